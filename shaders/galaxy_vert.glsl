@@ -2,20 +2,47 @@
 
 uniform sampler2D colorTex;
 
+// form space -> observer centric galaxy frame, including the galaxy's
+// orientation, per-axis scale and offset
+uniform mat4 m;
+// billboard half-axes in view orientation, scaled by the base sprite size
+uniform vec3 viewU;
+uniform vec3 viewV;
+// base sprite size; per-blob sizes are size0 * gl_Vertex.w
+uniform float size0;
+// (4 * lightGain + 1) * btot * brightness_corr * brightness
+uniform float brightnessScale;
+
 varying vec4 color;
 varying vec2 texCoord;
 
 void main(void)
 {
-    // we pass color index as short int
-    // reusing gl_MultiTexCoord0.z
-    // we use 255 only because we have 256 color indices
+    // gl_Vertex.xyz is the blob position in form space, gl_Vertex.w the
+    // per-blob sprite scale factor. gl_MultiTexCoord0 packs the sprite
+    // corner (x, y), the color table index [0, 255] (z) and the blob
+    // brightness [0, 1] (w).
+    vec4 p = m * vec4(gl_Vertex.xyz, 1.0f);
+    float sizeFactor = gl_Vertex.w;
+
+    // sprites covering a large fraction of the view fade out towards
+    // screenFrac = 0.1 and are dropped beyond it, as the CPU path did
+    // point by point
+    float screenFrac = size0 * sizeFactor / length(p.xyz);
+    if (screenFrac >= 0.1f)
+    {
+        // collapse the sprite outside the clip volume
+        gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f);
+        color = vec4(0.0f);
+        texCoord = vec2(0.0f);
+        return;
+    }
+
+    float a = min(1.0f, brightnessScale * (0.1f - screenFrac) * gl_MultiTexCoord0.w);
     float t = gl_MultiTexCoord0.z / 255.0f; // [0, 255] -> [0, 1]
-    // we pass alpha values as as short int
-    // reusing gl_MultiTexCoord0.w
-    // we use 65535 for better precision
-    float a = gl_MultiTexCoord0.w / 65535.0f; // [0, 65535] -> [0, 1]
     color = vec4(texture2D(colorTex, vec2(t, 0.0f)).rgb, a);
-    texCoord = gl_MultiTexCoord0.st;
-    gl_Position = ftransform();
+    texCoord = gl_MultiTexCoord0.xy * 0.5f + 0.5f;
+
+    vec3 offsetInView = (gl_MultiTexCoord0.x * viewU + gl_MultiTexCoord0.y * viewV) * sizeFactor;
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(p.xyz + offsetInView, 1.0f);
 }
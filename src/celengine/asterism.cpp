@@ -99,6 +99,12 @@ bool Asterism::isColorOverridden() const
     return useOverrideColor;
 }
 
+void AsterismList::prepareAsync()
+{
+    prepareTask = async(launch::async, [this]() { prepare(); });
+}
+
+
 /*! Draw visible asterisms.
  */
 void AsterismList::render(const Color& defaultColor, const Renderer& renderer)
@@ -106,6 +112,11 @@ void AsterismList::render(const Color& defaultColor, const Renderer& renderer)
     m_vo.bind();
     if (!m_vo.initialized())
     {
+        // Wait for the background preparation kicked off at load; it
+        // has normally finished long before constellations are first
+        // toggled on, leaving only the buffer upload for this frame.
+        if (prepareTask.valid())
+            prepareTask.get();
         prepare();
 
         if (vtx_num == 0)
@@ -202,6 +213,11 @@ void AsterismList::prepare()
 
 void AsterismList::cleanup()
 {
+    // A still-running background preparation must finish before the
+    // buffer it writes is freed.
+    if (prepareTask.valid())
+        prepareTask.get();
+
     delete[] vtx_buf;
     // TODO: delete chains
 }
@@ -211,7 +227,8 @@ AsterismList* ReadAsterismList(istream& in, const StarDatabase& stardb)
 {
     auto* asterisms = new AsterismList();
     Tokenizer tokenizer(&in);
-    Parser parser(&tokenizer);
+    MemoryPool valuePool(16, 65536);
+    Parser parser(&tokenizer, &valuePool);
 
     while (tokenizer.nextToken() != Tokenizer::TokenEnd)
     {
@@ -271,5 +288,7 @@ AsterismList* ReadAsterismList(istream& in, const StarDatabase& stardb)
         delete chainsValue;
     }
 
+    asterisms->prepareAsync();
+
     return asterisms;
 }
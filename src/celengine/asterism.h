@@ -11,6 +11,7 @@
 #ifndef _CELENGINE_ASTERISM_H_
 #define _CELENGINE_ASTERISM_H_
 
+#include <future>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -64,10 +65,16 @@ class AsterismList : public std::vector<Asterism*>
  public:
     void render(const Color& color, const Renderer& renderer);
 
+    //! Assemble the line vertex array on a background thread so the
+    //! first render only has to upload it. Called once by the loader;
+    //! render() falls back to preparing synchronously if it was not.
+    void prepareAsync();
+
  private:
     void cleanup();
     void prepare();
 
+    std::future<void> prepareTask;
     GLfloat *vtx_buf{ nullptr };
     GLsizei vtx_num{ 0 };
     bool prepared{ false };
@@ -16,6 +16,7 @@
 #include "geometry.h"
 #include "meshmanager.h"
 #include "body.h"
+#include "solarsys.h"
 #include "atmosphere.h"
 #include "frame.h"
 #include "timeline.h"
@@ -63,7 +64,14 @@ Body::~Body()
             delete s.second;
         delete altSurfaces;
     }
+    if (deferredSurfaces)
+    {
+        for (const auto& s : *deferredSurfaces)
+            delete s.second.definition;
+        delete deferredSurfaces;
+    }
     delete locations;
+    delete locationCells;
 }
 
 
@@ -332,6 +340,7 @@ float Body::getGeomAlbedo() const
 void Body::setGeomAlbedo(float _geomAlbedo)
 {
     geomAlbedo = _geomAlbedo;
+    photometryEpoch++;
 }
 
 
@@ -406,6 +415,7 @@ void Body::setSemiAxes(const Vector3f& _semiAxes)
 
     // Radius will always be the largest of the three semi axes
     radius = semiAxes.maxCoeff();
+    photometryEpoch++;
     recomputeCullingRadius();
 }
 
@@ -574,7 +584,7 @@ UniversalCoord Body::getPosition(double tdb) const
 Quaterniond Body::getOrientation(double tdb) const
 {
     auto phase = timeline->findPhase(tdb);
-    return phase->rotationModel()->orientationAtTime(tdb) * phase->bodyFrame()->getOrientation(tdb);
+    return phase->rotationOrientation(tdb) * phase->bodyFrame()->getOrientation(tdb);
 }
 
 
@@ -667,7 +677,7 @@ Quaterniond Body::getEclipticToEquatorial(double tdb) const
 Quaterniond Body::getEclipticToBodyFixed(double tdb) const
 {
     auto phase = timeline->findPhase(tdb);
-    return phase->rotationModel()->orientationAtTime(tdb) * phase->bodyFrame()->getOrientation(tdb);
+    return phase->rotationOrientation(tdb) * phase->bodyFrame()->getOrientation(tdb);
 }
 
 
@@ -814,6 +824,12 @@ float Body::getApparentMagnitude(const Star& sun,
 
 /*! Get the apparent magnitude of the body, corrected for its phase.
  */
+// Width of the photometric cache buckets. A 0.5% relative distance
+// bucket keeps a cached magnitude within roughly 0.01 mag of the exact
+// value; the phase bucket is absolute in illuminated fraction.
+static const double PhotometryDistanceTolerance = 0.005;
+static const float PhotometryPhaseTolerance = 0.002f;
+
 float Body::getApparentMagnitude(float sunLuminosity,
                                  const Vector3d& sunPosition,
                                  const Vector3d& viewerPosition) const
@@ -822,7 +838,34 @@ float Body::getApparentMagnitude(float sunLuminosity,
     double distanceToSun = sunPosition.norm();
     float illuminatedFraction = (float) (1.0 + (viewerPosition / distanceToViewer).dot(sunPosition / distanceToSun)) / 2.0f;
 
-    return astro::lumToAppMag(getLuminosity(sunLuminosity, (float) distanceToSun) * illuminatedFraction, (float) astro::kilometersToLightYears(distanceToViewer));
+    // Reuse a cached magnitude while the query falls in the same
+    // distance and phase angle buckets as an earlier one; see the
+    // photometryCache comments in body.h.
+    for (unsigned int i = 0; i < PhotometryCacheEntries; i++)
+    {
+        const PhotometryCacheEntry& entry = photometryCache[i];
+        if (entry.epoch == photometryEpoch &&
+            entry.sunLuminosity == sunLuminosity &&
+            fabs(distanceToViewer - entry.viewerDistance) < entry.viewerDistance * PhotometryDistanceTolerance &&
+            fabs(distanceToSun - entry.sunDistance) < entry.sunDistance * PhotometryDistanceTolerance &&
+            fabs(illuminatedFraction - entry.illuminatedFraction) < PhotometryPhaseTolerance)
+        {
+            return entry.appMag;
+        }
+    }
+
+    float appMag = astro::lumToAppMag(getLuminosity(sunLuminosity, (float) distanceToSun) * illuminatedFraction, (float) astro::kilometersToLightYears(distanceToViewer));
+
+    PhotometryCacheEntry& entry = photometryCache[photometryCacheNext];
+    photometryCacheNext = (photometryCacheNext + 1) % PhotometryCacheEntries;
+    entry.epoch = photometryEpoch;
+    entry.sunLuminosity = sunLuminosity;
+    entry.viewerDistance = distanceToViewer;
+    entry.sunDistance = distanceToSun;
+    entry.illuminatedFraction = illuminatedFraction;
+    entry.appMag = appMag;
+
+    return appMag;
 }
 
 
@@ -883,6 +926,25 @@ void Body::setInfoURL(const string& _infoURL)
 
 Surface* Body::getAlternateSurface(const string& name) const
 {
+    // Instantiate a staged definition on first request
+    if (deferredSurfaces)
+    {
+        auto deferred = deferredSurfaces->find(name);
+        if (deferred != deferredSurfaces->end())
+        {
+            Surface* surface = CreateAltSurface(deferred->second.definition,
+                                                deferred->second.directory);
+            delete deferred->second.definition;
+            deferredSurfaces->erase(deferred);
+            if (surface != nullptr)
+            {
+                if (!altSurfaces)
+                    altSurfaces = new AltSurfaceTable();
+                (*altSurfaces)[name] = surface;
+            }
+        }
+    }
+
     if (!altSurfaces)
         return nullptr;
 
@@ -904,6 +966,31 @@ void Body::addAlternateSurface(const string& name, Surface* surface)
 }
 
 
+void Body::addAlternateSurfaceDefinition(const string& name,
+                                         Value* definition,
+                                         const fs::path& directory)
+{
+    // A new definition supersedes any surface already parsed under the
+    // same name (e.g. a Replace disposition).
+    if (altSurfaces)
+    {
+        auto iter = altSurfaces->find(name);
+        if (iter != altSurfaces->end())
+        {
+            delete iter->second;
+            altSurfaces->erase(iter);
+        }
+    }
+
+    if (!deferredSurfaces)
+        deferredSurfaces = new DeferredSurfaceTable();
+    DeferredSurface& deferred = (*deferredSurfaces)[name];
+    delete deferred.definition;
+    deferred.definition = definition;
+    deferred.directory = directory;
+}
+
+
 vector<string>* Body::getAlternateSurfaceNames() const
 {
     vector<string>* names = new vector<string>();
@@ -912,6 +999,11 @@ vector<string>* Body::getAlternateSurfaceNames() const
         for (const auto& s : *altSurfaces)
             names->push_back(s.first);
     }
+    if (deferredSurfaces)
+    {
+        for (const auto& s : *deferredSurfaces)
+            names->push_back(s.first);
+    }
 
     return names;
 }
@@ -927,6 +1019,10 @@ void Body::addLocation(Location* loc)
         locations = new vector<Location*>();
     locations->push_back(loc);
     loc->setParentBody(this);
+
+    // The location grid is stale now; rebuild it on the next cap query
+    delete locationCells;
+    locationCells = nullptr;
 }
 
 
@@ -936,6 +1032,112 @@ vector<Location*>* Body::getLocations() const
 }
 
 
+// Dimensions of the location grid. Bodies with fewer locations than
+// the threshold skip the grid entirely; a linear scan is cheaper.
+static const unsigned int LocationGridThreshold = 64;
+static const int LocationGridLatCells = 18;    // 10 degree cells
+static const int LocationGridLongCells = 36;
+
+void Body::buildLocationCells() const
+{
+    locationCells = new vector<LocationCell>();
+    if (locations == nullptr || locations->size() < LocationGridThreshold)
+        return;    // empty grid: findLocationsInCap falls back to a scan
+
+    // Bucket the locations by latitude and longitude
+    vector<vector<Location*>> grid(LocationGridLatCells * LocationGridLongCells);
+    for (const auto location : *locations)
+    {
+        Vector3d v = location->getPosition().cast<double>();
+        double r = v.norm();
+        double lat = r > 0.0 ? asin(std::max(-1.0, std::min(1.0, v.y() / r))) : 0.0;
+        double lon = r > 0.0 ? atan2(v.z(), v.x()) : 0.0;
+
+        int latCell = (int) ((lat / PI + 0.5) * LocationGridLatCells);
+        latCell = std::max(0, std::min(LocationGridLatCells - 1, latCell));
+        int longCell = (int) ((lon / (2.0 * PI) + 0.5) * LocationGridLongCells);
+        longCell = std::max(0, std::min(LocationGridLongCells - 1, longCell));
+
+        grid[latCell * LocationGridLongCells + longCell].push_back(location);
+    }
+
+    // Compute the bounding cone of each occupied cell from its actual
+    // members; near the poles this is much tighter than the cell extents.
+    for (auto& members : grid)
+    {
+        if (members.empty())
+            continue;
+
+        LocationCell cell;
+        Vector3d axis = Vector3d::Zero();
+        for (const auto location : members)
+        {
+            Vector3d v = location->getPosition().cast<double>();
+            double r = v.norm();
+            if (r > 0.0)
+                axis += v / r;
+        }
+
+        if (axis.norm() > 0.0)
+        {
+            cell.axis = axis.normalized();
+            double minCos = 1.0;
+            for (const auto location : members)
+            {
+                Vector3d v = location->getPosition().cast<double>();
+                double r = v.norm();
+                if (r > 0.0)
+                    minCos = std::min(minCos, cell.axis.dot(v / r));
+                else
+                    minCos = -1.0;
+            }
+            cell.radius = acos(std::max(-1.0, minCos));
+        }
+        else
+        {
+            // Degenerate cell (opposing or zero directions); never cull it
+            cell.axis = Vector3d::UnitX();
+            cell.radius = PI;
+        }
+
+        cell.cosRadius = cos(cell.radius);
+        cell.sinRadius = sin(cell.radius);
+        cell.members = std::move(members);
+        locationCells->push_back(std::move(cell));
+    }
+}
+
+
+void Body::findLocationsInCap(const Vector3d& capCenter,
+                              double capAngle,
+                              vector<Location*>& result) const
+{
+    if (locations == nullptr)
+        return;
+
+    if (locationCells == nullptr)
+        buildLocationCells();
+
+    if (locationCells->empty() || capAngle >= PI)
+    {
+        result.insert(result.end(), locations->begin(), locations->end());
+        return;
+    }
+
+    double cosCap = cos(capAngle);
+    double sinCap = sin(capAngle);
+    for (const auto& cell : *locationCells)
+    {
+        // A cell can contain cap members when the angle between the cap
+        // center and the cone axis is at most capAngle + cell.radius;
+        // compare cosines via the angle sum identity to avoid acos.
+        double cosLimit = cosCap * cell.cosRadius - sinCap * cell.sinRadius;
+        if (capAngle + cell.radius >= PI || capCenter.dot(cell.axis) >= cosLimit)
+            result.insert(result.end(), cell.members.begin(), cell.members.end());
+    }
+}
+
+
 Location* Body::findLocation(const string& name, bool i18n) const
 {
     if (!locations)
@@ -1057,7 +1259,12 @@ Body::getReferenceMarks() const
  */
 void Body::setVisible(bool _visible)
 {
-    visible = _visible;
+    if (_visible != visible)
+    {
+        visible = _visible;
+        // The frame tree caches per-child visibility for the renderer
+        markChanged();
+    }
 }
 
 
@@ -18,6 +18,7 @@
 #include <celephem/rotation.h>
 #include <celephem/orbit.h>
 #include <celutil/utf8.h>
+#include <celcompat/filesystem.h>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <GL/glew.h>
@@ -33,6 +34,7 @@ class Body;
 class FrameTree;
 class ReferenceMark;
 class Atmosphere;
+class Value;
 
 class PlanetarySystem
 {
@@ -304,6 +306,11 @@ class Body : public CatEntry
 
     Surface* getAlternateSurface(const std::string&) const;
     void addAlternateSurface(const std::string&, Surface*);
+    //! Stage an unparsed ssc alternate surface definition; it is parsed
+    //! on the first getAlternateSurface() request for it. The body takes
+    //! ownership of the definition.
+    void addAlternateSurfaceDefinition(const std::string&, Value* definition,
+                                       const fs::path& directory);
     std::vector<std::string>* getAlternateSurfaceNames() const;
 
     std::vector<Location*>* getLocations() const;
@@ -311,6 +318,17 @@ class Body : public CatEntry
     Location* findLocation(const std::string&, bool i18n = false) const;
     void computeLocations();
 
+    /*! Append to result every location whose direction from the body
+     *  center lies within the spherical cap of half-angle capAngle
+     *  (radians) about the unit vector capCenter, both in bodycentric
+     *  coordinates. The test is conservative -- locations outside the
+     *  cap may be returned, but none inside it are missed -- so the
+     *  renderer can use it to prune horizon tests for large gazetteers.
+     */
+    void findLocationsInCap(const Eigen::Vector3d& capCenter,
+                            double capAngle,
+                            std::vector<Location*>& result) const;
+
     bool isVisible() const { return visible; }
     void setVisible(bool _visible);
     bool isClickable() const { return clickable; }
@@ -400,13 +418,62 @@ class Body : public CatEntry
     std::string infoURL;
 
     typedef std::map<std::string, Surface*> AltSurfaceTable;
-    AltSurfaceTable *altSurfaces{ nullptr };
+    mutable AltSurfaceTable *altSurfaces{ nullptr };
+
+    // Alternate surface definitions staged at catalog load and parsed
+    // lazily; most add-on surfaces are never selected.
+    struct DeferredSurface
+    {
+        Value* definition{ nullptr };
+        fs::path directory;
+    };
+    typedef std::map<std::string, DeferredSurface> DeferredSurfaceTable;
+    mutable DeferredSurfaceTable* deferredSurfaces{ nullptr };
 
     std::vector<Location*>* locations{ nullptr };
     mutable bool locationsComputed{ false };
 
+    /*! Locations bucketed by a fixed latitude/longitude grid, each
+     *  bucket with the bounding cone of its members' directions. Built
+     *  lazily on the first cap query and discarded when a location is
+     *  added; left empty for bodies with few locations, which are
+     *  cheaper to scan linearly.
+     */
+    struct LocationCell
+    {
+        Eigen::Vector3d axis;
+        double radius;
+        double cosRadius;
+        double sinRadius;
+        std::vector<Location*> members;
+    };
+    mutable std::vector<LocationCell>* locationCells{ nullptr };
+    void buildLocationCells() const;
+
     std::list<ReferenceMark*>* referenceMarks{ nullptr };
 
+    /*! Cache of phase-corrected apparent magnitudes. The magnitude
+     *  varies slowly with the observer's position, so queries falling
+     *  into the same distance and phase angle buckets as an earlier
+     *  one reuse its result. One entry per recent light source; the
+     *  epoch is bumped when the albedo or size changes, invalidating
+     *  all entries. The renderer evaluates each body on one thread per
+     *  traversal, so no locking is needed.
+     */
+    struct PhotometryCacheEntry
+    {
+        uint32_t epoch{ 0 };
+        float sunLuminosity{ 0.0f };
+        double viewerDistance{ 0.0 };
+        double sunDistance{ 0.0 };
+        float illuminatedFraction{ 0.0f };
+        float appMag{ 0.0f };
+    };
+    static const unsigned int PhotometryCacheEntries = 4;
+    mutable PhotometryCacheEntry photometryCache[PhotometryCacheEntries];
+    mutable unsigned int photometryCacheNext{ 0 };
+    uint32_t photometryEpoch{ 1 };
+
     Color orbitColor;
     Color cometTailColor{ 0.5f, 0.5f, 0.75f };
 
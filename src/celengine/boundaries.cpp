@@ -8,18 +8,41 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <numeric>
 #include <GL/glew.h>
+#include <celmath/mathlib.h>
 #include "boundaries.h"
 #include "astro.h"
 #include "render.h"
 
 using namespace Eigen;
+using namespace celmath;
 using namespace std;
 
 constexpr const float BoundariesDrawDistance = 10000.0f;
 
+
+// Wrap an RA difference into (-12h, 12h], i.e. take the short way
+// around the celestial sphere.
+static float wrapDeltaRA(float dra)
+{
+    if (dra > 12.0f)
+        return dra - 24.0f;
+    if (dra < -12.0f)
+        return dra + 24.0f;
+    return dra;
+}
+
+
+static unsigned int decBandFor(float dec, unsigned int nBands)
+{
+    int band = (int) ((dec + 90.0f) * (float) nBands / 180.0f);
+    return (unsigned int) min(max(band, 0), (int) nBands - 1);
+}
+
 ConstellationBoundaries::ConstellationBoundaries()
 {
     currentChain = new Chain();
@@ -33,6 +56,11 @@ ConstellationBoundaries::~ConstellationBoundaries()
 
 void ConstellationBoundaries::cleanup()
 {
+    // A still-running background preparation must finish before the
+    // chains it reads are freed.
+    if (prepareTask.valid())
+        prepareTask.get();
+
     for (const auto chain : chains)
         delete chain;
     chains.clear();
@@ -45,7 +73,7 @@ void ConstellationBoundaries::cleanup()
 }
 
 
-void ConstellationBoundaries::moveto(float ra, float dec)
+void ConstellationBoundaries::moveto(float ra, float dec, const std::string& constellation)
 {
     assert(currentChain != nullptr);
 
@@ -60,12 +88,183 @@ void ConstellationBoundaries::moveto(float ra, float dec)
     {
         (*currentChain)[0] = v;
     }
+
+    closeBoundary();
+    currentBoundary.constellation = constellation;
+    currentBoundary.points.emplace_back(ra, dec);
 }
 
 
 void ConstellationBoundaries::lineto(float ra, float dec)
 {
     currentChain->emplace_back(astro::equatorialToEclipticCartesian(ra, dec, BoundariesDrawDistance));
+    currentBoundary.points.emplace_back(ra, dec);
+}
+
+
+void ConstellationBoundaries::finish()
+{
+    // Without this the final chain in the file would never make it
+    // into the chain list, and so never into the render batch.
+    if (currentChain != nullptr && currentChain->size() > 1)
+    {
+        chains.emplace_back(currentChain);
+        currentChain = new Chain();
+        currentChain->emplace_back(Vector3f::Zero());
+    }
+    closeBoundary();
+
+    decBands.assign(DecBands, vector<uint32_t>());
+    for (uint32_t i = 0; i < boundaries.size(); i++)
+    {
+        const Boundary& b = boundaries[i];
+        float lo = b.southPolar ? -90.0f : b.minDec;
+        float hi = (b.polar && !b.southPolar) ? 90.0f : b.maxDec;
+        unsigned int last = decBandFor(hi, DecBands);
+        for (unsigned int band = decBandFor(lo, DecBands); band <= last; band++)
+            decBands[band].push_back(i);
+    }
+}
+
+
+//! Finalize the polygon collected in currentBoundary: compute its
+//! bounds, detect whether it encircles a pole, and append it to the
+//! boundary list. Degenerate polygons are dropped.
+void ConstellationBoundaries::closeBoundary()
+{
+    Boundary& b = currentBoundary;
+    if (b.points.size() > 2)
+    {
+        // Walk the polygon with RA unwrapped; a polygon enclosing a
+        // pole accumulates a full turn in RA around its circumference.
+        float ra = b.points[0].x();
+        float decSum = b.points[0].y();
+        b.minRA = b.maxRA = ra;
+        b.minDec = b.maxDec = b.points[0].y();
+        for (unsigned int i = 1; i < b.points.size(); i++)
+        {
+            ra += wrapDeltaRA(b.points[i].x() - b.points[i - 1].x());
+            b.minRA = min(b.minRA, ra);
+            b.maxRA = max(b.maxRA, ra);
+            b.minDec = min(b.minDec, b.points[i].y());
+            b.maxDec = max(b.maxDec, b.points[i].y());
+            decSum += b.points[i].y();
+        }
+        ra += wrapDeltaRA(b.points[0].x() - b.points.back().x());
+
+        b.polar = fabs(ra - b.points[0].x()) > 12.0f;
+        // The IAU polar constellations lie entirely in the hemisphere
+        // of the pole they enclose, so the mean declination picks the
+        // right one.
+        b.southPolar = b.polar && decSum < 0.0f;
+
+        boundaries.push_back(b);
+    }
+
+    b.constellation.clear();
+    b.points.clear();
+}
+
+
+/*! Even-odd test against a boundary polygon in (RA, dec), casting the
+ *  ray from the query point along its meridian to the south celestial
+ *  pole. A polygon enclosing the north pole is crossed an odd number
+ *  of times from inside just like an ordinary one; for a polygon
+ *  enclosing the south pole the ray terminates inside it, which
+ *  inverts the parity.
+ */
+bool ConstellationBoundaries::contains(const Boundary& b, float ra, float dec)
+{
+    int crossings = 0;
+    unsigned int n = b.points.size();
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const Vector2f& p0 = b.points[i];
+        const Vector2f& p1 = b.points[(i + 1) % n];
+        float x0 = wrapDeltaRA(p0.x() - ra);
+        float x1 = x0 + wrapDeltaRA(p1.x() - p0.x());
+        if ((x0 > 0.0f) == (x1 > 0.0f))
+            continue;
+
+        float decCross = p0.y() + (p1.y() - p0.y()) * (-x0 / (x1 - x0));
+        if (decCross < dec)
+            crossings++;
+    }
+
+    bool inside = (crossings & 1) != 0;
+    return b.southPolar ? !inside : inside;
+}
+
+
+std::string ConstellationBoundaries::whichConstellation(const Eigen::Vector3f& direction) const
+{
+    if (boundaries.empty())
+        return {};
+
+    // Rotation from the J2000 equatorial to the J2000 ecliptic frame,
+    // recovered from the transform the boundary points went through so
+    // the query stays consistent with them.
+    static const Matrix3f equatorialToEcliptic = []()
+    {
+        Matrix3f m;
+        m.col(0) = astro::equatorialToEclipticCartesian( 0.0f,  0.0f, 1.0f);
+        m.col(1) = astro::equatorialToEclipticCartesian( 0.0f, 90.0f, 1.0f);
+        m.col(2) = astro::equatorialToEclipticCartesian(18.0f,  0.0f, 1.0f);
+        return m;
+    }();
+
+    Vector3f eq = equatorialToEcliptic.transpose() * direction.normalized();
+
+    float y = min(max(eq.y(), -1.0f), 1.0f);
+    float dec = 90.0f - radToDeg((float) acos(y));
+    float ra = 0.0f;
+    if (fabs(y) < 1.0f - 1.0e-6f)
+    {
+        // Invert the spherical mapping used by
+        // astro::equatorialToEclipticCartesian
+        float theta = atan2(eq.z(), -eq.x());
+        ra = (theta - (float) PI) / (2.0f * (float) PI) * 24.0f;
+        if (ra < 0.0f)
+            ra += 24.0f;
+    }
+
+    const vector<uint32_t>* candidates = nullptr;
+    vector<uint32_t> all;
+    if (!decBands.empty())
+    {
+        candidates = &decBands[decBandFor(dec, DecBands)];
+    }
+    else
+    {
+        // finish() was never called; fall back to testing everything
+        all.resize(boundaries.size());
+        iota(all.begin(), all.end(), 0);
+        candidates = &all;
+    }
+
+    for (uint32_t index : *candidates)
+    {
+        const Boundary& b = boundaries[index];
+        if ((dec < b.minDec && !b.southPolar) ||
+            (dec > b.maxDec && !(b.polar && !b.southPolar)))
+            continue;
+        if (!b.polar &&
+            !(ra >= b.minRA && ra <= b.maxRA) &&
+            !(ra - 24.0f >= b.minRA && ra - 24.0f <= b.maxRA) &&
+            !(ra + 24.0f >= b.minRA && ra + 24.0f <= b.maxRA))
+            continue;
+
+        if (contains(b, ra, dec))
+            return b.constellation;
+    }
+
+    return {};
+}
+
+
+void ConstellationBoundaries::prepareAsync()
+{
+    prepareTask = async(launch::async, [this]() { prepare(); });
 }
 
 
@@ -74,6 +273,11 @@ void ConstellationBoundaries::render(const Color& color, const Renderer& rendere
     m_vo.bind();
     if (!m_vo.initialized())
     {
+        // Wait for the background preparation kicked off at load; it
+        // has normally finished long before boundaries are first
+        // toggled on, leaving only the buffer upload for this frame.
+        if (prepareTask.valid())
+            prepareTask.get();
         prepare();
         m_vo.allocate(vtx_num * 3 * sizeof(GLshort), vtx_buf);
         cleanup();
@@ -95,6 +299,9 @@ void ConstellationBoundaries::render(const Color& color, const Renderer& rendere
 
 void ConstellationBoundaries::prepare()
 {
+    if (vtx_buf != nullptr)
+        return;
+
     vtx_num = accumulate(chains.begin(), chains.end(), 0,
                          [](int a, Chain* b) { return a + b->size(); });
 
@@ -145,7 +352,7 @@ ConstellationBoundaries* ReadBoundaries(istream& in)
 
         if (con != lastCon)
         {
-            boundaries->moveto(ra, dec);
+            boundaries->moveto(ra, dec, con);
             lastCon = con;
             conCount++;
         }
@@ -156,5 +363,8 @@ ConstellationBoundaries* ReadBoundaries(istream& in)
         ptCount++;
     }
 
+    boundaries->finish();
+    boundaries->prepareAsync();
+
     return boundaries;
 }
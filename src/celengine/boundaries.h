@@ -12,6 +12,8 @@
 #define _CELENGINE_BOUNDARIES_H_
 
 #include <Eigen/Core>
+#include <cstdint>
+#include <future>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -33,17 +35,70 @@ class ConstellationBoundaries
     ConstellationBoundaries& operator=(const ConstellationBoundaries&) = delete;
     ConstellationBoundaries& operator=(ConstellationBoundaries&&)      = delete;
 
-    void moveto(float ra, float dec);
+    void moveto(float ra, float dec, const std::string& constellation);
     void lineto(float ra, float dec);
+
+    //! Complete the boundary set once every point has been read:
+    //! closes the final polygon and builds the declination band index
+    //! used by whichConstellation().
+    void finish();
+
     void render(const Color& color, const Renderer& renderer);
 
+    //! Assemble the boundary line vertex array on a background thread
+    //! so the first render only has to upload it. Called once by the
+    //! loader; render() falls back to preparing synchronously.
+    void prepareAsync();
+
+    //! Return the name of the constellation (as it appears in the
+    //! boundary file) whose boundary encloses the given direction in
+    //! the J2000 ecliptic frame, or an empty string if the direction
+    //! cannot be attributed to any boundary.
+    std::string whichConstellation(const Eigen::Vector3f& direction) const;
+
  private:
+    //! A closed boundary polygon for a single constellation, kept in
+    //! the spherical coordinates of the boundary file (RA in hours,
+    //! declination in degrees). Unlike the chains, these survive the
+    //! post-upload cleanup so queries remain possible after the first
+    //! render.
+    struct Boundary
+    {
+        std::string constellation;
+        std::vector<Eigen::Vector2f> points;    // (RA, dec)
+
+        // Bounding box, with RA unwrapped so minRA may be negative or
+        // maxRA exceed 24 for polygons crossing RA 0.
+        float minRA{ 0.0f };
+        float maxRA{ 0.0f };
+        float minDec{ 0.0f };
+        float maxDec{ 0.0f };
+
+        //! Polygon encircles a celestial pole (its edges wrap a full
+        //! turn in RA), so it has no meaningful RA bounds.
+        bool polar{ false };
+        //! The enclosed pole is the south one
+        bool southPolar{ false };
+    };
+
     void cleanup();
     void prepare();
+    void closeBoundary();
+    static bool contains(const Boundary&, float ra, float dec);
 
     Chain* currentChain{ nullptr };
     std::vector<Chain*> chains;
 
+    Boundary currentBoundary;
+    std::vector<Boundary> boundaries;
+
+    // Equal-area-ish declination bands listing the boundaries that
+    // overlap each band, so a query tests a handful of polygons
+    // instead of all of them.
+    static const unsigned int DecBands = 36;
+    std::vector<std::vector<uint32_t>> decBands;
+
+    std::future<void> prepareTask;
     GLshort *vtx_buf{ nullptr };
     GLsizei vtx_num{ 0 };
     celgl::VertexObject m_vo{GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW};
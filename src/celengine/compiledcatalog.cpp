@@ -0,0 +1,89 @@
+// compiledcatalog.cpp
+//
+// Copyright (C) 2001-2009, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "tokenizer.h"
+#include "compiledcatalog.h"
+
+using namespace std;
+
+static const char CompiledCatalogMagic[4] = { 'C', 'T', 'O', 'K' };
+static const uint32_t CompiledCatalogVersion = 1;
+
+
+// Same FNV-1a hash as the star database octree cache uses to validate
+// its sidecar against the source catalog.
+static uint64_t hashCatalogText(const string& text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (string::size_type i = 0; i < text.size(); i++)
+    {
+        hash ^= (uint64_t) (unsigned char) text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+bool GetCompiledCatalog(const fs::path& sourcePath,
+                        const string& sourceText,
+                        string& tokens)
+{
+    fs::path sidecarPath(sourcePath.string() + ".tok");
+    uint64_t sourceHash = hashCatalogText(sourceText);
+
+    {
+        ifstream sidecar(sidecarPath.string(), ios::in | ios::binary);
+        if (sidecar.good())
+        {
+            char magic[4];
+            uint32_t version = 0;
+            uint64_t storedHash = 0;
+            sidecar.read(magic, sizeof(magic));
+            sidecar.read(reinterpret_cast<char*>(&version), sizeof(version));
+            sidecar.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash));
+            if (sidecar.good() &&
+                memcmp(magic, CompiledCatalogMagic, sizeof(magic)) == 0 &&
+                version == CompiledCatalogVersion &&
+                storedHash == sourceHash)
+            {
+                ostringstream body;
+                body << sidecar.rdbuf();
+                if (!sidecar.bad())
+                {
+                    tokens = body.str();
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Missing, stale, or corrupt sidecar; compile from the source text.
+    tokens.clear();
+    if (!Tokenizer::compile(sourceText, tokens))
+        return false;
+
+    // Rewrite the sidecar; failure (e.g. a read-only extras directory)
+    // just means the next run recompiles.
+    ofstream sidecar(sidecarPath.string(), ios::out | ios::binary | ios::trunc);
+    if (sidecar.good())
+    {
+        sidecar.write(CompiledCatalogMagic, sizeof(CompiledCatalogMagic));
+        sidecar.write(reinterpret_cast<const char*>(&CompiledCatalogVersion),
+                      sizeof(CompiledCatalogVersion));
+        sidecar.write(reinterpret_cast<const char*>(&sourceHash),
+                      sizeof(sourceHash));
+        sidecar.write(tokens.data(), tokens.size());
+    }
+
+    return true;
+}
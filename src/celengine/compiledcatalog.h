@@ -0,0 +1,30 @@
+// compiledcatalog.h
+//
+// Copyright (C) 2001-2009, the Celestia Development Team
+//
+// Sidecar cache of tokenized catalog files. Scanning the text of large
+// ssc/stc/dsc catalogs dominates cold startup, so the token stream is
+// compiled once and stored next to the source file together with a hash
+// of the source text; later runs replay the tokens and skip scanning.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELENGINE_COMPILEDCATALOG_H_
+#define _CELENGINE_COMPILEDCATALOG_H_
+
+#include <string>
+#include <celcompat/filesystem.h>
+
+//! Obtain the compiled token stream for a catalog file. The sidecar
+//! next to sourcePath is used when its stored hash matches sourceText;
+//! otherwise the source is tokenized and the sidecar rewritten
+//! (best-effort; a read-only location just loses the cache). Returns
+//! false if the source fails to tokenize.
+bool GetCompiledCatalog(const fs::path& sourcePath,
+                        const std::string& sourceText,
+                        std::string& tokens);
+
+#endif // _CELENGINE_COMPILEDCATALOG_H_
@@ -20,52 +20,79 @@
 using namespace std;
 using namespace celmath;
 
-static int pmod(int n, int m)
-{
-    return n >= 0 ? n % m : m - (-(n + 1) % m) - 1;
-}
-
-
 Console::Console(int _nRows, int _nColumns) :
     ostream(&sbuf),
     nRows(_nRows),
     nColumns(_nColumns)
 {
     sbuf.setConsole(this);
-    text = new wchar_t[(nColumns + 1) * nRows];
-    for (int i = 0; i < nRows; i++)
-        text[(nColumns + 1) * i] = '\0';
+    ring.resize((size_t) nRows * (nColumns + 1));
+    lines.push_back({ 0, 0, 0 });
+}
+
+
+// Copy a byte range out of the ring; a line may wrap around the end
+// of the buffer.
+string Console::lineText(const LineRecord& line) const
+{
+    string s;
+    s.reserve(line.length);
+    for (size_t i = 0; i < line.length; i++)
+        s.push_back(ring[(line.start + i) % ring.size()]);
+    return s;
 }
 
 
-Console::~Console()
+void Console::appendBytes(const char* bytes, size_t length)
 {
-    delete[] text;
+    // Evict the oldest lines once the byte budget is exceeded. Lines
+    // wrap at nColumns characters, so the line being appended to can
+    // never exceed the budget by itself.
+    while (lines.size() > 1 && head + length - lines.front().start > ring.size())
+        lines.pop_front();
+
+    for (size_t i = 0; i < length; i++)
+        ring[(head + i) % ring.size()] = bytes[i];
+    head += length;
+    lines.back().length += length;
 }
 
 
-/*! Resize the console log to use the specified number of rows.
- *  Old long entries are preserved in the resize. setRowCount()
- *  returns true if it was able to successfully allocate a new
- *  buffer, and false if there was a problem (out of memory.)
+/*! Resize the console log to retain the specified number of rows.
+ *  Old log entries are preserved in the resize, up to the new
+ *  capacity. setRowCount() returns true if it was able to
+ *  successfully allocate a new buffer, and false if there was a
+ *  problem (out of memory.)
  */
 bool Console::setRowCount(int _nRows)
 {
     if (_nRows == nRows)
         return true;
 
-    auto* newText = new wchar_t[(nColumns + 1) * _nRows];
+    // Stream offsets are taken modulo the ring size, so changing the
+    // capacity invalidates them; unpack the retained lines and replay
+    // them into the resized ring.
+    vector<string> retained;
+    retained.reserve(lines.size());
+    for (const auto& line : lines)
+        retained.push_back(lineText(line));
+    while ((int) retained.size() > _nRows)
+        retained.erase(retained.begin());
 
-    for (int i = 0; i < _nRows; i++)
+    nRows = _nRows;
+    ring.assign((size_t) nRows * (nColumns + 1), '\0');
+    head = 0;
+    lines.clear();
+
+    for (const auto& s : retained)
     {
-        newText[(nColumns + 1) * i] = '\0';
+        lines.push_back({ head, 0, 0 });
+        appendBytes(s.data(), s.length());
+        // Recover the character count for column tracking
+        lines.back().columns = UTF8Length(s);
     }
-
-    std::copy(newText, newText + (nColumns + 1) * min(_nRows, nRows), text);
-
-    delete[] text;
-    text = newText;
-    nRows = _nRows;
+    if (lines.empty())
+        lines.push_back({ 0, 0, 0 });
 
     return true;
 }
@@ -103,18 +130,23 @@ void Console::render(int rowHeight)
         return;
 
     glEnable(GL_TEXTURE_2D);
-    font->bind();
     glPushMatrix();
     for (int i = 0; i < rowHeight; i++)
     {
-        //int r = (nRows - rowHeight + 1 + windowRow + i) % nRows;
-        int r = pmod(row + windowRow + i, nRows);
-        for (int j = 0; j < nColumns; j++)
+        // The newest line sits at the end of the index; windowRow is
+        // a (negative) offset from it. Rows scrolled past either end
+        // of the scrollback are simply blank.
+        long idx = (long) lines.size() - 1 + windowRow + i;
+        if (idx >= 0 && idx < (long) lines.size() && lines[idx].length > 0)
         {
-            wchar_t ch = text[r * (nColumns + 1) + j];
-            if (ch == '\0')
-                break;
-            font->render(ch);
+            string s = lineText(lines[idx]);
+            // Shape (or fetch the cached run) before binding: the
+            // TrueType backend may grow its atlas while shaping,
+            // replacing the texture object.
+            const TextureFont::GlyphRun& run =
+                font->getGlyphRun(s.data(), (int) s.length());
+            font->bind();
+            font->renderGlyphRun(run, 0.0f, 0.0f);
         }
 
         // advance to the next line
@@ -142,12 +174,9 @@ void Console::setFont(TextureFont* f)
 
 void Console::newline()
 {
-    assert(column <= nColumns);
-    assert(row < nRows);
-
-    text[row * (nColumns + 1) + column] = '\0';
-    row = (row + 1) % nRows;
-    column = 0;
+    lines.push_back({ head, 0, 0 });
+    while ((int) lines.size() > nRows)
+        lines.pop_front();
 
     if (autoScroll)
         windowRow = -windowHeight;
@@ -161,10 +190,14 @@ void Console::print(wchar_t c)
         newline();
         break;
     default:
-        if (column == nColumns)
-            newline();
-        text[row * (nColumns + 1) + column] = c;
-        column++;
+        {
+            if (lines.back().columns == nColumns)
+                newline();
+            char encoded[8];
+            int length = UTF8Encode(c, encoded);
+            appendBytes(encoded, length);
+            lines.back().columns++;
+        }
         break;
     }
 }
@@ -188,13 +221,13 @@ void Console::print(char* s)
 
 int Console::getRow() const
 {
-    return row;
+    return (int) lines.size() - 1;
 }
 
 
 int Console::getColumn() const
 {
-    return column;
+    return lines.back().columns;
 }
 
 
@@ -10,7 +10,10 @@
 #ifndef _CELENGINE_CONSOLE_H_
 #define _CELENGINE_CONSOLE_H_
 
+#include <cstddef>
+#include <deque>
 #include <string>
+#include <vector>
 #include <iostream>
 #if NO_TTF
 #include <celtxf/texturefont.h>
@@ -49,7 +52,6 @@ class Console : public std::ostream
 {
  public:
     Console(int _nRows, int _nColumns);
-    ~Console();
 
     bool setRowCount(int _nRows);
 
@@ -79,11 +81,29 @@ class Console : public std::ostream
     int getWidth() const;
 
  private:
-    wchar_t* text{ nullptr };
+    // Scrollback storage: UTF-8 bytes in a fixed-capacity ring,
+    // addressed by monotonically increasing stream offsets, plus a
+    // line index. The oldest lines are evicted when either the byte
+    // budget or the line count is exceeded, so verbose logging never
+    // grows memory. Layout is deferred to render(): lines are shaped
+    // on demand and unchanged lines are served from the font's
+    // glyph-run cache, so a hidden console costs nothing.
+    struct LineRecord
+    {
+        std::size_t start;   // stream offset of the first byte
+        std::size_t length;  // length in bytes
+        int columns;         // length in characters, for wrapping
+    };
+
+    void appendBytes(const char* bytes, std::size_t length);
+    std::string lineText(const LineRecord&) const;
+
+    std::vector<char> ring;
+    std::size_t head{ 0 };   // stream offset one past the newest byte
+    std::deque<LineRecord> lines;
+
     int nRows;
     int nColumns;
-    int row{ 0 };
-    int column{ 0 };
 
     int windowRow{ 0 };
 
@@ -38,6 +38,7 @@
 #include "GL/glew.h"
 #include <vector>
 #include <iostream>
+#include <cmath>
 
 using namespace std;
 using namespace Eigen;
@@ -569,11 +570,125 @@ private:
 static HighPrec_VertexBuffer vbuf;
 
 
+// Finest tessellation available to the retained path; one cubic segment
+// is never split into more line pieces than this.
+static const unsigned int MaxRetainedSubdivision = 128;
+
+/** Curve vertices subdivided once and kept in a GPU buffer, with one
+  * line strip per cubic segment so that any time window maps to a
+  * contiguous run of strips. The buffer is rebuilt when the samples
+  * change or when the view scale moves to a different power-of-two
+  * tolerance bucket; in between, rendering is a cull pass over the
+  * segment bounds and a single glMultiDrawArrays call.
+  */
+class CurvePlot::RetainedVertices
+{
+public:
+    RetainedVertices() = default;
+
+    ~RetainedVertices()
+    {
+        if (vbobj != 0)
+            glDeleteBuffers(1, &vbobj);
+    }
+
+    void computeBounds(const deque<CurvePlotSample>& samples)
+    {
+        curveRadius = 0.0;
+        maxBoundingRadius = 0.0;
+        for (const auto& sample : samples)
+        {
+            curveRadius = max(curveRadius, sample.position.norm());
+            maxBoundingRadius = max(maxBoundingRadius, sample.boundingRadius);
+        }
+    }
+
+    void rebuild(const deque<CurvePlotSample>& samples, int bucket)
+    {
+        double tolerance = ldexp(1.0, bucket);
+
+        vertexData.clear();
+        firsts.clear();
+        counts.clear();
+        segmentStarts.clear();
+        segmentRadii.clear();
+
+        for (unsigned int i = 1; i < samples.size(); i++)
+        {
+            const CurvePlotSample& s0 = samples[i - 1];
+            const CurvePlotSample& s1 = samples[i];
+
+            double boundingRadius = s1.boundingRadius;
+            auto subdivisions = (unsigned int) max(1.0, ceil(boundingRadius / tolerance));
+            subdivisions = min(subdivisions, MaxRetainedSubdivision);
+
+            double dt = s1.t - s0.t;
+            Matrix4d coeff = cubicHermiteCoefficients(zeroExtend(s0.position),
+                                                      zeroExtend(s1.position),
+                                                      zeroExtend(s0.velocity * dt),
+                                                      zeroExtend(s1.velocity * dt));
+
+            firsts.push_back((GLint) (vertexData.size() / 3));
+            counts.push_back((GLsizei) (subdivisions + 1));
+            segmentStarts.push_back(zeroExtend(s0.position) + Vector4d::UnitW());
+            segmentRadii.push_back(boundingRadius);
+
+            double invSubdivisions = 1.0 / (double) subdivisions;
+            for (unsigned int j = 0; j <= subdivisions; j++)
+            {
+                double t = (double) j * invSubdivisions;
+                Vector4d p = coeff * Vector4d(1.0, t, t * t, t * t * t);
+                vertexData.push_back((float) p.x());
+                vertexData.push_back((float) p.y());
+                vertexData.push_back((float) p.z());
+            }
+        }
+
+        if (vbobj == 0)
+            glGenBuffers(1, &vbobj);
+        glBindBuffer(GL_ARRAY_BUFFER, vbobj);
+        glBufferData(GL_ARRAY_BUFFER,
+                     vertexData.size() * sizeof(float),
+                     vertexData.data(),
+                     GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        toleranceBucket = bucket;
+    }
+
+    GLuint vbobj{ 0 };
+    int toleranceBucket{ 0 };
+    unsigned int generation{ 0 };
+
+    // Maximum distance of any sample from the curve origin
+    double curveRadius{ 0.0 };
+    // Largest segment bounding radius
+    double maxBoundingRadius{ 0.0 };
+
+    // One line strip per cubic segment, in sample order
+    vector<float> vertexData;
+    vector<GLint> firsts;
+    vector<GLsizei> counts;
+    vector<Vector4d> segmentStarts;
+    vector<double> segmentRadii;
+
+    // Strips that survived culling this frame
+    vector<GLint> drawFirsts;
+    vector<GLsizei> drawCounts;
+};
+
+
 CurvePlot::CurvePlot()
 {
 }
 
 
+CurvePlot::~CurvePlot()
+{
+    delete m_retained;
+}
+
+
 /** Add a new sample to the path. If the sample time is less than the first time,
   * it is added at the end. If it is greater than the last time, it is appended
   * to the path. The sample is ignored if it has a time in between the first and
@@ -603,6 +718,9 @@ CurvePlot::addSample(const CurvePlotSample& sample)
     else
         m_samples.push_front(sample);
 
+    m_boundingRadius = max(m_boundingRadius, sample.position.norm());
+    ++m_generation;
+
     if (m_samples.size() > 1)
     {
         // Calculate a bounding radius for this segment. No point on the curve will
@@ -641,6 +759,7 @@ CurvePlot::removeSamplesBefore(double t)
     while (!m_samples.empty() && m_samples.front().t < t)
     {
         m_samples.pop_front();
+        ++m_generation;
     }
 }
 
@@ -653,6 +772,7 @@ CurvePlot::removeSamplesAfter(double t)
     while (!m_samples.empty() && m_samples.back().t > t)
     {
         m_samples.pop_back();
+        ++m_generation;
     }
 }
 
@@ -967,6 +1087,119 @@ CurvePlot::render(const Affine3d& modelview,
 }
 
 
+/** Draw some range of a piecewise curve from retained GPU buffers. The curve
+  * is subdivided in its own coordinate frame at a fixed tolerance and kept in
+  * a vertex buffer; per frame only the segment bounds are culled and the
+  * surviving strips are drawn with one glMultiDrawArrays call. The buffer is
+  * rebuilt when the view scale crosses a power-of-two tolerance bucket.
+  *
+  * The time window is rounded outward to whole sample segments, so this path
+  * is only suitable when the window endpoints are not visually significant
+  * (e.g. a full revolution of a closed orbit).
+  *
+  * @return true if the curve was drawn; false if the viewer is close enough
+  * that the retained tessellation (or single precision storage) is
+  * insufficient and the adaptive renderer must be used instead.
+  */
+bool
+CurvePlot::renderRetained(const Affine3d& modelview,
+                          double nearZ,
+                          double farZ,
+                          const Vector3d viewFrustumPlaneNormals[],
+                          double subdivisionThreshold,
+                          double startTime,
+                          double endTime,
+                          const Vector4f& color)
+{
+    if (m_samples.size() < 2 || endTime <= m_samples.front().t || startTime >= m_samples.back().t)
+        return true;
+
+    if (m_retained == nullptr)
+        m_retained = new RetainedVertices();
+    RetainedVertices& rv = *m_retained;
+
+    bool samplesChanged = rv.vbobj == 0 || rv.generation != m_generation;
+    if (samplesChanged)
+    {
+        rv.computeBounds(m_samples);
+        rv.generation = m_generation;
+    }
+
+    // The modelview transform maps the curve frame to camera space, so its
+    // translation is the vector from the eye to the curve origin.
+    double distance = max(modelview.translation().norm() - rv.curveRadius, -nearZ);
+    double tolerance = subdivisionThreshold * distance;
+
+    // Too close: the capped tessellation cannot reach the required density,
+    // or single precision vertex storage would quantize visibly.
+    if (rv.maxBoundingRadius >= tolerance * (double) MaxRetainedSubdivision ||
+        tolerance < rv.curveRadius * 1.0e-6)
+    {
+        return false;
+    }
+
+    auto bucket = (int) floor(log2(tolerance));
+    if (samplesChanged)
+    {
+        rv.rebuild(m_samples, bucket);
+    }
+    else if (bucket != rv.toleranceBucket)
+    {
+        // Hysteresis: keep the cached tessellation until the tolerance
+        // moves 25% beyond the cached bucket's bounds, so views hovering
+        // near a bucket boundary don't rebuild every frame.
+        double lo = ldexp(0.75, rv.toleranceBucket);
+        double hi = ldexp(1.25, rv.toleranceBucket + 1);
+        if (tolerance < lo || tolerance > hi)
+            rv.rebuild(m_samples, bucket);
+    }
+
+    // Linear search for the first sample, as in render()
+    unsigned int startSample = 0;
+    while (startSample < m_samples.size() - 1 && startTime > m_samples[startSample].t)
+        startSample++;
+    if (startSample > 0)
+        startSample--;
+
+    HighPrec_Frustum viewFrustum(nearZ, farZ, viewFrustumPlaneNormals);
+
+    rv.drawFirsts.clear();
+    rv.drawCounts.clear();
+
+    for (unsigned int i = startSample + 1; i < m_samples.size(); i++)
+    {
+        unsigned int segment = i - 1;
+        Vector4d p0 = modelview * rv.segmentStarts[segment];
+        if (!viewFrustum.cullSphere(p0, rv.segmentRadii[segment]))
+        {
+            rv.drawFirsts.push_back(rv.firsts[segment]);
+            rv.drawCounts.push_back(rv.counts[segment]);
+        }
+
+        if (endTime <= m_samples[i].t)
+            break;
+    }
+
+    if (rv.drawFirsts.empty())
+        return true;
+
+    glBindBuffer(GL_ARRAY_BUFFER, rv.vbobj);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    glColor4fv(color.data());
+
+    glMultiDrawArrays(GL_LINE_STRIP,
+                      rv.drawFirsts.data(),
+                      rv.drawCounts.data(),
+                      (GLsizei) rv.drawFirsts.size());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+
 /** Draw a piecewise cubic curve with transformation and frustum clipping. Only
   * the part of the curve between startTime and endTime will be drawn. Additionally,
   * the curve is drawn with a fade effect. The curve is at full opacity at fadeStartTime
@@ -47,6 +47,7 @@ class CurvePlot
 {
  public:
     CurvePlot();
+    ~CurvePlot();
 
     double duration() const { return m_duration; }
     void setDuration(double duration);
@@ -81,6 +82,14 @@ class CurvePlot
                 double startTime,
                 double endTime,
                 const Eigen::Vector4f& color) const;
+    bool renderRetained(const Eigen::Affine3d& modelview,
+                        double nearZ,
+                        double farZ,
+                        const Eigen::Vector3d viewFrustumPlaneNormals[],
+                        double subdivisionThreshold,
+                        double startTime,
+                        double endTime,
+                        const Eigen::Vector4f& color);
     void renderFaded(const Eigen::Affine3d& modelview,
                      double nearZ,
                      double farZ,
@@ -103,11 +112,25 @@ class CurvePlot
 
     unsigned int sampleCount() const { return m_samples.size(); }
 
+    //! Radius of a sphere about the curve origin containing all samples
+    double boundingRadius() const { return m_boundingRadius; }
+
  private:
     std::deque<CurvePlotSample> m_samples;
- 
+
     double m_duration{ 0.0 };
 
     unsigned int m_lastUsed{ 0 };
+
+    // Grows as samples are added; not shrunk on removal, so it may
+    // overestimate after the sample window slides.
+    double m_boundingRadius{ 0.0 };
+
+    // Subdivided vertices retained in a GPU buffer for renderRetained();
+    // rebuilt when the samples change or the view scale leaves the
+    // cached tolerance bucket.
+    class RetainedVertices;
+    RetainedVertices* m_retained{ nullptr };
+    unsigned int m_generation{ 0 };
 };
 
@@ -9,9 +9,13 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <cstring>
 #include <celutil/debug.h>
 #include <celutil/bytes.h>
+#include <celutil/compress.h>
+#include <celutil/memmap.h>
 #include <celengine/image.h>
 #include <GL/glew.h>
 
@@ -79,30 +83,26 @@ static uint32_t FourCC(const char* s)
 }
 
 
-#define DDPF_RGB    0x40
-#define DDPF_FOURCC 0x04
+#define DDPF_ALPHAPIXELS 0x01
+#define DDPF_RGB         0x40
+#define DDPF_FOURCC      0x04
 
+#define DDSD_CAPS        0x00000001
+#define DDSD_HEIGHT      0x00000002
+#define DDSD_WIDTH       0x00000004
+#define DDSD_PIXELFORMAT 0x00001000
+#define DDSD_MIPMAPCOUNT 0x00020000
+#define DDSD_LINEARSIZE  0x00080000
 
-Image* LoadDDSImage(const fs::path& filename)
-{
-    ifstream in(filename.string(), ios::in | ios::binary);
-    if (!in.good())
-    {
-        DPRINTF(LOG_LEVEL_ERROR, "Error opening DDS texture file %s.\n", filename);
-        return nullptr;
-    }
+#define DDSCAPS_COMPLEX  0x00000008
+#define DDSCAPS_TEXTURE  0x00001000
+#define DDSCAPS_MIPMAP   0x00400000
 
-    char header[4];
-    in.read(header, sizeof header);
-    if (header[0] != 'D' || header[1] != 'D' ||
-        header[2] != 'S' || header[3] != ' ')
-    {
-        DPRINTF(LOG_LEVEL_ERROR, "DDS texture file %s has bad header.\n", filename);
-        return nullptr;
-    }
 
-    DDSurfaceDesc ddsd;
-    in.read(reinterpret_cast<char*>(&ddsd), sizeof ddsd);
+// Byte swap a surface descriptor read from a file and determine the GL
+// format of its pixel data; returns -1 for unsupported formats.
+static int ParseDDSFormat(DDSurfaceDesc& ddsd)
+{
     LE_TO_CPU_INT32(ddsd.size, ddsd.size);
     LE_TO_CPU_INT32(ddsd.pitch, ddsd.pitch);
     LE_TO_CPU_INT32(ddsd.width, ddsd.width);
@@ -174,6 +174,110 @@ Image* LoadDDSImage(const fs::path& filename)
         }
     }
 
+    return format;
+}
+
+
+static bool isCompressedDDSFormat(int format)
+{
+    return format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+           format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ||
+           format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+
+static Image* LoadDDSImageFromStream(istream& in, const fs::path& filename);
+
+Image* LoadDDSImage(const fs::path& filename)
+{
+    static const size_t DDSDataOffset = 4 + sizeof(DDSurfaceDesc);
+
+    // Compressed payloads are laid out in the file exactly as
+    // glCompressedTexImage2D consumes them, so map the file and wrap
+    // the mapping in an Image instead of copying it to the heap; the
+    // upload then reads straight from the page cache.
+    {
+        MemoryMappedFile* mappedFile = new MemoryMappedFile(filename);
+
+        // A gzip compressed texture can't be served from the mapping;
+        // inflate it and read from the decompressed buffer.
+        if (mappedFile->isValid() &&
+            IsGzipData(mappedFile->data(), mappedFile->size()))
+        {
+            string inflated;
+            bool ok = DecompressGzipData(mappedFile->data(), mappedFile->size(), inflated);
+            delete mappedFile;
+            if (!ok)
+            {
+                DPRINTF(LOG_LEVEL_ERROR, "Error decompressing DDS texture file %s.\n", filename);
+                return nullptr;
+            }
+            istringstream in(inflated, ios::in | ios::binary);
+            return LoadDDSImageFromStream(in, filename);
+        }
+
+        if (mappedFile->isValid() &&
+            mappedFile->size() >= DDSDataOffset &&
+            memcmp(mappedFile->data(), "DDS ", 4) == 0)
+        {
+            DDSurfaceDesc ddsd;
+            memcpy(&ddsd, mappedFile->data() + 4, sizeof ddsd);
+            int format = ParseDDSFormat(ddsd);
+
+            if (isCompressedDDSFormat(format) && GLEW_EXT_texture_compression_s3tc)
+            {
+                auto* data = reinterpret_cast<unsigned char*>(
+                    const_cast<char*>(mappedFile->data() + DDSDataOffset));
+                Image* img = new Image(format,
+                                       (int) ddsd.width,
+                                       (int) ddsd.height,
+                                       max(ddsd.mipMapLevels, 1u),
+                                       mappedFile,
+                                       data);
+                if ((size_t) img->getSize() - 1 <= mappedFile->size() - DDSDataOffset)
+                {
+                    // Start paging the texels in while the caller gets
+                    // around to the upload
+                    mappedFile->prefetch(0, mappedFile->size());
+                    return img;
+                }
+
+                // Truncated payload; deleting the image releases the
+                // mapping, and the stream path below reports the error
+                DPRINTF(LOG_LEVEL_ERROR, "DDS texture file %s is truncated.\n", filename);
+                delete img;
+                return nullptr;
+            }
+        }
+        delete mappedFile;
+    }
+
+    ifstream in(filename.string(), ios::in | ios::binary);
+    if (!in.good())
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Error opening DDS texture file %s.\n", filename);
+        return nullptr;
+    }
+
+    return LoadDDSImageFromStream(in, filename);
+}
+
+
+static Image* LoadDDSImageFromStream(istream& in, const fs::path& filename)
+{
+    char header[4];
+    in.read(header, sizeof header);
+    if (header[0] != 'D' || header[1] != 'D' ||
+        header[2] != 'S' || header[3] != ' ')
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "DDS texture file %s has bad header.\n", filename);
+        return nullptr;
+    }
+
+    DDSurfaceDesc ddsd;
+    in.read(reinterpret_cast<char*>(&ddsd), sizeof ddsd);
+    int format = ParseDDSFormat(ddsd);
+
     if (format == -1)
     {
         DPRINTF(LOG_LEVEL_ERROR, "Unsupported format for DDS texture file %s.\n", filename);
@@ -182,9 +286,7 @@ Image* LoadDDSImage(const fs::path& filename)
 
     // If we have a compressed format, give up if S3 texture compression
     // isn't supported
-    if (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
-        format == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ||
-        format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    if (isCompressedDDSFormat(format))
     {
         if (!GLEW_EXT_texture_compression_s3tc)
             return nullptr;
@@ -215,3 +317,93 @@ Image* LoadDDSImage(const fs::path& filename)
 
     return img;
 }
+
+
+// Write a compressed or 32-bit RGBA image to a DDS file, including its
+// mipmap chain.  Used by the texture and normal map caches to store
+// artifacts that later runs can load directly through LoadDDSImage.
+bool SaveDDSImage(const fs::path& filename, Image& img)
+{
+    uint32_t fourCC = 0;
+    switch (img.getFormat())
+    {
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        fourCC = FourCC("DXT1");
+        break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        fourCC = FourCC("DXT3");
+        break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        fourCC = FourCC("DXT5");
+        break;
+    case GL_RGBA:
+        // Uncompressed 32-bit RGBA, used by the normal map cache
+        break;
+    default:
+        // Other uncompressed formats aren't worth caching
+        return false;
+    }
+
+    ofstream out(filename.string(), ios::out | ios::binary);
+    if (!out.good())
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Error creating DDS texture file %s.\n", filename);
+        return false;
+    }
+
+    DDSurfaceDesc ddsd;
+    memset(&ddsd, 0, sizeof ddsd);
+    ddsd.size = sizeof ddsd;
+    ddsd.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH |
+                 DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+    ddsd.width = (uint32_t) img.getWidth();
+    ddsd.height = (uint32_t) img.getHeight();
+    ddsd.pitch = (uint32_t) img.getMipLevelSize(0);
+    ddsd.mipMapLevels = (uint32_t) img.getMipLevelCount();
+    ddsd.format.size = sizeof ddsd.format;
+    if (fourCC != 0)
+    {
+        ddsd.format.flags = DDPF_FOURCC;
+        ddsd.format.fourCC = fourCC;
+    }
+    else
+    {
+        ddsd.format.flags = DDPF_RGB | DDPF_ALPHAPIXELS;
+        ddsd.format.bpp = 32;
+        ddsd.format.redMask   = 0x000000ff;
+        ddsd.format.greenMask = 0x0000ff00;
+        ddsd.format.blueMask  = 0x00ff0000;
+        ddsd.format.alphaMask = 0xff000000;
+    }
+    ddsd.caps.caps = DDSCAPS_TEXTURE;
+    if (img.getMipLevelCount() > 1)
+        ddsd.caps.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+    // The byte swapping macros are symmetric, so they also serve for
+    // the CPU to little-endian direction here.
+    LE_TO_CPU_INT32(ddsd.size, ddsd.size);
+    LE_TO_CPU_INT32(ddsd.flags, ddsd.flags);
+    LE_TO_CPU_INT32(ddsd.width, ddsd.width);
+    LE_TO_CPU_INT32(ddsd.height, ddsd.height);
+    LE_TO_CPU_INT32(ddsd.pitch, ddsd.pitch);
+    LE_TO_CPU_INT32(ddsd.mipMapLevels, ddsd.mipMapLevels);
+    LE_TO_CPU_INT32(ddsd.format.size, ddsd.format.size);
+    LE_TO_CPU_INT32(ddsd.format.flags, ddsd.format.flags);
+    LE_TO_CPU_INT32(ddsd.format.fourCC, ddsd.format.fourCC);
+    LE_TO_CPU_INT32(ddsd.format.bpp, ddsd.format.bpp);
+    LE_TO_CPU_INT32(ddsd.format.redMask, ddsd.format.redMask);
+    LE_TO_CPU_INT32(ddsd.format.greenMask, ddsd.format.greenMask);
+    LE_TO_CPU_INT32(ddsd.format.blueMask, ddsd.format.blueMask);
+    LE_TO_CPU_INT32(ddsd.format.alphaMask, ddsd.format.alphaMask);
+    LE_TO_CPU_INT32(ddsd.caps.caps, ddsd.caps.caps);
+
+    out.write("DDS ", 4);
+    out.write(reinterpret_cast<const char*>(&ddsd), sizeof ddsd);
+    for (int mip = 0; mip < img.getMipLevelCount(); mip++)
+    {
+        out.write(reinterpret_cast<const char*>(img.getMipLevel(mip)),
+                  img.getMipLevelSize(mip));
+    }
+
+    return out.good();
+}
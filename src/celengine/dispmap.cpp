@@ -8,6 +8,7 @@
 // of the License, or (at your option) any later version.
 
 #include "dispmap.h"
+#include <vector>
 
 
 DisplacementMap::DisplacementMap(int w, int h) :
@@ -41,3 +42,22 @@ void DisplacementMap::generate(DisplacementMapFunc func, void* info)
         }
     }
 }
+
+
+void DisplacementMap::generate(DisplacementMapBatchFunc func, void* info)
+{
+    std::vector<float> u(width);
+    std::vector<float> v(width);
+
+    for (int j = 0; j < width; j++)
+        u[j] = (float) j / (float) width;
+
+    // Hand the function one full row of samples per call
+    for (int i = 0; i < height; i++)
+    {
+        for (int j = 0; j < width; j++)
+            v[j] = (float) i / (float) height;
+
+        func(u.data(), v.data(), disp + i * width, (unsigned int) width, info);
+    }
+}
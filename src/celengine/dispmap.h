@@ -15,6 +15,13 @@
 
 typedef float (*DisplacementMapFunc)(float, float, void*);
 
+// Batched variant: fill disp[0..count) from the u and v sample arrays.
+// Callers hand over a whole row of samples at a time so that the
+// function can use vectorized noise kernels.
+typedef void (*DisplacementMapBatchFunc)(const float u[], const float v[],
+                                         float disp[], unsigned int count,
+                                         void* info);
+
 class DisplacementMap
 {
  public:
@@ -25,6 +32,7 @@ class DisplacementMap
     inline float getDisplacement(int x, int y) const;
     inline void setDisplacement(int x, int y, float d);
     void generate(DisplacementMapFunc func, void* info = nullptr);
+    void generate(DisplacementMapBatchFunc func, void* info = nullptr);
     void clear();
 
  private:
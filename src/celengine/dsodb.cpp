@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cassert>
 #include <algorithm>
+#include <queue>
 #include <celutil/debug.h>
 #include <celmath/mathlib.h>
 #include <celutil/util.h>
@@ -60,13 +61,43 @@ struct PtrCatalogNumberOrderingPredicate
 };
 
 
+DSODatabase::DSODatabase()
+{
+    GetMemoryAudit().registerReporter(this);
+}
+
+
 DSODatabase::~DSODatabase()
 {
+    GetMemoryAudit().unregisterReporter(this);
+
     delete [] DSOs;
     delete [] catalogNumberIndex;
 }
 
 
+void DSODatabase::reportMemory(MemoryLedger& ledger) const
+{
+    // The objects themselves are subclass-sized (Galaxy, Nebula, ...);
+    // the base object size makes this a floor rather than an exact
+    // figure.
+    ledger.add("dsodb", "objects",
+               (std::uintmax_t) capacity * sizeof(DeepSkyObject*) +
+               (std::uintmax_t) nDSOs * sizeof(DeepSkyObject));
+    ledger.add("dsodb", "catalog index", (std::uintmax_t) nDSOs * sizeof(DeepSkyObject*));
+
+    if (octreeRoot != nullptr)
+    {
+        std::uintmax_t nChildren = (std::uintmax_t) octreeRoot->countChildren();
+        ledger.add("dsodb", "octree",
+                   (nChildren + 1) * sizeof(DSOOctree) + nChildren * sizeof(DSOOctree*));
+    }
+
+    if (namesDB != nullptr)
+        ledger.add("dsodb", "names", namesDB->bytesUsed());
+}
+
+
 DeepSkyObject* DSODatabase::find(const uint32_t catalogNumber) const
 {
     Galaxy refDSO;  //terrible hack !!
@@ -204,6 +235,209 @@ void DSODatabase::findCloseDSOs(DSOHandler&     dsoHandler,
 }
 
 
+static void coneSearchNode(const DSOOctree* node,
+                           double scale,
+                           const Vector3d& origin,
+                           const Vector3d& axis,
+                           double halfAngle,
+                           float limitingMag,
+                           vector<DeepSkyObject*>& results)
+{
+    Vector3d toNode     = node->cellCenter() - origin;
+    double distance     = toNode.norm();
+    double nodeRadius   = scale * sqrt(3.0);
+
+    // Reject the node when its bounding sphere lies entirely outside
+    // the cone, or when even the brightest object in the subtree is
+    // too faint to reach the limiting magnitude from here.
+    if (distance > nodeRadius)
+    {
+        double cosToCenter = toNode.dot(axis) / distance;
+        double angleToCenter = acos(std::min(std::max(cosToCenter, -1.0), 1.0));
+        if (angleToCenter - asin(std::min(nodeRadius / distance, 1.0)) > halfAngle)
+            return;
+
+        if (astro::absToAppMag((double) node->getBrightestFactor(), distance - nodeRadius) > limitingMag)
+            return;
+    }
+
+    double minDistance = std::max(distance - nodeRadius, 0.0);
+    double dimmest = minDistance > 0.0 ? astro::appToAbsMag((double) limitingMag, minDistance) : 1000.0;
+
+    DeepSkyObject** first = node->firstObject();
+    for (unsigned int i = 0; i < node->objectCount(); ++i)
+    {
+        DeepSkyObject* dso = first[i];
+        float absMag = dso->getAbsoluteMagnitude();
+
+        // Node objects are sorted by ascending absolute magnitude.
+        if (absMag >= dimmest)
+            break;
+
+        Vector3d toObject = dso->getPosition() - origin;
+        double objDistance = toObject.norm();
+        if (objDistance > 0.0)
+        {
+            double cosAngle = toObject.dot(axis) / objDistance;
+            if (acos(std::min(std::max(cosAngle, -1.0), 1.0)) > halfAngle)
+                continue;
+        }
+
+        float appMag = objDistance >= 32.6167
+            ? (float) astro::absToAppMag((double) absMag, objDistance)
+            : absMag;
+        if (appMag < limitingMag)
+            results.push_back(dso);
+    }
+
+    if (node->hasChildren())
+    {
+        for (unsigned int i = 0; i < 8; ++i)
+            coneSearchNode(node->child(i), scale * 0.5, origin, axis,
+                           halfAngle, limitingMag, results);
+    }
+}
+
+
+vector<DeepSkyObject*> DSODatabase::coneSearch(const Vector3d& origin,
+                                               const Vector3d& direction,
+                                               double halfAngle,
+                                               float limitingMag) const
+{
+    vector<DeepSkyObject*> results;
+    if (octreeRoot == nullptr || direction.norm() == 0.0)
+        return results;
+
+    coneSearchNode(octreeRoot, (double) DSO_OCTREE_ROOT_SIZE,
+                   origin, direction.normalized(), halfAngle, limitingMag,
+                   results);
+    return results;
+}
+
+
+static void magnitudeRangeSearchNode(const DSOOctree* node,
+                                     double scale,
+                                     const Vector3d& origin,
+                                     double radius,
+                                     float faintestAbsMag,
+                                     vector<DeepSkyObject*>& results)
+{
+    double nodeRadius = scale * sqrt(3.0);
+    if ((origin - node->cellCenter()).norm() - nodeRadius > radius)
+        return;
+
+    // The brightest object actually present in this subtree is already
+    // fainter than the requested limit.
+    if (node->getBrightestFactor() > faintestAbsMag)
+        return;
+
+    double radiusSquared = radius * radius;
+
+    DeepSkyObject** first = node->firstObject();
+    for (unsigned int i = 0; i < node->objectCount(); ++i)
+    {
+        DeepSkyObject* dso = first[i];
+
+        // Node objects are sorted by ascending absolute magnitude.
+        if (dso->getAbsoluteMagnitude() >= faintestAbsMag)
+            break;
+
+        if ((dso->getPosition() - origin).squaredNorm() <= radiusSquared)
+            results.push_back(dso);
+    }
+
+    if (node->hasChildren())
+    {
+        for (unsigned int i = 0; i < 8; ++i)
+            magnitudeRangeSearchNode(node->child(i), scale * 0.5, origin,
+                                     radius, faintestAbsMag, results);
+    }
+}
+
+
+vector<DeepSkyObject*> DSODatabase::magnitudeRangeSearch(const Vector3d& origin,
+                                                         double radius,
+                                                         float faintestAbsMag) const
+{
+    vector<DeepSkyObject*> results;
+    if (octreeRoot == nullptr)
+        return results;
+
+    magnitudeRangeSearchNode(octreeRoot, (double) DSO_OCTREE_ROOT_SIZE,
+                             origin, radius, faintestAbsMag, results);
+    return results;
+}
+
+
+// Max-heap entry for the k-nearest search: the farthest of the current
+// candidates sits on top, ready to be displaced by a closer object.
+typedef pair<double, DeepSkyObject*> NearestCandidate;
+
+static void nearestDSOsNode(const DSOOctree* node,
+                            double scale,
+                            const Vector3d& origin,
+                            unsigned int k,
+                            priority_queue<NearestCandidate>& best)
+{
+    double nodeRadius = scale * sqrt(3.0);
+    double nodeMinDistance = std::max((origin - node->cellCenter()).norm() - nodeRadius, 0.0);
+
+    // Once k candidates are collected, a node farther away than the
+    // worst of them cannot improve the result.
+    if (best.size() >= k && nodeMinDistance * nodeMinDistance >= best.top().first)
+        return;
+
+    DeepSkyObject** first = node->firstObject();
+    for (unsigned int i = 0; i < node->objectCount(); ++i)
+    {
+        DeepSkyObject* dso = first[i];
+        double distanceSquared = (dso->getPosition() - origin).squaredNorm();
+        if (best.size() < k)
+        {
+            best.emplace(distanceSquared, dso);
+        }
+        else if (distanceSquared < best.top().first)
+        {
+            best.pop();
+            best.emplace(distanceSquared, dso);
+        }
+    }
+
+    if (node->hasChildren())
+    {
+        // Visit the closest children first so the candidate heap
+        // tightens as early as possible.
+        pair<double, unsigned int> order[8];
+        for (unsigned int i = 0; i < 8; ++i)
+            order[i] = make_pair((origin - node->child(i)->cellCenter()).squaredNorm(), i);
+        sort(order, order + 8);
+
+        for (unsigned int i = 0; i < 8; ++i)
+            nearestDSOsNode(node->child(order[i].second), scale * 0.5, origin, k, best);
+    }
+}
+
+
+vector<DeepSkyObject*> DSODatabase::nearestDSOs(const Vector3d& origin,
+                                                unsigned int k) const
+{
+    vector<DeepSkyObject*> results;
+    if (octreeRoot == nullptr || k == 0)
+        return results;
+
+    priority_queue<NearestCandidate> best;
+    nearestDSOsNode(octreeRoot, (double) DSO_OCTREE_ROOT_SIZE, origin, k, best);
+
+    results.resize(best.size());
+    for (size_t i = best.size(); i-- > 0;)
+    {
+        results[i] = best.top().second;
+        best.pop();
+    }
+    return results;
+}
+
+
 DSONameDatabase* DSODatabase::getNameDatabase() const
 {
     return namesDB;
@@ -219,69 +453,97 @@ void DSODatabase::setNameDatabase(DSONameDatabase* _namesDB)
 bool DSODatabase::load(istream& in, const fs::path& resourcePath)
 {
     Tokenizer tokenizer(&in);
-    Parser    parser(&tokenizer);
+    return load(tokenizer, resourcePath);
+}
+
+
+bool DSODatabase::load(Tokenizer& tokenizer, const fs::path& resourcePath)
+{
+    std::vector<DeepSkyCatalogEntry> entries;
+    // The arena must outlive the staged entries, which apply() consumes.
+    MemoryPool valuePool(16, 65536);
+    bool ok = parse(tokenizer, entries, &valuePool);
+    if (!apply(entries, resourcePath))
+        ok = false;
+    return ok;
+}
 
-    const char *d = resourcePath.string().c_str();
-    bindtextdomain(d, d); // domain name is the same as resource path
+
+bool DSODatabase::parse(Tokenizer& tokenizer, std::vector<DeepSkyCatalogEntry>& entries,
+                        MemoryPool* valuePool)
+{
+    Parser    parser(&tokenizer, valuePool);
 
     while (tokenizer.nextToken() != Tokenizer::TokenEnd)
     {
-        string objType;
-        string objName;
+        DeepSkyCatalogEntry entry;
 
         if (tokenizer.getTokenType() != Tokenizer::TokenName)
         {
             DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog file.\n");
             return false;
         }
-        objType = tokenizer.getNameValue();
+        entry.objType = tokenizer.getNameValue();
 
-        bool   autoGenCatalogNumber   = true;
-        uint32_t objCatalogNumber     = DeepSkyObject::InvalidCatalogNumber;
         if (tokenizer.getTokenType() == Tokenizer::TokenNumber)
         {
-            autoGenCatalogNumber   = false;
-            objCatalogNumber       = (uint32_t) tokenizer.getNumberValue();
+            entry.autoGenCatalogNumber = false;
+            entry.catalogNumber        = (uint32_t) tokenizer.getNumberValue();
             tokenizer.nextToken();
         }
 
-        if (autoGenCatalogNumber)
-        {
-            objCatalogNumber   = nextAutoCatalogNumber--;
-        }
-
         if (tokenizer.nextToken() != Tokenizer::TokenString)
         {
             DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog file: bad name.\n");
             return false;
         }
-        objName = tokenizer.getStringValue();
+        entry.objName = tokenizer.getStringValue();
 
-        Value* objParamsValue    = parser.readValue();
-        if (objParamsValue == nullptr ||
-            objParamsValue->getType() != Value::HashType)
+        entry.objParams = parser.readValue();
+        if (entry.objParams == nullptr ||
+            entry.objParams->getType() != Value::HashType)
         {
-            DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog entry %s\n", objName.c_str());
+            DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog entry %s\n", entry.objName.c_str());
+            delete entry.objParams;
             return false;
         }
 
-        Hash* objParams    = objParamsValue->getHash();
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+
+bool DSODatabase::apply(std::vector<DeepSkyCatalogEntry>& entries, const fs::path& resourcePath)
+{
+    const char *d = resourcePath.string().c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+
+    bool ok = true;
+    for (auto& entry : entries)
+    {
+        uint32_t objCatalogNumber = entry.catalogNumber;
+        if (entry.autoGenCatalogNumber)
+        {
+            objCatalogNumber   = nextAutoCatalogNumber--;
+        }
+
+        Hash* objParams    = entry.objParams->getHash();
         assert(objParams != nullptr);
 
         DeepSkyObject* obj = nullptr;
-        if (compareIgnoringCase(objType, "Galaxy") == 0)
+        if (compareIgnoringCase(entry.objType, "Galaxy") == 0)
             obj = new Galaxy();
-        else if (compareIgnoringCase(objType, "Globular") == 0)
+        else if (compareIgnoringCase(entry.objType, "Globular") == 0)
             obj = new Globular();
-        else if (compareIgnoringCase(objType, "Nebula") == 0)
+        else if (compareIgnoringCase(entry.objType, "Nebula") == 0)
             obj = new Nebula();
-        else if (compareIgnoringCase(objType, "OpenCluster") == 0)
+        else if (compareIgnoringCase(entry.objType, "OpenCluster") == 0)
             obj = new OpenCluster();
 
         if (obj != nullptr && obj->load(objParams, resourcePath))
         {
             obj->loadCategories(objParams, DataDisposition::Add, resourcePath.string());
-            delete objParamsValue;
 
             // Ensure that the DSO array is large enough
             if (nDSOs == capacity)
@@ -310,7 +572,7 @@ bool DSODatabase::load(istream& in, const fs::path& resourcePath)
 
             obj->setCatalogNumber(objCatalogNumber);
 
-            if (namesDB != nullptr && !objName.empty())
+            if (namesDB != nullptr && !entry.objName.empty())
             {
                 // List of names will replace any that already exist for
                 // this DSO.
@@ -322,14 +584,14 @@ bool DSODatabase::load(istream& in, const fs::path& resourcePath)
                 string::size_type startPos   = 0;
                 while (startPos != string::npos)
                 {
-                    string::size_type next    = objName.find(':', startPos);
+                    string::size_type next    = entry.objName.find(':', startPos);
                     string::size_type length  = string::npos;
                     if (next != string::npos)
                     {
                         length = next - startPos;
                         ++next;
                     }
-                    string DSOName = objName.substr(startPos, length);
+                    string DSOName = entry.objName.substr(startPos, length);
                     namesDB->add(objCatalogNumber, DSOName);
                     if (DSOName != _(DSOName.c_str()))
                         namesDB->add(objCatalogNumber, _(DSOName.c_str()));
@@ -340,11 +602,17 @@ bool DSODatabase::load(istream& in, const fs::path& resourcePath)
         else
         {
             DPRINTF(LOG_LEVEL_WARNING, "Bad Deep Sky Object definition--will continue parsing file.\n");
-            delete objParamsValue;
-            return false;
+            delete obj;
+            ok = false;
         }
+
+        delete entry.objParams;
+        entry.objParams = nullptr;
     }
-    return true;
+
+    entries.clear();
+
+    return ok;
 }
 
 
@@ -372,11 +640,63 @@ void DSODatabase::finish()
 }
 
 
+void DSODatabase::rebuild()
+{
+    // Discard the structures finish() derives from the DSO list; the
+    // objects themselves are untouched, so pointers held elsewhere
+    // (selections, markers) stay valid.
+    delete octreeRoot;
+    octreeRoot = nullptr;
+    delete[] catalogNumberIndex;
+    catalogNumberIndex = nullptr;
+    avgAbsMag = 0.0;
+
+    finish();
+}
+
+
+// Sort each node's object range by ascending absolute magnitude and
+// record the magnitude of the brightest object in every subtree. The
+// sorted ranges let the visibility traversal stop scanning a node at
+// the first object too faint to see, and the per-subtree brightest
+// magnitude gives a far tighter descent cutoff than the theoretical
+// exclusion factor in sparse regions of the catalog.
+static float indexNodeByMagnitude(DSOOctree* node)
+{
+    DeepSkyObject** first = node->firstObject();
+    sort(first, first + node->objectCount(),
+         [](const DeepSkyObject* a, const DeepSkyObject* b)
+         {
+             return a->getAbsoluteMagnitude() < b->getAbsoluteMagnitude();
+         });
+
+    float brightest = node->objectCount() > 0
+        ? first[0]->getAbsoluteMagnitude()
+        : 1000.0f;
+
+    if (node->hasChildren())
+    {
+        for (unsigned int i = 0; i < 8; ++i)
+            brightest = min(brightest, indexNodeByMagnitude(node->child(i)));
+    }
+
+    node->setBrightestFactor(brightest);
+    return brightest;
+}
+
+
 void DSODatabase::buildOctree()
 {
     DPRINTF(LOG_LEVEL_INFO, "Sorting DSOs into octree . . .\n");
     float absMag             = astro::appToAbsMag(DSO_OCTREE_MAGNITUDE, DSO_OCTREE_ROOT_SIZE * (float) sqrt(3.0));
 
+    // Let nodes grow with the catalog: doubling the node capacity
+    // halves the node count, and with magnitude-sorted ranges the
+    // extra objects per node cost nothing once the scan hits the
+    // faintness cutoff. The floor preserves the stock behavior for
+    // catalogs of the default size.
+    DynamicDSOOctree::setSplitThreshold((unsigned int) max(10, min(nDSOs / 1000, 75)));
+
     // TODO: investigate using a different center--it's possible that more
     // objects end up straddling the base level nodes when the center of the
     // octree is at the origin.
@@ -394,6 +714,8 @@ void DSODatabase::buildOctree()
     // are storing pointers to objects and not the objects themselves:
     root->rebuildAndSort(octreeRoot, firstDSO);
 
+    indexNodeByMagnitude(octreeRoot);
+
     DPRINTF(LOG_LEVEL_INFO, "%d DSOs total\n", (int) (firstDSO - sortedDSOs));
     DPRINTF(LOG_LEVEL_INFO, "Octree has %d nodes and %d DSOs.\n",
             1 + octreeRoot->countChildren(), octreeRoot->countObjects());
@@ -18,6 +18,7 @@
 #include <celengine/dsoname.h>
 #include <celengine/deepskyobj.h>
 #include <celengine/dsooctree.h>
+#include <celutil/memaudit.h>
 #include <celengine/parser.h>
 
 
@@ -26,13 +27,30 @@ constexpr const unsigned int MAX_DSO_NAMES = 10;
 // 100 Gly - on the order of the current size of the universe
 constexpr const float DSO_OCTREE_ROOT_SIZE = 1.0e11f;
 
+//! One object definition parsed from a dsc catalog and staged for later
+//! application to the database. objParams is owned by the entry until
+//! DSODatabase::apply() consumes it.
+struct DeepSkyCatalogEntry
+{
+    std::string objType;
+    std::string objName;
+    uint32_t catalogNumber{ DeepSkyObject::InvalidCatalogNumber };
+    bool autoGenCatalogNumber{ true };
+    Value* objParams{ nullptr };
+};
+
+
 //NOTE: this one and starDatabase should be derived from a common base class since they share lots of code and functionality.
-class DSODatabase
+class DSODatabase : public MemoryReporter
 {
  public:
-    DSODatabase() = default;
+    DSODatabase();
     ~DSODatabase();
 
+    //! MemoryReporter: account for the object array, indexes, octree
+    //! and name database.
+    void reportMemory(MemoryLedger&) const override;
+
 
     inline DeepSkyObject* getDSO(const uint32_t) const;
     inline uint32_t size() const;
@@ -54,6 +72,28 @@ class DSODatabase
                        const Eigen::Vector3d& obsPosition,
                        float radius) const;
 
+    // Spatial queries over the compiled octree, intended for scripted
+    // analytics; each prunes subtrees instead of scanning the whole
+    // object array. Positions and distances are in light years.
+
+    //! All DSOs within halfAngle radians of direction as seen from
+    //! origin, whose apparent magnitude from origin is brighter than
+    //! limitingMag.
+    std::vector<DeepSkyObject*> coneSearch(const Eigen::Vector3d& origin,
+                                           const Eigen::Vector3d& direction,
+                                           double halfAngle,
+                                           float limitingMag) const;
+
+    //! All DSOs within radius of origin whose absolute magnitude is
+    //! brighter than faintestAbsMag.
+    std::vector<DeepSkyObject*> magnitudeRangeSearch(const Eigen::Vector3d& origin,
+                                                     double radius,
+                                                     float faintestAbsMag) const;
+
+    //! The k DSOs closest to origin, nearest first.
+    std::vector<DeepSkyObject*> nearestDSOs(const Eigen::Vector3d& origin,
+                                            unsigned int k) const;
+
     std::string getDSOName    (const DeepSkyObject* const &, bool i18n = false) const;
     std::string getDSONameList(const DeepSkyObject* const &, const unsigned int maxNames = MAX_DSO_NAMES) const;
 
@@ -61,8 +101,22 @@ class DSODatabase
     void setNameDatabase(DSONameDatabase*);
 
     bool load(std::istream&, const fs::path& resourcePath = fs::path());
+    bool load(Tokenizer& tokenizer, const fs::path& resourcePath = fs::path());
+    //! Parse object definitions from a dsc catalog into a staging list
+    //! without touching the database. Has no shared state, so
+    //! independent catalogs may be parsed on separate threads.
+    static bool parse(Tokenizer& tokenizer, std::vector<DeepSkyCatalogEntry>& entries,
+                      MemoryPool* valuePool = nullptr);
+    //! Construct and register previously parsed objects in list order.
+    //! Not thread safe: object construction touches shared resource
+    //! caches (galaxy forms, categories, name database).
+    bool apply(std::vector<DeepSkyCatalogEntry>& entries, const fs::path& resourcePath = fs::path());
     bool loadBinary(std::istream&);
     void finish();
+    //! Rebuild the octree and indexes after loading additional catalogs
+    //! into a finished database. DeepSkyObject pointers remain stable,
+    //! so existing selections stay valid.
+    void rebuild();
 
     static DSODatabase* read(std::istream&);
 
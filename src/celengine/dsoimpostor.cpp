@@ -0,0 +1,186 @@
+// dsoimpostor.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Impostor cache for distant deep sky objects.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "dsoimpostor.h"
+#include "renderglsl.h"
+#include <cmath>
+
+using namespace Eigen;
+using namespace std;
+
+// Recapture thresholds: about one degree of view direction drift,
+// five percent of distance or brightness change. Distant DSOs change
+// appearance slowly, so captures are rare once the cache is warm.
+static const float ViewAngleCosThreshold  = 0.99985f;
+static const float DistanceRatioThreshold = 0.05f;
+static const float BrightnessThreshold    = 0.05f;
+
+
+DSOImpostorCache::~DSOImpostorCache()
+{
+    delete fbo;
+}
+
+
+bool DSOImpostorCache::isUsable()
+{
+    if (fboFailed)
+        return false;
+
+    if (fbo == nullptr)
+    {
+        fbo = new FramebufferObject(AtlasSize, AtlasSize,
+                                    FramebufferObject::ColorAttachment);
+        if (!fbo->isValid())
+        {
+            delete fbo;
+            fbo = nullptr;
+            fboFailed = true;
+            return false;
+        }
+
+        freeTiles.reserve(TileCount);
+        for (unsigned int i = TileCount; i > 0; i--)
+            freeTiles.push_back(i - 1);
+        tileOwner.resize(TileCount, nullptr);
+    }
+
+    return true;
+}
+
+
+void DSOImpostorCache::beginFrame()
+{
+    currentFrame++;
+}
+
+
+void DSOImpostorCache::evict(const DeepSkyObject* dso)
+{
+    auto iter = entries.find(dso);
+    if (iter == entries.end())
+        return;
+
+    freeTiles.push_back(iter->second.tile);
+    tileOwner[iter->second.tile] = nullptr;
+    entries.erase(iter);
+}
+
+
+DSOImpostorCache::Entry* DSOImpostorCache::acquire(const DeepSkyObject* dso,
+                                                   const Vector3f& relPos,
+                                                   float brightness,
+                                                   bool& needsCapture)
+{
+    float distance = relPos.norm();
+    Vector3f viewDir = relPos / distance;
+
+    auto iter = entries.find(dso);
+    if (iter != entries.end())
+    {
+        Entry& entry = iter->second;
+        entry.lastUsedFrame = currentFrame;
+        needsCapture =
+            viewDir.dot(entry.viewDir) < ViewAngleCosThreshold ||
+            abs(distance / entry.distance - 1.0f) > DistanceRatioThreshold ||
+            abs(brightness - entry.brightness) > BrightnessThreshold * max(entry.brightness, 0.01f);
+        return &entry;
+    }
+
+    if (freeTiles.empty())
+    {
+        // Evict the least recently used entry; an entry used this
+        // frame is still needed and must not be recycled.
+        const DeepSkyObject* lruDSO = nullptr;
+        unsigned int lruFrame = currentFrame;
+        for (const auto& e : entries)
+        {
+            if (e.second.lastUsedFrame < lruFrame)
+            {
+                lruFrame = e.second.lastUsedFrame;
+                lruDSO = e.first;
+            }
+        }
+        if (lruDSO == nullptr)
+            return nullptr;
+        evict(lruDSO);
+    }
+
+    Entry entry;
+    entry.tile = freeTiles.back();
+    freeTiles.pop_back();
+    tileOwner[entry.tile] = dso;
+    entry.lastUsedFrame = currentFrame;
+
+    needsCapture = true;
+    return &(entries[dso] = entry);
+}
+
+
+void DSOImpostorCache::beginCapture(const Entry& entry)
+{
+    glGetIntegerv(GL_VIEWPORT, savedViewport);
+    fbo->bind();
+
+    unsigned int tilesPerRow = AtlasSize / TileSize;
+    GLint x = (GLint) ((entry.tile % tilesPerRow) * TileSize);
+    GLint y = (GLint) ((entry.tile / tilesPerRow) * TileSize);
+
+    glViewport(x, y, TileSize, TileSize);
+    glScissor(x, y, TileSize, TileSize);
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+}
+
+
+void DSOImpostorCache::endCapture()
+{
+    fbo->unbind();
+    glViewport(savedViewport[0], savedViewport[1],
+               savedViewport[2], savedViewport[3]);
+}
+
+
+void DSOImpostorCache::drawImpostor(const Entry& entry, const Vector3f& relPos)
+{
+    unsigned int tilesPerRow = AtlasSize / TileSize;
+    float uvScale = (float) TileSize / (float) AtlasSize;
+    float u0 = (float) (entry.tile % tilesPerRow) * uvScale;
+    float v0 = (float) (entry.tile / tilesPerRow) * uvScale;
+
+    Vector3f right = entry.right * entry.halfSize;
+    Vector3f up    = entry.up * entry.halfSize;
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, fbo->colorTexture());
+
+    // Tiles were captured over transparent black in a pass that
+    // blends additively, so the stored color is already the object's
+    // screen contribution.
+    glBlendFunc(GL_ONE, GL_ONE);
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+
+    glBegin(GL_QUADS);
+    glTexCoord2f(u0, v0);
+    glVertex3fv(Vector3f(relPos - right - up).data());
+    glTexCoord2f(u0 + uvScale, v0);
+    glVertex3fv(Vector3f(relPos + right - up).data());
+    glTexCoord2f(u0 + uvScale, v0 + uvScale);
+    glVertex3fv(Vector3f(relPos + right + up).data());
+    glTexCoord2f(u0, v0 + uvScale);
+    glVertex3fv(Vector3f(relPos - right + up).data());
+    glEnd();
+
+    // restore the DSO pass blend mode
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+}
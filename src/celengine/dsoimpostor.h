@@ -0,0 +1,90 @@
+// dsoimpostor.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Impostor cache for distant deep sky objects. A DSO spanning only a
+// few pixels is rendered once into a tile of a shared texture atlas
+// and redrawn as a single billboard until the view direction,
+// distance or brightness drifts past the recapture thresholds.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <map>
+#include <vector>
+
+class DeepSkyObject;
+class FramebufferObject;
+
+class DSOImpostorCache
+{
+ public:
+    // 16 x 16 tiles of 64 pixels in a 1024 x 1024 atlas
+    static const unsigned int AtlasSize = 1024;
+    static const unsigned int TileSize  = 64;
+    static const unsigned int TileCount = (AtlasSize / TileSize) * (AtlasSize / TileSize);
+
+    struct Entry
+    {
+        unsigned int tile{ 0 };
+        // capture state; a drift past the thresholds forces a recapture
+        Eigen::Vector3f viewDir{ Eigen::Vector3f::Zero() };
+        float distance{ 0.0f };
+        float brightness{ 0.0f };
+        // world space billboard frame at capture time
+        Eigen::Vector3f right{ Eigen::Vector3f::Zero() };
+        Eigen::Vector3f up{ Eigen::Vector3f::Zero() };
+        float halfSize{ 0.0f };
+        unsigned int lastUsedFrame{ 0 };
+    };
+
+    DSOImpostorCache() = default;
+    ~DSOImpostorCache();
+    DSOImpostorCache(const DSOImpostorCache&) = delete;
+    DSOImpostorCache& operator=(const DSOImpostorCache&) = delete;
+
+    //! Lazily create the atlas; false when framebuffer objects are
+    //! unusable, in which case callers fall back to direct rendering.
+    bool isUsable();
+
+    //! Bump the frame counter used for least-recently-used eviction.
+    void beginFrame();
+
+    //! Find or allocate the entry for a DSO. needsCapture is set when
+    //! the tile contents are missing or stale and the caller must
+    //! redraw the object into the tile. Returns nullptr if every tile
+    //! was already used this frame.
+    Entry* acquire(const DeepSkyObject* dso,
+                   const Eigen::Vector3f& relPos,
+                   float brightness,
+                   bool& needsCapture);
+
+    //! Bind the atlas framebuffer and restrict drawing to the entry's
+    //! tile, cleared to transparent black. The caller owns the
+    //! projection and modelview setup for the capture.
+    void beginCapture(const Entry&);
+    //! Return to the normal render target and restore the viewport.
+    void endCapture();
+
+    //! Draw the captured tile as one world anchored billboard. The
+    //! DSO pass blends additively, and tiles are captured over black,
+    //! so the quad is emitted with GL_ONE / GL_ONE blending.
+    void drawImpostor(const Entry&, const Eigen::Vector3f& relPos);
+
+ private:
+    void evict(const DeepSkyObject* dso);
+
+    FramebufferObject* fbo{ nullptr };
+    bool fboFailed{ false };
+    std::map<const DeepSkyObject*, Entry> entries;
+    std::vector<unsigned int> freeTiles;
+    std::vector<const DeepSkyObject*> tileOwner;
+    unsigned int currentFrame{ 0 };
+    GLint savedViewport[4];
+};
@@ -74,14 +74,12 @@ void DSOOctree::processVisibleObjects(DSOHandler&    processor,
                                       double         scale,
                                       OctreeProcStats *stats) const
 {
-#ifdef OCTREE_DEBUG
-    size_t h;
+    size_t h = 0;
     if (stats != nullptr)
     {
         h = stats->height + 1;
         stats->nodes++;
     }
-#endif
     // See if this node lies within the view frustum
 
     // Test the cubic octree node against each one of the five
@@ -95,6 +93,15 @@ void DSOOctree::processVisibleObjects(DSOHandler&    processor,
             return;
     }
 
+    if (stats != nullptr && stats->visitedCells != nullptr)
+    {
+        OctreeVisitedCell cell;
+        cell.center = cellCenterPos.cast<float>();
+        cell.scale = (float) scale;
+        cell.objects = nObjects;
+        stats->visitedCells->push_back(cell);
+    }
+
     // Compute the distance to node; this is equal to the distance to
     // the cellCenterPos of the node minus the boundingRadius of the node, scale * SQRT3.
     double minDistance = (obsPosition - cellCenterPos).norm() - scale * DSOOctree::SQRT3;
@@ -104,25 +111,30 @@ void DSOOctree::processVisibleObjects(DSOHandler&    processor,
 
     for (unsigned int i=0; i<nObjects; ++i)
     {
-#ifdef OCTREE_DEBUG
-        if (stats != nullptr)
-            stats->objects++;
-#endif
         DeepSkyObject* _obj = _firstObject[i];
         float  absMag      = _obj->getAbsoluteMagnitude();
-        if (absMag < dimmest)
-        {
-            double distance    = (obsPosition - _obj->getPosition()).norm() - _obj->getBoundingSphereRadius();
-            float appMag = (float) ((distance >= 32.6167) ? astro::absToAppMag((double) absMag, distance) : absMag);
 
-            if ( appMag < limitingFactor)
-                processor.process(_obj, distance, absMag);
-        }
+        // The DSO database sorts each node's objects by ascending
+        // absolute magnitude after the octree is built, so the first
+        // object too faint to be seen from this node ends the scan.
+        if (absMag >= dimmest)
+            break;
+
+        if (stats != nullptr)
+            stats->objects++;
+        double distance    = (obsPosition - _obj->getPosition()).norm() - _obj->getBoundingSphereRadius();
+        float appMag = (float) ((distance >= 32.6167) ? astro::absToAppMag((double) absMag, distance) : absMag);
+
+        if ( appMag < limitingFactor)
+            processor.process(_obj, distance, absMag);
     }
 
     // See if any of the objects in child nodes are potentially included
-    // that we need to recurse deeper.
-    if (minDistance <= 0.0 || astro::absToAppMag((double) exclusionFactor, minDistance) <= limitingFactor)
+    // that we need to recurse deeper. The brightest factor records the
+    // magnitude of the brightest object actually present in the subtree;
+    // it is a much tighter bound than the construction-time exclusion
+    // factor in sparsely populated regions of the catalog.
+    if (minDistance <= 0.0 || astro::absToAppMag((double) brightestFactor, minDistance) <= limitingFactor)
     {
         // Recurse into the child nodes
         if (_children != nullptr)
@@ -135,15 +147,11 @@ void DSOOctree::processVisibleObjects(DSOHandler&    processor,
                                                     limitingFactor,
                                                     scale * 0.5f,
                                                     stats);
-#ifdef OCTREE_DEBUG
                 if (stats != nullptr && stats->height > h)
                     h = stats->height;
-#endif
             }
-#ifdef OCTREE_DEBUG
             if (stats != nullptr)
                 stats->height = h;
-#endif
         }
     }
 }
@@ -0,0 +1,460 @@
+// flightpath.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Recorded observer flight paths.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include "flightpath.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+namespace
+{
+
+// Format identification; the magic doubles as a version gate for the
+// camera sync stream.
+const char FlightPathMagic[4] = { 'C', 'E', 'L', 'F' };
+const uint16_t FlightPathVersion = 1;
+
+// Record flags
+const uint8_t AbsolutePositionFlag = 0x01;
+
+// Deltas are quantized to millimeters. A component further than this
+// many kilometers from the previous keyframe is stored as an absolute
+// record instead: beyond it the millimeter count no longer fits the
+// exact integer range of a double, let alone an int64.
+const double MaxDeltaKm = 1.0e9;
+const double KmToMm = 1.0e6;
+
+// Orientation components are quantized to signed 16 bits.
+const double QuatScale = 32767.0;
+
+
+// All multi-byte fields are stored little-endian, assembled bytewise
+// so the encoding doesn't depend on the host byte order.
+
+void writeUint64(ostream& out, uint64_t v)
+{
+    char buf[8];
+    for (int i = 0; i < 8; i++)
+        buf[i] = (char) ((v >> (i * 8)) & 0xff);
+    out.write(buf, 8);
+}
+
+void writeUint32(ostream& out, uint32_t v)
+{
+    char buf[4];
+    for (int i = 0; i < 4; i++)
+        buf[i] = (char) ((v >> (i * 8)) & 0xff);
+    out.write(buf, 4);
+}
+
+void writeUint16(ostream& out, uint16_t v)
+{
+    char buf[2];
+    buf[0] = (char) (v & 0xff);
+    buf[1] = (char) ((v >> 8) & 0xff);
+    out.write(buf, 2);
+}
+
+void writeUint8(ostream& out, uint8_t v)
+{
+    out.put((char) v);
+}
+
+void writeInt64(ostream& out, int64_t v)
+{
+    writeUint64(out, (uint64_t) v);
+}
+
+void writeInt16(ostream& out, int16_t v)
+{
+    writeUint16(out, (uint16_t) v);
+}
+
+void writeFloat(ostream& out, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint32(out, bits);
+}
+
+void writeDouble(ostream& out, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint64(out, bits);
+}
+
+// BigFix coordinates are stored in the same base64 encoding the
+// cel:// URL scheme uses, length-prefixed.
+void writeBigFix(ostream& out, const BigFix& v)
+{
+    BigFix b = v;
+    string s = b.toString();
+    writeUint8(out, (uint8_t) s.length());
+    out.write(s.c_str(), s.length());
+}
+
+bool readUint64(istream& in, uint64_t& v)
+{
+    char buf[8];
+    if (!in.read(buf, 8))
+        return false;
+    v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t) (uint8_t) buf[i] << (i * 8);
+    return true;
+}
+
+bool readUint32(istream& in, uint32_t& v)
+{
+    char buf[4];
+    if (!in.read(buf, 4))
+        return false;
+    v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t) (uint8_t) buf[i] << (i * 8);
+    return true;
+}
+
+bool readUint16(istream& in, uint16_t& v)
+{
+    char buf[2];
+    if (!in.read(buf, 2))
+        return false;
+    v = (uint16_t) ((uint8_t) buf[0] | ((uint16_t) (uint8_t) buf[1] << 8));
+    return true;
+}
+
+bool readUint8(istream& in, uint8_t& v)
+{
+    int c = in.get();
+    if (c == EOF)
+        return false;
+    v = (uint8_t) c;
+    return true;
+}
+
+bool readInt64(istream& in, int64_t& v)
+{
+    uint64_t u;
+    if (!readUint64(in, u))
+        return false;
+    v = (int64_t) u;
+    return true;
+}
+
+bool readInt16(istream& in, int16_t& v)
+{
+    uint16_t u;
+    if (!readUint16(in, u))
+        return false;
+    v = (int16_t) u;
+    return true;
+}
+
+bool readFloat(istream& in, float& v)
+{
+    uint32_t bits;
+    if (!readUint32(in, bits))
+        return false;
+    memcpy(&v, &bits, sizeof v);
+    return true;
+}
+
+bool readDouble(istream& in, double& v)
+{
+    uint64_t bits;
+    if (!readUint64(in, bits))
+        return false;
+    memcpy(&v, &bits, sizeof v);
+    return true;
+}
+
+bool readBigFix(istream& in, BigFix& v)
+{
+    uint8_t len = 0;
+    if (!readUint8(in, len))
+        return false;
+    char buf[256];
+    if (!in.read(buf, len))
+        return false;
+    v = BigFix(string(buf, len));
+    return true;
+}
+
+} // end unnamed namespace
+
+
+void FlightPath::clear()
+{
+    samples.clear();
+    lastSegment = 0;
+}
+
+
+void FlightPath::addSample(double t,
+                           const UniversalCoord& position,
+                           const Quaterniond& orientation)
+{
+    if (!samples.empty() && t <= samples.back().t)
+        return;
+
+    Sample s;
+    s.t = t;
+    s.position = position;
+    s.orientation = orientation;
+    samples.push_back(s);
+}
+
+
+double FlightPath::duration() const
+{
+    if (samples.empty())
+        return 0.0;
+    return samples.back().t - samples.front().t;
+}
+
+
+bool FlightPath::evaluate(double t,
+                          UniversalCoord& position,
+                          Quaterniond& orientation) const
+{
+    if (samples.empty())
+        return false;
+
+    if (samples.size() == 1 || t <= samples.front().t)
+    {
+        position = samples.front().position;
+        orientation = samples.front().orientation;
+        return true;
+    }
+
+    if (t >= samples.back().t)
+    {
+        position = samples.back().position;
+        orientation = samples.back().orientation;
+        return true;
+    }
+
+    // Locate the segment containing t; the cached index is right (or
+    // one short) for monotonic replay, with a binary search fallback
+    // for random access.
+    auto n = (unsigned int) samples.size();
+    unsigned int i = min(lastSegment, n - 2);
+    if (!(samples[i].t <= t && t < samples[i + 1].t))
+    {
+        if (i + 2 < n && samples[i + 1].t <= t && t < samples[i + 2].t)
+        {
+            i++;
+        }
+        else
+        {
+            auto iter = upper_bound(samples.begin(), samples.end(), t,
+                                    [](double val, const Sample& s) { return val < s.t; });
+            i = (unsigned int) (iter - samples.begin()) - 1;
+        }
+    }
+    lastSegment = i;
+
+    const Sample& s0 = samples[i];
+    const Sample& s1 = samples[i + 1];
+    double h = s1.t - s0.t;
+    double u = (t - s0.t) / h;
+
+    // Catmull-Rom tangents from the neighboring keyframes, scaled for
+    // the nonuniform sample spacing and clamped to the chord at the
+    // ends of the path. Everything is evaluated in double precision
+    // kilometer offsets from the segment start.
+    Vector3d p1 = s1.position.offsetFromKm(s0.position);
+    Vector3d m0 = p1;
+    Vector3d m1 = p1;
+    if (i > 0)
+    {
+        const Sample& sp = samples[i - 1];
+        m0 = (p1 - sp.position.offsetFromKm(s0.position)) * (h / (s1.t - sp.t));
+    }
+    if (i + 2 < n)
+    {
+        const Sample& sn = samples[i + 2];
+        m1 = sn.position.offsetFromKm(s0.position) * (h / (sn.t - s0.t));
+    }
+
+    // Cubic Hermite basis; the p0 terms vanish since p0 is the origin.
+    double u2 = u * u;
+    double u3 = u2 * u;
+    Vector3d offset = (u3 - 2.0 * u2 + u) * m0 +
+                      (-2.0 * u3 + 3.0 * u2) * p1 +
+                      (u3 - u2) * m1;
+    UniversalCoord base = s0.position;
+    position = base.offsetKm(offset);
+
+    Quaterniond q1 = s1.orientation;
+    if (s0.orientation.dot(q1) < 0.0)
+        q1.coeffs() = -q1.coeffs();
+    orientation = s0.orientation.slerp(u, q1);
+
+    return true;
+}
+
+
+bool FlightPath::write(ostream& out) const
+{
+    out.write(FlightPathMagic, sizeof FlightPathMagic);
+    writeUint16(out, FlightPathVersion);
+    writeUint16(out, 0);  // reserved
+    writeUint32(out, (uint32_t) samples.size());
+
+    // prev tracks the position a decoder will reconstruct, so the
+    // millimeter quantization error doesn't accumulate as drift.
+    UniversalCoord prev;
+    double prevT = 0.0;
+    Quaterniond prevQ(Quaterniond::Identity());
+
+    for (unsigned int i = 0; i < samples.size(); i++)
+    {
+        const Sample& s = samples[i];
+
+        bool absolute = i == 0;
+        Vector3d deltaKm(Vector3d::Zero());
+        if (!absolute)
+        {
+            deltaKm = s.position.offsetFromKm(prev);
+            if (fabs(deltaKm.x()) > MaxDeltaKm ||
+                fabs(deltaKm.y()) > MaxDeltaKm ||
+                fabs(deltaKm.z()) > MaxDeltaKm)
+            {
+                absolute = true;
+            }
+        }
+
+        writeUint8(out, absolute ? AbsolutePositionFlag : 0);
+        writeFloat(out, (float) (s.t - prevT));
+        prevT = s.t;
+
+        if (absolute)
+        {
+            writeBigFix(out, s.position.x);
+            writeBigFix(out, s.position.y);
+            writeBigFix(out, s.position.z);
+            prev = s.position;
+        }
+        else
+        {
+            Vector3d mm = deltaKm * KmToMm;
+            auto dx = (int64_t) llround(mm.x());
+            auto dy = (int64_t) llround(mm.y());
+            auto dz = (int64_t) llround(mm.z());
+            writeInt64(out, dx);
+            writeInt64(out, dy);
+            writeInt64(out, dz);
+            prev = prev.offsetKm(Vector3d((double) dx, (double) dy, (double) dz) / KmToMm);
+        }
+
+        // Keep successive quaternions in the same hemisphere, so the
+        // decoder's interpolation never takes the long way around.
+        Quaterniond q = s.orientation;
+        if (prevQ.dot(q) < 0.0)
+            q.coeffs() = -q.coeffs();
+        prevQ = q;
+
+        writeInt16(out, (int16_t) lround(q.x() * QuatScale));
+        writeInt16(out, (int16_t) lround(q.y() * QuatScale));
+        writeInt16(out, (int16_t) lround(q.z() * QuatScale));
+        writeInt16(out, (int16_t) lround(q.w() * QuatScale));
+    }
+
+    return out.good();
+}
+
+
+bool FlightPath::read(istream& in)
+{
+    clear();
+
+    char magic[4];
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    uint32_t count = 0;
+    if (!in.read(magic, sizeof magic) ||
+        memcmp(magic, FlightPathMagic, sizeof magic) != 0 ||
+        !readUint16(in, version) ||
+        version != FlightPathVersion ||
+        !readUint16(in, reserved) ||
+        !readUint32(in, count))
+    {
+        return false;
+    }
+
+    samples.reserve(count);
+
+    UniversalCoord prev;
+    double t = 0.0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t flags = 0;
+        float dt = 0.0f;
+        if (!readUint8(in, flags) || !readFloat(in, dt))
+        {
+            clear();
+            return false;
+        }
+        t += dt;
+
+        Sample s;
+        s.t = t;
+
+        if ((flags & AbsolutePositionFlag) != 0)
+        {
+            if (!readBigFix(in, s.position.x) ||
+                !readBigFix(in, s.position.y) ||
+                !readBigFix(in, s.position.z))
+            {
+                clear();
+                return false;
+            }
+        }
+        else
+        {
+            int64_t dx = 0, dy = 0, dz = 0;
+            if (!readInt64(in, dx) || !readInt64(in, dy) || !readInt64(in, dz))
+            {
+                clear();
+                return false;
+            }
+            s.position = prev.offsetKm(Vector3d((double) dx, (double) dy, (double) dz) / KmToMm);
+        }
+        prev = s.position;
+
+        int16_t qx = 0, qy = 0, qz = 0, qw = 0;
+        if (!readInt16(in, qx) || !readInt16(in, qy) ||
+            !readInt16(in, qz) || !readInt16(in, qw))
+        {
+            clear();
+            return false;
+        }
+        s.orientation = Quaterniond(qw / QuatScale,
+                                    qx / QuatScale,
+                                    qy / QuatScale,
+                                    qz / QuatScale);
+        s.orientation.normalize();
+
+        samples.push_back(s);
+    }
+
+    return true;
+}
@@ -0,0 +1,95 @@
+// flightpath.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Recorded observer flight paths: timestamped position/orientation
+// keyframes with a compact binary serialization and direct spline
+// evaluation for replay.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELENGINE_FLIGHTPATH_H_
+#define _CELENGINE_FLIGHTPATH_H_
+
+#include <iosfwd>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+#include <celengine/univcoord.h>
+
+
+/*! A FlightPath is a recorded camera trajectory: a sequence of
+ *  timestamped keyframes in universal coordinates, captured while the
+ *  user flies by hand. Replay evaluates a Catmull-Rom spline over the
+ *  keyframes directly, which is both cheaper and smoother than
+ *  recomputing goto logic from a script.
+ *
+ *  The binary format stores the first keyframe exactly (BigFix
+ *  coordinates in the same base64 encoding used by cel:// URLs) and
+ *  each later keyframe as a millimeter-quantized delta from its
+ *  predecessor together with a quantized orientation, so long
+ *  recordings stay small. A keyframe whose delta would overflow the
+ *  quantizer falls back to an exact absolute record. Records refer
+ *  only to the immediately preceding keyframe, so the same encoding
+ *  can be streamed one sample at a time for inter-node camera sync.
+ */
+class FlightPath
+{
+ public:
+    struct Sample
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        double t;                      // seconds from the start of the path
+        UniversalCoord position;
+        Eigen::Quaterniond orientation;
+    };
+
+    void clear();
+
+    //! Append a keyframe; samples must be added in increasing time
+    //! order, and out-of-order samples are dropped.
+    void addSample(double t,
+                   const UniversalCoord& position,
+                   const Eigen::Quaterniond& orientation);
+
+    unsigned int sampleCount() const
+    {
+        return (unsigned int) samples.size();
+    }
+
+    //! Length of the recording in seconds.
+    double duration() const;
+
+    /*! Evaluate the path at t seconds from its start. Position is
+     *  interpolated with a Catmull-Rom spline through the keyframes
+     *  (evaluated in double precision kilometer offsets from the
+     *  segment start, so precision doesn't degrade far from the
+     *  origin); orientation is spherically interpolated. Times outside
+     *  the recording clamp to the first or last keyframe. Returns
+     *  false only for an empty path.
+     */
+    bool evaluate(double t,
+                  UniversalCoord& position,
+                  Eigen::Quaterniond& orientation) const;
+
+    //! Serialize the path to its binary format; returns false if the
+    //! stream fails.
+    bool write(std::ostream& out) const;
+
+    //! Replace the contents of this path with one read from a stream;
+    //! returns false (leaving the path empty) on a malformed stream.
+    bool read(std::istream& in);
+
+ private:
+    std::vector<Sample, Eigen::aligned_allocator<Sample>> samples;
+
+    // Replay advances monotonically, so remember the last segment used
+    // by evaluate() instead of searching from scratch each frame.
+    mutable unsigned int lastSegment{ 0 };
+};
+
+#endif // _CELENGINE_FLIGHTPATH_H_
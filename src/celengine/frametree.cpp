@@ -131,16 +131,19 @@ FrameTree::recomputeBoundingSphere()
         m_maxChildRadius = 0.0;
         m_containsSecondaryIlluminators = false;
         m_childClassMask = 0;
+        m_childVisibility.clear();
+        m_childVisibility.reserve(children.size());
 
         for (const auto &phase : children)
         {
-            double bodyRadius = phase->body()->getRadius();
-            double r = phase->body()->getCullingRadius() + phase->orbit()->getBoundingRadius();
+            Body* body = phase->body();
+            double bodyRadius = body->getRadius();
+            double r = body->getCullingRadius() + phase->orbit()->getBoundingRadius();
             m_maxChildRadius = max(m_maxChildRadius, bodyRadius);
-            m_containsSecondaryIlluminators = m_containsSecondaryIlluminators || phase->body()->isSecondaryIlluminator();
-            m_childClassMask |= phase->body()->getClassification();
+            m_containsSecondaryIlluminators = m_containsSecondaryIlluminators || body->isSecondaryIlluminator();
+            m_childClassMask |= body->getClassification();
 
-            FrameTree* tree = phase->body()->getFrameTree();
+            FrameTree* tree = body->getFrameTree();
             if (tree != nullptr)
             {
                 tree->recomputeBoundingSphere();
@@ -151,6 +154,16 @@ FrameTree::recomputeBoundingSphere()
             }
 
             m_boundingSphereRadius = max(m_boundingSphereRadius, r);
+
+            // Pack this child's visibility state for the render traversal
+            auto vis = (uint32_t) body->getClassification() & ChildClassificationMask;
+            if (body->isVisible())
+                vis |= ChildVisible;
+            if (body->isSecondaryIlluminator())
+                vis |= ChildSecondaryIlluminator;
+            if (tree != nullptr)
+                vis |= ChildHasSubtree;
+            m_childVisibility.push_back(vis);
         }
     }
 }
@@ -16,6 +16,7 @@
 #include <memory>
 #include <vector>
 #include <cstddef>
+#include <cstdint>
 #include "frame.h"
 #include "timelinephase.h"
 
@@ -89,6 +90,28 @@ public:
         return m_childClassMask;
     }
 
+    // Flag bits packed above the classification in the per-child
+    // visibility table.
+    enum
+    {
+        ChildClassificationMask  = 0x00ffffff,
+        ChildVisible             = 0x01000000,
+        ChildSecondaryIlluminator= 0x02000000,
+        ChildHasSubtree          = 0x04000000
+    };
+
+    /*! Packed visibility state of each child, in child order: the
+     *  body's classification plus the Child* flag bits above. Rebuilt
+     *  with the rest of the derived state by recomputeBoundingSphere(),
+     *  so it is only valid when the tree is up to date. The render
+     *  traversal scans this table linearly to reject children that
+     *  cannot contribute to a frame without touching the bodies.
+     */
+    const std::vector<uint32_t>& childVisibility() const
+    {
+        return m_childVisibility;
+    }
+
 private:
     Star* starParent;
     Body* bodyParent;
@@ -100,6 +123,8 @@ private:
     bool m_changed{ false };
     int m_childClassMask{ 0 };
 
+    std::vector<uint32_t> m_childVisibility;
+
     ReferenceFrame::SharedConstPtr defaultFrame;
 };
 
@@ -58,6 +58,11 @@ class GalacticForm
 public:
     BlobVector* blobs;
     Vector3f scale;
+
+    // Static sprite geometry, uploaded once on first use; forms are
+    // shared between all galaxies of one Hubble type, so there is one
+    // buffer per template, not per galaxy.
+    celgl::VertexObject vo{ GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW };
 };
 
 struct GalaxyTypeName
@@ -284,19 +289,63 @@ void Galaxy::render(const Vector3f& offset,
     }
 }
 
-struct GalaxyVertex
+// Per-vertex layout of the static galaxy sprite buffer. position
+// holds the blob position in form space with the per-blob sprite
+// scale factor in w; texCoord packs the sprite corner, the color
+// table index and the blob brightness. Billboarding, the distance
+// dependent alpha and the color lookup all happen in the vertex
+// shader, so the buffer never changes after upload.
+struct GalaxyVtx
 {
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
-
-    Vector4f position;
-    Matrix<GLshort, 4, 1> texCoord; // texCoord.x = x, texCoord.y = y, texCoord.z = color index, texCoord.w = alpha
+    float position[4];  // xyz = form space position, w = sprite scale factor
+    float texCoord[4];  // x, y = corner, z = color index, w = brightness
 };
 
-static void draw(const GalaxyVertex *v, size_t count, void *indices)
+static const float spriteScaleFactor = 1.0f / 1.55f;
+
+static void initGalaxyData(celgl::VertexObject& vo, const BlobVector* points)
 {
-    glVertexPointer(4, GL_FLOAT, sizeof(GalaxyVertex), &v->position);
-    glTexCoordPointer(4, GL_SHORT, sizeof(GalaxyVertex), &v->texCoord);
-    glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, indices);
+    // Two triangles per blob; VertexObject draws plain arrays, and the
+    // buffer is built only once per shared form, so the duplicated
+    // corner vertices are cheaper than an extra index buffer path.
+    static const float corners[6][2] =
+    {
+        { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f },
+        { -1.0f, -1.0f }, { 1.0f,  1.0f }, { -1.0f, 1.0f },
+    };
+
+    vector<GalaxyVtx> galaxyVtx;
+    galaxyVtx.reserve(points->size() * 6);
+
+    int pow2 = 1;
+    float sizeFactor = 1.0f;
+    for (unsigned int i = 0; i < points->size(); ++i)
+    {
+        if ((i & pow2) != 0)
+        {
+            pow2 <<= 1;
+            sizeFactor *= spriteScaleFactor;
+        }
+
+        const Blob& b = (*points)[i];
+        GalaxyVtx vtx;
+        vtx.position[0] = b.position.x();
+        vtx.position[1] = b.position.y();
+        vtx.position[2] = b.position.z();
+        vtx.position[3] = sizeFactor;
+        vtx.texCoord[2] = (float) b.colorIndex;
+        vtx.texCoord[3] = b.brightness / 255.0f;
+        for (const auto& corner : corners)
+        {
+            vtx.texCoord[0] = corner[0];
+            vtx.texCoord[1] = corner[1];
+            galaxyVtx.push_back(vtx);
+        }
+    }
+
+    vo.allocate(galaxyVtx.size() * sizeof(GalaxyVtx), galaxyVtx.data());
+    vo.setVertices(4, GL_FLOAT, false, sizeof(GalaxyVtx), 0);
+    vo.setTextureCoords(4, GL_FLOAT, false, sizeof(GalaxyVtx), offsetof(GalaxyVtx, texCoord));
 }
 
 void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
@@ -328,8 +377,12 @@ void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
 
     if (galaxyTex == nullptr)
     {
-        galaxyTex = CreateProceduralTexture(width, height, GL_RGBA,
-                                            GalaxyTextureEval);
+        // Deep fields sample this sprite heavily minified, so build
+        // the mip chain by re-evaluating the analytic profile at each
+        // level rather than box-filtering the base image; anisotropic
+        // filtering is applied by the texture machinery when available.
+        galaxyTex = CreateProceduralMipMapTexture(width, height, GL_RGBA,
+                                                  GalaxyTextureEval);
     }
     assert(galaxyTex != nullptr);
     glActiveTexture(GL_TEXTURE0);
@@ -337,22 +390,18 @@ void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
 
     if (colorTex == nullptr)
     {
+        // One-dimensional lookup table, always sampled at full
+        // resolution: no mip chain needed.
         colorTex = CreateProceduralTexture(256, 1, GL_RGBA,
-                                           ColorTextureEval);
+                                           ColorTextureEval,
+                                           Texture::EdgeClamp,
+                                           Texture::NoMipMaps);
     }
     assert(colorTex != nullptr);
     glActiveTexture(GL_TEXTURE1);
     colorTex->bind();
 
     Matrix3f viewMat = viewerOrientation.conjugate().toRotationMatrix();
-    Vector4f v0(Vector4f::Zero());
-    Vector4f v1(Vector4f::Zero());
-    Vector4f v2(Vector4f::Zero());
-    Vector4f v3(Vector4f::Zero());
-    v0.head(3) = viewMat * Vector3f(-1, -1, 0) * size;
-    v1.head(3) = viewMat * Vector3f( 1, -1, 0) * size;
-    v2.head(3) = viewMat * Vector3f( 1,  1, 0) * size;
-    v3.head(3) = viewMat * Vector3f(-1,  1, 0) * size;
 
     Quaternionf orientation = getOrientation().conjugate();
     Matrix3f mScale = form->scale.asDiagonal() * size;
@@ -362,8 +411,6 @@ void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
     m.topLeftCorner(3,3) = mLinear;
     m.block<3,1>(0, 3) = offset;
 
-    int pow2 = 1;
-
     BlobVector* points = form->blobs;
     unsigned int nPoints = (unsigned int) (points->size() * clamp(getDetail()));
     // corrections to avoid excessive brightening if viewed e.g. edge-on
@@ -386,86 +433,49 @@ void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
             brightness_corr = 0.45f;
     }
 
+    /* The blobs are ordered so that sprite sizes fall by
+       spriteScaleFactor at every power-of-two index; points whose
+       bucket drops under the minimum feature size contribute nothing,
+       so the draw can stop at that bucket boundary instead of testing
+       every point. */
+    unsigned int visiblePoints = nPoints;
+    {
+        float s = size;
+        unsigned int bucketEnd = 1;
+        while (bucketEnd < nPoints)
+        {
+            s *= spriteScaleFactor;
+            if (s < minimumFeatureSize)
+            {
+                visiblePoints = bucketEnd;
+                break;
+            }
+            bucketEnd <<= 1;
+        }
+    }
+
     glPushMatrix();
     glTranslatef(-offset.x(), -offset.y(), -offset.z());
 
     const float btot = ((type > SBc) && (type < Irr)) ? 2.5f : 5.0f;
-    const float spriteScaleFactor = 1.0f / 1.55f;
-
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-    vector<GalaxyVertex, aligned_allocator<GalaxyVertex>> vertices;
-    vertices.reserve(4096 / sizeof(GalaxyVertex));
-    vector<short> indices;
-    indices.reserve(4096 / sizeof(GalaxyVertex) / 4 * 6); // 6 indices per 4 vertices
-    unsigned short j = 0;
 
     prog->use();
     prog->samplerParam("galaxyTex") = 0;
     prog->samplerParam("colorTex") = 1;
+    prog->mat4Param("m") = m;
+    prog->vec3Param("viewU") = viewMat * Vector3f(size, 0.0f, 0.0f);
+    prog->vec3Param("viewV") = viewMat * Vector3f(0.0f, size, 0.0f);
+    prog->floatParam("size0") = size;
+    prog->floatParam("brightnessScale") =
+        (4.0f * lightGain + 1.0f) * btot * brightness_corr * brightness;
 
-    for (unsigned int i = 0; i < nPoints; ++i)
-    {
-        if ((i & pow2) != 0)
-        {
-            pow2 <<= 1;
-            size *= spriteScaleFactor;
-            v0 *= spriteScaleFactor;
-            v1 *= spriteScaleFactor;
-            v2 *= spriteScaleFactor;
-            v3 *= spriteScaleFactor;
-            if (size < minimumFeatureSize)
-                break;
-        }
-
-        const Blob& b  = (*points)[i];
-        Vector4f    p  = m * b.position;
-        float       br = b.brightness / 255.0f;
-
-        float screenFrac = size / p.norm();
-        if (screenFrac < 0.1f)
-        {
-            float a = (4.0f * lightGain + 1.0f) * btot * (0.1f - screenFrac) * brightness_corr * brightness * br;
-            short alpha = (short) (a * 65535.99f);
-            short color = (short)b.colorIndex;
-            GalaxyVertex vtx;
-            vtx.position = p + v0;
-            vtx.texCoord = { 0, 0, color, alpha };
-            vertices.push_back(vtx);
-            vtx.position = p + v1;
-            vtx.texCoord = { 1, 0, color, alpha  };
-            vertices.push_back(vtx);
-            vtx.position = p + v2;
-            vtx.texCoord = { 1, 1, color, alpha  };
-            vertices.push_back(vtx);
-            vtx.position = p + v3;
-            vtx.texCoord = { 0, 1, color, alpha  };
-            vertices.push_back(vtx);
-
-            indices.push_back(j+0);
-            indices.push_back(j+1);
-            indices.push_back(j+2);
-            indices.push_back(j+0);
-            indices.push_back(j+2);
-            indices.push_back(j+3);
-            j += 4;
-
-            if ((vertices.size() + 4) * sizeof(GalaxyVertex) > 4096)
-            {
-                draw(&vertices[0], indices.size(), indices.data());
-                vertices.clear();
-                indices.clear();
-                j = 0;
-            }
-        }
-    }
+    form->vo.bind();
+    if (!form->vo.initialized())
+        initGalaxyData(form->vo, points);
 
-    if (indices.size() > 0)
-        draw(&vertices[0], indices.size(), indices.data());
+    form->vo.draw(GL_TRIANGLES, (GLsizei) visiblePoints * 6);
 
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    form->vo.unbind();
     glUseProgram(0);
     glPopMatrix();
     glActiveTexture(GL_TEXTURE0);
@@ -213,6 +213,27 @@ static void initVO(VertexObject& vo)
     vo.setVertices(2, GL_FLOAT, false, 0, 0);
 }
 
+// Bind the marker vertex object once for a run of symbol draws; while
+// the batch is active, renderMarker and renderCrosshair only update
+// uniforms and issue draws, which keeps annotation-heavy frames from
+// rebinding the same buffer for every marker.
+void Renderer::beginMarkerBatch()
+{
+    markerVO.bind();
+    if (!markerVO.initialized())
+        initVO(markerVO);
+    markerBatchActive = true;
+}
+
+
+void Renderer::endMarkerBatch()
+{
+    markerBatchActive = false;
+    glUseProgram(0);
+    markerVO.unbind();
+}
+
+
 void Renderer::renderMarker(MarkerRepresentation::Symbol symbol, float size, const Color& color)
 {
     assert(shaderManager != nullptr);
@@ -220,9 +241,12 @@ void Renderer::renderMarker(MarkerRepresentation::Symbol symbol, float size, con
     if (prog == nullptr)
         return;
 
-    markerVO.bind();
-    if (!markerVO.initialized())
-        initVO(markerVO);
+    if (!markerBatchActive)
+    {
+        markerVO.bind();
+        if (!markerVO.initialized())
+            initVO(markerVO);
+    }
 
     float s = size / 2.0f;
     prog->use();
@@ -289,8 +313,11 @@ void Renderer::renderMarker(MarkerRepresentation::Symbol symbol, float size, con
         break;
     }
 
-    glUseProgram(0);
-    markerVO.unbind();
+    if (!markerBatchActive)
+    {
+        glUseProgram(0);
+        markerVO.unbind();
+    }
 }
 
 /*! Draw an arrow at the view border pointing to an offscreen selection. This method
@@ -405,9 +432,12 @@ void Renderer::renderCrosshair(float selectionSizeInPixels, double tsec, const C
     if (prog == nullptr)
         return;
 
-    markerVO.bind();
-    if (!markerVO.initialized())
-        initVO(markerVO);
+    if (!markerBatchActive)
+    {
+        markerVO.bind();
+        if (!markerVO.initialized())
+            initVO(markerVO);
+    }
 
     const float cursorMinRadius = 6.0f;
     const float cursorRadiusVariability = 4.0f;
@@ -434,6 +464,10 @@ void Renderer::renderCrosshair(float selectionSizeInPixels, double tsec, const C
         prog->floatParam("angle") = theta;
         markerVO.draw(GL_TRIANGLES, CrosshairCount, CrosshairOffset);
     }
-    glUseProgram(0);
-    markerVO.unbind();
+
+    if (!markerBatchActive)
+    {
+        glUseProgram(0);
+        markerVO.unbind();
+    }
 }
@@ -450,17 +450,20 @@ void Globular::renderGlobularPointSprites(
     RRatio = pow(10.0f, CBin);
     XI = 1.0f / sqrt(1.0f + RRatio * RRatio);
 
+    // Like the point-star sprites, these profiles are analytic, so the
+    // mip chain is evaluated per level instead of downsampled; distant
+    // globulars then minify as cleanly as the star renderer's discs.
     if(centerTex[ic] == nullptr)
     {
-        centerTex[ic] = CreateProceduralTexture(cntrTexWidth, cntrTexHeight, GL_RGBA,
-                                                CenterCloudTexEval);
+        centerTex[ic] = CreateProceduralMipMapTexture(cntrTexWidth, cntrTexHeight, GL_RGBA,
+                                                      CenterCloudTexEval);
     }
     assert(centerTex[ic] != nullptr);
 
     if (globularTex == nullptr)
     {
-        globularTex = CreateProceduralTexture(starTexWidth, starTexHeight, GL_RGBA,
-                                              GlobularTextureEval);
+        globularTex = CreateProceduralMipMapTexture(starTexWidth, starTexHeight, GL_RGBA,
+                                                    GlobularTextureEval);
     }
     assert(globularTex != nullptr);
 
@@ -476,12 +479,12 @@ void Globular::renderGlobularPointSprites(
      * distance from center or resolution increases sufficiently.
      */
 
-    vo.bind();
-    if (!vo.initialized())
+    form->vo.bind();
+    if (!form->vo.initialized())
     {
         auto i = globProg->attribIndex("starSize");
         auto j = globProg->attribIndex("eta");
-        initGlobularData(vo, form->gblobs, i, j);
+        initGlobularData(form->vo, form->gblobs, i, j);
     }
 
     tidalProg->use();
@@ -493,7 +496,7 @@ void Globular::renderGlobularPointSprites(
     tidalProg->mat3Param("viewMat")     = viewMat;
     tidalProg->samplerParam("tidalTex") = 0;
 
-    vo.draw(GL_TRIANGLE_FAN, 4);
+    form->vo.draw(GL_TRIANGLE_FAN, 4);
 
     /*! Next, render globular cluster via distinct "star" sprites (globularTex)
      * for sufficiently large resolution and distance from center of globular.
@@ -517,10 +520,10 @@ void Globular::renderGlobularPointSprites(
     globProg->floatParam("RRatio")      = RRatio;
     globProg->samplerParam("starTex")   = 0;
 
-    vo.draw(GL_POINTS, count, 4);
+    form->vo.draw(GL_POINTS, count, 4);
 
     glUseProgram(0);
-    vo.unbind();
+    form->vo.unbind();
     glDisable(GL_POINT_SPRITE);
     glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
     // These should be called but stars are broken then
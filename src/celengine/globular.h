@@ -31,6 +31,12 @@ struct GlobularForm
 {
     std::vector<GBlob>* gblobs;
     Eigen::Vector3f scale;
+
+    // Static sprite geometry, uploaded once on first use. Forms are
+    // shared by every globular in the same concentration bin, so one
+    // buffer serves all of them; per-globular variation (transform,
+    // brightness, concentration) goes in as uniforms.
+    celgl::VertexObject vo{ GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW };
 };
 
 class Globular : public DeepSkyObject
@@ -91,8 +97,6 @@ class Globular : public DeepSkyObject
     float         r_c{ R_c_ref };
     float         c{ C_ref };
     float         tidalRadius{ 0.0f };
-
-    celgl::VertexObject vo{ GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW };
 };
 
 #endif // _GLOBULAR_H_
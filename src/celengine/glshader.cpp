@@ -9,6 +9,7 @@
 
 #include <iostream>
 #include "glshader.h"
+#include "glstats.h"
 #include <GL/glew.h>
 
 using namespace std;
@@ -19,6 +20,22 @@ static const string GetInfoLog(GLuint obj);
 
 ostream* g_shaderLogFile = nullptr;
 
+static bool deferStatusChecks = false;
+
+
+void
+GLShaderLoader::setDeferredStatusChecks(bool enable)
+{
+    deferStatusChecks = enable;
+}
+
+
+bool
+GLShaderLoader::deferredStatusChecks()
+{
+    return deferStatusChecks;
+}
+
 
 GLShader::GLShader(GLuint _id) :
     id(_id)
@@ -51,6 +68,10 @@ GLShader::compile(const vector<string>& source)
     // Actually compile the shader
     glCompileShader(id);
 
+    // Querying the status would block until the driver finishes
+    if (deferStatusChecks)
+        return ShaderStatus_OK;
+
     GLint compileSuccess;
     glGetShaderiv(id, GL_COMPILE_STATUS, &compileSuccess);
     if (compileSuccess != GL_TRUE)
@@ -82,8 +103,12 @@ FloatShaderParameter::FloatShaderParameter(GLuint obj, const char* name)
 FloatShaderParameter&
 FloatShaderParameter::operator=(float f)
 {
-    if (slot != -1)
+    if (slot != -1 && !(cached && f == lastValue))
+    {
         glUniform1f(slot, f);
+        lastValue = f;
+        cached = true;
+    }
     return *this;
 }
 
@@ -101,8 +126,12 @@ Vec3ShaderParameter::Vec3ShaderParameter(GLuint obj, const char* name)
 Vec3ShaderParameter&
 Vec3ShaderParameter::operator=(const Eigen::Vector3f& v)
 {
-    if (slot != -1)
+    if (slot != -1 && !(cached && v == lastValue))
+    {
         glUniform3fv(slot, 1, v.data());
+        lastValue = v;
+        cached = true;
+    }
     return *this;
 }
 
@@ -119,8 +148,12 @@ Vec4ShaderParameter::Vec4ShaderParameter(GLuint obj, const char* name)
 Vec4ShaderParameter&
 Vec4ShaderParameter::operator=(const Eigen::Vector4f& v)
 {
-    if (slot != -1)
+    if (slot != -1 && !(cached && v == lastValue))
+    {
         glUniform4fv(slot, 1, v.data());
+        lastValue = v;
+        cached = true;
+    }
     return *this;
 }
 
@@ -138,8 +171,12 @@ IntegerShaderParameter::IntegerShaderParameter(GLuint obj, const char* name)
 IntegerShaderParameter&
 IntegerShaderParameter::operator=(int i)
 {
-    if (slot != -1)
+    if (slot != -1 && !(cached && i == lastValue))
+    {
         glUniform1i(slot, i);
+        lastValue = i;
+        cached = true;
+    }
     return *this;
 }
 
@@ -157,8 +194,12 @@ Mat3ShaderParameter::Mat3ShaderParameter(GLuint obj, const char* name)
 Mat3ShaderParameter&
 Mat3ShaderParameter::operator=(const Eigen::Matrix3f& v)
 {
-    if (slot != -1)
+    if (slot != -1 && !(cached && v == lastValue))
+    {
         glUniformMatrix3fv(slot, 1, GL_FALSE, v.data());
+        lastValue = v;
+        cached = true;
+    }
     return *this;
 }
 
@@ -176,8 +217,12 @@ Mat4ShaderParameter::Mat4ShaderParameter(GLuint obj, const char* name)
 Mat4ShaderParameter&
 Mat4ShaderParameter::operator=(const Eigen::Matrix4f& v)
 {
-    if (slot != -1)
+    if (slot != -1 && !(cached && v == lastValue))
+    {
         glUniformMatrix4fv(slot, 1, GL_FALSE, v.data());
+        lastValue = v;
+        cached = true;
+    }
     return *this;
 }
 
@@ -200,6 +245,7 @@ void
 GLProgram::use() const
 {
     glUseProgram(id);
+    GLStats::addProgramChange();
 }
 
 
@@ -215,6 +261,10 @@ GLProgram::link()
 {
     glLinkProgram(id);
 
+    // Querying the status would block until the driver finishes
+    if (GLShaderLoader::deferredStatusChecks())
+        return ShaderStatus_OK;
+
     GLint linkSuccess;
     glGetProgramiv(id, GL_LINK_STATUS, &linkSuccess);
     if (linkSuccess != GL_TRUE)
@@ -375,6 +425,32 @@ GLShaderLoader::CreateProgram(const string& vsSource,
 }
 
 
+GLShaderStatus
+GLShaderLoader::CreateProgramFromBinary(unsigned int binaryFormat,
+                                        const void* binary,
+                                        int binaryLength,
+                                        GLProgram** progOut)
+{
+    GLuint progid = glCreateProgram();
+    if (progid == 0)
+        return ShaderStatus_LinkError;
+
+    glProgramBinary(progid, (GLenum) binaryFormat, binary, (GLsizei) binaryLength);
+
+    GLint linkSuccess = 0;
+    glGetProgramiv(progid, GL_LINK_STATUS, &linkSuccess);
+    if (linkSuccess != GL_TRUE)
+    {
+        glDeleteProgram(progid);
+        return ShaderStatus_LinkError;
+    }
+
+    *progOut = new GLProgram(progid);
+
+    return ShaderStatus_OK;
+}
+
+
 const string
 GetInfoLog(GLuint obj)
 {
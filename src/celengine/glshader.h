@@ -85,6 +85,9 @@ class GLProgram
 };
 
 
+// Each parameter object remembers the last value written and skips the
+// glUniform call when it is unchanged. Uniforms are per-program state in
+// GL, so the cached value stays valid across frames.
 class FloatShaderParameter
 {
  public:
@@ -95,6 +98,8 @@ class FloatShaderParameter
 
  private:
     int slot;
+    float lastValue{ 0.0f };
+    bool cached{ false };
 };
 
 
@@ -108,6 +113,8 @@ class Vec3ShaderParameter
 
  private:
     int slot;
+    Eigen::Matrix<float, 3, 1, Eigen::DontAlign> lastValue;
+    bool cached{ false };
 };
 
 
@@ -121,6 +128,8 @@ class Vec4ShaderParameter
 
  private:
     int slot;
+    Eigen::Matrix<float, 4, 1, Eigen::DontAlign> lastValue;
+    bool cached{ false };
 };
 
 
@@ -134,6 +143,8 @@ class IntegerShaderParameter
 
  private:
     int slot;
+    int lastValue{ 0 };
+    bool cached{ false };
 };
 
 
@@ -147,6 +158,8 @@ class Mat3ShaderParameter
 
  private:
     int slot;
+    Eigen::Matrix<float, 3, 3, Eigen::DontAlign> lastValue;
+    bool cached{ false };
 };
 
 
@@ -160,6 +173,8 @@ class Mat4ShaderParameter
 
  private:
     int slot;
+    Eigen::Matrix<float, 4, 4, Eigen::DontAlign> lastValue;
+    bool cached{ false };
 };
 
 
@@ -184,6 +199,23 @@ class GLShaderLoader
     static GLShaderStatus CreateProgram(const std::string& vsSource,
                                         const std::string& fsSource,
                                         GLProgram**);
+
+    /*! Create a program from a binary previously retrieved with
+     *  glGetProgramBinary. Fails with a link error if the driver
+     *  rejects the binary, e.g. after a driver update.
+     */
+    static GLShaderStatus CreateProgramFromBinary(unsigned int binaryFormat,
+                                                  const void* binary,
+                                                  int binaryLength,
+                                                  GLProgram**);
+
+    /*! While enabled, compile and link status queries are skipped, so
+     *  the calls return without waiting for the driver to finish. Used
+     *  with GL_KHR_parallel_shader_compile; the caller must check the
+     *  link status itself once compilation completes.
+     */
+    static void setDeferredStatusChecks(bool enable);
+    static bool deferredStatusChecks();
 };
 
 
@@ -0,0 +1,99 @@
+// glstats.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Per-frame counters for GL driver traffic.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <cstdlib>
+#include <fstream>
+
+#include <celutil/debug.h>
+#include "glstats.h"
+
+using namespace std;
+
+
+GLStats::Counters GLStats::current;
+GLStats::Counters GLStats::last;
+
+namespace
+{
+
+ofstream* csvOut = nullptr;
+unsigned long long csvFrame = 0;
+
+} // end unnamed namespace
+
+
+void GLStats::endFrame(uintmax_t textureBytes, uintmax_t geometryBytes)
+{
+    last = current;
+    current = Counters();
+
+    if (csvOut == nullptr)
+        return;
+
+    *csvOut << csvFrame << ','
+            << last.drawCalls << ','
+            << last.programChanges << ','
+            << last.textureBinds << ','
+            << last.bufferUploads << ','
+            << last.bufferUploadBytes << ','
+            << last.textureUploads << ','
+            << last.textureUploadBytes << ','
+            << textureBytes << ','
+            << geometryBytes << '\n';
+    csvFrame++;
+}
+
+
+bool GLStats::startCsv(const fs::path& path)
+{
+    if (csvOut != nullptr)
+        return false;
+
+    ofstream* out = new ofstream(path.string(), ios::out | ios::trunc);
+    if (!out->good())
+    {
+        delete out;
+        return false;
+    }
+
+    *out << "frame,drawCalls,programChanges,textureBinds,"
+            "bufferUploads,bufferUploadBytes,"
+            "textureUploads,textureUploadBytes,"
+            "textureResidentBytes,geometryResidentBytes\n";
+    csvOut = out;
+    csvFrame = 0;
+    return true;
+}
+
+
+void GLStats::stopCsv()
+{
+    delete csvOut;
+    csvOut = nullptr;
+}
+
+
+bool GLStats::csvActive()
+{
+    return csvOut != nullptr;
+}
+
+
+void GLStats::startCsvFromEnvironment()
+{
+    const char* filename = getenv("CELESTIA_GLSTATS_CSV");
+    if (filename == nullptr || *filename == '\0')
+        return;
+
+    if (!startCsv(filename))
+        DPRINTF(LOG_LEVEL_ERROR,
+                "Cannot write GL statistics CSV %s\n", filename);
+}
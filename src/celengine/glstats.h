@@ -0,0 +1,97 @@
+// glstats.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Per-frame counters for GL driver traffic.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELENGINE_GLSTATS_H_
+#define _CELENGINE_GLSTATS_H_
+
+#include <cstdint>
+#include <celcompat/filesystem.h>
+
+/*! GLStats counts the driver traffic issued through the GL wrapper
+ *  paths -- draw calls and buffer uploads from VertexObject, program
+ *  changes from GLProgram, texture binds and uploads from Texture. It
+ *  is always on: each count is a single integer increment on the
+ *  render thread. endFrame() snapshots the counters for the HUD and
+ *  resets them, and while CSV capture is active appends one row per
+ *  frame, so projector capacity planning can be scripted instead of
+ *  relying on vendor tools.
+ */
+class GLStats
+{
+ public:
+    struct Counters
+    {
+        unsigned int drawCalls{ 0 };
+        unsigned int programChanges{ 0 };
+        unsigned int textureBinds{ 0 };
+        unsigned int bufferUploads{ 0 };
+        std::uintmax_t bufferUploadBytes{ 0 };
+        unsigned int textureUploads{ 0 };
+        std::uintmax_t textureUploadBytes{ 0 };
+    };
+
+    static void addDrawCall()
+    {
+        current.drawCalls++;
+    }
+
+    static void addProgramChange()
+    {
+        current.programChanges++;
+    }
+
+    static void addTextureBind()
+    {
+        current.textureBinds++;
+    }
+
+    static void addBufferUpload(std::uintmax_t bytes)
+    {
+        current.bufferUploads++;
+        current.bufferUploadBytes += bytes;
+    }
+
+    static void addTextureUpload(std::uintmax_t bytes)
+    {
+        current.textureUploads++;
+        current.textureUploadBytes += bytes;
+    }
+
+    //! Close out the frame: the counters collected since the last
+    //! call become lastFrame() and are reset. The VRAM estimates are
+    //! the texture and geometry managers' resident bytes, passed in
+    //! by the caller so this layer needs no knowledge of the resource
+    //! managers.
+    static void endFrame(std::uintmax_t textureBytes,
+                         std::uintmax_t geometryBytes);
+
+    static const Counters& lastFrame()
+    {
+        return last;
+    }
+
+    //! Start appending one CSV row per frame to the named file.
+    //! Returns false if the file cannot be opened or capture is
+    //! already active.
+    static bool startCsv(const fs::path& path);
+    static void stopCsv();
+    static bool csvActive();
+
+    //! Start CSV capture if the CELESTIA_GLSTATS_CSV environment
+    //! variable names an output file, mirroring CELESTIA_TRACE_FILE.
+    static void startCsvFromEnvironment();
+
+ private:
+    static Counters current;
+    static Counters last;
+};
+
+#endif // _CELENGINE_GLSTATS_H_
@@ -14,7 +14,16 @@
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <thread>
+#include <vector>
+#include <celutil/memmap.h>
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(_M_AMD64) || defined(_M_X64)
+#define IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 extern "C" {
 #include <jpeglib.h>
@@ -108,9 +117,32 @@ Image::Image(int fmt, int w, int h, int mip) :
 }
 
 
+Image::Image(int fmt, int w, int h, int mip,
+             MemoryMappedFile* mapping, unsigned char* data) :
+    width(w),
+    height(h),
+    mipLevels(mip),
+    format(fmt),
+    ownPixels(false),
+    mappedFile(mapping)
+{
+    components = formatComponents(fmt);
+    assert(components != 0);
+
+    pitch = pad(w * components);
+
+    size = 1;
+    for (int i = 0; i < mipLevels; i++)
+        size += calcMipLevelSize(fmt, w, h, i);
+    pixels = data;
+}
+
+
 Image::~Image()
 {
-    delete[] pixels;
+    if (ownPixels)
+        delete[] pixels;
+    delete mappedFile;
 }
 
 
@@ -236,6 +268,143 @@ bool Image::hasAlpha() const
 }
 
 
+// Compute one normal map texel from height differences between adjacent
+// source texels.
+static inline void NormalMapTexel(const unsigned char* pixels,
+                                  unsigned char* nmPixels,
+                                  int i, int j,
+                                  int width, int height,
+                                  int pitch, int nmPitch,
+                                  int components,
+                                  float scale, bool wrap)
+{
+    int i0 = i;
+    int j0 = j;
+    int i1 = i - 1;
+    int j1 = j - 1;
+    if (i1 < 0)
+    {
+        if (wrap)
+        {
+            i1 = height - 1;
+        }
+        else
+        {
+            i0++;
+            i1++;
+        }
+    }
+    if (j1 < 0)
+    {
+        if (wrap)
+        {
+            j1 = width - 1;
+        }
+        else
+        {
+            j0++;
+            j1++;
+        }
+    }
+
+    auto h00 = (int) pixels[i0 * pitch + j0 * components];
+    auto h10 = (int) pixels[i0 * pitch + j1 * components];
+    auto h01 = (int) pixels[i1 * pitch + j0 * components];
+
+    float dx = (float) (h10 - h00) * (1.0f / 255.0f) * scale;
+    float dy = (float) (h01 - h00) * (1.0f / 255.0f) * scale;
+
+    auto mag = (float) sqrt(dx * dx + dy * dy + 1.0f);
+    float rmag = 1.0f / mag;
+
+    int n = i * nmPitch + j * 4;
+    nmPixels[n]     = (unsigned char) (128 + 127 * dx * rmag);
+    nmPixels[n + 1] = (unsigned char) (128 + 127 * dy * rmag);
+    nmPixels[n + 2] = (unsigned char) (128 + 127 * rmag);
+    nmPixels[n + 3] = 255;
+}
+
+
+// Compute normal map rows [ rowBegin, rowEnd ).  Rows only read from the
+// source image, so disjoint ranges may be processed concurrently.
+static void NormalMapRows(const unsigned char* pixels,
+                          unsigned char* nmPixels,
+                          int rowBegin, int rowEnd,
+                          int width, int height,
+                          int pitch, int nmPitch,
+                          int components,
+                          float scale, bool wrap)
+{
+#ifdef IMAGE_SSE2
+    __m128 invScale = _mm_set1_ps((1.0f / 255.0f) * scale);
+    __m128 one      = _mm_set1_ps(1.0f);
+    __m128 half127  = _mm_set1_ps(127.0f);
+    __m128 bias128  = _mm_set1_ps(128.0f);
+    __m128i alpha   = _mm_set1_epi32(255 << 24);
+    __m128i zero    = _mm_setzero_si128();
+#endif
+
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        int j = 0;
+
+#ifdef IMAGE_SSE2
+        // Away from the left edge both height taps come from contiguous
+        // bytes, so four texels can be differenced at once.  Only single
+        // channel input qualifies; multichannel images keep the scalar
+        // path since the taps are strided.
+        if (components == 1 && width > 8)
+        {
+            int i1 = (i > 0) ? i - 1 : (wrap ? height - 1 : 0);
+            const unsigned char* row  = pixels + i * pitch;
+            const unsigned char* rowU = pixels + i1 * pitch;
+            unsigned char* nmRow = nmPixels + i * nmPitch;
+
+            // Column 0 wraps (or clamps); handle it scalar below
+            for (j = 1; j + 4 <= width; j += 4)
+            {
+                int b00, b10, b01;
+                memcpy(&b00, row + j, 4);
+                memcpy(&b10, row + j - 1, 4);
+                memcpy(&b01, rowU + j, 4);
+
+                __m128i v00 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(b00), zero), zero);
+                __m128i v10 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(b10), zero), zero);
+                __m128i v01 = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(b01), zero), zero);
+
+                __m128 dx = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(v10, v00)), invScale);
+                __m128 dy = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(v01, v00)), invScale);
+
+                __m128 rmag = _mm_div_ps(one,
+                                         _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx),
+                                                                           _mm_mul_ps(dy, dy)),
+                                                                one)));
+
+                // Bias in float before truncating, matching the scalar
+                // (unsigned char) (128 + 127 * n) conversion
+                __m128i nx = _mm_cvttps_epi32(_mm_add_ps(bias128, _mm_mul_ps(half127, _mm_mul_ps(dx, rmag))));
+                __m128i ny = _mm_cvttps_epi32(_mm_add_ps(bias128, _mm_mul_ps(half127, _mm_mul_ps(dy, rmag))));
+                __m128i nz = _mm_cvttps_epi32(_mm_add_ps(bias128, _mm_mul_ps(half127, rmag)));
+
+                __m128i rgba = _mm_or_si128(_mm_or_si128(nx, _mm_slli_epi32(ny, 8)),
+                                            _mm_or_si128(_mm_slli_epi32(nz, 16), alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(nmRow + j * 4), rgba);
+            }
+
+            NormalMapTexel(pixels, nmPixels, i, 0, width, height,
+                           pitch, nmPitch, components, scale, wrap);
+        }
+#endif
+
+        for (; j < width; j++)
+        {
+            NormalMapTexel(pixels, nmPixels, i, j, width, height,
+                           pitch, nmPitch, components, scale, wrap);
+        }
+    }
+}
+
+
 // Convert an input height map to a normal map.  Ideally, a single channel
 // input should be used.  If not, the first color channel of the input image
 // is the one only one used when generating normals.  This produces the
@@ -252,56 +421,34 @@ Image* Image::computeNormalMap(float scale, bool wrap) const
     unsigned char* nmPixels = normalMap->getPixels();
     int nmPitch = normalMap->getPitch();
 
-    // Compute normals using differences between adjacent texels.
-    for (int i = 0; i < height; i++)
+    // Compute normals using differences between adjacent texels.  Each
+    // output row depends only on the source image, so large maps are
+    // split into row ranges and converted in parallel.
+    unsigned int nTasks = 1;
+    if (height >= 1024)
+        nTasks = max(1u, min(thread::hardware_concurrency(),
+                             (unsigned int) (height / 256)));
+
+    if (nTasks <= 1)
+    {
+        NormalMapRows(pixels, nmPixels, 0, height, width, height,
+                      pitch, nmPitch, components, scale, wrap);
+    }
+    else
     {
-        for (int j = 0; j < width; j++)
+        vector<future<void>> tasks;
+        int rowsPerTask = (height + (int) nTasks - 1) / (int) nTasks;
+        for (int row = 0; row < height; row += rowsPerTask)
         {
-            int i0 = i;
-            int j0 = j;
-            int i1 = i - 1;
-            int j1 = j - 1;
-            if (i1 < 0)
-            {
-                if (wrap)
-                {
-                    i1 = height - 1;
-                }
-                else
-                {
-                    i0++;
-                    i1++;
-                }
-            }
-            if (j1 < 0)
-            {
-                if (wrap)
-                {
-                    j1 = width - 1;
-                }
-                else
-                {
-                    j0++;
-                    j1++;
-                }
-            }
-
-            auto h00 = (int) pixels[i0 * pitch + j0 * components];
-            auto h10 = (int) pixels[i0 * pitch + j1 * components];
-            auto h01 = (int) pixels[i1 * pitch + j0 * components];
-
-            float dx = (float) (h10 - h00) * (1.0f / 255.0f) * scale;
-            float dy = (float) (h01 - h00) * (1.0f / 255.0f) * scale;
-
-            auto mag = (float) sqrt(dx * dx + dy * dy + 1.0f);
-            float rmag = 1.0f / mag;
-
-            int n = i * nmPitch + j * 4;
-            nmPixels[n]     = (unsigned char) (128 + 127 * dx * rmag);
-            nmPixels[n + 1] = (unsigned char) (128 + 127 * dy * rmag);
-            nmPixels[n + 2] = (unsigned char) (128 + 127 * rmag);
-            nmPixels[n + 3] = 255;
+            int rowEnd = min(row + rowsPerTask, height);
+            tasks.push_back(async(launch::async,
+                                  NormalMapRows,
+                                  pixels, nmPixels, row, rowEnd,
+                                  width, height, pitch, nmPitch,
+                                  components, scale, wrap));
         }
+        for (auto& task : tasks)
+            task.wait();
     }
 
     return normalMap;
@@ -364,6 +511,11 @@ METHODDEF(void) my_error_exit(j_common_ptr cinfo)
 }
 
 
+// Cap on the decoded size of a JPEG image; anything larger is reduced
+// while it is decompressed rather than materialized at full resolution.
+static const size_t MaxJPEGImageBytes = 256 * 1024 * 1024;
+
+
 Image* LoadJPEGImage(const fs::path& filename, int /*unused*/)
 {
     Image* img = nullptr;
@@ -426,8 +578,35 @@ Image* LoadJPEGImage(const fs::path& filename, int /*unused*/)
 
     // Step 4: set parameters for decompression
 
-    // In this example, we don't need to change any of the defaults set by
-    // jpeg_read_header(), so we do nothing here.
+    // Huge single-file surface maps (e.g. 64k x 32k) would need multi
+    // gigabyte decode buffers. Instead of materializing them, have
+    // libjpeg's DCT scaling shrink the image during decompression, and
+    // box filter scanline bands for any factor beyond the 1/8 the DCT
+    // path can provide; peak memory is then the reduced image plus one
+    // scanline.
+    auto fullBytes = (size_t) cinfo.image_width * cinfo.image_height *
+        cinfo.num_components;
+    unsigned int extraShrink = 1;
+    if (fullBytes > MaxJPEGImageBytes)
+    {
+        cinfo.scale_num = 1;
+        cinfo.scale_denom = 1;
+        while (cinfo.scale_denom < 8 &&
+               fullBytes / ((size_t) cinfo.scale_denom * cinfo.scale_denom) > MaxJPEGImageBytes)
+            cinfo.scale_denom *= 2;
+
+        while (true)
+        {
+            size_t factor = (size_t) cinfo.scale_denom * extraShrink;
+            if (fullBytes / (factor * factor) <= MaxJPEGImageBytes)
+                break;
+            extraShrink *= 2;
+        }
+
+        fmt::fprintf(clog, _("Reducing %ux%u JPEG image %ux during decode\n"),
+                     cinfo.image_width, cinfo.image_height,
+                     (unsigned int) cinfo.scale_denom * extraShrink);
+    }
 
     // Step 5: Start decompressor
 
@@ -456,21 +635,75 @@ Image* LoadJPEGImage(const fs::path& filename, int /*unused*/)
     if (cinfo.output_components == 1)
         format = GL_LUMINANCE;
 
-    img = new Image(format, cinfo.image_width, cinfo.image_height);
+    unsigned int outWidth = max(cinfo.output_width / extraShrink, 1u);
+    unsigned int outHeight = max(cinfo.output_height / extraShrink, 1u);
+    img = new Image(format, outWidth, outHeight);
 
-    // cont = cinfo.output_height - 1;
-    cont = 0;
-    while (cinfo.output_scanline < cinfo.output_height)
+    if (extraShrink == 1)
+    {
+        // cont = cinfo.output_height - 1;
+        cont = 0;
+        while (cinfo.output_scanline < cinfo.output_height)
+        {
+            // jpeg_read_scanlines expects an array of pointers to scanlines.
+            // Here the array is only one element long, but you could ask for
+            // more than one scanline at a time if that's more convenient.
+            (void) jpeg_read_scanlines(&cinfo, buffer, 1);
+
+            // Assume put_scanline_someplace wants a pointer and sample count.
+            // put_scanline_someplace(buffer[0], row_stride);
+            memcpy(img->getPixelRow(cont), buffer[0], row_stride);
+            cont++;
+        }
+    }
+    else
     {
-        // jpeg_read_scanlines expects an array of pointers to scanlines.
-        // Here the array is only one element long, but you could ask for
-        // more than one scanline at a time if that's more convenient.
-        (void) jpeg_read_scanlines(&cinfo, buffer, 1);
-
-        // Assume put_scanline_someplace wants a pointer and sample count.
-        // put_scanline_someplace(buffer[0], row_stride);
-        memcpy(img->getPixelRow(cont), buffer[0], row_stride);
-        cont++;
+        // Box filter extraShrink x extraShrink blocks of decoded
+        // scanlines into each output row; only one scanline is ever
+        // held in addition to the reduced image.
+        int components = cinfo.output_components;
+        vector<unsigned int> accum(outWidth * components);
+
+        for (unsigned int outRow = 0;
+             outRow < outHeight && cinfo.output_scanline < cinfo.output_height;
+             outRow++)
+        {
+            fill(accum.begin(), accum.end(), 0u);
+            unsigned int rowsInBand = 0;
+            while (rowsInBand < extraShrink &&
+                   cinfo.output_scanline < cinfo.output_height)
+            {
+                (void) jpeg_read_scanlines(&cinfo, buffer, 1);
+                const JSAMPLE* src = buffer[0];
+                for (unsigned int x = 0; x < outWidth; x++)
+                {
+                    unsigned int x0 = x * extraShrink;
+                    unsigned int x1 = min(x0 + extraShrink, (unsigned int) cinfo.output_width);
+                    for (unsigned int sx = x0; sx < x1; sx++)
+                    {
+                        for (int c = 0; c < components; c++)
+                            accum[x * components + c] += src[sx * components + c];
+                    }
+                }
+                rowsInBand++;
+            }
+
+            unsigned char* dst = img->getPixelRow(outRow);
+            for (unsigned int x = 0; x < outWidth; x++)
+            {
+                unsigned int x0 = x * extraShrink;
+                unsigned int x1 = min(x0 + extraShrink, (unsigned int) cinfo.output_width);
+                unsigned int n = rowsInBand * (x1 - x0);
+                for (int c = 0; c < components; c++)
+                    dst[x * components + c] =
+                        (unsigned char) ((accum[x * components + c] + n / 2) / n);
+            }
+        }
+
+        // Drain any leftover scanlines so jpeg_finish_decompress
+        // doesn't have to consume them itself
+        while (cinfo.output_scanline < cinfo.output_height)
+            (void) jpeg_read_scanlines(&cinfo, buffer, 1);
     }
 
     // Step 7: Finish decompression
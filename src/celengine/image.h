@@ -19,10 +19,21 @@
 // mipmap.)  Mip levels are addressed such that zero is the base (largest) mip
 // level.
 
+class MemoryMappedFile;
+
 class Image
 {
  public:
     Image(int fmt, int w, int h, int mip = 1);
+
+    /*! Construct an image whose pixel data lives inside a memory
+     *  mapped file instead of on the heap. The image takes ownership
+     *  of the mapping and releases it on destruction; the data must
+     *  follow the same layout the heap constructor would produce.
+     */
+    Image(int fmt, int w, int h, int mip,
+          MemoryMappedFile* mapping, unsigned char* data);
+
     ~Image();
 
     int getWidth() const;
@@ -57,6 +68,8 @@ class Image
     int format;
     int size;
     unsigned char* pixels{ nullptr };
+    bool ownPixels{ true };
+    MemoryMappedFile* mappedFile{ nullptr };
 };
 
 extern Image* LoadJPEGImage(const fs::path& filename,
@@ -64,6 +77,7 @@ extern Image* LoadJPEGImage(const fs::path& filename,
 extern Image* LoadBMPImage(const fs::path& filename);
 extern Image* LoadPNGImage(const fs::path& filename);
 extern Image* LoadDDSImage(const fs::path& filename);
+extern bool SaveDDSImage(const fs::path& filename, Image& img);
 
 extern Image* LoadImageFromFile(const fs::path& filename);
 
@@ -12,6 +12,10 @@
 #include <cassert>
 #include <iostream>
 #include <algorithm>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
 #include <celmath/mathlib.h>
 #include <GL/glew.h>
 #include "lodspheremesh.h"
@@ -90,6 +94,101 @@ static void InitTrigArrays()
 }
 
 
+// Shared GPU-resident tessellation caches. All spherical bodies render
+// through the single global LODSphereMesh, so a sphere section uploaded
+// once is reused by every body that needs the same region at the same
+// step. Sections whose texture coordinates depend on subtexture tiling
+// (virtual textures) can't be shared and keep using the streaming path.
+
+struct SphereSectionKey
+{
+    int phi0;
+    int theta0;
+    int extent;
+    int step;
+    bool tangents;
+    int nTextures;
+
+    bool operator<(const SphereSectionKey& other) const
+    {
+        return std::tie(phi0, theta0, extent, step, tangents, nTextures) <
+               std::tie(other.phi0, other.theta0, other.extent, other.step,
+                        other.tangents, other.nTextures);
+    }
+};
+
+struct CachedSectionBuffer
+{
+    GLuint buffer{ 0 };
+    unsigned int size{ 0 };
+    unsigned int lastUsed{ 0 };
+};
+
+// Budget for cached section vertex data; least recently used sections
+// are evicted when a new one doesn't fit.
+static const unsigned int SectionBufferCacheBudget = 16 * 1024 * 1024;
+
+static std::map<SphereSectionKey, CachedSectionBuffer> sectionBufferCache;
+static unsigned int sectionBufferCacheSize = 0;
+static unsigned int sectionCacheTick = 0;
+
+// Strip index buffers, keyed by (rings, slices). Index order only
+// depends on the section's ring and slice counts, so the handful of
+// combinations in use are built once and shared by all sections.
+static std::map<std::pair<int, int>, GLuint> sectionIndexCache;
+
+
+static GLuint GetSectionIndexBuffer(int nRings, int nSlices)
+{
+    auto key = std::make_pair(nRings, nSlices);
+    auto iter = sectionIndexCache.find(key);
+    if (iter != sectionIndexCache.end())
+        return iter->second;
+
+    std::vector<unsigned short> strip(nRings * (nSlices + 1) * 2);
+    int n2 = 0;
+    for (int i = 0; i < nRings; i++)
+    {
+        for (int j = 0; j <= nSlices; j++)
+        {
+            strip[n2 + 0] = i * (nSlices + 1) + j;
+            strip[n2 + 1] = (i + 1) * (nSlices + 1) + j;
+            n2 += 2;
+        }
+    }
+
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 strip.size() * sizeof(unsigned short),
+                 strip.data(),
+                 GL_STATIC_DRAW);
+
+    sectionIndexCache[key] = buffer;
+    return buffer;
+}
+
+
+static void EvictSectionBuffers(unsigned int bytesNeeded)
+{
+    while (sectionBufferCacheSize + bytesNeeded > SectionBufferCacheBudget &&
+           !sectionBufferCache.empty())
+    {
+        auto oldest = sectionBufferCache.begin();
+        for (auto iter = sectionBufferCache.begin(); iter != sectionBufferCache.end(); ++iter)
+        {
+            if (iter->second.lastUsed < oldest->second.lastUsed)
+                oldest = iter;
+        }
+
+        glDeleteBuffers(1, &oldest->second.buffer);
+        sectionBufferCacheSize -= oldest->second.size;
+        sectionBufferCache.erase(oldest);
+    }
+}
+
+
 static float getSphereLOD(float discSizeInPixels)
 {
     if (discSizeInPixels < 10)
@@ -278,8 +377,6 @@ void LODSphereMesh::render(unsigned int attributes,
             }
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-            glGenBuffers(1, &indexBuffer);
-
             useVertexBuffers = true;
 
             // HACK: delete the user arrays--we shouldn't need to allocate
@@ -295,28 +392,29 @@ void LODSphereMesh::render(unsigned int attributes,
         glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
     }
 
-    // Set up the mesh vertices
+    // Set up the mesh indices; every section rendered this frame uses
+    // the same ring and slice counts
     int nRings = phiExtent / ri.step;
     int nSlices = thetaExtent / ri.step;
 
-    int n2 = 0;
-    for (i = 0; i < nRings; i++)
+    if (useVertexBuffers)
     {
-        for (int j = 0; j <= nSlices; j++)
-        {
-            indices[n2 + 0] = i * (nSlices + 1) + j;
-            indices[n2 + 1] = (i + 1) * (nSlices + 1) + j;
-            n2 += 2;
-        }
+        sectionCacheTick++;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                     GetSectionIndexBuffer(nRings, nSlices));
     }
-
-    if (useVertexBuffers)
+    else
     {
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                             nIndices * sizeof(indices[0]),
-                             indices,
-                             GL_DYNAMIC_DRAW);
+        int n2 = 0;
+        for (i = 0; i < nRings; i++)
+        {
+            for (int j = 0; j <= nSlices; j++)
+            {
+                indices[n2 + 0] = i * (nSlices + 1) + j;
+                indices[n2 + 1] = (i + 1) * (nSlices + 1) + j;
+                n2 += 2;
+            }
+        }
     }
 
     // Compute the size of a vertex
@@ -378,6 +476,13 @@ void LODSphereMesh::render(unsigned int attributes,
                               frustum.plane(Frustum::Bottom),
                               frustum.plane(Frustum::Right));
 
+        // The side planes of a perspective frustum all pass through the
+        // eye; their intersection recovers the eye position in sphere
+        // coordinates, used for culling patches beyond the horizon.
+        ri.eyePos = intersect3(frustum.plane(Frustum::Left),
+                               frustum.plane(Frustum::Right),
+                               frustum.plane(Frustum::Top));
+
 
 #ifdef SHOW_PATCH_VISIBILITY
         {
@@ -598,6 +703,17 @@ int LODSphereMesh::renderPatches(int phi0, int theta0,
     if (outside)
         return 0;
 
+    // Horizon culling: from an eye at e outside the unit sphere, the
+    // visible cap is the set of points with p . e >= 1. Test the patch's
+    // bounding sphere against the horizon plane so the test remains
+    // conservative for curved patches.
+    float eyeDistance = ri.eyePos.norm();
+    if (eyeDistance > 1.0f &&
+        patchCenter.dot(ri.eyePos) + boundingRadius * eyeDistance < 1.0f)
+    {
+        return 0;
+    }
+
     if (level == 1)
     {
         renderSection(phi0, theta0, thetaExtent, ri);
@@ -635,63 +751,23 @@ void LODSphereMesh::renderSection(int phi0, int theta0, int extent,
     }
 #endif // SHOW_PATCH_VISIBILITY
 
-    auto stride = (GLsizei) (vertexSize * sizeof(float));
-    int texCoordOffset = ((ri.attributes & Tangents) != 0) ? 6 : 3;
-    float* vertexBase = useVertexBuffers ? (float*) nullptr : vertices;
-
-    glVertexPointer(3, GL_FLOAT, stride, vertexBase + 0);
-    if ((ri.attributes & Normals) != 0)
-        glNormalPointer(GL_FLOAT, stride, vertexBase);
-
-    for (int tc = 0; tc < nTexturesUsed; tc++)
-    {
-        if (nTexturesUsed > 1)
-            glClientActiveTexture(GL_TEXTURE0 + tc);
-        glTexCoordPointer(2, GL_FLOAT, stride,  vertexBase + (tc * 2) + texCoordOffset);
-    }
-
-    if ((ri.attributes & Tangents) != 0)
-    {
-        glVertexAttribPointer(CelestiaGLProgram::TangentAttributeIndex,
-                              3, GL_FLOAT, GL_FALSE,
-                              stride, vertexBase + 3); // 3 == tangentOffset
-    }
-
     // assert(ri.step >= minStep);
     // assert(phi0 + extent <= maxDivisions);
     // assert(theta0 + extent / 2 < maxDivisions);
     // assert(isPow2(extent));
     int thetaExtent = extent;
     int phiExtent = extent / 2;
-    int theta1 = theta0 + thetaExtent;
-    int phi1 = phi0 + phiExtent;
-    /*int n3 = 0;   Unused*/
-    /*int n2 = 0;   Unused*/
 
     float du[MAX_SPHERE_MESH_TEXTURES];
     float dv[MAX_SPHERE_MESH_TEXTURES];
     float u0[MAX_SPHERE_MESH_TEXTURES];
     float v0[MAX_SPHERE_MESH_TEXTURES];
 
-
-    if (useVertexBuffers)
-    {
-        // Calling glBufferData() with nullptr before mapping the buffer
-        // is a hint to OpenGL that previous contents of vertex buffer will
-        // be discarded and overwritten. It enables renaming in the driver,
-        // hopefully resulting in performance gains.
-        glBufferData(GL_ARRAY_BUFFER,
-                             maxVertices * vertexSize * sizeof(float),
-                             nullptr,
-                             GL_STREAM_DRAW);
-
-        vertices = reinterpret_cast<float*>(glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY));
-        if (vertices == nullptr)
-            return;
-    }
-
     // Set the current texture.  This is necessary because the texture
-    // may be split into subtextures.
+    // may be split into subtextures.  Track whether the texture
+    // coordinates depend on subtexture tiling; if they don't, the
+    // section's vertex data is static and can come from the shared cache.
+    bool staticMapping = true;
     for (int tex = 0; tex < nTexturesUsed; tex++)
     {
         du[tex] = (float) 1.0f / thetaDivisions;;
@@ -733,6 +809,13 @@ void LODSphereMesh::renderSection(int phi0, int theta0, int extent,
             u0[tex] = u0[tex] * tile.du + tile.u;
             v0[tex] = v0[tex] * tile.dv + tile.v;
 
+            if (uTexSplit != 1 || vTexSplit != 1 ||
+                tile.u != 0.0f || tile.v != 0.0f ||
+                tile.du != 1.0f || tile.dv != 1.0f)
+            {
+                staticMapping = false;
+            }
+
             // We track the current texture to avoid unnecessary and costly
             // texture state changes.
             if (tile.texID != subtextures[tex])
@@ -743,6 +826,154 @@ void LODSphereMesh::renderSection(int phi0, int theta0, int extent,
         }
     }
 
+    // TODO: Fix this--number of rings can reach zero and cause dropout
+    // int nRings = max(phiExtent / ri.step, 1); // buggy
+    int nRings = phiExtent / ri.step;
+    int nSlices = thetaExtent / ri.step;
+
+    if (useVertexBuffers && staticMapping)
+    {
+        SphereSectionKey key;
+        key.phi0 = phi0;
+        key.theta0 = theta0;
+        key.extent = extent;
+        key.step = ri.step;
+        key.tangents = (ri.attributes & Tangents) != 0;
+        key.nTextures = nTexturesUsed;
+
+        GLuint buffer = 0;
+        auto iter = sectionBufferCache.find(key);
+        if (iter != sectionBufferCache.end())
+        {
+            buffer = iter->second.buffer;
+            iter->second.lastUsed = sectionCacheTick;
+        }
+        else
+        {
+            auto size = (unsigned int) ((nRings + 1) * (nSlices + 1) * vertexSize * sizeof(float));
+            EvictSectionBuffers(size);
+
+            glGenBuffers(1, &buffer);
+            if (buffer != 0)
+            {
+                std::vector<float> data((nRings + 1) * (nSlices + 1) * vertexSize);
+                generateSectionVertices(data.data(), phi0, theta0, extent, ri, u0, v0, du, dv);
+
+                glBindBuffer(GL_ARRAY_BUFFER, buffer);
+                glBufferData(GL_ARRAY_BUFFER, size, data.data(), GL_STATIC_DRAW);
+
+                CachedSectionBuffer entry;
+                entry.buffer = buffer;
+                entry.size = size;
+                entry.lastUsed = sectionCacheTick;
+                sectionBufferCache[key] = entry;
+                sectionBufferCacheSize += size;
+            }
+        }
+
+        if (buffer != 0)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            setSectionPointers(ri, (float*) nullptr);
+
+            for (int i = 0; i < nRings; i++)
+            {
+                glDrawElements(GL_QUAD_STRIP,
+                               (nSlices + 1) * 2,
+                               GL_UNSIGNED_SHORT,
+                               (unsigned short*) nullptr + (nSlices + 1) * 2 * i);
+            }
+
+            // Restore the streaming buffer binding for any section that
+            // can't use the cache
+            glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
+            return;
+        }
+
+        // Buffer allocation failed; fall through to the streaming path
+    }
+
+    setSectionPointers(ri, useVertexBuffers ? (float*) nullptr : vertices);
+
+    if (useVertexBuffers)
+    {
+        // Calling glBufferData() with nullptr before mapping the buffer
+        // is a hint to OpenGL that previous contents of vertex buffer will
+        // be discarded and overwritten. It enables renaming in the driver,
+        // hopefully resulting in performance gains.
+        glBufferData(GL_ARRAY_BUFFER,
+                             maxVertices * vertexSize * sizeof(float),
+                             nullptr,
+                             GL_STREAM_DRAW);
+
+        vertices = reinterpret_cast<float*>(glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY));
+        if (vertices == nullptr)
+            return;
+    }
+
+    generateSectionVertices(vertices, phi0, theta0, extent, ri, u0, v0, du, dv);
+
+    if (useVertexBuffers)
+    {
+        vertices = nullptr;
+        if (!glUnmapBuffer(GL_ARRAY_BUFFER))
+            return;
+    }
+
+    unsigned short* indexBase = useVertexBuffers ? (unsigned short*) nullptr : indices;
+    for (int i = 0; i < nRings; i++)
+    {
+        glDrawElements(GL_QUAD_STRIP,
+                       (nSlices + 1) * 2,
+                       GL_UNSIGNED_SHORT,
+                       indexBase + (nSlices + 1) * 2 * i);
+    }
+
+    // Cycle through the vertex buffers
+    if (useVertexBuffers)
+    {
+        currentVB++;
+        if (currentVB == NUM_SPHERE_VERTEX_BUFFERS)
+            currentVB = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
+    }
+}
+
+
+void LODSphereMesh::setSectionPointers(const RenderInfo& ri, const float* vertexBase)
+{
+    auto stride = (GLsizei) (vertexSize * sizeof(float));
+    int texCoordOffset = ((ri.attributes & Tangents) != 0) ? 6 : 3;
+
+    glVertexPointer(3, GL_FLOAT, stride, vertexBase + 0);
+    if ((ri.attributes & Normals) != 0)
+        glNormalPointer(GL_FLOAT, stride, vertexBase);
+
+    for (int tc = 0; tc < nTexturesUsed; tc++)
+    {
+        if (nTexturesUsed > 1)
+            glClientActiveTexture(GL_TEXTURE0 + tc);
+        glTexCoordPointer(2, GL_FLOAT, stride,  vertexBase + (tc * 2) + texCoordOffset);
+    }
+
+    if ((ri.attributes & Tangents) != 0)
+    {
+        glVertexAttribPointer(CelestiaGLProgram::TangentAttributeIndex,
+                              3, GL_FLOAT, GL_FALSE,
+                              stride, vertexBase + 3); // 3 == tangentOffset
+    }
+}
+
+
+void LODSphereMesh::generateSectionVertices(float* data,
+                                            int phi0, int theta0, int extent,
+                                            const RenderInfo& ri,
+                                            const float u0[], const float v0[],
+                                            const float du[], const float dv[]) const
+{
+    int theta1 = theta0 + extent;
+    int phi1 = phi0 + extent / 2;
+
     int vindex = 0;
     for (int phi = phi0; phi <= phi1; phi += ri.step)
     {
@@ -756,21 +987,21 @@ void LODSphereMesh::renderSection(int phi0, int theta0, int extent,
                 float ctheta = cosTheta[theta];
                 float stheta = sinTheta[theta];
 
-                vertices[vindex]      = cphi * ctheta;
-                vertices[vindex + 1]  = sphi;
-                vertices[vindex + 2]  = cphi * stheta;
+                data[vindex]      = cphi * ctheta;
+                data[vindex + 1]  = sphi;
+                data[vindex + 2]  = cphi * stheta;
 
                 // Compute the tangent--required for bump mapping
-                vertices[vindex + 3] = stheta;
-                vertices[vindex + 4] = 0.0f;
-                vertices[vindex + 5] = -ctheta;
+                data[vindex + 3] = stheta;
+                data[vindex + 4] = 0.0f;
+                data[vindex + 5] = -ctheta;
 
                 vindex += 6;
 
                 for (int tex = 0; tex < nTexturesUsed; tex++)
                 {
-                    vertices[vindex]     = u0[tex] - theta * du[tex];
-                    vertices[vindex + 1] = v0[tex] - phi * dv[tex];
+                    data[vindex]     = u0[tex] - theta * du[tex];
+                    data[vindex + 1] = v0[tex] - phi * dv[tex];
                     vindex += 2;
                 }
             }
@@ -782,48 +1013,19 @@ void LODSphereMesh::renderSection(int phi0, int theta0, int extent,
                 float ctheta = cosTheta[theta];
                 float stheta = sinTheta[theta];
 
-                vertices[vindex]      = cphi * ctheta;
-                vertices[vindex + 1]  = sphi;
-                vertices[vindex + 2]  = cphi * stheta;
+                data[vindex]      = cphi * ctheta;
+                data[vindex + 1]  = sphi;
+                data[vindex + 2]  = cphi * stheta;
 
                 vindex += 3;
 
                 for (int tex = 0; tex < nTexturesUsed; tex++)
                 {
-                    vertices[vindex]     = u0[tex] - theta * du[tex];
-                    vertices[vindex + 1] = v0[tex] - phi * dv[tex];
+                    data[vindex]     = u0[tex] - theta * du[tex];
+                    data[vindex + 1] = v0[tex] - phi * dv[tex];
                     vindex += 2;
                 }
             }
         }
     }
-
-    if (useVertexBuffers)
-    {
-        vertices = nullptr;
-        if (!glUnmapBuffer(GL_ARRAY_BUFFER))
-            return;
-    }
-
-    // TODO: Fix this--number of rings can reach zero and cause dropout
-    // int nRings = max(phiExtent / ri.step, 1); // buggy
-    int nRings = phiExtent / ri.step;
-    int nSlices = thetaExtent / ri.step;
-    unsigned short* indexBase = useVertexBuffers ? (unsigned short*) nullptr : indices;
-    for (int i = 0; i < nRings; i++)
-    {
-        glDrawElements(GL_QUAD_STRIP,
-                       (nSlices + 1) * 2,
-                       GL_UNSIGNED_SHORT,
-                       indexBase + (nSlices + 1) * 2 * i);
-    }
-
-    // Cycle through the vertex buffers
-    if (useVertexBuffers)
-    {
-        currentVB++;
-        if (currentVB == NUM_SPHERE_VERTEX_BUFFERS)
-            currentVB = 0;
-        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffers[currentVB]);
-    }
 }
@@ -61,6 +61,7 @@ public:
         unsigned int attributes;  // vertex attributes
         const celmath::Frustum& frustum;   // frustum, for culling
         Eigen::Vector3f fp[8];    // frustum points, for culling
+        Eigen::Vector3f eyePos{ Eigen::Vector3f::Zero() };  // eye position, for horizon culling
         int texLOD[MAX_SPHERE_MESH_TEXTURES];
     };
 
@@ -71,6 +72,13 @@ public:
 
     void renderSection(int phi0, int theta0, int extent, const RenderInfo&);
 
+    void setSectionPointers(const RenderInfo&, const float* vertexBase);
+    void generateSectionVertices(float* data,
+                                 int phi0, int theta0, int extent,
+                                 const RenderInfo&,
+                                 const float u0[], const float v0[],
+                                 const float du[], const float dv[]) const;
+
     float* vertices{ nullptr };
 
     int maxVertices{ 0 };
@@ -87,7 +95,6 @@ public:
     bool useVertexBuffers{ false };
     int currentVB{ 0 };
     unsigned int vertexBuffers[NUM_SPHERE_VERTEX_BUFFERS];
-    GLuint indexBuffer{ 0 };
 };
 
 #endif // CELENGINE_LODSPHEREMESH_H_
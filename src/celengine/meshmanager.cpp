@@ -23,20 +23,34 @@
 #include "modelgeometry.h"
 
 #include <cel3ds/3dsread.h>
+#include <celmodel/meshoptimize.h>
+#include <celmodel/modelcache.h>
 #include <celmodel/modelfile.h>
 
 #include <celmath/mathlib.h>
 #include <celmath/perlin.h>
+#include <celutil/asyncfile.h>
+#include <celutil/compress.h>
 #include <celutil/debug.h>
 #include <celutil/filetype.h>
 #include <celutil/util.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <cassert>
+#include <cstdio>
+#include <system_error>
 #include <utility>
 #include <celutil/debug.h>
 #include <memory>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 
 using namespace cmod;
@@ -45,34 +59,172 @@ using namespace std;
 
 
 static Model* LoadCelestiaMesh(const fs::path& filename);
-static Model* Convert3DSModel(const M3DScene& scene, const fs::path& texPath);
+static Model* Convert3DSModel(const M3DScene& scene, cmod::TextureLoader* textureLoader);
 
 static GeometryManager* geometryManager = nullptr;
 
 constexpr const fs::path::value_type UniqueSuffixChar = '!';
 
 
-class CelestiaTextureLoader : public cmod::TextureLoader
+/*! Texture loader used while parsing a model on a background thread.
+ *  The texture manager is only safe to use from the main thread, so
+ *  instead of creating handles immediately we record the texture names
+ *  and bind the handles when the finished model is handed back in
+ *  GeometryInfo::tryFinishLoad().
+ */
+class DeferredTextureLoader : public cmod::TextureLoader
 {
 public:
-    CelestiaTextureLoader(const fs::path& texturePath) :
+    struct Entry
+    {
+        CelestiaTextureResource* resource;
+        std::string name;
+        fs::path texturePath;
+    };
+
+    DeferredTextureLoader(const fs::path& texturePath) :
         m_texturePath(texturePath)
     {
     }
 
-    ~CelestiaTextureLoader() = default;
+    ~DeferredTextureLoader() = default;
+
+    Material::TextureResource* loadTexture(const std::string& name);
 
-    Material::TextureResource* loadTexture(const std::string& name)
+    std::vector<Entry>& entries()
     {
-        ResourceHandle tex = GetTextureManager()->getHandle(TextureInfo(name, m_texturePath, TextureInfo::WrapTexture));
-        return new CelestiaTextureResource(tex);
+        return m_entries;
     }
 
 private:
     fs::path m_texturePath;
+    std::vector<Entry> m_entries;
+};
+
+
+/*! Texture reference created on a worker thread. Reports its source
+ *  name without consulting the texture manager, so the model can be
+ *  written to the optimization cache before the handle is bound.
+ */
+class DeferredTextureResource : public CelestiaTextureResource
+{
+public:
+    DeferredTextureResource(const std::string& source) :
+        CelestiaTextureResource(InvalidResource),
+        m_source(source)
+    {
+    }
+
+    std::string source() const { return m_source; }
+
+private:
+    std::string m_source;
+};
+
+
+Material::TextureResource* DeferredTextureLoader::loadTexture(const std::string& name)
+{
+    auto* resource = new DeferredTextureResource(name);
+    m_entries.push_back(Entry{ resource, name, m_texturePath });
+    return resource;
+}
+
+
+/*! A model load queued on the background worker pool. Snapshot of the
+ *  GeometryInfo fields the load needs, so the request stays valid even
+ *  if the resource manager's tables are resized while it is in flight.
+ */
+struct GeometryLoadRequest
+{
+    fs::path resolvedName;
+    fs::path path;
+    bool resolvedToPath{ false };
+    Eigen::Vector3f center{ Eigen::Vector3f::Zero() };
+    float scale{ 1.0f };
+    bool isNormalized{ true };
+
+    //! Request recency stamp; the worker pool serves the newest job first
+    unsigned int priority{ 0 };
+
+    bool done{ false };
+    Geometry* geometry{ nullptr };
+    std::vector<DeferredTextureLoader::Entry> deferredTextures;
+
+    //! Content hash of the source file, computed by the load worker
+    uint64_t contentHash{ 0 };
 };
 
 
+// Mix the uniquifying suffix into a content hash, so models that share
+// a source file but differ in center, scale, or normalization never
+// alias to one Geometry.
+static uint64_t foldUniquifyingSuffix(uint64_t hash, const fs::path::string_type& resolvedName)
+{
+    if (hash == 0)
+        return 0;
+
+    fs::path::string_type::size_type suffixStart = resolvedName.rfind(UniqueSuffixChar);
+    for (fs::path::string_type::size_type i = suffixStart;
+         i != fs::path::string_type::npos && i < resolvedName.size(); i++)
+    {
+        hash ^= (unsigned char) resolvedName[i];
+        hash *= UINT64_C(1099511628211);
+    }
+
+    return hash != 0 ? hash : 1;
+}
+
+
+static std::mutex loadQueueMutex;
+static std::condition_variable loadQueueCondVar;
+static std::deque<std::shared_ptr<GeometryLoadRequest>> loadQueue;
+static unsigned int loadWorkerCount = 0;
+static unsigned int loadPriorityStamp = 0;
+
+static void RunLoadRequest(GeometryLoadRequest& req);
+
+static void GeometryLoadWorker()
+{
+    for (;;)
+    {
+        std::shared_ptr<GeometryLoadRequest> job;
+        {
+            unique_lock<mutex> lock(loadQueueMutex);
+            loadQueueCondVar.wait(lock, [] { return !loadQueue.empty(); });
+
+            // Serve the most recently requested model first. The renderer
+            // refreshes the stamp of every model in view each frame, so
+            // visible models are loaded before ones that have left the view.
+            auto best = loadQueue.begin();
+            for (auto iter = loadQueue.begin(); iter != loadQueue.end(); ++iter)
+            {
+                if ((*iter)->priority > (*best)->priority)
+                    best = iter;
+            }
+            job = *best;
+            loadQueue.erase(best);
+        }
+
+        RunLoadRequest(*job);
+
+        lock_guard<mutex> lock(loadQueueMutex);
+        job->done = true;
+    }
+}
+
+
+//! Spawn the worker pool on first use; must be called with loadQueueMutex held
+static void StartLoadWorkers()
+{
+    unsigned int maxWorkers = std::max(1u, std::min(2u, std::thread::hardware_concurrency() / 2));
+    while (loadWorkerCount < maxWorkers)
+    {
+        std::thread(GeometryLoadWorker).detach();
+        loadWorkerCount++;
+    }
+}
+
+
 GeometryManager* GetGeometryManager()
 {
     if (geometryManager == nullptr)
@@ -110,72 +262,112 @@ fs::path GeometryInfo::resolve(const fs::path& baseDir)
 }
 
 
-Geometry* GeometryInfo::load(const fs::path& resolvedFilename)
+//! Load and condition a model; runs on a background worker thread
+static void RunLoadRequest(GeometryLoadRequest& req)
 {
     // Strip off the uniquifying suffix
-    fs::path::string_type::size_type uniquifyingSuffixStart = resolvedFilename.native().rfind(UniqueSuffixChar);
-    fs::path filename = resolvedFilename.native().substr(0, uniquifyingSuffixStart);
+    fs::path::string_type::size_type uniquifyingSuffixStart = req.resolvedName.native().rfind(UniqueSuffixChar);
+    fs::path filename = req.resolvedName.native().substr(0, uniquifyingSuffixStart);
+
+    // Hash the source file on this thread so the manager can alias
+    // byte-identical models without reading the file on the render
+    // thread; this also warms the file cache for the parse below.
+    req.contentHash = foldUniquifyingSuffix(GeometryInfo::hashFileContents(filename),
+                                            req.resolvedName.native());
 
     fmt::fprintf(clog, _("Loading model: %s\n"), filename);
     Model* model = nullptr;
     ContentType fileType = DetermineFileType(filename);
 
-    if (fileType == Content_3DStudio)
+#if PARTICLE_SYSTEM
+    if (fileType == Content_CelestiaParticleSystem)
     {
-        M3DScene* scene = Read3DSFile(filename);
-        if (scene != nullptr)
+        ifstream in(filename);
+        if (in.good())
         {
-            if (resolvedToPath)
-                model = Convert3DSModel(*scene, path);
-            else
-                model = Convert3DSModel(*scene, "");
+            req.geometry = LoadParticleSystem(in, req.path);
+        }
+        return;
+    }
+#endif
 
-            if (isNormalized)
-                model->normalize(center);
-            else
-                model->transform(center, scale);
+    DeferredTextureLoader textureLoader(fileType == Content_3DStudio && !req.resolvedToPath
+                                            ? fs::path() : req.path);
 
-            delete scene;
-        }
+    // Cache-optimized models are stored in the compressed cache format
+    // next to the source file, keyed by the source size like the normal
+    // map cache
+    fs::path cachePath;
+    if (fileType == Content_3DStudio || fileType == Content_CelestiaModel)
+    {
+        std::error_code ec;
+        uintmax_t sourceSize = fs::file_size(filename, ec);
+        if (!ec)
+            cachePath = filename.string() + "." + to_string(sourceSize) + ".qcm";
     }
-    else if (fileType == Content_CelestiaModel)
+
+    bool fromCache = false;
+    if (!cachePath.empty())
     {
-        ifstream in(filename.string(), ios::binary);
+        ifstream in(cachePath.string(), ios::binary);
         if (in.good())
         {
-            CelestiaTextureLoader textureLoader(path);
+            model = LoadCachedModel(in, &textureLoader);
+            fromCache = model != nullptr;
+        }
+    }
 
-            model = LoadModel(in, &textureLoader);
-            if (model != nullptr)
+    if (model == nullptr)
+    {
+        if (fileType == Content_3DStudio)
+        {
+            M3DScene* scene = Read3DSFile(filename);
+            if (scene != nullptr)
             {
-                if (isNormalized)
-                    model->normalize(center);
-                else
-                    model->transform(center, scale);
+                model = Convert3DSModel(*scene, &textureLoader);
+                delete scene;
             }
         }
-    }
-    else if (fileType == Content_CelestiaMesh)
-    {
-        model = LoadCelestiaMesh(filename);
-        if (model != nullptr)
+        else if (fileType == Content_CelestiaModel)
+        {
+            // Read through the decompression helper so gzip compressed
+            // models load transparently.
+            string contents;
+            if (ReadPossiblyCompressedFile(filename, contents))
+            {
+                istringstream in(contents, ios::in | ios::binary);
+                model = LoadModel(in, &textureLoader);
+            }
+        }
+        else if (fileType == Content_CelestiaMesh)
         {
-            if (isNormalized)
-                model->normalize(center);
-            else
-                model->transform(center, scale);
+            model = LoadCelestiaMesh(filename);
         }
     }
-#if PARTICLE_SYSTEM
-    else if (fileType == Content_CelestiaParticleSystem)
+
+    req.deferredTextures = std::move(textureLoader.entries());
+
+    if (model != nullptr && !fromCache)
     {
-        ifstream in(filename);
-        if (in.good())
+        // Reorder indices and vertices for the GPU vertex caches
+        for (unsigned int i = 0; i < model->getMeshCount(); ++i)
+            OptimizeMeshForVertexCache(*model->getMesh(i));
+
+        if (!cachePath.empty())
         {
-            return LoadParticleSystem(in, path);
+            ofstream out(cachePath.string(), ios::binary);
+            if (!out.good() || !SaveCachedModel(model, out))
+                std::remove(cachePath.string().c_str());
         }
     }
-#endif
+
+    if (model != nullptr)
+    {
+        if (req.isNormalized)
+            model->normalize(req.center);
+        else
+            model->transform(req.center, req.scale);
+    }
 
     // Condition the model for optimal rendering
     if (model != nullptr)
@@ -203,16 +395,117 @@ Geometry* GeometryInfo::load(const fs::path& resolvedFilename)
                      originalMaterialCount,
                      model->getMaterialCount());
 
-        return new ModelGeometry(unique_ptr<cmod::Model>(model));
+        auto* geometry = new ModelGeometry(unique_ptr<cmod::Model>(model));
+
+        // Generate the decimated LOD chain here rather than at render
+        // time; on the background worker the cost is invisible.
+        geometry->buildMeshLods();
+
+        req.geometry = geometry;
     }
     else
     {
         fmt::fprintf(clog, _("Error loading model '%s'\n"), filename);
-        return nullptr;
     }
 }
 
 
+//! Create texture handles recorded during a background parse; main thread only
+static void BindDeferredTextures(GeometryLoadRequest& req)
+{
+    for (const auto& entry : req.deferredTextures)
+    {
+        ResourceHandle tex = GetTextureManager()->getHandle(TextureInfo(entry.name, entry.texturePath, TextureInfo::WrapTexture));
+        entry.resource->setTextureHandle(tex);
+    }
+}
+
+
+Geometry* GeometryInfo::load(const fs::path& resolvedFilename)
+{
+    // Synchronous fallback; the manager normally loads geometry through
+    // beginLoad()/tryFinishLoad() instead.
+    GeometryLoadRequest req;
+    req.resolvedName = resolvedFilename;
+    req.path = path;
+    req.resolvedToPath = resolvedToPath;
+    req.center = center;
+    req.scale = scale;
+    req.isNormalized = isNormalized;
+
+    RunLoadRequest(req);
+    BindDeferredTextures(req);
+    contentHash = req.contentHash;
+
+    return req.geometry;
+}
+
+
+void GeometryInfo::beginLoad(const fs::path& resolvedFilename)
+{
+    loadRequest = make_shared<GeometryLoadRequest>();
+    loadRequest->resolvedName = resolvedFilename;
+    loadRequest->path = path;
+    loadRequest->resolvedToPath = resolvedToPath;
+    loadRequest->center = center;
+    loadRequest->scale = scale;
+    loadRequest->isNormalized = isNormalized;
+
+    // Warm the file cache for the model while the request waits behind
+    // whatever the worker pool is currently parsing.
+    fs::path::string_type::size_type uniquifyingSuffixStart = resolvedFilename.native().rfind(UniqueSuffixChar);
+    GetAsyncFileReader()->readahead(resolvedFilename.native().substr(0, uniquifyingSuffixStart));
+
+    lock_guard<mutex> lock(loadQueueMutex);
+    loadRequest->priority = ++loadPriorityStamp;
+    loadQueue.push_back(loadRequest);
+    StartLoadWorkers();
+    loadQueueCondVar.notify_one();
+}
+
+
+bool GeometryInfo::tryFinishLoad(Geometry*& res)
+{
+    res = nullptr;
+    if (loadRequest == nullptr)
+        return false;
+
+    {
+        lock_guard<mutex> lock(loadQueueMutex);
+        if (!loadRequest->done)
+        {
+            // Still queued or in progress; refresh the request stamp so
+            // that models currently in view are loaded first.
+            loadRequest->priority = ++loadPriorityStamp;
+            return false;
+        }
+    }
+
+    BindDeferredTextures(*loadRequest);
+    res = loadRequest->geometry;
+    contentHash = loadRequest->contentHash;
+    loadRequest.reset();
+    return true;
+}
+
+
+uintmax_t GeometryInfo::resourceSize() const
+{
+    if (resource == nullptr)
+        return 0;
+
+    // Use the model file size as a proxy for the in-memory footprint;
+    // vertex and index data dominate both.
+    fs::path::string_type::size_type uniquifyingSuffixStart = resolvedName.native().rfind(UniqueSuffixChar);
+    fs::path filename = resolvedName.native().substr(0, uniquifyingSuffixStart);
+
+    std::error_code ec;
+    uintmax_t size = fs::file_size(filename, ec);
+
+    return ec ? 0 : size;
+}
+
+
 struct NoiseMeshParameters
 {
     Vector3f size;
@@ -224,19 +517,31 @@ struct NoiseMeshParameters
 };
 
 
-static float NoiseDisplacementFunc(float u, float v, void* info)
+static void NoiseDisplacementBatchFunc(const float u[], const float v[],
+                                       float disp[], unsigned int count,
+                                       void* info)
 {
-    float theta = u * (float) PI * 2;
-    float phi = (v - 0.5f) * (float) PI;
-    float x = (float) (cos(phi) * cos(theta));
-    float y = (float) sin(phi);
-    float z = (float) (cos(phi) * sin(theta));
-
     // assert(info != nullptr);
     auto* params = (NoiseMeshParameters*) info;
 
-    Vector3f p = Vector3f(x, y, z) + params->offset;
-    return fractalsum(p, params->octaves) * params->featureHeight;
+    // Convert the sample batch to sphere surface points in SoA layout,
+    // then evaluate the fractal noise with the vectorized kernels.
+    vector<float> x(count);
+    vector<float> y(count);
+    vector<float> z(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        float theta = u[i] * (float) PI * 2;
+        float phi = (v[i] - 0.5f) * (float) PI;
+        x[i] = (float) (cos(phi) * cos(theta)) + params->offset.x();
+        y[i] = (float) sin(phi) + params->offset.y();
+        z[i] = (float) (cos(phi) * sin(theta)) + params->offset.z();
+    }
+
+    fractalsumv(x.data(), y.data(), z.data(), params->octaves, disp, count);
+
+    for (unsigned int i = 0; i < count; i++)
+        disp[i] *= params->featureHeight;
 }
 
 
@@ -303,7 +608,7 @@ Model* LoadCelestiaMesh(const fs::path& filename)
     Model* model = new Model();
     SphereMesh* sphereMesh = new SphereMesh(params.size,
                                             (int) params.rings, (int) params.slices,
-                                            NoiseDisplacementFunc,
+                                            NoiseDisplacementBatchFunc,
                                             (void*) &params);
     Mesh* mesh = sphereMesh->convertToMesh();
     model->addMesh(mesh);
@@ -313,8 +618,60 @@ Model* LoadCelestiaMesh(const fs::path& filename)
 }
 
 
+/*! Average the face normals around each corner of the faces in
+ *  [faceBegin, faceEnd) to produce smooth vertex normals. Only reads the
+ *  shared face normal and adjacency tables, so disjoint face ranges may
+ *  be processed concurrently.
+ */
+static void
+SmoothNormalsRange(const M3DTriangleMesh& mesh,
+                   const Vector3f* faceNormals,
+                   int* const* vertexFaces,
+                   Vector3f* vertexNormals,
+                   int faceBegin,
+                   int faceEnd)
+{
+    for (int i = faceBegin; i < faceEnd; i++)
+    {
+        uint16_t v0, v1, v2;
+        mesh.getFace(i, v0, v1, v2);
+        // uint32_t smoothingGroups = mesh.getSmoothingGroups(i);
+
+        Vector3f v = Vector3f::Zero();
+        for (int j = 1; j <= vertexFaces[v0][0]; j++)
+        {
+            int k = vertexFaces[v0][j];
+            // if (k == i || (smoothingGroups & mesh.getSmoothingGroups(k)) != 0)
+            if (faceNormals[i].dot(faceNormals[k]) > 0.5f)
+                v += faceNormals[k];
+        }
+        vertexNormals[i * 3] = v.normalized();
+
+        v = Vector3f::Zero();
+        for (int j = 1; j <= vertexFaces[v1][0]; j++)
+        {
+            int k = vertexFaces[v1][j];
+            // if (k == i || (smoothingGroups & mesh.getSmoothingGroups(k)) != 0)
+            if (faceNormals[i].dot(faceNormals[k]) > 0.5f)
+                v += faceNormals[k];
+        }
+        vertexNormals[i * 3 + 1] = v.normalized();
+
+        v = Vector3f::Zero();
+        for (int j = 1; j <= vertexFaces[v2][0]; j++)
+        {
+            int k = vertexFaces[v2][j];
+            // if (k == i || (smoothingGroups & mesh.getSmoothingGroups(k)) != 0)
+            if (faceNormals[i].dot(faceNormals[k]) > 0.5f)
+                v += faceNormals[k];
+        }
+        vertexNormals[i * 3 + 2] = v.normalized();
+    }
+}
+
+
 static Mesh*
-ConvertTriangleMesh(M3DTriangleMesh& mesh,
+ConvertTriangleMesh(const M3DTriangleMesh& mesh,
                     const M3DScene& scene)
 {
     int nFaces     = mesh.getFaceCount();
@@ -408,42 +765,34 @@ ConvertTriangleMesh(M3DTriangleMesh& mesh,
             vertexFaces[v2][faceCounts[v2]--] = i;
         }
 
-        // average face normals to compute the vertex normals
-        for (int i = 0; i < nFaces; i++)
-        {
-            uint16_t v0, v1, v2;
-            mesh.getFace(i, v0, v1, v2);
-            // uint32_t smoothingGroups = mesh.getSmoothingGroups(i);
-
-            Vector3f v = Vector3f::Zero();
-            for (int j = 1; j <= vertexFaces[v0][0]; j++)
-            {
-                int k = vertexFaces[v0][j];
-                // if (k == i || (smoothingGroups & mesh.getSmoothingGroups(k)) != 0)
-                if (faceNormals[i].dot(faceNormals[k]) > 0.5f)
-                    v += faceNormals[k];
-            }
-            vertexNormals[i * 3] = v.normalized();
-
-            v = Vector3f::Zero();
-            for (int j = 1; j <= vertexFaces[v1][0]; j++)
-            {
-                int k = vertexFaces[v1][j];
-                // if (k == i || (smoothingGroups & mesh.getSmoothingGroups(k)) != 0)
-                if (faceNormals[i].dot(faceNormals[k]) > 0.5f)
-                    v += faceNormals[k];
-            }
-            vertexNormals[i * 3 + 1] = v.normalized();
+        // Average face normals to compute the vertex normals. This is by
+        // far the most expensive part of the conversion, and each face only
+        // reads the shared tables built above, so large meshes are split
+        // into face ranges and smoothed in parallel.
+        unsigned int nTasks = 1;
+        if (nFaces >= 4096)
+            nTasks = max(1u, min(thread::hardware_concurrency(),
+                                 (unsigned int) (nFaces / 2048)));
 
-            v = Vector3f::Zero();
-            for (int j = 1; j <= vertexFaces[v2][0]; j++)
+        if (nTasks <= 1)
+        {
+            SmoothNormalsRange(mesh, faceNormals, vertexFaces, vertexNormals,
+                               0, nFaces);
+        }
+        else
+        {
+            vector<future<void>> tasks;
+            int facesPerTask = (nFaces + (int) nTasks - 1) / (int) nTasks;
+            for (int face = 0; face < nFaces; face += facesPerTask)
             {
-                int k = vertexFaces[v2][j];
-                // if (k == i || (smoothingGroups & mesh.getSmoothingGroups(k)) != 0)
-                if (faceNormals[i].dot(faceNormals[k]) > 0.5f)
-                    v += faceNormals[k];
+                int faceEnd = min(face + facesPerTask, nFaces);
+                tasks.push_back(async(launch::async,
+                                      SmoothNormalsRange,
+                                      cref(mesh), faceNormals, vertexFaces,
+                                      vertexNormals, face, faceEnd));
             }
-            vertexNormals[i * 3 + 2] = v.normalized();
+            for (auto& task : tasks)
+                task.wait();
         }
     }
 
@@ -537,7 +886,7 @@ toMaterialColor(Color c)
 
 
 static Model*
-Convert3DSModel(const M3DScene& scene, const fs::path& texPath)
+Convert3DSModel(const M3DScene& scene, cmod::TextureLoader* textureLoader)
 {
     Model* model = new Model();
 
@@ -566,8 +915,7 @@ Convert3DSModel(const M3DScene& scene, const fs::path& texPath)
 
         if (!material->getTextureMap().empty())
         {
-            ResourceHandle tex = GetTextureManager()->getHandle(TextureInfo(material->getTextureMap(), texPath, TextureInfo::WrapTexture));
-            newMaterial->maps[Material::DiffuseMap] = new CelestiaTextureResource(tex);
+            newMaterial->maps[Material::DiffuseMap] = textureLoader->loadTexture(material->getTextureMap());
         }
 
         model->addMaterial(newMaterial);
@@ -575,6 +923,7 @@ Convert3DSModel(const M3DScene& scene, const fs::path& texPath)
 
     // Convert all models in the scene. Some confusing terminology: a 3ds 'scene' is the same
     // as a Celestia model, and a 3ds 'model' is the same as a Celestia mesh.
+    vector<const M3DTriangleMesh*> triMeshes;
     for (uint32_t i = 0; i < scene.getModelCount(); i++)
     {
         M3DModel* model3ds = scene.getModel(i);
@@ -584,13 +933,33 @@ Convert3DSModel(const M3DScene& scene, const fs::path& texPath)
             {
                 M3DTriangleMesh* mesh = model3ds->getTriMesh(j);
                 if (mesh)
-                {
-                    Mesh* newMesh = ConvertTriangleMesh(*mesh, scene);
-                    model->addMesh(newMesh);
-                }
+                    triMeshes.push_back(mesh);
             }
         }
     }
 
+    // Each triangle mesh converts independently of the others, so scenes
+    // with several meshes (common in city and station add-ons) are
+    // converted in parallel. Meshes are added to the model in file order
+    // either way.
+    if (triMeshes.size() > 1 && thread::hardware_concurrency() > 1)
+    {
+        vector<future<Mesh*>> tasks;
+        tasks.reserve(triMeshes.size());
+        for (const M3DTriangleMesh* mesh : triMeshes)
+        {
+            tasks.push_back(async(launch::async,
+                                  ConvertTriangleMesh,
+                                  cref(*mesh), cref(scene)));
+        }
+        for (auto& task : tasks)
+            model->addMesh(task.get());
+    }
+    else
+    {
+        for (const M3DTriangleMesh* mesh : triMeshes)
+            model->addMesh(ConvertTriangleMesh(*mesh, scene));
+    }
+
     return model;
 }
@@ -12,11 +12,14 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include <celutil/resmanager.h>
 #include <celengine/geometry.h>
 #include <celcompat/filesystem.h>
 
 
+struct GeometryLoadRequest;
+
 class GeometryInfo : public ResourceInfo<Geometry>
 {
  public:
@@ -52,6 +55,17 @@ class GeometryInfo : public ResourceInfo<Geometry>
 
     virtual fs::path resolve(const fs::path&);
     virtual Geometry* load(const fs::path&);
+    virtual std::uintmax_t resourceSize() const;
+
+    // Models are parsed on a background worker pool; until the load
+    // completes the renderer falls back to the body's bounding ellipsoid.
+    virtual bool loadsAsynchronously() const { return true; }
+    virtual void beginLoad(const fs::path&);
+    virtual bool tryFinishLoad(Geometry*&);
+
+ private:
+    //! In-flight background load; shared so copies of this info track it
+    std::shared_ptr<GeometryLoadRequest> loadRequest;
 };
 
 inline bool operator<(const GeometryInfo& g0, const GeometryInfo& g1)
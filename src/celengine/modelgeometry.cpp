@@ -11,10 +11,13 @@
 #include "modelgeometry.h"
 #include "rendcontext.h"
 #include "texmanager.h"
+#include <celmodel/meshsimplify.h>
 #include <Eigen/Core>
 #include <functional>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 
 using namespace cmod;
 using namespace Eigen;
@@ -24,27 +27,224 @@ using namespace celmath;
 
 // Vertex buffer object support
 
-// VBO optimization is only worthwhile for large enough vertex lists
-static const unsigned int MinVBOSize = 4096;
+// Size of the shared buffer arenas; meshes over half this size get a
+// dedicated buffer of their own
+static const unsigned int BufferArenaSize = 4 * 1024 * 1024;
+
+// Suballocation alignment within an arena
+static const unsigned int BufferArenaAlignment = 64;
+
+// Models below this triangle count aren't worth the memory cost of a
+// decimated LOD chain
+static const unsigned int MinLodModelFaceCount = 20000;
+
+
+/*! Shared vertex and index buffer arenas. Add-on scenes often contain
+ *  hundreds of small models; giving each its own buffer objects means
+ *  as many allocations and bind switches per frame. Instead mesh data
+ *  is suballocated from large shared arenas, so walking the render
+ *  list mostly changes byte offsets within an already bound buffer.
+ *  Suballocations are never recycled individually: an arena block is
+ *  released when every model using it has been destroyed.
+ */
+class GeometryBufferArena
+{
+public:
+    struct Allocation
+    {
+        GLuint buffer{ 0 };
+        unsigned int offset{ 0 };
+        bool pooled{ false };
+    };
+
+    Allocation allocate(GLenum target, unsigned int size, const void* data)
+    {
+        Allocation allocation;
+        if (size == 0)
+            return allocation;
+
+        // Large meshes get dedicated buffers; pooling them would just
+        // turn over arena blocks
+        if (size >= BufferArenaSize / 2)
+        {
+            glGenBuffers(1, &allocation.buffer);
+            if (allocation.buffer != 0)
+            {
+                glBindBuffer(target, allocation.buffer);
+                glBufferData(target, size, data, GL_STATIC_DRAW);
+                glBindBuffer(target, 0);
+            }
+            return allocation;
+        }
+
+        std::vector<Block>& blocks = blocksForTarget(target);
+
+        unsigned int alignedSize = (size + BufferArenaAlignment - 1) & ~(BufferArenaAlignment - 1);
+        if (blocks.empty() || blocks.back().used + alignedSize > BufferArenaSize)
+        {
+            Block block;
+            glGenBuffers(1, &block.buffer);
+            if (block.buffer == 0)
+                return allocation;
+
+            glBindBuffer(target, block.buffer);
+            glBufferData(target, BufferArenaSize, nullptr, GL_STATIC_DRAW);
+            glBindBuffer(target, 0);
+            blocks.push_back(block);
+        }
+
+        Block& block = blocks.back();
+        glBindBuffer(target, block.buffer);
+        glBufferSubData(target, block.used, size, data);
+        glBindBuffer(target, 0);
+
+        allocation.buffer = block.buffer;
+        allocation.offset = block.used;
+        allocation.pooled = true;
+        block.used += alignedSize;
+        block.liveAllocations++;
+
+        return allocation;
+    }
+
+    void release(GLenum target, const Allocation& allocation)
+    {
+        if (allocation.buffer == 0)
+            return;
+
+        if (!allocation.pooled)
+        {
+            glDeleteBuffers(1, &allocation.buffer);
+            return;
+        }
+
+        std::vector<Block>& blocks = blocksForTarget(target);
+        for (auto iter = blocks.begin(); iter != blocks.end(); ++iter)
+        {
+            if (iter->buffer != allocation.buffer)
+                continue;
+
+            if (--iter->liveAllocations == 0)
+            {
+                // Keep the open block for reuse; retire full ones
+                if (iter + 1 == blocks.end())
+                    iter->used = 0;
+                else
+                {
+                    glDeleteBuffers(1, &iter->buffer);
+                    blocks.erase(iter);
+                }
+            }
+            return;
+        }
+    }
+
+private:
+    struct Block
+    {
+        GLuint buffer{ 0 };
+        unsigned int used{ 0 };
+        unsigned int liveAllocations{ 0 };
+    };
+
+    std::vector<Block>& blocksForTarget(GLenum target)
+    {
+        return target == GL_ELEMENT_ARRAY_BUFFER ? m_elementBlocks : m_arrayBlocks;
+    }
+
+    std::vector<Block> m_arrayBlocks;
+    std::vector<Block> m_elementBlocks;
+};
+
+
+static GeometryBufferArena* GetGeometryBufferArena()
+{
+    // Only used from the render thread, where a GL context is current
+    static GeometryBufferArena* arena = new GeometryBufferArena();
+    return arena;
+}
 
 
 class ModelOpenGLData
 {
 public:
+    struct MeshBuffers
+    {
+        GeometryBufferArena::Allocation vertices;
+        GeometryBufferArena::Allocation indices;
+
+        //! Byte offset of each primitive group within the index allocation
+        std::vector<unsigned int> groupOffsets;
+    };
+
     ModelOpenGLData() = default;
 
     ~ModelOpenGLData()
     {
-        for (auto vboId : vbos)
+        for (const auto& mb : buffers)
         {
-            if (vboId != 0)
+            GetGeometryBufferArena()->release(GL_ARRAY_BUFFER, mb.vertices);
+            GetGeometryBufferArena()->release(GL_ELEMENT_ARRAY_BUFFER, mb.indices);
+        }
+    }
+
+    //! Upload one mesh into the shared arenas
+    void addMesh(const Mesh* mesh)
+    {
+        MeshBuffers mb;
+        if (mesh != nullptr)
+        {
+            GeometryBufferArena* arena = GetGeometryBufferArena();
+
+            mb.vertices = arena->allocate(GL_ARRAY_BUFFER,
+                                          mesh->getVertexCount() * mesh->getVertexDescription().stride,
+                                          mesh->getVertexData());
+
+            // Pack the index lists of all primitive groups contiguously
+            unsigned int indexBytes = 0;
+            for (unsigned int i = 0; i < mesh->getGroupCount(); ++i)
             {
-                glDeleteBuffers(1, &vboId);
+                mb.groupOffsets.push_back(indexBytes);
+                indexBytes += mesh->getGroup(i)->nIndices * sizeof(Mesh::index32);
+            }
+
+            if (indexBytes != 0)
+            {
+                std::vector<char> indexData(indexBytes);
+                for (unsigned int i = 0; i < mesh->getGroupCount(); ++i)
+                {
+                    const Mesh::PrimitiveGroup* group = mesh->getGroup(i);
+                    memcpy(indexData.data() + mb.groupOffsets[i],
+                           group->indices,
+                           group->nIndices * sizeof(Mesh::index32));
+                }
+
+                mb.indices = arena->allocate(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexData.data());
             }
         }
+
+        buffers.push_back(std::move(mb));
     }
 
-    std::vector<GLuint> vbos; // vertex buffer objects
+    std::vector<MeshBuffers> buffers;
+};
+
+
+/*! A decimated version of the model used when its projected screen size
+ *  drops below maxScreenSize. The meshes vector parallels the base
+ *  model's mesh list; a null entry means that mesh could not be
+ *  simplified and the full-detail mesh is used in its place.
+ */
+class ModelGeometryLevel
+{
+public:
+    ModelGeometryLevel() = default;
+    ~ModelGeometryLevel() = default;
+
+    float maxScreenSize{ 0.0f };
+    std::vector<std::unique_ptr<cmod::Mesh>> meshes;
+    bool vbInitialized{ false };
+    ModelOpenGLData glData;
 };
 
 
@@ -58,6 +258,9 @@ ModelGeometry::ModelGeometry(unique_ptr<cmod::Model>&& model) :
 }
 
 
+ModelGeometry::~ModelGeometry() = default;
+
+
 bool
 ModelGeometry::pick(const Ray3d& r, double& distance) const
 {
@@ -69,69 +272,109 @@ ModelGeometry::pick(const Ray3d& r, double& distance) const
  *  since this class doesn't currently support animation.
  */
 void
-ModelGeometry::render(RenderContext& rc, double /* t */)
+ModelGeometry::render(RenderContext& rc, double t)
 {
-    // The first time the mesh is rendered, we will try and place the
-    // vertex data in a vertex buffer object and potentially get a huge
-    // rendering performance boost.  This can consume a great deal of
-    // memory, since we're duplicating the vertex data.  TODO: investigate
-    // the possibility of deleting the original data.  We can always map
-    // read-only later on for things like picking, but this could be a low
-    // performance path.
+    renderInstanced(rc, nullptr, 0, t);
+}
+
+
+/*! Render the model once per instance transform, setting up material
+ *  and vertex array state only when it changes. A null transform list
+ *  draws a single copy using the current model matrix.
+ */
+void
+ModelGeometry::renderInstanced(RenderContext& rc,
+                               const Matrix4f* instanceTransforms,
+                               unsigned int instanceCount,
+                               double /* t */)
+{
+    // The first time the mesh is rendered, upload the vertex and index
+    // data into the shared buffer arenas.  This duplicates the data;
+    // the CPU copy is kept for picking.
     if (!m_vbInitialized)
     {
         m_vbInitialized = true;
 
         for (unsigned int i = 0; i < m_model->getMeshCount(); ++i)
-        {
-            Mesh* mesh = m_model->getMesh(i);
-            const Mesh::VertexDescription& vertexDesc = mesh->getVertexDescription();
+            m_glData->addMesh(m_model->getMesh(i));
+    }
 
-            GLuint vboId = 0;
-            if (mesh->getVertexCount() * vertexDesc.stride > MinVBOSize)
-            {
-                glGenBuffers(1, &vboId);
-                if (vboId != 0)
-                {
-                    glBindBuffer(GL_ARRAY_BUFFER, vboId);
-                    glBufferData(GL_ARRAY_BUFFER,
-                                    mesh->getVertexCount() * vertexDesc.stride,
-                                    mesh->getVertexData(),
-                                    GL_STATIC_DRAW);
-                    glBindBuffer(GL_ARRAY_BUFFER, 0);
-                }
-            }
+    // Pick the coarsest LOD level appropriate for the projected size; no
+    // matching level means full detail
+    ModelGeometryLevel* level = nullptr;
+    float screenSize = rc.getScreenSize();
+    for (const auto& lod : m_lods)
+    {
+        if (screenSize <= lod->maxScreenSize)
+            level = lod.get();
+    }
 
-            m_glData->vbos.push_back(vboId);
-        }
+    if (level != nullptr && !level->vbInitialized)
+    {
+        level->vbInitialized = true;
+
+        for (const auto& mesh : level->meshes)
+            level->glData.addMesh(mesh.get());
     }
 
     unsigned int lastMaterial = ~0u;
     unsigned int materialCount = m_model->getMaterialCount();
+    GLuint boundArrayBuffer = 0;
+    GLuint boundElementBuffer = 0;
 
     // Iterate over all meshes in the model
     for (unsigned int meshIndex = 0; meshIndex < m_model->getMeshCount(); ++meshIndex)
     {
         Mesh* mesh = m_model->getMesh(meshIndex);
-        GLuint vboId = 0;
+        const ModelOpenGLData::MeshBuffers* mb = nullptr;
+
+        if (meshIndex < m_glData->buffers.size())
+            mb = &m_glData->buffers[meshIndex];
 
-        if (meshIndex < m_glData->vbos.size())
+        // Substitute the decimated mesh where the level has one
+        if (level != nullptr &&
+            meshIndex < level->meshes.size() &&
+            level->meshes[meshIndex] != nullptr)
         {
-            vboId = m_glData->vbos[meshIndex];
+            mesh = level->meshes[meshIndex].get();
+            mb = meshIndex < level->glData.buffers.size() ? &level->glData.buffers[meshIndex] : nullptr;
         }
 
-        if (vboId != 0)
+        if (mb != nullptr && mb->vertices.buffer != 0)
         {
-            // Bind the vertex buffer object.
-            glBindBuffer(GL_ARRAY_BUFFER, vboId);
-            rc.setVertexArrays(mesh->getVertexDescription(), nullptr);
+            // Mesh data lives in an arena; within a shared block only the
+            // base offset changes between meshes
+            if (boundArrayBuffer != mb->vertices.buffer)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, mb->vertices.buffer);
+                boundArrayBuffer = mb->vertices.buffer;
+            }
+            rc.setVertexArrays(mesh->getVertexDescription(),
+                               reinterpret_cast<const void*>((std::uintptr_t) mb->vertices.offset));
         }
         else
         {
-            // No vertex buffer object; just use normal vertex arrays
+            // Buffer allocation failed; fall back to client vertex arrays
+            if (boundArrayBuffer != 0)
+            {
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                boundArrayBuffer = 0;
+            }
             rc.setVertexArrays(mesh->getVertexDescription(), mesh->getVertexData());
         }
 
+        bool useIndexBuffer = mb != nullptr && mb->indices.buffer != 0;
+        if (useIndexBuffer && boundElementBuffer != mb->indices.buffer)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mb->indices.buffer);
+            boundElementBuffer = mb->indices.buffer;
+        }
+        else if (!useIndexBuffer && boundElementBuffer != 0)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            boundElementBuffer = 0;
+        }
+
         // Iterate over all primitive groups in the mesh
         for (unsigned int groupIndex = 0; groupIndex < mesh->getGroupCount(); ++groupIndex)
         {
@@ -146,14 +389,74 @@ ModelGeometry::render(RenderContext& rc, double /* t */)
             }
 
             rc.setMaterial(material);
-            rc.drawGroup(*group);
+            if (instanceTransforms != nullptr)
+            {
+                if (useIndexBuffer)
+                    rc.drawGroupInstanced(*group, mb->indices.offset + mb->groupOffsets[groupIndex],
+                                          instanceTransforms, instanceCount);
+                else
+                    rc.drawGroupInstanced(*group, instanceTransforms, instanceCount);
+            }
+            else if (useIndexBuffer)
+            {
+                rc.drawGroup(*group, mb->indices.offset + mb->groupOffsets[groupIndex]);
+            }
+            else
+            {
+                rc.drawGroup(*group);
+            }
         }
+    }
 
-        // If we set a VBO, unbind it.
-        if (vboId != 0)
+    if (boundArrayBuffer != 0)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (boundElementBuffer != 0)
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+void
+ModelGeometry::buildMeshLods()
+{
+    unsigned int faceCount = m_model->getPrimitiveCount();
+    if (faceCount < MinLodModelFaceCount)
+        return;
+
+    static const struct
+    {
+        float maxScreenSize;
+        unsigned int reduction;
+    } levels[] =
+    {
+        { 400.0f,  8 },
+        { 100.0f, 64 },
+    };
+
+    for (const auto& levelSpec : levels)
+    {
+        unsigned int target = max(1000u, faceCount / levelSpec.reduction);
+        if (target >= faceCount)
+            continue;
+
+        auto level = unique_ptr<ModelGeometryLevel>(new ModelGeometryLevel());
+        level->maxScreenSize = levelSpec.maxScreenSize;
+
+        bool simplifiedAny = false;
+        for (unsigned int i = 0; i < m_model->getMeshCount(); ++i)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            const Mesh* mesh = m_model->getMesh(i);
+
+            // Divide the face budget between meshes by their share of the model
+            auto meshTarget = (unsigned int) ((uint64_t) target * mesh->getPrimitiveCount() / faceCount);
+            Mesh* simplified = SimplifyMesh(*mesh, max(meshTarget, 16u));
+            if (simplified != nullptr)
+                simplifiedAny = true;
+
+            level->meshes.emplace_back(simplified);
         }
+
+        if (simplifiedAny)
+            m_lods.push_back(move(level));
     }
 }
 
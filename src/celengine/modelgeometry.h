@@ -14,7 +14,9 @@
 #include "geometry.h"
 #include <celmodel/model.h>
 #include <celutil/resmanager.h>
+#include <Eigen/Core>
 #include <memory>
+#include <vector>
 
 
 class CelestiaTextureResource : public cmod::Material::TextureResource
@@ -30,6 +32,15 @@ public:
         return m_textureHandle;
     }
 
+    /*! Bind the texture handle after the fact. Used for models parsed on
+     *  a background thread, where texture handles can only be created
+     *  once the model is handed back to the main thread; see meshmanager.cpp.
+     */
+    void setTextureHandle(ResourceHandle textureHandle)
+    {
+        m_textureHandle = textureHandle;
+    }
+
     std::string source() const;
 
 private:
@@ -37,12 +48,13 @@ private:
 };
 
 class ModelOpenGLData;
+class ModelGeometryLevel;
 
 class ModelGeometry : public Geometry
 {
  public:
     ModelGeometry(std::unique_ptr<cmod::Model>&& model);
-    ~ModelGeometry() = default;
+    ~ModelGeometry();
 
     /*! Find the closest intersection between the ray and the
      *  model.  If the ray intersects the model, return true
@@ -54,16 +66,36 @@ class ModelGeometry : public Geometry
     //! Render the model in the current OpenGL context
     virtual void render(RenderContext&, double t = 0.0);
 
+    /*! Render one copy of the model per instance transform. Material,
+     *  vertex array, and buffer state is set up once per primitive
+     *  group and shared by all instances, so this is much cheaper than
+     *  repeated render() calls for bodies that reuse the same model.
+     *  The caller is responsible for ensuring that the render context's
+     *  lighting setup is valid for every instance.
+     */
+    void renderInstanced(RenderContext& rc,
+                         const Eigen::Matrix4f* instanceTransforms,
+                         unsigned int instanceCount,
+                         double t = 0.0);
+
     virtual bool usesTextureType(cmod::Material::TextureSemantic) const;
     virtual bool isOpaque() const;
     virtual bool isNormalized() const;
 
     void loadTextures();
 
+    /*! Generate decimated LOD meshes for large models. render() picks a
+     *  level by the projected screen size supplied through the render
+     *  context. Pure CPU work with no OpenGL dependency, so geometry
+     *  loading runs it on the background worker.
+     */
+    void buildMeshLods();
+
  private:
     std::unique_ptr<cmod::Model> m_model;
     bool m_vbInitialized{ false };
     std::unique_ptr<ModelOpenGLData> m_glData;
+    std::vector<std::unique_ptr<ModelGeometryLevel>> m_lods;
 };
 
 #endif // !_CELENGINE_MODEL_H_
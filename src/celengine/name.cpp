@@ -1,12 +1,98 @@
+#include <algorithm>
+#include <cstring>
 #include <celutil/debug.h>
 #include "name.h"
 
+namespace
+{
+
+// Case-insensitive ordering on the name component, matching the
+// CompareIgnoringCasePredicate ordering the old std::map used.
+struct NameEntryOrderingPredicate
+{
+    bool operator()(const std::pair<std::string, uint32_t>& a,
+                    const std::pair<std::string, uint32_t>& b) const
+    {
+        return compareIgnoringCase(a.first, b.first) < 0;
+    }
+};
+
+// Ordering on catalog number only; stable sorting keeps names of one
+// object in insertion order, which getFirstNameIter relies upon (the
+// proper name is listed first in the name files).
+struct NumberEntryOrderingPredicate
+{
+    bool operator()(const std::pair<uint32_t, std::string>& a,
+                    const std::pair<uint32_t, std::string>& b) const
+    {
+        return a.first < b.first;
+    }
+};
+
+} // anonymous namespace
+
+
+void NameDatabase::finalizeNames() const
+{
+    if (sortedNameCount == nameIndex.size())
+        return;
+
+    std::stable_sort(nameIndex.begin() + sortedNameCount, nameIndex.end(),
+                     NameEntryOrderingPredicate());
+    std::inplace_merge(nameIndex.begin(), nameIndex.begin() + sortedNameCount,
+                       nameIndex.end(), NameEntryOrderingPredicate());
+    sortedNameCount = nameIndex.size();
+    nameKeysValid = false;
+}
+
+
+void NameDatabase::finalizeNumbers() const
+{
+    if (sortedNumberCount == numberIndex.size())
+        return;
+
+    std::stable_sort(numberIndex.begin() + sortedNumberCount, numberIndex.end(),
+                     NumberEntryOrderingPredicate());
+    std::inplace_merge(numberIndex.begin(), numberIndex.begin() + sortedNumberCount,
+                       numberIndex.end(), NumberEntryOrderingPredicate());
+    sortedNumberCount = numberIndex.size();
+}
+
+
 uint32_t NameDatabase::getNameCount() const
 {
     return nameIndex.size();
 }
 
-void NameDatabase::add(const uint32_t catalogNumber, const std::string& name, bool replaceGreek)
+
+namespace
+{
+
+// Heap bytes behind a string: zero when the small-string optimization
+// applies, otherwise the allocated buffer (approximated by capacity).
+std::uintmax_t stringHeapBytes(const std::string& s)
+{
+    return s.capacity() < sizeof(std::string) ? 0 : s.capacity() + 1;
+}
+
+} // anonymous namespace
+
+
+std::uintmax_t NameDatabase::bytesUsed() const
+{
+    std::uintmax_t total = nameIndex.capacity() * sizeof(NameIndex::value_type) +
+                           numberIndex.capacity() * sizeof(NumberIndex::value_type) +
+                           nameKeys.capacity() * sizeof(std::string);
+    for (const auto& entry : nameIndex)
+        total += stringHeapBytes(entry.first);
+    for (const auto& entry : numberIndex)
+        total += stringHeapBytes(entry.second);
+    for (const auto& key : nameKeys)
+        total += stringHeapBytes(key);
+    return total;
+}
+
+void NameDatabase::add(const uint32_t catalogNumber, const std::string& name, bool /*parseGreek*/)
 {
     if (name.length() != 0)
     {
@@ -16,45 +102,100 @@ void NameDatabase::add(const uint32_t catalogNumber, const std::string& name, bo
             DPRINTF(LOG_LEVEL_INFO,"Duplicated name '%s' on object with catalog numbers: %d and %d\n", name.c_str(), tmp, catalogNumber);
 #endif
         // Add the new name
-        //nameIndex.insert(NameIndex::value_type(name, catalogNumber));
         std::string fname = ReplaceGreekLetterAbbr(name);
 
-        nameIndex[fname] = catalogNumber;
-        numberIndex.insert(NumberIndex::value_type(catalogNumber, fname));
+        // An existing entry for the name is overwritten, matching the
+        // old nameIndex[fname] = catalogNumber behavior.
+        NameIndex::value_type nameEntry(fname, catalogNumber);
+        auto range = std::equal_range(nameIndex.begin(), nameIndex.begin() + sortedNameCount,
+                                      nameEntry, NameEntryOrderingPredicate());
+        if (range.first != range.second)
+        {
+            range.first->second = catalogNumber;
+        }
+        else
+        {
+            auto tail = std::find_if(nameIndex.begin() + sortedNameCount, nameIndex.end(),
+                                     [&fname](const NameIndex::value_type& e)
+                                     { return compareIgnoringCase(e.first, fname) == 0; });
+            if (tail != nameIndex.end())
+            {
+                tail->second = catalogNumber;
+            }
+            else
+            {
+                nameIndex.push_back(std::move(nameEntry));
+                nameKeysValid = false;
+            }
+        }
+
+        numberIndex.emplace_back(catalogNumber, fname);
+
+        // Keep the unsorted tails short so lookups stay cheap.
+        if (nameIndex.size() - sortedNameCount > mergeThreshold)
+            finalizeNames();
+        if (numberIndex.size() - sortedNumberCount > mergeThreshold)
+            finalizeNumbers();
     }
 }
+
 void NameDatabase::erase(const uint32_t catalogNumber)
 {
-    numberIndex.erase(catalogNumber);
+    finalizeNumbers();
+
+    auto range = std::equal_range(numberIndex.begin(), numberIndex.end(),
+                                  NumberIndex::value_type(catalogNumber, std::string()),
+                                  NumberEntryOrderingPredicate());
+    if (range.first != range.second)
+    {
+        numberIndex.erase(range.first, range.second);
+        sortedNumberCount = numberIndex.size();
+    }
 }
 
 uint32_t NameDatabase::getCatalogNumberByName(const std::string& name) const
 {
-    NameIndex::const_iterator iter = nameIndex.find(name);
-
-    if (iter == nameIndex.end())
+    // Search the sorted region by binary search and the pending tail
+    // linearly; this deliberately avoids finalizing so interleaved
+    // lookups and additions during catalog loading stay cheap.
+    auto lookup = [this](const std::string& n) -> uint32_t
     {
-        iter = nameIndex.find(ReplaceGreekLetterAbbr(name));
-        if (iter == nameIndex.end())
-            return InvalidCatalogNumber;
-    }
-    return iter->second;
+        NameIndex::value_type entry(n, 0);
+        auto range = std::equal_range(nameIndex.begin(), nameIndex.begin() + sortedNameCount,
+                                      entry, NameEntryOrderingPredicate());
+        if (range.first != range.second)
+            return range.first->second;
+
+        for (auto iter = nameIndex.begin() + sortedNameCount; iter != nameIndex.end(); ++iter)
+        {
+            if (compareIgnoringCase(iter->first, n) == 0)
+                return iter->second;
+        }
+        return (uint32_t) InvalidCatalogNumber;
+    };
+
+    uint32_t catalogNumber = lookup(name);
+    if (catalogNumber == InvalidCatalogNumber)
+        catalogNumber = lookup(ReplaceGreekLetterAbbr(name));
+
+    return catalogNumber;
 }
 
 // Return the first name matching the catalog number or end()
 // if there are no matching names.  The first name *should* be the
 // proper name of the OBJ, if one exists. This requires the
 // OBJ name database file to have the proper names listed before
-// other designations.  Also, the STL implementation must
-// preserve this order when inserting the names into the multimap
-// (not certain whether or not this behavior is in the STL spec.
-// but it works on the implementations I've tried so far.)
+// other designations; the stable batch sort preserves that order.
 std::string NameDatabase::getNameByCatalogNumber(const uint32_t catalogNumber) const
 {
     if (catalogNumber == InvalidCatalogNumber)
         return "";
 
-    NumberIndex::const_iterator iter = numberIndex.lower_bound(catalogNumber);
+    finalizeNumbers();
+
+    auto iter = std::lower_bound(numberIndex.begin(), numberIndex.end(),
+                                 NumberIndex::value_type(catalogNumber, std::string()),
+                                 NumberEntryOrderingPredicate());
 
     if (iter != numberIndex.end() && iter->first == catalogNumber)
         return iter->second;
@@ -64,16 +205,16 @@ std::string NameDatabase::getNameByCatalogNumber(const uint32_t catalogNumber) c
 
 
 // Return the first name matching the catalog number or end()
-// if there are no matching names.  The first name *should* be the
-// proper name of the OBJ, if one exists. This requires the
-// OBJ name database file to have the proper names listed before
-// other designations.  Also, the STL implementation must
-// preserve this order when inserting the names into the multimap
-// (not certain whether or not this behavior is in the STL spec.
-// but it works on the implementations I've tried so far.)
+// if there are no matching names. See getNameByCatalogNumber for the
+// name ordering guarantee. The returned iterator is invalidated by
+// add() and erase().
 NameDatabase::NumberIndex::const_iterator NameDatabase::getFirstNameIter(const uint32_t catalogNumber) const
 {
-    NumberIndex::const_iterator iter = numberIndex.lower_bound(catalogNumber);
+    finalizeNumbers();
+
+    auto iter = std::lower_bound(numberIndex.begin(), numberIndex.end(),
+                                 NumberIndex::value_type(catalogNumber, std::string()),
+                                 NumberEntryOrderingPredicate());
 
     if (iter == numberIndex.end() || iter->first != catalogNumber)
         return getFinalNameIter();
@@ -96,13 +237,24 @@ std::vector<std::string> NameDatabase::getCompletion(const std::string& name, bo
     }
 
     std::vector<std::string> completion;
-    int name_length = UTF8Length(name);
+    const std::string key = UTF8NormalizedKey(name);
+
+    if (!nameKeysValid)
+    {
+        nameKeys.clear();
+        nameKeys.reserve(nameIndex.size());
+        for (const auto& entry : nameIndex)
+            nameKeys.push_back(UTF8NormalizedKey(entry.first));
+        nameKeysValid = true;
+    }
 
-    for (NameIndex::const_iterator iter = nameIndex.begin(); iter != nameIndex.end(); ++iter)
+    for (NameIndex::size_type i = 0; i < nameIndex.size(); i++)
     {
-        if (!UTF8StringCompare(iter->first, name, name_length, true))
+        const std::string& candidate = nameKeys[i];
+        if (candidate.length() >= key.length() &&
+            std::memcmp(candidate.data(), key.data(), key.length()) == 0)
         {
-            completion.push_back(iter->first);
+            completion.push_back(nameIndex[i].first);
         }
     }
     return completion;
@@ -12,9 +12,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <iostream>
-#include <map>
+#include <utility>
 #include <vector>
 #include <celutil/debug.h>
 #include <celutil/util.h>
@@ -22,11 +23,22 @@
 
 // TODO: this can be "detemplatized" by creating e.g. a global-scope enum InvalidCatalogNumber since there
 // lies the one and only need for type genericity.
+
+/*! NameDatabase stores the name <-> catalog number relation in two
+ *  sorted vectors instead of std::map/multimap: additions append to a
+ *  small unsorted tail which is merged into the sorted region in
+ *  batches, so bulk catalog loading avoids the per-insert node
+ *  allocation and pointer chasing of the tree containers, and lookups
+ *  are two cache-friendly binary searches. Methods that hand out
+ *  iterators (getFirstNameIter) or enumerate names fold the tail in
+ *  first, so returned iterators must not be held across calls to add()
+ *  or erase().
+ */
 class NameDatabase
 {
  public:
-    typedef std::map<std::string, uint32_t, CompareIgnoringCasePredicate> NameIndex;
-    typedef std::multimap<uint32_t, std::string> NumberIndex;
+    typedef std::vector<std::pair<std::string, uint32_t>> NameIndex;
+    typedef std::vector<std::pair<uint32_t, std::string>> NumberIndex;
     enum {
         InvalidCatalogNumber = 0xffffffff
     };
@@ -43,6 +55,11 @@ class NameDatabase
     void erase(const uint32_t);
 
     uint32_t      getCatalogNumberByName(const std::string&) const;
+
+    //! Approximate heap bytes used by the name indexes, for memory
+    //! accounting. String buffers beyond the small-string optimization
+    //! are counted at capacity.
+    std::uintmax_t bytesUsed() const;
     std::string getNameByCatalogNumber(const uint32_t)       const;
 
     NumberIndex::const_iterator getFirstNameIter(const uint32_t catalogNumber) const;
@@ -52,7 +69,23 @@ class NameDatabase
     std::vector<std::string> getCompletion(const std::vector<std::string> &list) const;
 
  protected:
-    NameIndex   nameIndex;
-    NumberIndex numberIndex;
-};
+    // Merge the unsorted tails into the sorted regions. Logically const:
+    // the mapping is unchanged, only its physical arrangement.
+    void finalizeNames() const;
+    void finalizeNumbers() const;
 
+    mutable NameIndex   nameIndex;
+    mutable NumberIndex numberIndex;
+    mutable NameIndex::size_type   sortedNameCount{ 0 };
+    mutable NumberIndex::size_type sortedNumberCount{ 0 };
+
+    // Normalized completion keys, parallel to nameIndex; rebuilt on the
+    // first completion request after the index changes, so per-keystroke
+    // prefix matching over the whole database is a memcmp per name
+    // instead of a character-by-character UTF-8 decode.
+    mutable std::vector<std::string> nameKeys;
+    mutable bool nameKeysValid{ false };
+
+    // Tail length at which add() folds the pending entries in eagerly.
+    static const size_t mergeThreshold = 1024;
+};
@@ -50,6 +50,7 @@ ResourceHandle Nebula::getGeometry() const
 void Nebula::setGeometry(ResourceHandle _geometry)
 {
     geometry = _geometry;
+    resolvedGeometry = nullptr;
 }
 
 const char* Nebula::getObjTypeName() const
@@ -82,18 +83,30 @@ bool Nebula::load(AssociativeArray* params, const fs::path& resPath)
 }
 
 
-void Nebula::render(const Vector3f& /*unused*/,
+void Nebula::render(const Vector3f& offset,
                     const Quaternionf& /*unused*/,
                     float /*unused*/,
                     float pixelSize,
                     const Renderer* renderer)
 {
-    Geometry* g = nullptr;
-    if (geometry != InvalidResource)
-        g = GetGeometryManager()->find(geometry);
-    if (g == nullptr)
+    // A nebula whose projected extent is below a pixel cannot
+    // contribute anything visible; skip geometry resolution and
+    // submission entirely.
+    float distance = offset.norm();
+    if (distance > 0.0f && getRadius() / distance < 0.5f * pixelSize)
         return;
 
+    // Memoize the handle resolution; only a successful lookup is
+    // cached, so geometry that hasn't finished loading is retried.
+    if (resolvedGeometry == nullptr)
+    {
+        if (geometry != InvalidResource)
+            resolvedGeometry = GetGeometryManager()->find(geometry);
+        if (resolvedGeometry == nullptr)
+            return;
+    }
+    Geometry* g = resolvedGeometry;
+
     glDisable(GL_BLEND);
 
     glScalef(getRadius(), getRadius(), getRadius());
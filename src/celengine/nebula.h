@@ -13,6 +13,8 @@
 #include <celutil/reshandle.h>
 #include <celengine/deepskyobj.h>
 
+class Geometry;
+
 class Nebula : public DeepSkyObject
 {
  public:
@@ -57,6 +59,11 @@ class Nebula : public DeepSkyObject
 
  private:
     ResourceHandle geometry{ InvalidResource };
+
+    // Memoized result of resolving the geometry handle; many nebulae
+    // share a mesh template, and looking the handle up in the geometry
+    // manager once per nebula per frame adds up in mesh-heavy scenes.
+    Geometry* resolvedGeometry{ nullptr };
 };
 
 #endif // CELENGINE_NEBULA_H_
@@ -11,6 +11,7 @@
 #include "observer.h"
 #include "simulation.h"
 #include "frametree.h"
+#include "flightpath.h"
 #include <celmath/mathlib.h>
 #include <celmath/solve.h>
 #include <celmath/geomutil.h>
@@ -259,6 +260,27 @@ void Observer::update(double dt, double timeScale)
     if (simTime <= minimumSimTime)
         simTime = minimumSimTime;
 
+    // Flight path replay overrides all other motion: the spline is
+    // evaluated directly at the elapsed real time and the result
+    // placed in universal coordinates.
+    if (replayPath != nullptr)
+    {
+        double pathTime = realTime - replayStartTime;
+
+        UniversalCoord p;
+        Quaterniond q;
+        if (replayPath->evaluate(pathTime, p, q))
+        {
+            setPosition(p);
+            setOrientation(q);
+        }
+
+        if (pathTime >= replayPath->duration())
+            replayPath = nullptr;
+
+        return;
+    }
+
     if (observerMode == Travelling)
     {
         // Compute the fraction of the trip that has elapsed; handle zero
@@ -267,7 +289,32 @@ void Observer::update(double dt, double timeScale)
         if (journey.duration > 0)
             t = (float) clamp((realTime - journey.startTime) / journey.duration);
 
-        Vector3d jv = journey.to.offsetFromKm(journey.from);
+        // Revalidate the derived journey quantities; the comparisons
+        // are cheap fixed-point equality tests and only fail on the
+        // first frame of a trip or after a frame change.
+        if (!journeyDerived.valid ||
+            !(journeyDerived.from.x == journey.from.x) ||
+            !(journeyDerived.from.y == journey.from.y) ||
+            !(journeyDerived.from.z == journey.from.z) ||
+            !(journeyDerived.to.x == journey.to.x) ||
+            !(journeyDerived.to.y == journey.to.y) ||
+            !(journeyDerived.to.z == journey.to.z) ||
+            journeyDerived.expFactor != journey.expFactor ||
+            journeyDerived.accelTime != journey.accelTime)
+        {
+            journeyDerived.from = journey.from;
+            journeyDerived.to = journey.to;
+            journeyDerived.offset = journey.to.offsetFromKm(journey.from);
+            journeyDerived.length = journeyDerived.offset.norm();
+            journeyDerived.direction = journeyDerived.length > 0.0
+                ? (journeyDerived.offset / journeyDerived.length).eval()
+                : Vector3d::Zero();
+            journeyDerived.expFactor = journey.expFactor;
+            journeyDerived.accelTime = journey.accelTime;
+            journeyDerived.coastTerm = exp(journey.expFactor * journey.accelTime);
+            journeyDerived.valid = true;
+        }
+
         UniversalCoord p;
 
         // Another interpolation method . . . accelerate exponentially,
@@ -285,20 +332,19 @@ void Observer::update(double dt, double timeScale)
             }
             else
             {
-                x = exp(journey.expFactor * journey.accelTime) *
+                x = journeyDerived.coastTerm *
                     (journey.expFactor * (u - journey.accelTime) + 1) - 1;
             }
 
             if (journey.traj == Linear)
             {
-                Vector3d v = jv;
-                if (v.norm() == 0.0)
+                if (journeyDerived.length == 0.0)
                 {
                     p = journey.from;
                 }
                 else
                 {
-                    v.normalize();
+                    const Vector3d& v = journeyDerived.direction;
                     if (t < 0.5)
                         p = journey.from.offsetKm(v * x);
                     else
@@ -326,13 +372,13 @@ void Observer::update(double dt, double timeScale)
                 Vector3d v0 = ufrom.offsetFromKm(origin);
                 Vector3d v1 = uto.offsetFromKm(origin);
 
-                if (jv.norm() == 0.0)
+                if (journeyDerived.length == 0.0)
                 {
                     p = journey.from;
                 }
                 else
                 {
-                    x /= jv.norm();
+                    x /= journeyDerived.length;
                     Vector3d v;
 
                     if (t < 0.5)
@@ -354,7 +400,7 @@ void Observer::update(double dt, double timeScale)
                 Vector3d v0 = ufrom.offsetFromKm(origin);
                 //Vector3d v1 = uto.offsetFromKm(origin);
 
-                if (jv.norm() == 0.0)
+                if (journeyDerived.length == 0.0)
                 {
                     p = journey.from;
                 }
@@ -451,6 +497,73 @@ void Observer::update(double dt, double timeScale)
 
         setOrientation(LookAt<double>(Vector3d::Zero(), viewDir, up));
     }
+
+    // Sample the flight recording after all motion for this tick has
+    // been applied.
+    if (recordingPath != nullptr && realTime - lastRecordTime >= recordInterval)
+    {
+        recordingPath->addSample(realTime - recordStartTime,
+                                 getPosition(), getOrientation());
+        lastRecordTime = realTime;
+    }
+}
+
+
+void Observer::beginRecording(double sampleInterval)
+{
+    recordingPath = make_shared<FlightPath>();
+    recordInterval = sampleInterval;
+    recordStartTime = realTime;
+
+    // Capture the starting keyframe immediately; later samples are
+    // taken in update().
+    recordingPath->addSample(0.0, getPosition(), getOrientation());
+    lastRecordTime = realTime;
+}
+
+
+shared_ptr<FlightPath> Observer::endRecording()
+{
+    shared_ptr<FlightPath> path = recordingPath;
+    recordingPath = nullptr;
+
+    // Close the recording with the current state, so short final
+    // segments aren't lost to the sampling interval.
+    if (path != nullptr && realTime > lastRecordTime)
+        path->addSample(realTime - recordStartTime, getPosition(), getOrientation());
+
+    return path;
+}
+
+
+bool Observer::isRecording() const
+{
+    return recordingPath != nullptr;
+}
+
+
+void Observer::playFlightPath(const shared_ptr<const FlightPath>& path)
+{
+    if (path == nullptr || path->sampleCount() == 0)
+        return;
+
+    cancelMotion();
+    setVelocity(Vector3d::Zero());
+    setAngularVelocity(Vector3d::Zero());
+    replayPath = path;
+    replayStartTime = realTime;
+}
+
+
+void Observer::stopFlightPath()
+{
+    replayPath = nullptr;
+}
+
+
+bool Observer::isReplayingFlightPath() const
+{
+    return replayPath != nullptr;
 }
 
 
@@ -737,6 +850,12 @@ Observer::ObserverMode Observer::getMode() const
 }
 
 
+UniversalCoord Observer::getJourneyDestination() const
+{
+    return frame->convertToUniversal(journey.to, getTime());
+}
+
+
 void Observer::setMode(Observer::ObserverMode mode)
 {
     observerMode = mode;
@@ -18,12 +18,15 @@
 #ifndef _CELENGINE_OBSERVER_H_
 #define _CELENGINE_OBSERVER_H_
 
+#include <memory>
 #include <celmath/mathlib.h>
 #include <celengine/frame.h>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include "shared.h"
 
+class FlightPath;
+
 class ObserverFrame
 {
 public:
@@ -222,6 +225,10 @@ public:
     ObserverMode getMode() const;
     void setMode(ObserverMode);
 
+    //! Destination of the journey in progress, in universal
+    //! coordinates; only meaningful while getMode() is Travelling.
+    UniversalCoord getJourneyDestination() const;
+
     enum TrajectoryType
     {
         Linear        = 0,
@@ -252,6 +259,22 @@ public:
     void gotoJourney(const JourneyParams&);
     // void setSimulation(Simulation* _sim) { sim = _sim; };
 
+    //! Start recording the observer's flight: the universal position
+    //! and orientation are sampled every sampleInterval seconds of
+    //! real time as keyframes of a FlightPath.
+    void beginRecording(double sampleInterval = 0.2);
+    //! Stop recording and return the recorded path, or nullptr if no
+    //! recording was in progress.
+    std::shared_ptr<FlightPath> endRecording();
+    bool isRecording() const;
+
+    //! Replay a recorded flight path from its beginning; any goto in
+    //! progress is cancelled and manual control is suspended until the
+    //! path ends or stopFlightPath() is called.
+    void playFlightPath(const std::shared_ptr<const FlightPath>& path);
+    void stopFlightPath();
+    bool isReplayingFlightPath() const;
+
  private:
     void computeGotoParameters(const Selection &sel,
                                JourneyParams &jparams,
@@ -307,6 +330,27 @@ public:
 
     ObserverMode     	observerMode{ Free };
     JourneyParams    	journey;
+
+    // Quantities derived from the journey parameters that are constant
+    // for the whole trip. update() revalidates them against the
+    // endpoints (a goto start or a frame change rewrites journey.from
+    // and journey.to) instead of redoing the UniversalCoord arithmetic
+    // and normalization every frame.
+    struct JourneyDerived
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+        UniversalCoord from;
+        UniversalCoord to;
+        Eigen::Vector3d offset{ 0.0, 0.0, 0.0 };
+        Eigen::Vector3d direction{ 0.0, 0.0, 0.0 };
+        double length{ 0.0 };
+        double expFactor{ 0.0 };
+        double accelTime{ 0.0 };
+        double coastTerm{ 0.0 };
+        bool valid{ false };
+    };
+    JourneyDerived   	journeyDerived;
+
     Selection        	trackObject;
 
     Eigen::Quaterniond 	trackingOrientation{ Eigen::Quaternionf::Identity() };   // orientation prior to selecting tracking
@@ -316,6 +360,17 @@ public:
 
     uint64_t locationFilter{ ~0ull };
     std::string displayedSurface;
+
+    // Flight recording and replay state; see beginRecording() and
+    // playFlightPath(). Sample times are kept relative to the start of
+    // the recording so paths replay from any real time.
+    std::shared_ptr<FlightPath> recordingPath;
+    double recordInterval{ 0.0 };
+    double recordStartTime{ 0.0 };
+    double lastRecordTime{ 0.0 };
+
+    std::shared_ptr<const FlightPath> replayPath;
+    double replayStartTime{ 0.0 };
 };
 
 #endif // _CELENGINE_OBSERVER_H_
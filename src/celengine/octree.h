@@ -16,6 +16,7 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <celengine/observer.h>
+#include <future>
 #include <vector>
 
 // The DynamicOctree and StaticOctree template arguments are:
@@ -25,11 +26,27 @@
 // OBJ's limiting property defined by the octree particular specialization: ie. we use [absolute magnitude] for star octrees, etc.
 // For details, see notes below.
 
+//! A cell visited by one traversal, captured for the octree heatmap.
+//! Center and scale (half the cell's edge length) are in the tree's
+//! own units, reduced to single precision for rendering.
+struct OctreeVisitedCell
+{
+    Eigen::Vector3f center;
+    float scale;
+    unsigned int objects;
+};
+
 struct OctreeProcStats
 {
     size_t nodes { 0 };
     size_t height { 0 };
     size_t objects { 0 };
+    double timeMs { 0.0 };
+
+    // When non-null, every node the traversal visits appends its cell
+    // here; the renderer clears and rebinds the vector each frame
+    // while the octree heatmap is shown.
+    std::vector<OctreeVisitedCell>* visitedCells { nullptr };
 };
 
 template <class OBJ, class PREC> class OctreeProcessor
@@ -72,10 +89,23 @@ private:
 
     void insertObject  (const OBJ&, const PREC);
     void rebuildAndSort(StaticOctree<OBJ, PREC>*&, OBJ*&);
+    unsigned int countObjects() const;
+
+    //! Set the number of objects a node may hold before it is split.
+    //! Catalog loaders tune this to the catalog density before
+    //! building: denser catalogs get larger nodes, which keeps the
+    //! node count (and traversal cost) from growing linearly with the
+    //! catalog.
+    static void setSplitThreshold(unsigned int t) { SPLIT_THRESHOLD = t; }
 
  private:
    static unsigned int SPLIT_THRESHOLD;
 
+   // Subtrees holding at least this many objects are compiled as
+   // independent tasks during rebuildAndSort; smaller ones aren't worth
+   // the scheduling overhead.
+   static const unsigned int PARALLEL_REBUILD_THRESHOLD = 65536;
+
    static LimitingFactorPredicate*      limitingFactorPredicate;
    static StraddlingPredicate*          straddlingPredicate;
    static ExclusionFactorDecayFunction* decayFunction;
@@ -138,6 +168,30 @@ template <class OBJ, class PREC> class StaticOctree
 
     void computeStatistics(std::vector<OctreeLevelStatistics>& stats, unsigned int level = 0);
 
+    // Structural accessors used by flat (de)serialization of prebuilt
+    // octrees; child(i) is only valid when hasChildren() returns true.
+    const PointType& cellCenter() const        { return cellCenterPos; }
+    float getExclusionFactor() const           { return exclusionFactor; }
+    OBJ* firstObject() const                   { return _firstObject; }
+    unsigned int objectCount() const           { return nObjects; }
+    bool hasChildren() const                   { return _children != nullptr; }
+    const StaticOctree* child(unsigned int i) const { return _children[i]; }
+    StaticOctree* child(unsigned int i)             { return _children[i]; }
+
+    // The exclusion factor is a construction-time upper bound on how
+    // bright objects in the subtree may be; the brightest factor is the
+    // limiting property of the brightest object actually stored in the
+    // subtree, recorded by a post-build pass. Traversals that prune on
+    // it cut off much earlier in sparse regions of a catalog.
+    float getBrightestFactor() const           { return brightestFactor; }
+    void setBrightestFactor(float f)           { brightestFactor = f; }
+
+    /*! Attach a block of eight children to a node built by a
+     *  deserializer. The node takes ownership of the array and the
+     *  children.
+     */
+    void setChildren(StaticOctree** children)  { _children = children; }
+
  private:
     static const PREC SQRT3;
 
@@ -145,6 +199,7 @@ template <class OBJ, class PREC> class StaticOctree
     StaticOctree** _children;
     Eigen::Matrix<PREC, 3, 1>   cellCenterPos;
     float          exclusionFactor;
+    float          brightestFactor;
     OBJ*           _firstObject;
     unsigned int   nObjects;
 };
@@ -294,6 +349,25 @@ inline void DynamicOctree<OBJ, PREC>::sortIntoChildNodes()
 }
 
 
+template <class OBJ, class PREC>
+inline unsigned int DynamicOctree<OBJ, PREC>::countObjects() const
+{
+    unsigned int count = _objects != nullptr ? (unsigned int) _objects->size() : 0;
+
+    if (_children != nullptr)
+        for (int i = 0; i < 8; ++i)
+            count += _children[i]->countObjects();
+
+    return count;
+}
+
+
+// The eight child subtrees of a node write into disjoint ranges of the
+// sorted-objects array, so they can be compiled into StaticOctree nodes
+// concurrently once the ranges have been pre-partitioned by object count.
+// Large subtrees are dispatched as asynchronous tasks; small ones are
+// processed inline, which keeps the task count proportional to the number
+// of cores actually worth using.
 template <class OBJ, class PREC>
 inline void DynamicOctree<OBJ, PREC>::rebuildAndSort(StaticOctree<OBJ, PREC>*& _staticNode, OBJ*& _sortedObjects)
 {
@@ -312,8 +386,55 @@ inline void DynamicOctree<OBJ, PREC>::rebuildAndSort(StaticOctree<OBJ, PREC>*& _
     {
         _staticNode->_children    = new StaticOctree<OBJ, PREC>*[8];
 
+        // Pre-partition the output array among the children. The counting
+        // pass is cheap relative to node construction and only performed
+        // where tasks may actually be spawned.
+        unsigned int childCounts[8];
+        bool anyParallel = false;
         for (int i=0; i<8; ++i)
-            _children[i]->rebuildAndSort(_staticNode->_children[i], _sortedObjects);
+        {
+            childCounts[i] = _children[i]->countObjects();
+            if (childCounts[i] >= PARALLEL_REBUILD_THRESHOLD)
+                anyParallel = true;
+        }
+
+        if (!anyParallel)
+        {
+            for (int i=0; i<8; ++i)
+                _children[i]->rebuildAndSort(_staticNode->_children[i], _sortedObjects);
+        }
+        else
+        {
+            std::future<void> tasks[8];
+            OBJ* childStart = _sortedObjects;
+            for (int i=0; i<8; ++i)
+            {
+                DynamicOctree* child = _children[i];
+                StaticOctree<OBJ, PREC>** staticChild = &_staticNode->_children[i];
+                if (childCounts[i] >= PARALLEL_REBUILD_THRESHOLD)
+                {
+                    tasks[i] = std::async(std::launch::async,
+                                          [child, staticChild, childStart]()
+                                          {
+                                              OBJ* cursor = childStart;
+                                              child->rebuildAndSort(*staticChild, cursor);
+                                          });
+                }
+                else
+                {
+                    OBJ* cursor = childStart;
+                    child->rebuildAndSort(*staticChild, cursor);
+                }
+                childStart += childCounts[i];
+            }
+
+            for (int i=0; i<8; ++i)
+            {
+                if (tasks[i].valid())
+                    tasks[i].get();
+            }
+            _sortedObjects = childStart;
+        }
     }
 }
 
@@ -331,6 +452,7 @@ inline StaticOctree<OBJ, PREC>::StaticOctree(const Eigen::Matrix<PREC, 3, 1>& ce
     _children      (nullptr),
     cellCenterPos  (cellCenterPos),
     exclusionFactor(exclusionFactor),
+    brightestFactor(exclusionFactor),
     _firstObject   (_firstObject),
     nObjects       (nObjects)
 {
@@ -70,9 +70,11 @@ void OpenCluster::render(const Vector3f& /*unused*/,
                          const Renderer* /*unused*/)
 {
     // Nothing to do right now; open clusters are only visible as their
-    // constituent stars and a label when labels are turned on.  A good idea
-    // would be to add an 'sky chart' mode, in which clusters are rendered as
-    // circles.
+    // constituent stars and a label when labels are turned on.  The
+    // member stars go through the regular point-star batching path, so
+    // there is deliberately no cluster-specific sprite submission to
+    // maintain here.  A good idea would be to add an 'sky chart' mode,
+    // in which clusters are rendered as circles.
 }
 
 
@@ -51,6 +51,7 @@ void Overlay::begin()
 
 void Overlay::end()
 {
+    flushText();
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
@@ -68,6 +69,7 @@ void Overlay::setFont(TextureFont* f)
 {
     if (f != font)
     {
+        flushText();
         font = f;
         fontChanged = true;
     }
@@ -76,12 +78,14 @@ void Overlay::setFont(TextureFont* f)
 
 void Overlay::beginText()
 {
+    flushText();
     glPushMatrix();
     textBlock++;
 }
 
 void Overlay::endText()
 {
+    flushText();
     if (textBlock > 0)
     {
         textBlock--;
@@ -91,53 +95,44 @@ void Overlay::endText()
 }
 
 
-void Overlay::print(wchar_t c)
+void Overlay::flushText()
 {
-    if (font != nullptr)
+    if (pendingText.empty() || font == nullptr)
     {
-        if (!useTexture || fontChanged)
-        {
-            glEnable(GL_TEXTURE_2D);
-            font->bind();
-            useTexture = true;
-            fontChanged = false;
-        }
+        pendingText.clear();
+        return;
+    }
 
-        switch (c)
-        {
-        case '\n':
-            if (textBlock > 0)
-            {
-                glPopMatrix();
-                glTranslatef(0.0f, (float) -(1 + font->getHeight()), 0.0f);
-                xoffset = 0.0f;
-                glPushMatrix();
-            }
-            break;
-        default:
-            font->render(c, xoffset, yoffset);
-            xoffset += font->getAdvance(c);
-            break;
-        }
+    // The run cache keys on content, so a HUD line whose text did not
+    // change since the previous frame skips shaping and tessellation
+    // entirely and costs a single vertex-array draw. Shape before
+    // binding: the TrueType backend may grow its atlas while shaping,
+    // replacing the texture object.
+    const TextureFont::GlyphRun& run =
+        font->getGlyphRun(pendingText.c_str(), (int) pendingText.length());
+
+    if (!useTexture || fontChanged)
+    {
+        glEnable(GL_TEXTURE_2D);
+        useTexture = true;
+        fontChanged = false;
     }
+    font->bind();
+    font->renderGlyphRun(run, xoffset, yoffset);
+    xoffset += (float) run.width;
+
+    pendingText.clear();
 }
 
 
-void Overlay::print(char c)
+void Overlay::print(wchar_t c)
 {
     if (font != nullptr)
     {
-        if (!useTexture || fontChanged)
-        {
-            glEnable(GL_TEXTURE_2D);
-            font->bind();
-            useTexture = true;
-            fontChanged = false;
-        }
-
         switch (c)
         {
         case '\n':
+            flushText();
             if (textBlock > 0)
             {
                 glPopMatrix();
@@ -147,13 +142,22 @@ void Overlay::print(char c)
             }
             break;
         default:
-            font->render(c, xoffset, yoffset);
-            xoffset += font->getAdvance(c);
+            {
+                char encoded[8];
+                int len = UTF8Encode(c, encoded);
+                pendingText.append(encoded, len);
+            }
             break;
         }
     }
 }
 
+
+void Overlay::print(char c)
+{
+    print((wchar_t) (unsigned char) c);
+}
+
 void Overlay::print(const char* s)
 {
     int length = strlen(s);
@@ -170,6 +174,7 @@ void Overlay::print(const char* s)
 
 void Overlay::drawRectangle(const Rect& r)
 {
+    flushText();
     if (useTexture && r.tex == nullptr)
     {
         glDisable(GL_TEXTURE_2D);
@@ -179,18 +184,21 @@ void Overlay::drawRectangle(const Rect& r)
     renderer.drawRectangle(r);
 }
 
-void Overlay::setColor(float r, float g, float b, float a) const
+void Overlay::setColor(float r, float g, float b, float a)
 {
+    flushText();
     glColor4f(r, g, b, a);
 }
 
-void Overlay::setColor(const Color& c) const
+void Overlay::setColor(const Color& c)
 {
+    flushText();
     glColor4f(c.red(), c.green(), c.blue(), c.alpha());
 }
 
-void Overlay::moveBy(float dx, float dy, float dz) const
+void Overlay::moveBy(float dx, float dy, float dz)
 {
+    flushText();
     glTranslatef(dx, dy, dz);
 }
 
@@ -66,16 +66,21 @@ class Overlay : public std::ostream
     void setWindowSize(int, int);
     void setFont(TextureFont*);
 
-    void setColor(float r, float g, float b, float a) const;
-    void setColor(const Color& c) const;
-
-    void moveBy(float dx, float dy, float dz = 0.0f) const;
-    void savePos() const
+    // These all flush any pending text run first: glyphs are retained
+    // until the color, transform or draw state changes so that an
+    // unbroken run renders as one cached batch.
+    void setColor(float r, float g, float b, float a);
+    void setColor(const Color& c);
+
+    void moveBy(float dx, float dy, float dz = 0.0f);
+    void savePos()
     {
+        flushText();
         glPushMatrix();
     };
-    void restorePos() const
+    void restorePos()
     {
+        flushText();
         glPopMatrix();
     };
     const Renderer& getRenderer() const
@@ -92,6 +97,10 @@ class Overlay : public std::ostream
     void print(const char*);
 
  private:
+    //! Render the accumulated text run through the font's cached
+    //! glyph-run path. Runs are keyed by content, so text that did not
+    //! change between frames is not re-shaped, only re-drawn.
+    void flushText();
     int windowWidth{ 1 };
     int windowHeight{ 1 };
     TextureFont* font{ nullptr };
@@ -102,6 +111,9 @@ class Overlay : public std::ostream
     float xoffset{ 0.0f };
     float yoffset{ 0.0f };
 
+    // Text accumulated since the last state change, in UTF-8.
+    std::string pendingText;
+
     float lineWidth { 1.0f };
 
     OverlayStreamBuf sbuf;
@@ -256,11 +256,17 @@ CreateSampledTrajectory(Hash* trajData, const fs::path& path)
 
     DPRINTF(LOG_LEVEL_INFO, "Attempting to load sampled trajectory from source '%s'\n", sourceName.c_str());
     ResourceHandle orbitHandle = GetTrajectoryManager()->getHandle(TrajectoryInfo(sourceName, path, interpolation, precision));
-    Orbit* orbit = GetTrajectoryManager()->find(orbitHandle);
+    Orbit* orbit = GetTrajectoryManager()->fetch(orbitHandle);
     if (orbit == nullptr)
     {
         clog << "Could not load sampled trajectory from '" << sourceName << "'\n";
     }
+    else
+    {
+        // The timeline keeps this pointer for the life of the body; pin
+        // the trajectory so the resource budget doesn't evict it.
+        GetTrajectoryManager()->addRef(orbit);
+    }
 
     return orbit;
 }
@@ -499,7 +505,17 @@ CreateSpiceOrbit(Hash* orbitData,
                                boundingRadius);
     }
 
-    if (!orbit->init(path, &kernelList))
+    // With AsyncLoad, kernels are furnished on a background thread and
+    // the body is shown at its fallback position until loading
+    // completes. Note that load failures can then no longer be detected
+    // here, so any fallback trajectory in the SSC file is not used.
+    bool loadAsync = false;
+    orbitData->getBoolean("AsyncLoad", loadAsync);
+    if (loadAsync)
+    {
+        orbit->initAsync(path, &kernelList);
+    }
+    else if (!orbit->init(path, &kernelList))
     {
         // Error using SPICE library; destroy the orbit; hopefully a
         // fallback is defined in the SSC file.
@@ -750,9 +766,11 @@ CreateOrbit(const Selection& centralObject,
                                                              path,
                                                              TrajectoryInterpolationCubic,
                                                              TrajectoryPrecisionSingle));
-        orbit = GetTrajectoryManager()->find(orbitHandle);
+        orbit = GetTrajectoryManager()->fetch(orbitHandle);
         if (orbit != nullptr)
         {
+            // Pinned for the same reason as in CreateSampledTrajectory
+            GetTrajectoryManager()->addRef(orbit);
             return orbit;
         }
         clog << "Could not load sampled orbit file '" << sampOrbitFile << "'\n";
@@ -1116,9 +1134,11 @@ CreateRotationModel(Hash* planetData,
                 sampOrientationFile.c_str());
         ResourceHandle orientationHandle =
             GetRotationModelManager()->getHandle(RotationModelInfo(sampOrientationFile, path));
-        rotationModel = GetRotationModelManager()->find(orientationHandle);
+        rotationModel = GetRotationModelManager()->fetch(orientationHandle);
         if (rotationModel != nullptr)
         {
+            // Pinned for the same reason as sampled trajectories
+            GetRotationModelManager()->addRef(rotationModel);
             return rotationModel;
         }
 
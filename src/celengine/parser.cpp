@@ -10,12 +10,107 @@
 
 #include "parser.h"
 #include "astro.h"
+#include <celutil/alloctag.h>
 #include <celutil/util.h>
 
 using namespace Eigen;
 using namespace celmath;
 
 
+/****** Pooled allocation for parser node types ******/
+
+// While a pooled readValue call is in progress, Value and
+// AssociativeArray nodes (and the string payloads owned by Values) are
+// bump-allocated from the owning Parser's MemoryPool. Each allocation
+// is prefixed with the pool that produced it -- null for the global
+// heap -- so that delete behaves identically for pooled and heap nodes:
+// destructors always run, and only heap-backed memory is returned to
+// the global allocator. Pooled memory is reclaimed in bulk when the
+// pool is freed.
+//
+// ssc files are parsed on multiple worker threads, each with a pool of
+// its own, so the active pool designation is thread-local.
+static thread_local MemoryPool* activeValuePool = nullptr;
+
+// Room for the pool pointer, padded so the node keeps the pool's
+// allocation alignment.
+static const std::size_t ValueNodeHeaderSize = 16;
+
+static void* allocValueNode(std::size_t size)
+{
+    void* memory = nullptr;
+    if (activeValuePool != nullptr)
+        memory = activeValuePool->allocate((unsigned int) (size + ValueNodeHeaderSize));
+
+    if (memory != nullptr)
+    {
+        *static_cast<MemoryPool**>(memory) = activeValuePool;
+    }
+    else
+    {
+        // No active pool, or the request exceeded the pool's block size.
+        memory = ::operator new(size + ValueNodeHeaderSize);
+        *static_cast<MemoryPool**>(memory) = nullptr;
+    }
+
+    return static_cast<char*>(memory) + ValueNodeHeaderSize;
+}
+
+static void freeValueNode(void* ptr)
+{
+    if (ptr == nullptr)
+        return;
+
+    char* memory = static_cast<char*>(ptr) - ValueNodeHeaderSize;
+    if (*reinterpret_cast<MemoryPool**>(memory) == nullptr)
+        ::operator delete(memory);
+    // Pool-backed nodes are reclaimed en masse by the pool.
+}
+
+// Designate the pool that node allocations draw from for the duration
+// of a readValue call, including its recursion through arrays and
+// hashes. Restores the previous designation on exit so nested parsers
+// compose.
+class ActiveValuePoolScope
+{
+public:
+    ActiveValuePoolScope(MemoryPool* pool) :
+        previous(activeValuePool)
+    {
+        if (pool != nullptr)
+            activeValuePool = pool;
+    }
+
+    ~ActiveValuePoolScope()
+    {
+        activeValuePool = previous;
+    }
+
+private:
+    MemoryPool* previous;
+};
+
+void* Value::operator new(std::size_t size)
+{
+    return allocValueNode(size);
+}
+
+void Value::operator delete(void* ptr)
+{
+    freeValueNode(ptr);
+}
+
+void* AssociativeArray::operator new(std::size_t size)
+{
+    return allocValueNode(size);
+}
+
+void AssociativeArray::operator delete(void* ptr)
+{
+    freeValueNode(ptr);
+}
+
+
 /****** Value method implementations *******/
 
 Value::Value(double d)
@@ -27,7 +122,7 @@ Value::Value(double d)
 Value::Value(const string& s)
 {
     type = StringType;
-    data.s = new string(s);
+    data.s = new (allocValueNode(sizeof(string))) string(s);
 }
 
 Value::Value(ValueArray* a)
@@ -52,7 +147,8 @@ Value::~Value()
 {
     if (type == StringType)
     {
-        delete data.s;
+        data.s->~string();
+        freeValueNode(data.s);
     }
     else if (type == ArrayType)
     {
@@ -91,7 +187,7 @@ double Value::getNumber() const
     return data.d;
 }
 
-string Value::getString() const
+const string& Value::getString() const
 {
     // ASSERT(type == StringType);
     return *data.s;
@@ -115,11 +211,52 @@ bool Value::getBoolean() const
     return (data.d != 0.0);
 }
 
+Value* Value::clone() const
+{
+    switch (type)
+    {
+    case NumberType:
+        return new Value(data.d);
+
+    case StringType:
+        return new Value(*data.s);
+
+    case BooleanType:
+        return new Value(data.d != 0.0);
+
+    case ArrayType:
+        {
+            auto* array = new ValueArray();
+            if (data.a != nullptr)
+            {
+                array->reserve(data.a->size());
+                for (const auto v : *data.a)
+                    array->push_back(v->clone());
+            }
+            return new Value(array);
+        }
+
+    case HashType:
+        {
+            auto* hash = new Hash();
+            if (data.h != nullptr)
+            {
+                for (HashIterator iter = data.h->begin(); iter != data.h->end(); ++iter)
+                    hash->addValue(iter->first, *iter->second->clone());
+            }
+            return new Value(hash);
+        }
+    }
+
+    return nullptr;
+}
+
 
 /****** Parser method implementation ******/
 
-Parser::Parser(Tokenizer* _tokenizer) :
-    tokenizer(_tokenizer)
+Parser::Parser(Tokenizer* _tokenizer, MemoryPool* _valuePool) :
+    tokenizer(_tokenizer),
+    valuePool(_valuePool)
 {
 }
 
@@ -257,6 +394,9 @@ bool Parser::readUnits(const string& propertyName, Hash* hash)
 
 Value* Parser::readValue()
 {
+    ActiveValuePoolScope poolScope(valuePool);
+    AllocTagScope allocTag("parse");
+
     Tokenizer::TokenType tok = tokenizer->nextToken();
     switch (tok)
     {
@@ -15,6 +15,7 @@
 #include <map>
 #include <celmath/mathlib.h>
 #include <celutil/color.h>
+#include <celutil/memorypool.h>
 #include <celcompat/filesystem.h>
 #include <celengine/tokenizer.h>
 #include <Eigen/Core>
@@ -30,6 +31,10 @@ class AssociativeArray
     AssociativeArray() = default;
     ~AssociativeArray();
 
+    // Pool-aware allocation; see Value::operator new below.
+    void* operator new(std::size_t);
+    void operator delete(void*);
+
     Value* getValue(const std::string&) const;
     void addValue(const std::string&, Value&);
 
@@ -92,10 +97,28 @@ public:
     Value(bool);
     ~Value();
 
+    //! Deep copy of this value and everything below it. Allocations
+    //! follow the usual rules: they come from the active parser arena
+    //! while a pooled readValue is in progress, and from the global
+    //! heap otherwise. Used to detach a subtree from an arena-backed
+    //! catalog tree so it can outlive the arena.
+    Value* clone() const;
+
+    // Parsing a large catalog creates an enormous number of small Value
+    // and AssociativeArray nodes which are discarded as soon as each
+    // object definition has been applied. When the Parser was given a
+    // MemoryPool, nodes are bump-allocated from it and their memory is
+    // reclaimed in bulk when the pool is freed; every node records its
+    // origin in a small header, so delete remains valid for all nodes
+    // (destructors still run, and only heap-backed memory is returned
+    // to the global allocator).
+    void* operator new(std::size_t);
+    void operator delete(void*);
+
     ValueType getType() const;
 
     double getNumber() const;
-    string getString() const;
+    const string& getString() const;
     ValueArray* getArray() const;
     Hash* getHash() const;
     bool getBoolean() const;
@@ -115,12 +138,21 @@ private:
 class Parser
 {
 public:
-    Parser(Tokenizer*);
+    //! When a MemoryPool is supplied, the Value and AssociativeArray
+    //! nodes produced by readValue are allocated from it instead of
+    //! individually from the heap. The resulting trees are used exactly
+    //! as before -- delete still runs destructors and releases their
+    //! heap-owned internals -- but the node memory itself is reclaimed
+    //! in bulk when the pool is freed, which must happen only once the
+    //! trees are no longer referenced. The pool is not owned by the
+    //! Parser; catalog loaders typically keep one per file.
+    Parser(Tokenizer*, MemoryPool* valuePool = nullptr);
 
     Value* readValue();
 
 private:
     Tokenizer* tokenizer;
+    MemoryPool* valuePool;
 
     bool readUnits(const std::string&, Hash*);
     ValueArray* readArray();
@@ -10,15 +10,18 @@
 // of the License, or (at your option) any later version.
 
 #include "celutil/util.h"
+#include "celutil/debug.h"
 #include <cmath>
 #include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <limits>
+#include <vector>
 #include "modelgeometry.h"
 #include "particlesystem.h"
 #include <GL/glew.h>
 #include "vecgl.h"
+#include "glshader.h"
 #include "rendcontext.h"
 #include "texmanager.h"
 
@@ -75,6 +78,17 @@ using namespace std;
  *  be every time a particle is to be drawn. The well-known defects in
  *  pseudorandom sequences produced by an LCG are not visible in a particle
  *  system (and lack of apparent visual artifacts is the *only* requirement here.)
+ *
+ *  GPU EVALUATION
+ *  Statelessness also makes the system a perfect fit for the GPU: a
+ *  particle's state at any time is a pure function of its initial position,
+ *  velocity, rotation rate and age. An emitter therefore generates its
+ *  steady-state pool of rate * lifetime particles once, uploads it to a
+ *  static vertex buffer, and a vertex shader computes position, size and
+ *  color for the current time. Each pool slot is reborn every pool period
+ *  retracing the same trajectory, which keeps the buffer immutable; the
+ *  per-frame CPU cost is a few uniforms and one point-sprite draw call no
+ *  matter how many particles are alive.
  */
 
 // Same values as rand48()
@@ -88,7 +102,7 @@ static const uint64_t M = ((uint64_t) 1 << 48) - 1;
 class LCGRandomGenerator
 {
 public:
-    LCGRandomGenerator() : previous(0) = default;
+    LCGRandomGenerator() : previous(0) {}
 
     LCGRandomGenerator(uint64_t seed) :
         previous(seed)
@@ -251,6 +265,9 @@ ParticleEmitter::~ParticleEmitter()
 {
     delete m_positionGenerator;
     delete m_velocityGenerator;
+
+    if (m_vbo != 0)
+        glDeleteBuffers(1, &m_vbo);
 }
 
 
@@ -288,11 +305,202 @@ ParticleEmitter::setBlendMode(cmod::Material::BlendMode blendMode)
 
 static const uint64_t scrambleMask = (uint64_t(0xcccccccc) << 32) | 0xcccccccc;
 
+// Upper bound on pool slots per emitter; above this the emission rate
+// is effectively reduced and a warning is logged.
+static const unsigned int MaxPoolSize = 8 * 1024 * 1024;
+
+
+// Evaluates one pool slot for the current time. All time uniforms are
+// pre-wrapped on the CPU into [0, poolDuration), so single precision
+// is sufficient no matter how large the simulation time gets. Dead
+// slots (recycling gap, before emitter start, after emitter stop) are
+// clipped away by moving the point behind the far plane.
+static const char* particleVertexShaderSource =
+    "#version 120\n"
+    "uniform float wrappedTime;\n"
+    "uniform float poolDuration;\n"
+    "uniform float lifetime;\n"
+    "uniform float minAge;\n"
+    "uniform float maxAge;\n"
+    "uniform vec3 acceleration;\n"
+    "uniform vec4 startColor;\n"
+    "uniform vec4 endColor;\n"
+    "uniform float startSize;\n"
+    "uniform float endSize;\n"
+    "uniform float pointScale;\n"
+    "varying float rotation;\n"
+    "void main()\n"
+    "{\n"
+    "    float phase = gl_MultiTexCoord0.x;\n"
+    "    float rotationRate = gl_MultiTexCoord0.y;\n"
+    "    float age = mod(wrappedTime - phase * poolDuration, poolDuration);\n"
+    "    if (age < minAge || age >= maxAge)\n"
+    "    {\n"
+    "        gl_Position = vec4(0.0, 0.0, 2.0, 1.0);\n"
+    "        gl_PointSize = 1.0;\n"
+    "        gl_FrontColor = vec4(0.0);\n"
+    "        rotation = 0.0;\n"
+    "        return;\n"
+    "    }\n"
+    "    float alpha = age / lifetime;\n"
+    "    vec3 center = gl_Vertex.xyz + gl_Normal * age + acceleration * (age * age);\n"
+    "    vec4 eyePos = gl_ModelViewMatrix * vec4(center, 1.0);\n"
+    "    gl_Position = gl_ProjectionMatrix * eyePos;\n"
+    "    float size = mix(startSize, endSize, alpha);\n"
+    "    gl_PointSize = pointScale * size / max(-eyePos.z, 1.0e-6);\n"
+    "    gl_FrontColor = mix(startColor, endColor, alpha);\n"
+    "    rotation = rotationRate * age;\n"
+    "}\n";
+
+static const char* particleFragmentShaderSource =
+    "#version 120\n"
+    "uniform sampler2D particleTex;\n"
+    "uniform float useTexture;\n"
+    "varying float rotation;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 texColor = vec4(1.0);\n"
+    "    if (useTexture > 0.5)\n"
+    "    {\n"
+    "        float c = cos(rotation);\n"
+    "        float s = sin(rotation);\n"
+    "        vec2 tc = gl_PointCoord - vec2(0.5, 0.5);\n"
+    "        tc = vec2(c * tc.x - s * tc.y, s * tc.x + c * tc.y) + vec2(0.5, 0.5);\n"
+    "        texColor = texture2D(particleTex, tc);\n"
+    "    }\n"
+    "    gl_FragColor = gl_Color * texColor;\n"
+    "}\n";
+
+
+// One program shared by every emitter; emitters differ only in
+// uniforms and the bound pool buffer.
+struct ParticleProgram
+{
+    GLProgram* program{ nullptr };
+    FloatShaderParameter wrappedTime;
+    FloatShaderParameter poolDuration;
+    FloatShaderParameter lifetime;
+    FloatShaderParameter minAge;
+    FloatShaderParameter maxAge;
+    Vec3ShaderParameter acceleration;
+    Vec4ShaderParameter startColor;
+    Vec4ShaderParameter endColor;
+    FloatShaderParameter startSize;
+    FloatShaderParameter endSize;
+    FloatShaderParameter pointScale;
+    FloatShaderParameter useTexture;
+    IntegerShaderParameter particleTex;
+};
+
+static ParticleProgram particleProgram;
+static bool particleProgramFailed = false;
+
+static bool
+getParticleProgram()
+{
+    if (particleProgram.program != nullptr)
+        return true;
+    if (particleProgramFailed)
+        return false;
+
+    GLProgram* prog = nullptr;
+    if (GLShaderLoader::CreateProgram(particleVertexShaderSource,
+                                      particleFragmentShaderSource,
+                                      &prog) != ShaderStatus_OK)
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Error creating particle system shader\n");
+        particleProgramFailed = true;
+        return false;
+    }
+
+    GLuint id = prog->getID();
+    particleProgram.program = prog;
+    particleProgram.wrappedTime = FloatShaderParameter(id, "wrappedTime");
+    particleProgram.poolDuration = FloatShaderParameter(id, "poolDuration");
+    particleProgram.lifetime = FloatShaderParameter(id, "lifetime");
+    particleProgram.minAge = FloatShaderParameter(id, "minAge");
+    particleProgram.maxAge = FloatShaderParameter(id, "maxAge");
+    particleProgram.acceleration = Vec3ShaderParameter(id, "acceleration");
+    particleProgram.startColor = Vec4ShaderParameter(id, "startColor");
+    particleProgram.endColor = Vec4ShaderParameter(id, "endColor");
+    particleProgram.startSize = FloatShaderParameter(id, "startSize");
+    particleProgram.endSize = FloatShaderParameter(id, "endSize");
+    particleProgram.pointScale = FloatShaderParameter(id, "pointScale");
+    particleProgram.useTexture = FloatShaderParameter(id, "useTexture");
+    particleProgram.particleTex = IntegerShaderParameter(id, "particleTex");
+
+    return true;
+}
+
+
+/*! Generate the steady-state particle pool and upload it to a static
+ *  vertex buffer: initial position, initial velocity, and a (phase,
+ *  rotation rate) pair per slot. Slot i is seeded exactly the way the
+ *  per-frame path seeded particle serials, and the generators are
+ *  invoked in the same order, so pool particles follow the same
+ *  trajectories the CPU evaluation produced.
+ */
+bool
+ParticleEmitter::initGpuPool() const
+{
+    if (m_vbo != 0)
+        return true;
+    if (m_poolFailed)
+        return false;
+
+    double slots = std::ceil((double) m_rate * (double) m_lifetime);
+    if (slots > (double) MaxPoolSize)
+    {
+        DPRINTF(LOG_LEVEL_ERROR,
+                "Particle emitter wants %.0f particles; clamping to %u\n",
+                slots, MaxPoolSize);
+        slots = (double) MaxPoolSize;
+    }
+    m_poolSize = std::max(1u, (unsigned int) slots);
+
+    // Interleaved layout: position (3), velocity (3), phase, rotation rate
+    vector<float> pool;
+    pool.reserve((size_t) m_poolSize * 8);
+    for (unsigned int i = 0; i < m_poolSize; i++)
+    {
+        LCGRandomGenerator gen(uint64_t(i) * uint64_t(0x128ef719) ^ scrambleMask);
+
+        Vector3f v = m_velocityGenerator->generate(gen);
+        Vector3f p = m_positionGenerator->generate(gen);
+        float rotationRate = m_rotationEnabled
+            ? m_minRotationRate + m_rotationRateVariance * gen.randFloat()
+            : 0.0f;
+
+        pool.push_back(p.x());
+        pool.push_back(p.y());
+        pool.push_back(p.z());
+        pool.push_back(v.x());
+        pool.push_back(v.y());
+        pool.push_back(v.z());
+        pool.push_back((float) i / (float) m_poolSize);
+        pool.push_back(rotationRate);
+    }
+
+    glGenBuffers(1, &m_vbo);
+    if (m_vbo == 0)
+    {
+        m_poolFailed = true;
+        return false;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER,
+                 pool.size() * sizeof(float),
+                 pool.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return true;
+}
+
+
 void
-ParticleEmitter::render(double tsec,
-                        RenderContext& rc,
-                        ParticleVertex* particleBuffer,
-                        unsigned int particleBufferCapacity) const
+ParticleEmitter::render(double tsec, RenderContext& rc) const
 {
     double t = tsec;
     bool startBounded = m_startTime > -numeric_limits<double>::infinity();
@@ -315,15 +523,11 @@ ParticleEmitter::render(double tsec,
             return;
     }
 
-    Matrix3f modelViewMatrix = rc.getCameraOrientation().conjugate().toRotationMatrix();
+    if (!getParticleProgram() || !initGpuPool())
+        return;
 
     rc.setMaterial(&m_material);
 
-    Vector3f v0 = modelViewMatrix * Vector3f(-1.0f, -1.0f, 0.0f);
-    Vector3f v1 = modelViewMatrix * Vector3f( 1.0f, -1.0f, 0.0f);
-    Vector3f v2 = modelViewMatrix * Vector3f( 1.0f,  1.0f, 0.0f);
-    Vector3f v3 = modelViewMatrix * Vector3f(-1.0f,  1.0f, 0.0f);
-
     glDisable(GL_LIGHTING);
 
     Texture* texture = nullptr;
@@ -348,96 +552,60 @@ ParticleEmitter::render(double tsec,
 
     glDepthMask(GL_FALSE);
 
-    double emissionInterval = 1.0 / m_rate;
-    double dserial = std::fmod(t * m_rate, (double) (1 << 31));
-    auto serial = (int) (dserial);
-    double age = (dserial - serial) * emissionInterval;
-    auto invLifetime = (float) (1.0 / m_lifetime);
-
-    double maxAge = m_lifetime;
+    // Age window of live particles. A slot is alive while its age is
+    // inside [minAge, maxAge): maxAge shrinks right after the emitter
+    // starts (no particle can be older than the emitter), and minAge
+    // grows once emission has stopped (young particles were never
+    // born). Everything is computed in double here and wrapped into
+    // the pool period, so the shader only ever sees small values.
+    double poolDuration = (double) m_poolSize / (double) m_rate;
+    double maxAge = (double) m_lifetime;
     if (startBounded)
-    {
-        maxAge = std::min((double) m_lifetime, t);
-    }
-
+        maxAge = std::min(maxAge, t);
+    double minAge = 0.0;
     if (endBounded && tsec > m_endTime)
-    {
-        auto skipParticles = (int) ((tsec - m_endTime) * m_rate);
-        serial -= skipParticles;
-        age += skipParticles * emissionInterval;
-    }
-
-    Vec4f startColor(m_startColor.red(), m_startColor.green(), m_startColor.blue(), m_startColor.alpha());
-    Vec4f endColor(m_endColor.red(), m_endColor.green(), m_endColor.blue(), m_endColor.alpha());
-
-    unsigned int particleCount = 0;
-
-    while (age < maxAge)
-    {
-        // When the particle buffer is full, render the particles and flush it
-        if (particleCount == particleBufferCapacity)
-        {
-            glDrawArrays(GL_TRIANGLE_FAN, 0, particleCount * 4);
-            particleCount = 0;
-        }
-
-        float alpha = (float) age * invLifetime;
-        float beta = 1.0f - alpha;
-        float size = alpha * m_endSize + beta * m_startSize;
-
-        // Scramble the random number generator seed so that we don't end up with
-        // artifacts from using regularly incrementing values.
-        //
-        // TODO: consider whether the generator could be seeded just once before
-        // the first particle is drawn. This would entail further restrictions,
-        // such as no 'branching' (variable number of calls to LCG::generate()) in
-        // particle state calculation.
-        LCGRandomGenerator gen(uint64_t(serial) * uint64_t(0x128ef719) ^ scrambleMask);
-
-        // Calculate the color of the particle
-        // TODO: switch to using a lookup table for color and opacity
-        unsigned char color[4];
-        color[Color::Red]   = (unsigned char) ((alpha * endColor.x + beta * startColor.x) * 255.99f);
-        color[Color::Green] = (unsigned char) ((alpha * endColor.y + beta * startColor.y) * 255.99f);
-        color[Color::Blue]  = (unsigned char) ((alpha * endColor.z + beta * startColor.z) * 255.99f);
-        color[Color::Alpha] = (unsigned char) ((alpha * endColor.w + beta * startColor.w) * 255.99f);
-
-        Vector3f v = m_velocityGenerator->generate(gen);
-        Vector3f center = m_positionGenerator->generate(gen) + v * (float) age;
-        if (m_nonZeroAcceleration)
-            center += m_acceleration * (float) (age * age);
-
-        if (!m_rotationEnabled)
-        {
-            particleBuffer[particleCount * 4 + 0].set(center + v0 * size, Vector2f(0.0f, 1.0f), color);
-            particleBuffer[particleCount * 4 + 1].set(center + v1 * size, Vector2f(1.0f, 1.0f), color);
-            particleBuffer[particleCount * 4 + 2].set(center + v2 * size, Vector2f(1.0f, 0.0f), color);
-            particleBuffer[particleCount * 4 + 3].set(center + v3 * size, Vector2f(0.0f, 0.0f), color);
-        }
-        else
-        {
-            float rotationRate = m_minRotationRate + m_rotationRateVariance * gen.randFloat();
-            float rotation = rotationRate * (float) age;
-            float c = std::cos(rotation);
-            float s = std::sin(rotation);
-
-            particleBuffer[particleCount * 4 + 0].set(center + (modelViewMatrix * Vector3f(-c + s, -s - c, 0.0f)) * size, Vector2f(0.0f, 1.0f), color);
-            particleBuffer[particleCount * 4 + 1].set(center + (modelViewMatrix * Vector3f( c + s,  s - c, 0.0f)) * size, Vector2f(1.0f, 1.0f), color);
-            particleBuffer[particleCount * 4 + 2].set(center + (modelViewMatrix * Vector3f( c - s,  s + c, 0.0f)) * size, Vector2f(1.0f, 0.0f), color);
-            particleBuffer[particleCount * 4 + 3].set(center + (modelViewMatrix * Vector3f(-c - s, -s + c, 0.0f)) * size, Vector2f(0.0f, 0.0f), color);
-        }
-
-        ++particleCount;
-
-        age += emissionInterval;
-        serial--;
-    }
-
-    // Render any remaining particles in the buffer
-    if (particleCount > 0)
-    {
-        glDrawArrays(GL_TRIANGLE_FAN, 0, particleCount * 4);
-    }
+        minAge = tsec - m_endTime;
+
+    particleProgram.program->use();
+    particleProgram.wrappedTime = (float) std::fmod(t, poolDuration);
+    particleProgram.poolDuration = (float) poolDuration;
+    particleProgram.lifetime = m_lifetime;
+    particleProgram.minAge = (float) minAge;
+    particleProgram.maxAge = (float) maxAge;
+    particleProgram.acceleration = m_acceleration;
+    particleProgram.startColor = Vector4f(m_startColor.red(), m_startColor.green(),
+                                          m_startColor.blue(), m_startColor.alpha());
+    particleProgram.endColor = Vector4f(m_endColor.red(), m_endColor.green(),
+                                        m_endColor.blue(), m_endColor.alpha());
+    particleProgram.startSize = m_startSize;
+    particleProgram.endSize = m_endSize;
+    particleProgram.pointScale = rc.getPointScale();
+    particleProgram.useTexture = texture != nullptr ? 1.0f : 0.0f;
+    particleProgram.particleTex = 0;
+
+    glEnable(GL_POINT_SPRITE);
+    glTexEnvi(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
+    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 8 * sizeof(float), (void*) 0);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, 8 * sizeof(float), (void*) (3 * sizeof(float)));
+    glClientActiveTexture(GL_TEXTURE0);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, 8 * sizeof(float), (void*) (6 * sizeof(float)));
+
+    glDrawArrays(GL_POINTS, 0, m_poolSize);
+
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    glDisable(GL_POINT_SPRITE);
+    glUseProgram(0);
 }
 
 
@@ -452,25 +620,8 @@ ParticleEmitter::createMaterial()
 }
 
 
-#define STRUCT_OFFSET(s, memberName) ((uint32_t) (reinterpret_cast<char*>(&(s).memberName) - reinterpret_cast<char*>(&(s))))
-
-ParticleSystem::ParticleSystem() :
-    m_vertexDesc(nullptr),
-    m_vertexData(nullptr),
-    m_particleCapacity(0),
-    m_particleCount(0)
+ParticleSystem::ParticleSystem()
 {
-    m_particleCapacity = 1000;
-    m_vertexData = new ParticleVertex[m_particleCapacity * 4];
-
-    // Create the vertex description; currently, it is the same for all
-    // particle systems.
-    ParticleVertex temp;
-    Mesh::VertexAttribute attributes[3];
-    attributes[0] = cmod::Mesh::VertexAttribute(Mesh::Position, Mesh::Float3, STRUCT_OFFSET(temp, position));
-    attributes[1] = Mesh::VertexAttribute(Mesh::Texture0, Mesh::Float2, STRUCT_OFFSET(temp, texCoord));
-    attributes[2] = Mesh::VertexAttribute(Mesh::Color0, Mesh::UByte4, STRUCT_OFFSET(temp, color));
-    m_vertexDesc = new Mesh::VertexDescription(sizeof(ParticleVertex), 3, attributes);
 }
 
 
@@ -478,20 +629,15 @@ ParticleSystem::~ParticleSystem()
 {
     for (const auto emitter : m_emitterList)
         delete emitter;
-
-    delete[] m_vertexData;
-    delete m_vertexDesc;
 }
 
 
 void
 ParticleSystem::render(RenderContext& rc, double tsec)
 {
-    rc.setVertexArrays(*m_vertexDesc, m_vertexData);
-
     for (const auto emitter : m_emitterList)
     {
-        emitter->render(tsec, rc, m_vertexData, m_particleCapacity);
+        emitter->render(tsec, rc);
     }
 
     glEnable(GL_LIGHTING);
@@ -15,6 +15,7 @@
 #include "celutil/color.h"
 #include "rendcontext.h"
 #include "geometry.h"
+#include <GL/glew.h>
 #include <Eigen/Core>
 #include <string>
 #include <list>
@@ -22,25 +23,21 @@
 class VectorGenerator;
 
 
-
-struct ParticleVertex
-{
-    void set(const Eigen::Vector3f& _position, const Eigen::Vector2f& _texCoord, const unsigned char* _color)
-    {
-        position = _position;
-        texCoord = _texCoord;
-        color[Color::Red]   = _color[Color::Red];
-        color[Color::Green] = _color[Color::Green];
-        color[Color::Blue]  = _color[Color::Blue];
-        color[Color::Alpha] = _color[Color::Alpha];
-    }
-
-    Eigen::Vector3f position;
-    Eigen::Vector2f texCoord;
-    unsigned char color[4];
-};
-
-
+/*! A particle emitter with GPU-resident state. The stateless design
+ *  (see particlesystem.cpp) means a particle's trajectory is a pure
+ *  function of its initial position, velocity and age, so instead of
+ *  regenerating every particle on the CPU each frame, the steady-state
+ *  pool of rate * lifetime particles is generated once, uploaded to a
+ *  static vertex buffer, and evaluated for the current time entirely
+ *  in a vertex shader. Per frame the CPU cost is a handful of uniform
+ *  updates and one draw call regardless of particle count, which is
+ *  what makes multi-million particle emitters practical.
+ *
+ *  Each pool slot is reborn every pool period, retracing the same
+ *  trajectory; with more than a few hundred particles the repetition
+ *  is not visually detectable, and it is what allows the pool to stay
+ *  immutable on the GPU.
+ */
 class ParticleEmitter
 {
 public:
@@ -49,7 +46,7 @@ public:
     ParticleEmitter();
     ~ParticleEmitter();
 
-    void render(double tsec, RenderContext& rc, ParticleVertex* particleBuffer, unsigned int particleBufferCapacity) const;
+    void render(double tsec, RenderContext& rc) const;
 
     void setAcceleration(const Eigen::Vector3f& acceleration);
     void createMaterial();
@@ -59,6 +56,8 @@ public:
     void setBlendMode(cmod::Material::BlendMode blendMode);
 
 private:
+    bool initGpuPool() const;
+
     double m_startTime;
     double m_endTime;
 
@@ -88,6 +87,11 @@ private:
     cmod::Material::BlendMode m_blendMode;
 
     cmod::Material m_material;
+
+    // GPU particle pool, built lazily on first render
+    mutable GLuint m_vbo{ 0 };
+    mutable unsigned int m_poolSize{ 0 };
+    mutable bool m_poolFailed{ false };
 };
 
 
@@ -105,11 +109,6 @@ class ParticleSystem : public Geometry
 
  public:
     std::list<ParticleEmitter*> m_emitterList;
-
-    cmod::Mesh::VertexDescription* m_vertexDesc;
-    ParticleVertex* m_vertexData;
-    unsigned int m_particleCapacity;
-    unsigned int m_particleCount;
 };
 
 
@@ -15,6 +15,9 @@
 #include "body.h"
 #include <GL/glew.h>
 #include "render.h"
+#include "lodspheremesh.h"
+#include "renderinfo.h"
+#include "renderglsl.h"
 
 using namespace cmod;
 using namespace Eigen;
@@ -136,6 +139,20 @@ RenderContext::getPointScale() const
 }
 
 
+void
+RenderContext::setScreenSize(float _screenSize)
+{
+    screenSize = _screenSize;
+}
+
+
+float
+RenderContext::getScreenSize() const
+{
+    return screenSize;
+}
+
+
 void
 RenderContext::setCameraOrientation(const Quaternionf& q)
 {
@@ -152,6 +169,51 @@ RenderContext::getCameraOrientation() const
 
 void
 RenderContext::drawGroup(const Mesh::PrimitiveGroup& group)
+{
+    drawGroupIndices(group, group.indices);
+}
+
+
+void
+RenderContext::drawGroup(const Mesh::PrimitiveGroup& group, unsigned int indexBufferOffset)
+{
+    drawGroupIndices(group, reinterpret_cast<const void*>((std::uintptr_t) indexBufferOffset));
+}
+
+
+void
+RenderContext::drawGroupInstanced(const Mesh::PrimitiveGroup& group,
+                                  const Matrix4f* instanceTransforms,
+                                  unsigned int instanceCount)
+{
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        glPushMatrix();
+        glMultMatrixf(instanceTransforms[i].data());
+        drawGroupIndices(group, group.indices);
+        glPopMatrix();
+    }
+}
+
+
+void
+RenderContext::drawGroupInstanced(const Mesh::PrimitiveGroup& group,
+                                  unsigned int indexBufferOffset,
+                                  const Matrix4f* instanceTransforms,
+                                  unsigned int instanceCount)
+{
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        glPushMatrix();
+        glMultMatrixf(instanceTransforms[i].data());
+        drawGroupIndices(group, reinterpret_cast<const void*>((std::uintptr_t) indexBufferOffset));
+        glPopMatrix();
+    }
+}
+
+
+void
+RenderContext::drawGroupIndices(const Mesh::PrimitiveGroup& group, const void* indices)
 {
     // Skip rendering if this is the emissive pass but there's no
     // emissive texture.
@@ -173,7 +235,7 @@ RenderContext::drawGroup(const Mesh::PrimitiveGroup& group)
     glDrawElements(GLPrimitiveModes[(int) group.prim],
                    group.nIndices,
                    GL_UNSIGNED_INT,
-                   group.indices);
+                   indices);
 
     if (group.prim == Mesh::SpriteList)
     {
@@ -570,6 +632,15 @@ GLSL_RenderContext::makeCurrent(const Material& m)
     {
         prog->setAtmosphereParameters(*atmosphere, objRadius, objRadius);
         disableDepthWriteOnBlend = false;
+
+        const AtmosphereTransmittanceLUT* lut = GetAtmosphereTransmittanceLUT(atmosphere, objRadius);
+        if (lut->texture != nullptr)
+        {
+            glActiveTexture(GL_TEXTURE0 + nTextures);
+            lut->texture->bind();
+            glActiveTexture(GL_TEXTURE0);
+            prog->transmittanceScale = lut->maxOpticalDepth / objRadius;
+        }
     }
 
     if ((shaderProps.texUsage & ShaderProperties::PointSprite) != 0)
@@ -31,6 +31,26 @@ class RenderContext
                                  const void* vertexData);
     virtual void drawGroup(const cmod::Mesh::PrimitiveGroup& group);
 
+    /*! Draw a group whose indices live in the currently bound element
+     *  array buffer, starting at the given byte offset.
+     */
+    void drawGroup(const cmod::Mesh::PrimitiveGroup& group, unsigned int indexBufferOffset);
+
+    /*! Draw a group once per instance transform. The generated shaders
+     *  take their model matrix from the fixed-function stack, so each
+     *  instance is replayed with only a matrix change between draws;
+     *  material, vertex array, and shader state stay bound across the
+     *  whole batch. Only valid when the current material and lighting
+     *  setup apply to every instance.
+     */
+    void drawGroupInstanced(const cmod::Mesh::PrimitiveGroup& group,
+                            const Eigen::Matrix4f* instanceTransforms,
+                            unsigned int instanceCount);
+    void drawGroupInstanced(const cmod::Mesh::PrimitiveGroup& group,
+                            unsigned int indexBufferOffset,
+                            const Eigen::Matrix4f* instanceTransforms,
+                            unsigned int instanceCount);
+
     const cmod::Material* getMaterial() const;
     void setMaterial(const cmod::Material*);
     void lock() { locked = true; }
@@ -49,14 +69,21 @@ class RenderContext
     void setPointScale(float);
     float getPointScale() const;
 
+    //! Projected size of the object in pixels; used for mesh LOD selection
+    void setScreenSize(float);
+    float getScreenSize() const;
+
     void setCameraOrientation(const Eigen::Quaternionf& q);
     Eigen::Quaternionf getCameraOrientation() const;
 
  private:
+    void drawGroupIndices(const cmod::Mesh::PrimitiveGroup& group, const void* indices);
+
     const cmod::Material* material{ nullptr };
     bool locked{ false };
     RenderPass renderPass{ PrimaryPass };
     float pointScale{ 1.0f };
+    float screenSize{ 1.0e6f };
     Eigen::Quaternionf cameraOrientation;  // required for drawing billboards
 
  protected:
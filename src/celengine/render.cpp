@@ -51,6 +51,7 @@ std::ofstream hdrlog;
 #include "meshmanager.h"
 #include "renderinfo.h"
 #include "renderglsl.h"
+#include "dsoimpostor.h"
 #include "axisarrow.h"
 #include "frametree.h"
 #include "timelinephase.h"
@@ -67,6 +68,7 @@ std::ofstream hdrlog;
 #include <celutil/utf8.h>
 #include <celutil/util.h>
 #include <celutil/timer.h>
+#include <celutil/tracelog.h>
 #include <GL/glew.h>
 #ifdef VIDEO_SYNC
 #ifdef _WIN32
@@ -80,9 +82,12 @@ std::ofstream hdrlog;
 #include <algorithm>
 #include <cstring>
 #include <cassert>
+#include <future>
+#include <tuple>
 #include <sstream>
 #include <iomanip>
 #include <numeric>
+#include <thread>
 
 using namespace cmod;
 using namespace Eigen;
@@ -182,6 +187,28 @@ static const unsigned int OrbitCacheCullThreshold = 200;
 // Age in frames at which unused orbit paths may be eliminated from the cache
 static const uint32_t OrbitCacheRetireAge = 16;
 
+// Bodies that were invisible from every direction at their last
+// evaluation are re-evaluated once per this many frames, with each
+// body assigned a fixed slot so roughly 1/interval of them refresh on
+// any given frame.
+static const uint32_t InvisibleBodyUpdateInterval = 8;
+
+// Margin below the faintest rendered magnitude (and below one pixel of
+// apparent size) a body must clear before its evaluation may be
+// deferred; brightness and size changes between evaluations have to
+// stay well inside it.
+static const float DeferralMagMargin = 2.0f;
+static const float DeferralDiscSizeLimit = 0.25f;
+
+// Maximum simulated time in days allowed between evaluations of a
+// deferred body; fast or jumping time forces a recompute.
+static const double DeferralMaxTimeStep = 1.0;
+
+// Drop the deferral schedule entirely if it ever accumulates this many
+// entries; keeps it from growing without bound across catalog add-ons
+// and visits to many systems.
+static const size_t BodyScheduleCullThreshold = 16384;
+
 Color Renderer::StarLabelColor          (0.471f, 0.356f, 0.682f);
 Color Renderer::PlanetLabelColor        (0.407f, 0.333f, 0.964f);
 Color Renderer::DwarfPlanetLabelColor   (0.557f, 0.235f, 0.576f);
@@ -289,18 +316,16 @@ public:
     void setTexture(Texture* /*_texture*/);
 
 private:
-    struct StarVertex
-    {
-        Eigen::Vector3f position;
-        float size;
-        unsigned char color[4];
-        float pad;
-    };
-
+    // Structure-of-arrays storage: positions, sizes, and colors are
+    // kept in separate tightly packed streams. The fill loop touches
+    // only whole cache lines of each attribute, and the driver sources
+    // each client array without striding over unrelated data.
     const Renderer& renderer;
     unsigned int capacity;
     unsigned int nStars{ 0 };
-    StarVertex* vertices{ nullptr };
+    Eigen::Vector3f* positions{ nullptr };
+    float* sizes{ nullptr };
+    unsigned char* colors{ nullptr };
     bool useSprites{ false };
     Texture* texture{ nullptr };
 };
@@ -310,12 +335,16 @@ PointStarVertexBuffer::PointStarVertexBuffer(const Renderer& _renderer,
     renderer(_renderer),
     capacity(_capacity)
 {
-    vertices = new StarVertex[capacity];
+    positions = new Eigen::Vector3f[capacity];
+    sizes = new float[capacity];
+    colors = new unsigned char[capacity * 4];
 }
 
 PointStarVertexBuffer::~PointStarVertexBuffer()
 {
-    delete[] vertices;
+    delete[] positions;
+    delete[] sizes;
+    delete[] colors;
 }
 
 void PointStarVertexBuffer::startSprites()
@@ -327,16 +356,15 @@ void PointStarVertexBuffer::startSprites()
     prog->use();
     prog->samplerParam("starTex") = 0;
 
-    unsigned int stride = sizeof(StarVertex);
     glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, stride, &vertices[0].position);
+    glVertexPointer(3, GL_FLOAT, 0, positions);
     glEnableClientState(GL_COLOR_ARRAY);
-    glColorPointer(4, GL_UNSIGNED_BYTE, stride, &vertices[0].color);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors);
 
     glEnableVertexAttribArray(CelestiaGLProgram::PointSizeAttributeIndex);
     glVertexAttribPointer(CelestiaGLProgram::PointSizeAttributeIndex,
                           1, GL_FLOAT, GL_FALSE,
-                          stride, &vertices[0].size);
+                          0, sizes);
 
     glDisableClientState(GL_TEXTURE_COORD_ARRAY);
     glDisableClientState(GL_NORMAL_ARRAY);
@@ -348,11 +376,10 @@ void PointStarVertexBuffer::startSprites()
 
 void PointStarVertexBuffer::startPoints()
 {
-    unsigned int stride = sizeof(StarVertex);
     glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, stride, &vertices[0].position);
+    glVertexPointer(3, GL_FLOAT, 0, positions);
     glEnableClientState(GL_COLOR_ARRAY);
-    glColorPointer(4, GL_UNSIGNED_BYTE, stride, &vertices[0].color);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors);
 
     // An option to control the size of the stars would be helpful.
     // Which size looks best depends a lot on the resolution and the
@@ -371,7 +398,6 @@ void PointStarVertexBuffer::render()
 {
     if (nStars != 0)
     {
-        unsigned int stride = sizeof(StarVertex);
         if (useSprites)
         {
             glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
@@ -383,14 +409,14 @@ void PointStarVertexBuffer::render()
             glDisable(GL_TEXTURE_2D);
             glPointSize(1.0f);
         }
-        glVertexPointer(3, GL_FLOAT, stride, &vertices[0].position);
-        glColorPointer(4, GL_UNSIGNED_BYTE, stride, &vertices[0].color);
+        glVertexPointer(3, GL_FLOAT, 0, positions);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, colors);
 
         if (useSprites)
         {
             glVertexAttribPointer(CelestiaGLProgram::PointSizeAttributeIndex,
                                   1, GL_FLOAT, GL_FALSE,
-                                  stride, &vertices[0].size);
+                                  0, sizes);
         }
 
         if (texture != nullptr)
@@ -425,9 +451,9 @@ inline void PointStarVertexBuffer::addStar(const Eigen::Vector3f& pos,
 {
     if (nStars < capacity)
     {
-        vertices[nStars].position = pos;
-        vertices[nStars].size = size;
-        color.get(vertices[nStars].color);
+        positions[nStars] = pos;
+        sizes[nStars] = size;
+        color.get(colors + nStars * 4);
         nStars++;
     }
 
@@ -443,6 +469,146 @@ void PointStarVertexBuffer::setTexture(Texture* _texture)
   texture = _texture;
 }
 
+/*! BodyPointBatch accumulates solar system bodies drawn as points or
+ *  camera-aligned sprites — minor planets, distant moons, halos — into
+ *  shared vertex streams so that they can be submitted in a handful of
+ *  draw calls instead of one immediate mode quad per body. It plays the
+ *  same role for renderObjectAsPoint that PointStarVertexBuffer plays
+ *  for the star renderer. Quads are expanded on the CPU exactly as the
+ *  immediate mode path did; the caller picks the flush points, so the
+ *  blending order against other translucent geometry is preserved. All
+ *  the batched primitives blend additively, so ordering within one
+ *  batch doesn't affect the output.
+ */
+class BodyPointBatch
+{
+public:
+    BodyPointBatch() = default;
+    ~BodyPointBatch() = default;
+
+    void setCameraOrientation(const Eigen::Quaternionf& orientation)
+    {
+        Eigen::Matrix3f m = orientation.conjugate().toRotationMatrix();
+        quadVerts[0] = m * Eigen::Vector3f(-1, -1, 0);
+        quadVerts[1] = m * Eigen::Vector3f( 1, -1, 0);
+        quadVerts[2] = m * Eigen::Vector3f( 1,  1, 0);
+        quadVerts[3] = m * Eigen::Vector3f(-1,  1, 0);
+    }
+
+    void addPoint(const Eigen::Vector3f& center, const Color& color)
+    {
+        pointVerts.push_back(center);
+        appendColor(pointColors, color);
+    }
+
+    void addSprite(const Eigen::Vector3f& center, float size, const Color& color)
+    {
+        appendQuad(spriteVerts, spriteTexCoords, spriteColors, center, size, color);
+    }
+
+    void addGlare(const Eigen::Vector3f& center, float size, const Color& color)
+    {
+        appendQuad(glareVerts, glareTexCoords, glareColors, center, size, color);
+    }
+
+    bool empty() const
+    {
+        return pointVerts.empty() && spriteVerts.empty() && glareVerts.empty();
+    }
+
+    void render();
+
+private:
+    static void appendColor(std::vector<unsigned char>& colors, const Color& color)
+    {
+        unsigned char rgba[4];
+        color.get(rgba);
+        colors.insert(colors.end(), rgba, rgba + 4);
+    }
+
+    void appendQuad(std::vector<Eigen::Vector3f>& verts,
+                    std::vector<float>& texCoords,
+                    std::vector<unsigned char>& colors,
+                    const Eigen::Vector3f& center,
+                    float size,
+                    const Color& color)
+    {
+        static const float quadTexCoords[8] = { 0, 1,  1, 1,  1, 0,  0, 0 };
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            verts.push_back(center + quadVerts[i] * size);
+            appendColor(colors, color);
+        }
+        texCoords.insert(texCoords.end(), quadTexCoords, quadTexCoords + 8);
+    }
+
+    Eigen::Vector3f quadVerts[4];
+
+    std::vector<Eigen::Vector3f> pointVerts;
+    std::vector<unsigned char> pointColors;
+    std::vector<Eigen::Vector3f> spriteVerts;
+    std::vector<float> spriteTexCoords;
+    std::vector<unsigned char> spriteColors;
+    std::vector<Eigen::Vector3f> glareVerts;
+    std::vector<float> glareTexCoords;
+    std::vector<unsigned char> glareColors;
+};
+
+void BodyPointBatch::render()
+{
+    if (empty())
+        return;
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+
+    if (!pointVerts.empty())
+    {
+        glDisable(GL_TEXTURE_2D);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, pointVerts[0].data());
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, pointColors.data());
+        glDrawArrays(GL_POINTS, 0, pointVerts.size());
+        glEnable(GL_TEXTURE_2D);
+        pointVerts.clear();
+        pointColors.clear();
+    }
+
+    if (!spriteVerts.empty() && gaussianDiscTex != nullptr)
+    {
+        gaussianDiscTex->bind();
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, spriteVerts[0].data());
+        glTexCoordPointer(2, GL_FLOAT, 0, spriteTexCoords.data());
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, spriteColors.data());
+        glDrawArrays(GL_QUADS, 0, spriteVerts.size());
+        spriteVerts.clear();
+        spriteTexCoords.clear();
+        spriteColors.clear();
+    }
+
+    if (!glareVerts.empty() && gaussianGlareTex != nullptr)
+    {
+        gaussianGlareTex->bind();
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, glareVerts[0].data());
+        glTexCoordPointer(2, GL_FLOAT, 0, glareTexCoords.data());
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, glareColors.data());
+        glDrawArrays(GL_QUADS, 0, glareVerts.size());
+        glareVerts.clear();
+        glareTexCoords.clear();
+        glareColors.clear();
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
 /**** End star vertex buffer classes ****/
 
 
@@ -465,6 +631,9 @@ Renderer::Renderer() :
     starStyle(FuzzyPointStars),
     pointStarVertexBuffer(nullptr),
     glareVertexBuffer(nullptr),
+    bodyPointBatch(nullptr),
+    frameArena(16, 262144),
+    passTimingEnabled(false),
     textureResolution(medres),
     frameCount(0),
     lastOrbitCacheFlush(0),
@@ -489,6 +658,7 @@ Renderer::Renderer() :
 {
     pointStarVertexBuffer = new PointStarVertexBuffer(*this, 2048);
     glareVertexBuffer = new PointStarVertexBuffer(*this, 2048);
+    bodyPointBatch = new BodyPointBatch();
     skyVertices = new SkyVertex[MaxSkySlices * (MaxSkyRings + 1)];
     skyIndices = new uint32_t[(MaxSkySlices + 1) * 2 * MaxSkyRings];
     skyContour = new SkyContourPoint[MaxSkySlices + 1];
@@ -524,9 +694,23 @@ Renderer::~Renderer()
 {
     delete pointStarVertexBuffer;
     delete glareVertexBuffer;
+    delete bodyPointBatch;
+    for (const auto& query : occlusionQueries)
+    {
+        if (query.second.id != 0)
+            glDeleteQueries(1, &query.second.id);
+    }
+    for (const auto& profile : passProfiles)
+    {
+        if (profile.second.queries[0] != 0)
+            glDeleteQueries(2, profile.second.queries);
+    }
+    if (m_capturePBOs[0] != 0)
+        glDeleteBuffers(CaptureRingSize, m_capturePBOs);
     delete[] skyVertices;
     delete[] skyIndices;
     delete[] skyContour;
+    delete dsoImpostorCache;
 #ifdef USE_BLOOM_LISTS
     for (size_t i = 0; i < (sizeof gaussianLists/sizeof(GLuint)); ++i)
     {
@@ -901,6 +1085,82 @@ bool operator<(const RenderListEntry& a, const RenderListEntry& b)
 }
 
 
+// Map an IEEE float to an unsigned integer with the same ordering, so
+// that depth values can be ordered by integer sorting machinery.
+static inline uint32_t floatToSortableUint(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return (bits & 0x80000000u) != 0 ? ~bits : bits | 0x80000000u;
+}
+
+// Below this size the comparison sort wins; radix setup isn't free.
+static const size_t RadixSortThreshold = 64;
+
+// Sort the render list front to back (the ordering of operator< above)
+// using a radix sort over quantized depth keys. Entries are reduced to
+// packed (depth key, index) pairs, the pairs are sorted with byte-wide
+// counting passes, and the full-size entries are gathered once at the
+// end. Unlike std::sort this runs in deterministic time regardless of
+// the initial ordering, which matters for dense ring and moon systems
+// that put thousands of entries in the list. All scratch storage is
+// drawn from the frame arena.
+static void depthSortRenderList(vector<RenderListEntry>& renderList, MemoryPool& arena)
+{
+    size_t nEntries = renderList.size();
+    if (nEntries < RadixSortThreshold)
+    {
+        sort(renderList.begin(), renderList.end());
+        return;
+    }
+
+    typedef vector<uint64_t, ArenaAllocator<uint64_t>> KeyList;
+    KeyList keys{ ArenaAllocator<uint64_t>(arena) };
+    KeyList scratch{ ArenaAllocator<uint64_t>(arena) };
+    keys.reserve(nEntries);
+    scratch.resize(nEntries);
+
+    for (size_t i = 0; i < nEntries; i++)
+    {
+        // Complement the key because the list is ordered far-to-near in
+        // key space: -z points into the screen.
+        uint32_t key = ~floatToSortableUint(renderList[i].centerZ - renderList[i].radius);
+        keys.push_back(((uint64_t) key << 32) | (uint64_t) i);
+    }
+
+    // Four counting passes over the key byte lanes; the index in the low
+    // half of each pair makes the sort stable for free.
+    for (unsigned int shift = 32; shift < 64; shift += 8)
+    {
+        size_t counts[256] = { 0 };
+        for (uint64_t key : keys)
+            counts[(key >> shift) & 0xff]++;
+
+        // Skip passes where all keys share one byte value.
+        if (counts[(keys[0] >> shift) & 0xff] == nEntries)
+            continue;
+
+        size_t offsets[256];
+        size_t total = 0;
+        for (unsigned int b = 0; b < 256; b++)
+        {
+            offsets[b] = total;
+            total += counts[b];
+        }
+
+        for (uint64_t key : keys)
+            scratch[offsets[(key >> shift) & 0xff]++] = key;
+        keys.swap(scratch);
+    }
+
+    vector<RenderListEntry, ArenaAllocator<RenderListEntry>> sorted{ ArenaAllocator<RenderListEntry>(arena) };
+    sorted.reserve(nEntries);
+    for (uint64_t key : keys)
+        sorted.push_back(renderList[key & 0xffffffffu]);
+    copy(sorted.begin(), sorted.end(), renderList.begin());
+}
+
+
 // Depth comparison for labels
 // Note that it's essential to declare this operator as a member
 // function of Renderer::Label; if it's not a class member, C++'s
@@ -1310,7 +1570,7 @@ void Renderer::addAnnotation(vector<Annotation>& annotations,
 
         Annotation a;
         if (!special || markerRep == nullptr)
-             a.labelText = labelText;
+             a.labelText.assign(labelText.data(), labelText.length());
         a.markerRep = markerRep;
         a.color = color;
         a.position = win.cast<float>();
@@ -1358,6 +1618,77 @@ void Renderer::addSortedAnnotation(const MarkerRepresentation* markerRep,
 }
 
 
+// Labels shown in the previous frame get this importance bonus, so a
+// label at the budget boundary must be clearly displaced by a better
+// candidate before it disappears.
+static const float LabelHysteresisBonus = 0.75f;
+
+void Renderer::addStarLabelCandidate(const Star& star,
+                                     Color color,
+                                     const Vector3f& position,
+                                     float importance)
+{
+    if (labelsShownLastFrame.count(&star) != 0)
+        importance += LabelHysteresisBonus;
+    labelCandidates.push_back({ &star, nullptr, nullptr, color, position, 0.0f, importance });
+}
+
+
+void Renderer::addDSOLabelCandidate(DeepSkyObject* dso,
+                                    const MarkerRepresentation* markerRep,
+                                    Color color,
+                                    const Vector3f& position,
+                                    float symbolSize,
+                                    float importance)
+{
+    if (labelsShownLastFrame.count(dso) != 0)
+        importance += LabelHysteresisBonus;
+    labelCandidates.push_back({ nullptr, dso, markerRep, color, position, symbolSize, importance });
+}
+
+
+void Renderer::commitLabelCandidates(const Universe& universe)
+{
+    // Keep the highest scoring candidates up to the per-frame budget;
+    // only the survivors pay for name resolution and layout.
+    if (labelCandidates.size() > MaxLabelsPerFrame)
+    {
+        nth_element(labelCandidates.begin(),
+                    labelCandidates.begin() + MaxLabelsPerFrame,
+                    labelCandidates.end(),
+                    [](const LabelCandidate& a, const LabelCandidate& b)
+                    {
+                        return a.importance > b.importance;
+                    });
+        labelCandidates.resize(MaxLabelsPerFrame);
+    }
+
+    labelsShownLastFrame.clear();
+    for (const auto& candidate : labelCandidates)
+    {
+        if (candidate.star != nullptr)
+        {
+            addBackgroundAnnotation(nullptr,
+                                    universe.getStarCatalog()->getStarName(*candidate.star, true),
+                                    candidate.color,
+                                    candidate.position);
+            labelsShownLastFrame.insert(candidate.star);
+        }
+        else
+        {
+            addBackgroundAnnotation(candidate.markerRep,
+                                    universe.getDSOCatalog()->getDSOName(candidate.dso, true),
+                                    candidate.color,
+                                    candidate.position,
+                                    AlignLeft, VerticalAlignCenter,
+                                    candidate.symbolSize);
+            labelsShownLastFrame.insert(candidate.dso);
+        }
+    }
+    labelCandidates.clear();
+}
+
+
 void Renderer::clearAnnotations(vector<Annotation>& annotations)
 {
     annotations.clear();
@@ -1463,9 +1794,14 @@ inline void disableSmoothLines(uint64_t renderFlags)
 class OrbitSampler : public OrbitSampleProc
 {
 public:
-    vector<CurvePlotSample> samples;
+    // Samples are scratch data discarded once they've been copied into
+    // the CurvePlot, so they're drawn from the renderer's frame arena.
+    vector<CurvePlotSample, ArenaAllocator<CurvePlotSample>> samples;
 
-    OrbitSampler() = default;
+    OrbitSampler(MemoryPool& arena) :
+        samples(ArenaAllocator<CurvePlotSample>(arena))
+    {
+    }
 
     void sample(double t, const Vector3d& position, const Vector3d& velocity)
     {
@@ -1564,6 +1900,7 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
                            float nearDist,
                            float farDist)
 {
+    CELZONE("render/orbit");
     auto *prog = shaderManager->getShader(ShaderProperties::PerVertexColor);
     if (prog == nullptr)
         return;
@@ -1625,7 +1962,7 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
         cachedOrbit = new CurvePlot();
         cachedOrbit->setLastUsed(frameCount);
 
-        OrbitSampler sampler;
+        OrbitSampler sampler(frameArena);
         orbit->sample(startTime,
                       startTime + orbit->getPeriod(),
                       sampler);
@@ -1656,6 +1993,16 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
     if (cachedOrbit->empty())
         return;
 
+    // Skip orbits whose projected extent is below a couple of pixels;
+    // dense belts are full of paths too small to see, and culling them
+    // here avoids the window update and subdivision work entirely.
+    {
+        double orbitRadius = cachedOrbit->boundingRadius();
+        double distanceToOrbit = max(orbitPath.origin.norm() - orbitRadius, (double) nearDist);
+        if (orbitRadius < 2.0 * pixelSize * distanceToOrbit)
+            return;
+    }
+
     //*** Orbit rendering parameters
 
     // The 'window' is the interval of time for which the orbit will be drawn.
@@ -1703,7 +2050,7 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
             cachedOrbit->removeSamplesBefore(cachedOrbit->startTime() * (1.0 + 1.0e-15));
 
             // Add the new samples
-            OrbitSampler sampler;
+            OrbitSampler sampler(frameArena);
             orbit->sample(newWindowStart, min(currentWindowStart, newWindowEnd), sampler);
             sampler.insertBackward(cachedOrbit);
 #if DEBUG_ORBIT_CACHE
@@ -1719,7 +2066,7 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
             cachedOrbit->removeSamplesAfter(cachedOrbit->endTime() * (1.0 - 1.0e-15));
 
             // Add the new samples
-            OrbitSampler sampler;
+            OrbitSampler sampler(frameArena);
             orbit->sample(max(currentWindowEnd, newWindowStart), newWindowEnd, sampler);
             sampler.insertForward(cachedOrbit);
 #if DEBUG_ORBIT_CACHE
@@ -1775,11 +2122,27 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
 
         if (LinearFadeFraction == 0.0f || (renderFlags & ShowFadingOrbits) == 0)
         {
-            cachedOrbit->render(modelview,
-                                nearZ, farZ, viewFrustumPlaneNormals,
-                                subdivisionThreshold,
-                                windowStart, windowEnd,
-                                orbitColor);
+            // A full revolution without fading is a closed curve, so the
+            // retained path's snapping of the window to sample boundaries
+            // is invisible and we can draw from cached vertex buffers.
+            bool drawn = false;
+            if (OrbitPeriodsShown >= 1.0)
+            {
+                drawn = cachedOrbit->renderRetained(modelview,
+                                                    nearZ, farZ, viewFrustumPlaneNormals,
+                                                    subdivisionThreshold,
+                                                    windowStart, windowEnd,
+                                                    orbitColor);
+            }
+
+            if (!drawn)
+            {
+                cachedOrbit->render(modelview,
+                                    nearZ, farZ, viewFrustumPlaneNormals,
+                                    subdivisionThreshold,
+                                    windowStart, windowEnd,
+                                    orbitColor);
+            }
         }
         else
         {
@@ -1806,10 +2169,18 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
         else
         {
             // Show the entire trajectory
-            cachedOrbit->render(modelview,
-                                nearZ, farZ, viewFrustumPlaneNormals,
-                                subdivisionThreshold,
-                                orbitColor);
+            if (!cachedOrbit->renderRetained(modelview,
+                                             nearZ, farZ, viewFrustumPlaneNormals,
+                                             subdivisionThreshold,
+                                             cachedOrbit->startTime(),
+                                             cachedOrbit->endTime(),
+                                             orbitColor))
+            {
+                cachedOrbit->render(modelview,
+                                    nearZ, farZ, viewFrustumPlaneNormals,
+                                    subdivisionThreshold,
+                                    orbitColor);
+            }
         }
     }
 
@@ -1968,6 +2339,49 @@ void Renderer::renderItem(const RenderListEntry& rle,
 }
 
 
+/*! Append a draw command to the render command queue. The queue is
+ *  single producer/single consumer: today both sides run on the GL
+ *  thread, with traversal recording and drainRenderCommands() replaying,
+ *  so a full queue can simply be drained in place. When recording moves
+ *  to a traversal thread, the producer will instead wait for the
+ *  submission thread to catch up.
+ */
+void Renderer::recordRenderCommand(const RenderCommand& cmd, const Observer& observer)
+{
+    if (!renderCommands.push(cmd))
+    {
+        drainRenderCommands(observer);
+        renderCommands.push(cmd);
+    }
+}
+
+
+/*! Replay all recorded draw commands in order. This is the only place
+ *  where the render list passes touch GL.
+ */
+void Renderer::drainRenderCommands(const Observer& observer)
+{
+    RenderCommand cmd;
+    while (renderCommands.pop(cmd))
+    {
+        switch (cmd.type)
+        {
+        case RenderCommand::DrawItem:
+            renderItem(cmd.item, observer, m_cameraOrientation,
+                       cmd.nearPlaneDistance, cmd.farPlaneDistance);
+            break;
+
+        case RenderCommand::FlushPointBatch:
+            bodyPointBatch->render();
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+
 #ifdef USE_HDR
 void Renderer::genBlurTextures()
 {
@@ -2238,6 +2652,7 @@ void Renderer::renderToTexture(const Observer& observer,
                                float faintestMagNight,
                                const Selection& sel)
 {
+    CELZONE("render/toTexture");
     if (sceneTexture == 0)
         return;
     glPushAttrib(GL_COLOR_BUFFER_BIT);
@@ -2407,6 +2822,10 @@ void Renderer::render(const Observer& observer,
                       float faintestMagNight,
                       const Selection& sel)
 {
+    // Advance the resource usage frame stamp and evict textures and
+    // geometry if a GPU memory budget is configured and exceeded.
+    GetResourceBudget().update();
+
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
 
@@ -2466,13 +2885,38 @@ void Renderer::draw(const Observer& observer,
                     float faintestMagNight,
                     const Selection& sel)
 {
+    CELTRACE_SCOPE("render");
+
     // Get the observer's time
     double now = observer.getTime();
     realTime = observer.getRealTime();
 
     frameCount++;
+
+    // Deferred-body scheduling assumes the visibility thresholds are
+    // stable between evaluations; drop the schedule whenever a setting
+    // changed, and keep it from accumulating entries for long-gone
+    // bodies.
+    if (settingsChanged || bodyUpdateSchedule.size() > BodyScheduleCullThreshold)
+        bodyUpdateSchedule.clear();
     settingsChanged = false;
 
+    // Shadow caster state is valid for a single frame; bodies may also
+    // be unloaded between frames, so don't keep pointers to them. The
+    // views of one view set share a frame (and its simulation time),
+    // so only the first view pays for the rebuild.
+    if (!viewSetActive || viewSetFirstDraw)
+    {
+        eclipseCasterCache.clear();
+        viewSetFirstDraw = false;
+    }
+
+    // Rekey the body position cache for this frame's time and viewpoint.
+    bodyOffsetIndex.clear();
+    bodyOffsets.clear();
+    bodyOffsetTime = now;
+    bodyOffsetOrigin = observer.getPosition();
+
     // Compute the size of a pixel
     setFieldOfView(radToDeg(observer.getFOV()));
     pixelSize = calcPixelSize(fov, (float) windowHeight);
@@ -2493,6 +2937,9 @@ void Renderer::draw(const Observer& observer,
 
     m_cameraOrientation = observer.getOrientationf();
 
+    // Point-like bodies batched this frame share one set of billboard axes.
+    bodyPointBatch->setCameraOrientation(m_cameraOrientation);
+
     // Get the view frustum used for culling in camera space.
     Frustum frustum(degToRad(fov),
                     getAspectRatio(),
@@ -2516,6 +2963,14 @@ void Renderer::draw(const Observer& observer,
 
     clearSortedAnnotations();
 
+    // Rewind the frame arena; all scratch containers allocated from it
+    // during the previous frame are gone by now. The member render lists
+    // below keep their capacity across frames, so in the steady state
+    // neither they nor the arena touch the heap.
+    frameArena.freeAll();
+
+    updatePassTimings();
+
     // Put all solar system bodies into the render list.  Stars close and
     // large enough to have discernible surface detail are also placed in
     // renderList.
@@ -2548,7 +3003,9 @@ void Renderer::draw(const Observer& observer,
     if ((renderFlags & (ShowSSO | ShowOrbits)) != 0)
     {
         nearStars.clear();
-        universe.getNearStars(observer.getPosition(), SolarSystemMaxDistance, nearStars);
+        nearStarSystems.clear();
+        universe.getNearStars(observer.getPosition(), SolarSystemMaxDistance,
+                              nearStars, nearStarSystems);
 
         // Set up direct light sources (i.e. just stars at the moment)
         // Skip if only star orbits to be shown
@@ -2557,14 +3014,15 @@ void Renderer::draw(const Observer& observer,
 
         // Traverse the frame trees of each nearby solar system and
         // build the list of objects to be rendered.
-        for (const auto sun : nearStars)
+        for (size_t starIndex = 0; starIndex < nearStars.size(); starIndex++)
         {
+            const Star* sun = nearStars[starIndex];
             addStarOrbitToRenderList(*sun, observer, now);
             // Skip if only star orbits to be shown
             if ((renderFlags & ShowSSO) == 0)
                 continue;
 
-            SolarSystem* solarSystem = universe.getSolarSystem(sun);
+            SolarSystem* solarSystem = nearStarSystems[starIndex];
             if (solarSystem == nullptr)
                 continue;
 
@@ -2582,6 +3040,21 @@ void Renderer::draw(const Observer& observer,
             // Compute the position of the observer in astrocentric coordinates
             Vector3d astrocentricObserverPos = astrocentricPosition(observer.getPosition(), *sun, now);
 
+            // Hierarchical culling at the system level: the tree's
+            // bounding sphere is conservative over all epochs (it
+            // accumulates the orbit bounding radii and culling radii of
+            // every phase, active or not), so when the observer is
+            // outside it and it lies entirely outside the view frustum,
+            // nothing in the system can be visible and the whole
+            // traversal — render lists and orbit lists — is skipped.
+            double systemRadius = solarSysTree->boundingSphereRadius();
+            if (astrocentricObserverPos.norm() > systemRadius &&
+                xfrustum.testSphere((-astrocentricObserverPos).cast<float>(),
+                                    (float) systemRadius) == Frustum::Outside)
+            {
+                continue;
+            }
+
             // Build render lists for bodies and orbits paths
             buildRenderLists(astrocentricObserverPos,
                              xfrustum,
@@ -2847,7 +3320,9 @@ void Renderer::draw(const Observer& observer,
     // Render deep sky objects
     if ((renderFlags & ShowDSO) != 0 && universe.getDSOCatalog() != nullptr)
     {
+        beginPass("deep sky objects");
         renderDeepSkyObjects(universe, observer, faintestMag);
+        endPass("deep sky objects");
     }
 
     // Translate the camera before rendering the stars
@@ -2866,7 +3341,9 @@ void Renderer::draw(const Observer& observer,
         if (toggleAA)
             glDisable(GL_MULTISAMPLE);
 
+        beginPass("point stars");
         renderPointStars(*universe.getStarCatalog(), faintestMag, observer);
+        endPass("point stars");
 
         if (toggleAA)
             glEnable(GL_MULTISAMPLE);
@@ -2876,6 +3353,9 @@ void Renderer::draw(const Observer& observer,
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 #endif
 
+    if ((renderFlags & ShowOctree) != 0)
+        renderOctreeHeatmap(observerPosLY);
+
     glTranslatef(-observerPosLY.x(), -observerPosLY.y(), -observerPosLY.z());
 
 
@@ -2883,7 +3363,10 @@ void Renderer::draw(const Observer& observer,
     renderAsterisms(universe, dist);
     renderBoundaries(universe, dist);
 
-    // Render star and deep sky object labels
+    // Render star and deep sky object labels; the scored candidates
+    // collected during traversal are reduced to the per-frame label
+    // budget before any names are resolved.
+    commitLabelCandidates(universe);
     renderBackgroundAnnotations(FontNormal);
 
     // Render constellations labels
@@ -2898,7 +3381,7 @@ void Renderer::draw(const Observer& observer,
 
     if ((renderFlags & ShowMarkers) != 0)
     {
-        renderMarkers(*universe.getMarkers(),
+        renderMarkers(universe,
                       observer.getPosition(),
                       observer.getOrientation(),
                       now);
@@ -2912,7 +3395,9 @@ void Renderer::draw(const Observer& observer,
     bool selectionVisible = false;
     if (!sel.empty() && (renderFlags & ShowMarkers) != 0)
     {
-        Vector3d offset = sel.getPosition(now).offsetFromKm(observer.getPosition());
+        Vector3d offset = sel.body() != nullptr
+            ? cachedBodyOffsetKm(sel.body(), now, observer.getPosition())
+            : sel.getPosition(now).offsetFromKm(observer.getPosition());
 
         static MarkerRepresentation cursorRep(MarkerRepresentation::Crosshair);
         selectionVisible = xfrustum.testSphere(offset, sel.radius()) != Frustum::Outside;
@@ -3117,7 +3602,7 @@ void Renderer::draw(const Observer& observer,
         // ideal for performance; should render opaque objects front to
         // back, then translucent objects back to front. However, the
         // amount of overdraw in Celestia is typically low.)
-        sort(renderList.begin(), renderList.end());
+        depthSortRenderList(renderList, frameArena);
 
         // Sort the annotations
         sort(depthSortedAnnotations.begin(), depthSortedAnnotations.end());
@@ -3316,12 +3801,14 @@ void Renderer::draw(const Observer& observer,
         vector<Annotation>::iterator annotation = depthSortedAnnotations.begin();
 
         // Render everything that wasn't culled.
+        vector<OcclusionQueryCandidate> occlusionCandidates;
         float intervalSize = 1.0f / (float) max(1, nIntervals);
         i = nEntries - 1;
         for (int interval = 0; interval < nIntervals; interval++)
         {
             currentIntervalIndex = interval;
             beginObjectAnnotations();
+            occlusionCandidates.clear();
 
             float nearPlaneDistance = -depthPartitions[interval].nearZ;
             float farPlaneDistance  = -depthPartitions[interval].farZ;
@@ -3353,7 +3840,8 @@ void Renderer::draw(const Observer& observer,
 #endif
             int firstInInterval = i;
 
-            // Render just the opaque objects in the first pass
+            // Collect the opaque objects for the first pass
+            vector<int> opaqueItems;
             while (i >= 0 && renderList[i].farZ < depthPartitions[interval].nearZ)
             {
                 // This interval should completely contain the item
@@ -3392,11 +3880,76 @@ void Renderer::draw(const Observer& observer,
                 // Treat objects that are smaller than one pixel as transparent and render
                 // them in the second pass.
                 if (renderList[i].isOpaque && renderList[i].discSizeInPixels > 1.0f)
-                    renderItem(renderList[i], observer, m_cameraOrientation, nearPlaneDistance, farPlaneDistance);
+                    opaqueItems.push_back(i);
 
                 i--;
             }
 
+            // Group opaque draws by render state so consecutive items
+            // reuse program, texture, and buffer bindings instead of
+            // cycling them on every draw. The shader program chosen for
+            // a body is driven by its surface appearance flags, and
+            // binding churn by the model and base texture, so those
+            // form the key; the preceding depth sort is kept as the
+            // tiebreaker by the stable sort. Opaque draws are depth
+            // tested, so regrouping them doesn't change the image.
+            auto stateKey = [this](int index)
+                -> std::tuple<int, ResourceHandle, uint32_t, ResourceHandle>
+            {
+                const RenderListEntry& rle = renderList[index];
+                if (rle.renderableType == RenderListEntry::RenderableBody)
+                {
+                    const Surface& surface = rle.body->getSurface();
+                    return std::make_tuple((int) rle.renderableType,
+                                           rle.body->getGeometry(),
+                                           surface.appearanceFlags,
+                                           surface.baseTexture.tex[textureResolution]);
+                }
+
+                return std::make_tuple((int) rle.renderableType,
+                                       InvalidResource,
+                                       (uint32_t) 0,
+                                       InvalidResource);
+            };
+
+            if (opaqueItems.size() > 1)
+            {
+                stable_sort(opaqueItems.begin(), opaqueItems.end(),
+                            [&stateKey](int a, int b)
+                            {
+                                return stateKey(a) < stateKey(b);
+                            });
+            }
+
+            // Render just the opaque objects in the first pass
+            for (int index : opaqueItems)
+            {
+                RenderCommand cmd;
+                cmd.item = renderList[index];
+                cmd.nearPlaneDistance = nearPlaneDistance;
+                cmd.farPlaneDistance = farPlaneDistance;
+                recordRenderCommand(cmd, observer);
+
+                // A body with a visible disc may still append a halo
+                // sprite; flush right after it to keep the draw order
+                // of the unbatched renderer.
+                cmd.type = RenderCommand::FlushPointBatch;
+                recordRenderCommand(cmd, observer);
+
+                // Bodies carrying real geometry get a bounding quad
+                // occlusion query once the interval is complete.
+                if (renderList[index].renderableType == RenderListEntry::RenderableBody)
+                {
+                    occlusionCandidates.push_back({ renderList[index].body,
+                                                    renderList[index].position,
+                                                    renderList[index].radius });
+                }
+            }
+
+            // Submit the pass: replay the recorded commands on the GL
+            // thread in recording order.
+            drainRenderCommands(observer);
+
             // Render orbit paths
             if (!orbitPathList.empty())
             {
@@ -3435,7 +3988,9 @@ void Renderer::draw(const Observer& observer,
                         }
 #endif
                         orbitsRendered++;
+                        beginPass("orbits");
                         renderOrbit(orbit, now, m_cameraOrientation.cast<double>(), intervalFrustum, nearPlaneDistance, farPlaneDistance);
+                        endPass("orbits");
 
 #if DEBUG_COALESCE
                         if (highlightObject.body() == orbit.body)
@@ -3459,11 +4014,51 @@ void Renderer::draw(const Observer& observer,
             while (i >= 0 && renderList[i].farZ < depthPartitions[interval].nearZ)
             {
                 if (!renderList[i].isOpaque || renderList[i].discSizeInPixels <= 1.0f)
-                    renderItem(renderList[i], observer, m_cameraOrientation, nearPlaneDistance, farPlaneDistance);
+                {
+                    // Bodies and stars small enough to be drawn as points
+                    // just accumulate sprites in the body point batch;
+                    // anything that draws real geometry acts as a flush
+                    // point so the blending order is preserved.
+                    bool batched = (renderList[i].renderableType == RenderListEntry::RenderableBody ||
+                                    renderList[i].renderableType == RenderListEntry::RenderableStar) &&
+                                   renderList[i].discSizeInPixels <= 1.0f;
+
+                    RenderCommand cmd;
+                    if (!batched)
+                    {
+                        cmd.type = RenderCommand::FlushPointBatch;
+                        recordRenderCommand(cmd, observer);
+                    }
+
+                    cmd.type = RenderCommand::DrawItem;
+                    cmd.item = renderList[i];
+                    cmd.nearPlaneDistance = nearPlaneDistance;
+                    cmd.farPlaneDistance = farPlaneDistance;
+                    recordRenderCommand(cmd, observer);
+
+                    if (!batched)
+                    {
+                        cmd.type = RenderCommand::FlushPointBatch;
+                        recordRenderCommand(cmd, observer);
+                    }
+                }
 
                 i--;
             }
 
+            // Submit the pass, ending with any point-like bodies still
+            // accumulated in the batch.
+            {
+                RenderCommand cmd;
+                cmd.type = RenderCommand::FlushPointBatch;
+                recordRenderCommand(cmd, observer);
+            }
+            drainRenderCommands(observer);
+
+            // Test the interval's geometry-bearing bodies against its
+            // finished depth buffer; results drive next frame's culling.
+            issueOcclusionQueries(occlusionCandidates);
+
             // Render annotations in this interval
             enableSmoothLines(renderFlags);
             annotation = renderSortedAnnotations(annotation, -depthPartitions[interval].nearZ, -depthPartitions[interval].farZ, FontNormal);
@@ -3542,6 +4137,7 @@ void Renderer::renderObjectAsPoint(const Vector3f& position,
                                    bool useHalos,
                                    bool emissive)
 {
+    CELZONE("render/objectAsPoint");
     float maxDiscSize = (starStyle == ScaledDiscStars) ? MaxScaledDiscStarSize : 1.0f;
     float maxBlendDiscSize = maxDiscSize + 3.0f;
 
@@ -3622,42 +4218,25 @@ void Renderer::renderObjectAsPoint(const Vector3f& position,
         // object, and on a plane normal to the view direction.
         center = center + direction * (radius / (m * Vector3f::UnitZ()).dot(direction));
 
-        glEnable(GL_DEPTH_TEST);
 #if !defined(NO_MAX_POINT_SIZE)
         // TODO: OpenGL appears to limit the max point size unless we
         // actually set up a shader that writes the pointsize values. To get
         // around this, we'll use billboards.
-        Vector3f v0 = m * Vector3f(-1, -1, 0);
-        Vector3f v1 = m * Vector3f( 1, -1, 0);
-        Vector3f v2 = m * Vector3f( 1,  1, 0);
-        Vector3f v3 = m * Vector3f(-1,  1, 0);
+        //
+        // The billboards aren't drawn here: they're appended to the
+        // body point batch and submitted in bulk at the next flush
+        // point, so thousands of point-like bodies cost a handful of
+        // draw calls instead of one apiece.
         float distanceAdjust = pixelSize * center.norm() * 0.5f;
 
         if (starStyle == PointStars)
         {
-            glDisable(GL_TEXTURE_2D);
-            glBegin(GL_POINTS);
-            glColor(color, alpha);
-            glVertex(center);
-            glEnd();
-            glEnable(GL_TEXTURE_2D);
+            bodyPointBatch->addPoint(center, Color(color, alpha));
         }
         else
         {
-            gaussianDiscTex->bind();
-
             pointSize *= distanceAdjust;
-            glBegin(GL_QUADS);
-            glColor(color, alpha);
-            glTexCoord2f(0, 1);
-            glVertex(center + (v0 * pointSize));
-            glTexCoord2f(1, 1);
-            glVertex(center + (v1 * pointSize));
-            glTexCoord2f(1, 0);
-            glVertex(center + (v2 * pointSize));
-            glTexCoord2f(0, 0);
-            glVertex(center + (v3 * pointSize));
-            glEnd();
+            bodyPointBatch->addSprite(center, pointSize, Color(color, alpha));
         }
 
         // If the object is brighter than magnitude 1, add a halo around it to
@@ -3668,22 +4247,11 @@ void Renderer::renderObjectAsPoint(const Vector3f& position,
         // with halos.
         if (useHalos && glareAlpha > 0.0f)
         {
-            gaussianGlareTex->bind();
-
             glareSize *= distanceAdjust;
-            glBegin(GL_QUADS);
-            glColor(color, glareAlpha);
-            glTexCoord2f(0, 1);
-            glVertex(center + (v0 * glareSize));
-            glTexCoord2f(1, 1);
-            glVertex(center + (v1 * glareSize));
-            glTexCoord2f(1, 0);
-            glVertex(center + (v2 * glareSize));
-            glTexCoord2f(0, 0);
-            glVertex(center + (v3 * glareSize));
-            glEnd();
+            bodyPointBatch->addGlare(center, glareSize, Color(color, glareAlpha));
         }
 #else
+        glEnable(GL_DEPTH_TEST);
         // Disabled because of point size limits
         glEnable(GL_POINT_SPRITE);
         glTexEnvi(GL_POINT_SPRITE, GL_COORD_REPLACE, GL_TRUE);
@@ -3743,6 +4311,7 @@ void Renderer::renderEllipsoidAtmosphere(const Atmosphere& atmosphere,
                                          float pixSize,
                                          bool lit)
 {
+    CELZONE("render/atmosphere");
     if (atmosphere.height == 0.0f)
         return;
 
@@ -4080,6 +4649,7 @@ void Renderer::renderLocations(const Body& body,
                                const Vector3d& bodyPosition,
                                const Quaterniond& bodyOrientation)
 {
+    CELZONE("render/locations");
     const vector<Location*>* locations = body.getLocations();
 
     if (locations == nullptr)
@@ -4101,7 +4671,30 @@ void Renderer::renderLocations(const Body& body,
 
     Matrix3d bodyMatrix = bodyOrientation.conjugate().toRotationMatrix();
 
-    for (const auto location : *locations)
+    // Prune against the visible cap before doing any per-location work:
+    // only features within the region of the surface that can face the
+    // observer need the ray test below. The cap is the geometric horizon
+    // for the inscribed sphere, padded to cover label elevation (labels
+    // on non-ellipsoidal bodies are projected onto 1.01x the bounding
+    // sphere) plus a little slack.
+    double observerDistance = viewRayOrigin.norm();
+    double minSemiAxis = (double) semiAxes.minCoeff();
+    double capAngle = PI;
+    Vector3d capCenter = Vector3d::UnitX();
+    if (observerDistance > 0.0)
+    {
+        capCenter = viewRayOrigin / observerDistance;
+        if (observerDistance > minSemiAxis && minSemiAxis > 0.0)
+        {
+            capAngle = acos(minSemiAxis / observerDistance) +
+                       acos(std::min(1.0, minSemiAxis / (boundingRadius * 1.02))) + 0.05;
+        }
+    }
+
+    vector<Location*> candidateLocations;
+    body.findLocationsInCap(capCenter, capAngle, candidateLocations);
+
+    for (const auto location : candidateLocations)
     {
         auto featureType = location->getFeatureType();
         if ((featureType & locationFilter) != 0)
@@ -4409,6 +5002,7 @@ void Renderer::renderObject(const Vector3f& pos,
                             RenderProperties& obj,
                             const LightingState& ls)
 {
+    CELZONE("render/object");
     RenderInfo ri;
 
     float altitude = distance - obj.radius;
@@ -4433,10 +5027,19 @@ void Renderer::renderObject(const Vector3f& pos,
     // Get the object's geometry; nullptr indicates that object is an
     // ellipsoid.
     Geometry* geometry = nullptr;
+    bool geometryPending = false;
     if (obj.geometry != InvalidResource)
     {
         // This is a model loaded from a file
         geometry = GetGeometryManager()->find(obj.geometry);
+        if (geometry == nullptr)
+        {
+            // Models load on a background thread; render the bounding
+            // ellipsoid as a placeholder until the mesh is ready. A failed
+            // load leaves the body invisible, as it always has.
+            const GeometryInfo* info = GetGeometryManager()->getResourceInfo(obj.geometry);
+            geometryPending = info != nullptr && info->state == ResourceLoading;
+        }
     }
 
     // Get the textures . . .
@@ -4583,9 +5186,11 @@ void Renderer::renderObject(const Vector3f& pos,
             cloudTexOffset = (float) (-pfmod(now * atmosphere->cloudSpeed / (2 * PI), 1.0));
     }
 
-    if (obj.geometry == InvalidResource)
+    if (obj.geometry == InvalidResource || geometryPending)
     {
-        // A null model indicates that this body is a sphere
+        // A null model indicates that this body is a sphere; a pending
+        // model is stood in for by the bounding ellipsoid until the
+        // background load completes.
         if (lit)
         {
             renderEllipsoid_GLSL(ri, ls,
@@ -4804,6 +5409,56 @@ void Renderer::renderObject(const Vector3f& pos,
 }
 
 
+const Renderer::EclipseCasterState&
+Renderer::eclipseCasterState(const Body& body, double now)
+{
+    auto iter = eclipseCasterCache.find(&body);
+    if (iter != eclipseCasterCache.end() && iter->second.time == now)
+        return iter->second;
+
+    EclipseCasterState& state = eclipseCasterCache[&body];
+    state.time = now;
+    state.position = body.getAstrocentricPosition(now);
+    state.canCastShadows = body.hasVisibleGeometry() &&
+                           body.extant(now) &&
+                           body.isEllipsoid();
+
+    // The orientation is only needed for ring shadow tests
+    if (body.getRings() != nullptr)
+        state.orientation = body.getOrientation(now);
+
+    return state;
+}
+
+
+Vector3d
+Renderer::cachedBodyOffsetKm(const Body* body, double t, const UniversalCoord& origin)
+{
+    // Callers outside the normal frame sequence (or a viewpoint that
+    // changed mid-frame) get a freshly keyed table instead of stale data.
+    if (t != bodyOffsetTime ||
+        !(origin.x == bodyOffsetOrigin.x &&
+          origin.y == bodyOffsetOrigin.y &&
+          origin.z == bodyOffsetOrigin.z))
+    {
+        bodyOffsetIndex.clear();
+        bodyOffsets.clear();
+        bodyOffsetTime = t;
+        bodyOffsetOrigin = origin;
+    }
+
+    auto iter = bodyOffsetIndex.find(body);
+    if (iter != bodyOffsetIndex.end())
+        return bodyOffsets[iter->second];
+
+    Vector3d offset = body->getPosition(t).offsetFromKm(origin);
+    bodyOffsetIndex[body] = (unsigned int) bodyOffsets.size();
+    bodyOffsets.push_back(offset);
+
+    return offset;
+}
+
+
 bool Renderer::testEclipse(const Body& receiver,
                            const Body& caster,
                            LightingState& lightingState,
@@ -4814,14 +5469,14 @@ bool Renderer::testEclipse(const Body& receiver,
     LightingState::EclipseShadowVector& shadows = *lightingState.shadows[lightIndex];
     bool isReceiverShadowed = false;
 
+    const EclipseCasterState& casterState = eclipseCasterState(caster, now);
+
     // Ignore situations where the shadow casting body is much smaller than
     // the receiver, as these shadows aren't likely to be relevant.  Also,
     // ignore eclipses where the caster is not an ellipsoid, since we can't
     // generate correct shadows in this case.
     if (caster.getRadius() >= receiver.getRadius() * MinRelativeOccluderRadius &&
-        caster.hasVisibleGeometry() &&
-        caster.extant(now) &&
-        caster.isEllipsoid())
+        casterState.canCastShadows)
     {
         // All of the eclipse related code assumes that both the caster
         // and receiver are spherical.  Irregular receivers will work more
@@ -4831,8 +5486,8 @@ bool Renderer::testEclipse(const Body& receiver,
         // less than the distance between the sun and the receiver.  This
         // approximation works everywhere in the solar system, and is likely
         // valid for any orbitally stable pair of objects orbiting a star.
-        Vector3d posReceiver = receiver.getAstrocentricPosition(now);
-        Vector3d posCaster = caster.getAstrocentricPosition(now);
+        Vector3d posReceiver = eclipseCasterState(receiver, now).position;
+        Vector3d posCaster = casterState.position;
 
         //const Star* sun = receiver.getSystem()->getStar();
         //assert(sun != nullptr);
@@ -4909,7 +5564,7 @@ bool Renderer::testEclipse(const Body& receiver,
             {
                 // Possible intersection, but it depends on the orientation of the
                 // rings.
-                Quaterniond casterOrientation = caster.getOrientation(now);
+                const Quaterniond& casterOrientation = casterState.orientation;
                 Vector3d ringPlaneNormal = casterOrientation * Vector3d::UnitY();
                 Vector3d shadowDirection = lightToCasterDir.normalized();
                 Vector3d v = ringPlaneNormal.cross(shadowDirection);
@@ -4951,21 +5606,262 @@ bool Renderer::testEclipse(const Body& receiver,
 }
 
 
-void Renderer::renderPlanet(Body& body,
-                            const Vector3f& pos,
-                            float distance,
-                            float appMag,
-                            const Observer& observer,
-                            const Quaternionf& cameraOrientation,
-                            float nearPlaneDistance,
-                            float farPlaneDistance)
+/*! Return true if last frame's occlusion query for this body found no
+ *  visible samples and the result is still fresh. Pending query results
+ *  are polled without blocking: until a result arrives the body is
+ *  treated as visible, so a stall in the query pipeline can only cost
+ *  performance, never correctness.
+ */
+bool Renderer::isBodyOccluded(const Body& body)
 {
-    double now = observer.getTime();
-    float altitude = distance - body.getRadius();
-    float discSizeInPixels = body.getRadius() /
-        (max(nearPlaneDistance, altitude) * pixelSize);
+    if (!GLEW_ARB_occlusion_query)
+        return false;
+
+    auto iter = occlusionQueries.find(&body);
+    if (iter == occlusionQueries.end())
+        return false;
 
-    if (discSizeInPixels > 1 && body.hasVisibleGeometry())
+    OcclusionQueryInfo& info = iter->second;
+    if (info.pending)
+    {
+        GLuint available = 0;
+        glGetQueryObjectuiv(info.id, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != 0)
+        {
+            GLuint samples = 0;
+            glGetQueryObjectuiv(info.id, GL_QUERY_RESULT, &samples);
+            info.occluded = samples == 0;
+            info.pending = false;
+        }
+    }
+
+    // Ignore stale results; the camera or the bodies may have moved a
+    // long way since the query was issued.
+    return info.occluded && frameCount - info.queryFrame <= 2;
+}
+
+
+/*! Issue occlusion queries for the bodies drawn with full geometry in
+ *  the depth interval just rendered. Each body is reduced to a camera
+ *  aligned quad on the near tangent plane of its bounding sphere, drawn
+ *  with color and depth writes disabled against the interval's finished
+ *  depth buffer. The results are consumed by isBodyOccluded() on the
+ *  following frames, letting renderPlanet skip the surface, atmosphere
+ *  and ring passes of bodies hidden behind others.
+ */
+void Renderer::issueOcclusionQueries(const vector<OcclusionQueryCandidate>& candidates)
+{
+    // With fewer than two bodies carrying geometry there is nothing
+    // around to occlude them; don't pay for the queries.
+    if (!GLEW_ARB_occlusion_query || candidates.size() < 2)
+        return;
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glUseProgram(0);
+
+    Matrix3f m = m_cameraOrientation.conjugate().toRotationMatrix();
+    Vector3f v0 = m * Vector3f(-1, -1, 0);
+    Vector3f v1 = m * Vector3f( 1, -1, 0);
+    Vector3f v2 = m * Vector3f( 1,  1, 0);
+    Vector3f v3 = m * Vector3f(-1,  1, 0);
+
+    for (const auto& candidate : candidates)
+    {
+        OcclusionQueryInfo& info = occlusionQueries[candidate.body];
+        if (info.id == 0)
+            glGenQueries(1, &info.id);
+        else if (info.pending)
+            continue; // last frame's result hasn't been retrieved yet
+
+        // The quad sits on the near tangent plane with the sphere
+        // radius as its half-size, which covers strictly more screen
+        // area at strictly nearer depth than the body itself: a body
+        // is only reported occluded if the quad is fully buried.
+        Vector3f direction = candidate.position.normalized();
+        Vector3f center = candidate.position - direction * candidate.radius;
+        float size = candidate.radius;
+
+        glBeginQuery(GL_SAMPLES_PASSED, info.id);
+        glBegin(GL_QUADS);
+        glVertex(center + (v0 * size));
+        glVertex(center + (v1 * size));
+        glVertex(center + (v2 * size));
+        glVertex(center + (v3 * size));
+        glEnd();
+        glEndQuery(GL_SAMPLES_PASSED);
+
+        info.pending = true;
+        info.queryFrame = frameCount;
+    }
+
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+}
+
+
+void Renderer::setPassTimingEnabled(bool enable)
+{
+    if (passTimingEnabled && !enable)
+    {
+        for (auto& profile : passProfiles)
+        {
+            if (profile.second.queries[0] != 0)
+                glDeleteQueries(2, profile.second.queries);
+        }
+        passProfiles.clear();
+    }
+    passTimingEnabled = enable;
+}
+
+
+map<string, Renderer::PassTiming> Renderer::getPassTimings() const
+{
+    map<string, PassTiming> timings;
+    for (const auto& profile : passProfiles)
+        timings[profile.first] = profile.second.smoothed;
+    return timings;
+}
+
+
+void Renderer::beginPass(const char* name)
+{
+    if (!passTimingEnabled)
+        return;
+
+    // GL_TIME_ELAPSED queries may not nest; when a pass is already
+    // being measured, record CPU time only for this one.
+    bool queryActive = false;
+    for (const auto& profile : passProfiles)
+        queryActive = queryActive || profile.second.activeQuery >= 0;
+
+    PassProfile& profile = passProfiles[name];
+    profile.cpuStart = passTimer.getTime();
+
+    if (!GLEW_ARB_timer_query || queryActive)
+        return;
+
+    if (profile.queries[0] == 0)
+        glGenQueries(2, profile.queries);
+
+    // Collect results from previously issued queries without blocking;
+    // a query typically completes one or two frames after it is issued.
+    for (int i = 0; i < 2; i++)
+    {
+        if (!profile.pending[i])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(profile.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(profile.queries[i], GL_QUERY_RESULT, &elapsed);
+            profile.frameGpuMs += (double) elapsed * 1.0e-6;
+            profile.pending[i] = false;
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (!profile.pending[i])
+        {
+            glBeginQuery(GL_TIME_ELAPSED, profile.queries[i]);
+            profile.activeQuery = i;
+            break;
+        }
+    }
+}
+
+
+void Renderer::endPass(const char* name)
+{
+    if (!passTimingEnabled)
+        return;
+
+    PassProfile& profile = passProfiles[name];
+    profile.frameCpuMs += (passTimer.getTime() - profile.cpuStart) * 1000.0;
+
+    if (profile.activeQuery >= 0)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        profile.pending[profile.activeQuery] = true;
+        profile.activeQuery = -1;
+    }
+}
+
+
+void Renderer::updatePassTimings()
+{
+    if (!passTimingEnabled)
+        return;
+
+    // Fold the totals accumulated over the previous frame into the
+    // rolling averages. GPU results arrive a frame or two late, so they
+    // lag the CPU numbers slightly; for a rolling average that is fine.
+    const double smoothing = 0.05;
+    for (auto& entry : passProfiles)
+    {
+        PassProfile& profile = entry.second;
+        profile.smoothed.cpuTimeMs += (profile.frameCpuMs - profile.smoothed.cpuTimeMs) * smoothing;
+        profile.smoothed.gpuTimeMs += (profile.frameGpuMs - profile.smoothed.gpuTimeMs) * smoothing;
+        profile.frameCpuMs = 0.0;
+        profile.frameGpuMs = 0.0;
+    }
+}
+
+
+// Pass name for per-class body timing; the cost profile of a planet
+// with atmosphere and rings is very different from that of a spacecraft
+// mesh, so they are reported separately.
+static const char* bodyClassPassName(int classification)
+{
+    switch (classification)
+    {
+    case Body::Planet:
+    case Body::DwarfPlanet:
+        return "planets";
+    case Body::Moon:
+    case Body::MinorMoon:
+        return "moons";
+    case Body::Asteroid:
+        return "asteroids";
+    case Body::Comet:
+        return "comets";
+    case Body::Spacecraft:
+        return "spacecraft";
+    default:
+        return "other bodies";
+    }
+}
+
+
+void Renderer::renderPlanet(Body& body,
+                            const Vector3f& pos,
+                            float distance,
+                            float appMag,
+                            const Observer& observer,
+                            const Quaternionf& cameraOrientation,
+                            float nearPlaneDistance,
+                            float farPlaneDistance)
+{
+    CELZONE("render/planet");
+    const char* passName = bodyClassPassName(body.getClassification());
+    beginPass(passName);
+
+    double now = observer.getTime();
+    float altitude = distance - body.getRadius();
+    float discSizeInPixels = body.getRadius() /
+        (max(nearPlaneDistance, altitude) * pixelSize);
+
+    // Skip the surface, atmosphere and ring passes when last frame's
+    // occlusion query saw no visible samples; the depth interval loop
+    // still issues a fresh query each frame, so the body starts
+    // rendering again as soon as it emerges.
+    if (discSizeInPixels > 1 && body.hasVisibleGeometry() && !isBodyOccluded(body))
     {
         RenderProperties rp;
 
@@ -5221,7 +6117,7 @@ void Renderer::renderPlanet(Body& body,
 
             // We need a double precision body-relative position of the
             // observer, otherwise location labels will tend to jitter.
-            Vector3d posd = body.getPosition(observer.getTime()).offsetFromKm(observer.getPosition());
+            Vector3d posd = cachedBodyOffsetKm(&body, observer.getTime(), observer.getPosition());
             renderLocations(body, posd, q);
 
             glDisable(GL_DEPTH_TEST);
@@ -5249,6 +6145,8 @@ void Renderer::renderPlanet(Body& body,
 #ifdef USE_HDR
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 #endif
+
+    endPass(passName);
 }
 
 
@@ -5261,6 +6159,7 @@ void Renderer::renderStar(const Star& star,
                           float nearPlaneDistance,
                           float farPlaneDistance)
 {
+    CELZONE("render/star");
     if (!star.getVisibility())
         return;
 
@@ -5371,6 +6270,7 @@ void Renderer::renderCometTail(const Body& body,
                                const Observer& observer,
                                float discSizeInPixels)
 {
+    CELZONE("render/cometTail");
     auto prog = shaderManager->getShader("comet");
     if (prog == nullptr)
         return;
@@ -5518,7 +6418,7 @@ void Renderer::renderCometTail(const Body& body,
     float fadeFactor = 0.5f * (1.0f - tanh(fadeDistance - 1.0f / fadeDistance));
     prog->floatParam("fadeFactor") = fadeFactor;
 
-    vector<unsigned short> indices;
+    vector<unsigned short, ArenaAllocator<unsigned short>> indices{ ArenaAllocator<unsigned short>(frameArena) };
     indices.reserve(nTailSlices * 2 + 2);
     for (int j = 0; j < nTailSlices; j++)
     {
@@ -5594,6 +6494,7 @@ void Renderer::renderReferenceMark(const ReferenceMark& refMark,
 
 void Renderer::renderAsterisms(const Universe& universe, float dist)
 {
+    CELZONE("render/asterisms");
     if ((renderFlags & ShowDiagrams) == 0 || universe.getAsterisms() == nullptr)
         return;
 
@@ -5613,6 +6514,7 @@ void Renderer::renderAsterisms(const Universe& universe, float dist)
 
 void Renderer::renderBoundaries(const Universe& universe, float dist)
 {
+    CELZONE("render/boundaries");
     if ((renderFlags & ShowBoundaries) == 0 || universe.getBoundaries() == nullptr)
         return;
 
@@ -5733,6 +6635,30 @@ void Renderer::addRenderListEntries(RenderListEntry& rle,
 }
 
 
+// Result of the per-body visibility and culling math performed while
+// walking a FrameTree. Worker threads only fill these in; the render
+// thread alone consumes them, so the render lists and the resource
+// managers are touched from a single thread.
+struct FrameTreeChildResult
+{
+    const TimelinePhase* phase{ nullptr };
+    bool addEntry{ false };
+    bool isLabeled{ false };
+    bool hasIlluminator{ false };
+    bool traverseSubtree{ false };
+    bool deferrable{ false };
+    SecondaryIlluminator illum;
+    RenderListEntry rle;
+    Vector3d subtreeCenter{ Vector3d::Zero() };
+};
+
+// Minimum number of direct children of a frame tree before
+// buildRenderLists spreads the per-body math across threads; smaller
+// trees aren't worth the scheduling overhead. The targets are large
+// flat trees such as asteroid catalog add-ons.
+static const unsigned int ParallelTraversalThreshold = 1024;
+
+
 void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
                                 const Frustum& viewFrustum,
                                 const Vector3d& viewPlaneNormal,
@@ -5741,6 +6667,7 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
                                 const Observer& observer,
                                 double now)
 {
+    CELZONE("render/buildRenderLists");
     int labelClassMask = translateLabelModeToClassMask(labelMode);
 
     Matrix3f viewMat = observer.getOrientationf().toRotationMatrix();
@@ -5749,13 +6676,52 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
     double sinViewAngle = sqrt(1.0 - square(cosViewConeAngle));
 
     unsigned int nChildren = tree != nullptr ? tree->childCount() : 0;
-    for (unsigned int i = 0; i < nChildren; i++)
-    {
-        auto phase = tree->getChild(i);
 
-        // No need to do anything if the phase isn't active now
-        if (!phase->includes(now))
-            continue;
+    // Packed per-child visibility table, rebuilt by the frame tree
+    // whenever a body changes. Scanning it linearly rejects children
+    // that cannot contribute anything to this frame -- wrong class or
+    // marked invisible, with no subtree and no planetshine -- before
+    // their positions are even computed, which matters for large flat
+    // trees like asteroid catalog add-ons with their class turned off.
+    const std::vector<uint32_t>* childVisibility = tree != nullptr
+        ? &tree->childVisibility() : nullptr;
+    bool haveVisibilityTable = childVisibility != nullptr &&
+                               childVisibility->size() == nChildren;
+
+    auto rejectChild = [&](unsigned int i)
+    {
+        if (!haveVisibilityTable)
+            return false;
+
+        uint32_t vis = (*childVisibility)[i];
+        if ((vis & (FrameTree::ChildHasSubtree | FrameTree::ChildSecondaryIlluminator)) != 0)
+            return false;
+
+        uint32_t klass = vis & FrameTree::ChildClassificationMask;
+        // Surface features inherit visibility from their parent body,
+        // so they are never rejected here.
+        if (klass == (uint32_t) Body::SurfaceFeature)
+            return false;
+
+        if ((vis & FrameTree::ChildVisible) == 0)
+            return true;
+
+        // Diffuse objects have no class-based visibility control
+        return klass != (uint32_t) Body::Diffuse &&
+               (klass & (uint32_t) bodyVisibilityMask) == 0;
+    };
+
+    // Evaluate a single child of the tree: position, culling tests,
+    // apparent magnitude, and the subtree rejection tests. Renderer
+    // state is only read and all output goes to result, but the orbit
+    // and frame queries go through the ephemeris layer's single-entry
+    // time caches, which are written on a cache miss. Concurrent
+    // callers must therefore guarantee that every cache reachable from
+    // here has already been primed at the evaluation time; see the
+    // warm-up pass in the parallel branch below.
+    auto evaluateChild = [&](const TimelinePhase* phase, FrameTreeChildResult& result)
+    {
+        result.phase = phase;
 
         Body* body = phase->body();
 
@@ -5801,11 +6767,10 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
                         clog << "Planetshine: " << body->getName()
                              << ", " << body->getRadius() / (float) pos_v.length() / pixelSize << endl;
 #endif
-                        SecondaryIlluminator illum;
-                        illum.body = body;
-                        illum.position_v = pos_v;
-                        illum.radius = body->getRadius();
-                        secondaryIlluminators.push_back(illum);
+                        result.hasIlluminator = true;
+                        result.illum.body = body;
+                        result.illum.position_v = pos_v;
+                        result.illum.radius = body->getRadius();
                     }
                 }
                 else
@@ -5854,7 +6819,7 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
 
             if ((discSize > 1 || visibleAsPoint || isLabeled) && isBodyVisible(body, bodyVisibilityMask))
             {
-                RenderListEntry rle;
+                RenderListEntry& rle = result.rle;
 
                 rle.position = pos_v.cast<float>();
                 rle.distance = (float) dist_v;
@@ -5868,11 +6833,14 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
                 // defined relative to the SSB.)
                 rle.sun = -pos_s.cast<float>();
 
-                addRenderListEntries(rle, *body, isLabeled);
+                result.addEntry = true;
+                result.isLabeled = isLabeled;
             }
         }
 
         const FrameTree* subtree = body->getFrameTree();
+        float brightestPossible = -100.0f;
+        float largestPossible = 100.0f;
         if (subtree != nullptr)
         {
             double dist_v = pos_v.norm();
@@ -5887,8 +6855,8 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
             // true or when a subtree object could potentially illuminate something
             // in the view cone.
             auto minPossibleDistance = (float) (dist_v - subtree->boundingSphereRadius());
-            float brightestPossible = 0.0;
-            float largestPossible = 0.0;
+            brightestPossible = 0.0f;
+            largestPossible = 0.0f;
 
             // If the viewer is not within the subtree bounding sphere, see if we can cull it because
             // it contains no objects brighter than the limiting magnitude and no objects that will
@@ -5946,15 +6914,200 @@ void Renderer::buildRenderLists(const Vector3d& astrocentricObserverPos,
 
             if (traverseSubtree)
             {
-                buildRenderLists(astrocentricObserverPos,
-                                 viewFrustum,
-                                 viewPlaneNormal,
-                                 pos_s,
-                                 subtree,
-                                 observer,
-                                 now);
+                result.traverseSubtree = true;
+                result.subtreeCenter = pos_s;
             }
-        } // end subtree traverse
+        } // end subtree tests
+
+        // Decide whether this body may skip evaluation for the next few
+        // frames. None of the tests may depend on the view direction --
+        // the camera can turn freely before the next evaluation -- so a
+        // body qualifies only if it would be invisible from any
+        // direction: well below the magnitude cutoff, covering a small
+        // fraction of a pixel, unlabeled, not an illuminator, and with
+        // no subtree containing anything that could be bright or large
+        // enough to render or to illuminate something else.
+        if (!result.addEntry && !result.hasIlluminator && !result.traverseSubtree &&
+            !body->isSecondaryIlluminator() &&
+            (body->getOrbitClassification() & labelClassMask) == 0)
+        {
+            double dist_v = pos_v.norm();
+            float discSize = (body->getCullingRadius() / (float) dist_v) / pixelSize;
+
+            float appMag = 100.0f;
+            for (unsigned int li = 0; li < lightSourceList.size(); li++)
+            {
+                Vector3d sunPos = pos_v - lightSourceList[li].position;
+                appMag = min(appMag, body->getApparentMagnitude(lightSourceList[li].luminosity, sunPos, pos_v));
+            }
+
+            if (appMag > faintestPlanetMag + DeferralMagMargin &&
+                discSize < DeferralDiscSizeLimit &&
+                (subtree == nullptr ||
+                 (!subtree->containsSecondaryIlluminators() &&
+                  brightestPossible > faintestPlanetMag + DeferralMagMargin &&
+                  largestPossible < DeferralDiscSizeLimit)))
+            {
+                result.deferrable = true;
+            }
+        }
+    };
+
+    // Consume a result on the render thread: emit the render list
+    // entries and illuminators, and recurse into accepted subtrees.
+    auto consumeResult = [&](const FrameTreeChildResult& result)
+    {
+        if (result.deferrable)
+        {
+            // Stagger re-evaluations: each phase belongs to a fixed
+            // slot derived from its address, so about 1/interval of
+            // the deferred bodies refresh on any given frame.
+            auto slot = (uint32_t) (reinterpret_cast<uintptr_t>(result.phase) >> 6);
+            BodyScheduleEntry& entry = bodyUpdateSchedule[result.phase];
+            entry.nextEvalFrame = frameCount + InvisibleBodyUpdateInterval -
+                                  (frameCount + slot) % InvisibleBodyUpdateInterval;
+            entry.evalTime = now;
+            return;
+        }
+        bodyUpdateSchedule.erase(result.phase);
+
+        if (result.hasIlluminator)
+            secondaryIlluminators.push_back(result.illum);
+
+        if (result.addEntry)
+        {
+            RenderListEntry rle = result.rle;
+            addRenderListEntries(rle, *result.phase->body(), result.isLabeled);
+        }
+
+        if (result.traverseSubtree)
+        {
+            buildRenderLists(astrocentricObserverPos,
+                             viewFrustum,
+                             viewPlaneNormal,
+                             result.subtreeCenter,
+                             result.phase->body()->getFrameTree(),
+                             observer,
+                             now);
+        }
+    };
+
+    // A body is skipped when its last evaluation found it invisible
+    // from every direction, its round-robin slot has not come up yet,
+    // and simulated time has not moved far since that evaluation. The
+    // workers only read the schedule; it is written on the render
+    // thread in consumeResult after they have been joined.
+    auto deferEvaluation = [&](const TimelinePhase* phase)
+    {
+        auto iter = bodyUpdateSchedule.find(phase);
+        return iter != bodyUpdateSchedule.end() &&
+               frameCount < iter->second.nextEvalFrame &&
+               fabs(now - iter->second.evalTime) < DeferralMaxTimeStep;
+    };
+
+    if (nChildren >= ParallelTraversalThreshold)
+    {
+        unsigned int nWorkers = max(2u, thread::hardware_concurrency());
+        unsigned int chunkSize = (nChildren + nWorkers - 1) / nWorkers;
+
+        vector<FrameTreeChildResult> results(nChildren);
+
+        // Siblings commonly share ephemeris state: every member of a
+        // satellite constellation references the parent body -- and with
+        // it the parent's CachingRotationModel and timeline phase lookup
+        // -- through its own orbit frame, and trajectory files are shared
+        // between bodies by the TrajectoryManager. The single-entry
+        // caches on that path are written on a miss, so prime them at the
+        // evaluation time on this thread first: every distinct frame
+        // (distinct frame objects may still reference the same body), and
+        // every orbit that appears under more than one child. Once a
+        // cache holds the evaluation time, further queries at that time
+        // take the read-only hit path, making the workers' concurrent
+        // lookups safe. Orbits unique to one child need no priming; they
+        // are only ever touched by that child's worker.
+        {
+            vector<const Orbit*> sharedOrbitCandidates;
+            sharedOrbitCandidates.reserve(nChildren);
+            set<const ReferenceFrame*> primedFrames;
+
+            for (unsigned int i = 0; i < nChildren; i++)
+            {
+                if (rejectChild(i))
+                    continue;
+
+                const TimelinePhase* phase = tree->getChild(i).get();
+                if (!phase->includes(now) || deferEvaluation(phase))
+                    continue;
+
+                sharedOrbitCandidates.push_back(phase->orbit());
+
+                const ReferenceFrame* frame = phase->orbitFrame().get();
+                if (primedFrames.insert(frame).second)
+                    frame->getOrientation(now);
+            }
+
+            sort(sharedOrbitCandidates.begin(), sharedOrbitCandidates.end());
+            for (size_t i = 1; i < sharedOrbitCandidates.size(); i++)
+            {
+                // Prime at the first repeat of each run of equal pointers
+                if (sharedOrbitCandidates[i] == sharedOrbitCandidates[i - 1] &&
+                    (i == 1 || sharedOrbitCandidates[i] != sharedOrbitCandidates[i - 2]))
+                {
+                    sharedOrbitCandidates[i]->positionAtTime(now);
+                }
+            }
+        }
+
+        auto evaluateRange = [&](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; i++)
+            {
+                if (rejectChild(i))
+                    continue;
+
+                const TimelinePhase* phase = tree->getChild(i).get();
+
+                // No need to do anything if the phase isn't active now
+                if (phase->includes(now) && !deferEvaluation(phase))
+                    evaluateChild(phase, results[i]);
+            }
+        };
+
+        vector<future<void>> workers;
+        for (unsigned int begin = chunkSize; begin < nChildren; begin += chunkSize)
+            workers.push_back(async(launch::async, evaluateRange, begin, min(begin + chunkSize, nChildren)));
+        evaluateRange(0, chunkSize);
+        for (auto& worker : workers)
+            worker.get();
+
+        // Merge in tree order, so the render lists end up identical to
+        // the ones a serial traversal would have produced.
+        for (unsigned int i = 0; i < nChildren; i++)
+        {
+            if (results[i].phase != nullptr)
+                consumeResult(results[i]);
+        }
+    }
+    else
+    {
+        for (unsigned int i = 0; i < nChildren; i++)
+        {
+            if (rejectChild(i))
+                continue;
+
+            const TimelinePhase* phase = tree->getChild(i).get();
+
+            // No need to do anything if the phase isn't active now
+            if (!phase->includes(now))
+                continue;
+
+            if (deferEvaluation(phase))
+                continue;
+
+            FrameTreeChildResult result;
+            evaluateChild(phase, result);
+            consumeResult(result);
+        }
     }
 }
 
@@ -5965,6 +7118,7 @@ void Renderer::buildOrbitLists(const Vector3d& astrocentricObserverPos,
                                const FrameTree* tree,
                                double now)
 {
+    CELZONE("render/buildOrbitLists");
     Matrix3d viewMat = observerOrientation.toRotationMatrix();
     Vector3d viewMatZ = viewMat.row(2);
 
@@ -6069,19 +7223,42 @@ void Renderer::buildOrbitLists(const Vector3d& astrocentricObserverPos,
 void Renderer::buildLabelLists(const Frustum& viewFrustum,
                                double now)
 {
+    CELZONE("render/buildLabelLists");
     int labelClassMask = translateLabelModeToClassMask(labelMode);
     Body* lastPrimary = nullptr;
     Sphered primarySphere;
 
-    for (auto& render_item : renderList)
+    auto nEntries = (unsigned int) renderList.size();
+
+    // Test the bounding spheres of all render list entries against the
+    // view frustum up front, 32 spheres per call, rather than making one
+    // testSphere() call per labeled body inside the loop below.
+    vector<float> cullX(nEntries), cullY(nEntries), cullZ(nEntries), cullR(nEntries);
+    for (unsigned int i = 0; i < nEntries; i++)
     {
+        cullX[i] = renderList[i].position.x();
+        cullY[i] = renderList[i].position.y();
+        cullZ[i] = renderList[i].position.z();
+        cullR[i] = renderList[i].radius;
+    }
+
+    vector<uint32_t> visibleMask((nEntries + 31) / 32, 0);
+    for (unsigned int i = 0; i < nEntries; i += 32)
+    {
+        visibleMask[i >> 5] = viewFrustum.testSpheres(&cullX[i], &cullY[i], &cullZ[i],
+                                                      &cullR[i], min(32u, nEntries - i));
+    }
+
+    for (unsigned int ri = 0; ri < nEntries; ri++)
+    {
+        RenderListEntry& render_item = renderList[ri];
         if (render_item.renderableType != RenderListEntry::RenderableBody)
             continue;
 
         int classification = render_item.body->getOrbitClassification();
 
         if ((classification & labelClassMask) != 0 &&
-            viewFrustum.testSphere(render_item.position, render_item.radius) != Frustum::Outside)
+            (visibleMask[ri >> 5] & (1u << (ri & 31u))) != 0)
         {
             const Body* body = render_item.body;
             Vector3f pos = render_item.position;
@@ -6428,9 +7605,16 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
                 float distr = 3.5f * (labelThresholdMag - appMag)/labelThresholdMag;
                 if (distr > 1.0f)
                     distr = 1.0f;
-                renderer->addBackgroundAnnotation(nullptr, starDB->getStarName(star, true),
-                                                  Color(Renderer::StarLabelColor, distr * Renderer::StarLabelColor.alpha()),
-                                                  relPos);
+
+                // Score by brightness headroom below the label
+                // threshold, with a small preference for labels near
+                // the view center; the budget pass picks the winners.
+                float importance = (labelThresholdMag - appMag) +
+                                   0.5f * starDir.dot(viewNormal);
+                renderer->addStarLabelCandidate(star,
+                                                Color(Renderer::StarLabelColor, distr * Renderer::StarLabelColor.alpha()),
+                                                relPos,
+                                                importance);
                 nLabelled++;
             }
         }
@@ -6539,6 +7723,7 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
                                 float faintestMagNight,
                                 const Observer& observer)
 {
+    CELZONE("render/pointStars");
     Vector3d obsPos = observer.getPosition().toLy();
 
     PointStarRenderer starRenderer;
@@ -6608,22 +7793,25 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
     else
         starRenderer.starVertexBuffer->startSprites();
 
-#ifdef OCTREE_DEBUG
     m_starProcStats.nodes = 0;
     m_starProcStats.height = 0;
     m_starProcStats.objects = 0;
-#endif
-    starDB.findVisibleStars(starRenderer,
-                            obsPos.cast<float>(),
-                            observer.getOrientationf(),
-                            degToRad(fov),
-                            getAspectRatio(),
-                            faintestMagNight,
-#ifdef OCTREE_DEBUG
-                            &m_starProcStats);
-#else
-                            nullptr);
-#endif
+    m_starProcStats.visitedCells = nullptr;
+    if ((renderFlags & ShowOctree) != 0)
+    {
+        m_starVisitedCells.clear();
+        m_starProcStats.visitedCells = &m_starVisitedCells;
+    }
+    double traversalStart = passTimer.getTime();
+    visibleStarSet.findVisibleStars(starDB,
+                                    starRenderer,
+                                    obsPos.cast<float>(),
+                                    observer.getOrientationf(),
+                                    degToRad(fov),
+                                    getAspectRatio(),
+                                    faintestMagNight,
+                                    &m_starProcStats);
+    m_starProcStats.timeMs = (passTimer.getTime() - traversalStart) * 1000.0;
 
     starRenderer.starVertexBuffer->render();
     starRenderer.glareVertexBuffer->render();
@@ -6632,6 +7820,71 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
 }
 
 
+// Draw the octree cells visited by this frame's star and DSO
+// traversals as wireframe cubes, tinted by occupancy: sparse cells are
+// blue, crowded cells shade through green to red. DSO cells draw at
+// half intensity so the two trees stay distinguishable when both are
+// shown. Rendered in the observer-centered frame the stars use, so the
+// cubes land exactly on the regions of the catalog being walked.
+void Renderer::renderOctreeHeatmap(const Vector3f& obsPosLY)
+{
+    if (m_starVisitedCells.empty() && m_dsoVisitedCells.empty())
+        return;
+
+    unsigned int maxObjects = 1;
+    for (const auto& cell : m_starVisitedCells)
+        maxObjects = max(maxObjects, cell.objects);
+    for (const auto& cell : m_dsoVisitedCells)
+        maxObjects = max(maxObjects, cell.objects);
+
+    glUseProgram(0);
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+
+    // The 12 edges of a cube, as pairs of corner indexes; corner bit i
+    // selects the positive half along axis i.
+    static const int edges[12][2] =
+    {
+        { 0, 1 }, { 1, 3 }, { 3, 2 }, { 2, 0 },
+        { 4, 5 }, { 5, 7 }, { 7, 6 }, { 6, 4 },
+        { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+    };
+
+    auto drawCells = [&](const vector<OctreeVisitedCell>& cells,
+                         float alphaScale)
+    {
+        glBegin(GL_LINES);
+        for (const auto& cell : cells)
+        {
+            float heat = (float) cell.objects / (float) maxObjects;
+            float r = min(1.0f, 2.0f * heat);
+            float g = 1.0f - (float) fabs(2.0f * heat - 1.0f);
+            float b = max(0.0f, 1.0f - 2.0f * heat);
+            glColor4f(r, g, b, 0.35f * alphaScale);
+
+            Vector3f center = cell.center - obsPosLY;
+            for (const auto& edge : edges)
+            {
+                for (int e = 0; e < 2; e++)
+                {
+                    int corner = edge[e];
+                    glVertex3f(center.x() + ((corner & 1) ? cell.scale : -cell.scale),
+                               center.y() + ((corner & 2) ? cell.scale : -cell.scale),
+                               center.z() + ((corner & 4) ? cell.scale : -cell.scale));
+                }
+            }
+        }
+        glEnd();
+    };
+
+    drawCells(m_starVisitedCells, 1.0f);
+    drawCells(m_dsoVisitedCells, 0.5f);
+
+    glEnable(GL_TEXTURE_2D);
+}
+
+
 class DSORenderer : public ObjectRenderer<DeepSkyObject*, double>
 {
  public:
@@ -6744,15 +7997,29 @@ void DSORenderer::process(DeepSkyObject* const & dso,
                     glMatrixMode(GL_MODELVIEW);
                 }
 
-                glPushMatrix();
-                glTranslate(relPos);
+                // DSOs covering only a few pixels go through the
+                // impostor atlas: captured into a tile once, then
+                // redrawn as a single billboard until the view angle,
+                // distance or brightness drifts. The distance guard
+                // keeps objects the observer is inside of (e.g. the
+                // Milky Way) on the direct path.
+                bool drewImpostor = false;
+                auto appRadiusPixels = (float) ((dsoRadius / distanceToDSO) / pixelSize);
+                if (2.0f * appRadiusPixels <= 32.0f && distanceToDSO > 10.0 * dsoRadius)
+                    drewImpostor = renderer->renderDSOImpostor(dso, relPos, brightness);
+
+                if (!drewImpostor)
+                {
+                    glPushMatrix();
+                    glTranslate(relPos);
 
-                dso->render(relPos,
-                            observer->getOrientationf(),
-                            (float) brightness,
-                            pixelSize,
-                            renderer);
-                glPopMatrix();
+                    dso->render(relPos,
+                                observer->getOrientationf(),
+                                (float) brightness,
+                                pixelSize,
+                                renderer);
+                    glPopMatrix();
+                }
 
                 if (dsoRadius < 1000.0)
                 {
@@ -6818,11 +8085,16 @@ void DSORenderer::process(DeepSkyObject* const & dso,
                     if (distr > 1.0f)
                         distr = 1.0f;
 
-                    renderer->addBackgroundAnnotation(rep,
-                                                      dsoDB->getDSOName(dso, true),
-                                                      Color(labelColor, distr * labelColor.alpha()),
-                                                      relPos,
-                                                      Renderer::AlignLeft, Renderer::VerticalAlignCenter, symbolSize);
+                    // The per-class step doubles as a class weight in
+                    // the label budget: nebulae and galaxies outrank
+                    // globulars of the same brightness headroom.
+                    float importance = step * (labelThresholdMag - appMagEff);
+                    renderer->addDSOLabelCandidate(dso,
+                                                   rep,
+                                                   Color(labelColor, distr * labelColor.alpha()),
+                                                   relPos,
+                                                   symbolSize,
+                                                   importance);
                 }
             } // labels enabled
         } // in frustum
@@ -6834,6 +8106,7 @@ void Renderer::renderDeepSkyObjects(const Universe&  universe,
                                     const Observer& observer,
                                     const float     faintestMagNight)
 {
+    CELZONE("render/deepSkyObjects");
     DSORenderer dsoRenderer;
 
     Vector3d obsPos     = observer.getPosition().toLy();
@@ -6887,22 +8160,28 @@ void Renderer::renderDeepSkyObjects(const Universe&  universe,
 
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
 
-#ifdef OCTREE_DEBUG
+    if (dsoImpostorCache == nullptr)
+        dsoImpostorCache = new DSOImpostorCache();
+    dsoImpostorCache->beginFrame();
+
     m_dsoProcStats.objects = 0;
     m_dsoProcStats.nodes = 0;
     m_dsoProcStats.height = 0;
-#endif
+    m_dsoProcStats.visitedCells = nullptr;
+    if ((renderFlags & ShowOctree) != 0)
+    {
+        m_dsoVisitedCells.clear();
+        m_dsoProcStats.visitedCells = &m_dsoVisitedCells;
+    }
+    double traversalStart = passTimer.getTime();
     dsoDB->findVisibleDSOs(dsoRenderer,
                            obsPos,
                            observer.getOrientationf(),
                            degToRad(fov),
                            getAspectRatio(),
                            2 * faintestMagNight,
-#ifdef OCTREE_DEBUG
                            &m_dsoProcStats);
-#else
-                            nullptr);
-#endif
+    m_dsoProcStats.timeMs = (passTimer.getTime() - traversalStart) * 1000.0;
 
     // clog << "DSOs processed: " << dsoRenderer.dsosProcessed << endl;
 
@@ -6910,6 +8189,74 @@ void Renderer::renderDeepSkyObjects(const Universe&  universe,
 }
 
 
+bool Renderer::renderDSOImpostor(DeepSkyObject* dso,
+                                 const Vector3f& relPos,
+                                 float brightness)
+{
+    if (!dsoImpostorCache->isUsable())
+        return false;
+
+    bool needsCapture = false;
+    DSOImpostorCache::Entry* entry =
+        dsoImpostorCache->acquire(dso, relPos, brightness, needsCapture);
+    if (entry == nullptr)
+        return false;
+
+    if (needsCapture)
+    {
+        float distance = relPos.norm();
+        auto dsoRadius = (float) dso->getBoundingSphereRadius();
+
+        // Pad the capture frustum slightly so sprite falloff at the
+        // object's rim is not clipped at the tile edge.
+        float halfSize = dsoRadius * 1.1f;
+        float angRadius = atan(halfSize / distance);
+
+        // Camera at the observer's position looking straight at the
+        // DSO; the billboard frame is stored so the tile is redrawn
+        // with the same orientation it was captured in, making the
+        // impostor stable under camera roll.
+        Quaternionf captureOrientation;
+        captureOrientation.setFromTwoVectors(relPos, Vector3f(0.0f, 0.0f, -1.0f));
+
+        float nearZ = std::max(distance - 2.0f * halfSize, distance * 0.01f);
+        float farZ  = distance + 2.0f * halfSize;
+        float capturePixelSize =
+            2.0f * (float) tan(angRadius) / (float) DSOImpostorCache::TileSize;
+
+        dsoImpostorCache->beginCapture(*entry);
+
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadMatrix(Perspective(radToDeg(2.0f * angRadius), 1.0f, nearZ, farZ));
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+        glRotate(captureOrientation);
+        glTranslate(relPos);
+
+        dso->render(relPos, captureOrientation, brightness, capturePixelSize, this);
+
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+
+        dsoImpostorCache->endCapture();
+
+        entry->viewDir = relPos / distance;
+        entry->distance = distance;
+        entry->brightness = brightness;
+        entry->right = captureOrientation.conjugate() * Vector3f::UnitX();
+        entry->up = captureOrientation.conjugate() * Vector3f::UnitY();
+        entry->halfSize = halfSize;
+    }
+
+    dsoImpostorCache->drawImpostor(*entry, relPos);
+    return true;
+}
+
+
 static Vector3d toStandardCoords(const Vector3d& v)
 {
     return Vector3d(v.x(), -v.z(), v.y());
@@ -6918,9 +8265,10 @@ static Vector3d toStandardCoords(const Vector3d& v)
 
 void Renderer::renderSkyGrids(const Observer& observer)
 {
+    CELZONE("render/skyGrids");
     if ((renderFlags & ShowCelestialSphere) != 0)
     {
-        SkyGrid grid;
+        SkyGrid& grid = m_equatorialSkyGrid;
         grid.setOrientation(Quaterniond(AngleAxis<double>(astro::J2000Obliquity, Vector3d::UnitX())));
         grid.setLineColor(EquatorialGridColor);
         grid.setLabelColor(EquatorialGridLabelColor);
@@ -6929,7 +8277,7 @@ void Renderer::renderSkyGrids(const Observer& observer)
 
     if ((renderFlags & ShowGalacticGrid) != 0)
     {
-        SkyGrid galacticGrid;
+        SkyGrid& galacticGrid = m_galacticSkyGrid;
         galacticGrid.setOrientation((astro::eclipticToEquatorial() * astro::equatorialToGalactic()).conjugate());
         galacticGrid.setLineColor(GalacticGridColor);
         galacticGrid.setLabelColor(GalacticGridLabelColor);
@@ -6939,7 +8287,7 @@ void Renderer::renderSkyGrids(const Observer& observer)
 
     if ((renderFlags & ShowEclipticGrid) != 0)
     {
-        SkyGrid grid;
+        SkyGrid& grid = m_eclipticSkyGrid;
         grid.setOrientation(Quaterniond::Identity());
         grid.setLineColor(EclipticGridColor);
         grid.setLabelColor(EclipticGridLabelColor);
@@ -6955,7 +8303,7 @@ void Renderer::renderSkyGrids(const Observer& observer)
 
         if (body != nullptr)
         {
-            SkyGrid grid;
+            SkyGrid& grid = m_horizonSkyGrid;
             grid.setLineColor(HorizonGridColor);
             grid.setLabelColor(HorizonGridLabelColor);
             grid.setLongitudeUnits(SkyGrid::LongitudeDegrees);
@@ -7053,6 +8401,7 @@ void Renderer::labelConstellations(const AsterismList& asterisms,
 void Renderer::renderParticles(const vector<Particle>& particles,
                                const Quaternionf& /*orientation*/)
 {
+    CELZONE("render/particles");
     ShaderProperties shaderprop;
     shaderprop.lightModel = ShaderProperties::ParticleModel;
     shaderprop.texUsage = ShaderProperties::PointSprite;
@@ -7076,19 +8425,137 @@ void Renderer::renderParticles(const vector<Particle>& particles,
     glDisable(GL_POINT_SPRITE);
 }
 
+// One vertex of the batched annotation text draw; all label quads of
+// a pass are accumulated into a single array and submitted with one
+// glDrawArrays call instead of immediate mode per character.
+struct LabelVertex
+{
+    float x, y, z;
+    float u, v;
+    unsigned char color[4];
+};
+
+// Scratch buffer for the per-pass batches; kept across frames so the
+// allocation settles at the high-water mark.
+static vector<LabelVertex> labelBatch;
+
+static void appendGlyphRun(vector<LabelVertex>& batch,
+                           const TextureFont::GlyphRun& run,
+                           float x, float y, float z,
+                           const Color& color)
+{
+    LabelVertex vtx;
+    vtx.z = z;
+    vtx.color[0] = (unsigned char) (color.red() * 255.99f);
+    vtx.color[1] = (unsigned char) (color.green() * 255.99f);
+    vtx.color[2] = (unsigned char) (color.blue() * 255.99f);
+    vtx.color[3] = (unsigned char) (color.alpha() * 255.99f);
+
+    for (const auto& v : run.vertices)
+    {
+        vtx.x = x + v.x;
+        vtx.y = y + v.y;
+        vtx.u = v.u;
+        vtx.v = v.v;
+        batch.push_back(vtx);
+    }
+}
+
+static void drawLabelBatch(const vector<LabelVertex>& batch)
+{
+    if (batch.empty())
+        return;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(LabelVertex), &batch[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(LabelVertex), &batch[0].u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(LabelVertex), batch[0].color);
+    glDrawArrays(GL_QUADS, 0, (GLsizei) batch.size());
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Screen-bound overlap culling for dense label sets: placed label
+// rectangles are registered in a coarse screen grid, and a new label
+// is dropped when it intersects one already placed. Candidate tests
+// only run against rectangles sharing a grid cell, keeping the cost
+// linear in practice even with thousands of labels.
+class LabelOverlapCuller
+{
+ public:
+    LabelOverlapCuller(int width, int height) :
+        cols(width / CellSize + 1),
+        rows(height / CellSize + 1)
+    {
+        cells.resize(cols * rows);
+    }
+
+    bool place(float x0, float y0, float x1, float y1)
+    {
+        int c0 = max(0, (int) x0 / CellSize);
+        int c1 = min(cols - 1, (int) x1 / CellSize);
+        int r0 = max(0, (int) y0 / CellSize);
+        int r1 = min(rows - 1, (int) y1 / CellSize);
+        if (c0 > c1 || r0 > r1)
+            return true; // fully off screen; let frustum handling deal with it
+
+        for (int r = r0; r <= r1; r++)
+        {
+            for (int c = c0; c <= c1; c++)
+            {
+                for (int index : cells[r * cols + c])
+                {
+                    const Rectf& other = rects[index];
+                    if (x0 < other.x1 && x1 > other.x0 &&
+                        y0 < other.y1 && y1 > other.y0)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        int index = (int) rects.size();
+        rects.push_back({ x0, y0, x1, y1 });
+        for (int r = r0; r <= r1; r++)
+        {
+            for (int c = c0; c <= c1; c++)
+                cells[r * cols + c].push_back(index);
+        }
+        return true;
+    }
+
+ private:
+    static const int CellSize = 64;
+
+    struct Rectf
+    {
+        float x0, y0, x1, y1;
+    };
+
+    int cols;
+    int rows;
+    vector<Rectf> rects;
+    vector<vector<int>> cells;
+};
+
 void Renderer::renderAnnotations(const vector<Annotation>& annotations, FontStyle fs)
 {
+    CELZONE("render/annotations");
     if (font[fs] == nullptr)
         return;
 
+    beginPass("annotations");
+
     // Enable line smoothing for rendering symbols
     enableSmoothLines(renderFlags);
 
 #ifdef USE_HDR
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_FALSE);
 #endif
-    glEnable(GL_TEXTURE_2D);
-    font[fs]->bind();
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -7099,6 +8566,10 @@ void Renderer::renderAnnotations(const vector<Annotation>& annotations, FontStyl
     glPushMatrix();
     glLoadIdentity();
 
+    // Draw all marker symbols first with the marker geometry bound
+    // once, then all text with the font bound once; interleaving the
+    // two rebinds buffer and texture state for every annotation.
+    beginMarkerBatch();
     for (int i = 0; i < (int) annotations.size(); i++)
     {
         if (annotations[i].markerRep != nullptr)
@@ -7120,33 +8591,52 @@ void Renderer::renderAnnotations(const vector<Annotation>& annotations, FontStyl
                 renderCrosshair(size, realTime, annotations[i].color);
             else
                 markerRep.render(*this, size);
-
-            if (!markerRep.label().empty())
-            {
-                int labelOffset = (int) markerRep.size() / 2;
-                glTranslatef(labelOffset + PixelOffset, -labelOffset - font[fs]->getHeight() + PixelOffset, 0.0f);
-                font[fs]->render(markerRep.label(), 0.0f, 0.0f);
-            }
             glPopMatrix();
         }
+    }
+    endMarkerBatch();
+
+    // Layout pass: shape (or fetch cached) glyph runs, cull labels
+    // whose screen rectangle overlaps one already placed, and gather
+    // the surviving quads. Shaping happens before the font texture is
+    // bound because the TrueType backend may grow its atlas while
+    // shaping. The batch is then drawn with a single call.
+    int fontHeight = font[fs]->getHeight();
+    LabelOverlapCuller culler(windowWidth, windowHeight);
+    labelBatch.clear();
+
+    for (int i = 0; i < (int) annotations.size(); i++)
+    {
+        if (annotations[i].markerRep != nullptr &&
+            !annotations[i].markerRep->label().empty())
+        {
+            const MarkerRepresentation& markerRep = *annotations[i].markerRep;
+            const auto& run = font[fs]->getGlyphRun(markerRep.label().data(),
+                                                    (int) markerRep.label().length());
+
+            int labelOffset = (int) markerRep.size() / 2;
+            float x = (float) (int) annotations[i].position.x() + labelOffset + PixelOffset;
+            float y = (float) (int) annotations[i].position.y() - labelOffset - fontHeight + PixelOffset;
+            // Marker labels are explicit user requests; batch but
+            // never cull them.
+            appendGlyphRun(labelBatch, run, x, y, 0.0f, annotations[i].color);
+        }
 
         if (!annotations[i].labelText.empty())
         {
-            glPushMatrix();
-            int labelWidth = 0;
+            const auto& run = font[fs]->getGlyphRun(annotations[i].labelText.data(),
+                                                    (int) annotations[i].labelText.length());
             int hOffset = 2;
             int vOffset = 0;
 
             switch (annotations[i].halign)
             {
             case AlignCenter:
-                labelWidth = (font[fs]->getWidth(annotations[i].labelText));
-                hOffset = -labelWidth / 2;
+                hOffset = -run.width / 2;
                 break;
 
             case AlignRight:
-                labelWidth = (font[fs]->getWidth(annotations[i].labelText));
-                hOffset = -(labelWidth + 2);
+                hOffset = -(run.width + 2);
                 break;
 
             case AlignLeft:
@@ -7158,25 +8648,30 @@ void Renderer::renderAnnotations(const vector<Annotation>& annotations, FontStyl
             switch (annotations[i].valign)
             {
             case VerticalAlignCenter:
-                vOffset = -font[fs]->getHeight() / 2;
+                vOffset = -fontHeight / 2;
                 break;
             case VerticalAlignTop:
-                vOffset = -font[fs]->getHeight();
+                vOffset = -fontHeight;
                 break;
             case VerticalAlignBottom:
                 vOffset = 0;
                 break;
             }
 
-            glColor(annotations[i].color);
-            glTranslatef((int) annotations[i].position.x() + hOffset + PixelOffset,
-                         (int) annotations[i].position.y() + vOffset + PixelOffset, 0.0f);
-            // EK TODO: Check where to replace (see '_(' above)
-            font[fs]->render(annotations[i].labelText, 0.0f, 0.0f);
-            glPopMatrix();
+            float x = (float) ((int) annotations[i].position.x() + hOffset) + PixelOffset;
+            float y = (float) ((int) annotations[i].position.y() + vOffset) + PixelOffset;
+
+            if (!culler.place(x, y, x + run.width, y + fontHeight))
+                continue;
+
+            appendGlyphRun(labelBatch, run, x, y, 0.0f, annotations[i].color);
         }
     }
 
+    glEnable(GL_TEXTURE_2D);
+    font[fs]->bind();
+    drawLabelBatch(labelBatch);
+
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
@@ -7186,6 +8681,8 @@ void Renderer::renderAnnotations(const vector<Annotation>& annotations, FontStyl
 #endif
 
     disableSmoothLines(renderFlags);
+
+    endPass("annotations");
 }
 
 
@@ -7219,9 +8716,9 @@ Renderer::renderSortedAnnotations(vector<Annotation>::iterator iter,
     if (font[fs] == nullptr)
         return iter;
 
+    beginPass("annotations");
+
     glEnable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D);
-    font[fs]->bind();
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -7239,48 +8736,69 @@ Renderer::renderSortedAnnotations(vector<Annotation>::iterator iter,
     float d1 = -(farDist + nearDist) / (farDist - nearDist);
     float d2 = -2.0f * nearDist * farDist / (farDist - nearDist);
 
+    // Marker symbols first with the marker geometry bound once, then
+    // text with the font bound once; the depth buffer keeps the output
+    // equivalent to the old interleaved ordering.
+    vector<Annotation>::iterator startIter = iter;
+    beginMarkerBatch();
     for (; iter != depthSortedAnnotations.end() && iter->position.z() > nearDist; iter++)
     {
+        if (iter->markerRep == nullptr)
+            continue;
+
         // Compute normalized device z
         float ndc_z = d1 + d2 / -iter->position.z();
         ndc_z = min(1.0f, max(-1.0f, ndc_z)); // Clamp to [-1,1]
 
-        // Offsets to left align label
-        int labelHOffset = 0;
-        int labelVOffset = 0;
+        const MarkerRepresentation& markerRep = *iter->markerRep;
+        float size = markerRep.size();
+        if (iter->size > 0.0f)
+        {
+            size = iter->size;
+        }
 
         glPushMatrix();
-        if (iter->markerRep != nullptr)
-        {
-            const MarkerRepresentation& markerRep = *iter->markerRep;
-            float size = markerRep.size();
-            if (iter->size > 0.0f)
-            {
-                size = iter->size;
-            }
+        glTranslatef((GLfloat) (int) iter->position.x(), (GLfloat) (int) iter->position.y(), ndc_z);
+        glColor(iter->color);
 
-            glTranslatef((GLfloat) (int) iter->position.x(), (GLfloat) (int) iter->position.y(), ndc_z);
-            glColor(iter->color);
+        if (markerRep.symbol() == MarkerRepresentation::Crosshair)
+            renderCrosshair(size, realTime, iter->color);
+        else
+            markerRep.render(*this, size);
+        glPopMatrix();
+    }
+    endMarkerBatch();
 
-            if (markerRep.symbol() == MarkerRepresentation::Crosshair)
-                renderCrosshair(size, realTime, iter->color);
-            else
-                markerRep.render(*this, size);
+    glEnable(GL_TEXTURE_2D);
+    font[fs]->bind();
+
+    for (auto labelIter = startIter; labelIter != iter; labelIter++)
+    {
+        // Compute normalized device z
+        float ndc_z = d1 + d2 / -labelIter->position.z();
+        ndc_z = min(1.0f, max(-1.0f, ndc_z)); // Clamp to [-1,1]
 
+        glPushMatrix();
+        if (labelIter->markerRep != nullptr)
+        {
+            const MarkerRepresentation& markerRep = *labelIter->markerRep;
             if (!markerRep.label().empty())
             {
                 int labelOffset = (int) markerRep.size() / 2;
-                glTranslatef(labelOffset + PixelOffset, -labelOffset - font[fs]->getHeight() + PixelOffset, 0.0f);
+                glTranslatef((int) labelIter->position.x() + labelOffset + PixelOffset,
+                             (int) labelIter->position.y() - labelOffset - font[fs]->getHeight() + PixelOffset,
+                             ndc_z);
+                glColor(labelIter->color);
                 font[fs]->render(markerRep.label(), 0.0f, 0.0f);
             }
         }
         else
         {
-            glTranslatef((int) iter->position.x() + PixelOffset + labelHOffset,
-                         (int) iter->position.y() + PixelOffset + labelVOffset,
+            glTranslatef((int) labelIter->position.x() + PixelOffset,
+                         (int) labelIter->position.y() + PixelOffset,
                          ndc_z);
-            glColor(iter->color);
-            font[fs]->render(iter->labelText, 0.0f, 0.0f);
+            glColor(labelIter->color);
+            font[fs]->render(labelIter->labelText.data(), (int) labelIter->labelText.length(), 0.0f, 0.0f);
         }
         glPopMatrix();
     }
@@ -7291,6 +8809,8 @@ Renderer::renderSortedAnnotations(vector<Annotation>::iterator iter,
     glMatrixMode(GL_MODELVIEW);
     glDisable(GL_DEPTH_TEST);
 
+    endPass("annotations");
+
     return iter;
 }
 
@@ -7305,9 +8825,9 @@ Renderer::renderAnnotations(vector<Annotation>::iterator startIter,
     if (font[fs] == nullptr)
         return endIter;
 
+    beginPass("annotations");
+
     glEnable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D);
-    font[fs]->bind();
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -7325,74 +8845,103 @@ Renderer::renderAnnotations(vector<Annotation>::iterator startIter,
     float d1 = -(farDist + nearDist) / (farDist - nearDist);
     float d2 = -2.0f * nearDist * farDist / (farDist - nearDist);
 
+    // Marker symbols first with the marker geometry bound once, then
+    // text with the font bound once; the depth buffer keeps the output
+    // equivalent to the old interleaved ordering.
     vector<Annotation>::iterator iter = startIter;
+    beginMarkerBatch();
     for (; iter != endIter && iter->position.z() > nearDist; iter++)
     {
+        if (iter->markerRep == nullptr)
+            continue;
+
         // Compute normalized device z
         float ndc_z = d1 + d2 / -iter->position.z();
         ndc_z = min(1.0f, max(-1.0f, ndc_z)); // Clamp to [-1,1]
 
+        const MarkerRepresentation& markerRep = *iter->markerRep;
+        float size = markerRep.size();
+        if (iter->size > 0.0f)
+        {
+            size = iter->size;
+        }
+
+        glPushMatrix();
+        glTranslatef((GLfloat) (int) iter->position.x(), (GLfloat) (int) iter->position.y(), ndc_z);
+        glColor(iter->color);
+
+        if (markerRep.symbol() == MarkerRepresentation::Crosshair)
+            renderCrosshair(size, realTime, iter->color);
+        else
+            markerRep.render(*this, size);
+        glPopMatrix();
+    }
+    endMarkerBatch();
+
+    // Shape and gather all label quads (with their normalized device
+    // z in the vertex), then draw the batch once; see the screen
+    // space overload above.
+    int fontHeight = font[fs]->getHeight();
+    labelBatch.clear();
+
+    for (auto labelIter = startIter; labelIter != iter; labelIter++)
+    {
+        // Compute normalized device z
+        float ndc_z = d1 + d2 / -labelIter->position.z();
+        ndc_z = min(1.0f, max(-1.0f, ndc_z)); // Clamp to [-1,1]
+
         // Offsets to left align label
         int labelHOffset = 0;
         int labelVOffset = 0;
 
-        if (iter->markerRep != nullptr)
+        if (labelIter->markerRep != nullptr &&
+            !labelIter->markerRep->label().empty())
         {
-            glPushMatrix();
-            const MarkerRepresentation& markerRep = *iter->markerRep;
-            float size = markerRep.size();
-            if (iter->size > 0.0f)
-            {
-                size = iter->size;
-            }
-
-            glTranslatef((GLfloat) (int) iter->position.x(), (GLfloat) (int) iter->position.y(), ndc_z);
-            glColor(iter->color);
-
-            if (markerRep.symbol() == MarkerRepresentation::Crosshair)
-                renderCrosshair(size, realTime, iter->color);
-            else
-                markerRep.render(*this, size);
-
-            if (!markerRep.label().empty())
-            {
-                int labelOffset = (int) markerRep.size() / 2;
-                glTranslatef(labelOffset + PixelOffset, -labelOffset - font[fs]->getHeight() + PixelOffset, 0.0f);
-                font[fs]->render(markerRep.label(), 0.0f, 0.0f);
-            }
-            glPopMatrix();
+            const MarkerRepresentation& markerRep = *labelIter->markerRep;
+            const auto& run = font[fs]->getGlyphRun(markerRep.label().data(),
+                                                    (int) markerRep.label().length());
+
+            int labelOffset = (int) markerRep.size() / 2;
+            float x = (float) ((int) labelIter->position.x() + labelOffset) + PixelOffset;
+            float y = (float) ((int) labelIter->position.y() - labelOffset - fontHeight) + PixelOffset;
+            appendGlyphRun(labelBatch, run, x, y, ndc_z, labelIter->color);
         }
 
-        if (!iter->labelText.empty())
+        if (!labelIter->labelText.empty())
         {
-            if (iter->markerRep != nullptr)
-                labelHOffset += (int) iter->markerRep->size() / 2 + 3;
-
-            glPushMatrix();
-            glTranslatef((int) iter->position.x() + PixelOffset + labelHOffset,
-                         (int) iter->position.y() + PixelOffset + labelVOffset,
-                         ndc_z);
-            glColor(iter->color);
-            font[fs]->render(iter->labelText, 0.0f, 0.0f);
-            glPopMatrix();
+            if (labelIter->markerRep != nullptr)
+                labelHOffset += (int) labelIter->markerRep->size() / 2 + 3;
+
+            const auto& run = font[fs]->getGlyphRun(labelIter->labelText.data(),
+                                                    (int) labelIter->labelText.length());
+            float x = (float) ((int) labelIter->position.x() + labelHOffset) + PixelOffset;
+            float y = (float) ((int) labelIter->position.y() + labelVOffset) + PixelOffset;
+            appendGlyphRun(labelBatch, run, x, y, ndc_z, labelIter->color);
         }
     }
 
+    glEnable(GL_TEXTURE_2D);
+    font[fs]->bind();
+    drawLabelBatch(labelBatch);
+
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
     glPopMatrix();
     glMatrixMode(GL_MODELVIEW);
     glDisable(GL_DEPTH_TEST);
 
+    endPass("annotations");
+
     return iter;
 }
 
 
-void Renderer::renderMarkers(const MarkerList& markers,
+void Renderer::renderMarkers(const Universe& universe,
                              const UniversalCoord& cameraPosition,
                              const Quaterniond& cameraOrientation,
                              double jd)
 {
+    CELZONE("render/markers");
     // Calculate the cosine of half the maximum field of view. We'll use this for
     // fast testing of marker visibility. The stored field of view is the
     // vertical field of view; we want the field of view as measured on the
@@ -7403,54 +8952,89 @@ void Renderer::renderMarkers(const MarkerList& markers,
 
     Vector3d viewVector = cameraOrientation.conjugate() * -Vector3d::UnitZ();
 
-    for (const auto& marker : markers)
+    const MarkerList& markers = *universe.getMarkers();
+
+    // Markers on moving objects are few; cull them individually.
+    for (uint32_t index : universe.getDynamicMarkerIndices())
+        addMarkerAnnotation(markers[index], cameraPosition, viewVector, cosFOV, jd);
+
+    // Markers on stars and deep sky objects are bucketed into grid
+    // cells; a whole cell is rejected with one cone test before any of
+    // its markers is transformed to camera space.
+    Vector3d cameraPosLy = cameraPosition.toLy();
+    double cellRadius = astro::lightYearsToKilometers(Universe::MarkerCellRadius);
+    for (const auto& gridEntry : universe.getStaticMarkerGrid())
     {
-        Vector3d offset = marker.position(jd).offsetFromKm(cameraPosition);
+        const Universe::MarkerCell& cell = gridEntry.second;
+        Vector3d cellOffset = (cell.center - cameraPosLy) * astro::lightYearsToKilometers(1.0);
 
-        // Only render those markers that lie withing the field of view.
-        if ((offset.dot(viewVector)) > cosFOV * offset.norm())
+        // Conservative test: the cell can contain a visible marker only
+        // if the sphere of the cell's bounding radius around its center
+        // intersects the view cone.
+        if (cellOffset.dot(viewVector) + cellRadius >
+            cosFOV * max(cellOffset.norm() - cellRadius, 0.0))
         {
-            double distance = offset.norm();
-            float symbolSize = 0.0f;
-            if (marker.sizing() == DistanceBasedSize)
-            {
-                symbolSize = (float) (marker.representation().size() / distance) / pixelSize;
-            }
+            for (uint32_t index : cell.markerIndices)
+                addMarkerAnnotation(markers[index], cameraPosition, viewVector, cosFOV, jd);
+        }
+    }
+}
 
-            if (marker.occludable())
-            {
-                // If the marker is occludable, add it to the sorted annotation list if it's relatively
-                // nearby, and to the background list if it's very distant.
-                if (distance < astro::lightYearsToKilometers(1.0))
-                {
-                    // Modify the marker position so that it is always in front of the marked object.
-                    double boundingRadius;
-                    if (marker.object().body() != nullptr)
-                        boundingRadius = marker.object().body()->getBoundingRadius();
-                    else
-                        boundingRadius = marker.object().radius();
-                    offset *= (1.0 - boundingRadius * 1.01 / distance);
 
-                    addSortedAnnotation(&(marker.representation()), "", marker.representation().color(),
-                                        offset.cast<float>(),
-                                        AlignLeft, VerticalAlignTop, symbolSize);
-                }
+void Renderer::addMarkerAnnotation(const Marker& marker,
+                                   const UniversalCoord& cameraPosition,
+                                   const Vector3d& viewVector,
+                                   double cosFOV,
+                                   double jd)
+{
+    const Body* markedBody = marker.object().body();
+    Vector3d offset = markedBody != nullptr
+        ? cachedBodyOffsetKm(markedBody, jd, cameraPosition)
+        : marker.position(jd).offsetFromKm(cameraPosition);
+
+    // Only render those markers that lie withing the field of view.
+    if ((offset.dot(viewVector)) > cosFOV * offset.norm())
+    {
+        double distance = offset.norm();
+        float symbolSize = 0.0f;
+        if (marker.sizing() == DistanceBasedSize)
+        {
+            symbolSize = (float) (marker.representation().size() / distance) / pixelSize;
+        }
+
+        if (marker.occludable())
+        {
+            // If the marker is occludable, add it to the sorted annotation list if it's relatively
+            // nearby, and to the background list if it's very distant.
+            if (distance < astro::lightYearsToKilometers(1.0))
+            {
+                // Modify the marker position so that it is always in front of the marked object.
+                double boundingRadius;
+                if (marker.object().body() != nullptr)
+                    boundingRadius = marker.object().body()->getBoundingRadius();
                 else
-                {
-                    addAnnotation(backgroundAnnotations,
-                                  &(marker.representation()), "", marker.representation().color(),
-                                  offset.cast<float>(),
-                                  AlignLeft, VerticalAlignTop, symbolSize);
-                }
+                    boundingRadius = marker.object().radius();
+                offset *= (1.0 - boundingRadius * 1.01 / distance);
+
+                addSortedAnnotation(&(marker.representation()), "", marker.representation().color(),
+                                    offset.cast<float>(),
+                                    AlignLeft, VerticalAlignTop, symbolSize);
             }
             else
             {
-                addAnnotation(foregroundAnnotations,
+                addAnnotation(backgroundAnnotations,
                               &(marker.representation()), "", marker.representation().color(),
                               offset.cast<float>(),
                               AlignLeft, VerticalAlignTop, symbolSize);
             }
         }
+        else
+        {
+            addAnnotation(foregroundAnnotations,
+                          &(marker.representation()), "", marker.representation().color(),
+                          offset.cast<float>(),
+                          AlignLeft, VerticalAlignTop, symbolSize);
+        }
     }
 }
 
@@ -7664,6 +9248,69 @@ bool Renderer::captureFrame(int x, int y, int w, int h, Renderer::PixelFormat fo
     return glGetError() == GL_NO_ERROR;
 }
 
+// Size in bytes of a readback with the default GL_PACK_ALIGNMENT of 4;
+// both supported pixel formats are three components wide.
+static std::size_t captureBufferSize(int w, int h)
+{
+    return (std::size_t) (((w * 3 + 3) & ~0x3)) * h;
+}
+
+bool Renderer::captureFrameAsync(int x, int y, int w, int h, Renderer::PixelFormat format, bool back) const
+{
+    if (m_capturePending == CaptureRingSize)
+        return false;
+
+    if (m_capturePBOs[0] == 0)
+        glGenBuffers(CaptureRingSize, m_capturePBOs);
+
+    std::size_t size = captureBufferSize(w, h);
+    int slot = m_captureHead;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_capturePBOs[slot]);
+    if (m_capturePBOSizes[slot] != size)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        m_capturePBOSizes[slot] = size;
+    }
+    glReadBuffer(back ? GL_BACK : GL_FRONT);
+    glReadPixels(x, y, w, h, toGLFormat(format), GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_captureHead = (m_captureHead + 1) % CaptureRingSize;
+    m_capturePending++;
+
+    return glGetError() == GL_NO_ERROR;
+}
+
+bool Renderer::retrieveCapturedFrame(unsigned char* buffer, bool drain) const
+{
+    // While filling the ring the oldest transfer is at most two frames
+    // old and mapping it will not stall; when draining at end of
+    // capture we accept the wait.
+    if (m_capturePending == 0 || (!drain && m_capturePending < CaptureRingSize))
+        return false;
+
+    int slot = m_captureTail;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_capturePBOs[slot]);
+    void* data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    bool ok = data != nullptr;
+    if (ok)
+    {
+        memcpy(buffer, data, m_capturePBOSizes[slot]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_captureTail = (m_captureTail + 1) % CaptureRingSize;
+    m_capturePending--;
+
+    return ok;
+}
+
+bool Renderer::hasPendingCapture() const
+{
+    return m_capturePending > 0;
+}
+
 static void drawRectangle(const Renderer &renderer, const Rect &r)
 {
     uint32_t p = r.tex == nullptr ? 0 : ShaderProperties::HasTexture;
@@ -7754,6 +9401,20 @@ void Renderer::setRenderRegion(int x, int y, int width, int height, bool withSci
     resize(width, height);
 }
 
+void Renderer::beginViewSet()
+{
+    viewSetActive = true;
+    viewSetFirstDraw = true;
+}
+
+
+void Renderer::endViewSet()
+{
+    viewSetActive = false;
+    viewSetFirstDraw = false;
+}
+
+
 float Renderer::getAspectRatio() const
 {
     return static_cast<float>(windowWidth) / static_cast<float>(windowHeight);
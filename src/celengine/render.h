@@ -20,8 +20,14 @@
 #include <celengine/glcontext.h>
 #endif
 #include <celengine/starcolors.h>
+#include <celengine/visibleset.h>
+#include <celutil/blockpool.h>
+#include <celutil/memorypool.h>
+#include <celutil/ringbuffer.h>
+#include <celutil/timer.h>
 #include <celengine/rendcontext.h>
 #include "celengine/vertexobject.h"
+#include "celengine/skygrid.h"
 #if NO_TTF
 #include <celtxf/texturefont.h>
 #else
@@ -29,15 +35,18 @@
 #endif
 #include <vector>
 #include <list>
+#include <set>
 #include <string>
 
 
 class RendererWatcher;
 class FrameTree;
+class TimelinePhase;
 class ReferenceMark;
 class CurvePlot;
 class AsterismList;
 class Rect;
+class DSOImpostorCache;
 
 struct LightSource
 {
@@ -81,6 +90,30 @@ struct RenderListEntry
 };
 
 
+/*! A typed draw command recorded during scene traversal and replayed
+ *  in order on the GL thread by Renderer::drainRenderCommands(). The
+ *  depth interval passes no longer issue GL work directly while they
+ *  walk the render list; they append commands to a lock-free queue
+ *  instead, which keeps scene logic free of GL calls and allows the
+ *  recording side to move off the GL thread.
+ */
+struct RenderCommand
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    enum Type
+    {
+        DrawItem,        // render one render list entry
+        FlushPointBatch  // submit the accumulated body point batch
+    };
+
+    Type type{ DrawItem };
+    RenderListEntry item;
+    float nearPlaneDistance{ 0.0f };
+    float farPlaneDistance{ 0.0f };
+};
+
+
 struct SecondaryIlluminator
 {
     const Body*     body;
@@ -91,6 +124,7 @@ struct SecondaryIlluminator
 
 
 class PointStarVertexBuffer;
+class BodyPointBatch;
 
 class Renderer
 {
@@ -192,6 +226,11 @@ class Renderer
         ShowComets              = 0x0000000080000000,
         ShowSpacecrafts         = 0x0000000100000000,
         ShowFadingOrbits        = 0x0000000200000000,
+        // Octree diagnostics: draw the star and DSO octree cells
+        // visited this frame as a heatmap and collect per-traversal
+        // counters; used when tuning split thresholds for non-stock
+        // catalogs.
+        ShowOctree              = 0x0000000400000000,
     };
 
     enum StarStyle
@@ -274,8 +313,33 @@ class Renderer
 
     bool captureFrame(int, int, int, int, PixelFormat format, unsigned char*, bool = false) const;
 
+    // Asynchronous framebuffer readback: captureFrameAsync() issues a
+    // glReadPixels into a pixel-pack buffer from a three-deep ring and
+    // returns immediately; retrieveCapturedFrame() maps the oldest
+    // buffer once the ring is full (or unconditionally when draining),
+    // so the transfer overlaps the rendering of subsequent frames.
+    bool captureFrameAsync(int, int, int, int, PixelFormat format, bool = false) const;
+    bool retrieveCapturedFrame(unsigned char* buffer, bool drain = false) const;
+    bool hasPendingCapture() const;
+
     void renderMarker(MarkerRepresentation::Symbol symbol, float size, const Color& color);
 
+    // Bracket a run of renderMarker calls; the marker vertex object and
+    // shader are bound once for the whole run instead of per symbol.
+    void beginMarkerBatch();
+    void endMarkerBatch();
+
+    /*! Bracket the views of one window frame. Inside a view set,
+     *  per-frame caches keyed on simulation time (currently the
+     *  eclipse caster state) are cleared only before the first view
+     *  and shared by the rest, since no body can be unloaded between
+     *  the views of one frame. Outside a view set every render pass
+     *  clears them, the safe default for callers that drive the
+     *  renderer directly.
+     */
+    void beginViewSet();
+    void endViewSet();
+
 #ifdef USE_HDR
     bool getBloomEnabled();
     void setBloomEnabled(bool);
@@ -293,6 +357,23 @@ class Renderer
     void setResolution(unsigned int resolution);
     unsigned int getResolution() const;
 
+    //! Rolling per-frame average of the CPU and GPU time spent in one
+    //! render pass, in milliseconds. GPU times are zero when the driver
+    //! lacks ARB_timer_query.
+    struct PassTiming
+    {
+        double cpuTimeMs{ 0.0 };
+        double gpuTimeMs{ 0.0 };
+    };
+
+    // Per-pass cost instrumentation: when enabled, the major render
+    // passes (point stars, deep sky objects, bodies by class, orbits,
+    // annotations) are bracketed with CPU timestamps and GL timer
+    // queries. Disabled by default as timer queries are not free.
+    void setPassTimingEnabled(bool enable);
+    bool getPassTimingEnabled() const { return passTimingEnabled; }
+    std::map<std::string, PassTiming> getPassTimings() const;
+
     void loadTextures(Body*);
 
     // Label related methods
@@ -312,7 +393,10 @@ class Renderer
 
     struct Annotation
     {
-        std::string labelText;
+        // Pool-backed: annotations are rebuilt every frame, so plain
+        // std::string storage would hit the global allocator once per
+        // label per frame.
+        PooledString labelText;
         const MarkerRepresentation* markerRep;
         Color color;
         Eigen::Vector3f position;
@@ -345,6 +429,27 @@ class Renderer
                              LabelVerticalAlignment valign = VerticalAlignBottom,
                              float size = 0.0f);
 
+    // Budgeted label submission for dense fields. Star and DSO labels
+    // are collected during scene traversal as candidates scored by
+    // brightness headroom and class weight; after traversal the highest
+    // scoring candidates, up to MaxLabelsPerFrame, have their names
+    // resolved and become background annotations. Labels shown in the
+    // previous frame receive a score bonus so the selected set does not
+    // flicker at the budget boundary.
+    void addStarLabelCandidate(const Star& star,
+                               Color color,
+                               const Eigen::Vector3f& position,
+                               float importance);
+    void addDSOLabelCandidate(DeepSkyObject* dso,
+                              const MarkerRepresentation* markerRep,
+                              Color color,
+                              const Eigen::Vector3f& position,
+                              float symbolSize,
+                              float importance);
+    void commitLabelCandidates(const Universe&);
+
+    static const unsigned int MaxLabelsPerFrame = 512;
+
    ShaderManager& getShaderManager() const { return *shaderManager; }
 
     // Callbacks for renderables; these belong in a special renderer interface
@@ -389,6 +494,14 @@ class Renderer
     void removeWatcher(RendererWatcher*);
     void notifyWatchers() const;
 
+    //! Render a distant DSO through the impostor atlas: capture it
+    //! into its tile when missing or stale, then draw the tile as one
+    //! billboard. Returns false when the object must be rendered
+    //! directly (impostors unusable or the atlas is full).
+    bool renderDSOImpostor(DeepSkyObject* dso,
+                           const Eigen::Vector3f& relPos,
+                           float brightness);
+
  public:
     // Internal types
     // TODO: Figure out how to make these private.  Even with a friend
@@ -416,11 +529,17 @@ class Renderer
         LightingState::EclipseShadowVector* eclipseShadows;
     };
 
-#ifdef OCTREE_DEBUG
+    // Octree traversal counters for the most recent frame; collected
+    // unconditionally since they are a handful of increments per
+    // visited node, and read by the debug overlay and the celx perf
+    // API. Visited cells are captured only while ShowOctree is set.
     OctreeProcStats m_starProcStats;
     OctreeProcStats m_dsoProcStats;
-#endif
  private:
+    // Impostor atlas for DSOs spanning only a few pixels; see
+    // renderDSOImpostor()
+    DSOImpostorCache* dsoImpostorCache{ nullptr };
+
     struct SkyVertex
     {
         float x, y, z;
@@ -480,6 +599,7 @@ class Renderer
     void renderDeepSkyObjects(const Universe&,
                               const Observer&,
                               float faintestMagNight);
+    void renderOctreeHeatmap(const Eigen::Vector3f& obsPosLY);
     void renderSkyGrids(const Observer& observer);
     void renderSelectionPointer(const Observer& observer,
                                 double now,
@@ -550,6 +670,25 @@ class Renderer
                          const Observer& observer,
                          float discSizeInPixels);
 
+    // Bounding quad queued for an occlusion query at the end of a
+    // depth interval.
+    struct OcclusionQueryCandidate
+    {
+        const Body* body;
+        Eigen::Vector3f position;
+        float radius;
+    };
+
+    bool isBodyOccluded(const Body& body);
+    void issueOcclusionQueries(const std::vector<OcclusionQueryCandidate>& candidates);
+
+    void beginPass(const char* name);
+    void endPass(const char* name);
+    void updatePassTimings();
+
+    void recordRenderCommand(const RenderCommand& cmd, const Observer& observer);
+    void drainRenderCommands(const Observer& observer);
+
     void renderObjectAsPoint_nosprite(const Eigen::Vector3f& center,
                                       float radius,
                                       float appMag,
@@ -622,10 +761,15 @@ class Renderer
                                                                   float farDist,
                                                                   FontStyle fs);
 
-    void renderMarkers(const MarkerList&,
+    void renderMarkers(const Universe&,
                        const UniversalCoord& cameraPosition,
                        const Eigen::Quaterniond& cameraOrientation,
                        double jd);
+    void addMarkerAnnotation(const Marker&,
+                             const UniversalCoord& cameraPosition,
+                             const Eigen::Vector3d& viewVector,
+                             double cosFOV,
+                             double jd);
 
     void renderOrbit(const OrbitPathListEntry&,
                      double now,
@@ -705,6 +849,8 @@ class Renderer
     Eigen::Quaternionf m_cameraOrientation;
     PointStarVertexBuffer* pointStarVertexBuffer;
     PointStarVertexBuffer* glareVertexBuffer;
+    BodyPointBatch* bodyPointBatch;
+    VisibleStarSet visibleStarSet;
     std::vector<RenderListEntry> renderList;
     std::vector<SecondaryIlluminator> secondaryIlluminators;
     std::vector<DepthBufferPartition> depthPartitions;
@@ -712,13 +858,135 @@ class Renderer
     std::vector<Annotation> backgroundAnnotations;
     std::vector<Annotation> foregroundAnnotations;
     std::vector<Annotation> depthSortedAnnotations;
+
+    struct LabelCandidate
+    {
+        const Star* star;              // exactly one of star and dso is set
+        DeepSkyObject* dso;
+        const MarkerRepresentation* markerRep;
+        Color color;
+        Eigen::Vector3f position;
+        float symbolSize;
+        float importance;
+    };
+    std::vector<LabelCandidate> labelCandidates;
+    std::set<const void*> labelsShownLastFrame;
     std::vector<Annotation> objectAnnotations;
     std::vector<OrbitPathListEntry> orbitPathList;
     LightingState::EclipseShadowVector eclipseShadows[MaxLights];
+
+    // Per-frame cache of shadow caster state. Within a planetary system
+    // every moon tests every other body as a potential occluder, so
+    // without the cache each caster's orbit and rotation are evaluated
+    // once per receiver instead of once per frame. Cleared at the start
+    // of each frame; entries also record the evaluation time so a stale
+    // entry is never reused.
+    struct EclipseCasterState
+    {
+        Eigen::Vector3d position;
+        Eigen::Quaterniond orientation;
+        double time;
+        bool canCastShadows;
+    };
+    std::map<const Body*, EclipseCasterState, std::less<const Body*>,
+             Eigen::aligned_allocator<std::pair<const Body* const, EclipseCasterState>>> eclipseCasterCache;
+    const EclipseCasterState& eclipseCasterState(const Body&, double now);
+
+    // See beginViewSet()
+    bool viewSetActive{ false };
+    bool viewSetFirstDraw{ false };
+
+    // Per-frame cache of observer-relative body positions in kilometers.
+    // Body::getPosition walks the timeline and reference frame chain and
+    // performs the final subtraction in 128-bit fixed point; the selection
+    // cursor, location labels, and marker passes each need the same offset
+    // for the same body within one frame, so the conversion is done once
+    // and the double precision result shared. Positions are kept in a flat
+    // vector with a side index so repeated lookups stay in one contiguous
+    // table; entries record the time and origin they were computed for and
+    // the table is emptied whenever either changes.
+    Eigen::Vector3d cachedBodyOffsetKm(const Body* body, double t,
+                                       const UniversalCoord& origin);
+    std::map<const Body*, unsigned int> bodyOffsetIndex;
+    std::vector<Eigen::Vector3d> bodyOffsets;
+    double bodyOffsetTime{ 0.0 };
+    UniversalCoord bodyOffsetOrigin;
+
+    // Reduced-rate update schedule for bodies that could not be seen
+    // from any direction at their last evaluation: too faint, covering
+    // well under a pixel, unlabeled, and with no subtree containing
+    // anything bright or large enough to matter. Such bodies skip the
+    // frame tree traversal work until their staggered round-robin slot
+    // comes up again. Only orientation-independent tests may qualify a
+    // body, so the camera can turn freely between evaluations; picks
+    // and scripts read positions straight from the timeline and are
+    // unaffected. Entries record the simulation time of the last
+    // evaluation so large time steps force an immediate recompute.
+    struct BodyScheduleEntry
+    {
+        uint32_t nextEvalFrame{ 0 };
+        double evalTime{ 0.0 };
+    };
+    std::map<const TimelinePhase*, BodyScheduleEntry> bodyUpdateSchedule;
+
     std::vector<const Star*> nearStars;
+    std::vector<SolarSystem*> nearStarSystems;
 
     std::vector<LightSource> lightSourceList;
 
+    // Bump allocator for containers that live for a single frame; reset
+    // with a pointer rewind at the top of render(), so steady-state
+    // rendering performs no heap allocation for scratch buffers.
+    MemoryPool frameArena;
+
+    // One-frame-delayed occlusion query results per body; see
+    // issueOcclusionQueries().
+    struct OcclusionQueryInfo
+    {
+        GLuint id{ 0 };
+        uint32_t queryFrame{ 0 };
+        bool occluded{ false };
+        bool pending{ false };
+    };
+    std::map<const Body*, OcclusionQueryInfo> occlusionQueries;
+
+    // Draw commands recorded by the depth interval passes and replayed
+    // in order by drainRenderCommands().
+    SPSCRingBuffer<RenderCommand> renderCommands{ 4096 };
+
+    // State for one instrumented render pass: a pair of GL timer
+    // queries used in alternation so reading one result never blocks on
+    // a query issued this frame, per-frame accumulators (a pass such as
+    // renderOrbit runs many times per frame), and the smoothed averages
+    // reported by getPassTimings().
+    struct PassProfile
+    {
+        GLuint queries[2]{ 0, 0 };
+        bool pending[2]{ false, false };
+        int activeQuery{ -1 };
+        double cpuStart{ 0.0 };
+        double frameCpuMs{ 0.0 };
+        double frameGpuMs{ 0.0 };
+        PassTiming smoothed;
+    };
+    bool passTimingEnabled;
+    std::map<std::string, PassProfile> passProfiles;
+    Timer passTimer;
+
+    // Octree cells visited this frame, kept for the ShowOctree heatmap
+    std::vector<OctreeVisitedCell> m_starVisitedCells;
+    std::vector<OctreeVisitedCell> m_dsoVisitedCells;
+
+    // Ring of pixel-pack buffers for asynchronous framebuffer
+    // readback; mutable because captureFrame() is const and the async
+    // variants share its signature convention.
+    enum { CaptureRingSize = 3 };
+    mutable GLuint m_capturePBOs[CaptureRingSize]{ 0, 0, 0 };
+    mutable std::size_t m_capturePBOSizes[CaptureRingSize]{ 0, 0, 0 };
+    mutable int m_captureHead{ 0 };
+    mutable int m_captureTail{ 0 };
+    mutable int m_capturePending{ 0 };
+
     Eigen::Matrix4d modelMatrix;
     Eigen::Matrix4d projMatrix;
 
@@ -738,6 +1006,14 @@ class Renderer
     int m_GLStateFlag { 0 };
 
     celgl::VertexObject markerVO{ GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW };
+    bool markerBatchActive { false };
+
+    // Sky grids persist across frames so their tessellation buffers and
+    // label anchor caches are reused; see SkyGrid::render().
+    SkyGrid m_equatorialSkyGrid;
+    SkyGrid m_galacticSkyGrid;
+    SkyGrid m_eclipticSkyGrid;
+    SkyGrid m_horizonSkyGrid;
 
  public:
 #if 0
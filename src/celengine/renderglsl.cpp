@@ -42,6 +42,109 @@ using namespace celmath;
 const double AtmosphereExtinctionThreshold = 0.05;
 
 
+// Resolution of the precomputed transmittance tables. The u axis is the
+// cosine of the angle between the ray and the local vertical; the v axis
+// is the height above the planet surface.
+static const int TransmittanceLUTWidth   = 256;
+static const int TransmittanceLUTHeight  = 128;
+static const int TransmittanceLUTSamples = 64;
+
+static map<const Atmosphere*, AtmosphereTransmittanceLUT> transmittanceLUTs;
+
+
+// Integrate atmospheric density along a ray starting at radius r with
+// direction cosine mu relative to the local vertical, out to the sky
+// sphere. Rays that strike the planet return a huge depth so they
+// saturate at the table maximum.
+static float
+IntegrateOpticalDepth(float r, float mu,
+                      float planetRadius, float skyRadius, float invScaleHeight)
+{
+    float b2 = r * r * (mu * mu - 1.0f);
+    if (mu < 0.0f && b2 + planetRadius * planetRadius > 0.0f)
+        return 1.0e30f;
+
+    float pathLength = -r * mu + sqrt(max(0.0f, b2 + skyRadius * skyRadius));
+
+    float step = pathLength / (float) TransmittanceLUTSamples;
+    float depth = 0.0f;
+    for (int i = 0; i < TransmittanceLUTSamples; i++)
+    {
+        float t = ((float) i + 0.5f) * step;
+        float h = sqrt(r * r + t * t + 2.0f * r * mu * t) - planetRadius;
+        depth += exp(-max(0.0f, h) * invScaleHeight);
+    }
+
+    return depth * step;
+}
+
+
+class TransmittanceLUTFunction : public TexelFunctionObject
+{
+public:
+    TransmittanceLUTFunction(float _planetRadius, float _skyRadius,
+                             float _invScaleHeight, float _maxOpticalDepth) :
+        planetRadius(_planetRadius),
+        skyRadius(_skyRadius),
+        invScaleHeight(_invScaleHeight),
+        maxOpticalDepth(_maxOpticalDepth)
+    {
+    }
+
+    void operator()(float u, float v, float /*w*/, unsigned char* pixel) override
+    {
+        float mu = u;
+        float r = planetRadius + (v + 1.0f) * 0.5f * (skyRadius - planetRadius);
+        float depth = IntegrateOpticalDepth(r, mu, planetRadius, skyRadius, invScaleHeight);
+
+        // 16-bit fixed point split across two channels; the shader
+        // decodes (hi + lo / 256) / 255 * maxOpticalDepth
+        float dnorm = min(depth / maxOpticalDepth, 1.0f);
+        auto d16 = (unsigned int) (dnorm * 65280.0f + 0.5f);
+        pixel[0] = (unsigned char) (d16 >> 8);
+        pixel[1] = (unsigned char) (d16 & 0xff);
+        pixel[2] = 0;
+    }
+
+private:
+    float planetRadius;
+    float skyRadius;
+    float invScaleHeight;
+    float maxOpticalDepth;
+};
+
+
+const AtmosphereTransmittanceLUT*
+GetAtmosphereTransmittanceLUT(const Atmosphere* atmosphere, float planetRadius)
+{
+    auto iter = transmittanceLUTs.find(atmosphere);
+    if (iter != transmittanceLUTs.end())
+        return &iter->second;
+
+    float skyRadius = planetRadius + -atmosphere->mieScaleHeight * (float) log(AtmosphereExtinctionThreshold);
+    float invScaleHeight = 1.0f / atmosphere->mieScaleHeight;
+
+    // The deepest path through the atmosphere is the horizon-grazing
+    // ray from the surface; use it to normalize the table entries.
+    float maxOpticalDepth = IntegrateOpticalDepth(planetRadius, 0.0f,
+                                                  planetRadius, skyRadius,
+                                                  invScaleHeight) * 1.05f;
+
+    AtmosphereTransmittanceLUT& lut = transmittanceLUTs[atmosphere];
+    lut.maxOpticalDepth = maxOpticalDepth;
+
+    TransmittanceLUTFunction func(planetRadius, skyRadius,
+                                  invScaleHeight, maxOpticalDepth);
+    lut.texture = CreateProceduralTexture(TransmittanceLUTWidth,
+                                          TransmittanceLUTHeight,
+                                          GL_RGB, func,
+                                          Texture::EdgeClamp,
+                                          Texture::NoMipMaps);
+
+    return &lut;
+}
+
+
 // Render a planet sphere with GLSL shaders
 void renderEllipsoid_GLSL(const RenderInfo& ri,
                        const LightingState& ls,
@@ -261,6 +364,16 @@ void renderEllipsoid_GLSL(const RenderInfo& ri,
         if (shadprop.hasScattering())
         {
             prog->setAtmosphereParameters(*atmosphere, radius, radius);
+
+            const AtmosphereTransmittanceLUT* lut = GetAtmosphereTransmittanceLUT(atmosphere, radius);
+            if (lut->texture != nullptr)
+            {
+                glActiveTexture(GL_TEXTURE0 + nTextures);
+                lut->texture->bind();
+                glActiveTexture(GL_TEXTURE0);
+                nTextures++;
+                prog->transmittanceScale = lut->maxOpticalDepth / radius;
+            }
         }
     }
 
@@ -304,6 +417,7 @@ void renderGeometry_GLSL(Geometry* geometry,
 
     rc.setCameraOrientation(ri.orientation);
     rc.setPointScale(ri.pointScale);
+    rc.setScreenSize(ri.pixWidth);
 
     // Handle extended material attributes (per model only, not per submesh)
     rc.setLunarLambert(ri.lunarLambert);
@@ -349,6 +463,7 @@ void renderGeometry_GLSL_Unlit(Geometry* geometry,
     GLSLUnlit_RenderContext rc(renderer, geometryScale);
 
     rc.setPointScale(ri.pointScale);
+    rc.setScreenSize(ri.pixWidth);
 
     // Handle material override; a texture specified in an ssc file will
     // override all materials specified in the model file.
@@ -480,6 +595,16 @@ void renderClouds_GLSL(const RenderInfo& ri,
         if (shadprop.hasScattering())
         {
             prog->setAtmosphereParameters(*atmosphere, radius, cloudRadius);
+
+            const AtmosphereTransmittanceLUT* lut = GetAtmosphereTransmittanceLUT(atmosphere, radius);
+            if (lut->texture != nullptr)
+            {
+                glActiveTexture(GL_TEXTURE0 + nTextures);
+                lut->texture->bind();
+                glActiveTexture(GL_TEXTURE0);
+                nTextures++;
+                prog->transmittanceScale = lut->maxOpticalDepth / cloudRadius;
+            }
         }
     }
 
@@ -546,6 +671,13 @@ renderAtmosphere_GLSL(const RenderInfo& ri,
     prog->eyePosition = ls.eyePos_obj / atmScale;
     prog->setAtmosphereParameters(*atmosphere, radius, atmosphereRadius);
 
+    const AtmosphereTransmittanceLUT* lut = GetAtmosphereTransmittanceLUT(atmosphere, radius);
+    if (lut->texture != nullptr)
+    {
+        lut->texture->bind();
+        prog->transmittanceScale = lut->maxOpticalDepth / atmosphereRadius;
+    }
+
 #if 0
     // Currently eclipse shadows are ignored when rendering atmospheres
     if (shadprop.shadowCounts != 0)
@@ -17,6 +17,19 @@
 #include <Eigen/Geometry>
 
 class Renderer;
+class Texture;
+
+// Precomputed table of atmospheric optical depth along rays through the
+// atmosphere, indexed by height and direction cosine. Entries are stored
+// in physical units and rescaled per object with transmittanceScale.
+struct AtmosphereTransmittanceLUT
+{
+    Texture* texture{ nullptr };
+    float maxOpticalDepth{ 0.0f };
+};
+
+const AtmosphereTransmittanceLUT* GetAtmosphereTransmittanceLUT(const Atmosphere* atmosphere,
+                                                                float planetRadius);
 
 void renderEllipsoid_GLSL(const RenderInfo& ri,
                        const LightingState& ls,
@@ -13,6 +13,8 @@
 #include <celutil/debug.h>
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <system_error>
 
 using namespace std;
 
@@ -48,3 +50,59 @@ RotationModel* RotationModelInfo::load(const fs::path& filename)
 
     return LoadSampledOrientation(filename);
 }
+
+
+void RotationModelInfo::beginLoad(const fs::path& filename)
+{
+    // The info object may move when the manager's resource table grows,
+    // so the worker operates on a private copy.
+    RotationModelInfo request(source, path);
+    loadFuture = make_shared<future<pair<RotationModel*, uint64_t>>>(
+        async(launch::async,
+              [request, filename]() mutable
+              {
+                  RotationModel* model = request.load(filename);
+
+                  // Hash the source file here so the manager can alias
+                  // byte-identical orientation files without reading the
+                  // file on the calling thread.
+                  return make_pair(model, RotationModelInfo::hashFileContents(filename));
+              }));
+}
+
+
+bool RotationModelInfo::tryFinishLoad(RotationModel*& res)
+{
+    res = nullptr;
+    if (loadFuture == nullptr)
+        return false;
+    if (loadFuture->wait_for(chrono::seconds(0)) != future_status::ready)
+        return false;
+
+    pair<RotationModel*, uint64_t> result = loadFuture->get();
+    res = result.first;
+    contentHash = result.second;
+    loadFuture.reset();
+    return true;
+}
+
+
+void RotationModelInfo::waitLoad()
+{
+    if (loadFuture != nullptr)
+        loadFuture->wait();
+}
+
+
+uintmax_t RotationModelInfo::resourceSize() const
+{
+    if (resource == nullptr)
+        return 0;
+
+    // Use the orientation file size as a proxy for the in-memory
+    // footprint; the sample array dominates both.
+    std::error_code ec;
+    uintmax_t size = fs::file_size(resolvedName, ec);
+
+    return ec ? 0 : size;
+}
@@ -14,6 +14,9 @@
 #include <celutil/resmanager.h>
 #include <string>
 #include <map>
+#include <memory>
+#include <future>
+#include <utility>
 
 
 class RotationModelInfo : public ResourceInfo<RotationModel>
@@ -28,6 +31,20 @@ class RotationModelInfo : public ResourceInfo<RotationModel>
 
     fs::path resolve(const fs::path&) override;
     RotationModel* load(const fs::path&) override;
+    std::uintmax_t resourceSize() const override;
+
+    // Sampled orientation files are parsed on a background thread,
+    // prefetched and then fetched by the solar system loader just
+    // like sampled trajectories.
+    bool loadsAsynchronously() const override { return true; }
+    void beginLoad(const fs::path&) override;
+    bool tryFinishLoad(RotationModel*&) override;
+    void waitLoad() override;
+
+ private:
+    //! In-flight background load of the model and its content hash;
+    //! shared so copies of this info track it
+    std::shared_ptr<std::future<std::pair<RotationModel*, uint64_t>>> loadFuture;
 };
 
 inline bool operator<(const RotationModelInfo& ti0,
@@ -18,9 +18,20 @@
 #include <sstream>
 #include <iomanip>
 #include <celutil/debug.h>
+#include <celutil/tracelog.h>
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
 #include <Eigen/Geometry>
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
 using namespace Eigen;
 using namespace std;
 
@@ -55,6 +66,206 @@ static const char* errorFragmentShaderSource =
 static const char* CommonHeader = "#version 120\n";
 
 
+// On-disk cache of linked program binaries. Compiling a generated shader
+// on first use of a ShaderProperties combination can hitch the frame
+// loop for hundreds of milliseconds; binaries saved with
+// glGetProgramBinary are reloaded in bulk at startup, so warm runs never
+// compile generated shaders at all. Entries are keyed by the full
+// ShaderProperties and a hash of the driver identification strings,
+// since program binaries are only valid for the driver that produced
+// them.
+
+static const char ShaderCacheDir[] = "shadercache";
+
+struct ShaderCacheHeader
+{
+    uint32_t magic;
+    uint32_t driverHash;
+    uint32_t nLights;
+    uint32_t texUsage;
+    uint32_t lightModel;
+    uint32_t effects;
+    uint32_t shadowCounts;
+    uint32_t simpleProps;
+    uint32_t binaryFormat;
+    uint32_t binaryLength;
+};
+
+static const uint32_t ShaderCacheMagic = 0x31726c63; // "clr1"
+
+
+// Asynchronous compilation. With KHR_parallel_shader_compile the driver
+// compiles and links on its own worker threads; the compile and link
+// calls return immediately as long as no status query forces a wait.
+// getShader() issues the build, hands back a simplified fallback
+// program, and polls GL_COMPLETION_STATUS_KHR on later calls, swapping
+// the finished program in without ever stalling the frame loop.
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+
+static bool AsyncCompileUsable()
+{
+#ifdef GLEW_KHR_parallel_shader_compile
+    return GLEW_KHR_parallel_shader_compile != 0;
+#else
+    return false;
+#endif
+}
+
+
+static uint32_t HashMix(uint32_t h, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        h ^= (value >> (i * 8)) & 0xff;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static uint32_t HashMix(uint32_t h, const char* s)
+{
+    for (; s != nullptr && *s != '\0'; ++s)
+    {
+        h ^= (uint8_t) *s;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+static uint32_t DriverHash()
+{
+    uint32_t h = 2166136261u;
+    h = HashMix(h, (const char*) glGetString(GL_VENDOR));
+    h = HashMix(h, (const char*) glGetString(GL_RENDERER));
+    h = HashMix(h, (const char*) glGetString(GL_VERSION));
+    return h;
+}
+
+
+static bool ShaderCacheUsable()
+{
+    static int usable = -1;
+    if (usable < 0)
+    {
+        GLint formats = 0;
+        if (GLEW_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        usable = formats > 0 ? 1 : 0;
+    }
+
+    return usable != 0;
+}
+
+
+static fs::path ShaderCacheFileName(const ShaderProperties& props)
+{
+    uint32_t h = 2166136261u;
+    h = HashMix(h, props.nLights);
+    h = HashMix(h, props.texUsage);
+    h = HashMix(h, props.lightModel);
+    h = HashMix(h, props.effects);
+    h = HashMix(h, props.shadowCounts);
+    h = HashMix(h, props.simpleProps);
+    return fs::path(ShaderCacheDir) / fmt::sprintf("cel_%08x.bin", h);
+}
+
+
+static void SaveCachedShader(GLuint progID, const ShaderProperties& props)
+{
+    GLint binaryLength = 0;
+    glGetProgramiv(progID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0)
+        return;
+
+    vector<char> binary(binaryLength);
+    GLsizei written = 0;
+    GLenum binaryFormat = 0;
+    glGetProgramBinary(progID, binaryLength, &written, &binaryFormat, binary.data());
+    if (written <= 0)
+        return;
+
+#ifdef _WIN32
+    _mkdir(ShaderCacheDir);
+#else
+    mkdir(ShaderCacheDir, 0755);
+#endif
+
+    ShaderCacheHeader header;
+    header.magic = ShaderCacheMagic;
+    header.driverHash = DriverHash();
+    header.nLights = props.nLights;
+    header.texUsage = props.texUsage;
+    header.lightModel = props.lightModel;
+    header.effects = props.effects;
+    header.shadowCounts = props.shadowCounts;
+    header.simpleProps = props.simpleProps;
+    header.binaryFormat = binaryFormat;
+    header.binaryLength = (uint32_t) written;
+
+    fs::path cacheFile = ShaderCacheFileName(props);
+    ofstream out(cacheFile.string(), ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(binary.data(), written);
+    if (!out.good())
+    {
+        out.close();
+        std::remove(cacheFile.string().c_str());
+    }
+}
+
+
+/*! Load one cached binary; on success fills in the properties it was
+ *  compiled from. Entries from another driver or a stale format are
+ *  simply skipped and recompiled on demand.
+ */
+static GLProgram* LoadCachedShader(const fs::path& cacheFile, ShaderProperties& props)
+{
+    ifstream in(cacheFile.string(), ios::binary);
+    if (!in.good())
+        return nullptr;
+
+    ShaderCacheHeader header;
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in.good() ||
+        header.magic != ShaderCacheMagic ||
+        header.driverHash != DriverHash() ||
+        header.binaryLength == 0 ||
+        header.binaryLength > 0x4000000)
+    {
+        return nullptr;
+    }
+
+    vector<char> binary(header.binaryLength);
+    in.read(binary.data(), header.binaryLength);
+    if (!in.good())
+        return nullptr;
+
+    GLProgram* prog = nullptr;
+    GLShaderStatus status = GLShaderLoader::CreateProgramFromBinary(header.binaryFormat,
+                                                                    binary.data(),
+                                                                    (int) header.binaryLength,
+                                                                    &prog);
+    if (status != ShaderStatus_OK)
+        return nullptr;
+
+    props = ShaderProperties();
+    props.nLights = (unsigned short) header.nLights;
+    props.texUsage = (unsigned short) header.texUsage;
+    props.lightModel = (unsigned short) header.lightModel;
+    props.effects = (unsigned short) header.effects;
+    props.shadowCounts = header.shadowCounts;
+    props.simpleProps = header.simpleProps;
+
+    return prog;
+}
+
+
 bool
 ShaderProperties::usesShadows() const
 {
@@ -237,6 +448,27 @@ ShaderProperties::usesTangentSpaceLighting() const
 }
 
 
+/*! Pack the properties into a single 64-bit hash table key. The fields
+ *  comfortably fit: texUsage and shadowCounts are used in full, while
+ *  nLights is at most MaxShaderLights, lightModel at most ParticleModel,
+ *  and effects has only three flag bits defined. Simple shader
+ *  properties ignore every other field, so their keys live in a
+ *  separate space marked by the top bit.
+ */
+uint64_t
+ShaderProperties::packedKey() const
+{
+    if (simpleProps != 0)
+        return (uint64_t) simpleProps | (UINT64_C(1) << 63);
+
+    return (uint64_t) shadowCounts
+        | ((uint64_t) texUsage   << 32)
+        | ((uint64_t) lightModel << 48)
+        | ((uint64_t) effects    << 52)
+        | ((uint64_t) nLights    << 56);
+}
+
+
 bool operator<(const ShaderProperties& p0, const ShaderProperties& p1)
 {
     if (p0.texUsage < p1.texUsage)
@@ -276,11 +508,55 @@ ShaderManager::ShaderManager()
 #endif
 
 #endif
+
+    loadShaderCache();
+    GetMemoryAudit().registerReporter(this);
+}
+
+
+void ShaderManager::reportMemory(MemoryLedger& ledger) const
+{
+    std::uintmax_t nPrograms = dynamicShaders.size() + staticShaders.size();
+    ledger.add("shaders", "programs", nPrograms * sizeof(CelestiaGLProgram));
+
+    std::uintmax_t indexBytes =
+        dynamicShaders.size() * (sizeof(uint64_t) + 2 * sizeof(void*)) +
+        staticShaders.size() * (sizeof(std::string) + 5 * sizeof(void*)) +
+        pendingShaders.size() * (sizeof(ShaderProperties) + 5 * sizeof(void*));
+    ledger.add("shaders", "index", indexBytes);
+}
+
+
+/*! Load all cached program binaries produced by earlier runs on this
+ *  driver. The manager is created after GL initialization, so the
+ *  binaries can be handed straight to the driver here instead of
+ *  compiling shaders the first time each combination appears on screen.
+ */
+void ShaderManager::loadShaderCache()
+{
+    if (!ShaderCacheUsable())
+        return;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(fs::path(ShaderCacheDir), ec))
+    {
+        ShaderProperties props;
+        GLProgram* prog = LoadCachedShader(entry.path(), props);
+        if (prog == nullptr)
+            continue;
+
+        if (dynamicShaders.count(props.packedKey()) == 0)
+            dynamicShaders[props.packedKey()] = new CelestiaGLProgram(*prog, props);
+        else
+            delete prog;
+    }
 }
 
 
 ShaderManager::~ShaderManager()
 {
+    GetMemoryAudit().unregisterReporter(this);
+
     for(const auto& shader : dynamicShaders)
         delete shader.second;
 
@@ -290,24 +566,159 @@ ShaderManager::~ShaderManager()
         delete shader.second;
 
     staticShaders.clear();
+
+    for (const auto& shader : pendingShaders)
+        delete shader.second;
+
+    pendingShaders.clear();
 }
 
 CelestiaGLProgram*
 ShaderManager::getShader(const ShaderProperties& props)
 {
-    auto iter = dynamicShaders.find(props);
+    CELZONE("shader/getShader");
+    // Promote any compiles the driver has finished in the background
+    checkPendingShaders();
+
+    auto iter = dynamicShaders.find(props.packedKey());
     if (iter != dynamicShaders.end())
     {
         // Shader already exists
         return iter->second;
     }
-    else
+
+    if (AsyncCompileUsable() && props.simpleProps == 0)
+    {
+        if (pendingShaders.count(props) != 0)
+            return getFallbackShader(props);
+
+        // A fallback of nullptr means this program is already minimal;
+        // those compile quickly enough to build synchronously below
+        CelestiaGLProgram* fallback = getFallbackShader(props);
+        if (fallback != nullptr)
+        {
+            GLProgram* prog = issueProgram(props);
+            if (prog != nullptr)
+            {
+                pendingShaders[props] = prog;
+                return fallback;
+            }
+        }
+    }
+
+    // Create a new shader and add it to the table of created shaders
+    CelestiaGLProgram* prog = buildProgram(props);
+    dynamicShaders[props.packedKey()] = prog;
+
+    return prog;
+}
+
+
+/*! Return a simplified stand-in program used while the real one
+ *  compiles in the background: same light count and model, but no
+ *  shadows, scattering effects, or secondary textures. Returns nullptr
+ *  when the requested program is already minimal.
+ */
+CelestiaGLProgram*
+ShaderManager::getFallbackShader(const ShaderProperties& props)
+{
+    ShaderProperties fallback = props;
+    fallback.shadowCounts = 0;
+    fallback.effects = 0;
+    fallback.texUsage &= ShaderProperties::DiffuseTexture |
+                         ShaderProperties::VertexColors |
+                         ShaderProperties::VertexOpacities |
+                         ShaderProperties::PointSprite;
+    if (fallback.lightModel == ShaderProperties::PerPixelSpecularModel)
+        fallback.lightModel = ShaderProperties::SpecularModel;
+
+    if (fallback.packedKey() == props.packedKey())
+        return nullptr;
+
+    auto iter = dynamicShaders.find(fallback.packedKey());
+    if (iter != dynamicShaders.end())
+        return iter->second;
+
+    CelestiaGLProgram* prog = buildProgram(fallback);
+    dynamicShaders[fallback.packedKey()] = prog;
+
+    return prog;
+}
+
+
+/*! Issue compilation and linking for a program without waiting on the
+ *  results. Returns the unfinished program; the caller polls it via
+ *  checkPendingShaders().
+ */
+GLProgram*
+ShaderManager::issueProgram(const ShaderProperties& props)
+{
+    GLVertexShader* vs = nullptr;
+    GLFragmentShader* fs = nullptr;
+
+    GLShaderLoader::setDeferredStatusChecks(true);
+    buildShaders(props, &vs, &fs);
+
+    GLProgram* prog = nullptr;
+    if (vs != nullptr && fs != nullptr &&
+        GLShaderLoader::CreateProgram(*vs, *fs, &prog) == ShaderStatus_OK)
     {
-        // Create a new shader and add it to the table of created shaders
-        CelestiaGLProgram* prog = buildProgram(props);
-        dynamicShaders[props] = prog;
+        if (props.texUsage & ShaderProperties::NormalTexture)
+            glBindAttribLocation(prog->getID(), 6, "tangent");
+
+        if (props.texUsage & ShaderProperties::PointSprite)
+            glBindAttribLocation(prog->getID(), 7, "pointSize");
 
-        return prog;
+        if (ShaderCacheUsable())
+            glProgramParameteri(prog->getID(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+        prog->link();
+    }
+
+    GLShaderLoader::setDeferredStatusChecks(false);
+
+    delete vs;
+    delete fs;
+
+    return prog;
+}
+
+
+/*! Move finished background compiles into the shader table. */
+void
+ShaderManager::checkPendingShaders()
+{
+    if (pendingShaders.empty())
+        return;
+
+    for (auto iter = pendingShaders.begin(); iter != pendingShaders.end();)
+    {
+        GLint complete = 1;
+        glGetProgramiv(iter->second->getID(), GL_COMPLETION_STATUS_KHR, &complete);
+        if (complete == 0)
+        {
+            ++iter;
+            continue;
+        }
+
+        GLint linked = 0;
+        glGetProgramiv(iter->second->getID(), GL_LINK_STATUS, &linked);
+        if (linked == GL_TRUE)
+        {
+            if (ShaderCacheUsable())
+                SaveCachedShader(iter->second->getID(), iter->first);
+
+            dynamicShaders[iter->first.packedKey()] = new CelestiaGLProgram(*iter->second, iter->first);
+        }
+        else
+        {
+            // Rebuild synchronously; that path logs the compile errors
+            // and substitutes the error shader
+            delete iter->second;
+            dynamicShaders[iter->first.packedKey()] = buildProgram(iter->first);
+        }
+
+        iter = pendingShaders.erase(iter);
     }
 }
 
@@ -1334,49 +1745,31 @@ AtmosphericEffects(const ShaderProperties& props)
     source += "    vec3 atmEnter = eyePosition + min(0.0, (-rq + d)) * eyeDir;\n";
     source += "    vec3 atmLeave = gl_Vertex.xyz;\n";
 
-    source += "    vec3 atmSamplePoint = (atmEnter + atmLeave) * 0.5;\n";
-    //source += "    vec3 atmSamplePoint = atmEnter * 0.2 + atmLeave * 0.8;\n";
-
-    // Compute the distance through the atmosphere from the sample point to the sun
-    source += "    vec3 atmSamplePointSun = atmEnter * 0.5 + atmLeave * 0.5;\n";
-    source += "    rq = dot(atmSamplePointSun, " + LightProperty(0, "direction") + ");\n";
-    source += "    qq = dot(atmSamplePointSun, atmSamplePointSun) - atmosphereRadius.y;\n";
-    source += "    d = sqrt(rq * rq - qq);\n";
-    source += "    float distSun = -rq + d;\n";
-    source += "    float distAtm = length(atmEnter - atmLeave);\n";
-
-    // Compute the density of the atmosphere at the sample point; it falls off exponentially
-    // with the height above the planet's surface.
-#if 0
-    source += "    float h = max(0.0, length(atmSamplePoint) - atmosphereRadius.z);\n";
-    source += "    float density = exp(-h * mieH);\n";
-#else
-    source += "    float density = 0.0;\n";
-    source += "    atmSamplePoint = atmEnter * 0.333 + atmLeave * 0.667;\n";
-    //source += "    atmSamplePoint = atmEnter * 0.1 + atmLeave * 0.9;\n";
-    source += "    float h = max(0.0, length(atmSamplePoint) - atmosphereRadius.z);\n";
-    source += "    density += exp(-h * mieH);\n";
-    source += "    atmSamplePoint = atmEnter * 0.667 + atmLeave * 0.333;\n";
-    //source += "    atmSamplePoint = atmEnter * 0.9 + atmLeave * 0.1;\n";
-    source += "    h = max(0.0, length(atmSamplePoint) - atmosphereRadius.z);\n";
-    source += "    density += exp(-h * mieH);\n";
-#endif
+    // Optical depths come from the precomputed transmittance table
+    // instead of a two-sample density approximation. The view path is
+    // the difference of two table entries taken along the reversed ray,
+    // so neither lookup can strike the planet.
+    source += "    vec3 atmSamplePointSun = (atmEnter + atmLeave) * 0.5;\n";
+    source += "    float tauSun = opticalDepth(atmSamplePointSun, " + LightProperty(0, "direction") + ");\n";
+    source += "    vec3 backDir = atmEnter - atmLeave;\n";
+    source += "    backDir = backDir / max(length(backDir), 1.0e-6);\n";
+    source += "    float tau = max(opticalDepth(atmLeave, backDir) - opticalDepth(atmEnter, backDir), 0.0);\n";
 
     bool hasAbsorption = true;
 
     string scatter;
     if (hasAbsorption)
     {
-        source += "    vec3 sunColor = exp(-extinctionCoeff * density * distSun);\n";
-        source += "    vec3 ex = exp(-extinctionCoeff * density * distAtm);\n";
+        source += "    vec3 sunColor = exp(-extinctionCoeff * tauSun);\n";
+        source += "    vec3 ex = exp(-extinctionCoeff * tau);\n";
 
-        scatter = "(1.0 - exp(-scatterCoeffSum * density * distAtm))";
+        scatter = "(1.0 - exp(-scatterCoeffSum * tau))";
     }
 #if 0
     else
     {
-        source += "    vec3 sunColor = exp(-scatterCoeffSum * density * distSun);\n";
-        source += "    vec3 ex = exp(-scatterCoeffSum * density * distAtm);\n";
+        source += "    vec3 sunColor = exp(-scatterCoeffSum * tauSun);\n";
+        source += "    vec3 ex = exp(-scatterCoeffSum * tau);\n";
 
         // If there's no absorption, the extinction coefficients are just the scattering coefficients,
         // so there's no need to recompute the scattering.
@@ -1491,6 +1884,22 @@ ScatteringConstantDeclarations(const ShaderProperties& /*props*/)
     source += "uniform vec3 scatterCoeffSum;\n";
     source += "uniform vec3 invScatterCoeffSum;\n";
     source += "uniform vec3 extinctionCoeff;\n";
+    source += "uniform sampler2D transmittanceTex;\n";
+    source += "uniform float transmittanceScale;\n";
+
+    // Optical depth along a ray from point p in direction d out to the
+    // top of the atmosphere, read from the precomputed transmittance
+    // table. Depths are stored as 16-bit fixed point split across two
+    // channels and normalized by transmittanceScale; rays that strike
+    // the planet saturate at the maximum depth.
+    source += "float opticalDepth(vec3 p, vec3 d)\n";
+    source += "{\n";
+    source += "    float r = length(p);\n";
+    source += "    float mu = dot(p, d) / r;\n";
+    source += "    float y = (r - atmosphereRadius.z) / (atmosphereRadius.x - atmosphereRadius.z);\n";
+    source += "    vec4 t = texture2DLod(transmittanceTex, vec2(mu * 0.5 + 0.5, y), 0.0);\n";
+    source += "    return (t.x + t.y * (1.0 / 256.0)) * transmittanceScale;\n";
+    source += "}\n";
 
     return source;
 }
@@ -1587,8 +1996,8 @@ PointSizeCalculation()
 }
 
 
-GLVertexShader*
-ShaderManager::buildVertexShader(const ShaderProperties& props)
+string
+ShaderManager::vertexShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -1899,16 +2308,12 @@ ShaderManager::buildVertexShader(const ShaderProperties& props)
     source += "gl_Position = ftransform();\n";
     source += "}\n";
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
-ShaderManager::buildFragmentShader(const ShaderProperties& props)
+string
+ShaderManager::fragmentShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2322,17 +2727,13 @@ ShaderManager::buildFragmentShader(const ShaderProperties& props)
 
     source += "}\n";
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source;
 }
 
 
 #if 0
-GLVertexShader*
-ShaderManager::buildRingsVertexShader(const ShaderProperties& props)
+string
+ShaderManager::ringsVertexShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2377,16 +2778,12 @@ ShaderManager::buildRingsVertexShader(const ShaderProperties& props)
     source += "gl_Position = ftransform();\n";
     source += "}\n";
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
-ShaderManager::buildRingsFragmentShader(const ShaderProperties& props)
+string
+ShaderManager::ringsFragmentShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2462,17 +2859,13 @@ ShaderManager::buildRingsFragmentShader(const ShaderProperties& props)
 
     source += "}\n";
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source;
 }
 #endif
 
 
-GLVertexShader*
-ShaderManager::buildRingsVertexShader(const ShaderProperties& props)
+string
+ShaderManager::ringsVertexShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2505,16 +2898,12 @@ ShaderManager::buildRingsVertexShader(const ShaderProperties& props)
     source += "gl_Position = ftransform();\n";
     source += "}\n";
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
-ShaderManager::buildRingsFragmentShader(const ShaderProperties& props)
+string
+ShaderManager::ringsFragmentShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2615,16 +3004,12 @@ ShaderManager::buildRingsFragmentShader(const ShaderProperties& props)
 
     source += "}\n";
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source;
 }
 
 
-GLVertexShader*
-ShaderManager::buildAtmosphereVertexShader(const ShaderProperties& props)
+string
+ShaderManager::atmosphereVertexShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2652,16 +3037,12 @@ ShaderManager::buildAtmosphereVertexShader(const ShaderProperties& props)
     source += "gl_Position = ftransform();\n";
     source += "}\n";
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
-ShaderManager::buildAtmosphereFragmentShader(const ShaderProperties& props)
+string
+ShaderManager::atmosphereFragmentShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2703,18 +3084,14 @@ ShaderManager::buildAtmosphereFragmentShader(const ShaderProperties& props)
     source += "    gl_FragColor = vec4(color, dot(scatterEx, vec3(0.333, 0.333, 0.333)));\n";
     source += "}\n";
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source;
 }
 
 
 // The emissive shader ignores all lighting and uses the diffuse color
 // as the final fragment color.
-GLVertexShader*
-ShaderManager::buildEmissiveVertexShader(const ShaderProperties& props)
+string
+ShaderManager::emissiveVertexShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2767,16 +3144,12 @@ ShaderManager::buildEmissiveVertexShader(const ShaderProperties& props)
     source += "}\n";
     // End of main()
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source, &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source;
 }
 
 
-GLFragmentShader*
-ShaderManager::buildEmissiveFragmentShader(const ShaderProperties& props)
+string
+ShaderManager::emissiveFragmentShaderSource(const ShaderProperties& props)
 {
     string source(CommonHeader);
 
@@ -2816,17 +3189,13 @@ ShaderManager::buildEmissiveFragmentShader(const ShaderProperties& props)
     source += "}\n";
     // End of main()
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source, &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source;
 }
 
 
 // Build the vertex shader used for rendering particle systems.
-GLVertexShader*
-ShaderManager::buildParticleVertexShader(const ShaderProperties& props)
+string
+ShaderManager::particleVertexShaderSource(const ShaderProperties& props)
 {
     ostringstream source;
 
@@ -2897,16 +3266,12 @@ ShaderManager::buildParticleVertexShader(const ShaderProperties& props)
     source << "}\n";
     // End of main()
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source.str(), &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source.str();
 }
 
 
-GLFragmentShader*
-ShaderManager::buildParticleFragmentShader(const ShaderProperties& props)
+string
+ShaderManager::particleFragmentShaderSource(const ShaderProperties& props)
 {
     ostringstream source;
 
@@ -2963,15 +3328,11 @@ ShaderManager::buildParticleFragmentShader(const ShaderProperties& props)
     source << "}\n";
     // End of main()
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source.str(), &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source.str();
 }
 
-GLVertexShader*
-ShaderManager::buildSimpleVertexShader(uint32_t props)
+string
+ShaderManager::simpleVertexShaderSource(uint32_t props)
 {
     ostringstream source;
 
@@ -2996,16 +3357,12 @@ ShaderManager::buildSimpleVertexShader(uint32_t props)
     source << "}\n";
     // End of main()
 
-    DumpVSSource(source);
-
-    GLVertexShader* vs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateVertexShader(source.str(), &vs);
-    return status == ShaderStatus_OK ? vs : nullptr;
+    return source.str();
 }
 
 
-GLFragmentShader*
-ShaderManager::buildSimpleFragmentShader(uint32_t props)
+string
+ShaderManager::simpleFragmentShaderSource(uint32_t props)
 {
     ostringstream source;
 
@@ -3035,54 +3392,98 @@ ShaderManager::buildSimpleFragmentShader(uint32_t props)
     source << "}\n";
     // End of main()
 
-    DumpFSSource(source);
-
-    GLFragmentShader* fs = nullptr;
-    GLShaderStatus status = GLShaderLoader::CreateFragmentShader(source.str(), &fs);
-    return status == ShaderStatus_OK ? fs : nullptr;
+    return source.str();
 }
 
 
 
-CelestiaGLProgram*
-ShaderManager::buildProgram(const ShaderProperties& props)
+void
+ShaderManager::buildShaderSources(const ShaderProperties& props,
+                                  std::string& vsSource,
+                                  std::string& fsSource)
 {
-    GLProgram* prog = nullptr;
-    GLShaderStatus status;
-
-    GLVertexShader* vs = nullptr;
-    GLFragmentShader* fs = nullptr;
-
     if (props.simpleProps != 0)
     {
-        vs = buildSimpleVertexShader(props.simpleProps);
-        fs = buildSimpleFragmentShader(props.simpleProps);
+        vsSource = simpleVertexShaderSource(props.simpleProps);
+        fsSource = simpleFragmentShaderSource(props.simpleProps);
     }
     else if (props.lightModel == ShaderProperties::RingIllumModel)
     {
-        vs = buildRingsVertexShader(props);
-        fs = buildRingsFragmentShader(props);
+        vsSource = ringsVertexShaderSource(props);
+        fsSource = ringsFragmentShaderSource(props);
     }
     else if (props.lightModel == ShaderProperties::AtmosphereModel)
     {
-        vs = buildAtmosphereVertexShader(props);
-        fs = buildAtmosphereFragmentShader(props);
+        vsSource = atmosphereVertexShaderSource(props);
+        fsSource = atmosphereFragmentShaderSource(props);
     }
     else if (props.lightModel == ShaderProperties::EmissiveModel)
     {
-        vs = buildEmissiveVertexShader(props);
-        fs = buildEmissiveFragmentShader(props);
+        vsSource = emissiveVertexShaderSource(props);
+        fsSource = emissiveFragmentShaderSource(props);
     }
     else if (props.lightModel == ShaderProperties::ParticleModel)
     {
-        vs = buildParticleVertexShader(props);
-        fs = buildParticleFragmentShader(props);
+        vsSource = particleVertexShaderSource(props);
+        fsSource = particleFragmentShaderSource(props);
     }
     else
     {
-        vs = buildVertexShader(props);
-        fs = buildFragmentShader(props);
+        vsSource = vertexShaderSource(props);
+        fsSource = fragmentShaderSource(props);
+    }
+}
+
+
+void
+ShaderManager::buildShaders(const ShaderProperties& props,
+                            GLVertexShader** vs,
+                            GLFragmentShader** fs)
+{
+    string vsSource;
+    string fsSource;
+
+#ifdef USE_PRECOMPILED_SHADERS
+    // Prefer a source pair generated at build time by shadergen. The
+    // embedded ring shadow variants assume ARB_shader_texture_lod.
+    if (!props.hasRingShadows() || GLEW_ARB_shader_texture_lod)
+    {
+        uint64_t key = props.packedKey();
+        for (unsigned int i = 0; i < PrecompiledShaderSourceCount; i++)
+        {
+            const PrecompiledShaderSource& pre = PrecompiledShaderSources[i];
+            if (pre.props.packedKey() == key)
+            {
+                vsSource = pre.vertexSource;
+                fsSource = pre.fragmentSource;
+                break;
+            }
+        }
     }
+#endif
+
+    if (vsSource.empty())
+        buildShaderSources(props, vsSource, fsSource);
+
+    DumpVSSource(vsSource);
+    DumpFSSource(fsSource);
+
+    GLShaderLoader::CreateVertexShader(vsSource, vs);
+    GLShaderLoader::CreateFragmentShader(fsSource, fs);
+}
+
+
+CelestiaGLProgram*
+ShaderManager::buildProgram(const ShaderProperties& props)
+{
+    CELZONE("shader/buildProgram");
+    GLProgram* prog = nullptr;
+    GLShaderStatus status;
+
+    GLVertexShader* vs = nullptr;
+    GLFragmentShader* fs = nullptr;
+
+    buildShaders(props, &vs, &fs);
 
     if (vs != nullptr && fs != nullptr)
     {
@@ -3102,7 +3503,14 @@ ShaderManager::buildProgram(const ShaderProperties& props)
                 glBindAttribLocation(prog->getID(), 7, "pointSize");
             }
 
+            if (ShaderCacheUsable())
+                glProgramParameteri(prog->getID(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
             status = prog->link();
+
+            // Save the linked binary so later runs can skip the compile
+            if (status == ShaderStatus_OK && ShaderCacheUsable())
+                SaveCachedShader(prog->getID(), props);
         }
     }
     else
@@ -3330,6 +3738,7 @@ CelestiaGLProgram::initParameters()
         miePhaseAsymmetry    = floatParam("mieK");
         rayleighCoeff        = vec3Param("rayleighCoeff");
         rayleighScaleHeight  = floatParam("rayleighH");
+        transmittanceScale   = floatParam("transmittanceScale");
         atmosphereRadius     = vec3Param("atmosphereRadius");
         scatterCoeffSum      = vec3Param("scatterCoeffSum");
         invScatterCoeffSum   = vec3Param("invScatterCoeffSum");
@@ -3415,6 +3824,13 @@ CelestiaGLProgram::initSamplers()
         if (slot != -1)
             glUniform1i(slot, nSamplers++);
     }
+
+    if (props.hasScattering())
+    {
+        int slot = glGetUniformLocation(program->getID(), "transmittanceTex");
+        if (slot != -1)
+            glUniform1i(slot, nSamplers++);
+    }
 }
 
 
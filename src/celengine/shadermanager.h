@@ -11,10 +11,12 @@
 #define _CELENGINE_SHADERMANAGER_H_
 
 #include <map>
+#include <unordered_map>
 #include <iostream>
 #include <celengine/glshader.h>
 #include <celengine/lightenv.h>
 #include <celengine/atmosphere.h>
+#include <celutil/memaudit.h>
 #include <Eigen/Geometry>
 
 #define ADVANCED_CLOUD_SHADOWS 0
@@ -48,6 +50,8 @@ class ShaderProperties
     bool hasScattering() const;
     bool isViewDependent() const;
 
+    uint64_t packedKey() const;
+
  enum
  {
      DiffuseTexture          =   0x01,
@@ -260,6 +264,10 @@ class CelestiaGLProgram
     // scatterCoeffSum when there is no absorption.
     Vec3ShaderParameter extinctionCoeff;
 
+    // Maximum optical depth encoded in the transmittance lookup table,
+    // in units of the object radius; used to decode table entries.
+    FloatShaderParameter transmittanceScale;
+
     // Radius of sphere for atmosphere--should be significantly larger than
     // scale height. Three components:
     //    x = radius
@@ -294,40 +302,78 @@ class CelestiaGLProgram
 };
 
 
-class ShaderManager
+// A vertex/fragment source pair emitted at build time by the shadergen
+// tool for a frequently used property set (see src/tools/shadergen). The
+// table is only present when the build enables PRECOMPILE_SHADERS.
+struct PrecompiledShaderSource
+{
+    ShaderProperties props;
+    const char* vertexSource;
+    const char* fragmentSource;
+};
+
+extern const PrecompiledShaderSource* PrecompiledShaderSources;
+extern const unsigned int PrecompiledShaderSourceCount;
+
+
+class ShaderManager : public MemoryReporter
 {
  public:
     ShaderManager();
     ~ShaderManager();
 
+    //! MemoryReporter: program objects and lookup tables. GPU-side
+    //! program binaries belong to the driver and are not visible here.
+    void reportMemory(MemoryLedger&) const override;
+
     CelestiaGLProgram* getShader(const ShaderProperties&);
     CelestiaGLProgram* getShader(const std::string&);
     CelestiaGLProgram* getShader(const std::string&, const std::string&, const std::string&);
 
+    // Assemble GLSL source for a property set. Requires no GL context;
+    // also used by the shadergen tool at build time.
+    static void buildShaderSources(const ShaderProperties&,
+                                   std::string& vsSource,
+                                   std::string& fsSource);
+
  private:
     CelestiaGLProgram* buildProgram(const ShaderProperties&);
     CelestiaGLProgram* buildProgram(const std::string&, const std::string&);
 
-    GLVertexShader* buildVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildFragmentShader(const ShaderProperties&);
+    void loadShaderCache();
 
-    GLVertexShader* buildRingsVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildRingsFragmentShader(const ShaderProperties&);
+    void buildShaders(const ShaderProperties&, GLVertexShader**, GLFragmentShader**);
+    GLProgram* issueProgram(const ShaderProperties&);
+    void checkPendingShaders();
+    CelestiaGLProgram* getFallbackShader(const ShaderProperties&);
 
-    GLVertexShader* buildAtmosphereVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildAtmosphereFragmentShader(const ShaderProperties&);
+    static std::string vertexShaderSource(const ShaderProperties&);
+    static std::string fragmentShaderSource(const ShaderProperties&);
 
-    GLVertexShader* buildEmissiveVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildEmissiveFragmentShader(const ShaderProperties&);
+    static std::string ringsVertexShaderSource(const ShaderProperties&);
+    static std::string ringsFragmentShaderSource(const ShaderProperties&);
 
-    GLVertexShader* buildParticleVertexShader(const ShaderProperties&);
-    GLFragmentShader* buildParticleFragmentShader(const ShaderProperties&);
+    static std::string atmosphereVertexShaderSource(const ShaderProperties&);
+    static std::string atmosphereFragmentShaderSource(const ShaderProperties&);
 
-    GLVertexShader* buildSimpleVertexShader(uint32_t);
-    GLFragmentShader* buildSimpleFragmentShader(uint32_t);
+    static std::string emissiveVertexShaderSource(const ShaderProperties&);
+    static std::string emissiveFragmentShaderSource(const ShaderProperties&);
 
-    std::map<ShaderProperties, CelestiaGLProgram*, ShaderProperties::Cmp> dynamicShaders;
+    static std::string particleVertexShaderSource(const ShaderProperties&);
+    static std::string particleFragmentShaderSource(const ShaderProperties&);
+
+    static std::string simpleVertexShaderSource(uint32_t);
+    static std::string simpleFragmentShaderSource(uint32_t);
+
+    // Programs indexed by the packed property encoding; lookups on the
+    // per-frame hot path do no string work and no field-by-field
+    // comparisons.
+    std::unordered_map<uint64_t, CelestiaGLProgram*> dynamicShaders;
     std::map<std::string, CelestiaGLProgram*> staticShaders;
+
+    // Programs whose compilation has been handed to the driver but not
+    // yet finished; a simplified fallback program stands in until then.
+    std::map<ShaderProperties, GLProgram*, ShaderProperties::Cmp> pendingShaders;
 };
 
 #endif // _CELENGINE_SHADERMANAGER_H_
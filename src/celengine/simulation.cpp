@@ -13,6 +13,7 @@
 #include <algorithm>
 #include "render.h"
 #include "simulation.h"
+#include <celutil/tracelog.h>
 
 using namespace Eigen;
 using namespace std;
@@ -33,6 +34,27 @@ Simulation::~Simulation()
 }
 
 
+void Simulation::addWatcher(SimulationWatcher* watcher)
+{
+    watchers.push_back(watcher);
+}
+
+
+void Simulation::removeWatcher(SimulationWatcher* watcher)
+{
+    auto iter = find(watchers.begin(), watchers.end(), watcher);
+    if (iter != watchers.end())
+        watchers.erase(iter);
+}
+
+
+void Simulation::notifyWatchers(int property)
+{
+    for (const auto watcher : watchers)
+        watcher->notifyChange(this, property);
+}
+
+
 static const Star* getSun(Body* body)
 {
     PlanetarySystem* system = body->getSystem();
@@ -42,6 +64,7 @@ static const Star* getSun(Body* body)
 
 void Simulation::render(Renderer& renderer)
 {
+    CELZONE("sim/render");
     renderer.render(*activeObserver,
                     *universe,
                     faintestVisible,
@@ -59,6 +82,7 @@ void Simulation::draw(Renderer& renderer)
 
 void Simulation::render(Renderer& renderer, Observer& observer)
 {
+    CELZONE("sim/renderView");
     renderer.render(observer,
                     *universe,
                     faintestVisible,
@@ -92,6 +116,7 @@ void Simulation::setTime(double jd)
     {
         activeObserver->setTime(jd);
     }
+    notifyWatchers(TimeJumped);
 }
 
 
@@ -111,6 +136,7 @@ double Simulation::getArrivalTime() const
 // Tick the simulation by dt seconds
 void Simulation::update(double dt)
 {
+    CELZONE("sim/update");
     realTime += dt;
 
     for (const auto observer : observers)
@@ -118,8 +144,27 @@ void Simulation::update(double dt)
         observer->update(dt, timeScale);
     }
 
-    // Find the closest solar system
-    closestSolarSystem = universe->getNearestSolarSystem(activeObserver->getPosition());
+    // Find the closest solar system. The search walks the star octree
+    // and its result depends only on the observer's position (catalog
+    // positions are fixed) and on the set of loaded systems, so repeat
+    // it only when either has changed meaningfully. The tolerance is
+    // tiny against the one light year search radius, but it skips the
+    // octree walk entirely while the observer sits inside a system.
+    static const double nearestSystemToleranceLy = 1.0e-5;
+
+    UniversalCoord pos = activeObserver->getPosition();
+    SolarSystemCatalog* catalog = universe->getSolarSystemCatalog();
+    std::size_t catalogSize = catalog != nullptr ? catalog->size() : 0;
+
+    if (!closestSystemValid ||
+        catalogSize != closestSystemCatalogSize ||
+        astro::kilometersToLightYears(pos.offsetFromKm(closestSystemSearchPos).norm()) > nearestSystemToleranceLy)
+    {
+        closestSolarSystem = universe->getNearestSolarSystem(pos);
+        closestSystemSearchPos = pos;
+        closestSystemCatalogSize = catalogSize;
+        closestSystemValid = true;
+    }
 }
 
 
@@ -131,7 +176,34 @@ Selection Simulation::getSelection() const
 
 void Simulation::setSelection(const Selection& sel)
 {
+    if (selection == sel)
+        return;
+
     selection = sel;
+    notifyWatchers(SelectionChanged);
+}
+
+
+void Simulation::markObject(const Selection& sel,
+                            const MarkerRepresentation& markerRep,
+                            int owner)
+{
+    universe->markObject(sel, markerRep, owner);
+    notifyWatchers(MarkersChanged);
+}
+
+
+void Simulation::unmarkObject(const Selection& sel, int owner)
+{
+    universe->unmarkObject(sel, owner);
+    notifyWatchers(MarkersChanged);
+}
+
+
+void Simulation::unmarkAll()
+{
+    universe->unmarkAll();
+    notifyWatchers(MarkersChanged);
 }
 
 
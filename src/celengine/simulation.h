@@ -19,11 +19,15 @@
 #include <celengine/texmanager.h>
 #include <celengine/frame.h>
 #include <celengine/observer.h>
+#include <celutil/watcher.h>
 #include <Eigen/Core>
 #include <vector>
 
 
 class Renderer;
+class Simulation;
+
+typedef Watcher<Simulation> SimulationWatcher;
 
 class Simulation
 {
@@ -31,6 +35,20 @@ class Simulation
     Simulation(Universe*);
     ~Simulation();
 
+    //! Discrete state changes reported to SimulationWatchers. The
+    //! continuous advance of time and observer motion in update() are
+    //! deliberately not reported; watchers poll those if they need
+    //! them.
+    enum
+    {
+        SelectionChanged = 1,
+        TimeJumped       = 2,
+        MarkersChanged   = 4,
+    };
+
+    void addWatcher(SimulationWatcher*);
+    void removeWatcher(SimulationWatcher*);
+
     double getTime() const; // Julian date
     void setTime(double jd);
 
@@ -57,6 +75,14 @@ class Simulation
     Selection getTrackedObject() const;
     void setTrackedObject(const Selection&);
 
+    // Marker changes are routed through the simulation so that
+    // watchers hear about them.
+    void markObject(const Selection&,
+                    const MarkerRepresentation& markerRep,
+                    int owner);
+    void unmarkObject(const Selection&, int owner);
+    void unmarkAll();
+
     void selectPlanet(int);
     Selection findObject(std::string s, bool i18n = false);
     Selection findObjectFromPath(std::string s, bool i18n = false);
@@ -118,6 +144,7 @@ class Simulation
 
  private:
     SolarSystem* getSolarSystem(const Star* star);
+    void notifyWatchers(int);
 
  private:
     double realTime{ 0.0 };
@@ -128,6 +155,13 @@ class Simulation
     Universe* universe;
 
     SolarSystem* closestSolarSystem{ nullptr };
+
+    // State of the most recent nearest-solar-system search; update()
+    // repeats the octree query only when these go stale.
+    UniversalCoord closestSystemSearchPos;
+    std::size_t closestSystemCatalogSize{ 0 };
+    bool closestSystemValid{ false };
+
     Selection selection;
 
     Observer* activeObserver;
@@ -135,6 +169,8 @@ class Simulation
 
     float faintestVisible{ 5.0f };
     bool pauseState{ false };
+
+    std::vector<SimulationWatcher*> watchers;
 };
 
 #endif // _CELENGINE_SIMULATION_H_
@@ -31,8 +31,19 @@ using namespace celmath;
 // The maximum number of parallels or meridians that will be visible
 const double MAX_VISIBLE_ARCS = 10.0;
 
-// Number of line segments used to approximate one arc of the celestial sphere
-const int ARC_SUBDIVISIONS = 100;
+// Number of line segments in the cached tessellation of a full great
+// circle. The per-frame path subdivided just the visible arc, so the
+// cached circles use a finer subdivision to stay smooth when zoomed in.
+const int CIRCLE_SUBDIVISIONS = 720;
+
+// Number of line segments in the cached meridian arc; meridians span at
+// most half a great circle.
+const int MERIDIAN_SUBDIVISIONS = CIRCLE_SUBDIVISIONS / 2;
+
+// Fraction of the half field of view the view may drift before cached
+// label anchors are recomputed. Anchors are fixed to the sky, so between
+// recomputations the labels merely lag the frustum edges slightly.
+const double LABEL_VIEW_SLACK = 0.01;
 
 // Size of the cross indicating the north and south poles
 const double POLAR_CROSS_SIZE = 0.01;
@@ -543,10 +554,33 @@ SkyGrid::render(Renderer& renderer,
     Quaterniond q = xrot90 * m_orientation * xrot90.conjugate();
     Quaternionf orientationf = q.cast<float>();
 
+    // Label anchors are expensive to place (plane/circle intersections and
+    // sexigesimal formatting), but they are fixed to the sky, so the anchors
+    // from the previous placement remain valid while the view stays close to
+    // the one they were computed for. Recompute them only when the combined
+    // camera/grid rotation has drifted appreciably or any discrete placement
+    // parameter changed.
+    Quaterniond viewOrientation = cameraOrientation * xrot90 * m_orientation.conjugate() * xrot90.conjugate();
+    double viewDelta = 2.0 * std::acos(std::min(1.0, std::fabs(viewOrientation.dot(m_cachedViewOrientation))));
+    bool labelsStale = viewDelta > halfFov * LABEL_VIEW_SLACK ||
+                       vfov != m_cachedFov ||
+                       windowWidth != m_cachedWindowWidth ||
+                       windowHeight != m_cachedWindowHeight ||
+                       raIncrement != m_cachedRaIncrement ||
+                       decIncrement != m_cachedDecIncrement;
+    if (labelsStale)
+    {
+        m_cachedLabels.clear();
+        m_cachedViewOrientation = viewOrientation;
+        m_cachedFov = vfov;
+        m_cachedWindowWidth = windowWidth;
+        m_cachedWindowHeight = windowHeight;
+        m_cachedRaIncrement = raIncrement;
+    }
+
     prog->use();
     prog->vec4Param("color") = m_lineColor.toVector4();
 
-    // Render the parallels
     glPushMatrix();
     glRotate(xrot90 * m_orientation.conjugate() * xrot90.conjugate());
 
@@ -554,28 +588,59 @@ SkyGrid::render(Renderer& renderer,
     // intersect the near or far plane of the view frustum.
     glScalef(1000.0f, 1000.0f, 1000.0f);
 
-    double arcStep = (maxTheta - minTheta) / (double) ARC_SUBDIVISIONS;
-    double theta0 = minTheta;
+    // Render meridians only to the last latitude circle; this looks better
+    // than spokes radiating from the pole.
+    double maxMeridianAngle = PI / 2.0 * (1.0 - 2.0 * (double) decIncrement / (double) DEG_MIN_SEC_TOTAL);
+    double cosMaxMeridianAngle = cos(maxMeridianAngle);
 
-    auto buffer = new Vector3f[ARC_SUBDIVISIONS+1];
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, buffer);
+    // All parallels are scaled copies of one circle and all meridians are
+    // rotated copies of one arc, so a single tessellation of each template,
+    // kept in a GPU buffer, serves every line of the grid. The templates
+    // depend only on the grid density and are regenerated when it changes.
+    bool rebuildMesh = decIncrement != m_cachedDecIncrement;
+    if (rebuildMesh)
+        m_vo.bindWritable();
+    else
+        m_vo.bind();
+    if (!m_vo.initialized() || rebuildMesh)
+    {
+        vector<Vector3f> mesh;
+        mesh.reserve(CIRCLE_SUBDIVISIONS + MERIDIAN_SUBDIVISIONS + 2);
+
+        // Unit circle in the xz plane; Celestia coordinates
+        for (int j = 0; j <= CIRCLE_SUBDIVISIONS; j++)
+        {
+            double theta = 2.0 * PI * (double) j / (double) CIRCLE_SUBDIVISIONS;
+            mesh.emplace_back((float) std::cos(theta), 0.0f, (float) -std::sin(theta));
+        }
+
+        // Prime meridian arc between the last latitude circles
+        for (int j = 0; j <= MERIDIAN_SUBDIVISIONS; j++)
+        {
+            double phi = maxMeridianAngle * (2.0 * (double) j / (double) MERIDIAN_SUBDIVISIONS - 1.0);
+            mesh.emplace_back((float) std::cos(phi), (float) std::sin(phi), 0.0f);
+        }
+
+        m_vo.allocate(mesh.size() * sizeof(Vector3f), mesh.data());
+        m_vo.setVertices(3, GL_FLOAT);
+        m_cachedDecIncrement = decIncrement;
+    }
 
+    // Render the parallels
     for (int dec = startDec; dec <= endDec; dec += decIncrement)
     {
         double phi = PI * (double) dec / (double) DEG_MIN_SEC_TOTAL;
         double cosPhi = cos(phi);
         double sinPhi = sin(phi);
 
-        for (int j = 0; j <= ARC_SUBDIVISIONS; j++)
-        {
-            double theta = theta0 + j * arcStep;
-            auto x = (float) (cosPhi * std::cos(theta));
-            auto y = (float) (cosPhi * std::sin(theta));
-            auto z = (float) sinPhi;
-            buffer[j] = {x, z, -y};  // convert to Celestia coords
-        }
-        glDrawArrays(GL_LINE_STRIP, 0, ARC_SUBDIVISIONS+1);
+        glPushMatrix();
+        glTranslated(0.0, sinPhi, 0.0);
+        glScaled(cosPhi, 1.0, cosPhi);
+        m_vo.draw(GL_LINE_STRIP, CIRCLE_SUBDIVISIONS + 1);
+        glPopMatrix();
+
+        if (!labelsStale)
+            continue;
 
         // Place labels at the intersections of the view frustum planes
         // and the parallels.
@@ -586,8 +651,6 @@ SkyGrid::render(Renderer& renderer,
         {
             Vector3d isect0(Vector3d::Zero());
             Vector3d isect1(Vector3d::Zero());
-            Renderer::LabelAlignment hAlign = getCoordLabelHAlign(k);
-            Renderer::LabelVerticalAlignment vAlign = getCoordLabelVAlign(k);
 
             if (planeCircleIntersection(frustumNormal[k], center, axis0, axis1,
                                         &isect0, &isect1))
@@ -607,51 +670,31 @@ SkyGrid::render(Renderer& renderer,
                 glEnd();
 #endif
 
-                Matrix3f m = observer.getOrientationf().toRotationMatrix();
                 p0 = orientationf.conjugate() * p0;
                 p1 = orientationf.conjugate() * p1;
 
-                if ((m * p0).z() < 0.0)
-                {
-                    renderer.addBackgroundAnnotation(nullptr, labelText, m_labelColor, p0, hAlign, vAlign);
-                }
-
-                if ((m * p1).z() < 0.0)
-                {
-                    renderer.addBackgroundAnnotation(nullptr, labelText, m_labelColor, p1, hAlign, vAlign);
-                }
+                m_cachedLabels.push_back({ labelText, p0, k });
+                m_cachedLabels.push_back({ labelText, p1, k });
             }
         }
     }
 
     // Draw the meridians
-
-    // Render meridians only to the last latitude circle; this looks better
-    // than spokes radiating from the pole.
-    double maxMeridianAngle = PI / 2.0 * (1.0 - 2.0 * (double) decIncrement / (double) DEG_MIN_SEC_TOTAL);
-    minDec = std::max(minDec, -maxMeridianAngle);
-    maxDec = std::min(maxDec,  maxMeridianAngle);
-    arcStep = (maxDec - minDec) / (double) ARC_SUBDIVISIONS;
-    double phi0 = minDec;
-
-    double cosMaxMeridianAngle = cos(maxMeridianAngle);
-
     for (int ra = startRa; ra <= endRa; ra += raIncrement)
     {
         double theta = 2.0 * PI * (double) ra / (double) totalLongitudeUnits;
+
+        glPushMatrix();
+        glRotated(theta * 180.0 / PI, 0.0, 1.0, 0.0);
+        m_vo.draw(GL_LINE_STRIP, MERIDIAN_SUBDIVISIONS + 1, CIRCLE_SUBDIVISIONS + 1);
+        glPopMatrix();
+
+        if (!labelsStale)
+            continue;
+
         double cosTheta = cos(theta);
         double sinTheta = sin(theta);
 
-        for (int j = 0; j <= ARC_SUBDIVISIONS; j++)
-        {
-            double phi = phi0 + j * arcStep;
-            auto x = (float) (cos(phi) * cosTheta);
-            auto y = (float) (cos(phi) * sinTheta);
-            auto z = (float) sin(phi);
-            buffer[j] = {x, z, -y};  // convert to Celestia coords
-        }
-        glDrawArrays(GL_LINE_STRIP, 0, ARC_SUBDIVISIONS+1);
-
         // Place labels at the intersections of the view frustum planes
         // and the meridians.
         Vector3d center(0.0, 0.0, 0.0);
@@ -661,8 +704,6 @@ SkyGrid::render(Renderer& renderer,
         {
             Vector3d isect0(0.0, 0.0, 0.0);
             Vector3d isect1(0.0, 0.0, 0.0);
-            Renderer::LabelAlignment hAlign = getCoordLabelHAlign(k);
-            Renderer::LabelVerticalAlignment vAlign = getCoordLabelVAlign(k);
 
             if (planeCircleIntersection(frustumNormal[k], center, axis0, axis1,
                                         &isect0, &isect1))
@@ -682,36 +723,51 @@ SkyGrid::render(Renderer& renderer,
                 glEnd();
 #endif
 
-                Matrix3f m = observer.getOrientationf().toRotationMatrix();
                 p0 = orientationf.conjugate() * p0;
                 p1 = orientationf.conjugate() * p1;
 
-                if ((m * p0).z() < 0.0 && axis0.dot(isect0) >= cosMaxMeridianAngle)
-                {
-                    renderer.addBackgroundAnnotation(nullptr, labelText, m_labelColor, p0, hAlign, vAlign);
-                }
+                if (axis0.dot(isect0) >= cosMaxMeridianAngle)
+                    m_cachedLabels.push_back({ labelText, p0, k });
 
-                if ((m * p1).z() < 0.0 && axis0.dot(isect1) >= cosMaxMeridianAngle)
-                {
-                    renderer.addBackgroundAnnotation(nullptr, labelText, m_labelColor, p1, hAlign, vAlign);
-                }
+                if (axis0.dot(isect1) >= cosMaxMeridianAngle)
+                    m_cachedLabels.push_back({ labelText, p1, k });
             }
         }
     }
 
-    // Draw crosses indicating the north and south poles
-    buffer[0] = {-polarCrossSize, 1.0f,  0.0f};
-    buffer[1] = { polarCrossSize, 1.0f,  0.0f};
-    buffer[2] = {0.0f, 1.0f, -polarCrossSize};
-    buffer[3] = {0.0f, 1.0f,  polarCrossSize};
-    buffer[4] = {-polarCrossSize, -1.0f,  0.0f};
-    buffer[5] = { polarCrossSize, -1.0f,  0.0f};
-    buffer[6] = {0.0f, -1.0f, -polarCrossSize};
-    buffer[7] = {0.0f, -1.0f,  polarCrossSize};
+    m_vo.unbind();
+
+    // Draw crosses indicating the north and south poles; their size tracks
+    // the field of view, so they stay in a small client-side array.
+    Vector3f crosses[8] = {
+        {-polarCrossSize, 1.0f,  0.0f},
+        { polarCrossSize, 1.0f,  0.0f},
+        {0.0f, 1.0f, -polarCrossSize},
+        {0.0f, 1.0f,  polarCrossSize},
+        {-polarCrossSize, -1.0f,  0.0f},
+        { polarCrossSize, -1.0f,  0.0f},
+        {0.0f, -1.0f, -polarCrossSize},
+        {0.0f, -1.0f,  polarCrossSize}
+    };
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, crosses);
     glDrawArrays(GL_LINES, 0, 8);
-
     glDisableClientState(GL_VERTEX_ARRAY);
+
     glPopMatrix();
     glUseProgram(0);
-    delete[] buffer;
+
+    // Submit the cached anchors; visibility depends on the current camera
+    // orientation, so it is retested every frame.
+    Matrix3f m = observer.getOrientationf().toRotationMatrix();
+    for (const auto& label : m_cachedLabels)
+    {
+        if ((m * label.position).z() < 0.0f)
+        {
+            renderer.addBackgroundAnnotation(nullptr, label.text, m_labelColor,
+                                             label.position,
+                                             getCoordLabelHAlign(label.planeIndex),
+                                             getCoordLabelVAlign(label.planeIndex));
+        }
+    }
 }
@@ -14,9 +14,11 @@
 #define _CELENGINE_SKYGRID_H_
 
 #include <string>
+#include <vector>
 #include <celutil/color.h>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include "vertexobject.h"
 
 class Renderer;
 class Observer;
@@ -102,6 +104,16 @@ public:
     }
 
 private:
+    //! A coordinate label anchor cached in universal coordinates. The
+    //! anchor's visibility is retested every frame; only its position and
+    //! text are reused between recomputations.
+    struct CachedLabel
+    {
+        std::string text;
+        Eigen::Vector3f position;
+        int planeIndex;     // view frustum plane the label is attached to
+    };
+
     std::string latitudeLabel(int latitude, int latitudeStep) const;
     std::string longitudeLabel(int longitude, int longitudeStep) const;
     int parallelSpacing(double idealSpacing) const;
@@ -113,6 +125,21 @@ private:
     Color m_labelColor{ Color::White };
     LongitudeUnits m_longitudeUnits{ LongitudeHours };
     LongitudeDirection m_longitudeDirection{ IncreasingCounterclockwise };
+
+    // Tessellations of a template circle and meridian arc, shared by all
+    // parallels and meridians and regenerated only when the grid density
+    // changes.
+    celgl::VertexObject m_vo{ GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW };
+    int m_cachedDecIncrement{ -1 };
+
+    // Label anchors from the last full placement pass, reused while the
+    // view stays close to the one they were computed for.
+    std::vector<CachedLabel> m_cachedLabels;
+    Eigen::Quaterniond m_cachedViewOrientation{ Eigen::Quaterniond::Identity() };
+    double m_cachedFov{ -1.0 };
+    int m_cachedWindowWidth{ 0 };
+    int m_cachedWindowHeight{ 0 };
+    int m_cachedRaIncrement{ -1 };
 };
 
 #endif // _CELENGINE_PLANETGRID_H_
@@ -21,6 +21,8 @@
 #include "parser.h"
 #include "texmanager.h"
 #include "meshmanager.h"
+#include "trajmanager.h"
+#include "rotationmanager.h"
 #include "universe.h"
 #include "multitexture.h"
 #include "parseobject.h"
@@ -75,9 +77,14 @@ enum BodyType
   The name and parent name are both mandatory.
 */
 
+static void errorMessagePrelude(int lineNumber)
+{
+    fmt::fprintf(cerr,_("Error in .ssc file (line %d): "), lineNumber);
+}
+
 static void errorMessagePrelude(const Tokenizer& tok)
 {
-    fmt::fprintf(cerr,_("Error in .ssc file (line %d): "), tok.getLineNumber());
+    errorMessagePrelude(tok.getLineNumber());
 }
 
 static void sscError(const Tokenizer& tok,
@@ -87,6 +94,12 @@ static void sscError(const Tokenizer& tok,
     cerr << msg << '\n';
 }
 
+static void sscError(int lineNumber, const string& msg)
+{
+    errorMessagePrelude(lineNumber);
+    cerr << msg << '\n';
+}
+
 
 // Object class properties
 static const int CLASSES_UNCLICKABLE           = Body::Invisible |
@@ -261,6 +274,19 @@ static void FillinSurface(Hash* surfaceData,
 }
 
 
+Surface* CreateAltSurface(Value* definition, const fs::path& directory)
+{
+    if (definition == nullptr || definition->getType() != Value::HashType)
+        return nullptr;
+
+    Surface* surface = new Surface();
+    surface->color = Color(1.0f, 1.0f, 1.0f);
+    FillinSurface(definition->getHash(), surface, directory);
+
+    return surface;
+}
+
+
 static Selection GetParentObject(PlanetarySystem* system)
 {
     Selection parent;
@@ -1078,44 +1104,50 @@ static Body* CreateReferencePoint(const string& name,
 }
 
 
-bool LoadSolarSystemObjects(istream& in,
-                            Universe& universe,
-                            const fs::path& directory)
+bool ParseSolarSystemObjects(istream& in,
+                             vector<SolarSystemObjectEntry>& objects,
+                             MemoryPool* valuePool)
 {
     Tokenizer tokenizer(&in);
-    Parser parser(&tokenizer);
+    return ParseSolarSystemObjects(tokenizer, objects, valuePool);
+}
 
-    const char* d = directory.string().c_str();
-    bindtextdomain(d, d); // domain name is the same as resource path
+
+bool ParseSolarSystemObjects(Tokenizer& tokenizer,
+                             vector<SolarSystemObjectEntry>& objects,
+                             MemoryPool* valuePool)
+{
+    Parser parser(&tokenizer, valuePool);
 
     while (tokenizer.nextToken() != Tokenizer::TokenEnd)
     {
+        SolarSystemObjectEntry entry;
+        entry.lineNumber = tokenizer.getLineNumber();
+
         // Read the disposition; if none is specified, the default is Add.
-        DataDisposition disposition = DataDisposition::Add;
         if (tokenizer.getTokenType() == Tokenizer::TokenName)
         {
             if (tokenizer.getNameValue() == "Add")
             {
-                disposition = DataDisposition::Add;
+                entry.disposition = DataDisposition::Add;
                 tokenizer.nextToken();
             }
             else if (tokenizer.getNameValue() == "Replace")
             {
-                disposition = DataDisposition::Replace;
+                entry.disposition = DataDisposition::Replace;
                 tokenizer.nextToken();
             }
             else if (tokenizer.getNameValue() == "Modify")
             {
-                disposition = DataDisposition::Modify;
+                entry.disposition = DataDisposition::Modify;
                 tokenizer.nextToken();
             }
         }
 
         // Read the item type; if none is specified the default is Body
-        string itemType("Body");
         if (tokenizer.getTokenType() == Tokenizer::TokenName)
         {
-            itemType = tokenizer.getNameValue();
+            entry.itemType = tokenizer.getNameValue();
             tokenizer.nextToken();
         }
 
@@ -1127,14 +1159,14 @@ bool LoadSolarSystemObjects(istream& in,
 
         // The name list is a string with zero more names. Multiple names are
         // delimited by colons.
-        string nameList = tokenizer.getStringValue().c_str();
+        entry.nameList = tokenizer.getStringValue().c_str();
 
         if (tokenizer.nextToken() != Tokenizer::TokenString)
         {
             sscError(tokenizer, "bad parent object name");
             return false;
         }
-        string parentName = tokenizer.getStringValue().c_str();
+        entry.parentName = tokenizer.getStringValue().c_str();
 
         Value* objectDataValue = parser.readValue();
         if (objectDataValue == nullptr)
@@ -1149,15 +1181,111 @@ bool LoadSolarSystemObjects(istream& in,
             delete objectDataValue;
             return false;
         }
-        Hash* objectData = objectDataValue->getHash();
 
-        Selection parent = universe.findPath(parentName, nullptr, 0);
+        entry.objectData = objectDataValue;
+        objects.push_back(entry);
+    }
+
+    return true;
+}
+
+
+// Begin background loads for the sampled trajectory and orientation files
+// referenced by an object definition. The handles created here are the same
+// ones that CreateOrbit/CreateRotationModel request later, so by the time a
+// timeline is built each file is either resident or already being parsed.
+static void PrefetchObjectResources(Hash* objectData, const fs::path& path)
+{
+    Value* sampledTrajDataValue = objectData->getValue("SampledTrajectory");
+    if (sampledTrajDataValue != nullptr && sampledTrajDataValue->getType() == Value::HashType)
+    {
+        Hash* trajData = sampledTrajDataValue->getHash();
+        string sourceName;
+        if (trajData->getString("Source", sourceName))
+        {
+            // Defaults must match CreateSampledTrajectory(), or the
+            // prefetched handle won't be the one requested later.
+            TrajectoryInterpolation interpolation = TrajectoryInterpolationCubic;
+            string interpolationString;
+            if (trajData->getString("Interpolation", interpolationString) &&
+                !compareIgnoringCase(interpolationString, "linear"))
+            {
+                interpolation = TrajectoryInterpolationLinear;
+            }
+
+            bool useDoublePrecision = true;
+            trajData->getBoolean("DoublePrecision", useDoublePrecision);
+            TrajectoryPrecision precision = useDoublePrecision ? TrajectoryPrecisionDouble : TrajectoryPrecisionSingle;
+
+            TrajectoryManager* trajManager = GetTrajectoryManager();
+            trajManager->prefetch(trajManager->getHandle(TrajectoryInfo(sourceName, path, interpolation, precision)));
+        }
+    }
+
+    string sampOrbitFile;
+    if (objectData->getString("SampledOrbit", sampOrbitFile))
+    {
+        TrajectoryManager* trajManager = GetTrajectoryManager();
+        trajManager->prefetch(trajManager->getHandle(TrajectoryInfo(sampOrbitFile,
+                                                                    path,
+                                                                    TrajectoryInterpolationCubic,
+                                                                    TrajectoryPrecisionSingle)));
+    }
+
+    string sampOrientationFile;
+    if (objectData->getString("SampledOrientation", sampOrientationFile))
+    {
+        RotationModelManager* rotationManager = GetRotationModelManager();
+        rotationManager->prefetch(rotationManager->getHandle(RotationModelInfo(sampOrientationFile, path)));
+    }
+}
+
+
+// Scan parsed catalog entries for trajectory and orientation sources and
+// start loading them in the background, so that file parsing overlaps with
+// the object construction in ApplySolarSystemObjects().
+static void PrefetchSolarSystemResources(const vector<SolarSystemObjectEntry>& objects,
+                                         const fs::path& directory)
+{
+    for (const auto& entry : objects)
+    {
+        Hash* objectData = entry.objectData->getHash();
+        PrefetchObjectResources(objectData, directory);
+
+        // Sources may also appear inside the phases of an explicit timeline
+        Value* timelineValue = objectData->getValue("Timeline");
+        if (timelineValue != nullptr && timelineValue->getType() == Value::ArrayType)
+        {
+            for (Value* phaseValue : *timelineValue->getArray())
+            {
+                if (phaseValue->getType() == Value::HashType)
+                    PrefetchObjectResources(phaseValue->getHash(), directory);
+            }
+        }
+    }
+}
+
+
+bool ApplySolarSystemObjects(vector<SolarSystemObjectEntry>& objects,
+                             Universe& universe,
+                             const fs::path& directory)
+{
+    const char* d = directory.string().c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+
+    PrefetchSolarSystemResources(objects, directory);
+
+    for (auto& entry : objects)
+    {
+        Hash* objectData = entry.objectData->getHash();
+
+        Selection parent = universe.findPath(entry.parentName, nullptr, 0);
         PlanetarySystem* parentSystem = nullptr;
 
         vector<string> names;
         // Iterate through the string for names delimited
         // by ':', and insert them into the name list.
-        if (nameList.empty())
+        if (entry.nameList.empty())
         {
             names.push_back("");
         }
@@ -1166,25 +1294,25 @@ bool LoadSolarSystemObjects(istream& in,
             string::size_type startPos   = 0;
             while (startPos != string::npos)
             {
-                string::size_type next    = nameList.find(':', startPos);
+                string::size_type next    = entry.nameList.find(':', startPos);
                 string::size_type length  = string::npos;
                 if (next != string::npos)
                 {
                     length   = next - startPos;
                     ++next;
                 }
-                names.push_back(nameList.substr(startPos, length));
+                names.push_back(entry.nameList.substr(startPos, length));
                 startPos   = next;
             }
         }
         string primaryName = names.front();
 
         BodyType bodyType = UnknownBodyType;
-        if (itemType == "Body")
+        if (entry.itemType == "Body")
             bodyType = NormalBody;
-        else if (itemType == "ReferencePoint")
+        else if (entry.itemType == "ReferencePoint")
             bodyType = ReferencePoint;
-        else if (itemType == "SurfaceObject")
+        else if (entry.itemType == "SurfaceObject")
             bodyType = SurfaceObject;
 
         if (bodyType != UnknownBodyType)
@@ -1216,8 +1344,8 @@ bool LoadSolarSystemObjects(istream& in,
             }
             else
             {
-                errorMessagePrelude(tokenizer);
-                fmt::fprintf(cerr, _("parent body '%s' of '%s' not found.\n"), parentName, primaryName);
+                errorMessagePrelude(entry.lineNumber);
+                fmt::fprintf(cerr, _("parent body '%s' of '%s' not found.\n"), entry.parentName, primaryName);
             }
 
             if (parentSystem != nullptr)
@@ -1225,12 +1353,12 @@ bool LoadSolarSystemObjects(istream& in,
                 Body* existingBody = parentSystem->find(primaryName);
                 if (existingBody)
                 {
-                    if (disposition == DataDisposition::Add)
+                    if (entry.disposition == DataDisposition::Add)
                     {
-                        errorMessagePrelude(tokenizer);
-                        fmt::fprintf(cerr, _("warning duplicate definition of %s %s\n"), parentName, primaryName);
+                        errorMessagePrelude(entry.lineNumber);
+                        fmt::fprintf(cerr, _("warning duplicate definition of %s %s\n"), entry.parentName, primaryName);
                     }
-                    else if (disposition == DataDisposition::Replace)
+                    else if (entry.disposition == DataDisposition::Replace)
                     {
                         existingBody->setDefaultProperties();
                     }
@@ -1238,35 +1366,41 @@ bool LoadSolarSystemObjects(istream& in,
 
                 Body* body;
                 if (bodyType == ReferencePoint)
-                    body = CreateReferencePoint(primaryName, parentSystem, universe, existingBody, objectData, directory, disposition);
+                    body = CreateReferencePoint(primaryName, parentSystem, universe, existingBody, objectData, directory, entry.disposition);
                 else
-                    body = CreateBody(primaryName, parentSystem, universe, existingBody, objectData, directory, disposition, bodyType);
+                    body = CreateBody(primaryName, parentSystem, universe, existingBody, objectData, directory, entry.disposition, bodyType);
 
                 if (body != nullptr)
                 {
-                    body->loadCategories(objectData, disposition, directory.string());
-                    if (disposition == DataDisposition::Add)
+                    body->loadCategories(objectData, entry.disposition, directory.string());
+                    if (entry.disposition == DataDisposition::Add)
                         for (const auto& name : names)
                             body->addAlias(name);
                 }
             }
         }
-        else if (itemType == "AltSurface")
+        else if (entry.itemType == "AltSurface")
         {
-            Surface* surface = new Surface();
-            surface->color = Color(1.0f, 1.0f, 1.0f);
-            FillinSurface(objectData, surface, directory);
             if (parent.body() != nullptr)
-                parent.body()->addAlternateSurface(primaryName, surface);
+            {
+                // Stage the definition unparsed; most alternate surfaces
+                // are never selected. The staged copy is detached with
+                // clone() because it can outlive a per-file value arena.
+                parent.body()->addAlternateSurfaceDefinition(primaryName,
+                                                             entry.objectData->clone(),
+                                                             directory);
+            }
             else
-                sscError(tokenizer, _("bad alternate surface"));
+            {
+                sscError(entry.lineNumber, _("bad alternate surface"));
+            }
         }
-        else if (itemType == "Location")
+        else if (entry.itemType == "Location")
         {
             if (parent.body() != nullptr)
             {
                 Location* location = CreateLocation(objectData, parent.body());
-                location->loadCategories(objectData, disposition, directory.string());
+                location->loadCategories(objectData, entry.disposition, directory.string());
                 if (location != nullptr)
                 {
                     location->setName(primaryName);
@@ -1274,23 +1408,43 @@ bool LoadSolarSystemObjects(istream& in,
                 }
                 else
                 {
-                    sscError(tokenizer, _("bad location"));
+                    sscError(entry.lineNumber, _("bad location"));
                 }
             }
             else
             {
-                errorMessagePrelude(tokenizer);
-                fmt::fprintf(cerr, _("parent body '%s' of '%s' not found.\n"), parentName, primaryName);
+                errorMessagePrelude(entry.lineNumber);
+                fmt::fprintf(cerr, _("parent body '%s' of '%s' not found.\n"), entry.parentName, primaryName);
             }
         }
-        delete objectDataValue;
+
+        delete entry.objectData;
+        entry.objectData = nullptr;
     }
 
-    // TODO: Return some notification if there's an error parsing the file
+    objects.clear();
+
     return true;
 }
 
 
+bool LoadSolarSystemObjects(istream& in,
+                            Universe& universe,
+                            const fs::path& directory)
+{
+    vector<SolarSystemObjectEntry> objects;
+    MemoryPool valuePool(16, 65536);
+    bool ok = ParseSolarSystemObjects(in, objects, &valuePool);
+
+    // Apply whatever parsed successfully even when the file has trailing
+    // errors; this matches the previous incremental behavior.
+    ApplySolarSystemObjects(objects, universe, directory);
+
+    // TODO: Return some notification if there's an error parsing the file
+    return ok;
+}
+
+
 SolarSystem::SolarSystem(Star* _star) :
     star(_star),
     planets(nullptr),
@@ -15,6 +15,8 @@
 #include <iostream>
 #include <celengine/body.h>
 #include <celengine/stardb.h>
+#include <celengine/parser.h>
+#include <celengine/parseobject.h>
 
 class FrameTree;
 
@@ -39,6 +41,44 @@ typedef std::map<uint32_t, SolarSystem*> SolarSystemCatalog;
 
 class Universe;
 
+//! One object definition parsed from an ssc catalog and staged for
+//! later application to the Universe. objectData is owned by the entry
+//! until ApplySolarSystemObjects() consumes it.
+struct SolarSystemObjectEntry
+{
+    DataDisposition disposition{ DataDisposition::Add };
+    std::string itemType{ "Body" };
+    std::string nameList;
+    std::string parentName;
+    Value* objectData{ nullptr };
+    int lineNumber{ 0 };
+};
+
+// Parse object definitions from an ssc stream into a staging list
+// without touching the Universe. Has no shared state, so independent
+// files may be parsed on separate threads.
+// Instantiate a Surface from an ssc AltSurface definition. Used by
+// Body to parse staged alternate surfaces on first request. Returns
+// nullptr if the definition is not an assoc array.
+Surface* CreateAltSurface(Value* definition, const fs::path& directory);
+
+// When a MemoryPool is supplied the staged Value trees are arena
+// allocated; the pool must then outlive the staging list, including
+// its pass through ApplySolarSystemObjects.
+bool ParseSolarSystemObjects(std::istream& in,
+                             std::vector<SolarSystemObjectEntry>& objects,
+                             MemoryPool* valuePool = nullptr);
+bool ParseSolarSystemObjects(Tokenizer& tokenizer,
+                             std::vector<SolarSystemObjectEntry>& objects,
+                             MemoryPool* valuePool = nullptr);
+
+// Apply previously parsed definitions to the Universe in list order.
+// Not thread safe; entries referring to objects from other catalogs
+// must be applied after them.
+bool ApplySolarSystemObjects(std::vector<SolarSystemObjectEntry>& objects,
+                             Universe& universe,
+                             const fs::path& dir = fs::path());
+
 bool LoadSolarSystemObjects(std::istream& in,
                             Universe& universe,
                             const fs::path& dir = fs::path());
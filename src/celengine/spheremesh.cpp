@@ -16,6 +16,7 @@
 #include <celmath/mathlib.h>
 #include <GL/glew.h>
 #include <cmath>
+#include <vector>
 
 using namespace Eigen;
 
@@ -54,6 +55,18 @@ SphereMesh::SphereMesh(const Vector3f& size,
     fixNormals();
 }
 
+SphereMesh::SphereMesh(const Vector3f& size,
+                       int _nRings, int _nSlices,
+                       DisplacementMapBatchFunc func,
+                       void* info)
+{
+    createSphere(1.0f, _nRings, _nSlices);
+    scale(size);
+    displace(func, info);
+    generateNormals();
+    fixNormals();
+}
+
 SphereMesh::~SphereMesh()
 {
     delete[] vertices;
@@ -342,6 +355,38 @@ void SphereMesh::displace(DisplacementMapFunc func, void* info)
 }
 
 
+void SphereMesh::displace(DisplacementMapBatchFunc func, void* info)
+{
+    // Evaluate a full ring of displacements per call so that batched
+    // (SIMD) noise kernels see long runs of samples.
+    std::vector<float> u(nSlices + 1);
+    std::vector<float> v(nSlices + 1);
+    std::vector<float> d(nSlices + 1);
+
+    for (int j = 0; j <= nSlices; j++)
+        u[j] = (float) j / (float) nSlices;
+
+    for (int i = 0; i < nRings; i++)
+    {
+        float rowV = (float) i / (float) (nRings - 1);
+        for (int j = 0; j <= nSlices; j++)
+            v[j] = rowV;
+
+        func(u.data(), v.data(), d.data(), (unsigned int) (nSlices + 1), info);
+
+        for (int j = 0; j <= nSlices; j++)
+        {
+            int n = (i * (nSlices + 1) + j) * 3;
+            Vector3f normal(normals[n], normals[n + 1], normals[n + 2]);
+            Vector3f vert = normal * d[j];
+            vertices[n]     += vert.x();
+            vertices[n + 1] += vert.y();
+            vertices[n + 2] += vert.z();
+        }
+    }
+}
+
+
 Mesh* SphereMesh::convertToMesh() const
 {
     uint32_t stride = 32;
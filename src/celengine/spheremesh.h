@@ -38,6 +38,10 @@ public:
                int _nRings, int _nSlices,
                DisplacementMapFunc func,
                void* info);
+    SphereMesh(const Eigen::Vector3f& size,
+               int _nRings, int _nSlices,
+               DisplacementMapBatchFunc func,
+               void* info);
     ~SphereMesh();
 
     //! Convert this object into a standard Celestia mesh.
@@ -50,6 +54,7 @@ public:
     void fixNormals();
     void displace(const DisplacementMap& dispmap, float height);
     void displace(DisplacementMapFunc func, void* info);
+    void displace(DisplacementMapBatchFunc func, void* info);
 
     int nRings;
     int nSlices;
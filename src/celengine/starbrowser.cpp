@@ -11,200 +11,102 @@
 
 #include <string>
 #include <algorithm>
-#include <set>
 #include "starbrowser.h"
 
 using namespace Eigen;
 using namespace std;
 
 
-// TODO: More of the functions in this module should be converted to
-// methods of the StarBrowser class.
-
-struct CloserStarPredicate
+// Stars with planetary systems are a tiny subset of the catalog, so
+// the list is assembled straight from the solar system catalog and
+// sorted by distance, rather than scanning all stars.
+static std::vector<const Star*>
+starsWithPlanets(const Universe* univ, const Vector3f& pos, unsigned int nStars)
 {
-    Vector3f pos;
-    bool operator()(const Star* star0, const Star* star1) const
-    {
-        Vector3f p0 = star0->getPosition();
-        Vector3f p1 = star1->getPosition();
-
-#if 0
-        Vector3f v0(p0.x * 1e6 - pos.x, p0.y * 1e6 - pos.y, p0.z * 1e6 - pos.z);
-        Vector3f v1(p1.x * 1e6 - pos.x, p1.y * 1e6 - pos.y, p1.z * 1e6 - pos.z);
-#endif
-        Vector3f v0 = p0 * 1.0e6f - pos;
-        Vector3f v1 = p1 * 1.0e6f - pos;
-
-        return (v0.squaredNorm() < v1.squaredNorm());
-    }
-};
+    std::vector<const Star*> stars;
 
+    SolarSystemCatalog* solarSystems = univ->getSolarSystemCatalog();
+    const StarDatabase* stardb = univ->getStarCatalog();
+    if (solarSystems == nullptr || stardb == nullptr)
+        return stars;
 
-struct BrighterStarPredicate
-{
-    Vector3f pos;
-    UniversalCoord ucPos;
-    bool operator()(const Star* star0, const Star* star1) const
+    stars.reserve(solarSystems->size());
+    for (const auto& system : *solarSystems)
     {
-        Vector3f p0 = star0->getPosition();
-        Vector3f p1 = star1->getPosition();
-        Vector3f v0 = p0 * 1.0e6f - pos;
-        Vector3f v1 = p1 * 1.0e6f - pos;
-        float d0 = v0.norm();
-        float d1 = v1.norm();
-
-        return (star0->getApparentMagnitude(d0) <
-                star1->getApparentMagnitude(d1));
+        const Star* star = stardb->find(system.first);
+        if (star != nullptr)
+            stars.push_back(star);
     }
-};
 
+    sort(stars.begin(), stars.end(),
+         [&pos](const Star* star0, const Star* star1)
+         {
+             return ((star0->getPosition() - pos).squaredNorm() <
+                     (star1->getPosition() - pos).squaredNorm());
+         });
 
-struct BrightestStarPredicate
-{
-    bool operator()(const Star* star0, const Star* star1) const
-    {
-        return (star0->getAbsoluteMagnitude() <
-                star1->getAbsoluteMagnitude());
-    }
-};
+    if (stars.size() > nStars)
+        stars.resize(nStars);
+    return stars;
+}
 
 
-struct SolarSystemPredicate
+const Star* StarBrowser::nearestStar()
 {
-    Vector3f pos;
-    SolarSystemCatalog* solarSystems;
-
-    bool operator()(const Star* star0, const Star* star1) const
-    {
-        SolarSystemCatalog::iterator iter;
-
-        iter = solarSystems->find(star0->getCatalogNumber());
-        bool hasPlanets0 = (iter != solarSystems->end());
-        iter = solarSystems->find(star1->getCatalogNumber());
-        bool hasPlanets1 = (iter != solarSystems->end());
-        if (hasPlanets1 == hasPlanets0)
-        {
-            Vector3f p0 = star0->getPosition();
-            Vector3f p1 = star1->getPosition();
-            Vector3f v0 = p0 * 1.0e6f - pos;
-            Vector3f v1 = p1 * 1.0e6f - pos;
-            return (v0.squaredNorm() < v1.squaredNorm());
-        }
-        else
-        {
-            return hasPlanets0;
-        }
-    }
-};
+    const StarDatabase* stardb = appSim->getUniverse()->getStarCatalog();
+    std::vector<const Star*> stars = stardb->nearestStars(pos, 1);
+    return stars.empty() ? nullptr : stars.front();
+}
 
 
-// Find the nearest/brightest/X-est N stars in a database.  The
-// supplied predicate determines which of two stars is a better match.
-template<class Pred> static std::vector<const Star*>*
-findStars(const StarDatabase& stardb, Pred pred, int nStars)
+std::vector<const Star*>*
+StarBrowser::listStars(unsigned int nStars)
 {
-    std::vector<const Star*>* finalStars = new std::vector<const Star*>();
-    if (nStars == 0)
-        return finalStars;
-    if(nStars > 500)
+    if (nStars > 500)
         nStars = 500;
 
-    typedef std::multiset<const Star*, Pred> StarSet;
-    StarSet firstStars(pred);
-
-    int totalStars = stardb.size();
-    if (totalStars < nStars)
-        nStars = totalStars;
+    // The result set changes slowly as the observer drifts, so the
+    // previous query is reused until the observer has moved
+    // appreciably or the query itself changed.
+    static const float cachedPosToleranceLy = 0.001f;
 
-    // We'll need at least nStars in the set, so first fill
-    // up the list indiscriminately.
-    int i = 0;
-    for (i = 0; i < nStars; i++)
-        firstStars.insert(stardb.getStar(i));
-
-    // From here on, only add a star to the set if it's
-    // a better match than the worst matching star already
-    // in the set.
-    const Star* lastStar = *--firstStars.end();
-    for (; i < totalStars; i++)
+    if (predicate == cachedPredicate &&
+        nStars == cachedCount &&
+        (pos - cachedPos).norm() < cachedPosToleranceLy)
     {
-        Star* star = stardb.getStar(i);
-        if (pred(star, lastStar))
-        {
-            firstStars.insert(star);
-            firstStars.erase(--firstStars.end());
-            lastStar = *--firstStars.end();
-        }
+        return new std::vector<const Star*>(cachedStars);
     }
 
-    // Move the best matching stars into the vector
-    finalStars->reserve(nStars);
-    for (const auto& star : firstStars)
-        finalStars->push_back(star);
-
-    return finalStars;
-}
-
+    const Universe* univ = appSim->getUniverse();
+    const StarDatabase* stardb = univ->getStarCatalog();
 
-const Star* StarBrowser::nearestStar()
-{
-    Universe* univ = appSim->getUniverse();
-    CloserStarPredicate closerPred;
-    closerPred.pos = pos;
-    std::vector<const Star*>* stars = findStars(*(univ->getStarCatalog()), closerPred, 1);
-    const Star *star = (*stars)[0];
-    delete stars;
-    return star;
-}
-
-
-std::vector<const Star*>*
-StarBrowser::listStars(unsigned int nStars)
-{
-    Universe* univ = appSim->getUniverse();
-    switch(predicate)
+    std::vector<const Star*> stars;
+    switch (predicate)
     {
     case BrighterStars:
-        {
-            BrighterStarPredicate brighterPred;
-            brighterPred.pos = pos;
-            brighterPred.ucPos = ucPos;
-            return findStars(*(univ->getStarCatalog()), brighterPred, nStars);
-        }
+        stars = stardb->brightestStars(pos, nStars);
         break;
 
     case BrightestStars:
-        {
-            BrightestStarPredicate brightestPred;
-            return findStars(*(univ->getStarCatalog()), brightestPred, nStars);
-        }
+        stars = stardb->brightestAbsoluteStars(nStars);
         break;
 
     case StarsWithPlanets:
-        {
-            SolarSystemCatalog* solarSystems = univ->getSolarSystemCatalog();
-            if (!solarSystems)
-                return nullptr;
-            SolarSystemPredicate solarSysPred;
-            solarSysPred.pos = pos;
-            solarSysPred.solarSystems = solarSystems;
-            return findStars(*(univ->getStarCatalog()), solarSysPred,
-                             min((size_t) nStars, solarSystems->size()));
-        }
+        stars = starsWithPlanets(univ, pos, nStars);
         break;
 
     case NearestStars:
     default:
-        {
-            CloserStarPredicate closerPred;
-            closerPred.pos = pos;
-            return findStars(*(univ->getStarCatalog()), closerPred, nStars);
-        }
+        stars = stardb->nearestStars(pos, nStars);
         break;
     }
 
-    return nullptr;  // keep compiler happy
+    cachedStars = stars;
+    cachedPos = pos;
+    cachedPredicate = predicate;
+    cachedCount = nStars;
+
+    return new std::vector<const Star*>(std::move(stars));
 }
 
 
@@ -45,6 +45,13 @@ class StarBrowser
  private:
     Simulation *appSim;
     int predicate;
+
+    // Cached results of the last query; listStars() reuses them until
+    // the observer has moved appreciably or the query itself changes.
+    std::vector<const Star*> cachedStars;
+    Eigen::Vector3f cachedPos{ 0.0f, 0.0f, 0.0f };
+    int cachedPredicate{ -1 };
+    unsigned int cachedCount{ 0 };
 };
 
 #endif // _CELENGINE_STARBROWSER_H_
@@ -14,7 +14,7 @@
 
 
 // Approximate colors used by older versions of Celestia
-Color StarColors_Enhanced[41] =
+constexpr Color StarColors_Enhanced[41] =
 {
     Color(0.00f, 0.00f, 0.00f), // T = 0K
     Color(0.75f, 0.20f, 0.20f), // T = 1000K
@@ -64,7 +64,7 @@ Color StarColors_Enhanced[41] =
 // Generated by Mitchell Charity <mcharity@lcs.mit.edu>
 // See "What Color is a Blackbody":
 //     http://www.vendian.org/mncharity/dir3/blackbody/
-Color StarColors_Blackbody_2deg_D65[401] =
+constexpr Color StarColors_Blackbody_2deg_D65[401] =
 {
     Color(0.0000f, 0.0000f, 0.0000f),    // T=     0K P=2.472e+06
     Color(1.0000f, 0.0337f, 0.0000f),    // T=   100K P=2.472e+06
@@ -470,29 +470,22 @@ Color StarColors_Blackbody_2deg_D65[401] =
 };
 
 
-static ColorTemperatureTable* enhanced = nullptr;
-static ColorTemperatureTable* blackbodyD65 = nullptr;
+// Both the color arrays above and the tables indexing them are
+// constant-initialized: they live in the read-only data segment and
+// cost nothing at startup.
+constexpr ColorTemperatureTable enhanced(StarColors_Enhanced, 41, 40000.0f);
+constexpr ColorTemperatureTable blackbodyD65(StarColors_Blackbody_2deg_D65, 401, 40000.0f);
 
-ColorTemperatureTable*
+const ColorTemperatureTable*
 GetStarColorTable(ColorTableType ct)
 {
     switch (ct)
     {
     case ColorTable_Enhanced:
-        if (enhanced == nullptr)
-        {
-            enhanced = new ColorTemperatureTable(StarColors_Enhanced,
-                                                 41, 40000.0f);
-        }
-        return enhanced;
+        return &enhanced;
 
     case ColorTable_Blackbody_D65:
-        if (blackbodyD65 == nullptr)
-        {
-            blackbodyD65 = new ColorTemperatureTable(StarColors_Blackbody_2deg_D65,
-                                                     401, 40000.0f);
-        }
-        return blackbodyD65;
+        return &blackbodyD65;
 
     default:
         return nullptr;
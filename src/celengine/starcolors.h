@@ -18,9 +18,9 @@
 class ColorTemperatureTable
 {
  public:
-    ColorTemperatureTable(Color* _colors,
-                          unsigned int _nColors,
-                          float maxTemp) :
+    constexpr ColorTemperatureTable(const Color* _colors,
+                                    unsigned int _nColors,
+                                    float maxTemp) :
         colors(_colors),
         nColors(_nColors),
         tempScale((float) (_nColors - 1) / maxTemp)
@@ -35,6 +35,16 @@ class ColorTemperatureTable
             return colors[colorTableIndex];
     }
 
+    //! Look up a batch of temperatures at once; colors must have room
+    //! for count entries. Keeps the table state (base, count, scale) in
+    //! registers across the whole batch for bulk consumers that process
+    //! stars as arrays rather than one visitor call at a time.
+    void lookupColors(const float* temps, Color* colors, unsigned int count) const
+    {
+        for (unsigned int i = 0; i < count; i++)
+            colors[i] = lookupColor(temps[i]);
+    }
+
  private:
     const Color* colors;
     unsigned nColors;
@@ -47,7 +57,7 @@ enum ColorTableType
     ColorTable_Blackbody_D65,
 };
 
-extern ColorTemperatureTable* GetStarColorTable(ColorTableType);
+extern const ColorTemperatureTable* GetStarColorTable(ColorTableType);
 
 
 #endif // _CELENGINE_STARCOLORS_H_
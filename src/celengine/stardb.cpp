@@ -12,12 +12,21 @@
 #include <cmath>
 #include <cstdlib>
 #include <celutil/debug.h>
+#include <celutil/tracelog.h>
 #include <cassert>
 #include <algorithm>
 #include <celmath/mathlib.h>
 #include <celutil/util.h>
 #include <celutil/bytes.h>
+#include <celutil/compress.h>
+#include <celutil/memmap.h>
 #include <celengine/stardb.h>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
 #include <config.h>
 #include "astro.h"
 #include "parser.h"
@@ -53,6 +62,59 @@ constexpr const float STAR_OCTREE_MAGNITUDE   = 6.0f;
 constexpr const char FILE_HEADER[]            = "CELSTARS";
 constexpr const char CROSSINDEX_FILE_HEADER[] = "CELINDEX";
 
+// Version 0x0100 is the classic packed stream format; version 0x0200
+// stores fixed-size little-endian records whose field order matches the
+// in-memory Star layout, so a memory mapped catalog can be decoded with
+// straight copies on little-endian hosts (byte swapping was already done
+// at pack time).
+constexpr const uint16_t StarDBVersion       = 0x0100;
+constexpr const uint16_t StarDBPackedVersion = 0x0200;
+
+// Version 0x0300 is the compact format: stars are grouped by the leaf
+// cubes of an octree subdivision and stored in traversal order, with
+// positions quantized to 16 bits per axis relative to the group cube,
+// spectral types indexed into a per-group palette, and catalog numbers
+// delta coded as varints within each group. Group record blocks carry
+// their byte length, so groups decode independently and in parallel.
+// Written by makestardb --compact; roughly half the size of the 20
+// byte stream records for large catalogs.
+constexpr const uint16_t StarDBCompactVersion = 0x0300;
+
+// Version 0x0301 additionally stores the absolute magnitude of each
+// group's brightest member in the group header. That lets the loader
+// defer groups too faint for the resident tier: their records stay in
+// the backing store and are only decoded when the observer's position
+// and magnitude limit make them visible, so startup time and resident
+// memory scale with the bright tier rather than the catalog.
+constexpr const uint16_t StarDBTieredVersion = 0x0301;
+
+// A compact format group never holds more than this many stars, so a
+// palette index always fits in one byte.
+constexpr const uint32_t CompactGroupMaxStars = 256;
+
+// Residency threshold for the tiered compact format: groups whose
+// brightest member is at or brighter than this absolute magnitude are
+// decoded at load, the rest on demand.
+constexpr const float DeepTierMagLimit = 9.0f;
+
+// At most this many deferred groups stay decoded at once; the least
+// recently visible ones are evicted when the budget is exceeded.
+constexpr const unsigned int DeferredGroupBudget = 4096;
+
+// Never evict a group processed within this many visibility queries.
+// Cached traversal results (VisibleStarSet) replay star pointers for
+// up to 30 frames per view, so the eviction age must comfortably
+// exceed any replay window even with several active views.
+constexpr const uint32_t DeferredGroupMinAge = 512;
+
+// Sidecar cache holding the spatial sort permutation and flattened
+// octree node records; lets finish() skip octree construction when the
+// loaded catalogs are unchanged. The cache is written in host byte order
+// and carries an endianness tag, since it is a per-machine artifact.
+constexpr const char OCTREE_CACHE_HEADER[]   = "CELOCTRE";
+constexpr const uint16_t OctreeCacheVersion  = 0x0100;
+constexpr const uint32_t OctreeCacheByteOrderTag = 0x01020304;
+
 
 // Used to sort stars by catalog number
 struct CatalogNumberOrderingPredicate
@@ -182,13 +244,85 @@ bool StarDatabase::CrossIndexEntry::operator<(const StarDatabase::CrossIndexEntr
 StarDatabase::StarDatabase()
 {
     crossIndexes.resize(MaxCatalog);
+    crossIndexLookups.resize(MaxCatalog);
+    GetMemoryAudit().registerReporter(this);
+}
+
+
+void StarDatabase::reportMemory(MemoryLedger& ledger) const
+{
+    ledger.add("stardb", "stars", (std::uintmax_t) nStars * sizeof(Star));
+    ledger.add("stardb", "catalog index", (std::uintmax_t) nStars * sizeof(Star*));
+
+    if (octreeRoot != nullptr)
+    {
+        // Every node with children owns an array of eight child
+        // pointers; countChildren() totals the children themselves.
+        std::uintmax_t nChildren = (std::uintmax_t) octreeRoot->countChildren();
+        ledger.add("stardb", "octree",
+                   (nChildren + 1) * sizeof(StarOctree) + nChildren * sizeof(StarOctree*));
+    }
+
+    std::uintmax_t crossIndexBytes = 0;
+    for (const auto index : crossIndexes)
+    {
+        if (index != nullptr)
+            crossIndexBytes += index->capacity() * sizeof(CrossIndexEntry);
+    }
+    for (const auto& lookup : crossIndexLookups)
+    {
+        for (const auto& page : lookup.pages)
+            crossIndexBytes += page.capacity() * sizeof(uint32_t);
+    }
+    ledger.add("stardb", "cross indexes", crossIndexBytes);
+
+    if (!deferredGroups.empty())
+    {
+        std::uintmax_t deepTierBytes = deferredGroups.capacity() * sizeof(DeferredGroup);
+        {
+            std::lock_guard<std::mutex> lock(deferredGroupMutex);
+            for (const auto& group : deferredGroups)
+                deepTierBytes += group.stars.capacity() * sizeof(Star);
+        }
+        ledger.add("stardb", "deep tier", deepTierBytes);
+    }
+
+    if (namesDB != nullptr)
+        ledger.add("stardb", "names", namesDB->bytesUsed());
+}
+
+
+void StarDatabase::CrossIndexLookup::build(const CrossIndex& xindex)
+{
+    pages.clear();
+    for (const auto& ent : xindex)
+    {
+        uint32_t page = ent.catalogNumber >> PageBits;
+        if (page >= pages.size())
+            pages.resize(page + 1);
+        if (pages[page].empty())
+            pages[page].assign(PageSize, Star::InvalidCatalogNumber);
+        pages[page][ent.catalogNumber & (PageSize - 1)] = ent.celCatalogNumber;
+    }
+}
+
+
+uint32_t StarDatabase::CrossIndexLookup::lookup(uint32_t number) const
+{
+    uint32_t page = number >> PageBits;
+    if (page >= pages.size() || pages[page].empty())
+        return Star::InvalidCatalogNumber;
+    return pages[page][number & (PageSize - 1)];
 }
 
 
 StarDatabase::~StarDatabase()
 {
+    GetMemoryAudit().unregisterReporter(this);
+
     delete [] stars;
     delete [] catalogNumberIndex;
+    delete compactMapping;
 
     for (const auto index : crossIndexes)
         delete index;
@@ -288,22 +422,10 @@ uint32_t StarDatabase::crossIndex(const Catalog catalog, const uint32_t celCatal
 // in a cross index.
 uint32_t StarDatabase::searchCrossIndexForCatalogNumber(const Catalog catalog, const uint32_t number) const
 {
-    if (static_cast<unsigned int>(catalog) >= crossIndexes.size())
-        return Star::InvalidCatalogNumber;
-
-    CrossIndex* xindex = crossIndexes[catalog];
-    if (xindex == nullptr)
+    if (static_cast<unsigned int>(catalog) >= crossIndexLookups.size())
         return Star::InvalidCatalogNumber;
 
-    CrossIndexEntry xindexEnt;
-    xindexEnt.catalogNumber = number;
-
-    CrossIndex::iterator iter = lower_bound(xindex->begin(), xindex->end(),
-                                            xindexEnt);
-    if (iter == xindex->end() || iter->catalogNumber != number)
-        return Star::InvalidCatalogNumber;
-    else
-        return iter->celCatalogNumber;
+    return crossIndexLookups[catalog].lookup(number);
 }
 
 
@@ -492,8 +614,10 @@ void StarDatabase::findVisibleStars(StarHandler& starHandler,
                                     float fovY,
                                     float aspectRatio,
                                     float limitingMag,
-                                    OctreeProcStats *stats) const
+                                    OctreeProcStats *stats,
+                                    bool includeDeferred) const
 {
+    CELZONE("stardb/findVisibleStars");
     // Compute the bounding planes of an infinite view frustum
     Hyperplane<float, 3> frustumPlanes[5];
     Vector3f planeNormals[5];
@@ -517,6 +641,87 @@ void StarDatabase::findVisibleStars(StarHandler& starHandler,
                                       limitingMag,
                                       STAR_OCTREE_ROOT_SIZE,
                                       stats);
+
+    if (includeDeferred && !deferredGroups.empty())
+        processDeferredGroups(starHandler, position, frustumPlanes, limitingMag);
+}
+
+
+// Process the stars of the deep tier groups that are currently
+// visible. Groups are rejected from their headers alone -- first by
+// the apparent magnitude of their brightest member at the observer's
+// distance, then against the view frustum like an octree node -- and
+// only the survivors are decoded from the backing store. Groups that
+// go unprocessed long enough to be outside any cached traversal replay
+// window are evicted again once the decoded budget is exceeded.
+void StarDatabase::processDeferredGroups(StarHandler& starHandler,
+                                         const Vector3f& position,
+                                         const Hyperplane<float, 3>* frustumPlanes,
+                                         float limitingMag) const
+{
+    lock_guard<mutex> lock(deferredGroupMutex);
+    ++deferredClock;
+
+    unordered_map<uint16_t, StarDetails*> detailsCache;
+
+    for (auto& group : deferredGroups)
+    {
+        float minDistance = (position - group.center).norm() -
+                            group.halfSize * (float) sqrt(3.0);
+        if (minDistance > 0 &&
+            astro::absToAppMag(group.brightestMag, minDistance) > limitingMag)
+            continue;
+
+        bool culled = false;
+        for (unsigned int i = 0; i < 5; ++i)
+        {
+            const Hyperplane<float, 3>& plane = frustumPlanes[i];
+            float r = group.halfSize * plane.normal().cwiseAbs().sum();
+            if (plane.signedDistance(group.center) < -r)
+            {
+                culled = true;
+                break;
+            }
+        }
+        if (culled)
+            continue;
+
+        if (group.stars.empty() && group.starCount > 0)
+        {
+            group.stars.reserve(group.starCount);
+            if (!decodeGroupStars(group, group.stars, detailsCache,
+                                  deferredDetailsMutex))
+            {
+                group.stars.clear();
+                continue;
+            }
+            ++decodedDeferredGroups;
+        }
+        group.lastUsed = deferredClock;
+
+        // Deep tier stars never have orbits, so unlike the octree
+        // per-object loop there is no orbit size test here.
+        for (const auto& star : group.stars)
+        {
+            float distance = (star.getPosition() - position).norm();
+            float appMag = astro::absToAppMag(star.getAbsoluteMagnitude(), distance);
+            if (appMag <= limitingMag)
+                starHandler.process(star, distance, appMag);
+        }
+    }
+
+    if (decodedDeferredGroups <= DeferredGroupBudget)
+        return;
+    for (auto& group : deferredGroups)
+    {
+        if (!group.stars.empty() && deferredClock - group.lastUsed > DeferredGroupMinAge)
+        {
+            group.stars.clear();
+            group.stars.shrink_to_fit();
+            if (--decodedDeferredGroups <= DeferredGroupBudget)
+                break;
+        }
+    }
 }
 
 
@@ -524,6 +729,7 @@ void StarDatabase::findCloseStars(StarHandler& starHandler,
                                   const Vector3f& position,
                                   float radius) const
 {
+    CELZONE("stardb/findCloseStars");
     octreeRoot->processCloseObjects(starHandler,
                                     position,
                                     radius,
@@ -531,6 +737,199 @@ void StarDatabase::findCloseStars(StarHandler& starHandler,
 }
 
 
+// Candidate entry for the k-best octree queries below. The heap top
+// is the current worst candidate (farthest, or faintest), which the
+// traversal uses as its pruning bound.
+typedef pair<float, const Star*> StarCandidate;
+
+
+static void nearestStarsNode(const StarOctree* node,
+                             float scale,
+                             const Vector3f& origin,
+                             unsigned int k,
+                             priority_queue<StarCandidate>& best)
+{
+    float nodeRadius = scale * (float) sqrt(3.0);
+    float nodeMinDistance = std::max((origin - node->cellCenter()).norm() - nodeRadius, 0.0f);
+
+    // Once k candidates are collected, a node farther away than the
+    // worst of them cannot improve the result.
+    if (best.size() >= k && nodeMinDistance * nodeMinDistance >= best.top().first)
+        return;
+
+    const Star* first = node->firstObject();
+    for (unsigned int i = 0; i < node->objectCount(); ++i)
+    {
+        const Star& star = first[i];
+        float distanceSquared = (star.getPosition() - origin).squaredNorm();
+        if (best.size() < k)
+        {
+            best.emplace(distanceSquared, &star);
+        }
+        else if (distanceSquared < best.top().first)
+        {
+            best.pop();
+            best.emplace(distanceSquared, &star);
+        }
+    }
+
+    if (node->hasChildren())
+    {
+        // Visit the closest children first so the candidate heap
+        // tightens as early as possible.
+        pair<float, unsigned int> order[8];
+        for (unsigned int i = 0; i < 8; ++i)
+            order[i] = make_pair((origin - node->child(i)->cellCenter()).squaredNorm(), i);
+        sort(order, order + 8);
+
+        for (unsigned int i = 0; i < 8; ++i)
+            nearestStarsNode(node->child(order[i].second), scale * 0.5f, origin, k, best);
+    }
+}
+
+
+static void brightestStarsNode(const StarOctree* node,
+                               float scale,
+                               const Vector3f& origin,
+                               unsigned int k,
+                               priority_queue<StarCandidate>& best)
+{
+    // A node's own objects can be arbitrarily bright, so they are
+    // always examined once the node is reached; the magnitude bound
+    // only gates the descent into children, which by construction
+    // hold nothing brighter than this node's exclusion magnitude.
+    const Star* first = node->firstObject();
+    for (unsigned int i = 0; i < node->objectCount(); ++i)
+    {
+        const Star& star = first[i];
+        float distance = (star.getPosition() - origin).norm();
+        float appMag = star.getApparentMagnitude(distance);
+        if (best.size() < k)
+        {
+            best.emplace(appMag, &star);
+        }
+        else if (appMag < best.top().first)
+        {
+            best.pop();
+            best.emplace(appMag, &star);
+        }
+    }
+
+    if (!node->hasChildren())
+        return;
+
+    float childRadius = scale * 0.5f * (float) sqrt(3.0);
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        const StarOctree* child = node->child(i);
+        float childMinDistance =
+            std::max((origin - child->cellCenter()).norm() - childRadius, 0.0f);
+
+        if (best.size() >= k &&
+            childMinDistance > 0.0f &&
+            astro::absToAppMag(node->getExclusionFactor(), childMinDistance) > best.top().first)
+        {
+            continue;
+        }
+
+        brightestStarsNode(child, scale * 0.5f, origin, k, best);
+    }
+}
+
+
+static void brightestAbsoluteNode(const StarOctree* node,
+                                  unsigned int k,
+                                  priority_queue<StarCandidate>& best)
+{
+    const Star* first = node->firstObject();
+    for (unsigned int i = 0; i < node->objectCount(); ++i)
+    {
+        const Star& star = first[i];
+        float absMag = star.getAbsoluteMagnitude();
+        if (best.size() < k)
+        {
+            best.emplace(absMag, &star);
+        }
+        else if (absMag < best.top().first)
+        {
+            best.pop();
+            best.emplace(absMag, &star);
+        }
+    }
+
+    if (!node->hasChildren())
+        return;
+
+    // Children hold nothing brighter than this node's exclusion
+    // magnitude, so a full candidate set that already beats it ends
+    // the descent.
+    if (best.size() >= k && node->getExclusionFactor() > best.top().first)
+        return;
+
+    for (unsigned int i = 0; i < 8; ++i)
+        brightestAbsoluteNode(node->child(i), k, best);
+}
+
+
+vector<const Star*> StarDatabase::nearestStars(const Vector3f& position,
+                                               unsigned int k) const
+{
+    vector<const Star*> results;
+    if (k == 0 || octreeRoot == nullptr)
+        return results;
+
+    priority_queue<StarCandidate> best;
+    nearestStarsNode(octreeRoot, STAR_OCTREE_ROOT_SIZE, position, k, best);
+
+    results.resize(best.size());
+    for (size_t i = best.size(); i-- > 0;)
+    {
+        results[i] = best.top().second;
+        best.pop();
+    }
+    return results;
+}
+
+
+vector<const Star*> StarDatabase::brightestStars(const Vector3f& position,
+                                                 unsigned int k) const
+{
+    vector<const Star*> results;
+    if (k == 0 || octreeRoot == nullptr)
+        return results;
+
+    priority_queue<StarCandidate> best;
+    brightestStarsNode(octreeRoot, STAR_OCTREE_ROOT_SIZE, position, k, best);
+
+    results.resize(best.size());
+    for (size_t i = best.size(); i-- > 0;)
+    {
+        results[i] = best.top().second;
+        best.pop();
+    }
+    return results;
+}
+
+
+vector<const Star*> StarDatabase::brightestAbsoluteStars(unsigned int k) const
+{
+    vector<const Star*> results;
+    if (k == 0 || octreeRoot == nullptr)
+        return results;
+
+    priority_queue<StarCandidate> best;
+    brightestAbsoluteNode(octreeRoot, k, best);
+
+    results.resize(best.size());
+    for (size_t i = best.size(); i-- > 0;)
+    {
+        results[i] = best.top().second;
+        best.pop();
+    }
+    return results;
+}
+
+
 StarNameDatabase* StarDatabase::getNameDatabase() const
 {
     return namesDB;
@@ -605,6 +1004,7 @@ bool StarDatabase::loadCrossIndex(const Catalog catalog, istream& in)
     sort(xindex->begin(), xindex->end());
 
     crossIndexes[catalog] = xindex;
+    crossIndexLookups[catalog].build(*xindex);
 
     return true;
 }
@@ -612,6 +1012,7 @@ bool StarDatabase::loadCrossIndex(const Catalog catalog, istream& in)
 
 bool StarDatabase::loadBinary(istream& in)
 {
+    CELZONE("stardb/loadBinary");
     uint32_t nStarsInFile = 0;
 
     // Verify that the star database file has a correct header
@@ -631,7 +1032,7 @@ bool StarDatabase::loadBinary(istream& in)
         uint16_t version;
         in.read((char*) &version, sizeof version);
         LE_TO_CPU_INT16(version, version);
-        if (version != 0x0100)
+        if (version != StarDBVersion)
             return false;
     }
 
@@ -701,10 +1102,12 @@ bool StarDatabase::loadBinary(istream& in)
     {
         binFileStarCount = unsortedStars.size();
         binFileCatalogNumberIndex = new Star*[binFileStarCount];
-        for (unsigned int i = 0; i < binFileStarCount; i++)
+        unsigned int nextIndex = 0;
+        unsortedStars.forEachBlock([&](Star* block, unsigned int count)
         {
-            binFileCatalogNumberIndex[i] = &unsortedStars[i];
-        }
+            for (unsigned int i = 0; i < count; i++)
+                binFileCatalogNumberIndex[nextIndex++] = block + i;
+        });
         sort(binFileCatalogNumberIndex, binFileCatalogNumberIndex + binFileStarCount,
              PtrCatalogNumberOrderingPredicate());
     }
@@ -713,11 +1116,565 @@ bool StarDatabase::loadBinary(istream& in)
 }
 
 
+// Decode an unsigned LEB128 varint, advancing p. Returns false if the
+// value runs past end or exceeds 32 bits.
+static bool readVarint(const char*& p, const char* end, uint32_t& value)
+{
+    value = 0;
+    unsigned int shift = 0;
+    while (p < end && shift < 35)
+    {
+        uint8_t byte = (uint8_t) *p++;
+        value |= (uint32_t) (byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+        shift += 7;
+    }
+    return false;
+}
+
+
+// Decode the records of one compact format group into out. The
+// details cache persists across groups on one caller; the global star
+// details tables in star.cpp are only touched under detailsMutex on a
+// cache miss.
+bool StarDatabase::decodeGroupStars(const DeferredGroup& group,
+                                    std::vector<Star>& out,
+                                    std::unordered_map<uint16_t, StarDetails*>& detailsCache,
+                                    std::mutex& detailsMutex) const
+{
+    auto truncated = [&]() {
+        fmt::fprintf(cerr, _("Star database is truncated: %s\n"), compactPath.string());
+        return false;
+    };
+
+    Eigen::Vector3f corner = group.center - Eigen::Vector3f::Constant(group.halfSize);
+    float step = group.halfSize * 2.0f / 65535.0f;
+
+    const char* record = group.records;
+    uint32_t catNo = 0;
+    for (uint32_t n = 0; n < group.starCount; n++)
+    {
+        uint32_t delta;
+        if (!readVarint(record, group.recordsEnd, delta))
+            return truncated();
+        catNo += delta;
+
+        // Quantized position, packed magnitude, palette index
+        const size_t fixedPart = 3 * sizeof(uint16_t) + sizeof(int16_t) + 1;
+        if ((size_t) (group.recordsEnd - record) < fixedPart)
+            return truncated();
+
+        uint16_t qx, qy, qz;
+        int16_t packedMag;
+        memcpy(&qx, record, sizeof qx);
+        memcpy(&qy, record + 2, sizeof qy);
+        memcpy(&qz, record + 4, sizeof qz);
+        memcpy(&packedMag, record + 6, sizeof packedMag);
+        uint8_t paletteIndex = (uint8_t) record[8];
+        record += fixedPart;
+        LE_TO_CPU_INT16(qx, qx);
+        LE_TO_CPU_INT16(qy, qy);
+        LE_TO_CPU_INT16(qz, qz);
+        LE_TO_CPU_INT16(packedMag, packedMag);
+
+        if (paletteIndex >= group.paletteSize)
+            return false;
+        uint16_t spectralType;
+        memcpy(&spectralType, group.palette + (size_t) paletteIndex * 2, sizeof spectralType);
+        LE_TO_CPU_INT16(spectralType, spectralType);
+
+        StarDetails* details = nullptr;
+        auto cached = detailsCache.find(spectralType);
+        if (cached != detailsCache.end())
+        {
+            details = cached->second;
+        }
+        else
+        {
+            StellarClass sc;
+            if (sc.unpack(spectralType))
+            {
+                std::lock_guard<std::mutex> lock(detailsMutex);
+                details = StarDetails::GetStarDetails(sc);
+            }
+            detailsCache[spectralType] = details;
+        }
+
+        if (details == nullptr)
+        {
+            fmt::fprintf(cerr, _("Bad spectral type in star database, star #%u\n"),
+                         catNo);
+            return false;
+        }
+
+        Star star;
+        star.setPosition(corner.x() + (float) qx * step,
+                         corner.y() + (float) qy * step,
+                         corner.z() + (float) qz * step);
+        star.setAbsoluteMagnitude((float) packedMag / 256.0f);
+        star.setDetails(details);
+        star.setCatalogNumber(catNo);
+        out.push_back(star);
+    }
+
+    return true;
+}
+
+
+// Decode a compact format catalog (versions 0x0300 and 0x0301). A
+// first pass locates the group blocks from their byte lengths; the
+// groups are independent -- catalog number deltas reset at each group
+// -- so the records then decode on parallel workers like the
+// fixed-size formats. With the tiered version, groups whose brightest
+// member is fainter than DeepTierMagLimit are only scanned here; their
+// records decode on demand in processDeferredGroups.
+bool StarDatabase::loadCompact(const char* p, const char* end,
+                               uint32_t nStarsInFile, const fs::path& path,
+                               uint16_t version)
+{
+    CELZONE("stardb/loadCompact");
+    auto truncated = [&]() {
+        fmt::fprintf(cerr, _("Star database is truncated: %s\n"), path.string());
+        return false;
+    };
+
+    compactPath = path;
+    bool tiered = version == StarDBTieredVersion;
+
+    uint32_t groupCount;
+    if ((size_t) (end - p) < sizeof groupCount)
+        return truncated();
+    memcpy(&groupCount, p, sizeof groupCount);
+    LE_TO_CPU_INT32(groupCount, groupCount);
+    p += sizeof groupCount;
+
+    std::vector<DeferredGroup> groups;
+    groups.reserve(groupCount);
+    uint64_t totalStars = 0;
+    for (uint32_t g = 0; g < groupCount; g++)
+    {
+        // Group header: cube center, cube half size, brightest member
+        // magnitude (tiered version only), record block byte length,
+        // star count, palette size.
+        size_t headerSize = 4 * sizeof(float) + sizeof(uint32_t) + 2 * sizeof(uint16_t);
+        if (tiered)
+            headerSize += sizeof(int16_t);
+        if ((size_t) (end - p) < headerSize)
+            return truncated();
+
+        float cx, cy, cz, halfSize;
+        int16_t packedBrightest = 0;
+        uint32_t recordBytes;
+        uint16_t starCount, paletteSize;
+        const char* h = p;
+        memcpy(&cx, h, sizeof cx);
+        memcpy(&cy, h + 4, sizeof cy);
+        memcpy(&cz, h + 8, sizeof cz);
+        memcpy(&halfSize, h + 12, sizeof halfSize);
+        h += 4 * sizeof(float);
+        if (tiered)
+        {
+            memcpy(&packedBrightest, h, sizeof packedBrightest);
+            h += sizeof packedBrightest;
+        }
+        memcpy(&recordBytes, h, sizeof recordBytes);
+        memcpy(&starCount, h + 4, sizeof starCount);
+        memcpy(&paletteSize, h + 6, sizeof paletteSize);
+        LE_TO_CPU_FLOAT(cx, cx);
+        LE_TO_CPU_FLOAT(cy, cy);
+        LE_TO_CPU_FLOAT(cz, cz);
+        LE_TO_CPU_FLOAT(halfSize, halfSize);
+        LE_TO_CPU_INT16(packedBrightest, packedBrightest);
+        LE_TO_CPU_INT32(recordBytes, recordBytes);
+        LE_TO_CPU_INT16(starCount, starCount);
+        LE_TO_CPU_INT16(paletteSize, paletteSize);
+        p += headerSize;
+
+        if (starCount > CompactGroupMaxStars || paletteSize > starCount)
+            return false;
+        if ((size_t) (end - p) < (size_t) paletteSize * sizeof(uint16_t) + recordBytes)
+            return truncated();
+
+        DeferredGroup group;
+        group.center = Eigen::Vector3f(cx, cy, cz);
+        group.halfSize = halfSize;
+        group.brightestMag = tiered ? (float) packedBrightest / 256.0f : 0.0f;
+        group.palette = p;
+        p += (size_t) paletteSize * sizeof(uint16_t);
+        group.records = p;
+        group.recordsEnd = p + recordBytes;
+        p += recordBytes;
+        group.paletteSize = paletteSize;
+        group.starCount = starCount;
+        totalStars += starCount;
+        groups.push_back(std::move(group));
+    }
+    if (totalStars != nStarsInFile)
+        return truncated();
+
+    // Partition into the resident tier, decoded now, and the deep
+    // tier, whose groups wait for an observer that can see them.
+    std::vector<size_t> resident;
+    resident.reserve(groups.size());
+    uint64_t deferredStars = 0;
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        if (groups[g].brightestMag <= DeepTierMagLimit)
+        {
+            resident.push_back(g);
+        }
+        else
+        {
+            deferredStars += groups[g].starCount;
+            deferredGroups.push_back(std::move(groups[g]));
+        }
+    }
+
+    std::mutex detailsMutex;
+    auto decodeGroups = [&](size_t firstGroup, size_t groupCountInChunk,
+                            std::vector<Star>& out) -> bool
+    {
+        std::unordered_map<uint16_t, StarDetails*> detailsCache;
+        for (size_t g = firstGroup; g < firstGroup + groupCountInChunk; g++)
+        {
+            if (!decodeGroupStars(groups[resident[g]], out, detailsCache, detailsMutex))
+                return false;
+        }
+        return true;
+    };
+
+    unsigned int nWorkers = std::thread::hardware_concurrency();
+    if (nWorkers < 1)
+        nWorkers = 1;
+    const size_t minGroupsPerWorker = 256;
+    if (resident.size() / minGroupsPerWorker < nWorkers)
+        nWorkers = (unsigned int) std::max((size_t) 1, resident.size() / minGroupsPerWorker);
+
+    std::vector<std::vector<Star>> chunks(nWorkers);
+    if (nWorkers > 1)
+    {
+        size_t chunkSize = resident.size() / nWorkers;
+        std::vector<std::future<bool>> tasks;
+        for (unsigned int w = 0; w < nWorkers; ++w)
+        {
+            size_t first = w * chunkSize;
+            size_t count = w + 1 == nWorkers ? resident.size() - first : chunkSize;
+            tasks.push_back(std::async(std::launch::async, decodeGroups,
+                                       first, count, std::ref(chunks[w])));
+        }
+
+        bool ok = true;
+        for (auto& task : tasks)
+            ok = task.get() && ok;
+        if (!ok)
+            return false;
+    }
+    else
+    {
+        if (!decodeGroups(0, resident.size(), chunks[0]))
+            return false;
+    }
+
+    commitBinaryStars(chunks, nStarsInFile);
+
+    if (!deferredGroups.empty())
+    {
+        fmt::fprintf(clog, _("Deferred %llu faint stars in %u deep tier groups\n"),
+                     (unsigned long long) deferredStars,
+                     (unsigned int) deferredGroups.size());
+    }
+
+    return true;
+}
+
+
+// Decode a star catalog directly from a memory mapped file. The stream
+// format (version 0x0100), the packed record format (version 0x0200),
+// and the compact formats (versions 0x0300 and 0x0301) are all
+// accepted; in each case the per-record istream overhead of
+// loadBinary(istream&) is avoided entirely and cold-cache loads are
+// limited by page fault throughput rather than stdio.
+bool StarDatabase::loadBinary(const fs::path& path)
+{
+    std::unique_ptr<MemoryMappedFile> catalog(new MemoryMappedFile(path));
+    if (!catalog->isValid())
+    {
+        // Mapping can fail for special files (e.g. data piped in during
+        // testing); fall back to the portable stream loader.
+        ifstream in(path.string(), ios::in | ios::binary);
+        return in.good() && loadBinary(in);
+    }
+
+    const char* p = catalog->data();
+    const char* end = p + catalog->size();
+
+    // Accept a gzip compressed catalog transparently; the records are
+    // then decoded from the inflated buffer instead of the mapping.
+    // The buffer is a member so deferred compact groups can keep
+    // decoding from it after loading.
+    compactBuffer.clear();
+    if (IsGzipData(p, catalog->size()))
+    {
+        if (!DecompressGzipData(p, catalog->size(), compactBuffer))
+        {
+            fmt::fprintf(cerr, _("Error decompressing star database %s\n"), path.string());
+            return false;
+        }
+        p = compactBuffer.data();
+        end = p + compactBuffer.size();
+    }
+
+    size_t headerLength = strlen(FILE_HEADER);
+    if ((size_t) (end - p) < headerLength + sizeof(uint16_t) + sizeof(uint32_t) ||
+        strncmp(p, FILE_HEADER, headerLength) != 0)
+    {
+        return false;
+    }
+    p += headerLength;
+
+    uint16_t version;
+    memcpy(&version, p, sizeof version);
+    LE_TO_CPU_INT16(version, version);
+    p += sizeof version;
+    if (version != StarDBVersion && version != StarDBPackedVersion &&
+        version != StarDBCompactVersion && version != StarDBTieredVersion)
+        return false;
+
+    uint32_t nStarsInFile;
+    memcpy(&nStarsInFile, p, sizeof nStarsInFile);
+    LE_TO_CPU_INT32(nStarsInFile, nStarsInFile);
+    p += sizeof nStarsInFile;
+
+    if (version == StarDBCompactVersion || version == StarDBTieredVersion)
+    {
+        if (!loadCompact(p, end, nStarsInFile, path, version))
+            return false;
+
+        // Deferred groups decode out of the backing bytes on demand,
+        // so the mapping (or the inflated buffer) must stay alive;
+        // without any, neither is needed once loading is done.
+        if (deferredGroups.empty())
+        {
+            compactBuffer.clear();
+            compactBuffer.shrink_to_fit();
+        }
+        else if (compactBuffer.empty())
+        {
+            compactMapping = catalog.release();
+        }
+        return true;
+    }
+
+    // Stream records are 20 bytes; packed records carry the absolute
+    // magnitude as a float and are padded to 24 bytes.
+    size_t recordSize = version == StarDBVersion ? 20 : 24;
+    if ((size_t) (end - p) < (size_t) nStarsInFile * recordSize)
+    {
+        fmt::fprintf(cerr, _("Star database is truncated: %s\n"), path.string());
+        return false;
+    }
+
+    // Decode the records in parallel chunks: byte swapping, stellar
+    // class unpacking, and details resolution dominate decode time and
+    // are independent per record. Each worker resolves star details
+    // through a chunk-local cache; the global tables in star.cpp are
+    // only touched under a mutex on a cache miss, which happens once
+    // per distinct spectral type per chunk.
+    std::mutex detailsMutex;
+    auto decodeChunk = [&](uint32_t firstRecord, uint32_t count,
+                           std::vector<Star>& out) -> bool
+    {
+        std::unordered_map<uint16_t, StarDetails*> detailsCache;
+        const char* record = p + (size_t) firstRecord * recordSize;
+        out.reserve(count);
+
+        for (uint32_t n = 0; n < count; ++n, record += recordSize)
+        {
+            uint32_t catNo;
+            float x, y, z;
+            float absMag;
+            uint16_t spectralType;
+
+            if (version == StarDBVersion)
+            {
+                int16_t packedMag;
+                memcpy(&catNo, record, sizeof catNo);
+                memcpy(&x, record + 4,  sizeof x);
+                memcpy(&y, record + 8,  sizeof y);
+                memcpy(&z, record + 12, sizeof z);
+                memcpy(&packedMag, record + 16, sizeof packedMag);
+                memcpy(&spectralType, record + 18, sizeof spectralType);
+                LE_TO_CPU_INT32(catNo, catNo);
+                LE_TO_CPU_FLOAT(x, x);
+                LE_TO_CPU_FLOAT(y, y);
+                LE_TO_CPU_FLOAT(z, z);
+                LE_TO_CPU_INT16(packedMag, packedMag);
+                LE_TO_CPU_INT16(spectralType, spectralType);
+                absMag = (float) packedMag / 256.0f;
+            }
+            else
+            {
+                memcpy(&x, record,      sizeof x);
+                memcpy(&y, record + 4,  sizeof y);
+                memcpy(&z, record + 8,  sizeof z);
+                memcpy(&absMag, record + 12, sizeof absMag);
+                memcpy(&catNo, record + 16, sizeof catNo);
+                memcpy(&spectralType, record + 20, sizeof spectralType);
+                LE_TO_CPU_FLOAT(x, x);
+                LE_TO_CPU_FLOAT(y, y);
+                LE_TO_CPU_FLOAT(z, z);
+                LE_TO_CPU_FLOAT(absMag, absMag);
+                LE_TO_CPU_INT32(catNo, catNo);
+                LE_TO_CPU_INT16(spectralType, spectralType);
+            }
+
+            StarDetails* details = nullptr;
+            auto cached = detailsCache.find(spectralType);
+            if (cached != detailsCache.end())
+            {
+                details = cached->second;
+            }
+            else
+            {
+                StellarClass sc;
+                if (sc.unpack(spectralType))
+                {
+                    std::lock_guard<std::mutex> lock(detailsMutex);
+                    details = StarDetails::GetStarDetails(sc);
+                }
+                detailsCache[spectralType] = details;
+            }
+
+            if (details == nullptr)
+            {
+                fmt::fprintf(cerr, _("Bad spectral type in star database, star #%u\n"),
+                             firstRecord + n);
+                return false;
+            }
+
+            Star star;
+            star.setPosition(x, y, z);
+            star.setAbsoluteMagnitude(absMag);
+            star.setDetails(details);
+            star.setCatalogNumber(catNo);
+            out.push_back(star);
+        }
+
+        return true;
+    };
+
+    unsigned int nWorkers = std::thread::hardware_concurrency();
+    if (nWorkers < 1)
+        nWorkers = 1;
+    const uint32_t minRecordsPerWorker = 65536;
+    if (nStarsInFile / minRecordsPerWorker < nWorkers)
+        nWorkers = std::max(1u, nStarsInFile / minRecordsPerWorker);
+
+    std::vector<std::vector<Star>> chunks(nWorkers);
+    if (nWorkers > 1)
+    {
+        uint32_t chunkSize = nStarsInFile / nWorkers;
+        std::vector<std::future<bool>> tasks;
+        for (unsigned int w = 0; w < nWorkers; ++w)
+        {
+            uint32_t first = w * chunkSize;
+            uint32_t count = w + 1 == nWorkers ? nStarsInFile - first : chunkSize;
+            tasks.push_back(std::async(std::launch::async, decodeChunk,
+                                       first, count, std::ref(chunks[w])));
+        }
+
+        bool ok = true;
+        for (auto& task : tasks)
+            ok = task.get() && ok;
+        if (!ok)
+            return false;
+    }
+    else
+    {
+        if (!decodeChunk(0, nStarsInFile, chunks[0]))
+            return false;
+    }
+
+    commitBinaryStars(chunks, nStarsInFile);
+
+    compactBuffer.clear();
+    compactBuffer.shrink_to_fit();
+
+    return true;
+}
+
+
+// Append decoded star chunks to the database and rebuild the binary
+// file catalog number index; shared by the binary format decoders.
+void StarDatabase::commitBinaryStars(const std::vector<std::vector<Star>>& chunks,
+                                     uint32_t nStarsInFile)
+{
+    for (const auto& chunk : chunks)
+    {
+        for (const auto& star : chunk)
+        {
+            Star copy = star;
+            unsortedStars.add(copy);
+            nStars++;
+        }
+    }
+
+    DPRINTF(LOG_LEVEL_ERROR, "StarDatabase::read: nStars = %d\n", nStarsInFile);
+    fmt::fprintf(clog, _("%d stars in binary database\n"), nStars);
+
+    if (unsortedStars.size() > 0)
+    {
+        binFileStarCount = unsortedStars.size();
+        binFileCatalogNumberIndex = new Star*[binFileStarCount];
+        unsigned int nextIndex = 0;
+        unsortedStars.forEachBlock([&](Star* block, unsigned int count)
+        {
+            for (unsigned int i = 0; i < count; i++)
+                binFileCatalogNumberIndex[nextIndex++] = block + i;
+        });
+        sort(binFileCatalogNumberIndex, binFileCatalogNumberIndex + binFileStarCount,
+             PtrCatalogNumberOrderingPredicate());
+    }
+}
+
+
+void StarDatabase::setOctreeCacheFile(const fs::path& path)
+{
+    octreeCacheFile = path;
+}
+
+
 void StarDatabase::finish()
 {
     fmt::fprintf(clog, _("Total star count: %d\n"), nStars);
 
-    buildOctree();
+    bool octreeRestored = false;
+    uint64_t catalogHash = 0;
+    std::vector<uint32_t> loadOrderCatalogNumbers;
+    if (!octreeCacheFile.empty())
+    {
+        catalogHash = computeCatalogHash();
+        octreeRestored = loadCachedOctree(catalogHash);
+        if (!octreeRestored)
+        {
+            // Remember the load order so the sort permutation can be
+            // recovered once the octree build has scattered the stars.
+            loadOrderCatalogNumbers.reserve(unsortedStars.size());
+            unsortedStars.forEachBlock([&](const Star* block, unsigned int count)
+            {
+                for (unsigned int i = 0; i < count; i++)
+                    loadOrderCatalogNumbers.push_back(block[i].getCatalogNumber());
+            });
+        }
+    }
+
+    if (!octreeRestored)
+    {
+        buildOctree();
+        if (!octreeCacheFile.empty())
+            saveCachedOctree(catalogHash, loadOrderCatalogNumbers);
+    }
     buildIndexes();
 
     // Delete the temporary indices used only during loading
@@ -1156,8 +2113,18 @@ bool StarDatabase::createStar(Star* star,
  */
 bool StarDatabase::load(istream& in, const fs::path& resourcePath)
 {
+    CELZONE("stardb/loadText");
     Tokenizer tokenizer(&in);
-    Parser parser(&tokenizer);
+    return load(tokenizer, resourcePath);
+}
+
+
+bool StarDatabase::load(Tokenizer& tokenizer, const fs::path& resourcePath)
+{
+    // Star definitions are applied and discarded one at a time, so their
+    // Value trees can come from a per-file arena freed wholesale.
+    MemoryPool valuePool(16, 65536);
+    Parser parser(&tokenizer, &valuePool);
 
     const char *d = resourcePath.string().c_str();
     bindtextdomain(d, d); // domain name is the same as resource path
@@ -1324,7 +2291,7 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
                 delete star;
 
                 // Add the new star to the temporary (load time) index.
-                stcFileCatalogNumberIndex[catalogNumber] = &unsortedStars[unsortedStars.size() - 1];
+                stcFileCatalogNumberIndex.insert(catalogNumber, &unsortedStars[unsortedStars.size() - 1]);
             }
 
             if (namesDB != nullptr && !objName.empty())
@@ -1368,6 +2335,7 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
 
 void StarDatabase::buildOctree()
 {
+    CELZONE("stardb/buildOctree");
     // This should only be called once for the database
     // ASSERT(octreeRoot == nullptr);
 
@@ -1376,10 +2344,11 @@ void StarDatabase::buildOctree()
                                       STAR_OCTREE_ROOT_SIZE * (float) sqrt(3.0));
     DynamicStarOctree* root = new DynamicStarOctree(Vector3f(1000.0f, 1000.0f, 1000.0f),
                                                     absMag);
-    for (unsigned int i = 0; i < unsortedStars.size(); ++i)
+    unsortedStars.forEachBlock([&](Star* block, unsigned int count)
     {
-        root->insertObject(unsortedStars[i], STAR_OCTREE_ROOT_SIZE);
-    }
+        for (unsigned int i = 0; i < count; i++)
+            root->insertObject(block[i], STAR_OCTREE_ROOT_SIZE);
+    });
 
     DPRINTF(LOG_LEVEL_INFO, "Spatially sorting stars for improved locality of reference . . .\n");
     Star* sortedStars    = new Star[nStars];
@@ -1402,7 +2371,7 @@ void StarDatabase::buildOctree()
                      level,
                      STAR_OCTREE_ROOT_SIZE / pow(2.0, (double) level),
                      stat.nodeCount,
-                     stat.objectCount;
+                     stat.objectCount);
     }
 #endif
 
@@ -1417,6 +2386,7 @@ void StarDatabase::buildOctree()
 
 void StarDatabase::buildIndexes()
 {
+    CELZONE("stardb/buildIndexes");
     // This should only be called once for the database
     // assert(catalogNumberIndexes[0] == nullptr);
 
@@ -1430,6 +2400,251 @@ void StarDatabase::buildIndexes()
 }
 
 
+// The octree structure and spatial sort are fully determined by the
+// catalog numbers, positions, and magnitudes of the loaded stars, so
+// those are what the cache key covers. Star details travel with the
+// in-memory stars when the cached permutation is applied, so non-spatial
+// modifications (textures, orbits, ...) never invalidate the cache.
+uint64_t StarDatabase::computeCatalogHash() const
+{
+    uint64_t hash = 14695981039346656037ULL;    // FNV-1a offset basis
+
+    auto mix = [&hash](const void* data, size_t length)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;           // FNV-1a prime
+        }
+    };
+
+    unsortedStars.forEachBlock([&](const Star* block, unsigned int count)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const Star& star = block[i];
+            uint32_t catNo = star.getCatalogNumber();
+            Vector3f position = star.getPosition();
+            float absMag = star.getAbsoluteMagnitude();
+            mix(&catNo, sizeof catNo);
+            mix(position.data(), sizeof(float) * 3);
+            mix(&absMag, sizeof absMag);
+        }
+    });
+
+    return hash;
+}
+
+
+// Flat octree node record. Children of the n-th internal node (in array
+// order) always occupy the next unclaimed block of eight entries, which
+// makes the layout trivial to validate on load.
+struct OctreeCacheNode
+{
+    float center[3];
+    float exclusionFactor;
+    uint32_t firstObject;
+    uint32_t nObjects;
+    uint32_t firstChild;        // == OctreeCacheLeaf for leaf nodes
+};
+
+constexpr const uint32_t OctreeCacheLeaf = 0xffffffffu;
+
+
+bool StarDatabase::loadCachedOctree(uint64_t catalogHash)
+{
+    MemoryMappedFile cache(octreeCacheFile);
+    if (!cache.isValid())
+        return false;
+
+    const char* p = cache.data();
+    size_t headerLength = strlen(OCTREE_CACHE_HEADER);
+    size_t fixedLength = headerLength + sizeof(uint16_t) + sizeof(uint32_t)
+                       + sizeof(uint64_t) + 2 * sizeof(uint32_t);
+    if (cache.size() < fixedLength ||
+        strncmp(p, OCTREE_CACHE_HEADER, headerLength) != 0)
+    {
+        return false;
+    }
+    p += headerLength;
+
+    uint16_t version;
+    memcpy(&version, p, sizeof version);
+    p += sizeof version;
+    uint32_t byteOrderTag;
+    memcpy(&byteOrderTag, p, sizeof byteOrderTag);
+    p += sizeof byteOrderTag;
+    uint64_t hash;
+    memcpy(&hash, p, sizeof hash);
+    p += sizeof hash;
+    uint32_t starCount, nodeCount;
+    memcpy(&starCount, p, sizeof starCount);
+    p += sizeof starCount;
+    memcpy(&nodeCount, p, sizeof nodeCount);
+    p += sizeof nodeCount;
+
+    if (version != OctreeCacheVersion ||
+        byteOrderTag != OctreeCacheByteOrderTag ||
+        hash != catalogHash ||
+        starCount != (uint32_t) nStars ||
+        nodeCount == 0)
+    {
+        return false;
+    }
+
+    size_t payload = (size_t) starCount * sizeof(uint32_t)
+                   + (size_t) nodeCount * sizeof(OctreeCacheNode);
+    if (cache.size() - fixedLength < payload)
+        return false;
+
+    const char* permBase = p;
+    const char* nodeBase = p + (size_t) starCount * sizeof(uint32_t);
+
+    // Validate the node records before allocating anything. Internal
+    // nodes must claim consecutive blocks of eight children in order.
+    uint32_t nextChild = 1;
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        OctreeCacheNode node;
+        memcpy(&node, nodeBase + (size_t) i * sizeof node, sizeof node);
+        if (node.firstObject > starCount ||
+            node.nObjects > starCount - node.firstObject)
+        {
+            return false;
+        }
+        if (node.firstChild != OctreeCacheLeaf)
+        {
+            if (node.firstChild != nextChild)
+                return false;
+            nextChild += 8;
+        }
+    }
+    if (nextChild != nodeCount)
+        return false;
+
+    // Apply the spatial sort permutation to the loaded stars.
+    Star* sortedStars = new Star[nStars];
+    for (uint32_t i = 0; i < starCount; ++i)
+    {
+        uint32_t loadIndex;
+        memcpy(&loadIndex, permBase + (size_t) i * sizeof loadIndex, sizeof loadIndex);
+        if (loadIndex >= starCount)
+        {
+            delete[] sortedStars;
+            return false;
+        }
+        sortedStars[i] = unsortedStars[loadIndex];
+    }
+
+    // Reconstruct the octree nodes and link the child blocks.
+    std::vector<StarOctree*> nodes(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        OctreeCacheNode node;
+        memcpy(&node, nodeBase + (size_t) i * sizeof node, sizeof node);
+        nodes[i] = new StarOctree(Vector3f(node.center[0], node.center[1], node.center[2]),
+                                  node.exclusionFactor,
+                                  sortedStars + node.firstObject,
+                                  node.nObjects);
+    }
+    for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+        OctreeCacheNode node;
+        memcpy(&node, nodeBase + (size_t) i * sizeof node, sizeof node);
+        if (node.firstChild != OctreeCacheLeaf)
+        {
+            StarOctree** children = new StarOctree*[8];
+            for (unsigned int j = 0; j < 8; ++j)
+                children[j] = nodes[node.firstChild + j];
+            nodes[i]->setChildren(children);
+        }
+    }
+
+    unsortedStars.clear();
+    stars = sortedStars;
+    octreeRoot = nodes[0];
+
+    DPRINTF(LOG_LEVEL_INFO, "Restored star octree from cache (%u nodes)\n", nodeCount);
+
+    return true;
+}
+
+
+void StarDatabase::saveCachedOctree(uint64_t catalogHash,
+                                    const std::vector<uint32_t>& loadOrderCatalogNumbers) const
+{
+    if (loadOrderCatalogNumbers.size() != (size_t) nStars)
+        return;
+
+    ofstream out(octreeCacheFile.string(), ios::out | ios::binary | ios::trunc);
+    if (!out.good())
+        return;     // cache directory may be read-only; not an error
+
+    std::map<uint32_t, uint32_t> loadIndex;
+    for (uint32_t i = 0; i < (uint32_t) nStars; ++i)
+        loadIndex[loadOrderCatalogNumbers[i]] = i;
+
+    // Flatten the octree breadth first; each internal node claims the
+    // next free block of eight node slots for its children.
+    std::vector<const StarOctree*> nodes;
+    nodes.push_back(octreeRoot);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (nodes[i]->hasChildren())
+        {
+            for (unsigned int j = 0; j < 8; ++j)
+                nodes.push_back(nodes[i]->child(j));
+        }
+    }
+
+    uint16_t version = OctreeCacheVersion;
+    uint32_t byteOrderTag = OctreeCacheByteOrderTag;
+    uint32_t starCount = (uint32_t) nStars;
+    uint32_t nodeCount = (uint32_t) nodes.size();
+    out.write(OCTREE_CACHE_HEADER, strlen(OCTREE_CACHE_HEADER));
+    out.write((const char*) &version, sizeof version);
+    out.write((const char*) &byteOrderTag, sizeof byteOrderTag);
+    out.write((const char*) &catalogHash, sizeof catalogHash);
+    out.write((const char*) &starCount, sizeof starCount);
+    out.write((const char*) &nodeCount, sizeof nodeCount);
+
+    for (uint32_t i = 0; i < starCount; ++i)
+    {
+        auto iter = loadIndex.find(stars[i].getCatalogNumber());
+        if (iter == loadIndex.end())
+            return;     // should not happen; leave a short (invalid) cache
+        out.write((const char*) &iter->second, sizeof(uint32_t));
+    }
+
+    uint32_t nextChild = 1;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const StarOctree* source = nodes[i];
+        OctreeCacheNode node;
+        node.center[0] = source->cellCenter().x();
+        node.center[1] = source->cellCenter().y();
+        node.center[2] = source->cellCenter().z();
+        node.exclusionFactor = source->getExclusionFactor();
+        node.firstObject = (uint32_t) (source->firstObject() - stars);
+        node.nObjects = source->objectCount();
+        if (source->hasChildren())
+        {
+            node.firstChild = nextChild;
+            nextChild += 8;
+        }
+        else
+        {
+            node.firstChild = OctreeCacheLeaf;
+        }
+        out.write((const char*) &node, sizeof node);
+    }
+
+    if (!out.good())
+        DPRINTF(LOG_LEVEL_WARNING, "Failed writing star octree cache\n");
+}
+
+
 /*! While loading the star catalogs, this function must be called instead of
  *  find(). The final catalog number index for stars cannot be built until
  *  after all stars have been loaded. During catalog loading, there are two
@@ -1458,14 +2673,8 @@ Star* StarDatabase::findWhileLoading(uint32_t catalogNumber) const
             return *star;
     }
 
-    // Next check for stars loaded from an stc file
-    map<uint32_t, Star*>::const_iterator iter = stcFileCatalogNumberIndex.find(catalogNumber);
-    if (iter != stcFileCatalogNumberIndex.end())
-    {
-        return iter->second;
-    }
-
-    // Star not found
-    return nullptr;
+    // Next check for stars loaded from an stc file; returns nullptr
+    // when the star hasn't been loaded (yet).
+    return stcFileCatalogNumberIndex.find(catalogNumber);
 }
 
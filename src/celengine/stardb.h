@@ -14,13 +14,25 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <mutex>
+#include <unordered_map>
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 #include <celengine/constellation.h>
 #include <celengine/starname.h>
 #include <celengine/star.h>
+#include <celutil/concurrentindex.h>
+#include <celutil/memaudit.h>
 #include <celengine/staroctree.h>
 #include <celengine/parseobject.h>
 
 
+class Tokenizer;
+class MemoryMappedFile;
+
 static const unsigned int MAX_STAR_NAMES = 10;
 
 // TODO: Move BlockArray to celutil; consider making it a full STL
@@ -33,12 +45,24 @@ static const unsigned int MAX_STAR_NAMES = 10;
  *  - The address of a BlockArray element is guaranteed not to
  *    change over the lifetime of the BlockArray (or until the
  *    BlockArray is cleared.)
+ *
+ *  Blocks default to one huge page worth of elements, and on Linux
+ *  they are allocated huge-page aligned with MADV_HUGEPAGE, so dense
+ *  whole-array passes over very large catalogs touch few page table
+ *  entries.
  */
 template<class T> class BlockArray
 {
 public:
-    BlockArray() :
-        m_blockSize(1000),
+    //! Elements per block needed to fill one huge page
+    static unsigned int defaultBlockSize()
+    {
+        size_t n = HugePageSize / sizeof(T);
+        return n > 0 ? (unsigned int) n : 1u;
+    }
+
+    BlockArray(unsigned int blockSize = 0) :
+        m_blockSize(blockSize != 0 ? blockSize : defaultBlockSize()),
         m_elementCount(0)
     {
     }
@@ -59,8 +83,10 @@ public:
         unsigned int blockIndex = m_elementCount / m_blockSize;
         if (blockIndex == m_blocks.size())
         {
-            T* newBlock = new T[m_blockSize];
+            bool huge = false;
+            T* newBlock = allocateBlock(huge);
             m_blocks.push_back(newBlock);
+            m_blockIsHuge.push_back(huge ? 1 : 0);
         }
 
         unsigned int elementIndex = m_elementCount % m_blockSize;
@@ -71,12 +97,13 @@ public:
 
     void clear()
     {
-        for (typename std::vector<T*>::const_iterator iter = m_blocks.begin(); iter != m_blocks.end(); ++iter)
+        for (unsigned int i = 0; i < m_blocks.size(); ++i)
         {
-            delete[] *iter;
+            freeBlock(m_blocks[i], m_blockIsHuge[i] != 0);
         }
         m_elementCount = 0;
         m_blocks.clear();
+        m_blockIsHuge.clear();
     }
 
     T& operator[](int index)
@@ -93,19 +120,93 @@ public:
         return m_blocks[blockNumber][elementNumber];
     }
 
+    /*! Visit the elements as contiguous spans, one call per block:
+     *  f(pointer to first element, count of valid elements). Whole
+     *  array passes like the octree and index builds iterate this way
+     *  instead of paying the block division on every access.
+     */
+    template<typename F> void forEachBlock(F f)
+    {
+        unsigned int remaining = m_elementCount;
+        for (unsigned int i = 0; i < m_blocks.size() && remaining != 0; ++i)
+        {
+            unsigned int n = remaining < m_blockSize ? remaining : m_blockSize;
+            f(m_blocks[i], n);
+            remaining -= n;
+        }
+    }
+
+    template<typename F> void forEachBlock(F f) const
+    {
+        unsigned int remaining = m_elementCount;
+        for (unsigned int i = 0; i < m_blocks.size() && remaining != 0; ++i)
+        {
+            unsigned int n = remaining < m_blockSize ? remaining : m_blockSize;
+            f(static_cast<const T*>(m_blocks[i]), n);
+            remaining -= n;
+        }
+    }
+
 private:
+    static const size_t HugePageSize = 2 * 1024 * 1024;
+
+    T* allocateBlock(bool& huge)
+    {
+        huge = false;
+#ifdef __linux__
+        size_t bytes = (size_t) m_blockSize * sizeof(T);
+        if (bytes >= HugePageSize)
+        {
+            // Allocate aligned to a huge page boundary and ask the
+            // kernel to back the block with transparent huge pages;
+            // falls through to a plain allocation when that fails.
+            void* mem = nullptr;
+            size_t rounded = (bytes + HugePageSize - 1) & ~(HugePageSize - 1);
+            if (posix_memalign(&mem, HugePageSize, rounded) == 0)
+            {
+                (void) madvise(mem, rounded, MADV_HUGEPAGE);
+                T* block = static_cast<T*>(mem);
+                for (unsigned int i = 0; i < m_blockSize; ++i)
+                    new (block + i) T();
+                huge = true;
+                return block;
+            }
+        }
+#endif
+        return new T[m_blockSize];
+    }
+
+    void freeBlock(T* block, bool huge)
+    {
+#ifdef __linux__
+        if (huge)
+        {
+            for (unsigned int i = 0; i < m_blockSize; ++i)
+                block[i].~T();
+            free(block);
+            return;
+        }
+#endif
+        delete[] block;
+    }
+
     unsigned int m_blockSize;
     unsigned int m_elementCount;
     std::vector<T*> m_blocks;
+    std::vector<char> m_blockIsHuge;
 };
 
 
-class StarDatabase
+class StarDatabase : public MemoryReporter
 {
  public:
     StarDatabase();
     ~StarDatabase();
 
+    //! MemoryReporter: account for the star array, indexes, octree
+    //! and name database.
+    void reportMemory(MemoryLedger&) const override;
+
 
     inline Star*  getStar(const uint32_t) const;
     inline uint32_t size() const;
@@ -116,18 +217,48 @@ class StarDatabase
 
     std::vector<std::string> getCompletion(const std::string&) const;
 
+    //! When includeDeferred is set, the deep tier groups of a tiered
+    //! compact catalog are decoded on demand and their stars handed to
+    //! the handler as well. Only the render path should pass true:
+    //! deep tier stars are recycled by eviction, so pointers to them
+    //! must not be kept in selections or other long-lived references.
     void findVisibleStars(StarHandler& starHandler,
                           const Eigen::Vector3f& obsPosition,
                           const Eigen::Quaternionf&   obsOrientation,
                           float fovY,
                           float aspectRatio,
                           float limitingMag,
-                          OctreeProcStats * = nullptr) const;
+                          OctreeProcStats * = nullptr,
+                          bool includeDeferred = false) const;
 
     void findCloseStars(StarHandler& starHandler,
                         const Eigen::Vector3f& obsPosition,
                         float radius) const;
 
+    //! The spatial index over the catalog; exposed for the octree
+    //! diagnostics overlay, which reports per-level statistics.
+    StarOctree* getOctreeRoot() const { return octreeRoot; }
+
+    //! Find the k stars nearest to the given position (in light
+    //! years), ordered nearest first. The search walks the octree and
+    //! skips any subtree that cannot improve on the candidates found
+    //! so far, so it touches only a small fraction of the catalog.
+    std::vector<const Star*> nearestStars(const Eigen::Vector3f& position,
+                                          unsigned int k) const;
+
+    //! Find the k stars of greatest apparent brightness as seen from
+    //! the given position, ordered brightest first. Subtrees are
+    //! pruned with the per-node exclusion magnitude maintained by the
+    //! octree build: a node too far away and too intrinsically faint
+    //! to beat the current candidates is never descended into.
+    std::vector<const Star*> brightestStars(const Eigen::Vector3f& position,
+                                            unsigned int k) const;
+
+    //! Find the k intrinsically brightest stars (smallest absolute
+    //! magnitude), brightest first. Position-independent; subtrees
+    //! are pruned directly on the exclusion magnitude.
+    std::vector<const Star*> brightestAbsoluteStars(unsigned int k) const;
+
     std::string getStarName    (const Star&, bool i18n = false) const;
     void getStarName(const Star& star, char* nameBuffer, unsigned int bufferSize, bool i18n = false) const;
     std::string getStarNameList(const Star&, const unsigned int maxNames = MAX_STAR_NAMES) const;
@@ -136,7 +267,9 @@ class StarDatabase
     void setNameDatabase(StarNameDatabase*);
 
     bool load(std::istream&, const fs::path& resourcePath = fs::path());
+    bool load(Tokenizer& tokenizer, const fs::path& resourcePath = fs::path());
     bool loadBinary(std::istream&);
+    bool loadBinary(const fs::path&);
 
     enum Catalog
     {
@@ -160,6 +293,23 @@ class StarDatabase
 
     typedef std::vector<CrossIndexEntry> CrossIndex;
 
+    //! Two-level direct index from a foreign catalog number to the
+    //! Celestia number. Pages are only allocated for populated ranges,
+    //! so dense catalogs (HD, SAO) resolve with two array accesses
+    //! instead of a binary search.
+    struct CrossIndexLookup
+    {
+        static const unsigned int PageBits = 10;
+        static const uint32_t PageSize = 1u << PageBits;
+
+        std::vector<std::vector<uint32_t>> pages;
+
+        void build(const CrossIndex& xindex);
+        uint32_t lookup(uint32_t number) const;
+    };
+
+    //! Load a cross index; distinct catalogs may be loaded concurrently
+    //! since each load writes only its own preallocated slot.
     bool   loadCrossIndex  (const Catalog, std::istream&);
     uint32_t searchCrossIndexForCatalogNumber(const Catalog, const uint32_t number) const;
     Star*  searchCrossIndex(const Catalog, const uint32_t number) const;
@@ -167,6 +317,12 @@ class StarDatabase
 
     void finish();
 
+    // When set, finish() will try to restore the spatial sort and octree
+    // structure from this file instead of rebuilding them, and will
+    // refresh the file after a rebuild. The cache is keyed by a hash of
+    // the loaded catalogs and ignored on mismatch.
+    void setOctreeCacheFile(const fs::path&);
+
     static StarDatabase* read(std::istream&);
 
 private:
@@ -177,10 +333,48 @@ private:
                     const fs::path& path,
                     const bool isBarycenter);
 
+    //! One leaf group of a compact catalog whose brightest member is
+    //! too faint for the resident tier. The encoded records stay in
+    //! the backing store (mapping or inflated buffer); stars is filled
+    //! when an observer comes close enough for the group to be visible
+    //! and emptied again by eviction.
+    struct DeferredGroup
+    {
+        Eigen::Vector3f center;
+        float halfSize;
+        float brightestMag;      // absolute magnitude of brightest member
+        const char* palette;
+        const char* records;
+        const char* recordsEnd;
+        uint16_t paletteSize;
+        uint16_t starCount;
+        std::vector<Star> stars;
+        uint32_t lastUsed{ 0 };
+    };
+
+    bool loadCompact(const char* p, const char* end,
+                     uint32_t nStarsInFile, const fs::path& path,
+                     uint16_t version);
+    bool decodeGroupStars(const DeferredGroup& group,
+                          std::vector<Star>& out,
+                          std::unordered_map<uint16_t, StarDetails*>& detailsCache,
+                          std::mutex& detailsMutex) const;
+    void processDeferredGroups(StarHandler& starHandler,
+                               const Eigen::Vector3f& position,
+                               const Eigen::Hyperplane<float, 3>* frustumPlanes,
+                               float limitingMag) const;
+    void commitBinaryStars(const std::vector<std::vector<Star>>& chunks,
+                           uint32_t nStarsInFile);
+
     void buildOctree();
     void buildIndexes();
     Star* findWhileLoading(uint32_t catalogNumber) const;
 
+    uint64_t computeCatalogHash() const;
+    bool loadCachedOctree(uint64_t catalogHash);
+    void saveCachedOctree(uint64_t catalogHash,
+                          const std::vector<uint32_t>& loadOrderCatalogNumbers) const;
+
     int nStars{ 0 };
 
     Star*             stars{ nullptr };
@@ -190,6 +384,7 @@ private:
     uint32_t            nextAutoCatalogNumber{ 0xfffffffe };
 
     std::vector<CrossIndex*> crossIndexes;
+    std::vector<CrossIndexLookup> crossIndexLookups;
 
     // These values are used by the star database loader; they are
     // not used after loading is complete.
@@ -197,8 +392,9 @@ private:
     // List of stars loaded from binary file, sorted by catalog number
     Star** binFileCatalogNumberIndex{ nullptr };
     unsigned int binFileStarCount{ 0 };
-    // Catalog number -> star mapping for stars loaded from stc files
-    std::map<uint32_t, Star*> stcFileCatalogNumberIndex;
+    // Catalog number -> star mapping for stars loaded from stc files.
+    // Safe for concurrent lookups while the loader thread inserts.
+    ConcurrentCatalogIndex<Star> stcFileCatalogNumberIndex;
 
     struct BarycenterUsage
     {
@@ -206,6 +402,21 @@ private:
         uint32_t barycenterCatNo;
     };
     std::vector<BarycenterUsage> barycenters;
+
+    fs::path octreeCacheFile;
+
+    // Deep tier state for the tiered compact format. The visibility
+    // queries are const, so groups decode and evict behind a mutex.
+    mutable std::vector<DeferredGroup> deferredGroups;
+    mutable std::mutex deferredGroupMutex;
+    mutable std::mutex deferredDetailsMutex;
+    mutable uint32_t deferredClock{ 0 };
+    mutable unsigned int decodedDeferredGroups{ 0 };
+    // Backing bytes the deferred group records point into: the catalog
+    // mapping, or the inflated buffer when the catalog was compressed.
+    MemoryMappedFile* compactMapping{ nullptr };
+    std::string compactBuffer;
+    fs::path compactPath;
 };
 
 
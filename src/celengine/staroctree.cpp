@@ -11,6 +11,12 @@
 // of the License, or (at your option) any later version.
 
 #include <celengine/staroctree.h>
+#include <celmath/frustum.h>
+
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(_M_X64)
+#define STAROCTREE_USE_SSE2 1
+#include <emmintrin.h>
+#endif
 
 using namespace Eigen;
 
@@ -92,14 +98,12 @@ void StarOctree::processVisibleObjects(StarHandler&    processor,
                                        float           scale,
                                        OctreeProcStats *stats) const
 {
-#ifdef OCTREE_DEBUG
-    size_t h;
+    size_t h = 0;
     if (stats != nullptr)
     {
         h = stats->height + 1;
         stats->nodes++;
     }
-#endif
     // See if this node lies within the view frustum
 
     // Test the cubic octree node against each one of the five
@@ -112,6 +116,15 @@ void StarOctree::processVisibleObjects(StarHandler&    processor,
             return;
     }
 
+    if (stats != nullptr && stats->visitedCells != nullptr)
+    {
+        OctreeVisitedCell cell;
+        cell.center = cellCenterPos;
+        cell.scale = scale;
+        cell.objects = nObjects;
+        stats->visitedCells->push_back(cell);
+    }
+
     // Compute the distance to node; this is equal to the distance to
     // the cellCenterPos of the node minus the boundingRadius of the node, scale * SQRT3.
     float minDistance = (obsPosition - cellCenterPos).norm() - scale * StarOctree::SQRT3;
@@ -119,12 +132,67 @@ void StarOctree::processVisibleObjects(StarHandler&    processor,
     // Process the objects in this node
     float dimmest     = minDistance > 0 ? astro::appToAbsMag(limitingFactor, minDistance) : 1000;
 
-    for (unsigned int i=0; i<nObjects; ++i)
+    if (stats != nullptr)
+        stats->objects += nObjects;
+
+    unsigned int i = 0;
+
+#ifdef STAROCTREE_USE_SSE2
+    // Test four stars per iteration: squared distances and the
+    // magnitude prefilter are evaluated in parallel, and the square
+    // root runs once per group. Only stars passing the prefilter fall
+    // through to the scalar magnitude conversion, which needs a log10.
+    const __m128 obsX = _mm_set1_ps(obsPosition.x());
+    const __m128 obsY = _mm_set1_ps(obsPosition.y());
+    const __m128 obsZ = _mm_set1_ps(obsPosition.z());
+    const __m128 dimmest4 = _mm_set1_ps(dimmest);
+
+    for (; i + 4 <= nObjects; i += 4)
     {
-#ifdef OCTREE_DEBUG
-        if (stats != nullptr)
-            stats->objects++;
+        const Star& s0 = _firstObject[i];
+        const Star& s1 = _firstObject[i + 1];
+        const Star& s2 = _firstObject[i + 2];
+        const Star& s3 = _firstObject[i + 3];
+
+        __m128 px = _mm_set_ps(s3.getPosition().x(), s2.getPosition().x(),
+                               s1.getPosition().x(), s0.getPosition().x());
+        __m128 py = _mm_set_ps(s3.getPosition().y(), s2.getPosition().y(),
+                               s1.getPosition().y(), s0.getPosition().y());
+        __m128 pz = _mm_set_ps(s3.getPosition().z(), s2.getPosition().z(),
+                               s1.getPosition().z(), s0.getPosition().z());
+        __m128 mag = _mm_set_ps(s3.getAbsoluteMagnitude(), s2.getAbsoluteMagnitude(),
+                                s1.getAbsoluteMagnitude(), s0.getAbsoluteMagnitude());
+
+        __m128 dx = _mm_sub_ps(obsX, px);
+        __m128 dy = _mm_sub_ps(obsY, py);
+        __m128 dz = _mm_sub_ps(obsZ, pz);
+        __m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                   _mm_mul_ps(dz, dz));
+
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(mag, dimmest4));
+        if (mask == 0)
+            continue;
+
+        alignas(16) float distances[4];
+        _mm_store_ps(distances, _mm_sqrt_ps(distSq));
+
+        for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+            if ((mask & (1 << lane)) == 0)
+                continue;
+
+            const Star& obj = _firstObject[i + lane];
+            float distance = distances[lane];
+            float appMag   = astro::absToAppMag(obj.getAbsoluteMagnitude(), distance);
+
+            if (appMag < limitingFactor || (distance < MAX_STAR_ORBIT_RADIUS && obj.getOrbit()))
+                processor.process(obj, distance, appMag);
+        }
+    }
 #endif
+
+    for (; i < nObjects; ++i)
+    {
         const Star& obj = _firstObject[i];
 
         if (obj.getAbsoluteMagnitude() < dimmest)
@@ -144,8 +212,28 @@ void StarOctree::processVisibleObjects(StarHandler&    processor,
         // Recurse into the child nodes
         if (_children != nullptr)
         {
+            // Batch-test the bounding spheres of all eight children
+            // against the frustum in one call before recursing; children
+            // rejected here would fail their own (tighter) per-plane cube
+            // test anyway, since the sphere encloses the cube.
+            float childRadius = scale * 0.5f * StarOctree::SQRT3;
+            float cx[8], cy[8], cz[8], cr[8];
+            for (int i = 0; i < 8; ++i)
+            {
+                const Vector3f& childCenter = _children[i]->cellCenterPos;
+                cx[i] = childCenter.x();
+                cy[i] = childCenter.y();
+                cz[i] = childCenter.z();
+                cr[i] = childRadius;
+            }
+            unsigned int visibleMask =
+                celmath::Frustum::testSpheres(frustumPlanes, 5, cx, cy, cz, cr, 8);
+
             for (int i=0; i<8; ++i)
             {
+                if ((visibleMask & (1u << i)) == 0)
+                    continue;
+
                 _children[i]->processVisibleObjects(processor,
                                                     obsPosition,
                                                     frustumPlanes,
@@ -153,15 +241,11 @@ void StarOctree::processVisibleObjects(StarHandler&    processor,
                                                     scale * 0.5f,
                                                     stats
                                                    );
-#ifdef OCTREE_DEBUG
                 if (stats != nullptr && stats->height > h)
                     h = stats->height;
-#endif
             }
-#ifdef OCTREE_DEBUG
             if (stats != nullptr)
                 stats->height = h;
-#endif
         }
     }
 }
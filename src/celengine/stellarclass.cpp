@@ -8,6 +8,7 @@
 // of the License, or (at your option) any later version.
 
 #include <cstring>
+#include <cstdint>
 #include <celutil/debug.h>
 #include <cassert>
 #include <config.h>
@@ -58,15 +59,47 @@ Color StellarClass::getApparentColor(StellarClass::SpectralClass sc) const
 }
 
 
-// The << method of converting the stellar class to a string is
-// preferred, but it's not always practical, especially when you've
-// got a completely broken implementation of stringstreams to
-// deal with (*cough* gcc *cough*).
-string StellarClass::str() const
+namespace
+{
+
+// Every spectral type string for normal stars, built once on first
+// use. Entries are at most "M9 I-a0" plus the terminator, so a fixed
+// eight byte slot holds any of them and the whole table is ~13KB.
+struct SpectralTypeNameTable
 {
-    char s0, s1;
-    const char* s2 = "";
+    char names[StellarClass::NormalClassCount]
+              [StellarClass::SubclassCount]
+              [StellarClass::Lum_Count][8];
+
+    SpectralTypeNameTable()
+    {
+        static const char* lumSuffixes[StellarClass::Lum_Count] =
+        {
+            " I-a0", " I-a", " I-b", " II", " III", " IV", " V", " VI", ""
+        };
 
+        for (unsigned int spec = 0; spec < StellarClass::NormalClassCount; spec++)
+        {
+            for (unsigned int sub = 0; sub < StellarClass::SubclassCount; sub++)
+            {
+                for (unsigned int lum = 0; lum < StellarClass::Lum_Count; lum++)
+                {
+                    char* p = names[spec][sub][lum];
+                    *p++ = "OBAFGKMRSNWW?LTYC"[spec];
+                    if (sub != StellarClass::Subclass_Unknown)
+                        *p++ = (char) ('0' + sub);
+                    strcpy(p, lumSuffixes[lum]);
+                }
+            }
+        }
+    }
+};
+
+} // anonymous namespace
+
+
+const char* StellarClass::name() const
+{
     switch (getStarType())
     {
     case StellarClass::WhiteDwarf:
@@ -76,43 +109,40 @@ string StellarClass::str() const
     case StellarClass::BlackHole:
         return "X";
     case StellarClass::NormalStar:
-        s0 = "OBAFGKMRSNWW?LTYC"[(unsigned int) getSpectralClass()];
-        s1 = "0123456789"[getSubclass()];
-        switch (getLuminosityClass())
         {
-        case StellarClass::Lum_Ia0:
-            s2 = " I-a0";
-            break;
-        case StellarClass::Lum_Ia:
-            s2 = " I-a";
-            break;
-        case StellarClass::Lum_Ib:
-            s2 = " I-b";
-            break;
-        case StellarClass::Lum_II:
-            s2 = " II";
-            break;
-        case StellarClass::Lum_III:
-            s2 = " III";
-            break;
-        case StellarClass::Lum_IV:
-            s2 = " IV";
-            break;
-        case StellarClass::Lum_V:
-            s2 = " V";
-            break;
-        case StellarClass::Lum_VI:
-            s2 = " VI";
-            break;
-        default: break;  // Do nothing, but prevent GCC4 warnings (Beware: potentially dangerous)
+            static const SpectralTypeNameTable table;
+
+            // Clamp fields that a corrupt catalog could have pushed out
+            // of range; the old formatting code indexed out of bounds.
+            unsigned int spec = (unsigned int) getSpectralClass();
+            unsigned int sub = getSubclass();
+            unsigned int lum = (unsigned int) getLuminosityClass();
+            if (spec >= NormalClassCount)
+                spec = Spectral_Unknown;
+            if (sub >= SubclassCount)
+                sub = Subclass_Unknown;
+            if (lum >= Lum_Count)
+                lum = Lum_Unknown;
+            return table.names[spec][sub][lum];
         }
-        return fmt::sprintf("%c%c%s", s0, s1, s2);
     }
 
     return "?";
 }
 
 
+// The << method of converting the stellar class to a string is
+// preferred, but it's not always practical, especially when you've
+// got a completely broken implementation of stringstreams to
+// deal with (*cough* gcc *cough*).
+string StellarClass::str() const
+{
+    // Interned names are at most seven characters, so the returned
+    // string stays within the small-string optimization.
+    return name();
+}
+
+
 uint16_t
 StellarClass::packV1() const
 {
@@ -215,7 +245,7 @@ StellarClass::unpackV2(uint16_t st)
 
 ostream& operator<<(ostream& os, const StellarClass& sc)
 {
-    os << sc.str();
+    os << sc.name();
 
     return os;
 }
@@ -255,6 +285,80 @@ enum ParseState
 };
 
 
+namespace
+{
+
+// Character-indexed dispatch tables replacing the wide switch
+// statements in the per-character states. parse() runs once per star
+// at catalog load, so the class-letter dispatch is the hottest part
+// of the machine.
+enum
+{
+    NotAClass  = -1,
+    WolfRayet  = -2,
+};
+
+struct ParseTables
+{
+    // Leading class letter -> SpectralClass, WolfRayet for 'W',
+    // NotAClass for anything else
+    int8_t spectralClass[256];
+
+    // Letter following 'D' -> white dwarf SpectralClass, NotAClass
+    // for anything else (generic Spectral_D)
+    int8_t wdClass[256];
+
+    // Letters consumed silently in the extended white dwarf type
+    bool wdExtended[256];
+
+    ParseTables()
+    {
+        for (unsigned int i = 0; i < 256; i++)
+        {
+            spectralClass[i] = NotAClass;
+            wdClass[i] = NotAClass;
+            wdExtended[i] = false;
+        }
+
+        static const char normalLetters[] = "OBAFGKMRSNLTYC";
+        static const int8_t normalClasses[] =
+        {
+            StellarClass::Spectral_O, StellarClass::Spectral_B,
+            StellarClass::Spectral_A, StellarClass::Spectral_F,
+            StellarClass::Spectral_G, StellarClass::Spectral_K,
+            StellarClass::Spectral_M, StellarClass::Spectral_R,
+            StellarClass::Spectral_S, StellarClass::Spectral_N,
+            StellarClass::Spectral_L, StellarClass::Spectral_T,
+            StellarClass::Spectral_Y, StellarClass::Spectral_C,
+        };
+        for (unsigned int i = 0; normalLetters[i] != '\0'; i++)
+            spectralClass[(unsigned char) normalLetters[i]] = normalClasses[i];
+        spectralClass[(unsigned char) 'W'] = WolfRayet;
+
+        static const char wdLetters[] = "ABCOQXZ";
+        static const int8_t wdClasses[] =
+        {
+            StellarClass::Spectral_DA, StellarClass::Spectral_DB,
+            StellarClass::Spectral_DC, StellarClass::Spectral_DO,
+            StellarClass::Spectral_DQ, StellarClass::Spectral_DX,
+            StellarClass::Spectral_DZ,
+        };
+        for (unsigned int i = 0; wdLetters[i] != '\0'; i++)
+            wdClass[(unsigned char) wdLetters[i]] = wdClasses[i];
+
+        // V: variable; P/H: magnetic with/without polarized light;
+        // E: emission lines
+        static const char extendedLetters[] = "ABCOQZXVPHE";
+        for (unsigned int i = 0; extendedLetters[i] != '\0'; i++)
+            wdExtended[(unsigned char) extendedLetters[i]] = true;
+    }
+};
+
+const ParseTables parseTables;
+
+} // anonymous namespace
+
+
 StellarClass
 StellarClass::parse(const string& st)
 {
@@ -342,70 +446,21 @@ StellarClass::parse(const string& st)
             break;
 
         case NormalStarClassState:
-            switch (c)
             {
-            case 'W':
-                state = WolfRayetTypeState;
-                break;
-            case 'O':
-                specClass = StellarClass::Spectral_O;
-                state = NormalStarSubclassState;
-                break;
-            case 'B':
-                specClass = StellarClass::Spectral_B;
-                state = NormalStarSubclassState;
-                break;
-            case 'A':
-                specClass = StellarClass::Spectral_A;
-                state = NormalStarSubclassState;
-                break;
-            case 'F':
-                specClass = StellarClass::Spectral_F;
-                state = NormalStarSubclassState;
-                break;
-            case 'G':
-                specClass = StellarClass::Spectral_G;
-                state = NormalStarSubclassState;
-                break;
-            case 'K':
-                specClass = StellarClass::Spectral_K;
-                state = NormalStarSubclassState;
-                break;
-            case 'M':
-                specClass = StellarClass::Spectral_M;
-                state = NormalStarSubclassState;
-                break;
-            case 'R':
-                specClass = StellarClass::Spectral_R;
-                state = NormalStarSubclassState;
-                break;
-            case 'S':
-                specClass = StellarClass::Spectral_S;
-                state = NormalStarSubclassState;
-                break;
-            case 'N':
-                specClass = StellarClass::Spectral_N;
-                state = NormalStarSubclassState;
-                break;
-            case 'L':
-                specClass = StellarClass::Spectral_L;
-                state = NormalStarSubclassState;
-                break;
-            case 'T':
-                specClass = StellarClass::Spectral_T;
-                state = NormalStarSubclassState;
-                break;
-            case 'Y':
-                specClass = StellarClass::Spectral_Y;
-                state = NormalStarSubclassState;
-                break;
-            case 'C':
-                specClass = StellarClass::Spectral_C;
-                state = NormalStarSubclassState;
-                break;
-            default:
-                state = EndState;
-                break;
+                int8_t code = parseTables.spectralClass[(unsigned char) c];
+                if (code >= 0)
+                {
+                    specClass = static_cast<SpectralClass>(code);
+                    state = NormalStarSubclassState;
+                }
+                else if (code == WolfRayet)
+                {
+                    state = WolfRayetTypeState;
+                }
+                else
+                {
+                    state = EndState;
+                }
             }
             i++;
             break;
@@ -547,63 +602,26 @@ StellarClass::parse(const string& st)
             break;
 
         case WDTypeState:
-            switch (c)
             {
-            case 'A':
-                specClass = StellarClass::Spectral_DA;
-                i++;
-                break;
-            case 'B':
-                specClass = StellarClass::Spectral_DB;
-                i++;
-                break;
-            case 'C':
-                specClass = StellarClass::Spectral_DC;
-                i++;
-                break;
-            case 'O':
-                specClass = StellarClass::Spectral_DO;
-                i++;
-                break;
-            case 'Q':
-                specClass = StellarClass::Spectral_DQ;
-                i++;
-                break;
-            case 'X':
-                specClass = StellarClass::Spectral_DX;
-                i++;
-                break;
-            case 'Z':
-                specClass = StellarClass::Spectral_DZ;
-                i++;
-                break;
-            default:
-                specClass = StellarClass::Spectral_D;
-                break;
+                int8_t code = parseTables.wdClass[(unsigned char) c];
+                if (code >= 0)
+                {
+                    specClass = static_cast<SpectralClass>(code);
+                    i++;
+                }
+                else
+                {
+                    specClass = StellarClass::Spectral_D;
+                }
             }
             state = WDExtendedTypeState;
             break;
 
         case WDExtendedTypeState:
-            switch (c)
-            {
-            case 'A':
-            case 'B':
-            case 'C':
-            case 'O':
-            case 'Q':
-            case 'Z':
-            case 'X':
-            case 'V': // variable
-            case 'P': // magnetic stars with polarized light
-            case 'H': // magnetic stars without polarized light
-            case 'E': // emission lines
+            if (parseTables.wdExtended[(unsigned char) c])
                 i++;
-                break;
-            default:
+            else
                 state = WDSubclassState;
-                break;
-            }
             break;
 
         case WDSubclassState:
@@ -99,6 +99,11 @@ public:
 
     std::string str() const;
 
+    //! Canonical spectral type string ("G2 V", "WD", ...) from a static
+    //! interned table; the pointer stays valid for the life of the
+    //! program and no allocation is performed.
+    const char* name() const;
+
     static StellarClass parse(const std::string&);
 
     friend bool operator<(const StellarClass& sc0, const StellarClass& sc1);
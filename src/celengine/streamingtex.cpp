@@ -0,0 +1,441 @@
+// streamingtex.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Asynchronous texture streaming: images are decoded off the main
+// thread and uploaded through pixel buffer objects a slice at a time,
+// so that faulting in a large surface map does not hitch the renderer.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <config.h>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include <celutil/debug.h>
+#include <celutil/filetype.h>
+#include <GL/glew.h>
+#include "streamingtex.h"
+
+using namespace std;
+
+
+// Upper bound on the texel data uploaded per frame; at 60fps this keeps
+// each slice well under a millisecond on any hardware recent enough to
+// run Celestia.
+static const int StreamingSliceBytes = 1 << 20;
+
+
+// Shared 1x1 mid-gray texture bound while the real texels are still in
+// flight; gray keeps half-loaded bodies visible without being garish.
+static GLuint GetPlaceholderTexture()
+{
+    static GLuint placeholderName = 0;
+
+    if (placeholderName == 0)
+    {
+        static const unsigned char gray[4] = { 128, 128, 128, 255 };
+
+        glGenTextures(1, &placeholderName);
+        glBindTexture(GL_TEXTURE_2D, placeholderName);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, gray);
+    }
+
+    return placeholderName;
+}
+
+
+static GLenum GetGLTexAddressMode(Texture::AddressMode addressMode)
+{
+    switch (addressMode)
+    {
+    case Texture::Wrap:
+        return GL_REPEAT;
+
+    case Texture::EdgeClamp:
+        return GL_CLAMP_TO_EDGE;
+
+    case Texture::BorderClamp:
+        return GL_CLAMP_TO_BORDER;
+    }
+
+    return 0;
+}
+
+
+static int ilog2(unsigned int x)
+{
+    int n = -1;
+
+    while (x != 0)
+    {
+        x >>= 1;
+        n++;
+    }
+
+    return n;
+}
+
+
+static int CalcMipLevelCount(int w, int h)
+{
+    return max(ilog2(w), ilog2(h)) + 1;
+}
+
+
+StreamingTexture::StreamingTexture(const fs::path& _filename,
+                                   AddressMode _addressMode,
+                                   MipMapMode _mipMode,
+                                   bool _dxt5NormalMap) :
+    Texture(0, 0),
+    filename(_filename),
+    addressMode(_addressMode),
+    mipMode(_mipMode),
+    dxt5NormalMap(_dxt5NormalMap)
+{
+    pboNames[0] = pboNames[1] = 0;
+
+    decodeThread = thread([this]() {
+        Image* img = LoadImageFromFile(filename);
+        image = img;
+        state.store(img != nullptr ? DecodeDone : Failed,
+                    memory_order_release);
+    });
+}
+
+
+StreamingTexture::~StreamingTexture()
+{
+    if (decodeThread.joinable())
+        decodeThread.join();
+
+    delete image;
+    delete delegate;
+
+    if (glName != 0)
+        glDeleteTextures(1, (const GLuint*) &glName);
+    if (pboNames[0] != 0)
+        glDeleteBuffers(2, pboNames);
+}
+
+
+// Create the GL objects for the decoded image and decide how it will be
+// streamed. Runs on the main thread during the first bind() after the
+// decode thread finishes.
+void StreamingTexture::beginUpload()
+{
+    assert(image != nullptr);
+
+    setDimensions(image->getWidth(), image->getHeight());
+    alpha = image->hasAlpha();
+    compressed = image->isCompressed();
+
+    if (dxt5NormalMap && image->getFormat() == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+        setFormatOptions(Texture::DXT5NormalMap);
+
+    // Images too large for a single texture object need to be split;
+    // TiledTexture already handles that, so delegate to it. This is the
+    // one path that still uploads everything in a single frame.
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (image->getWidth() > maxTextureSize || image->getHeight() > maxTextureSize)
+    {
+        int uSplit = max(1, image->getWidth() / maxTextureSize);
+        int vSplit = max(1, image->getHeight() / maxTextureSize);
+        delegate = new TiledTexture(*image, uSplit, vSplit, mipMode);
+        finishUpload();
+        return;
+    }
+
+    mipmap = mipMode != NoMipMaps;
+    bool precomputedMipMaps = false;
+    if (mipmap && image->getMipLevelCount() == CalcMipLevelCount(image->getWidth(),
+                                                                 image->getHeight()))
+        precomputedMipMaps = true;
+
+    // As in ImageTexture: no automatic mipmap generation for compressed
+    // images, so without a prebuilt set mipmapping is turned off.
+    if (!precomputedMipMaps && image->isCompressed())
+        mipmap = false;
+
+    glGenTextures(1, (GLuint*) &glName);
+    glBindTexture(GL_TEXTURE_2D, glName);
+
+    GLenum texAddress = GetGLTexAddressMode(addressMode);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texAddress);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texAddress);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+
+    if (GLEW_EXT_texture_filter_anisotropic)
+    {
+        GLint maxAnisotropy = 1;
+        glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                        min(8, maxAnisotropy));
+    }
+
+    if (image->isCompressed())
+    {
+        // S3TC data is block encoded; rather than slicing within a
+        // level, upload one whole mipmap level per frame. Level zero of
+        // a compressed image is at most a quarter the size of its
+        // uncompressed equivalent, so this stays cheap.
+        nextMipLevel = 0;
+        mipLevelCount = precomputedMipMaps ? image->getMipLevelCount() : 1;
+    }
+    else
+    {
+        // Allocate the storage now, then fill it with glTexSubImage2D a
+        // slice of rows at a time.
+        glTexImage2D(GL_TEXTURE_2D, 0,
+                     image->getComponents(),
+                     image->getWidth(), image->getHeight(),
+                     0,
+                     (GLenum) image->getFormat(),
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+
+        nextRow = 0;
+        sliceRows = max(1, StreamingSliceBytes / image->getPitch());
+
+        usePBO = GLEW_ARB_pixel_buffer_object != GL_FALSE;
+        if (usePBO)
+            glGenBuffers(2, pboNames);
+    }
+
+    state.store(Uploading, memory_order_relaxed);
+}
+
+
+// Upload the next slice (or, for compressed images, the next mipmap
+// level); called once per frame from bind().
+void StreamingTexture::uploadSlice()
+{
+    glBindTexture(GL_TEXTURE_2D, glName);
+
+    if (image->isCompressed())
+    {
+        unsigned int mipWidth  = max((unsigned int) image->getWidth() >> nextMipLevel, 1u);
+        unsigned int mipHeight = max((unsigned int) image->getHeight() >> nextMipLevel, 1u);
+
+        glCompressedTexImage2D(GL_TEXTURE_2D,
+                               nextMipLevel,
+                               image->getFormat(),
+                               mipWidth, mipHeight,
+                               0,
+                               image->getMipLevelSize(nextMipLevel),
+                               image->getMipLevel(nextMipLevel));
+
+        nextMipLevel++;
+        if (nextMipLevel >= mipLevelCount)
+            finishUpload();
+        return;
+    }
+
+    int rows = min(sliceRows, getHeight() - nextRow);
+    int pitch = image->getPitch();
+    unsigned char* src = image->getPixels() + (size_t) nextRow * pitch;
+    bool lastSlice = nextRow + rows >= getHeight();
+
+    // Derived levels are regenerated whenever level zero changes, so
+    // only enable generation for the final slice.
+    if (mipmap && lastSlice)
+        glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS, GL_TRUE);
+
+    if (usePBO)
+    {
+        // Alternate between two orphaned buffers so writing this slice
+        // never waits for the GPU to finish reading the previous one.
+        int bytes = rows * pitch;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, pboNames[pboIndex]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER_ARB, bytes, nullptr, GL_STREAM_DRAW);
+        void* dst = glMapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY);
+        if (dst != nullptr)
+        {
+            memcpy(dst, src, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER_ARB);
+            glTexSubImage2D(GL_TEXTURE_2D, 0,
+                            0, nextRow,
+                            getWidth(), rows,
+                            (GLenum) image->getFormat(),
+                            GL_UNSIGNED_BYTE,
+                            nullptr);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+        pboIndex ^= 1;
+
+        if (dst == nullptr)
+        {
+            // Mapping failed; fall back to client memory uploads.
+            usePBO = false;
+            return;
+        }
+    }
+    else
+    {
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+                        0, nextRow,
+                        getWidth(), rows,
+                        (GLenum) image->getFormat(),
+                        GL_UNSIGNED_BYTE,
+                        src);
+    }
+
+    nextRow += rows;
+    if (nextRow >= getHeight())
+        finishUpload();
+}
+
+
+void StreamingTexture::finishUpload()
+{
+    delete image;
+    image = nullptr;
+
+    if (pboNames[0] != 0)
+    {
+        glDeleteBuffers(2, pboNames);
+        pboNames[0] = pboNames[1] = 0;
+    }
+
+    if (haveBorderColor)
+    {
+        if (delegate != nullptr)
+        {
+            delegate->setBorderColor(borderColor);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, glName);
+            float bc[4] = { borderColor.red(), borderColor.green(),
+                            borderColor.blue(), borderColor.alpha() };
+            glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, bc);
+        }
+    }
+
+    state.store(Complete, memory_order_release);
+}
+
+
+void StreamingTexture::bind()
+{
+    int s = state.load(memory_order_acquire);
+
+    if (s == DecodeDone)
+    {
+        if (decodeThread.joinable())
+            decodeThread.join();
+        beginUpload();
+        s = state.load(memory_order_relaxed);
+    }
+
+    if (s == Uploading)
+    {
+        uploadSlice();
+        s = state.load(memory_order_relaxed);
+    }
+
+    if (s == Complete)
+    {
+        if (delegate != nullptr)
+            delegate->bind();
+        else
+            glBindTexture(GL_TEXTURE_2D, glName);
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, GetPlaceholderTexture());
+    }
+}
+
+
+const TextureTile StreamingTexture::getTile(int lod, int u, int v)
+{
+    if (state.load(memory_order_acquire) != Complete)
+    {
+        if (lod != 0 || u != 0 || v != 0)
+            return TextureTile(0);
+        return TextureTile(GetPlaceholderTexture());
+    }
+
+    if (delegate != nullptr)
+        return delegate->getTile(lod, u, v);
+
+    if (lod != 0 || u != 0 || v != 0)
+        return TextureTile(0);
+
+    return TextureTile(glName);
+}
+
+
+void StreamingTexture::setBorderColor(Color color)
+{
+    borderColor = color;
+    haveBorderColor = true;
+
+    if (state.load(memory_order_acquire) != Complete)
+        return;
+
+    if (delegate != nullptr)
+    {
+        delegate->setBorderColor(color);
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, glName);
+        float bc[4] = { color.red(), color.green(),
+                        color.blue(), color.alpha() };
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, bc);
+    }
+}
+
+
+int StreamingTexture::getLODCount() const
+{
+    return delegate != nullptr ? delegate->getLODCount() : 1;
+}
+
+
+int StreamingTexture::getUTileCount(int lod) const
+{
+    return delegate != nullptr ? delegate->getUTileCount(lod) : 1;
+}
+
+
+int StreamingTexture::getVTileCount(int lod) const
+{
+    return delegate != nullptr ? delegate->getVTileCount(lod) : 1;
+}
+
+
+Texture* CreateStreamingTexture(const fs::path& filename,
+                                Texture::AddressMode addressMode,
+                                Texture::MipMapMode mipMode)
+{
+    ContentType contentType = DetermineFileType(filename);
+
+    // Virtual textures manage their own tile loading and cannot be
+    // streamed here.
+    if (contentType == Content_CelestiaTexture)
+        return nullptr;
+
+    // Mirror CreateTextureFromImage: prefer automatic mipmap generation
+    // so non power of two images keep their dimensions.
+    if (mipMode == Texture::DefaultMipMaps)
+        mipMode = Texture::AutoMipMaps;
+
+    return new StreamingTexture(filename, addressMode, mipMode,
+                                contentType == Content_DXT5NormalMap);
+}
@@ -0,0 +1,106 @@
+// streamingtex.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELENGINE_STREAMINGTEX_H_
+#define _CELENGINE_STREAMINGTEX_H_
+
+#include <atomic>
+#include <thread>
+#include <celengine/texture.h>
+
+class Image;
+
+/*! A texture that is faulted in without stalling the frame loop. The
+ *  image file is decoded on a worker thread; once decoding finishes,
+ *  the texels are uploaded through double buffered pixel buffer objects
+ *  in slices spread across successive frames. Until the upload is
+ *  complete, bind() and getTile() serve a small neutral placeholder, so
+ *  approaching a body with a large surface map never drops frames.
+ *
+ *  Compressed (DDS) images cannot be sliced row-wise, so they are
+ *  uploaded one mipmap level per frame instead; images too large for a
+ *  single texture are handed to TiledTexture on the completion frame.
+ */
+class StreamingTexture : public Texture
+{
+ public:
+    StreamingTexture(const fs::path& filename,
+                     AddressMode addressMode,
+                     MipMapMode mipMode,
+                     bool dxt5NormalMap);
+    virtual ~StreamingTexture();
+
+    virtual const TextureTile getTile(int lod, int u, int v);
+    virtual void bind();
+    virtual void setBorderColor(Color);
+
+    virtual int getLODCount() const;
+    virtual int getUTileCount(int lod) const;
+    virtual int getVTileCount(int lod) const;
+
+    //! True once the real texture is resident and being served.
+    bool isComplete() const
+    {
+        return state.load(std::memory_order_acquire) == Complete;
+    }
+
+ private:
+    enum StreamState
+    {
+        Decoding,    // worker thread is loading the image
+        DecodeDone,  // image ready; GL objects not yet created
+        Uploading,   // uploading slices, one per frame
+        Complete,    // texture resident; placeholder no longer used
+        Failed,      // decode failed; placeholder served permanently
+    };
+
+    void beginUpload();
+    void uploadSlice();
+    void finishUpload();
+
+    fs::path filename;
+    AddressMode addressMode;
+    MipMapMode mipMode;
+    bool dxt5NormalMap;
+
+    std::thread decodeThread;
+    std::atomic<int> state{ Decoding };
+    Image* image{ nullptr };
+
+    // Oversize images are delegated to a TiledTexture instead of being
+    // streamed into a single texture object.
+    Texture* delegate{ nullptr };
+
+    unsigned int glName{ 0 };
+    unsigned int pboNames[2];
+    bool usePBO{ false };
+    int pboIndex{ 0 };
+    bool mipmap{ false };
+
+    // Upload cursor: row offset for uncompressed images, mip level for
+    // compressed ones.
+    int nextRow{ 0 };
+    int sliceRows{ 0 };
+    int nextMipLevel{ 0 };
+    int mipLevelCount{ 0 };
+
+    Color borderColor;
+    bool haveBorderColor{ false };
+};
+
+
+/*! Create a streaming texture for the named file, or return nullptr if
+ *  the file type cannot be streamed (virtual .ctx textures). The caller
+ *  should fall back to LoadTextureFromFile in that case.
+ */
+extern Texture* CreateStreamingTexture(const fs::path& filename,
+                                       Texture::AddressMode addressMode = Texture::EdgeClamp,
+                                       Texture::MipMapMode mipMode = Texture::DefaultMipMaps);
+
+#endif // _CELENGINE_STREAMINGTEX_H_
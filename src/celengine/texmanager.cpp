@@ -9,9 +9,14 @@
 
 #include <config.h>
 #include <celutil/debug.h>
+#include <celutil/tracelog.h>
+#include <celutil/dirmanifest.h>
+#include <celutil/filetype.h>
 #include <iostream>
 #include <fstream>
+#include <system_error>
 #include "multitexture.h"
+#include "streamingtex.h"
 #include "texmanager.h"
 
 using namespace std;
@@ -19,6 +24,47 @@ using namespace std;
 
 static TextureManager* textureManager = nullptr;
 
+// Image files at least this large are decoded on a worker thread and
+// uploaded incrementally instead of synchronously, so that faulting in
+// a big surface map mid-flight does not stall rendering.
+static const uintmax_t StreamingTextureThreshold = 4 * 1024 * 1024;
+
+
+// Transcode a PNG/JPEG/BMP source texture to S3TC once and store the
+// result beside the original as a DDS file. The cache name includes the
+// source file size, so the artifact is regenerated when the source
+// changes. Returns nullptr when transcoding or caching is not possible;
+// the caller then falls back to the ordinary loaders.
+static Texture* LoadCachedCompressedTexture(const fs::path& name,
+                                            uintmax_t sourceSize,
+                                            Texture::AddressMode addressMode,
+                                            Texture::MipMapMode mipMode)
+{
+    fs::path cachePath = name;
+    cachePath += "." + to_string(sourceSize) + ".dds";
+
+    error_code ec;
+    if (!fs::exists(cachePath, ec))
+    {
+        Image* img = LoadImageFromFile(name);
+        if (img == nullptr)
+            return nullptr;
+
+        Image* compressedImg = CompressImageToS3TC(*img);
+        delete img;
+        if (compressedImg == nullptr)
+            return nullptr;
+
+        DPRINTF(LOG_LEVEL_INFO, "Writing compressed texture cache: %s\n", cachePath);
+        bool saved = SaveDDSImage(cachePath, *compressedImg);
+        delete compressedImg;
+        if (!saved)
+            return nullptr;
+    }
+
+    return LoadTextureFromFile(cachePath, addressMode, mipMode);
+}
+
 static const char *directories[]=
 {
     "lores",
@@ -35,39 +81,20 @@ TextureManager* GetTextureManager()
 }
 
 
+// Existence probes during resolution go through the directory
+// manifest: each texture may be tested against several directories and
+// extensions, and in a large extras tree most probes miss, so cached
+// listings replace per-probe open attempts with hash lookups.
 static string resolveWildcard(const string& filename)
 {
     string base(filename, 0, filename.length() - 1);
 
-    string pngfile = base + "png";
-    {
-        ifstream in(pngfile);
-        if (in.good())
-            return pngfile;
-    }
-    string jpgfile = base + "jpg";
-    {
-        ifstream in(jpgfile);
-        if (in.good())
-            return jpgfile;
-    }
-    string ddsfile = base + "dds";
-    {
-        ifstream in(ddsfile);
-        if (in.good())
-            return ddsfile;
-    }
-    string dxt5file = base + "dxt5nm";
-    {
-        ifstream in(dxt5file);
-        if (in.good())
-            return dxt5file;
-    }
-    string ctxfile = base + "ctx";
+    static const char* extensions[] = { "png", "jpg", "dds", "dxt5nm", "ctx" };
+    for (const char* extension : extensions)
     {
-        ifstream in(ctxfile);
-        if (in.good())
-            return ctxfile;
+        string candidate = base + extension;
+        if (GetDirectoryManifest()->exists(candidate))
+            return candidate;
     }
 
     return "";
@@ -92,8 +119,7 @@ fs::path TextureInfo::resolve(const fs::path& baseDir)
         }
         else
         {
-            ifstream in(filename.string());
-            if (in.good())
+            if (GetDirectoryManifest()->exists(filename))
                 return filename;
         }
     }
@@ -114,6 +140,7 @@ fs::path TextureInfo::resolve(const fs::path& baseDir)
 
 Texture* TextureInfo::load(const fs::path& name)
 {
+    CELZONE("texture/load");
     Texture::AddressMode addressMode = Texture::EdgeClamp;
     Texture::MipMapMode mipMode = Texture::DefaultMipMaps;
 
@@ -132,6 +159,34 @@ Texture* TextureInfo::load(const fs::path& name)
         DPRINTF(LOG_LEVEL_ERROR, "Loading texture: %s\n", name);
         // cout << "Loading texture: " << name << '\n';
 
+        error_code ec;
+        uintmax_t fileSize = fs::file_size(name, ec);
+
+        // Surfaces marked CompressTexture are served from an on-disk
+        // S3TC cache: transcoded by the GL driver on first load, read
+        // back directly as DDS on subsequent runs, which cuts VRAM use
+        // and upload time roughly fourfold.
+        if ((flags & CompressTexture) != 0 && !ec)
+        {
+            ContentType contentType = DetermineFileType(name);
+            if (contentType == Content_PNG ||
+                contentType == Content_JPEG ||
+                contentType == Content_BMP)
+            {
+                Texture* tex = LoadCachedCompressedTexture(name, fileSize,
+                                                           addressMode, mipMode);
+                if (tex != nullptr)
+                    return tex;
+            }
+        }
+
+        if (!ec && fileSize >= StreamingTextureThreshold)
+        {
+            Texture* tex = CreateStreamingTexture(name, addressMode, mipMode);
+            if (tex != nullptr)
+                return tex;
+        }
+
         return LoadTextureFromFile(name, addressMode, mipMode);
     }
 
@@ -140,3 +195,21 @@ Texture* TextureInfo::load(const fs::path& name)
 
     return LoadHeightMapFromFile(name, bumpHeight, addressMode);
 }
+
+
+uintmax_t TextureInfo::resourceSize() const
+{
+    if (resource == nullptr)
+        return 0;
+
+    uintmax_t texels = (uintmax_t) resource->getWidth() *
+                       (uintmax_t) resource->getHeight() *
+                       (uintmax_t) resource->getDepth();
+
+    // Roughly one byte per texel for S3TC, four uncompressed, plus a
+    // third for the mipmap chain. Only an estimate, but eviction
+    // decisions don't need more precision than that.
+    uintmax_t bytes = resource->isCompressed() ? texels : texels * 4;
+
+    return bytes + bytes / 3;
+}
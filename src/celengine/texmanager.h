@@ -67,6 +67,7 @@ class TextureInfo : public ResourceInfo<Texture>
 
     fs::path resolve(const fs::path&) override;
     Texture* load(const fs::path&) override;
+    std::uintmax_t resourceSize() const override;
 };
 
 inline bool operator<(const TextureInfo& ti0, const TextureInfo& ti1)
@@ -14,6 +14,7 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <system_error>
 
 extern "C" {
 #include <jpeglib.h>
@@ -26,6 +27,7 @@ extern "C" {
 #include <Eigen/Core>
 #include <GL/glew.h>
 #include <celutil/debug.h>
+#include "glstats.h"
 #include "texture.h"
 #include "virtualtex.h"
 
@@ -218,6 +220,7 @@ static void LoadMipmapSet(Image& img, GLenum target)
                          GL_UNSIGNED_BYTE,
                          img.getMipLevel(mip));
         }
+        GLStats::addTextureUpload(img.getMipLevelSize(mip));
     }
 }
 
@@ -248,6 +251,7 @@ static void LoadMiplessTexture(Image& img, GLenum target)
                      GL_UNSIGNED_BYTE,
                      img.getMipLevel(0));
     }
+    GLStats::addTextureUpload(img.getMipLevelSize(0));
 }
 
 
@@ -326,6 +330,13 @@ int Texture::getDepth() const
 }
 
 
+void Texture::setDimensions(int w, int h)
+{
+    width = w;
+    height = h;
+}
+
+
 unsigned int Texture::getFormatOptions() const
 {
     return formatOptions;
@@ -423,6 +434,7 @@ ImageTexture::~ImageTexture()
 void ImageTexture::bind()
 {
     glBindTexture(GL_TEXTURE_2D, glName);
+    GLStats::addTextureBind();
 }
 
 
@@ -741,6 +753,7 @@ CubeMap::~CubeMap()
 void CubeMap::bind()
 {
     glBindTexture(GL_TEXTURE_CUBE_MAP, glName);
+    GLStats::addTextureBind();
 }
 
 
@@ -811,6 +824,46 @@ Texture* CreateProceduralTexture(int width, int height,
 }
 
 
+Texture* CreateProceduralMipMapTexture(int width, int height,
+                                       int format,
+                                       ProceduralTexEval func,
+                                       Texture::AddressMode addressMode)
+{
+    int mipLevelCount = CalcMipLevelCount(width, height);
+    Image* img = new Image(format, width, height, mipLevelCount);
+
+    // Evaluate the function at every level's own resolution; a box
+    // filter over the base level (what gluBuild2DMipmaps would do)
+    // progressively washes out analytic profiles, which shows up as
+    // shimmering on heavily minified sprites.
+    int components = img->getComponents();
+    for (int mip = 0; mip < mipLevelCount; mip++)
+    {
+        int mipWidth  = max(width >> mip, 1);
+        int mipHeight = max(height >> mip, 1);
+        // Rows within each mip level are padded to a multiple of four
+        // bytes, matching the Image storage layout.
+        int mipPitch  = (mipWidth * components + 3) & ~0x3;
+        unsigned char* pixels = img->getMipLevel(mip);
+
+        for (int y = 0; y < mipHeight; y++)
+        {
+            for (int x = 0; x < mipWidth; x++)
+            {
+                float u = ((float) x + 0.5f) / (float) mipWidth * 2 - 1;
+                float v = ((float) y + 0.5f) / (float) mipHeight * 2 - 1;
+                func(u, v, 0, pixels + y * mipPitch + x * components);
+            }
+        }
+    }
+
+    Texture* tex = new ImageTexture(*img, addressMode, Texture::DefaultMipMaps);
+    delete img;
+
+    return tex;
+}
+
+
 // Helper function for CreateProceduralCubeMap; return the normalized
 // vector pointing to (s, t) on the specified face.
 static Vector3f cubeVector(int face, float s, float t)
@@ -975,11 +1028,122 @@ Texture* LoadTextureFromFile(const fs::path& filename,
 }
 
 
+// Compress an uncompressed RGB or RGBA image to S3TC by way of the GL
+// driver's compressor, returning a new image with a complete mipmap
+// chain. Returns nullptr if the driver cannot compress this image, in
+// which case the caller should stay with the uncompressed original.
+Image* CompressImageToS3TC(Image& img)
+{
+    if (!GLEW_ARB_texture_compression || !GLEW_EXT_texture_compression_s3tc)
+        return nullptr;
+    if (img.isCompressed())
+        return nullptr;
+
+    // Opaque images become DXT1 (4 bits per texel), images with alpha
+    // DXT5 (8 bits per texel). Single channel formats gain nothing.
+    GLenum compressedFormat;
+    int cacheFormat;
+    switch (img.getFormat())
+    {
+    case GL_RGB:
+    case GL_BGR_EXT:
+        compressedFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        cacheFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        break;
+    case GL_RGBA:
+    case GL_BGRA_EXT:
+        compressedFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        cacheFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        break;
+    default:
+        return nullptr;
+    }
+
+    // Create a scratch texture with automatic mipmap generation so the
+    // driver builds and compresses the entire chain in one upload.
+    GLuint scratchName = 0;
+    glGenTextures(1, &scratchName);
+    glBindTexture(GL_TEXTURE_2D, scratchName);
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP_SGIS, GL_TRUE);
+    glHint(GL_TEXTURE_COMPRESSION_HINT_ARB, GL_NICEST);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 compressedFormat,
+                 img.getWidth(), img.getHeight(),
+                 0,
+                 (GLenum) img.getFormat(),
+                 GL_UNSIGNED_BYTE,
+                 img.getPixels());
+
+    GLint isCompressed = GL_FALSE;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0,
+                             GL_TEXTURE_COMPRESSED_ARB, &isCompressed);
+    if (!isCompressed)
+    {
+        glDeleteTextures(1, &scratchName);
+        return nullptr;
+    }
+
+    int mipLevelCount = CalcMipLevelCount(img.getWidth(), img.getHeight());
+    Image* compressedImg = new Image(cacheFormat,
+                                     img.getWidth(), img.getHeight(),
+                                     mipLevelCount);
+
+    for (int mip = 0; mip < mipLevelCount; mip++)
+    {
+        GLint mipSize = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, mip,
+                                 GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB,
+                                 &mipSize);
+        if (mipSize != compressedImg->getMipLevelSize(mip))
+        {
+            // The driver produced something other than the canonical
+            // S3TC layout; don't try to cache it.
+            glDeleteTextures(1, &scratchName);
+            delete compressedImg;
+            return nullptr;
+        }
+        glGetCompressedTexImage(GL_TEXTURE_2D, mip,
+                                compressedImg->getMipLevel(mip));
+    }
+
+    glDeleteTextures(1, &scratchName);
+
+    return compressedImg;
+}
+
+
 // Load a height map texture from a file and convert it to a normal map.
+// Converted maps are cached to disk next to the height map so the
+// conversion runs once per source image rather than once per launch;
+// the cache name embeds the source file size and the height scale as a
+// cheap change fingerprint.
 Texture* LoadHeightMapFromFile(const fs::path& filename,
                                float height,
                                Texture::AddressMode addressMode)
 {
+    fs::path cachePath;
+    std::error_code ec;
+    uintmax_t sourceSize = fs::file_size(filename, ec);
+    if (!ec)
+    {
+        cachePath = filename.string() + "." + to_string(sourceSize) +
+            "." + to_string((long) (height * 1000.0f)) + ".nm.dds";
+        if (fs::exists(cachePath, ec) && !ec)
+        {
+            Image* cached = LoadDDSImage(cachePath);
+            if (cached != nullptr && cached->getFormat() == GL_RGBA)
+            {
+                Texture* tex = CreateTextureFromImage(*cached, addressMode,
+                                                      Texture::DefaultMipMaps);
+                delete cached;
+                return tex;
+            }
+            // Unreadable or stale cache entry; fall through and rebuild it
+            delete cached;
+        }
+    }
+
     Image* img = LoadImageFromFile(filename);
     if (img == nullptr)
         return nullptr;
@@ -989,6 +1153,9 @@ Texture* LoadHeightMapFromFile(const fs::path& filename,
     if (normalMap == nullptr)
         return nullptr;
 
+    if (!cachePath.empty())
+        SaveDDSImage(cachePath, *normalMap);
+
     Texture* tex = CreateTextureFromImage(*normalMap, addressMode,
                                           Texture::DefaultMipMaps);
     delete normalMap;
@@ -106,6 +106,10 @@ class Texture
     bool alpha{ false };
     bool compressed{ false };
 
+    //! Set the texture dimensions; used by textures that only learn
+    //! their true size after asynchronous decoding completes.
+    void setDimensions(int w, int h);
+
  private:
     int width;
     int height;
@@ -177,6 +181,16 @@ extern Texture* CreateProceduralTexture(int width, int height,
                                         TexelFunctionObject& func,
                                         Texture::AddressMode addressMode = Texture::EdgeClamp,
                                         Texture::MipMapMode mipMode = Texture::DefaultMipMaps);
+//! Like CreateProceduralTexture, but evaluate the texel function at
+//! every mip resolution instead of downsampling the base level, so the
+//! chain stays faithful to the analytic function. Only usable for
+//! resolution-independent functions; width and height must be powers
+//! of two.
+extern Texture* CreateProceduralMipMapTexture(int width, int height,
+                                              int format,
+                                              ProceduralTexEval func,
+                                              Texture::AddressMode addressMode = Texture::EdgeClamp);
+
 extern Texture* CreateProceduralCubeMap(int size, int format,
                                         ProceduralTexEval func);
 
@@ -188,5 +202,7 @@ extern Texture* LoadHeightMapFromFile(const fs::path& filename,
                                       float height,
                                       Texture::AddressMode addressMode = Texture::EdgeClamp);
 
+extern Image* CompressImageToS3TC(Image& img);
+
 
 #endif // _CELENGINE_TEXTURE_H_
@@ -54,23 +54,40 @@ const TimelinePhase::SharedConstPtr&
 Timeline::findPhase(double t) const
 {
     // Find the phase containing time t. The overwhelming common case is
-    // nPhases = 1, so we special case that. Otherwise, we do a simple linear search,
-    // as the number of phases in a timeline should always be quite small.
+    // nPhases = 1, so we special case that.
     if (phases.size() == 1)
     {
         return phases[0];
     }
-    else
+
+    // Queries happen once per frame per body while time advances almost
+    // continuously, so the phase found last time is nearly always still
+    // the right one; only re-search when t has left its interval.
+    if (cachedPhaseIndex < phases.size())
+    {
+        const TimelinePhase::SharedConstPtr& cached = phases[cachedPhaseIndex];
+        if (cached->includes(t))
+            return cached;
+    }
+
+    // Phases are contiguous and ordered by start time, so binary search
+    // for the first phase ending after t. Timelines built from mission
+    // reconstructions can contain thousands of per-orbit phases.
+    unsigned int low = 0;
+    unsigned int high = phases.size() - 1;
+    while (low < high)
     {
-        for (const auto& phase : phases)
-        {
-            if (t < phase->endTime())
-                return phase;
-        }
-
-        // Time is greater than the end time of the final phase. Just return the final phase.
-        return phases.back();
+        unsigned int mid = low + (high - low) / 2;
+        if (t < phases[mid]->endTime())
+            high = mid;
+        else
+            low = mid + 1;
     }
+
+    // If t is past the end of the final phase, this returns the final
+    // phase, matching the old linear search.
+    cachedPhaseIndex = low;
+    return phases[low];
 }
 
 
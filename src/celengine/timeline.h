@@ -40,6 +40,11 @@ public:
 
 private:
     std::vector<TimelinePhase::SharedConstPtr> phases;
+
+    //! Index of the phase returned by the last findPhase() call.
+    //! Simulation time moves almost continuously, so the previous
+    //! answer is nearly always still valid.
+    mutable unsigned int cachedPhaseIndex{ 0 };
 };
 
 #endif // _CELENGINE_TIMELINE_H_
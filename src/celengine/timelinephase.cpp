@@ -14,6 +14,8 @@
 #include "celengine/frame.h"
 #include "celengine/universe.h"
 #include "celengine/frametree.h"
+#include "celengine/trajmanager.h"
+#include "celengine/rotationmanager.h"
 #include "celephem/orbit.h"
 #include "celephem/rotation.h"
 #include <cassert>
@@ -39,6 +41,29 @@ TimelinePhase::TimelinePhase(Body* _body,
     // assert(owner == orbitFrame->getCenter()->getFrameTree());
 }
 
+TimelinePhase::~TimelinePhase()
+{
+    // release() ignores pointers the managers don't own, so orbits and
+    // rotation models constructed directly from catalog parameters pass
+    // through here harmlessly.
+    GetTrajectoryManager()->release(m_orbit);
+    GetRotationModelManager()->release(m_rotationModel);
+}
+
+Eigen::Quaterniond
+TimelinePhase::rotationOrientation(double tjd) const
+{
+    if (!m_rotationCacheValid || tjd != m_lastRotationTime)
+    {
+        m_lastRotationOrientation = m_rotationModel->orientationAtTime(tjd);
+        m_lastRotationTime = tjd;
+        m_rotationCacheValid = true;
+    }
+
+    return m_lastRotationOrientation;
+}
+
+
 /*! Create a new timeline phase in the specified universe.
  */
 TimelinePhase::SharedConstPtr
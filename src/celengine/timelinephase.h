@@ -62,6 +62,14 @@ public:
         return m_rotationModel;
     }
 
+    /*! Return the composed rotation model orientation (spin * equator)
+     *  at time tjd. Render orientation, locations, and picking all need
+     *  this quaternion within a single frame, so it is cached here and
+     *  recomputed only when the time changes; expensive custom rotation
+     *  series thus run once per body per simulation tick.
+     */
+    Eigen::Quaterniond rotationOrientation(double tjd) const;
+
     /*! Get the frame tree that contains this phase (always the tree associated
      *  with the center of the orbit frame.)
      */
@@ -87,7 +95,9 @@ public:
                                                              const ReferenceFrame::SharedConstPtr& bodyFrame,
                                                              RotationModel& rotationModel);
 
-    ~TimelinePhase() = default;
+    // Drops the eviction pins that the solar system loader took on
+    // manager-owned orbits and rotation models when it built the phase.
+    ~TimelinePhase();
 
     TimelinePhase(Body* _body,
                   double _startTime,
@@ -113,6 +123,11 @@ private:
     RotationModel* m_rotationModel;
 
     FrameTree* m_owner;
+
+    // Composed rotation model orientation cache
+    mutable Eigen::Quaterniond m_lastRotationOrientation;
+    mutable double m_lastRotationTime{ 0.0 };
+    mutable bool m_rotationCacheValid{ false };
 };
 
 #endif // _CELENGINE_TIMELINEPHASE_H_
@@ -10,6 +10,8 @@
 
 #include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <celutil/utf8.h>
 #include "tokenizer.h"
@@ -27,6 +29,22 @@ Tokenizer::Tokenizer(istream* _in) :
 }
 
 
+Tokenizer::Tokenizer(const std::string& text) :
+    in(nullptr),
+    textData(text.data()),
+    textLength(text.size())
+{
+}
+
+
+Tokenizer::Tokenizer(const char* compiledTokens, size_t length) :
+    in(nullptr),
+    replayData(compiledTokens),
+    replayLength(length)
+{
+}
+
+
 Tokenizer::TokenType Tokenizer::nextToken()
 {
     State state = StartState;
@@ -37,6 +55,9 @@ Tokenizer::TokenType Tokenizer::nextToken()
         return tokenType;
     }
 
+    if (replayData != nullptr)
+        return nextReplayToken();
+
     textToken = "";
     haveValidNumber = false;
     haveValidName = false;
@@ -45,7 +66,7 @@ Tokenizer::TokenType Tokenizer::nextToken()
     if (tokenType == TokenBegin)
     {
         nextChar = readChar();
-        if (in->eof())
+        if (nextChar == char_traits<char>::eof())
             return TokenEnd;
     }
     else if (tokenType == TokenEnd)
@@ -379,6 +400,99 @@ Tokenizer::TokenType Tokenizer::nextToken()
 }
 
 
+// Each record in a compiled token stream is a type byte followed by the
+// source line number, then a payload for names, strings and numbers.
+// TokenEnd is implied by the end of the buffer.
+Tokenizer::TokenType Tokenizer::nextReplayToken()
+{
+    if (replayPos >= replayLength)
+    {
+        tokenType = TokenEnd;
+        return tokenType;
+    }
+
+    auto type = (TokenType) (unsigned char) replayData[replayPos];
+    replayPos += 1;
+
+    uint32_t line = 0;
+    if (replayPos + sizeof(line) > replayLength)
+    {
+        syntaxError("Truncated compiled token stream");
+        tokenType = TokenError;
+        return tokenType;
+    }
+    memcpy(&line, replayData + replayPos, sizeof(line));
+    replayPos += sizeof(line);
+    lineNum = (int) line;
+
+    if (type == TokenNumber)
+    {
+        if (replayPos + sizeof(numberValue) > replayLength)
+        {
+            syntaxError("Truncated compiled token stream");
+            tokenType = TokenError;
+            return tokenType;
+        }
+        memcpy(&numberValue, replayData + replayPos, sizeof(numberValue));
+        replayPos += sizeof(numberValue);
+    }
+    else if (type == TokenName || type == TokenString)
+    {
+        uint32_t length = 0;
+        if (replayPos + sizeof(length) > replayLength)
+        {
+            syntaxError("Truncated compiled token stream");
+            tokenType = TokenError;
+            return tokenType;
+        }
+        memcpy(&length, replayData + replayPos, sizeof(length));
+        replayPos += sizeof(length);
+        if (replayPos + length > replayLength)
+        {
+            syntaxError("Truncated compiled token stream");
+            tokenType = TokenError;
+            return tokenType;
+        }
+        textToken.assign(replayData + replayPos, length);
+        replayPos += length;
+    }
+
+    tokenType = type;
+    return tokenType;
+}
+
+
+bool Tokenizer::compile(const std::string& text, std::string& out)
+{
+    Tokenizer tokenizer(text);
+
+    for (;;)
+    {
+        TokenType type = tokenizer.nextToken();
+        if (type == TokenError)
+            return false;
+        if (type == TokenEnd)
+            return true;
+
+        out.push_back((char) type);
+        auto line = (uint32_t) tokenizer.getLineNumber();
+        out.append((const char*) &line, sizeof(line));
+
+        if (type == TokenNumber)
+        {
+            double value = tokenizer.numberValue;
+            out.append((const char*) &value, sizeof(value));
+        }
+        else if (type == TokenName || type == TokenString)
+        {
+            auto length = (uint32_t) tokenizer.textToken.size();
+            out.append((const char*) &length, sizeof(length));
+            out.append(tokenizer.textToken.data(), length);
+        }
+    }
+}
+
+
 Tokenizer::TokenType Tokenizer::getTokenType()
 {
     return tokenType;
@@ -397,13 +511,13 @@ double Tokenizer::getNumberValue()
 }
 
 
-string Tokenizer::getNameValue()
+const string& Tokenizer::getNameValue()
 {
     return textToken;
 }
 
 
-string Tokenizer::getStringValue()
+const string& Tokenizer::getStringValue()
 {
     return textToken;
 }
@@ -411,7 +525,11 @@ string Tokenizer::getStringValue()
 
 int Tokenizer::readChar()
 {
-    auto c = (int) in->get();
+    int c;
+    if (textData != nullptr)
+        c = textPos < textLength ? (int) (unsigned char) textData[textPos++] : char_traits<char>::eof();
+    else
+        c = (int) in->get();
     if (c == '\n')
         lineNum++;
 
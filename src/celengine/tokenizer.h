@@ -41,12 +41,26 @@ public:
 
     Tokenizer(istream*);
 
+    //! Scan directly over in-memory text, avoiding a stream read per
+    //! character. The text must remain valid for the lifetime of the
+    //! tokenizer.
+    Tokenizer(const std::string& text);
+
+    //! Replay a compiled token stream produced by compile(). The buffer
+    //! must remain valid for the lifetime of the tokenizer.
+    Tokenizer(const char* compiledTokens, size_t length);
+
+    //! Tokenize text into a compact buffer that can be replayed later
+    //! without rescanning it. Returns false if the text contains a
+    //! syntax error.
+    static bool compile(const std::string& text, std::string& out);
+
     TokenType nextToken();
     TokenType getTokenType();
     void pushBack();
     double getNumberValue();
-    string getNameValue();
-    string getStringValue();
+    const string& getNameValue();
+    const string& getStringValue();
 
     int getLineNumber() const;
 
@@ -82,6 +96,17 @@ private:
 
     int readChar();
     void syntaxError(const char*);
+    TokenType nextReplayToken();
+
+    // In-memory text to scan instead of reading from the input stream
+    const char* textData{ nullptr };
+    size_t textLength{ 0 };
+    size_t textPos{ 0 };
+
+    // Compiled token stream to replay instead of scanning the input
+    const char* replayData{ nullptr };
+    size_t replayLength{ 0 };
+    size_t replayPos{ 0 };
 
     double numberValue{ 0.0 };
 
@@ -15,6 +15,8 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <chrono>
+#include <system_error>
 #include <celutil/debug.h>
 
 using namespace std;
@@ -25,6 +27,26 @@ static TrajectoryManager* trajectoryManager = nullptr;
 constexpr const fs::path::value_type UniqueSuffixChar = '!';
 
 
+// Mix the uniquifying suffix into a content hash, so trajectories that
+// share a source file but differ in interpolation or precision never
+// alias to one Orbit.
+static uint64_t foldUniquifyingSuffix(uint64_t hash, const fs::path::string_type& resolvedName)
+{
+    if (hash == 0)
+        return 0;
+
+    fs::path::string_type::size_type suffixStart = resolvedName.rfind(UniqueSuffixChar);
+    for (fs::path::string_type::size_type i = suffixStart;
+         i != fs::path::string_type::npos && i < resolvedName.size(); i++)
+    {
+        hash ^= (unsigned char) resolvedName[i];
+        hash *= UINT64_C(1099511628211);
+    }
+
+    return hash != 0 ? hash : 1;
+}
+
+
 TrajectoryManager* GetTrajectoryManager()
 {
     if (trajectoryManager == nullptr)
@@ -101,3 +123,67 @@ Orbit* TrajectoryInfo::load(const fs::path& filename)
 
     return sampTrajectory;
 }
+
+
+void TrajectoryInfo::beginLoad(const fs::path& filename)
+{
+    // The info object may move when the manager's resource table grows,
+    // so the worker operates on a private copy.
+    TrajectoryInfo request(source, path, interpolation, precision);
+    loadFuture = make_shared<future<pair<Orbit*, uint64_t>>>(
+        async(launch::async,
+              [request, filename]() mutable
+              {
+                  Orbit* trajectory = request.load(filename);
+
+                  // Hash the source file here so the manager can alias
+                  // byte-identical trajectories without reading the file
+                  // on the calling thread.
+                  string::size_type uniquifyingSuffixStart = filename.string().rfind(UniqueSuffixChar);
+                  fs::path strippedFilename = filename.string().substr(0, uniquifyingSuffixStart);
+                  uint64_t hash = foldUniquifyingSuffix(TrajectoryInfo::hashFileContents(strippedFilename),
+                                                        filename.native());
+
+                  return make_pair(trajectory, hash);
+              }));
+}
+
+
+bool TrajectoryInfo::tryFinishLoad(Orbit*& res)
+{
+    res = nullptr;
+    if (loadFuture == nullptr)
+        return false;
+    if (loadFuture->wait_for(chrono::seconds(0)) != future_status::ready)
+        return false;
+
+    pair<Orbit*, uint64_t> result = loadFuture->get();
+    res = result.first;
+    contentHash = result.second;
+    loadFuture.reset();
+    return true;
+}
+
+
+void TrajectoryInfo::waitLoad()
+{
+    if (loadFuture != nullptr)
+        loadFuture->wait();
+}
+
+
+uintmax_t TrajectoryInfo::resourceSize() const
+{
+    if (resource == nullptr)
+        return 0;
+
+    // Use the trajectory file size as a proxy for the in-memory
+    // footprint; the sample arrays dominate both.
+    fs::path::string_type::size_type uniquifyingSuffixStart = resolvedName.native().rfind(UniqueSuffixChar);
+    fs::path strippedFilename = resolvedName.native().substr(0, uniquifyingSuffixStart);
+
+    std::error_code ec;
+    uintmax_t size = fs::file_size(strippedFilename, ec);
+
+    return ec ? 0 : size;
+}
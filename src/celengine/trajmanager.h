@@ -14,6 +14,9 @@
 #include <celephem/samporbit.h>
 #include <string>
 #include <map>
+#include <memory>
+#include <future>
+#include <utility>
 #include <celutil/resmanager.h>
 
 
@@ -33,6 +36,21 @@ class TrajectoryInfo : public ResourceInfo<Orbit>
 
     fs::path resolve(const fs::path&) override;
     Orbit* load(const fs::path&) override;
+    std::uintmax_t resourceSize() const override;
+
+    // Sampled trajectories are parsed on a background thread. The
+    // solar system loader prefetches every trajectory named in a
+    // catalog before it builds timelines, then fetches the results,
+    // so parsing overlaps with the rest of catalog loading.
+    bool loadsAsynchronously() const override { return true; }
+    void beginLoad(const fs::path&) override;
+    bool tryFinishLoad(Orbit*&) override;
+    void waitLoad() override;
+
+ private:
+    //! In-flight background load of the orbit and its content hash;
+    //! shared so copies of this info track it
+    std::shared_ptr<std::future<std::pair<Orbit*, uint64_t>>> loadFuture;
 };
 
 // Sort trajectory info records. The same trajectory can be loaded multiple times with
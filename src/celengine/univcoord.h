@@ -15,6 +15,7 @@
 #ifndef _CELENGINE_UNIVCOORD_H_
 #define _CELENGINE_UNIVCOORD_H_
 
+#include <cstddef>
 #include <celutil/bigfix.h>
 #include "astro.h"
 #include <Eigen/Core>
@@ -74,6 +75,24 @@ class UniversalCoord
         return Eigen::Vector3d((double) (x - uc.x), (double) (y - uc.y), (double) (z - uc.z)) * astro::microLightYearsToKilometers(1.0);
     }
 
+    /** Convert a contiguous run of coordinates to kilometer offsets
+      * from a common origin. The differences keep full BigFix
+      * precision; doing the conversion in one tight loop lets the
+      * compiler keep the scale factor and origin words in registers,
+      * which matters when reducing thousands of positions at once.
+      */
+    static void offsetsFromKm(const UniversalCoord* coords, std::size_t count,
+                              const UniversalCoord& origin, Eigen::Vector3d* out)
+    {
+        const double scale = astro::microLightYearsToKilometers(1.0);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            out[i] = Eigen::Vector3d((double) (coords[i].x - origin.x),
+                                     (double) (coords[i].y - origin.y),
+                                     (double) (coords[i].z - origin.z)) * scale;
+        }
+    }
+
     /** Get the offset in light years of this coordinate from a point (also with
       * units of light years.) The difference is calculated at high precision and
       * the reduced to single precision.
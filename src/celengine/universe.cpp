@@ -21,7 +21,13 @@
 #include <celmath/mathlib.h>
 #include <celmath/intersect.h>
 #include <celutil/utf8.h>
+#include <celutil/debug.h>
+#include <celutil/filetype.h>
 #include <cassert>
+#include <fstream>
+#include <algorithm>
+#include <future>
+#include <thread>
 
 static const double ANGULAR_RES = 3.5e-6;
 
@@ -95,6 +101,42 @@ void Universe::setBoundaries(ConstellationBoundaries* _boundaries)
     boundaries = _boundaries;
 }
 
+bool Universe::loadCatalog(const fs::path& path)
+{
+    ContentType type = DetermineFileType(path);
+
+    if (type == Content_CelestiaCatalog)
+    {
+        ifstream in(path.string(), ios::in);
+        if (!in.good())
+            return false;
+        return LoadSolarSystemObjects(in, *this, path.parent_path());
+    }
+
+    if (type == Content_CelestiaDeepSkyCatalog)
+    {
+        if (dsoCatalog == nullptr)
+            return false;
+        ifstream in(path.string(), ios::in);
+        if (!in.good())
+            return false;
+        bool ok = dsoCatalog->load(in, path.parent_path());
+        dsoCatalog->rebuild();
+        return ok;
+    }
+
+    if (type == Content_CelestiaStarCatalog)
+    {
+        DPRINTF(LOG_LEVEL_ERROR,
+                "Star catalogs cannot be loaded into a running universe: %s\n",
+                path.string());
+        return false;
+    }
+
+    DPRINTF(LOG_LEVEL_ERROR, "Unrecognized catalog file: %s\n", path.string());
+    return false;
+}
+
 // Return the planetary system of a star, or nullptr if it has no planets.
 SolarSystem* Universe::getSolarSystem(const Star* star) const
 {
@@ -165,21 +207,155 @@ MarkerList* Universe::getMarkers() const
 }
 
 
+const Universe::MarkerGrid& Universe::getStaticMarkerGrid() const
+{
+    return markerGrid;
+}
+
+
+const std::vector<uint32_t>& Universe::getDynamicMarkerIndices() const
+{
+    return dynamicMarkerIndices;
+}
+
+
+// A star octree node at depth 22 is about 240 light years across.
+const double Universe::MarkerCellSize = 1.0e9 / 4194304.0;
+const double Universe::MarkerCellRadius = Universe::MarkerCellSize * 0.5 * 1.7320508 + 1.0;
+
+static const uint32_t InvalidMarkerIndex = ~0u;
+
+
+// Markers on stars and deep sky objects are bucketed by position;
+// everything else (bodies, locations) moves with time and is culled
+// individually.
+static bool markerHasFixedPosition(const Selection& sel)
+{
+    return sel.star() != nullptr || sel.deepsky() != nullptr;
+}
+
+
+static Vector3d markerPositionLy(const Selection& sel)
+{
+    if (sel.star() != nullptr)
+        return sel.star()->getPosition().cast<double>();
+    return sel.deepsky()->getPosition();
+}
+
+
+static Universe::MarkerGrid::key_type markerCellIndex(const Vector3d& p)
+{
+    return std::make_tuple((int) std::floor(p.x() / Universe::MarkerCellSize),
+                           (int) std::floor(p.y() / Universe::MarkerCellSize),
+                           (int) std::floor(p.z() / Universe::MarkerCellSize));
+}
+
+
+//! Locate the marker for a selection, confining the search to a single
+//! grid cell for fixed-position objects. Returns InvalidMarkerIndex if
+//! the selection is unmarked.
+uint32_t Universe::findMarkerIndex(const Selection& sel) const
+{
+    const std::vector<uint32_t>* bucket = &dynamicMarkerIndices;
+    if (markerHasFixedPosition(sel))
+    {
+        auto iter = markerGrid.find(markerCellIndex(markerPositionLy(sel)));
+        if (iter == markerGrid.end())
+            return InvalidMarkerIndex;
+        bucket = &iter->second.markerIndices;
+    }
+
+    for (uint32_t index : *bucket)
+    {
+        if ((*markers)[index].object() == sel)
+            return index;
+    }
+
+    return InvalidMarkerIndex;
+}
+
+
+void Universe::addMarkerToIndex(uint32_t index)
+{
+    const Selection sel = (*markers)[index].object();
+    if (markerHasFixedPosition(sel))
+    {
+        auto key = markerCellIndex(markerPositionLy(sel));
+        MarkerCell& cell = markerGrid[key];
+        if (cell.markerIndices.empty())
+        {
+            cell.center = Vector3d((std::get<0>(key) + 0.5) * MarkerCellSize,
+                                   (std::get<1>(key) + 0.5) * MarkerCellSize,
+                                   (std::get<2>(key) + 0.5) * MarkerCellSize);
+        }
+        cell.markerIndices.push_back(index);
+    }
+    else
+    {
+        dynamicMarkerIndices.push_back(index);
+    }
+}
+
+
+void Universe::removeMarkerFromIndex(uint32_t index)
+{
+    const Selection sel = (*markers)[index].object();
+    if (markerHasFixedPosition(sel))
+    {
+        auto iter = markerGrid.find(markerCellIndex(markerPositionLy(sel)));
+        if (iter == markerGrid.end())
+            return;
+        std::vector<uint32_t>& bucket = iter->second.markerIndices;
+        bucket.erase(std::remove(bucket.begin(), bucket.end(), index), bucket.end());
+        if (bucket.empty())
+            markerGrid.erase(iter);
+    }
+    else
+    {
+        dynamicMarkerIndices.erase(std::remove(dynamicMarkerIndices.begin(),
+                                               dynamicMarkerIndices.end(),
+                                               index),
+                                   dynamicMarkerIndices.end());
+    }
+}
+
+
+//! Remove the marker at the given index. The last marker is moved into
+//! the vacated slot so only its index entry needs updating; marker
+//! order is not significant.
+void Universe::removeMarkerAt(uint32_t index)
+{
+    removeMarkerFromIndex(index);
+
+    uint32_t last = (uint32_t) markers->size() - 1;
+    if (index != last)
+    {
+        removeMarkerFromIndex(last);
+        (*markers)[index] = (*markers)[last];
+        markers->pop_back();
+        addMarkerToIndex(index);
+    }
+    else
+    {
+        markers->pop_back();
+    }
+}
+
+
 void Universe::markObject(const Selection& sel,
                           const MarkerRepresentation& rep,
                           int priority,
                           bool occludable,
                           MarkerSizing sizing)
 {
-    auto iter = std::find_if(markers->begin(), markers->end(),
-                             [&sel](Marker& m) { return m.object() == sel; });
-    if (iter != markers->end())
+    uint32_t existing = findMarkerIndex(sel);
+    if (existing != InvalidMarkerIndex)
     {
         // Handle the case when the object is already marked.  If the
         // priority is higher or equal to the existing marker, replace it.
         // Otherwise, do nothing.
-        if (priority >= iter->priority())
-            markers->erase(iter);
+        if (priority >= (*markers)[existing].priority())
+            removeMarkerAt(existing);
         else
             return;
     }
@@ -190,30 +366,31 @@ void Universe::markObject(const Selection& sel,
     marker.setOccludable(occludable);
     marker.setSizing(sizing);
     markers->push_back(marker);
+    addMarkerToIndex((uint32_t) markers->size() - 1);
 }
 
 
 void Universe::unmarkObject(const Selection& sel, int priority)
 {
-    auto iter = std::find_if(markers->begin(), markers->end(),
-                            [&sel](Marker& m) { return m.object() == sel; });
-    if (iter != markers->end() && priority >= iter->priority())
-        markers->erase(iter);
+    uint32_t index = findMarkerIndex(sel);
+    if (index != InvalidMarkerIndex && priority >= (*markers)[index].priority())
+        removeMarkerAt(index);
 }
 
 
 void Universe::unmarkAll()
 {
-    markers->erase(markers->begin(), markers->end());
+    markers->clear();
+    markerGrid.clear();
+    dynamicMarkerIndices.clear();
 }
 
 
 bool Universe::isMarked(const Selection& sel, int priority) const
 {
-    auto iter = std::find_if(markers->begin(), markers->end(),
-                             [&sel](Marker& m) { return m.object() == sel; });
-    if (iter != markers->end())
-        return iter->priority() >= priority;
+    uint32_t index = findMarkerIndex(sel);
+    if (index != InvalidMarkerIndex)
+        return (*markers)[index].priority() >= priority;
 
     return false;
 }
@@ -296,15 +473,30 @@ struct PlanetPickInfo
 };
 
 
-static bool ApproxPlanetPickTraversal(Body* body, void* info)
+// Bodies eligible for picking in one system, with the filter
+// conditions (visible, extant, clickable) applied during a single
+// frame tree traversal. The pick passes below run over this list with
+// each body's astrocentric position evaluated exactly once; the old
+// code repeated the full ephemeris chain on every traversal.
+struct PlanetPickCandidates
+{
+    std::vector<Body*> bodies;
+    double jd;
+};
+
+
+static bool CollectPlanetPickCandidates(Body* body, void* info)
 {
-    auto* pickInfo = (PlanetPickInfo*) info;
+    auto* candidates = (PlanetPickCandidates*) info;
+    if (body->isVisible() && body->extant(candidates->jd) && body->isClickable())
+        candidates->bodies.push_back(body);
+
+    return true;
+}
 
-    // Reject invisible bodies and bodies that don't exist at the current time
-    if (!body->isVisible() || !body->extant(pickInfo->jd) || !body->isClickable())
-        return true;
 
-    Vector3d bpos = body->getAstrocentricPosition(pickInfo->jd);
+static void ApproxPlanetPickTest(Body* body, const Vector3d& bpos, PlanetPickInfo* pickInfo)
+{
     Vector3d bodyDir = bpos - pickInfo->pickRay.origin;
     double distance = bodyDir.norm();
 
@@ -315,7 +507,7 @@ static bool ApproxPlanetPickTraversal(Body* body, void* info)
 
     if (std::max((double) pickInfo->atanTolerance, ANGULAR_RES) > appOrbitRadius)
     {
-        return true;
+        return;
     }
 
     bodyDir.normalize();
@@ -328,24 +520,17 @@ static bool ApproxPlanetPickTraversal(Body* body, void* info)
         pickInfo->closestBody = body;
         pickInfo->closestApproxDistance = distance;
     }
-
-    return true;
 }
 
 
 // Perform an intersection test between the pick ray and a body
-static bool ExactPlanetPickTraversal(Body* body, void* info)
+static void ExactPlanetPickTest(Body* body, const Vector3d& bpos, PlanetPickInfo* pickInfo)
 {
-    auto* pickInfo = reinterpret_cast<PlanetPickInfo*>(info);
-    Vector3d bpos = body->getAstrocentricPosition(pickInfo->jd);
     float radius = body->getRadius();
     double distance = -1.0;
 
     // Test for intersection with the bounding sphere
-    if (body->isVisible() &&
-        body->extant(pickInfo->jd) &&
-        body->isClickable() &&
-        testIntersection(pickInfo->pickRay, Sphered(bpos, radius), distance))
+    if (testIntersection(pickInfo->pickRay, Sphered(bpos, radius), distance))
     {
         if (body->getGeometry() == InvalidResource)
         {
@@ -406,8 +591,6 @@ static bool ExactPlanetPickTraversal(Body* body, void* info)
             pickInfo->closestBody = body;
         }
     }
-
-    return true;
 }
 
 // Recursively traverse a frame tree; call the specified callback function for each
@@ -467,9 +650,23 @@ Selection Universe::pickPlanet(SolarSystem& solarSystem,
     pickInfo.jd = when;
     pickInfo.atanTolerance = (float) atan(tolerance);
 
+    // Gather the pickable bodies in a single traversal and evaluate
+    // each one's astrocentric position exactly once; both pick passes
+    // below read from this cache.
+    PlanetPickCandidates candidates;
+    candidates.jd = when;
+    traverseFrameTree(solarSystem.getFrameTree(), when, CollectPlanetPickCandidates, (void*) &candidates);
+
+    size_t nCandidates = candidates.bodies.size();
+    vector<Vector3d> positions;
+    positions.reserve(nCandidates);
+    for (Body* body : candidates.bodies)
+        positions.push_back(body->getAstrocentricPosition(when));
+
     // First see if there's a planet|moon that the pick ray intersects.
     // Select the closest planet|moon intersected.
-    traverseFrameTree(solarSystem.getFrameTree(), when, ExactPlanetPickTraversal, (void*) &pickInfo);
+    for (size_t i = 0; i < nCandidates; i++)
+        ExactPlanetPickTest(candidates.bodies[i], positions[i], &pickInfo);
 
     if (pickInfo.closestBody != nullptr)
     {
@@ -478,7 +675,8 @@ Selection Universe::pickPlanet(SolarSystem& solarSystem,
 
         // Check if there is a satellite in front of the primary body that is
         // sufficiently close to the pickRay
-        traverseFrameTree(solarSystem.getFrameTree(), when, ApproxPlanetPickTraversal, (void*) &pickInfo);
+        for (size_t i = 0; i < nCandidates; i++)
+            ApproxPlanetPickTest(candidates.bodies[i], positions[i], &pickInfo);
 
         if (pickInfo.closestBody == closestBody)
             return  Selection(closestBody);
@@ -500,7 +698,8 @@ Selection Universe::pickPlanet(SolarSystem& solarSystem,
     // clicks on a pixel where the planet's disc has been rendered--in order
     // to make distant planets visible on the screen at all, their apparent
     // size has to be greater than their actual disc size.
-    traverseFrameTree(solarSystem.getFrameTree(), when, ApproxPlanetPickTraversal, (void*) &pickInfo);
+    for (size_t i = 0; i < nCandidates; i++)
+        ApproxPlanetPickTest(candidates.bodies[i], positions[i], &pickInfo);
 
     if (pickInfo.sinAngle2Closest <= sinTol2)
         return Selection(pickInfo.closestBody);
@@ -1208,12 +1407,164 @@ SolarSystem* Universe::getNearestSolarSystem(const UniversalCoord& position) con
 }
 
 
+// Guard band around the requested radius when refilling the
+// neighborhood cache; the octree is only re-traversed after the
+// observer has moved this far from the cached center.
+static const float NearStarCacheMargin = 0.25f;
+
+void
+Universe::refillNearStarCache(const Vector3f& pos, float maxDistance) const
+{
+    vector<const Star*> previous;
+    previous.swap(nearStarCache);
+
+    NearStarFinder finder(maxDistance + NearStarCacheMargin, nearStarCache);
+    starCatalog->findCloseStars(finder, pos, maxDistance + NearStarCacheMargin);
+
+    // Resolve each star's solar system once per refill
+    nearStarCacheSystems.clear();
+    nearStarCacheSystems.reserve(nearStarCache.size());
+    for (const auto star : nearStarCache)
+        nearStarCacheSystems.push_back(getSolarSystem(star));
+
+    if (nearStarCache != previous)
+        nearStarGeneration++;
+
+    nearStarCacheCenter = pos;
+    nearStarCacheRadius = maxDistance + NearStarCacheMargin;
+    nearStarCacheCatalogSize = starCatalog->size();
+    nearStarCacheSystemCount = solarSystemCatalog->size();
+    nearStarCacheValid = true;
+}
+
+
 void
 Universe::getNearStars(const UniversalCoord& position,
                        float maxDistance,
                        vector<const Star*>& nearStars) const
 {
     Vector3f pos = position.toLy().cast<float>();
-    NearStarFinder finder(maxDistance, nearStars);
-    starCatalog->findCloseStars(finder, pos, maxDistance);
+
+    // The query sphere must fit inside the cached sphere; slack is how
+    // much room it has left. Catalog positions are fixed, so the cache
+    // only goes stale through motion or catalog growth.
+    float slack = nearStarCacheRadius - maxDistance - (pos - nearStarCacheCenter).norm();
+    if (!nearStarCacheValid ||
+        slack < 0.0f ||
+        starCatalog->size() != nearStarCacheCatalogSize)
+    {
+        refillNearStarCache(pos, maxDistance);
+    }
+
+    for (const auto star : nearStarCache)
+    {
+        if ((star->getPosition() - pos).norm() < maxDistance)
+            nearStars.push_back(star);
+    }
+}
+
+
+void
+Universe::getNearStars(const UniversalCoord& position,
+                       float maxDistance,
+                       vector<const Star*>& nearStars,
+                       vector<SolarSystem*>& systems) const
+{
+    Vector3f pos = position.toLy().cast<float>();
+
+    float slack = nearStarCacheRadius - maxDistance - (pos - nearStarCacheCenter).norm();
+    if (!nearStarCacheValid ||
+        slack < 0.0f ||
+        starCatalog->size() != nearStarCacheCatalogSize ||
+        solarSystemCatalog->size() != nearStarCacheSystemCount)
+    {
+        refillNearStarCache(pos, maxDistance);
+    }
+
+    for (size_t i = 0; i < nearStarCache.size(); i++)
+    {
+        if ((nearStarCache[i]->getPosition() - pos).norm() < maxDistance)
+        {
+            nearStars.push_back(nearStarCache[i]);
+            systems.push_back(nearStarCacheSystems[i]);
+        }
+    }
+}
+
+
+// Minimum batch size before computePositions() spreads the work over
+// multiple threads; below this the async overhead isn't worth it.
+static const size_t ParallelPositionsThreshold = 256;
+
+/*! Compute the orbital positions of many bodies at a single epoch in
+ *  one call, spreading the work across all cores. positions[i]
+ *  receives the position of bodies[i] within its own orbit frame at
+ *  tjd (the expensive part of a frame tree update); composing the
+ *  astrocentric position stays with the caller. Bodies without an
+ *  active orbit at tjd get a zero position.
+ *
+ *  Evaluating an orbit may update its internal caches, so bodies that
+ *  share an orbit object are kept on the same worker. Sorting the work
+ *  by orbit also groups bodies using the same orbit model together,
+ *  which keeps each worker inside one evaluation kernel (Kepler
+ *  solver, VSOP87 series, sampled trajectory) at a time instead of
+ *  bouncing between them.
+ */
+void
+Universe::computePositions(double tjd,
+                           const vector<Body*>& bodies,
+                           vector<Vector3d>& positions) const
+{
+    size_t nBodies = bodies.size();
+    positions.resize(nBodies);
+
+    vector<pair<const Orbit*, size_t> > work;
+    work.reserve(nBodies);
+    for (size_t i = 0; i < nBodies; i++)
+    {
+        const Orbit* orbit = bodies[i] != nullptr ? bodies[i]->getOrbit(tjd) : nullptr;
+        work.emplace_back(orbit, i);
+    }
+    sort(work.begin(), work.end());
+
+    auto evaluateRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const Orbit* orbit = work[i].first;
+            positions[work[i].second] = orbit != nullptr
+                ? orbit->positionAtTime(tjd)
+                : Vector3d::Zero();
+        }
+    };
+
+    if (nBodies < ParallelPositionsThreshold)
+    {
+        evaluateRange(0, nBodies);
+        return;
+    }
+
+    unsigned int nWorkers = max(2u, thread::hardware_concurrency());
+    size_t chunkSize = nBodies / nWorkers + 1;
+
+    vector<future<void> > workers;
+    workers.reserve(nWorkers);
+    size_t begin = 0;
+    while (begin < nBodies)
+    {
+        size_t end = min(begin + chunkSize, nBodies);
+        // Don't split a run of bodies sharing one orbit object across
+        // two workers.
+        while (end < nBodies && work[end].first == work[end - 1].first)
+            end++;
+
+        if (end < nBodies)
+            workers.push_back(async(launch::async, evaluateRange, begin, end));
+        else
+            evaluateRange(begin, end);
+        begin = end;
+    }
+
+    for (auto& worker : workers)
+        worker.get();
 }
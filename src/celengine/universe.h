@@ -19,6 +19,8 @@
 #include <celengine/marker.h>
 #include <celengine/selection.h>
 #include <celengine/asterism.h>
+#include <map>
+#include <tuple>
 #include <vector>
 
 
@@ -45,6 +47,14 @@ class Universe
     ConstellationBoundaries* getBoundaries() const;
     void setBoundaries(ConstellationBoundaries*);
 
+    //! Load a catalog file into the running universe without a restart.
+    //! ssc files apply incrementally by design; dsc files are loaded and
+    //! the DSO octree and indexes are rebuilt, which leaves existing
+    //! DeepSkyObject pointers valid. stc files are rejected: rebuilding
+    //! the star octree relocates the Star objects that solar systems,
+    //! frames and observers point into.
+    bool loadCatalog(const fs::path& path);
+
     Selection pick(const UniversalCoord& origin,
                    const Eigen::Vector3f& direction,
                    double when,
@@ -87,6 +97,25 @@ class Universe
                       float maxDistance,
                       std::vector<const Star*>& stars) const;
 
+    //! Near-star query that also reports each star's solar system (or
+    //! nullptr), resolved once per neighborhood cache refill instead
+    //! of through a catalog lookup per frame.
+    void getNearStars(const UniversalCoord& position,
+                      float maxDistance,
+                      std::vector<const Star*>& stars,
+                      std::vector<SolarSystem*>& systems) const;
+
+    /*! Generation counter for the near-star neighborhood; it advances
+     *  only when the membership of the cached set changes, so callers
+     *  holding state derived from the set of nearby systems can
+     *  compare generations instead of diffing the lists each frame.
+     */
+    uint32_t getNearStarGeneration() const { return nearStarGeneration; }
+
+    void computePositions(double tjd,
+                          const std::vector<Body*>& bodies,
+                          std::vector<Eigen::Vector3d>& positions) const;
+
     void markObject(const Selection&,
                     const MarkerRepresentation& rep,
                     int priority,
@@ -97,6 +126,32 @@ class Universe
     bool isMarked(const Selection&, int priority) const;
     MarkerList* getMarkers() const;
 
+    /*! A cell of the static marker grid. Markers on stars and deep sky
+     *  objects have (nearly) fixed positions, so they are bucketed into
+     *  cubic cells the size of a star octree node at a fixed depth. The
+     *  renderer culls whole cells against the view cone before
+     *  transforming any individual marker, and mark/unmark lookups for
+     *  fixed objects search a single cell instead of the whole list.
+     */
+    struct MarkerCell
+    {
+        Eigen::Vector3d center;                // cell center, light years
+        std::vector<uint32_t> markerIndices;   // indices into the marker list
+    };
+    typedef std::map<std::tuple<int, int, int>, MarkerCell> MarkerGrid;
+
+    //! Edge length of a static marker grid cell in light years; the
+    //! cells coincide with star octree nodes at depth 22.
+    static const double MarkerCellSize;
+    //! Bounding radius of a cell: half the cell diagonal plus slack for
+    //! stars that orbit a barycenter away from their catalog position.
+    static const double MarkerCellRadius;
+
+    const MarkerGrid& getStaticMarkerGrid() const;
+    //! Indices of markers on objects whose position is time dependent
+    //! (bodies, locations); these are culled individually each frame.
+    const std::vector<uint32_t>& getDynamicMarkerIndices() const;
+
  private:
     Selection pickPlanet(SolarSystem& solarSystem,
                          const UniversalCoord& origin,
@@ -125,6 +180,33 @@ class Universe
     ConstellationBoundaries* boundaries{nullptr};
     MarkerList* markers;
 
+    // Spatial index over the marker list, maintained incrementally by
+    // markObject/unmarkObject. Entries for fixed-position objects live
+    // in grid cells; the rest are listed in dynamicMarkerIndices.
+    MarkerGrid markerGrid;
+    std::vector<uint32_t> dynamicMarkerIndices;
+
+    uint32_t findMarkerIndex(const Selection&) const;
+    void addMarkerToIndex(uint32_t index);
+    void removeMarkerFromIndex(uint32_t index);
+    void removeMarkerAt(uint32_t index);
+
+    // Neighborhood cache for getNearStars: every star within
+    // nearStarCacheRadius light years of nearStarCacheCenter, in
+    // octree traversal order. Queries whose sphere fits inside the
+    // cached sphere are answered by scanning this (typically tiny)
+    // list instead of traversing the octree.
+    mutable std::vector<const Star*> nearStarCache;
+    mutable std::vector<SolarSystem*> nearStarCacheSystems;
+    mutable Eigen::Vector3f nearStarCacheCenter{ Eigen::Vector3f::Zero() };
+    mutable float nearStarCacheRadius{ 0.0f };
+    mutable uint32_t nearStarCacheCatalogSize{ 0 };
+    mutable std::size_t nearStarCacheSystemCount{ 0 };
+    mutable uint32_t nearStarGeneration{ 0 };
+    mutable bool nearStarCacheValid{ false };
+
+    void refillNearStarCache(const Eigen::Vector3f& pos, float maxDistance) const;
+
     std::vector<const Star*> closeStars;
 };
 
@@ -9,6 +9,7 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include "glstats.h"
 #include "vertexobject.h"
 
 namespace celgl
@@ -29,9 +30,16 @@ VertexObject::~VertexObject()
 {
     delete m_attribParams;
 
+    for (auto& fence : m_fences)
+    {
+        if (fence != nullptr)
+            glDeleteSync(fence);
+    }
+
     if (GLEW_ARB_vertex_array_object)
         glDeleteVertexArrays(1, &m_vaoId);
 
+    // Deleting the buffer implicitly unmaps a persistent mapping.
     glDeleteBuffers(1, &m_vboId);
 }
 
@@ -88,6 +96,7 @@ void VertexObject::unbind() noexcept
 bool VertexObject::allocate(const void* data) noexcept
 {
     glBufferData(m_bufferType, m_bufferSize, data, m_streamType);
+    GLStats::addBufferUpload(m_bufferSize);
     return glGetError() != GL_NO_ERROR;
 }
 
@@ -108,15 +117,74 @@ bool VertexObject::allocate(GLenum bufferType, GLsizeiptr bufferSize, const void
 bool VertexObject::setBufferData(const void* data, GLintptr offset, GLsizeiptr size) noexcept
 {
     glBufferSubData(m_bufferType, offset, size == 0 ? m_bufferSize : size, data);
+    GLStats::addBufferUpload(size == 0 ? m_bufferSize : size);
     return glGetError() != GL_NO_ERROR;
 }
 
+/*! Allocate an immutable buffer of StreamRegions * regionSize bytes and
+ *  map it persistently, putting the object into streaming mode: callers
+ *  write vertex data for each use directly into the region returned by
+ *  beginStreamRegion() with no driver copy, and rotate through the
+ *  regions so the CPU never writes memory the GPU is still reading.
+ *  Returns true on failure (the same convention as allocate()), e.g.
+ *  when ARB_buffer_storage is unavailable; callers should then fall
+ *  back to allocate()/setBufferData() streaming.
+ */
+bool VertexObject::allocateStream(GLsizeiptr regionSize) noexcept
+{
+    if (!GLEW_ARB_buffer_storage || !GLEW_ARB_sync)
+        return true;
+
+    const GLbitfield storageFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    m_regionSize = regionSize;
+    m_bufferSize = regionSize * StreamRegions;
+    glBufferStorage(m_bufferType, m_bufferSize, nullptr, storageFlags);
+    m_mappedPtr = glMapBufferRange(m_bufferType, 0, m_bufferSize, storageFlags);
+    return m_mappedPtr == nullptr || glGetError() != GL_NO_ERROR;
+}
+
+/*! Advance to the next stream region and return a write pointer to it,
+ *  waiting on the region's fence in the rare case the GPU is still
+ *  reading it. Returns nullptr when the object isn't in streaming mode.
+ */
+void* VertexObject::beginStreamRegion() noexcept
+{
+    if (m_mappedPtr == nullptr)
+        return nullptr;
+
+    m_currentRegion = (m_currentRegion + 1) % StreamRegions;
+
+    GLsync& fence = m_fences[m_currentRegion];
+    if (fence != nullptr)
+    {
+        // With triple buffering this fence is nearly always signaled
+        // already; the timeout only guards against a wedged driver.
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 0.1 sec
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    return reinterpret_cast<char*>(m_mappedPtr) + m_currentRegion * m_regionSize;
+}
+
+/*! Place a fence after the draw calls that read the current stream
+ *  region; beginStreamRegion() waits on it before handing the region
+ *  out for writing again.
+ */
+void VertexObject::endStreamRegion() noexcept
+{
+    if (m_mappedPtr != nullptr)
+        m_fences[m_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
 void VertexObject::draw(GLenum primitive, GLsizei count, GLint first) noexcept
 {
     if ((m_state & State::Initialize) != 0)
         enableAttribArrays();
 
     glDrawArrays(primitive, first, count);
+    GLStats::addDrawCall();
 }
 
 void VertexObject::enableAttribArrays() noexcept
@@ -38,6 +38,9 @@ class VertexObject
     bool allocate(GLsizeiptr bufferSize, const void* data = nullptr) noexcept;
     bool allocate(GLenum bufferType, GLsizeiptr bufferSize, const void* data, GLenum streamType) noexcept;
     bool setBufferData(const void* data, GLintptr offset = 0, GLsizeiptr size = 0) noexcept;
+    bool allocateStream(GLsizeiptr regionSize) noexcept;
+    void* beginStreamRegion() noexcept;
+    void endStreamRegion() noexcept;
     void setVertices(GLint count, GLenum type, bool normalized = false, GLsizei stride = 0, GLsizeiptr offset = 0) noexcept;
     void setNormals(GLint count, GLenum type, bool normalized = false, GLsizei stride = 0, GLsizeiptr offset = 0) noexcept;
     void setColors(GLint count, GLenum type, bool normalized = false, GLsizei stride = 0, GLsizeiptr offset = 0) noexcept;
@@ -55,6 +58,23 @@ class VertexObject
     void setBufferSize(GLsizeiptr bufferSize) noexcept { m_bufferSize = bufferSize; }
     void setStreamType(GLenum streamType) noexcept     { m_streamType = streamType; }
 
+    inline bool isStreaming() const noexcept
+    {
+        return m_mappedPtr != nullptr;
+    }
+    inline unsigned int streamRegionIndex() const noexcept
+    {
+        return m_currentRegion;
+    }
+    inline GLsizeiptr streamRegionOffset() const noexcept
+    {
+        return m_currentRegion * m_regionSize;
+    }
+
+    // Number of rotating regions in a streaming buffer; three keeps the
+    // CPU a frame ahead of the GPU without fence waits in practice.
+    static const unsigned int StreamRegions = 3;
+
  private:
     enum AttrType : uint16_t
     {
@@ -96,6 +116,13 @@ class VertexObject
     GLsizeiptr m_bufferSize{ 0 };
     GLenum     m_bufferType{ 0 };
     GLenum     m_streamType{ 0 };
+
+    // Persistent-mapped streaming state; see allocateStream().
+    void*      m_mappedPtr{ nullptr };
+    GLsizeiptr m_regionSize{ 0 };
+    unsigned int m_currentRegion{ 0 };
+    GLsync     m_fences[StreamRegions]{};
+
     std::array<PtrParams, 8> m_params {};
     std::map<GLint, PtrParams>* m_attribParams{ nullptr };
 };
@@ -7,17 +7,25 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <utility>
+#include <vector>
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(_M_AMD64) || defined(_M_X64)
+#define VIRTUALTEX_SSE2 1
+#include <emmintrin.h>
+#endif
 #include <celutil/debug.h>
 #include <GL/glew.h>
 #include <celutil/debug.h>
 #include <celcompat/filesystem.h>
+#include <celutil/asyncfile.h>
 #include <celutil/filetype.h>
 #include "parser.h"
 #include "virtualtex.h"
@@ -27,6 +35,101 @@ using namespace std;
 
 static const int MaxResolutionLevels = 13;
 
+// Tile prefetching: how far ahead of the observed footprint motion to
+// request tiles (in frames; roughly one to two seconds at typical frame
+// rates), how many decoded tiles to keep waiting for consumption, and
+// how many new requests to issue per frame.
+static const int PrefetchLeadFrames = 60;
+static const unsigned int PrefetchCacheTiles = 32;
+static const unsigned int PrefetchMaxRequestsPerFrame = 8;
+
+// Tile decoding is embarrassingly parallel, so a pool of threads works
+// the prefetch queue; capped because image decode is partly I/O bound.
+static const unsigned int MaxPrefetchThreads = 8;
+
+
+static uint64_t TileKey(unsigned int lod, unsigned int u, unsigned int v)
+{
+    return ((uint64_t) lod << 32) | ((uint64_t) v << 16) | (uint64_t) u;
+}
+
+
+// Registry of live virtual textures so the debug HUD can enumerate
+// them. Virtual textures are created and destroyed on the main thread,
+// but guard the list anyway; it's not on any hot path.
+static vector<VirtualTexture*> vtRegistry;
+static mutex vtRegistryMutex;
+
+
+// Box filter one output row: average the two source rows byte-wise
+// (SSE2 when available; components interleave transparently since the
+// filter is per-byte), then collapse horizontal pixel pairs.
+static void BoxFilterRows(const unsigned char* row0, const unsigned char* row1,
+                          int srcW, int components,
+                          unsigned char* tmp, unsigned char* dst)
+{
+    int rowBytes = srcW * components;
+    int x = 0;
+
+#ifdef VIRTUALTEX_SSE2
+    for (; x + 16 <= rowBytes; x += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(tmp + x), _mm_avg_epu8(a, b));
+    }
+#endif
+    for (; x < rowBytes; x++)
+        tmp[x] = (unsigned char) (((int) row0[x] + (int) row1[x] + 1) >> 1);
+
+    int dstW = max(srcW >> 1, 1);
+    for (int i = 0; i < dstW; i++)
+    {
+        const unsigned char* p0 = tmp + (i * 2) * components;
+        const unsigned char* p1 = srcW > 1 ? p0 + components : p0;
+        for (int c = 0; c < components; c++)
+            dst[i * components + c] =
+                (unsigned char) (((int) p0[c] + (int) p1[c] + 1) >> 1);
+    }
+}
+
+
+// Build the complete mipmap chain for an uncompressed image with box
+// filtering. Because the chain is complete, ImageTexture later uploads
+// it with LoadMipmapSet instead of running gluBuild2DMipmaps on the
+// main thread.
+static Image* BuildMipChain(Image& src)
+{
+    int levels = 1;
+    for (int w = src.getWidth(), h = src.getHeight(); w > 1 || h > 1; w >>= 1, h >>= 1)
+        levels++;
+
+    Image* img = new Image(src.getFormat(),
+                           src.getWidth(), src.getHeight(),
+                           levels);
+    memcpy(img->getMipLevel(0), src.getPixels(), src.getMipLevelSize(0));
+
+    int components = src.getComponents();
+    vector<unsigned char> tmp(src.getWidth() * components);
+
+    for (int mip = 1; mip < levels; mip++)
+    {
+        int srcW = max(src.getWidth() >> (mip - 1), 1);
+        int srcH = max(src.getHeight() >> (mip - 1), 1);
+        int dstH = max(srcH >> 1, 1);
+
+        for (int y = 0; y < dstH; y++)
+        {
+            const unsigned char* r0 = img->getPixelRow(mip - 1, min(y * 2, srcH - 1));
+            const unsigned char* r1 = img->getPixelRow(mip - 1, min(y * 2 + 1, srcH - 1));
+            BoxFilterRows(r0, r1, srcW, components, tmp.data(),
+                          img->getPixelRow(mip, y));
+        }
+    }
+
+    return img;
+}
+
 
 // Virtual textures are composed of tiles that are loaded from the hard drive
 // as they become visible.  Hidden tiles may be evicted from graphics memory
@@ -76,28 +179,51 @@ VirtualTexture::VirtualTexture(const fs::path& _tilePath,
 
     if (DetermineFileType(tileExt) == Content_DXT5NormalMap)
         setFormatOptions(Texture::DXT5NormalMap);
+
+    statResidentPerLevel.resize(MaxResolutionLevels, 0);
+
+    {
+        lock_guard<mutex> lock(vtRegistryMutex);
+        vtRegistry.push_back(this);
+    }
+    GetMemoryAudit().registerReporter(this);
 }
 
 
-const TextureTile VirtualTexture::getTile(int lod, int u, int v)
+VirtualTexture::~VirtualTexture()
 {
-    tilesRequested++;
-#if 0
-    cout << "getTile(" << lod << ", " << u << ", " << v << ")\n";
-#endif
+    GetMemoryAudit().unregisterReporter(this);
 
-    lod += baseSplit;
+    {
+        lock_guard<mutex> lock(vtRegistryMutex);
+        vtRegistry.erase(remove(vtRegistry.begin(), vtRegistry.end(), this),
+                         vtRegistry.end());
+    }
 
-    if (lod < 0 || (unsigned int) lod >= nResolutionLevels ||
-        u < 0 || u >= (2 << lod) ||
-        v < 0 || v >= (1 << lod))
+    if (!prefetchWorkers.empty())
     {
-        return TextureTile(0);
+        {
+            lock_guard<mutex> lock(prefetchMutex);
+            prefetchExit = true;
+        }
+        prefetchCondition.notify_all();
+        for (auto& worker : prefetchWorkers)
+            worker.join();
     }
 
+    for (const auto& entry : prefetchedTiles)
+        delete entry.second.img;
+}
+
+
+// Walk the quadtree and return the deepest tile available for the
+// requested coordinates, reporting the LOD it was found at.
+VirtualTexture::Tile* VirtualTexture::locateTile(int lod, int u, int v,
+                                                 unsigned int& tileLOD)
+{
     TileQuadtreeNode* node = tileTree[u >> lod];
     Tile* tile = node->tile;
-    unsigned int tileLOD = 0;
+    tileLOD = 0;
 
     for (int n = 0; n < lod; n++)
     {
@@ -115,6 +241,54 @@ const TextureTile VirtualTexture::getTile(int lod, int u, int v)
         }
     }
 
+    return tile;
+}
+
+
+const TextureTile VirtualTexture::getTile(int lod, int u, int v)
+{
+    tilesRequested++;
+#if 0
+    cout << "getTile(" << lod << ", " << u << ", " << v << ")\n";
+#endif
+
+    lod += baseSplit;
+
+    if (lod < 0 || (unsigned int) lod >= nResolutionLevels ||
+        u < 0 || u >= (2 << lod) ||
+        v < 0 || v >= (1 << lod))
+    {
+        return TextureTile(0);
+    }
+
+    // Track the footprint of this frame's requests at the finest LOD in
+    // use; updatePrefetch() projects its motion ahead to load tiles
+    // before they are first rendered.
+    if (lod > footprintLod)
+    {
+        footprintLod = lod;
+        footprintCount = 0;
+        footprintUSum = 0;
+        footprintVSum = 0;
+        footprintUMin = u;
+        footprintUMax = u;
+        footprintVMin = v;
+        footprintVMax = v;
+    }
+    if (lod == footprintLod)
+    {
+        footprintCount++;
+        footprintUSum += u;
+        footprintVSum += v;
+        footprintUMin = min(footprintUMin, u);
+        footprintUMax = max(footprintUMax, u);
+        footprintVMin = min(footprintVMin, v);
+        footprintVMax = max(footprintVMax, v);
+    }
+
+    unsigned int tileLOD = 0;
+    Tile* tile = locateTile(lod, u, v, tileLOD);
+
     // No tile was found at all--not even the base texture was found
     if (!tile)
         return TextureTile(0);
@@ -179,7 +353,12 @@ int VirtualTexture::getVTileCount(int lod) const
 
 void VirtualTexture::beginUsage()
 {
+    updatePrefetch();
+    footprintLod = -1;
+    footprintCount = 0;
+
     ticks++;
+    statTilesRequested = tilesRequested;
     tilesRequested = 0;
 }
 
@@ -199,18 +378,26 @@ unsigned int VirtualTexture::tileIndex(unsigned int lod,
 #endif
 
 
-ImageTexture* VirtualTexture::loadTileTexture(unsigned int lod, unsigned int u, unsigned int v)
+fs::path VirtualTexture::tileImagePath(unsigned int lod, unsigned int u, unsigned int v) const
 {
     lod >>= baseSplit;
     assert(lod < (unsigned)MaxResolutionLevels);
 
-    auto path = tilePath /
-                fmt::sprintf("level%d", lod) /
-                fmt::sprintf("%s%d_%d%s", tilePrefix, u, v, tileExt.string());
+    return tilePath /
+           fmt::sprintf("level%d", lod) /
+           fmt::sprintf("%s%d_%d%s", tilePrefix, u, v, tileExt.string());
+}
+
 
-    Image* img = LoadImageFromFile(path);
-    if (img == nullptr)
-        return nullptr;
+Image* VirtualTexture::loadTileImage(unsigned int lod, unsigned int u, unsigned int v)
+{
+    return LoadImageFromFile(tileImagePath(lod, u, v));
+}
+
+
+ImageTexture* VirtualTexture::createTileTexture(Image& img, unsigned int lod)
+{
+    lod >>= baseSplit;
 
     ImageTexture* tex = nullptr;
 
@@ -218,15 +405,13 @@ ImageTexture* VirtualTexture::loadTileTexture(unsigned int lod, unsigned int u,
     // mapping is built into the texture.
     MipMapMode mipMapMode = lod == 0 ? DefaultMipMaps : NoMipMaps;
 
-    if (isPow2(img->getWidth()) && isPow2(img->getHeight()))
-        tex = new ImageTexture(*img, EdgeClamp, mipMapMode);
+    if (isPow2(img.getWidth()) && isPow2(img.getHeight()))
+        tex = new ImageTexture(img, EdgeClamp, mipMapMode);
 
     // TODO: Virtual textures can have tiles in different formats, some
     // compressed and some not. The compression flag doesn't make much
     // sense for them.
-    compressed = img->isCompressed();
-
-    delete img;
+    compressed = img.isCompressed();
 
     return tex;
 }
@@ -236,14 +421,285 @@ void VirtualTexture::makeResident(Tile* tile, unsigned int lod, unsigned int u,
 {
     if (tile->tex == nullptr && !tile->loadFailed)
     {
-        // Potentially evict other tiles in order to make this one fit
-        tile->tex = loadTileTexture(lod, u, v);
+        // Use an image decoded ahead of time by the prefetch thread if
+        // one is available; otherwise fall back to a synchronous load,
+        // which stalls the frame and counts as a fault.
+        Image* img = takePrefetchedImage(lod, u, v);
+        if (img != nullptr)
+            statPrefetchHits++;
+        else
+        {
+            statTileFaults++;
+            img = loadTileImage(lod, u, v);
+        }
+
+        if (img != nullptr)
+        {
+            tile->tex = createTileTexture(*img, lod);
+            if (tile->tex != nullptr)
+            {
+                // Estimated footprint; GL-generated mipmaps for level 0
+                // tiles add about a third on top of the base image.
+                auto bytes = (uintmax_t) img->getSize();
+                if ((lod >> baseSplit) == 0 && img->getMipLevelCount() == 1)
+                    bytes += bytes / 3;
+
+                statResidentTiles++;
+                statResidentBytes += bytes;
+                statResidentPerLevel[lod >> baseSplit]++;
+            }
+            delete img;
+        }
+
         if (tile->tex == nullptr)
         {
             // cout << "Texture load failed!\n";
             tile->loadFailed = true;
+            statLoadFailures++;
+        }
+    }
+}
+
+
+// Project the motion of the tile footprint between the last two frames
+// ahead by PrefetchLeadFrames and queue the tiles it will cover for
+// background decoding. Runs on the main thread at the start of each
+// frame's usage of this texture.
+void VirtualTexture::updatePrefetch()
+{
+    if (footprintCount == 0)
+    {
+        havePrevFootprint = false;
+        return;
+    }
+
+    float centerU = (float) footprintUSum / (float) footprintCount;
+    float centerV = (float) footprintVSum / (float) footprintCount;
+    int lod = footprintLod;
+    int uCount = 2 << lod;
+    int vCount = 1 << lod;
+
+    if (havePrevFootprint && lod == prevFootprintLod)
+    {
+        float du = centerU - prevCenterU;
+        float dv = centerV - prevCenterV;
+
+        // Tile u wraps around in longitude; take the short way
+        if (du > (float) uCount * 0.5f)
+            du -= (float) uCount;
+        else if (du < (float) uCount * -0.5f)
+            du += (float) uCount;
+
+        float halfU = (float) (footprintUMax - footprintUMin) * 0.5f + 1.0f;
+        float halfV = (float) (footprintVMax - footprintVMin) * 0.5f + 1.0f;
+
+        // Only extrapolate coherent motion; a displacement larger than
+        // the footprint itself means the camera jumped, and prediction
+        // would just queue garbage.
+        bool moving = du != 0.0f || dv != 0.0f;
+        if (moving && fabs(du) <= halfU && fabs(dv) <= halfV)
+        {
+            float offU = du * (float) PrefetchLeadFrames;
+            float offV = dv * (float) PrefetchLeadFrames;
+
+            // Don't reach out more than two footprints ahead
+            if (fabs(offU) > halfU * 2.0f)
+                offU = offU > 0.0f ? halfU * 2.0f : halfU * -2.0f;
+            if (fabs(offV) > halfV * 2.0f)
+                offV = offV > 0.0f ? halfV * 2.0f : halfV * -2.0f;
+
+            int u0 = (int) floor(centerU + offU - halfU);
+            int u1 = (int) ceil(centerU + offU + halfU);
+            int v0 = max(0, (int) floor(centerV + offV - halfV));
+            int v1 = min(vCount - 1, (int) ceil(centerV + offV + halfV));
+
+            unsigned int requested = 0;
+            for (int v = v0; v <= v1 && requested < PrefetchMaxRequestsPerFrame; v++)
+            {
+                for (int u = u0; u <= u1 && requested < PrefetchMaxRequestsPerFrame; u++)
+                {
+                    int wrappedU = ((u % uCount) + uCount) % uCount;
+
+                    unsigned int tileLOD = 0;
+                    Tile* tile = locateTile(lod, wrappedU, v, tileLOD);
+                    if (tile == nullptr || tile->tex != nullptr || tile->loadFailed)
+                        continue;
+
+                    queueTilePrefetch(tileLOD,
+                                      (unsigned int) wrappedU >> (lod - tileLOD),
+                                      (unsigned int) v >> (lod - tileLOD));
+                    requested++;
+                }
+            }
         }
     }
+
+    havePrevFootprint = true;
+    prevFootprintLod = lod;
+    prevCenterU = centerU;
+    prevCenterV = centerV;
+}
+
+
+void VirtualTexture::queueTilePrefetch(unsigned int lod, unsigned int u, unsigned int v)
+{
+    uint64_t key = TileKey(lod, u, v);
+
+    lock_guard<mutex> lock(prefetchMutex);
+
+    auto it = prefetchedTiles.find(key);
+    if (it != prefetchedTiles.end())
+    {
+        // Already decoded or in flight; just refresh its age
+        it->second.lastPredicted = ticks;
+        return;
+    }
+
+    // Evict the entry the prediction has gone longest without naming;
+    // those are the prefetches that turned out to be wasted.
+    if (prefetchedTiles.size() >= PrefetchCacheTiles)
+    {
+        auto oldest = prefetchedTiles.begin();
+        for (auto i = prefetchedTiles.begin(); i != prefetchedTiles.end(); ++i)
+        {
+            if (i->second.lastPredicted < oldest->second.lastPredicted)
+                oldest = i;
+        }
+        delete oldest->second.img;
+        prefetchedTiles.erase(oldest);
+        statPrefetchWasted++;
+    }
+
+    PrefetchEntry entry;
+    entry.lastPredicted = ticks;
+    prefetchedTiles[key] = entry;
+    prefetchQueue.push_back(PrefetchRequest{ lod, u, v, key });
+
+    // Start the tile file toward the OS cache now; when the decode
+    // workers are saturated, the file I/O for queued tiles completes
+    // before their turn comes up.
+    GetAsyncFileReader()->readahead(tileImagePath(lod, u, v));
+
+    if (prefetchWorkers.empty())
+    {
+        unsigned int poolSize = thread::hardware_concurrency() / 2;
+        poolSize = max(1u, min(MaxPrefetchThreads, poolSize));
+        for (unsigned int i = 0; i < poolSize; i++)
+            prefetchWorkers.emplace_back(&VirtualTexture::prefetchThread, this);
+    }
+
+    prefetchCondition.notify_one();
+}
+
+
+// Remove and return the decoded image for the given tile, or nullptr if
+// the prefetcher never got to it. Either way the cache entry is
+// dropped: once a tile is requested for real, the entry has served its
+// purpose.
+Image* VirtualTexture::takePrefetchedImage(unsigned int lod, unsigned int u, unsigned int v)
+{
+    lock_guard<mutex> lock(prefetchMutex);
+
+    auto it = prefetchedTiles.find(TileKey(lod, u, v));
+    if (it == prefetchedTiles.end())
+        return nullptr;
+
+    Image* img = it->second.img;
+    prefetchedTiles.erase(it);
+
+    return img;
+}
+
+
+void VirtualTexture::prefetchThread()
+{
+    unique_lock<mutex> lock(prefetchMutex);
+
+    while (!prefetchExit)
+    {
+        if (prefetchQueue.empty())
+        {
+            prefetchCondition.wait(lock);
+            continue;
+        }
+
+        PrefetchRequest req = prefetchQueue.front();
+        prefetchQueue.pop_front();
+
+        lock.unlock();
+        Image* img = loadTileImage(req.lod, req.u, req.v);
+
+        // Level 0 tiles are mipmapped; build the chain here with the
+        // box filter so the main thread only has to upload it.
+        if (img != nullptr && !img->isCompressed() &&
+            (req.lod >> baseSplit) == 0 &&
+            img->getMipLevelCount() == 1 &&
+            isPow2(img->getWidth()) && isPow2(img->getHeight()))
+        {
+            Image* withMips = BuildMipChain(*img);
+            delete img;
+            img = withMips;
+        }
+
+        lock.lock();
+
+        auto it = prefetchedTiles.find(req.key);
+        if (it != prefetchedTiles.end())
+            it->second.img = img;
+        else
+            delete img;  // evicted or consumed while we were decoding
+    }
+}
+
+
+void VirtualTexture::getStats(Stats& stats) const
+{
+    stats.name = tilePath.string();
+    stats.residentTiles = statResidentTiles;
+    stats.residentBytes = statResidentBytes;
+    stats.tileFaults = statTileFaults;
+    stats.prefetchHits = statPrefetchHits;
+    stats.prefetchWasted = statPrefetchWasted;
+    stats.loadFailures = statLoadFailures;
+    stats.tilesRequested = statTilesRequested;
+
+    // Trim trailing empty levels so the HUD only shows levels in use
+    stats.residentPerLevel = statResidentPerLevel;
+    while (!stats.residentPerLevel.empty() && stats.residentPerLevel.back() == 0)
+        stats.residentPerLevel.pop_back();
+}
+
+
+void VirtualTexture::reportMemory(MemoryLedger& ledger) const
+{
+    string component = tilePath.string();
+    ledger.add(component, "tiles", statResidentBytes);
+
+    uintmax_t prefetchBytes = 0;
+    {
+        lock_guard<mutex> lock(prefetchMutex);
+        for (const auto& entry : prefetchedTiles)
+        {
+            if (entry.second.img != nullptr)
+                prefetchBytes += (uintmax_t) entry.second.img->getSize();
+        }
+    }
+    ledger.add(component, "prefetch", prefetchBytes);
+}
+
+
+void GetVirtualTextureStats(vector<VirtualTexture::Stats>& stats)
+{
+    lock_guard<mutex> lock(vtRegistryMutex);
+
+    stats.clear();
+    stats.reserve(vtRegistry.size());
+    for (const auto* vt : vtRegistry)
+    {
+        VirtualTexture::Stats s;
+        vt->getStats(s);
+        stats.push_back(s);
+    }
 }
 
 
@@ -10,11 +10,19 @@
 #ifndef _CELENGINE_VIRTUALTEX_H_
 #define _CELENGINE_VIRTUALTEX_H_
 
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 #include <celengine/texture.h>
+#include <celutil/memaudit.h>
 
 
-class VirtualTexture : public Texture
+class VirtualTexture : public Texture, public MemoryReporter
 {
  public:
     VirtualTexture(const fs::path& _tilePath,
@@ -22,11 +30,34 @@ class VirtualTexture : public Texture
                    unsigned int _tileSize,
                    const std::string& _tilePrefix,
                    const std::string& _tileType);
-    ~VirtualTexture() = default;
+    ~VirtualTexture();
 
     const TextureTile getTile(int lod, int u, int v) override;
     void bind() override;
 
+    // Residency and tile traffic counters, displayed on the debug HUD.
+    // Counts are cumulative since creation, except tilesRequested which
+    // covers the last completed frame. Resident tiles are only released
+    // when the whole texture is dropped, so the eviction figure here
+    // covers the prefetch cache: decoded tiles thrown away unused.
+    struct Stats
+    {
+        std::string name;
+        unsigned int residentTiles{ 0 };
+        std::uintmax_t residentBytes{ 0 };
+        std::vector<unsigned int> residentPerLevel;
+        unsigned int tileFaults{ 0 };
+        unsigned int prefetchHits{ 0 };
+        unsigned int prefetchWasted{ 0 };
+        unsigned int loadFailures{ 0 };
+        unsigned int tilesRequested{ 0 };
+    };
+
+    void getStats(Stats& stats) const;
+
+    //! MemoryReporter: resident tile textures and the prefetch cache.
+    void reportMemory(MemoryLedger&) const override;
+
     int getLODCount() const override;
     int getUTileCount(int lod) const override;
     int getVTileCount(int lod) const override;
@@ -49,10 +80,36 @@ class VirtualTexture : public Texture
         TileQuadtreeNode* children[4]{ nullptr, nullptr, nullptr, nullptr};
     };
 
+    // A tile image decoded ahead of need by the prefetch thread. The
+    // lastPredicted tick stamp implements priority aging: when the
+    // cache is full, the entry least recently named by the motion
+    // prediction (i.e. a wasted prefetch) is evicted first.
+    struct PrefetchEntry
+    {
+        Image* img{ nullptr };
+        unsigned int lastPredicted{ 0 };
+    };
+
+    struct PrefetchRequest
+    {
+        unsigned int lod;
+        unsigned int u;
+        unsigned int v;
+        uint64_t key;
+    };
+
     void populateTileTree();
     void addTileToTree(Tile* tile, unsigned int lod, unsigned int u, unsigned int v);
     void makeResident(Tile* tile, unsigned int lod, unsigned int u, unsigned int v);
-    ImageTexture* loadTileTexture(unsigned int lod, unsigned int u, unsigned int v);
+    Tile* locateTile(int lod, int u, int v, unsigned int& tileLOD);
+    fs::path tileImagePath(unsigned int lod, unsigned int u, unsigned int v) const;
+    Image* loadTileImage(unsigned int lod, unsigned int u, unsigned int v);
+    ImageTexture* createTileTexture(Image& img, unsigned int lod);
+
+    void updatePrefetch();
+    void queueTilePrefetch(unsigned int lod, unsigned int u, unsigned int v);
+    Image* takePrefetchedImage(unsigned int lod, unsigned int u, unsigned int v);
+    void prefetchThread();
 
     Tile* tiles{ nullptr };
     Tile* findTile(unsigned int lod,
@@ -75,9 +132,44 @@ class VirtualTexture : public Texture
     };
 
     TileQuadtreeNode* tileTree[2];
+
+    // Footprint of the tiles requested during the current frame at the
+    // finest LOD in use; its motion between frames drives prefetching.
+    int footprintLod{ -1 };
+    int footprintCount{ 0 };
+    long footprintUSum{ 0 };
+    long footprintVSum{ 0 };
+    int footprintUMin{ 0 };
+    int footprintUMax{ 0 };
+    int footprintVMin{ 0 };
+    int footprintVMax{ 0 };
+    bool havePrevFootprint{ false };
+    int prevFootprintLod{ -1 };
+    float prevCenterU{ 0.0f };
+    float prevCenterV{ 0.0f };
+
+    // Residency instrumentation, reported through getStats()
+    unsigned int statResidentTiles{ 0 };
+    std::uintmax_t statResidentBytes{ 0 };
+    std::vector<unsigned int> statResidentPerLevel;
+    unsigned int statTileFaults{ 0 };
+    unsigned int statPrefetchHits{ 0 };
+    unsigned int statPrefetchWasted{ 0 };
+    unsigned int statLoadFailures{ 0 };
+    unsigned int statTilesRequested{ 0 };
+
+    std::map<uint64_t, PrefetchEntry> prefetchedTiles;
+    std::deque<PrefetchRequest> prefetchQueue;
+    std::vector<std::thread> prefetchWorkers;
+    mutable std::mutex prefetchMutex;
+    std::condition_variable prefetchCondition;
+    bool prefetchExit{ false };
 };
 
 
 VirtualTexture* LoadVirtualTexture(const fs::path& filename);
 
+// Collect stats for every live virtual texture, for the debug HUD
+void GetVirtualTextureStats(std::vector<VirtualTexture::Stats>& stats);
+
 #endif // _CELENGINE_VIRTUALTEX_H_
@@ -20,6 +20,7 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <cmath>
+#include <cstring>
 
 using namespace Eigen;
 using namespace celmath;
@@ -101,11 +102,23 @@ renderTerminator(Renderer* renderer, const vector<Vector3f>& pos, const Vector4f
     vo.bindWritable();
     if (!vo.initialized())
     {
-        vo.allocate();
+        // Prefer a persistently mapped triple-buffered stream; fall
+        // back to plain dynamic buffer uploads on older drivers.
+        if (vo.allocateStream(maxSections * sizeof(Vector3f)))
+            vo.allocate();
         vo.setVertices(3, GL_FLOAT);
     }
 
-    vo.setBufferData(pos.data(), 0, pos.size() * sizeof(Vector3f));
+    GLint first = 0;
+    if (void* mem = vo.beginStreamRegion())
+    {
+        std::memcpy(mem, pos.data(), pos.size() * sizeof(Vector3f));
+        first = (GLint) (vo.streamRegionIndex() * maxSections);
+    }
+    else
+    {
+        vo.setBufferData(pos.data(), 0, pos.size() * sizeof(Vector3f));
+    }
 
     prog->use();
     prog->vec4Param("color") = color;
@@ -113,7 +126,8 @@ renderTerminator(Renderer* renderer, const vector<Vector3f>& pos, const Vector4f
     m.topLeftCorner(3, 3) = qf.conjugate().toRotationMatrix();
     prog->mat4Param("rotate") = m;
 
-    vo.draw(GL_LINE_LOOP, pos.size());
+    vo.draw(GL_LINE_LOOP, pos.size(), first);
+    vo.endStreamRegion();
 
     vo.unbind();
     glUseProgram(0);
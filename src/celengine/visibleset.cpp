@@ -0,0 +1,127 @@
+// visibleset.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Frame-coherent reuse of star octree traversal results.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <celengine/visibleset.h>
+#include "astro.h"
+
+using namespace Eigen;
+
+// Keep in sync with the traversal specialization in staroctree.cpp.
+static const float MAX_STAR_ORBIT_RADIUS = 1.0f;
+
+constexpr float VisibleStarSet::positionToleranceLy;
+constexpr float VisibleStarSet::magnitudeMargin;
+constexpr float VisibleStarSet::angularMarginRad;
+
+
+namespace
+{
+
+// Forwards stars passing the exact magnitude test to the real handler
+// while recording every candidate (including those only within the
+// collection margin) for later replay.
+class CollectingStarHandler : public StarHandler
+{
+ public:
+    CollectingStarHandler(StarHandler& _handler,
+                          std::vector<const Star*>& _visible,
+                          float _limitingMag) :
+        handler(_handler),
+        visible(_visible),
+        limitingMag(_limitingMag)
+    {
+    }
+
+    void process(const Star& star, float distance, float appMag) override
+    {
+        visible.push_back(&star);
+        if (appMag < limitingMag || (distance < MAX_STAR_ORBIT_RADIUS && star.getOrbit()))
+            handler.process(star, distance, appMag);
+    }
+
+ private:
+    StarHandler& handler;
+    std::vector<const Star*>& visible;
+    float limitingMag;
+};
+
+} // anonymous namespace
+
+
+bool VisibleStarSet::canReplay(const Vector3f& obsPosition,
+                               const Quaternionf& obsOrientation,
+                               float fovY,
+                               float aspectRatio,
+                               float limitingMag) const
+{
+    if (!valid || age >= maxAge)
+        return false;
+
+    if (limitingMag > cachedLimitingMag ||
+        fovY > cachedFovY ||
+        aspectRatio != cachedAspectRatio)
+    {
+        return false;
+    }
+
+    if ((obsPosition - cachedPosition).norm() > positionToleranceLy)
+        return false;
+
+    return cachedOrientation.angularDistance(obsOrientation) < angularMarginRad;
+}
+
+
+void VisibleStarSet::findVisibleStars(const StarDatabase& starDB,
+                                      StarHandler& starHandler,
+                                      const Vector3f& obsPosition,
+                                      const Quaternionf& obsOrientation,
+                                      float fovY,
+                                      float aspectRatio,
+                                      float limitingMag,
+                                      OctreeProcStats* stats)
+{
+    if (canReplay(obsPosition, obsOrientation, fovY, aspectRatio, limitingMag))
+    {
+        ++age;
+        for (const auto star : visible)
+        {
+            float distance = (obsPosition - star->getPosition()).norm();
+            float appMag = astro::absToAppMag(star->getAbsoluteMagnitude(), distance);
+            if (appMag < limitingMag ||
+                (distance < MAX_STAR_ORBIT_RADIUS && star->getOrbit()))
+            {
+                starHandler.process(*star, distance, appMag);
+            }
+        }
+        return;
+    }
+
+    visible.clear();
+    cachedPosition = obsPosition;
+    cachedOrientation = obsOrientation;
+    cachedFovY = fovY;
+    cachedAspectRatio = aspectRatio;
+    cachedLimitingMag = limitingMag;
+    age = 0;
+    valid = true;
+
+    // Collect with widened tolerances so small observer changes can be
+    // served from the cache on subsequent frames.
+    CollectingStarHandler collector(starHandler, visible, limitingMag);
+    starDB.findVisibleStars(collector,
+                            obsPosition,
+                            obsOrientation,
+                            fovY + 2.0f * angularMarginRad,
+                            aspectRatio,
+                            limitingMag + magnitudeMargin,
+                            stats,
+                            true /* includeDeferred: render-only query */);
+}
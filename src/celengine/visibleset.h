@@ -0,0 +1,76 @@
+// visibleset.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Frame-coherent reuse of star octree traversal results.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELENGINE_VISIBLESET_H_
+#define _CELENGINE_VISIBLESET_H_
+
+#include <vector>
+#include <celengine/stardb.h>
+
+/*! VisibleStarSet exploits the frame-to-frame coherence of the observer:
+ *  while the camera barely moves, the set of potentially visible stars is
+ *  nearly identical, so the octree traversal can be replaced by replaying
+ *  the set collected on a previous frame. The traversal that fills the
+ *  cache runs with a widened field of view and a magnitude margin, and the
+ *  replay applies the exact per-star distance and magnitude tests, so
+ *  reuse only risks missing stars once the observer leaves the tolerance
+ *  region--at which point a full traversal is performed again. The cache
+ *  additionally expires after a fixed number of frames.
+ */
+class VisibleStarSet
+{
+ public:
+    VisibleStarSet() = default;
+
+    //! Equivalent to StarDatabase::findVisibleStars, but with reuse.
+    void findVisibleStars(const StarDatabase& starDB,
+                          StarHandler& starHandler,
+                          const Eigen::Vector3f& obsPosition,
+                          const Eigen::Quaternionf& obsOrientation,
+                          float fovY,
+                          float aspectRatio,
+                          float limitingMag,
+                          OctreeProcStats* stats = nullptr);
+
+    //! Drop the cached set; the next query performs a full traversal.
+    void invalidate()
+    {
+        valid = false;
+    }
+
+ private:
+    bool canReplay(const Eigen::Vector3f& obsPosition,
+                   const Eigen::Quaternionf& obsOrientation,
+                   float fovY,
+                   float aspectRatio,
+                   float limitingMag) const;
+
+    std::vector<const Star*> visible;
+
+    Eigen::Vector3f cachedPosition{ Eigen::Vector3f::Zero() };
+    Eigen::Quaternionf cachedOrientation{ Eigen::Quaternionf::Identity() };
+    float cachedFovY{ 0.0f };
+    float cachedAspectRatio{ 0.0f };
+    float cachedLimitingMag{ 0.0f };
+    unsigned int age{ 0 };
+    bool valid{ false };
+
+    // Tolerances defining the reuse region. The magnitude margin covers
+    // stars brightening across the limit while the observer moves inside
+    // the position tolerance; the angular margin matches the amount by
+    // which the collection frustum is widened.
+    static constexpr float positionToleranceLy = 0.01f;
+    static constexpr float magnitudeMargin = 0.5f;
+    static constexpr float angularMarginRad = 0.05f;
+    static const unsigned int maxAge = 30;
+};
+
+#endif // _CELENGINE_VISIBLESET_H_
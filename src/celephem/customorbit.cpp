@@ -3155,9 +3155,9 @@ Orbit* GetCustomOrbit(const string& name)
     if (!jplephInitialized)
     {
         jplephInitialized = true;
-        ifstream in("data/jpleph.dat", ios::in | ios::binary);
-        if (in.good())
-            jpleph = JPLEphemeris::load(in);
+        // Memory-map the ephemeris so records are paged in on demand;
+        // load() falls back to stream reading if mapping fails.
+        jpleph = JPLEphemeris::load(fs::path("data/jpleph.dat"));
         if (jpleph != nullptr)
         {
            fmt::fprintf(clog, "Loaded DE%u ephemeris. Valid from JD %.8lf to JD %.8lf\n",
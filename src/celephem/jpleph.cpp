@@ -11,7 +11,9 @@
 // positions.
 
 #include <fstream>
+#include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include <cassert>
 #include <celutil/bytes.h>
 #include "jpleph.h"
@@ -22,6 +24,8 @@ using namespace std;
 static const unsigned int DE200RecordSize    =  826;
 static const unsigned int DE405RecordSize    = 1018;
 static const unsigned int DE406RecordSize    =  728;
+static const unsigned int DE430RecordSize    = 1018;
+static const unsigned int DE431RecordSize    =  988;
 
 static const unsigned int NConstants         =  400;
 static const unsigned int ConstantNameLength =  6;
@@ -106,9 +110,12 @@ Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd) const
     // recNo is always >= 0:
     auto recNo = (unsigned int) ((tjd - startDate) / daysPerInterval);
     // Make sure we don't go past the end of the array if t == endDate
-    if (recNo >= records.size())
-        recNo = records.size() - 1;
-    const JPLEphRecord* rec = &records[recNo];
+    unsigned int recordCount = records.empty() ? nRecords : (unsigned int) records.size();
+    if (recNo >= recordCount)
+        recNo = recordCount - 1;
+
+    double recT0 = 0.0;
+    const double* recCoeffs = getRecordCoeffs(recNo, recT0);
 
     assert(coeffInfo[planet].nGranules >= 1);
     assert(coeffInfo[planet].nGranules <= 32);
@@ -117,20 +124,20 @@ Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd) const
     // u is the normalized time (in [-1, 1]) for interpolating
     // coeffs is a pointer to the Chebyshev coefficients
     double u = 0.0;
-    double* coeffs = nullptr;
+    const double* coeffs = nullptr;
 
     // nGranules is unsigned int so it will be compared against FFFFFFFF:
     if (coeffInfo[planet].nGranules == (unsigned int) -1)
     {
-        coeffs = rec->coeffs + coeffInfo[planet].offset;
-        u = 2.0 * (tjd - rec->t0) / daysPerInterval - 1.0;
+        coeffs = recCoeffs + coeffInfo[planet].offset;
+        u = 2.0 * (tjd - recT0) / daysPerInterval - 1.0;
     }
     else
     {
     double daysPerGranule = daysPerInterval / coeffInfo[planet].nGranules;
-    auto granule = (int) ((tjd - rec->t0) / daysPerGranule);
-    double granuleStartDate = rec->t0 + daysPerGranule * (double) granule;
-    coeffs = rec->coeffs + coeffInfo[planet].offset +
+    auto granule = (int) ((tjd - recT0) / daysPerGranule);
+    double granuleStartDate = recT0 + daysPerGranule * (double) granule;
+    coeffs = recCoeffs + coeffInfo[planet].offset +
             granule * coeffInfo[planet].nCoeffs * 3;
     u = 2.0 * (tjd - granuleStartDate) / daysPerGranule - 1.0;
     }
@@ -155,31 +162,76 @@ Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd) const
 }
 
 
-JPLEphemeris* JPLEphemeris::load(istream& in)
+/*! Return the coefficient array of one record along with its start
+ *  time. Stream-loaded ephemerides keep every record resident; in
+ *  memory-mapped mode the raw big-endian record is paged in by the OS
+ *  on first touch and unpacked into a small LRU cache of native-endian
+ *  coefficient sets, so repeated queries around the current epoch do
+ *  not re-swap bytes.
+ */
+const double* JPLEphemeris::getRecordCoeffs(unsigned int recNo, double& t0) const
 {
-    JPLEphemeris* eph = nullptr;
+    if (!records.empty())
+    {
+        t0 = records[recNo].t0;
+        return records[recNo].coeffs;
+    }
+
+    cacheClock++;
 
+    for (unsigned int i = 0; i < RecordCacheSize; i++)
+    {
+        if (recordCache[i].recNo == recNo)
+        {
+            recordCache[i].lastUsed = cacheClock;
+            t0 = recordCache[i].coeffs[0];
+            return &recordCache[i].coeffs[2];
+        }
+    }
+
+    CachedRecord* victim = &recordCache[0];
+    for (unsigned int i = 1; i < RecordCacheSize; i++)
+    {
+        if (recordCache[i].lastUsed < victim->lastUsed)
+            victim = &recordCache[i];
+    }
+
+    const double* src = (const double*) (recordBase + (size_t) recNo * recordSize * 8);
+    victim->coeffs.resize(recordSize);
+    for (unsigned int j = 0; j < recordSize; j++)
+    {
+        double d = src[j];
+        BE_TO_CPU_DOUBLE(d, d);
+        victim->coeffs[j] = d;
+    }
+    victim->recNo = recNo;
+    victim->lastUsed = cacheClock;
+
+    // The first two 'coefficients' of a record are its time span
+    t0 = victim->coeffs[0];
+    return &victim->coeffs[2];
+}
+
+
+// Parse everything up to the first coefficient record.
+bool JPLEphemeris::loadHeader(istream& in, JPLEphemeris* eph)
+{
     // Skip past three header labels
     in.ignore(LabelSize * 3);
     if (!in.good())
-        return nullptr;
+        return false;
 
     // Skip past the constant names
     in.ignore(NConstants * ConstantNameLength);
     if (!in.good())
-        return nullptr;
-
-    eph = new JPLEphemeris();
+        return false;
 
     // Read the start time, end time, and time interval
     eph->startDate = readDouble(in);
     eph->endDate = readDouble(in);
     eph->daysPerInterval = readDouble(in);
     if (!in.good())
-    {
-        delete eph;
-        return nullptr;
-    }
+        return false;
 
     // Number of constants with valid values; not useful for us
     (void) readUint(in);
@@ -196,10 +248,7 @@ JPLEphemeris* JPLEphemeris::load(istream& in)
         eph->coeffInfo[i].nGranules = readUint(in);
     }
     if (!in.good())
-    {
-        delete eph;
-        return nullptr;
-    }
+        return false;
 
     eph->DENum = readUint(in);
 
@@ -214,25 +263,35 @@ JPLEphemeris* JPLEphemeris::load(istream& in)
     case 406:
         eph->recordSize = DE406RecordSize;
         break;
+    case 430:
+        eph->recordSize = DE430RecordSize;
+        break;
+    case 431:
+        eph->recordSize = DE431RecordSize;
+        break;
     default:
-        delete eph;
-        return nullptr;
+        return false;
     }
 
     eph->librationCoeffInfo.offset        = readUint(in);
     eph->librationCoeffInfo.nCoeffs       = readUint(in);
     eph->librationCoeffInfo.nGranules     = readUint(in);
     if (!in.good())
-    {
-        delete eph;
-        return nullptr;
-    }
+        return false;
 
     // Skip past the rest of the record
     in.ignore(eph->recordSize * 8 - 2856);
     // The next record contains constant values (which we don't need)
     in.ignore(eph->recordSize * 8);
-    if (!in.good())
+
+    return in.good();
+}
+
+
+JPLEphemeris* JPLEphemeris::load(istream& in)
+{
+    auto* eph = new JPLEphemeris();
+    if (!loadHeader(in, eph))
     {
         delete eph;
         return nullptr;
@@ -241,7 +300,7 @@ JPLEphemeris* JPLEphemeris::load(istream& in)
     auto nRecords = (unsigned int) ((eph->endDate - eph->startDate) /
                         eph->daysPerInterval);
     eph->records.resize(nRecords);
-    for (i = 0; i < nRecords; i++)
+    for (unsigned int i = 0; i < nRecords; i++)
     {
         eph->records[i].t0 = readDouble(in);
         eph->records[i].t1 = readDouble(in);
@@ -262,3 +321,46 @@ JPLEphemeris* JPLEphemeris::load(istream& in)
 
     return eph;
 }
+
+
+JPLEphemeris* JPLEphemeris::load(const fs::path& path)
+{
+    auto* eph = new JPLEphemeris();
+    if (eph->mappedFile.map(path) && eph->mappedFile.size() > 0)
+    {
+        // Parse the header from an in-memory stream over the start of
+        // the mapping; the coefficient records themselves are left in
+        // place and only touched on demand.
+        size_t headerSize = min(eph->mappedFile.size(), (size_t) 65536);
+        istringstream header(string(eph->mappedFile.data(), headerSize));
+        if (!loadHeader(header, eph))
+        {
+            delete eph;
+            return nullptr;
+        }
+
+        size_t recordBytes = (size_t) eph->recordSize * 8;
+        if (eph->mappedFile.size() < recordBytes * 3)
+        {
+            delete eph;
+            return nullptr;
+        }
+
+        // Coefficient records follow the two header records
+        eph->recordBase = eph->mappedFile.data() + recordBytes * 2;
+        eph->nRecords = (unsigned int) ((eph->endDate - eph->startDate) /
+                            eph->daysPerInterval);
+        auto available = (unsigned int) ((eph->mappedFile.size() - recordBytes * 2) / recordBytes);
+        if (eph->nRecords > available)
+            eph->nRecords = available;
+
+        return eph;
+    }
+
+    // Could not map the file; fall back to reading it into memory
+    delete eph;
+    ifstream in(path.string(), ios::in | ios::binary);
+    if (!in.good())
+        return nullptr;
+    return load(in);
+}
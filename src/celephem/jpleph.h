@@ -7,15 +7,18 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 //
-// Load JPL's DE200, DE405, and DE406 ephemerides and compute planet
-// positions.
+// Load JPL's DE200, DE405, DE406, DE430, and DE431 ephemerides and
+// compute planet positions.
 
 #ifndef _CELENGINE_JPLEPH_H_
 #define _CELENGINE_JPLEPH_H_
 
 #include <iostream>
 #include <vector>
+#include <cstdint>
 #include <Eigen/Core>
+#include <celcompat/filesystem.h>
+#include <celutil/memmap.h>
 
 enum JPLEphemItem
 {
@@ -68,11 +71,23 @@ public:
 
     static JPLEphemeris* load(std::istream&);
 
+    /*! Memory-map the ephemeris file instead of reading every record
+     *  into memory up front; coefficient records are paged in by the
+     *  OS on demand and unpacked into a small LRU cache, so resident
+     *  memory stays at the working set of the current epoch instead of
+     *  the full file (3GB for DE431). Falls back to stream loading
+     *  when the file cannot be mapped.
+     */
+    static JPLEphemeris* load(const fs::path& path);
+
     unsigned int getDENumber() const;
     double getStartDate() const;
     double getEndDate() const;
 
 private:
+    static bool loadHeader(std::istream&, JPLEphemeris*);
+    const double* getRecordCoeffs(unsigned int recNo, double& t0) const;
+
     JPLEphCoeffInfo coeffInfo[JPLEph_NItems];
     JPLEphCoeffInfo librationCoeffInfo;
 
@@ -87,6 +102,22 @@ private:
     unsigned int recordSize;  // number of doubles per record
 
     std::vector<JPLEphRecord> records;
+
+    // Memory-mapped mode; records is empty and coefficient records are
+    // unpacked on demand into recordCache.
+    static const unsigned int RecordCacheSize = 8;
+    struct CachedRecord
+    {
+        unsigned int recNo{ (unsigned int) -1 };
+        uint32_t lastUsed{ 0 };
+        std::vector<double> coeffs;
+    };
+
+    MemoryMappedFile mappedFile;
+    const char* recordBase{ nullptr };
+    unsigned int nRecords{ 0 };
+    mutable CachedRecord recordCache[RecordCacheSize];
+    mutable uint32_t cacheClock{ 0 };
 };
 
 #endif // _CELENGINE_JPLEPH_H_
@@ -189,7 +189,10 @@ EllipticalOrbit::EllipticalOrbit(double _pericenterDistance,
     argOfPeriapsis(_argOfPeriapsis),
     meanAnomalyAtEpoch(_meanAnomalyAtEpoch),
     period(_period),
-    epoch(_epoch)
+    epoch(_epoch),
+    lastMeanAnomaly(0.0),
+    lastEccentricAnomaly(0.0),
+    haveLastAnomaly(false)
 {
     orbitPlaneRotation = (ZRotation(_ascendingNode) * XRotation(_inclination) * ZRotation(_argOfPeriapsis)).toRotationMatrix();
 }
@@ -278,6 +281,13 @@ Vector3d Orbit::velocityAtTime(double tdb) const
 }
 
 
+// Largest estimated step in eccentric anomaly (radians) over which the
+// previous solution is still a useful starting guess; beyond this, fall
+// back to the full iterative solve. The step is estimated in eccentric
+// rather than mean anomaly because high-eccentricity orbits sweep
+// through pericenter much faster than the mean motion.
+static const double KeplerStepMaxDeltaE = 0.1;
+
 double EllipticalOrbit::eccentricAnomaly(double M) const
 {
     if (eccentricity == 0.0)
@@ -285,32 +295,66 @@ double EllipticalOrbit::eccentricAnomaly(double M) const
         // Circular orbit
         return M;
     }
-    if (eccentricity < 0.2)
-    {
-        // Low eccentricity, so use the standard iteration technique
-        Solution sol = solve_iteration_fixed(SolveKeplerFunc1(eccentricity, M), M, 5);
-        return sol.first;
-    }
-    else if (eccentricity < 0.9)
-    {
-        // Higher eccentricity elliptical orbit; use a more complex but
-        // much faster converging iteration.
-        Solution sol = solve_iteration_fixed(SolveKeplerFunc2(eccentricity, M), M, 6);
-        // Debugging
-        // DPRINTF(LOG_LEVEL_INFO, "ecc: %f, error: %f mas\n",
-        //        eccentricity, radToDeg(sol.second) * 3600000);
-        return sol.first;
-    }
-    else if (eccentricity < 1.0)
+    if (eccentricity < 1.0)
     {
-        // Extremely stable Laguerre-Conway method for solving Kepler's
-        // equation.  Only use this for high-eccentricity orbits, as it
-        // requires more calcuation.
-        double E = M + 0.85 * eccentricity * sign(sin(M));
-        Solution sol = solve_iteration_fixed(SolveKeplerLaguerreConway(eccentricity, M), E, 8);
-        return sol.first;
+        // Stepping mode: when the mean anomaly has moved only slightly
+        // since the last call, warm-start from the previous eccentric
+        // anomaly advanced by dE = dM / (1 - e cos E) and polish with
+        // Newton iteration, verifying the residual before accepting.
+        if (haveLastAnomaly)
+        {
+            double dM = M - lastMeanAnomaly;
+            double dE = dM / (1.0 - eccentricity * cos(lastEccentricAnomaly));
+            if (fabs(dE) < KeplerStepMaxDeltaE)
+            {
+                double E = lastEccentricAnomaly + dE;
+                for (int i = 0; i < 3; i++)
+                {
+                    double f = E - eccentricity * sin(E) - M;
+                    if (fabs(f) < 1.0e-10)
+                    {
+                        lastMeanAnomaly = M;
+                        lastEccentricAnomaly = E;
+                        return E;
+                    }
+                    E -= f / (1.0 - eccentricity * cos(E));
+                }
+            }
+        }
+
+        double E;
+        if (eccentricity < 0.2)
+        {
+            // Low eccentricity, so use the standard iteration technique
+            Solution sol = solve_iteration_fixed(SolveKeplerFunc1(eccentricity, M), M, 5);
+            E = sol.first;
+        }
+        else if (eccentricity < 0.9)
+        {
+            // Higher eccentricity elliptical orbit; use a more complex but
+            // much faster converging iteration.
+            Solution sol = solve_iteration_fixed(SolveKeplerFunc2(eccentricity, M), M, 6);
+            // Debugging
+            // DPRINTF(LOG_LEVEL_INFO, "ecc: %f, error: %f mas\n",
+            //        eccentricity, radToDeg(sol.second) * 3600000);
+            E = sol.first;
+        }
+        else
+        {
+            // Extremely stable Laguerre-Conway method for solving Kepler's
+            // equation.  Only use this for high-eccentricity orbits, as it
+            // requires more calcuation.
+            double E0 = M + 0.85 * eccentricity * sign(sin(M));
+            Solution sol = solve_iteration_fixed(SolveKeplerLaguerreConway(eccentricity, M), E0, 8);
+            E = sol.first;
+        }
+
+        lastMeanAnomaly = M;
+        lastEccentricAnomaly = E;
+        haveLastAnomaly = true;
+        return E;
     }
-    else if (eccentricity == 1.0)
+    if (eccentricity == 1.0)
     {
         // Nearly parabolic orbit; very common for comets
         // TODO: handle this
@@ -435,23 +479,134 @@ double EllipticalOrbit::getBoundingRadius() const
 
 Vector3d CachingOrbit::positionAtTime(double jd) const
 {
-    if (jd != lastTime)
+    if (jd == lastTime && positionCacheValid)
+        return lastPosition;
+
+    // Serve the query from a fitted segment when one covers this time.
+    for (unsigned int i = 0; i < ChebSegmentCount; i++)
     {
-        lastTime = jd;
-        lastPosition = computePosition(jd);
-        positionCacheValid = true;
-        velocityCacheValid = false;
+        const ChebSegment& seg = segments[i];
+        if (seg.t1 >= seg.t0 && jd >= seg.t0 && jd <= seg.t1)
+        {
+            lastTime = jd;
+            lastPosition = evaluateSegment(seg, jd);
+            positionCacheValid = true;
+            velocityCacheValid = false;
+            return lastPosition;
+        }
     }
-    else if (!positionCacheValid)
+
+    lastTime = jd;
+    lastPosition = computePosition(jd);
+    positionCacheValid = true;
+    velocityCacheValid = false;
+
+    // Fitting a segment costs ChebDegree + 1 model evaluations, so only
+    // do it once several queries have landed in the same time window --
+    // the pattern produced by rendering, labels, picking and scripting
+    // all asking for a body's position as simulation time advances.
+    // A one-off sweep such as orbit path sampling stays on the direct
+    // path.
+    if (segmentSpan <= 0.0)
     {
-        lastPosition = computePosition(jd);
-        positionCacheValid = true;
+        double period = getPeriod();
+        segmentSpan = period > 0.0 ? period / 50.0 : 1.0;
+    }
+
+    double window = floor(jd / segmentSpan);
+    if (window == pendingWindow)
+    {
+        if (++pendingHits >= 4)
+        {
+            fitSegment(window * segmentSpan);
+            pendingHits = 0;
+        }
+    }
+    else
+    {
+        pendingWindow = window;
+        pendingHits = 1;
     }
 
     return lastPosition;
 }
 
 
+/*! Fit Chebyshev polynomials to the position over the window starting
+ *  at windowStart and store them in the segment ring. If the trailing
+ *  coefficients show the current span is too wide for the fastest terms
+ *  of this orbit, the span is halved instead and no segment is stored;
+ *  a later fit will retry at the finer granularity.
+ */
+void CachingOrbit::fitSegment(double windowStart) const
+{
+    const unsigned int n = ChebDegree + 1;
+    double half = segmentSpan * 0.5;
+    double mid = windowStart + half;
+
+    Vector3d samples[n];
+    for (unsigned int k = 0; k < n; k++)
+        samples[k] = computePosition(mid + half * cos(PI * (k + 0.5) / n));
+
+    ChebSegment seg;
+    for (unsigned int j = 0; j < n; j++)
+    {
+        for (unsigned int c = 0; c < 3; c++)
+        {
+            double sum = 0.0;
+            for (unsigned int k = 0; k < n; k++)
+                sum += samples[k][c] * cos(PI * j * (k + 0.5) / n);
+            seg.coeffs[c][j] = 2.0 * sum / n;
+        }
+    }
+
+    // The magnitude of the last coefficients bounds the interpolation
+    // error for a converging Chebyshev series.
+    double errEstimate = 0.0;
+    for (unsigned int c = 0; c < 3; c++)
+    {
+        errEstimate = max(errEstimate,
+                          fabs(seg.coeffs[c][ChebDegree - 1]) +
+                          fabs(seg.coeffs[c][ChebDegree]));
+    }
+
+    double tolerance = max(1.0e-3, getBoundingRadius() * 1.0e-12);
+    if (errEstimate > tolerance)
+    {
+        segmentSpan *= 0.5;
+        return;
+    }
+
+    seg.t0 = windowStart;
+    seg.t1 = windowStart + segmentSpan;
+    segments[nextSegment] = seg;
+    nextSegment = (nextSegment + 1) % ChebSegmentCount;
+}
+
+
+Vector3d CachingOrbit::evaluateSegment(const ChebSegment& seg, double jd) const
+{
+    // Clenshaw recurrence on x in [-1, 1]
+    double x = (2.0 * jd - (seg.t0 + seg.t1)) / (seg.t1 - seg.t0);
+
+    Vector3d result;
+    for (unsigned int c = 0; c < 3; c++)
+    {
+        double b1 = 0.0;
+        double b2 = 0.0;
+        for (int j = (int) ChebDegree; j >= 1; j--)
+        {
+            double b = 2.0 * x * b1 - b2 + seg.coeffs[c][j];
+            b2 = b1;
+            b1 = b;
+        }
+        result[c] = x * b1 - b2 + 0.5 * seg.coeffs[c][0];
+    }
+
+    return result;
+}
+
+
 Vector3d CachingOrbit::velocityAtTime(double jd) const
 {
     if (jd != lastTime)
@@ -84,6 +84,15 @@ class EllipticalOrbit : public Orbit
     double epoch;
 
     Eigen::Matrix3d orbitPlaneRotation;
+
+    // Warm-start state for Kepler's equation. Queries at steadily
+    // advancing times are the common case in the simulation; the
+    // eccentric anomaly then moves only slightly between calls and can
+    // be tracked with a single Newton step instead of a full iterative
+    // solve.
+    mutable double lastMeanAnomaly;
+    mutable double lastEccentricAnomaly;
+    mutable bool haveLastAnomaly;
 };
 
 
@@ -119,11 +128,35 @@ class CachingOrbit : public Orbit
     Eigen::Vector3d velocityAtTime(double jd) const;
 
  private:
+    static const unsigned int ChebDegree = 10;
+    static const unsigned int ChebSegmentCount = 4;
+
+    //! One Chebyshev-fitted segment of the orbit: within [t0, t1] the
+    //! position is served by polynomial evaluation instead of the
+    //! expensive model. t1 < t0 marks an empty slot.
+    struct ChebSegment
+    {
+        double t0{ 0.0 };
+        double t1{ -1.0 };
+        double coeffs[3][ChebDegree + 1];
+    };
+
+    Eigen::Vector3d evaluateSegment(const ChebSegment& seg, double jd) const;
+    void fitSegment(double windowStart) const;
+
     mutable Eigen::Vector3d lastPosition;
     mutable Eigen::Vector3d lastVelocity;
     mutable double lastTime{ -1.0e30 };
     mutable bool positionCacheValid{ false };
     mutable bool velocityCacheValid{ false };
+
+    // Ring of fitted segments plus the heuristic state used to decide
+    // when fitting one is worth its sample evaluations.
+    mutable ChebSegment segments[ChebSegmentCount];
+    mutable unsigned int nextSegment{ 0 };
+    mutable double segmentSpan{ 0.0 };
+    mutable double pendingWindow{ 0.0 };
+    mutable int pendingHits{ 0 };
 };
 
 
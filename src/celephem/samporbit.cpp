@@ -16,13 +16,18 @@
 #include <celengine/astro.h>
 #include <celmath/mathlib.h>
 #include <celutil/bytes.h>
+#include <celutil/compress.h>
+#include <celutil/memmap.h>
 #include <celutil/util.h> // intl.h
 #include <cmath>
+#include <cstring>
 #include <string>
+#include <system_error>
 #include <algorithm>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <limits>
 #include <iomanip>
 #include <celutil/debug.h>
@@ -665,6 +670,679 @@ template <typename T> void SampledOrbitXYZV<T>::sample(double /* startTime */, d
 }
 
 
+// Memory mapped binary xyzv trajectory. Instead of parsing the whole
+// file into memory, the record array is left on disk and windowed in
+// on demand: a sparse in-memory index of chunk start times (one double
+// per XYZVBinaryChunkSamples records) narrows every lookup to a single
+// chunk, so only the pages around the current time are ever touched
+// and residency stays at a few MB even for multi-GB trajectories.
+// When playback crosses into a new chunk, the next chunk in the
+// direction time is moving is prefetched asynchronously by the OS.
+class StreamedOrbitXYZV : public CachingOrbit
+{
+public:
+    StreamedOrbitXYZV(TrajectoryInterpolation _interpolation);
+    ~StreamedOrbitXYZV() override = default;
+
+    bool open(const fs::path& filename);
+
+    double getPeriod() const override;
+    double getBoundingRadius() const override;
+    Vector3d computePosition(double jd) const override;
+    Vector3d computeVelocity(double jd) const override;
+
+    bool isPeriodic() const override;
+    void getValidRange(double& begin, double& end) const override;
+
+    void sample(double startTime, double endTime, OrbitSampleProc& proc) const override;
+
+private:
+    size_t findSample(double jd) const;
+    void prefetchNeighbor(size_t n, double jd) const;
+
+    MemoryMappedFile mappedFile;
+    const XYZVBinaryData* samples{ nullptr };
+    size_t sampleCount{ 0 };
+    vector<double> chunkStartTimes;
+    double boundingRadius{ 0.0 };
+    TrajectoryInterpolation interpolation;
+
+    mutable size_t lastSample{ 0 };
+    mutable double lastQueryTime{ 0.0 };
+    mutable size_t prefetchedChunk{ (size_t) -1 };
+};
+
+
+StreamedOrbitXYZV::StreamedOrbitXYZV(TrajectoryInterpolation _interpolation) :
+    interpolation(_interpolation)
+{
+}
+
+
+bool StreamedOrbitXYZV::open(const fs::path& filename)
+{
+    if (!mappedFile.map(filename))
+        return false;
+
+    if (mappedFile.size() < sizeof(XYZVBinaryHeader) + sizeof(XYZVBinaryData))
+        return false;
+
+    XYZVBinaryHeader header;
+    memcpy(&header, mappedFile.data(), sizeof(header));
+
+    if (string(header.magic) != "CELXYZV")
+        return false;
+    if (header.byteOrder != __BYTE_ORDER__)
+        return false;
+    if (header.digits != std::numeric_limits<double>::digits)
+        return false;
+    if (header.count == 0)
+        return false;
+
+    sampleCount = (mappedFile.size() - sizeof(XYZVBinaryHeader)) / sizeof(XYZVBinaryData);
+    if ((uint64_t) sampleCount > header.count)
+        sampleCount = (size_t) header.count;
+    samples = reinterpret_cast<const XYZVBinaryData*>(mappedFile.data() + sizeof(XYZVBinaryHeader));
+
+    // Access is a small moving window; keep the kernel from reading the
+    // whole file ahead of us.
+    mappedFile.adviseRandom();
+
+    // Build the time index from the first record of every chunk. Only one
+    // page per chunk is touched here, so this pass stays cheap even for
+    // very large files.
+    chunkStartTimes.reserve(sampleCount / XYZVBinaryChunkSamples + 1);
+    double maxRadius = 0.0;
+    for (size_t i = 0; i < sampleCount; i += XYZVBinaryChunkSamples)
+    {
+        chunkStartTimes.push_back(samples[i].tdb);
+        double r = Map<const Vector3d>(samples[i].position).norm();
+        if (r > maxRadius)
+            maxRadius = r;
+    }
+    double rLast = Map<const Vector3d>(samples[sampleCount - 1].position).norm();
+    if (rLast > maxRadius)
+        maxRadius = rLast;
+
+    // The radius is sampled at chunk granularity rather than measured
+    // exactly; pad it, since the bounding radius is only ever used for
+    // conservative tests where overestimating is safe.
+    boundingRadius = maxRadius * 1.25;
+
+    return true;
+}
+
+
+double StreamedOrbitXYZV::getPeriod() const
+{
+    return samples[sampleCount - 1].tdb - samples[0].tdb;
+}
+
+
+bool StreamedOrbitXYZV::isPeriodic() const
+{
+    return false;
+}
+
+
+void StreamedOrbitXYZV::getValidRange(double& begin, double& end) const
+{
+    begin = samples[0].tdb;
+    end = samples[sampleCount - 1].tdb;
+}
+
+
+double StreamedOrbitXYZV::getBoundingRadius() const
+{
+    return boundingRadius;
+}
+
+
+// Return the index of the first sample with t >= jd, touching only the
+// chunk that brackets jd. Mirrors the lower_bound semantics of the in
+// memory sampled orbits.
+size_t StreamedOrbitXYZV::findSample(double jd) const
+{
+    size_t n = lastSample;
+    if (n >= 1 && n < sampleCount && jd >= samples[n - 1].tdb && jd <= samples[n].tdb)
+        return n;
+
+    size_t chunk = upper_bound(chunkStartTimes.begin(), chunkStartTimes.end(), jd) -
+                   chunkStartTimes.begin();
+    if (chunk > 0)
+        chunk--;
+
+    // The bracketing pair may straddle a chunk boundary, so include the
+    // first record of the next chunk in the search range.
+    size_t begin = chunk * XYZVBinaryChunkSamples;
+    size_t end = min(begin + XYZVBinaryChunkSamples + 1, sampleCount);
+
+    while (begin < end)
+    {
+        size_t mid = begin + (end - begin) / 2;
+        if (samples[mid].tdb < jd)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+
+    lastSample = begin;
+    return begin;
+}
+
+
+// Hint the OS to page in the neighboring chunk in the direction time is
+// moving, so playback never stalls on a chunk boundary.
+void StreamedOrbitXYZV::prefetchNeighbor(size_t n, double jd) const
+{
+    size_t chunk = n / XYZVBinaryChunkSamples;
+    size_t neighbor;
+    if (jd >= lastQueryTime)
+        neighbor = chunk + 1;
+    else if (chunk > 0)
+        neighbor = chunk - 1;
+    else
+        neighbor = chunk;
+    lastQueryTime = jd;
+
+    if (neighbor == prefetchedChunk || neighbor >= chunkStartTimes.size())
+        return;
+    prefetchedChunk = neighbor;
+
+    mappedFile.prefetch(sizeof(XYZVBinaryHeader) +
+                            neighbor * XYZVBinaryChunkSamples * sizeof(XYZVBinaryData),
+                        XYZVBinaryChunkSamples * sizeof(XYZVBinaryData));
+}
+
+
+Vector3d StreamedOrbitXYZV::computePosition(double jd) const
+{
+    size_t n = findSample(jd);
+    prefetchNeighbor(n, jd);
+
+    Vector3d pos;
+    if (n == 0)
+    {
+        pos = Map<const Vector3d>(samples[0].position);
+    }
+    else if (n < sampleCount)
+    {
+        const XYZVBinaryData& s0 = samples[n - 1];
+        const XYZVBinaryData& s1 = samples[n];
+
+        double h = s1.tdb - s0.tdb;
+        if (h <= 0.0)
+        {
+            pos = Map<const Vector3d>(s1.position);
+        }
+        else if (interpolation == TrajectoryInterpolationCubic)
+        {
+            double t = (jd - s0.tdb) / h;
+            Vector3d p0 = Map<const Vector3d>(s0.position);
+            Vector3d p1 = Map<const Vector3d>(s1.position);
+            // Velocities in the file are km/sec; cubicInterpolate()
+            // wants them scaled to the span of the segment.
+            double vscale = astro::daysToSecs(1.0) * h;
+            pos = cubicInterpolate(p0, Map<const Vector3d>(s0.velocity) * vscale,
+                                   p1, Map<const Vector3d>(s1.velocity) * vscale,
+                                   t);
+        }
+        else
+        {
+            double t = (jd - s0.tdb) / h;
+            Vector3d p0 = Map<const Vector3d>(s0.position);
+            Vector3d p1 = Map<const Vector3d>(s1.position);
+            pos = p0 + t * (p1 - p0);
+        }
+    }
+    else
+    {
+        pos = Map<const Vector3d>(samples[sampleCount - 1].position);
+    }
+
+    // Add correction for Celestia's coordinate system
+    return Vector3d(pos.x(), pos.z(), -pos.y());
+}
+
+
+Vector3d StreamedOrbitXYZV::computeVelocity(double jd) const
+{
+    size_t n = findSample(jd);
+
+    Vector3d vel(Vector3d::Zero());
+    if (n > 0 && n < sampleCount)
+    {
+        const XYZVBinaryData& s0 = samples[n - 1];
+        const XYZVBinaryData& s1 = samples[n];
+
+        double h = s1.tdb - s0.tdb;
+        if (h <= 0.0)
+        {
+            vel = Map<const Vector3d>(s1.velocity) * astro::daysToSecs(1.0);
+        }
+        else if (interpolation == TrajectoryInterpolationCubic)
+        {
+            double t = (jd - s0.tdb) / h;
+            double vscale = astro::daysToSecs(1.0) * h;
+            Vector3d p0 = Map<const Vector3d>(s0.position);
+            Vector3d p1 = Map<const Vector3d>(s1.position);
+            vel = cubicInterpolateVelocity(p0, Map<const Vector3d>(s0.velocity) * vscale,
+                                           p1, Map<const Vector3d>(s1.velocity) * vscale,
+                                           t) * (1.0 / h);
+        }
+        else
+        {
+            vel = (Map<const Vector3d>(s1.position) - Map<const Vector3d>(s0.position)) * (1.0 / h);
+        }
+    }
+
+    // Add correction for Celestia's coordinate system
+    return Vector3d(vel.x(), vel.z(), -vel.y());
+}
+
+
+void StreamedOrbitXYZV::sample(double startTime, double endTime,
+                               OrbitSampleProc& proc) const
+{
+    // Unlike the in-memory sampled orbits, honor the requested range so
+    // drawing the path of a mission-length trajectory doesn't page the
+    // whole file in.
+    size_t begin = findSample(startTime);
+    if (begin > 0)
+        begin--;
+    size_t end = findSample(endTime);
+    if (end < sampleCount)
+        end++;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        Vector3d p = Map<const Vector3d>(samples[i].position);
+        Vector3d v = Map<const Vector3d>(samples[i].velocity) * astro::daysToSecs(1.0);
+        proc.sample(samples[i].tdb,
+                    Vector3d(p.x(), p.z(), -p.y()),
+                    Vector3d(v.x(), v.z(), -v.y()));
+    }
+}
+
+
+// Trajectories below this size are simply parsed into memory; windowed
+// streaming only pays off once the resident copy would be substantial.
+static const size_t StreamedTrajectoryThreshold = 16 * 1024 * 1024;
+
+static Orbit* LoadStreamedOrbitXYZV(const fs::path& filename, TrajectoryInterpolation interpolation)
+{
+    error_code ec;
+    uintmax_t fileSize = fs::file_size(filename, ec);
+    if (ec || fileSize < StreamedTrajectoryThreshold)
+        return nullptr;
+
+    auto* orbit = new StreamedOrbitXYZV(interpolation);
+    if (!orbit->open(filename))
+    {
+        delete orbit;
+        return nullptr;
+    }
+
+    return orbit;
+}
+
+
+// Evaluate a Chebyshev series by the Clenshaw recurrence.
+static double chebEval(const double coeffs[], double u)
+{
+    double b1 = 0.0;
+    double b2 = 0.0;
+    for (int k = (int) XYZVChebyshevDegree; k >= 1; k--)
+    {
+        double b0 = 2.0 * u * b1 - b2 + coeffs[k];
+        b2 = b1;
+        b1 = b0;
+    }
+    return u * b1 - b2 + coeffs[0];
+}
+
+
+// Derivative of a Chebyshev series with respect to u, computed by
+// differentiating the Clenshaw recurrence alongside it.
+static double chebEvalDeriv(const double coeffs[], double u)
+{
+    double b1 = 0.0, b2 = 0.0;
+    double db1 = 0.0, db2 = 0.0;
+    for (int k = (int) XYZVChebyshevDegree; k >= 1; k--)
+    {
+        double db0 = 2.0 * b1 + 2.0 * u * db1 - db2;
+        double b0 = 2.0 * u * b1 - b2 + coeffs[k];
+        db2 = db1;
+        db1 = db0;
+        b2 = b1;
+        b1 = b0;
+    }
+    return b1 + u * db1 - db2;
+}
+
+
+// Memory mapped compressed binary xyzv trajectory (see xyzvbinary.h).
+// Like StreamedOrbitXYZV the record array stays on disk and is
+// windowed in on demand, but samples are 16-byte quantized residuals
+// against a per-block Chebyshev predictor instead of 56-byte raw
+// records, so the on-disk footprint shrinks by 3.5x and the pages a
+// playback window touches shrink with it. The block descriptors
+// double as the time index.
+class CompressedOrbitXYZV : public CachingOrbit
+{
+public:
+    CompressedOrbitXYZV(TrajectoryInterpolation _interpolation);
+    ~CompressedOrbitXYZV() override = default;
+
+    bool open(const fs::path& filename);
+
+    double getPeriod() const override;
+    double getBoundingRadius() const override;
+    Vector3d computePosition(double jd) const override;
+    Vector3d computeVelocity(double jd) const override;
+
+    bool isPeriodic() const override;
+    void getValidRange(double& begin, double& end) const override;
+
+    void sample(double startTime, double endTime, OrbitSampleProc& proc) const override;
+
+private:
+    size_t findSample(double jd) const;
+    double sampleTime(size_t n) const;
+    void decodeSample(size_t n, double& tdb, Vector3d& position, Vector3d& velocity) const;
+
+    MemoryMappedFile mappedFile;
+    const XYZVCompressedBlock* blocks{ nullptr };
+    const XYZVCompressedSample* samples{ nullptr };
+    size_t blockCount{ 0 };
+    size_t sampleCount{ 0 };
+    double boundingRadius{ 0.0 };
+    TrajectoryInterpolation interpolation;
+
+    mutable size_t lastSample{ 0 };
+};
+
+
+CompressedOrbitXYZV::CompressedOrbitXYZV(TrajectoryInterpolation _interpolation) :
+    interpolation(_interpolation)
+{
+}
+
+
+bool CompressedOrbitXYZV::open(const fs::path& filename)
+{
+    if (!mappedFile.map(filename))
+        return false;
+
+    if (mappedFile.size() < sizeof(XYZVCompressedHeader))
+        return false;
+
+    XYZVCompressedHeader header;
+    memcpy(&header, mappedFile.data(), sizeof(header));
+
+    if (memcmp(header.magic, "CELXYZVC", 8) != 0)
+        return false;
+    if (header.byteOrder != __BYTE_ORDER__)
+        return false;
+    if (header.digits != std::numeric_limits<double>::digits)
+        return false;
+    if (header.count == 0 || header.blockCount == 0)
+        return false;
+
+    size_t required = sizeof(XYZVCompressedHeader) +
+                      (size_t) header.blockCount * sizeof(XYZVCompressedBlock) +
+                      (size_t) header.count * sizeof(XYZVCompressedSample);
+    if (mappedFile.size() < required)
+        return false;
+
+    blockCount = (size_t) header.blockCount;
+    sampleCount = (size_t) header.count;
+    blocks = reinterpret_cast<const XYZVCompressedBlock*>(
+        mappedFile.data() + sizeof(XYZVCompressedHeader));
+    samples = reinterpret_cast<const XYZVCompressedSample*>(
+        mappedFile.data() + sizeof(XYZVCompressedHeader) +
+        blockCount * sizeof(XYZVCompressedBlock));
+
+    mappedFile.adviseRandom();
+
+    // An upper bound on the radius follows from the coefficients alone:
+    // |T_k| <= 1, so each axis is bounded by the sum of its coefficient
+    // magnitudes plus the worst quantized residual. Only the block
+    // index is touched.
+    double maxRadius = 0.0;
+    for (size_t b = 0; b < blockCount; b++)
+    {
+        Vector3d bound;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double sum = 0.0;
+            for (unsigned int k = 0; k <= XYZVChebyshevDegree; k++)
+                sum += fabs(blocks[b].coeffs[axis][k]);
+            bound[axis] = sum + 32767.0 * blocks[b].posScale;
+        }
+        maxRadius = max(maxRadius, bound.norm());
+    }
+    boundingRadius = maxRadius;
+
+    return true;
+}
+
+
+double CompressedOrbitXYZV::getPeriod() const
+{
+    return blocks[blockCount - 1].endTime - blocks[0].startTime;
+}
+
+
+bool CompressedOrbitXYZV::isPeriodic() const
+{
+    return false;
+}
+
+
+void CompressedOrbitXYZV::getValidRange(double& begin, double& end) const
+{
+    begin = blocks[0].startTime;
+    end = blocks[blockCount - 1].endTime;
+}
+
+
+double CompressedOrbitXYZV::getBoundingRadius() const
+{
+    return boundingRadius;
+}
+
+
+double CompressedOrbitXYZV::sampleTime(size_t n) const
+{
+    return blocks[n / XYZVCompressedBlockSamples].startTime +
+           samples[n].timeOffset;
+}
+
+
+// Reconstruct sample n: the block predictor evaluated at the sample's
+// time plus the dequantized residuals. Velocities come back in km/sec,
+// matching the raw binary format.
+void CompressedOrbitXYZV::decodeSample(size_t n, double& tdb,
+                                       Vector3d& position, Vector3d& velocity) const
+{
+    const XYZVCompressedBlock& block = blocks[n / XYZVCompressedBlockSamples];
+    const XYZVCompressedSample& s = samples[n];
+
+    tdb = block.startTime + s.timeOffset;
+
+    double span = block.endTime - block.startTime;
+    double u = span > 0.0 ? 2.0 * (tdb - block.startTime) / span - 1.0 : 0.0;
+    double dudt = span > 0.0 ? 2.0 / span : 0.0;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        position[axis] = chebEval(block.coeffs[axis], u) +
+                         s.position[axis] * block.posScale;
+        // The predictor derivative is km/day; residuals and the result
+        // are km/sec.
+        velocity[axis] = chebEvalDeriv(block.coeffs[axis], u) * dudt /
+                             astro::daysToSecs(1.0) +
+                         s.velocity[axis] * block.velScale;
+    }
+}
+
+
+// Return the index of the first sample with t >= jd; only the block
+// bracketing jd is touched.
+size_t CompressedOrbitXYZV::findSample(double jd) const
+{
+    size_t n = lastSample;
+    if (n >= 1 && n < sampleCount &&
+        jd >= sampleTime(n - 1) && jd <= sampleTime(n))
+        return n;
+
+    size_t lo = 0;
+    size_t hi = blockCount;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (blocks[mid].startTime <= jd)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t block = lo > 0 ? lo - 1 : 0;
+
+    // The bracketing pair may straddle a block boundary, so include the
+    // first record of the next block in the search range.
+    size_t begin = block * XYZVCompressedBlockSamples;
+    size_t end = min(begin + XYZVCompressedBlockSamples + 1, sampleCount);
+
+    while (begin < end)
+    {
+        size_t mid = begin + (end - begin) / 2;
+        if (sampleTime(mid) < jd)
+            begin = mid + 1;
+        else
+            end = mid;
+    }
+
+    lastSample = begin;
+    return begin;
+}
+
+
+Vector3d CompressedOrbitXYZV::computePosition(double jd) const
+{
+    size_t n = findSample(jd);
+
+    double t0, t1;
+    Vector3d p0, p1, v0, v1;
+    Vector3d pos;
+    if (n == 0)
+    {
+        decodeSample(0, t0, pos, v0);
+    }
+    else if (n < sampleCount)
+    {
+        decodeSample(n - 1, t0, p0, v0);
+        decodeSample(n, t1, p1, v1);
+
+        double h = t1 - t0;
+        if (h <= 0.0)
+        {
+            pos = p1;
+        }
+        else if (interpolation == TrajectoryInterpolationCubic)
+        {
+            double t = (jd - t0) / h;
+            double vscale = astro::daysToSecs(1.0) * h;
+            pos = cubicInterpolate(p0, v0 * vscale, p1, v1 * vscale, t);
+        }
+        else
+        {
+            double t = (jd - t0) / h;
+            pos = p0 + t * (p1 - p0);
+        }
+    }
+    else
+    {
+        decodeSample(sampleCount - 1, t0, pos, v0);
+    }
+
+    // Add correction for Celestia's coordinate system
+    return Vector3d(pos.x(), pos.z(), -pos.y());
+}
+
+
+Vector3d CompressedOrbitXYZV::computeVelocity(double jd) const
+{
+    size_t n = findSample(jd);
+
+    Vector3d vel(Vector3d::Zero());
+    if (n > 0 && n < sampleCount)
+    {
+        double t0, t1;
+        Vector3d p0, p1, v0, v1;
+        decodeSample(n - 1, t0, p0, v0);
+        decodeSample(n, t1, p1, v1);
+
+        double h = t1 - t0;
+        if (h <= 0.0)
+        {
+            vel = v1 * astro::daysToSecs(1.0);
+        }
+        else if (interpolation == TrajectoryInterpolationCubic)
+        {
+            double t = (jd - t0) / h;
+            double vscale = astro::daysToSecs(1.0) * h;
+            vel = cubicInterpolateVelocity(p0, v0 * vscale,
+                                           p1, v1 * vscale,
+                                           t) * (1.0 / h);
+        }
+        else
+        {
+            vel = (p1 - p0) * (1.0 / h);
+        }
+    }
+
+    // Add correction for Celestia's coordinate system
+    return Vector3d(vel.x(), vel.z(), -vel.y());
+}
+
+
+void CompressedOrbitXYZV::sample(double startTime, double endTime,
+                                 OrbitSampleProc& proc) const
+{
+    size_t begin = findSample(startTime);
+    if (begin > 0)
+        begin--;
+    size_t end = findSample(endTime);
+    if (end < sampleCount)
+        end++;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        double tdb;
+        Vector3d p, v;
+        decodeSample(i, tdb, p, v);
+        v *= astro::daysToSecs(1.0);
+        proc.sample(tdb,
+                    Vector3d(p.x(), p.z(), -p.y()),
+                    Vector3d(v.x(), v.z(), -v.y()));
+    }
+}
+
+
+static Orbit* LoadCompressedOrbitXYZV(const fs::path& filename, TrajectoryInterpolation interpolation)
+{
+    auto* orbit = new CompressedOrbitXYZV(interpolation);
+    if (!orbit->open(filename))
+    {
+        delete orbit;
+        return nullptr;
+    }
+
+    return orbit;
+}
+
+
 // Scan past comments. A comment begins with the # character and ends
 // with a newline. Return true if the stream state is good. The stream
 // position will be at the first non-comment, non-whitespace character.
@@ -725,9 +1403,12 @@ static bool SkipComments(istream& in)
 
 template <typename T> SampledOrbit<T>* LoadSampledOrbit(const fs::path& filename, TrajectoryInterpolation interpolation, T /*unused*/)
 {
-    ifstream in(filename.string());
-    if (!in.good())
+    // Read through the decompression helper so gzip compressed
+    // trajectories load transparently.
+    string contents;
+    if (!ReadPossiblyCompressedFile(filename, contents))
         return nullptr;
+    istringstream in(contents);
 
     if (!SkipComments(in))
         return nullptr;
@@ -780,9 +1461,10 @@ template <typename T> SampledOrbit<T>* LoadSampledOrbit(const fs::path& filename
 
 template <typename T> SampledOrbitXYZV<T>* LoadSampledOrbitXYZV(const fs::path& filename, TrajectoryInterpolation interpolation, T /*unused*/)
 {
-    ifstream in(filename.string());
-    if (!in.good())
+    string contents;
+    if (!ReadPossiblyCompressedFile(filename, contents))
         return nullptr;
+    istringstream in(contents);
 
     if (!SkipComments(in))
         return nullptr;
@@ -915,7 +1597,16 @@ Orbit* LoadSampledTrajectoryDoublePrec(const fs::path& filename, TrajectoryInter
 Orbit* LoadXYZVTrajectorySinglePrec(const fs::path& filename, TrajectoryInterpolation interpolation)
 {
     auto f = filename;
-    Orbit* ret = LoadSampledOrbitXYZVBinary(f += fs::path("bin"), interpolation, 0.0f); // FIXME
+    f += fs::path("bin"); // FIXME
+    Orbit* ret = LoadCompressedOrbitXYZV(f, interpolation);
+    if (ret != nullptr)
+        return ret;
+
+    ret = LoadStreamedOrbitXYZV(f, interpolation);
+    if (ret != nullptr)
+        return ret;
+
+    ret = LoadSampledOrbitXYZVBinary(f, interpolation, 0.0f);
     if (ret != nullptr)
         return ret;
 
@@ -928,7 +1619,16 @@ Orbit* LoadXYZVTrajectorySinglePrec(const fs::path& filename, TrajectoryInterpol
 Orbit* LoadXYZVTrajectoryDoublePrec(const fs::path& filename, TrajectoryInterpolation interpolation)
 {
     auto f = filename;
-    Orbit* ret = LoadSampledOrbitXYZVBinary(f += fs::path("bin"), interpolation, 0.0); // FIXME
+    f += fs::path("bin"); // FIXME
+    Orbit* ret = LoadCompressedOrbitXYZV(f, interpolation);
+    if (ret != nullptr)
+        return ret;
+
+    ret = LoadStreamedOrbitXYZV(f, interpolation);
+    if (ret != nullptr)
+        return ret;
+
+    ret = LoadSampledOrbitXYZVBinary(f, interpolation, 0.0);
     if (ret != nullptr)
         return ret;
 
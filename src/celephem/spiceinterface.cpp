@@ -24,6 +24,13 @@ using namespace std;
 static set<fs::path> ResidentSpiceKernels;
 
 
+std::recursive_mutex& GetSpiceLock()
+{
+    static std::recursive_mutex spiceLock;
+    return spiceLock;
+}
+
+
 /*! Perform one-time initialization of SPICE.
  */
 bool
@@ -43,6 +50,8 @@ InitializeSpice()
  */
 bool GetNaifId(const string& name, int* id)
 {
+    lock_guard<recursive_mutex> lock(GetSpiceLock());
+
     SpiceInt spiceID = 0;
     SpiceBoolean found = SPICEFALSE;
 
@@ -76,6 +85,7 @@ bool GetNaifId(const string& name, int* id)
  */
 bool IsSpiceKernelLoaded(const fs::path& filepath)
 {
+    lock_guard<recursive_mutex> lock(GetSpiceLock());
     return ResidentSpiceKernels.find(filepath) != ResidentSpiceKernels.end();
 }
 
@@ -85,6 +95,8 @@ bool IsSpiceKernelLoaded(const fs::path& filepath)
  */
 bool LoadSpiceKernel(const fs::path& filepath)
 {
+    lock_guard<recursive_mutex> lock(GetSpiceLock());
+
     // Only load the kernel if it is not already resident. Note that this detection
     // of duplicate kernels will not work if a file was originally loaded through
     // a metakernel.
@@ -13,6 +13,7 @@
 #define _CELENGINE_SPICEINTERFACE_H_
 
 #include <string>
+#include <mutex>
 #include <celcompat/filesystem.h>
 
 extern bool InitializeSpice();
@@ -23,4 +24,11 @@ extern bool GetNaifId(const std::string& name, int* id);
 extern bool IsSpiceKernelLoaded(const fs::path& filepath);
 extern bool LoadSpiceKernel(const fs::path& filepath);
 
+/*! CSPICE is not thread safe: it keeps its kernel pool and error state
+ *  in globals. Every call into the toolkit must hold this lock. It is
+ *  recursive so that helpers like LoadSpiceKernel can be called both on
+ *  their own and from within a locked section.
+ */
+extern std::recursive_mutex& GetSpiceLock();
+
 #endif // _CELENGINE_SPICEINTERFACE_H_
@@ -12,6 +12,7 @@
 #include <iostream>
 #include <cstdio>
 #include <utility>
+#include <algorithm>
 #include "SpiceUsr.h"
 #include <celengine/astro.h>
 #include "spiceorbit.h"
@@ -23,6 +24,11 @@ using namespace std;
 
 static const double MILLISEC = astro::secsToDays(0.001);
 
+// Number of states the lookahead thread evaluates per request, and the
+// ring capacity they are handed over in.
+static const unsigned int PrefetchBatchSize = 32;
+static const unsigned int PrefetchRingSize = 64;
+
 /*! Create a new SPICE orbit using with a valid interval specified
  *  by beginning and ending.
  */
@@ -67,6 +73,23 @@ SpiceOrbit::SpiceOrbit(std::string  _targetBodyName,
 }
 
 
+SpiceOrbit::~SpiceOrbit()
+{
+    if (prefetchWorker.joinable())
+    {
+        {
+            lock_guard<mutex> lock(prefetchMutex);
+            prefetchExit = true;
+        }
+        prefetchCondition.notify_one();
+        prefetchWorker.join();
+    }
+
+    if (loadThread.joinable())
+        loadThread.join();
+}
+
+
 bool
 SpiceOrbit::isPeriodic() const
 {
@@ -84,10 +107,31 @@ SpiceOrbit::getPeriod() const
 }
 
 
+void
+SpiceOrbit::initAsync(const fs::path& path,
+                      const list<string>* requiredKernels)
+{
+    asyncPath = path;
+    if (requiredKernels != nullptr)
+        asyncKernels = *requiredKernels;
+    asyncIntervalBegin = validIntervalBegin;
+    asyncIntervalEnd = validIntervalEnd;
+
+    loadState.store(LoadingKernels, memory_order_release);
+    loadThread = thread([this]() {
+        init(asyncPath, asyncKernels.empty() ? nullptr : &asyncKernels);
+        loadState.store(ReadyAsync, memory_order_release);
+    });
+}
+
+
 bool
 SpiceOrbit::init(const fs::path& path,
                  const list<string>* requiredKernels)
 {
+    // Everything here talks to CSPICE, which keeps global state
+    lock_guard<recursive_mutex> spiceLock(GetSpiceLock());
+
     // Load required kernel files
     if (requiredKernels != nullptr)
     {
@@ -232,9 +276,170 @@ SpiceOrbit::init(const fs::path& path,
 }
 
 
+// The prefetch worker sleeps until the render thread posts a predicted
+// time range, then batch-evaluates states and hands them over through
+// the lock-free ring. Holding the SPICE lock here blocks loaders and
+// other SPICE orbits, but not the frame loop, which interpolates from
+// previously prefetched states.
+void
+SpiceOrbit::prefetchThread()
+{
+    for (;;)
+    {
+        double start, step;
+        {
+            unique_lock<mutex> lock(prefetchMutex);
+            prefetchCondition.wait(lock, [this]() {
+                return prefetchExit || prefetchRequest != prefetchServed;
+            });
+            if (prefetchExit)
+                return;
+            prefetchServed = prefetchRequest;
+            start = prefetchStart;
+            step = prefetchStep;
+        }
+
+        lock_guard<recursive_mutex> spiceLock(GetSpiceLock());
+        for (unsigned int i = 0; i < PrefetchBatchSize; i++)
+        {
+            double jd = start + step * i;
+            if (jd < validIntervalBegin || jd > validIntervalEnd)
+                break;
+
+            PrefetchedState state;
+            state.t = jd;
+
+            double t = astro::daysToSecs(jd - astro::J2000);
+            double stateVec[6];
+            double lt;
+            spkgeo_c(targetID, t, "eclipj2000", originID, stateVec, &lt);
+            if (failed_c())
+            {
+                reset_c();
+                break;
+            }
+
+            double d2s = astro::daysToSecs(1.0);
+            for (int k = 0; k < 3; k++)
+            {
+                state.position[k] = stateVec[k];
+                state.velocity[k] = stateVec[k + 3] * d2s;
+            }
+
+            if (!prefetchRing->push(state))
+                break;
+        }
+    }
+}
+
+
+/*! Post the predicted query times for upcoming frames to the lookahead
+ *  thread. The prediction is simply the last observed time step, which
+ *  matches the frame loop's steady advance; on time jumps or rate
+ *  changes the first query misses the window and reseeds the predictor.
+ */
+void
+SpiceOrbit::requestPrefetch(double jd) const
+{
+    double step = jd - lastQueryTime;
+    lastQueryTime = jd;
+
+    // Don't bother prefetching for repeated queries at one time, or at
+    // extreme time acceleration where interpolating between frames is
+    // no longer meaningful.
+    if (step == 0.0 || fabs(step) > 10.0)
+        return;
+
+    if (prefetchRing == nullptr)
+    {
+        prefetchRing.reset(new SPSCRingBuffer<PrefetchedState>(PrefetchRingSize));
+        prefetchWorker = thread(&SpiceOrbit::prefetchThread,
+                                const_cast<SpiceOrbit*>(this));
+    }
+
+    {
+        lock_guard<mutex> lock(prefetchMutex);
+        prefetchStart = jd + step;
+        prefetchStep = step;
+        prefetchRequest++;
+    }
+    prefetchCondition.notify_one();
+}
+
+
+/*! Serve a position query from the prefetched states when a bracketing
+ *  pair is available: drain the ring into the sorted lookup window and
+ *  cubically interpolate position and velocity across the bracketing
+ *  samples. Returns false (leaving the caller to evaluate directly)
+ *  when jd falls outside the prefetched window.
+ */
+bool
+SpiceOrbit::interpolatePrefetched(double jd, Vector3d& pos) const
+{
+    if (prefetchRing == nullptr)
+        return false;
+
+    PrefetchedState incoming;
+    while (prefetchRing->pop(incoming))
+        prefetchWindow.push_back(incoming);
+
+    if (prefetchWindow.size() < 2)
+        return false;
+
+    sort(prefetchWindow.begin(), prefetchWindow.end(),
+         [](const PrefetchedState& a, const PrefetchedState& b) { return a.t < b.t; });
+
+    // Keep the window from growing without bound when predictions miss
+    if (prefetchWindow.size() > 4 * PrefetchRingSize)
+        prefetchWindow.erase(prefetchWindow.begin(),
+                             prefetchWindow.begin() + prefetchWindow.size() / 2);
+
+    // Find the bracketing pair
+    unsigned int n = 0;
+    while (n < prefetchWindow.size() && prefetchWindow[n].t < jd)
+        n++;
+    if (n == 0 || n == prefetchWindow.size())
+        return false;
+
+    const PrefetchedState& s0 = prefetchWindow[n - 1];
+    const PrefetchedState& s1 = prefetchWindow[n];
+
+    // Only interpolate across a single prediction step; wider gaps mean
+    // the samples aren't from a contiguous prefetch run.
+    double h = s1.t - s0.t;
+    if (h <= 0.0 || h > fabs(prefetchStep) * 2.0)
+        return false;
+
+    // Cubic Hermite interpolation using the prefetched velocities; with
+    // frame-interval sample spacing the error is far below the accuracy
+    // of the ephemeris itself.
+    double u = (jd - s0.t) / h;
+    double u2 = u * u;
+    double u3 = u2 * u;
+    double w0 = 2.0 * u3 - 3.0 * u2 + 1.0;
+    double w1 = u3 - 2.0 * u2 + u;
+    double w2 = -2.0 * u3 + 3.0 * u2;
+    double w3 = u3 - u2;
+
+    for (int k = 0; k < 3; k++)
+    {
+        pos[k] = w0 * s0.position[k] + w1 * h * s0.velocity[k] +
+                 w2 * s1.position[k] + w3 * h * s1.velocity[k];
+    }
+
+    return true;
+}
+
+
 Vector3d
 SpiceOrbit::computePosition(double jd) const
 {
+    // While kernels are still loading on the background thread the
+    // coverage interval isn't known yet; report the fallback position
+    // at the origin until loading completes.
+    if (!isReady())
+        return Vector3d::Zero();
+
     if (jd < validIntervalBegin)
         jd = validIntervalBegin;
     else if (jd > validIntervalEnd)
@@ -246,11 +451,29 @@ SpiceOrbit::computePosition(double jd) const
     }
     else
     {
+        Vector3d interpolated;
+        if (interpolatePrefetched(jd, interpolated))
+        {
+            // Top up the lookahead when the query approaches the edge
+            // of the prefetched window
+            double lead = prefetchStep >= 0.0 ? prefetchWindow.back().t - jd
+                                              : jd - prefetchWindow.front().t;
+            if (lead < fabs(prefetchStep) * (PrefetchBatchSize / 2))
+                requestPrefetch(jd);
+            else
+                lastQueryTime = jd;
+
+            return Vector3d(interpolated.x(), interpolated.z(), -interpolated.y());
+        }
+
+        requestPrefetch(jd);
+
         // Input time for SPICE is seconds after J2000
         double t = astro::daysToSecs(jd - astro::J2000);
         double position[3];
         double lt;          // One way light travel time
 
+        lock_guard<recursive_mutex> spiceLock(GetSpiceLock());
         spkgps_c(targetID,
                  t,
                  "eclipj2000",
@@ -280,6 +503,9 @@ SpiceOrbit::computePosition(double jd) const
 Vector3d
 SpiceOrbit::computeVelocity(double jd) const
 {
+    if (!isReady())
+        return Vector3d::Zero();
+
     if (jd < validIntervalBegin)
         jd = validIntervalBegin;
     else if (jd > validIntervalEnd)
@@ -296,6 +522,7 @@ SpiceOrbit::computeVelocity(double jd) const
         double state[6];
         double lt;          // One way light travel time
 
+        lock_guard<recursive_mutex> spiceLock(GetSpiceLock());
         spkgeo_c(targetID,
                  t,
                  "eclipj2000",
@@ -325,6 +552,15 @@ SpiceOrbit::computeVelocity(double jd) const
 
 void SpiceOrbit::getValidRange(double& begin, double& end) const
 {
+    // The load thread rewrites the live interval; serve the values from
+    // construction time until it has finished.
+    if (!isReady())
+    {
+        begin = asyncIntervalBegin;
+        end = asyncIntervalEnd;
+        return;
+    }
+
     begin = validIntervalBegin;
     end = validIntervalEnd;
 }
@@ -15,7 +15,14 @@
 #include "orbit.h"
 #include <string>
 #include <list>
+#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <celcompat/filesystem.h>
+#include <celutil/ringbuffer.h>
 
 
 class SpiceOrbit : public CachingOrbit
@@ -31,11 +38,26 @@ class SpiceOrbit : public CachingOrbit
                std::string  _originName,
                double _period,
                double _boundingRadius);
-    virtual ~SpiceOrbit() = default;
+    virtual ~SpiceOrbit();
 
     bool init(const fs::path& path,
               const std::list<std::string>* requiredKernels);
 
+    /*! Load kernels and compute the coverage window on a background
+     *  thread instead of blocking the caller. Until loading finishes
+     *  the orbit reports a position at the origin; the renderer can
+     *  poll isReady() to find out when real positions are available.
+     */
+    void initAsync(const fs::path& path,
+                   const std::list<std::string>* requiredKernels);
+
+    //! Return true once asynchronous loading has finished (successfully
+    //! or not). Orbits initialized synchronously are always ready.
+    bool isReady() const
+    {
+        return loadState.load(std::memory_order_acquire) != LoadingKernels;
+    }
+
     virtual bool isPeriodic() const;
     virtual double getPeriod() const;
 
@@ -50,6 +72,26 @@ class SpiceOrbit : public CachingOrbit
     virtual void getValidRange(double& begin, double& end) const;
 
  private:
+    enum LoadState
+    {
+        ReadySync,       // initialized synchronously; members are stable
+        LoadingKernels,  // background init in progress
+        ReadyAsync,      // background init finished
+    };
+
+    // One state prefetched by the lookahead thread. Position in km and
+    // velocity in km/Julian day, both still in the SPICE ecliptic frame.
+    struct PrefetchedState
+    {
+        double t;
+        double position[3];
+        double velocity[3];
+    };
+
+    void prefetchThread();
+    bool interpolatePrefetched(double jd, Eigen::Vector3d& pos) const;
+    void requestPrefetch(double jd) const;
+
     const std::string targetBodyName;
     const std::string originName;
     double period;
@@ -64,6 +106,32 @@ class SpiceOrbit : public CachingOrbit
     double validIntervalEnd;
 
     bool useDefaultTimeInterval;
+
+    std::atomic<int> loadState{ ReadySync };
+    std::thread loadThread;
+    fs::path asyncPath;
+    std::list<std::string> asyncKernels;
+    // Copies of the coverage interval taken before the load thread
+    // starts, served to callers while it is rewriting the live values.
+    double asyncIntervalBegin{ 0.0 };
+    double asyncIntervalEnd{ 0.0 };
+
+    // Lookahead evaluation: the frame loop's queries advance at a nearly
+    // constant rate, so a worker thread batch-evaluates states for the
+    // predicted upcoming times into a lock-free ring and the render
+    // thread serves queries by Hermite interpolation between them,
+    // keeping CSPICE (and its global lock) off the frame loop.
+    mutable std::unique_ptr<SPSCRingBuffer<PrefetchedState> > prefetchRing;
+    mutable std::vector<PrefetchedState> prefetchWindow;
+    mutable std::thread prefetchWorker;
+    mutable std::mutex prefetchMutex;
+    mutable std::condition_variable prefetchCondition;
+    mutable double prefetchStart{ 0.0 };
+    mutable double prefetchStep{ 0.0 };
+    mutable unsigned int prefetchRequest{ 0 };
+    unsigned int prefetchServed{ 0 };
+    bool prefetchExit{ false };
+    mutable double lastQueryTime{ 0.0 };
 };
 
 #endif // _CELENGINE_SPICEORBIT_H_
@@ -13,10 +13,16 @@
 // of the License, or (at your option) any later version.
 
 #include <cmath>
+#include <vector>
 #include <celmath/mathlib.h>
 #include <celengine/astro.h>
 #include "vsop87.h"
 
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(_M_X64)
+#define VSOP87_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 using namespace Eigen;
 using namespace std;
 
@@ -34,6 +40,15 @@ struct VSOPSeries
     int nTerms;
 };
 
+// One Poisson series with the amplitudes, phases and frequencies split
+// into separate arrays. The static VSOPTerm tables produced by
+// vsoptrunc stay in AoS form; each orbit converts them once at
+// construction so SumSeries() can stream A, B and C contiguously.
+struct VSOPSeriesSoA
+{
+    vector<double> A, B, C;
+};
+
 // Terms from the VSOP87 Planetary Theories
 // Bretagnon P., Francou G.
 // Astron. Astrophys. 202, 309 (1988)
@@ -10998,42 +11013,222 @@ static VSOPSeries sun_Z[] = {
 };
 
 
-static double SumSeries(const VSOPSeries& series, double t)
+static vector<VSOPSeriesSoA> ConvertToSoA(const VSOPSeries* series, int nSeries)
+{
+    vector<VSOPSeriesSoA> soa(nSeries);
+    for (int i = 0; i < nSeries; i++)
+    {
+        soa[i].A.reserve(series[i].nTerms);
+        soa[i].B.reserve(series[i].nTerms);
+        soa[i].C.reserve(series[i].nTerms);
+        for (int j = 0; j < series[i].nTerms; j++)
+        {
+            soa[i].A.push_back(series[i].terms[j].A);
+            soa[i].B.push_back(series[i].terms[j].B);
+            soa[i].C.push_back(series[i].terms[j].C);
+        }
+    }
+    return soa;
+}
+
+
+#ifdef VSOP87_USE_SSE2
+// Evaluate cos() on both lanes of an SSE2 double vector. This is the
+// standard Cephes-style reduction into octants of the circle followed
+// by Taylor polynomials on |z| <= pi/4, good to about 1 ulp -- far
+// below the truncation error of the VSOP87 series themselves. The
+// reduction overflows for arguments beyond about 1e9 radians;
+// SumSeries() checks for that and falls back to std::cos.
+static inline __m128d CosSSE2(__m128d x)
+{
+    // cos is even, so drop the sign
+    x = _mm_andnot_pd(_mm_set1_pd(-0.0), x);
+
+    // Number of whole pi/4 octants below x, rounded up to even
+    __m128d y = _mm_mul_pd(x, _mm_set1_pd(1.27323954473516268615)); // 4/pi
+    __m128i j = _mm_cvttpd_epi32(y);
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    y = _mm_cvtepi32_pd(j);
+
+    // Extended precision modular arithmetic: z = x - y * pi/4, with
+    // pi/4 split into three parts so the products are exact.
+    __m128d z = _mm_sub_pd(x, _mm_mul_pd(y, _mm_set1_pd(7.85398125648498535156e-1)));
+    z = _mm_sub_pd(z, _mm_mul_pd(y, _mm_set1_pd(3.77489470793079817668e-8)));
+    z = _mm_sub_pd(z, _mm_mul_pd(y, _mm_set1_pd(2.69515142907905952645e-15)));
+    __m128d zz = _mm_mul_pd(z, z);
+
+    // With j even, bits 1 and 2 of j select the octant: octants 2 and 6
+    // need the sine polynomial, octants 2 and 4 flip the sign.
+    __m128i useSin32 = _mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)),
+                                       _mm_set1_epi32(2));
+    __m128i negate32 = _mm_cmpeq_epi32(_mm_and_si128(_mm_xor_si128(_mm_srli_epi32(j, 1),
+                                                                   _mm_srli_epi32(j, 2)),
+                                                     _mm_set1_epi32(1)),
+                                       _mm_set1_epi32(1));
+    __m128d useSin = _mm_castsi128_pd(_mm_shuffle_epi32(useSin32, _MM_SHUFFLE(1, 1, 0, 0)));
+    __m128d negate = _mm_castsi128_pd(_mm_shuffle_epi32(negate32, _MM_SHUFFLE(1, 1, 0, 0)));
+
+    // Taylor polynomials in Horner form; the coefficients are exact
+    // reciprocal factorials.
+    __m128d p = _mm_set1_pd(-1.0 / 1307674368000.0);                     // -1/15!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(1.0 / 6227020800.0));  //  1/13!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(-1.0 / 39916800.0));   // -1/11!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(1.0 / 362880.0));      //  1/9!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(-1.0 / 5040.0));       // -1/7!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(1.0 / 120.0));         //  1/5!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(-1.0 / 6.0));          // -1/3!
+    p = _mm_add_pd(_mm_mul_pd(p, zz), _mm_set1_pd(1.0));
+    __m128d sinz = _mm_mul_pd(z, p);
+
+    __m128d q = _mm_set1_pd(1.0 / 20922789888000.0);                     //  1/16!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(-1.0 / 87178291200.0)); // -1/14!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(1.0 / 479001600.0));   //  1/12!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(-1.0 / 3628800.0));    // -1/10!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(1.0 / 40320.0));       //  1/8!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(-1.0 / 720.0));        // -1/6!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(1.0 / 24.0));          //  1/4!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(-1.0 / 2.0));          // -1/2!
+    q = _mm_add_pd(_mm_mul_pd(q, zz), _mm_set1_pd(1.0));
+
+    __m128d r = _mm_or_pd(_mm_and_pd(useSin, sinz), _mm_andnot_pd(useSin, q));
+    return _mm_xor_pd(r, _mm_and_pd(negate, _mm_set1_pd(-0.0)));
+}
+#endif // VSOP87_USE_SSE2
+
+
+// Position tolerance tiers for truncated series evaluation. Tier 0 is
+// full precision; the others allow the evaluation loop to stop once the
+// dropped tail of a series can no longer move the result by more than
+// the stated tolerance. Term counts per tier are precomputed when an
+// orbit is constructed.
+static const double VSOPTierToleranceKm[] = { 0.0, 1.0, 100.0 };
+static const unsigned int VSOPTierCount = sizeof(VSOPTierToleranceKm) / sizeof(VSOPTierToleranceKm[0]);
+
+// Largest |t| (Julian millennia from J2000) at which the truncated
+// series may be evaluated; MixedOrbit limits VSOP87 to years
+// -4000..4000, so the t^i factors on the higher series are bounded.
+static const double VSOPMaxT = 6.0;
+
+
+// Number of leading terms needed to keep the truncation error of one
+// series below maxError in the series' own units; the dropped tail can
+// contribute at most the sum of its amplitudes.
+static size_t TermsForTolerance(const VSOPSeriesSoA& series, double maxError)
 {
-    if (series.nTerms < 1)
-        return 0.0;
+    double tail = 0.0;
+    size_t n = series.A.size();
+    while (n > 0 && tail + fabs(series.A[n - 1]) <= maxError)
+    {
+        tail += fabs(series.A[n - 1]);
+        n--;
+    }
+    return n;
+}
 
+
+// Precompute, for each tolerance tier, how many terms of each series of
+// one variable must be evaluated. kmPerUnit converts the series' units
+// into kilometers (KM_PER_AU for radius series; the orbit radius for
+// the angular ones). The error budget is split evenly across the
+// series of the variable, discounting the t^i factor each one carries.
+static vector<vector<size_t> > BuildTierCounts(const vector<VSOPSeriesSoA>& vs,
+                                               double kmPerUnit)
+{
+    vector<vector<size_t> > counts(VSOPTierCount, vector<size_t>(vs.size()));
+    for (unsigned int tier = 0; tier < VSOPTierCount; tier++)
+    {
+        for (size_t i = 0; i < vs.size(); i++)
+        {
+            if (VSOPTierToleranceKm[tier] == 0.0)
+            {
+                counts[tier][i] = vs[i].A.size();
+            }
+            else
+            {
+                double maxError = VSOPTierToleranceKm[tier] / kmPerUnit /
+                    (double) vs.size() / pow(VSOPMaxT, (double) i);
+                counts[tier][i] = TermsForTolerance(vs[i], maxError);
+            }
+        }
+    }
+    return counts;
+}
+
+
+static double SumSeries(const VSOPSeriesSoA& series, double t, size_t nTerms)
+{
     double x = 0.0;
-    VSOPTerm* term = &series.terms[0];
-    for (int i = 0; i < series.nTerms; i++, term++)
-        x += term->A * cos(term->B + term->C * t);
+    size_t i = 0;
+
+#ifdef VSOP87_USE_SSE2
+    // Four terms per iteration: two independent accumulators hide the
+    // latency of the polynomial evaluation in CosSSE2().
+    const __m128d vt = _mm_set1_pd(t);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d limit = _mm_set1_pd(1.0e9);
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    for (; i + 4 <= nTerms; i += 4)
+    {
+        __m128d ph0 = _mm_add_pd(_mm_loadu_pd(&series.B[i]),
+                                 _mm_mul_pd(_mm_loadu_pd(&series.C[i]), vt));
+        __m128d ph1 = _mm_add_pd(_mm_loadu_pd(&series.B[i + 2]),
+                                 _mm_mul_pd(_mm_loadu_pd(&series.C[i + 2]), vt));
+
+        // The octant reduction in CosSSE2() breaks down for extremely
+        // large phase angles; punt to the scalar loop if one shows up.
+        __m128d mag = _mm_max_pd(_mm_andnot_pd(signMask, ph0),
+                                 _mm_andnot_pd(signMask, ph1));
+        if (_mm_movemask_pd(_mm_cmpgt_pd(mag, limit)) != 0)
+            break;
+
+        sum0 = _mm_add_pd(sum0, _mm_mul_pd(_mm_loadu_pd(&series.A[i]), CosSSE2(ph0)));
+        sum1 = _mm_add_pd(sum1, _mm_mul_pd(_mm_loadu_pd(&series.A[i + 2]), CosSSE2(ph1)));
+    }
+
+    double partial[2];
+    _mm_storeu_pd(partial, _mm_add_pd(sum0, sum1));
+    x = partial[0] + partial[1];
+#endif
+
+    for (; i < nTerms; i++)
+        x += series.A[i] * cos(series.B[i] + series.C[i] * t);
 
     return x;
-};
+}
 
 class VSOP87Orbit : public CachingOrbit
 {
  private:
-    VSOPSeries* vsL;
-    int nL;
-    VSOPSeries* vsB;
-    int nB;
-    VSOPSeries* vsR;
-    int nR;
+    vector<VSOPSeriesSoA> vsL;
+    vector<VSOPSeriesSoA> vsB;
+    vector<VSOPSeriesSoA> vsR;
+    vector<vector<size_t> > tierCountsL;
+    vector<vector<size_t> > tierCountsB;
+    vector<vector<size_t> > tierCountsR;
     double period;
     double boundingRadius;
 
+    // Tier used by computePosition(); selected by sample() while the
+    // adaptive sampler runs, full precision otherwise. Mutable because
+    // sample() is const.
+    mutable unsigned int activeTier;
+
  public:
     VSOP87Orbit(VSOPSeries* _vsL, int _nL,
                 VSOPSeries* _vsB, int _nB,
                 VSOPSeries* _vsR, int _nR,
                 double _period,
                 double _boundingRadius) :
-        vsL(_vsL), nL(_nL),
-        vsB(_vsB), nB(_nB),
-        vsR(_vsR), nR(_nR),
+        vsL(ConvertToSoA(_vsL, _nL)),
+        vsB(ConvertToSoA(_vsB, _nB)),
+        vsR(ConvertToSoA(_vsR, _nR)),
+        tierCountsL(BuildTierCounts(vsL, _boundingRadius)),
+        tierCountsB(BuildTierCounts(vsB, _boundingRadius)),
+        tierCountsR(BuildTierCounts(vsR, KM_PER_AU)),
         period(_period),
-        boundingRadius(_boundingRadius)
+        boundingRadius(_boundingRadius),
+        activeTier(0)
     {
     };
     ~VSOP87Orbit() override = default;
@@ -11053,37 +11248,25 @@ class VSOP87Orbit : public CachingOrbit
         // t is Julian millenia since J2000.0
         double t = (jd - 2451545.0) / 365250.0;
 
-        // Heliocentric coordinates
+        // Heliocentric coordinates; accumulate the power series for
+        // each variable with Horner's scheme.
         double l = 0.0; // longitude
         double b = 0.0; // latitude
         double r = 0.0; // radius
 
         int i;
-        double T;
 
         // Evaluate series for l
-        T = 1;
-        for (i = 0; i < nL; i++)
-        {
-            l += SumSeries(vsL[i], t) * T;
-            T = t * T;
-        }
+        for (i = (int) vsL.size() - 1; i >= 0; i--)
+            l = l * t + SumSeries(vsL[i], t, tierCountsL[activeTier][i]);
 
         // Evaluate series for b
-        T = 1;
-        for (i = 0; i < nB; i++)
-        {
-            b += SumSeries(vsB[i], t) * T;
-            T = t * T;
-        }
+        for (i = (int) vsB.size() - 1; i >= 0; i--)
+            b = b * t + SumSeries(vsB[i], t, tierCountsB[activeTier][i]);
 
         // Evaluate series for r
-        T = 1;
-        for (i = 0; i < nR; i++)
-        {
-            r += SumSeries(vsR[i], t) * T;
-            T = t * T;
-        }
+        for (i = (int) vsR.size() - 1; i >= 0; i--)
+            r = r * t + SumSeries(vsR[i], t, tierCountsR[activeTier][i]);
 
         r *= KM_PER_AU;
 
@@ -11114,7 +11297,27 @@ class VSOP87Orbit : public CachingOrbit
         samplingParams.minStep   = samplingParams.startStep;
         samplingParams.maxStep   = samplingParams.startStep;
 
+        // Path generation doesn't need sub-kilometer accuracy, so
+        // evaluate the series truncated to the sampling tolerance while
+        // the sampler runs. At worst one position computed at reduced
+        // precision stays behind in the CachingOrbit cache, and its
+        // error is below the tolerance used to draw the path anyway.
+        activeTier = tierForTolerance(samplingParams.tolerance);
         adaptiveSample(startTime, endTime, proc, samplingParams);
+        activeTier = 0;
+    }
+
+    //! The highest (cheapest) evaluation tier whose precomputed
+    //! truncation error stays below the requested tolerance.
+    unsigned int tierForTolerance(double toleranceKm) const
+    {
+        unsigned int tier = 0;
+        for (unsigned int i = 1; i < VSOPTierCount; i++)
+        {
+            if (VSOPTierToleranceKm[i] <= toleranceKm)
+                tier = i;
+        }
+        return tier;
     }
 
 };
@@ -11124,12 +11327,9 @@ class VSOP87Orbit : public CachingOrbit
 class VSOP87OrbitRect : public CachingOrbit
 {
  private:
-    VSOPSeries* vsX;
-    int nX;
-    VSOPSeries* vsY;
-    int nY;
-    VSOPSeries* vsZ;
-    int nZ;
+    vector<VSOPSeriesSoA> vsX;
+    vector<VSOPSeriesSoA> vsY;
+    vector<VSOPSeriesSoA> vsZ;
     double period;
     double boundingRadius;
 
@@ -11139,9 +11339,9 @@ class VSOP87OrbitRect : public CachingOrbit
                     VSOPSeries* _vsZ, int _nZ,
                     double _period,
                     double _boundingRadius) :
-        vsX(_vsX), nX(_nX),
-        vsY(_vsY), nY(_nY),
-        vsZ(_vsZ), nZ(_nZ),
+        vsX(ConvertToSoA(_vsX, _nX)),
+        vsY(ConvertToSoA(_vsY, _nY)),
+        vsZ(ConvertToSoA(_vsZ, _nZ)),
         period(_period),
         boundingRadius(_boundingRadius)
     {
@@ -11171,31 +11371,18 @@ class VSOP87OrbitRect : public CachingOrbit
         Vector3d v(Vector3d::Zero());
 
         int i;
-        double T;
 
         // Evaluate series for x
-        T = 1;
-        for (i = 0; i < nX; i++)
-        {
-            v.x() += SumSeries(vsX[i], t) * T;
-            T = t * T;
-        }
+        for (i = (int) vsX.size() - 1; i >= 0; i--)
+            v.x() = v.x() * t + SumSeries(vsX[i], t, vsX[i].A.size());
 
         // Evaluate series for y
-        T = 1;
-        for (i = 0; i < nY; i++)
-        {
-            v.y() += SumSeries(vsY[i], t) * T;
-            T = t * T;
-        }
+        for (i = (int) vsY.size() - 1; i >= 0; i--)
+            v.y() = v.y() * t + SumSeries(vsY[i], t, vsY[i].A.size());
 
         // Evaluate series for z
-        T = 1;
-        for (i = 0; i < nZ; i++)
-        {
-            v.z() += SumSeries(vsZ[i], t) * T;
-            T = t * T;
-        }
+        for (i = (int) vsZ.size() - 1; i >= 0; i--)
+            v.z() = v.z() * t + SumSeries(vsZ[i], t, vsZ[i].A.size());
 
         v *= KM_PER_AU;
 
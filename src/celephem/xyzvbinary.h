@@ -2,6 +2,14 @@
 
 #include <cstdint>
 
+// A binary xyzv file consists of an XYZVBinaryHeader followed
+// immediately by header.count XYZVBinaryData records sorted by
+// ascending tdb. Because the records are fixed size and time
+// ordered, no explicit index is stored in the file; readers can
+// locate any epoch with a binary search, and streaming readers
+// treat the record array as chunks of XYZVBinaryChunkSamples
+// records whose start times form an implicit time index.
+
 struct XYZVBinaryHeader
 {
     char magic[8];
@@ -17,3 +25,57 @@ struct XYZVBinaryData
     double position[3];
     double velocity[3];
 };
+
+// Chunk granularity used by streaming readers; 4096 records is 224KB,
+// small enough that a handful of chunks keeps residency at a few MB.
+static const uint32_t XYZVBinaryChunkSamples = 4096;
+
+
+// Compressed binary xyzv format. The file consists of an
+// XYZVCompressedHeader, an array of header.blockCount
+// XYZVCompressedBlock descriptors forming the time index, and then
+// header.count XYZVCompressedSample records. Every block holds exactly
+// XYZVCompressedBlockSamples samples except the last, so block b's
+// samples start at record b * XYZVCompressedBlockSamples.
+//
+// Each block stores a Chebyshev polynomial fitted to its positions
+// over [startTime, endTime]; samples store only the residual against
+// that predictor (and against its derivative, for velocities),
+// quantized to 16 bits with per-block scales. Since the scales adapt
+// to the worst residual in each block, precision degrades only where
+// the predictor genuinely misses, and a 56-byte double-precision
+// record shrinks to 16 bytes.
+
+struct XYZVCompressedHeader
+{
+    char magic[8];        // "CELXYZVC", no terminator
+    uint16_t byteOrder;
+    uint16_t digits;
+    uint32_t reserved;
+    uint64_t count;       // total number of samples
+    uint64_t blockCount;
+};
+
+// Keep blocks shorter than one orbital period of a typical low orbit
+// sampled at a minute or so, or the polynomial cannot track the
+// motion and the residual scales blow up.
+static const uint32_t XYZVCompressedBlockSamples = 64;
+static const uint32_t XYZVChebyshevDegree = 8;
+
+struct XYZVCompressedBlock
+{
+    double startTime;     // tdb of the first sample
+    double endTime;       // tdb of the last sample
+    double posScale;      // km per residual unit
+    double velScale;      // km/sec per residual unit
+    double coeffs[3][XYZVChebyshevDegree + 1];
+    uint32_t sampleCount;
+    uint32_t reserved;
+};
+
+struct XYZVCompressedSample
+{
+    float timeOffset;     // days since the block's startTime
+    int16_t position[3];  // quantized residual against the predictor
+    int16_t velocity[3];  // quantized residual against its derivative
+};
@@ -0,0 +1,192 @@
+// anomalyrecorder.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Flight recorder for intermittent frame-time spikes.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+#include <celutil/debug.h>
+#include <fmt/printf.h>
+#include "anomalyrecorder.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Ring depth: a few seconds of lead-in at typical frame rates, so the
+// report shows what the application was doing before the spike.
+const unsigned int RingFrames = 256;
+
+// Frames recorded after the trigger before the report is written, so
+// the recovery is captured too.
+const unsigned int TrailingFrames = 30;
+
+// Minimum wall-clock seconds between reports; a sustained stall
+// produces one report, not one per frame.
+const double ReportInterval = 10.0;
+
+
+// Format a cumulative-counter delta between consecutive frames,
+// tolerating the counter resetting (e.g. after process-external
+// resource churn).
+int64_t counterDelta(uint64_t current, uint64_t previous)
+{
+    return current >= previous ? (int64_t) (current - previous) : 0;
+}
+
+
+const FrameDiagnostics::Alloc* findTag(const FrameDiagnostics& frame,
+                                       const string& tag)
+{
+    for (const auto& alloc : frame.allocs)
+    {
+        if (alloc.tag == tag)
+            return &alloc;
+    }
+    return nullptr;
+}
+
+} // end unnamed namespace
+
+
+AnomalyRecorder::AnomalyRecorder(double _thresholdMs) :
+    thresholdMs(_thresholdMs),
+    ring(RingFrames)
+{
+}
+
+
+void AnomalyRecorder::recordFrame(FrameDiagnostics& frame)
+{
+    frame.frameNumber = nextFrameNumber++;
+    ring[ringPos] = frame;
+    ringPos = (ringPos + 1) % RingFrames;
+    if (ringCount < RingFrames)
+        ringCount++;
+
+    if (!triggered)
+    {
+        if (frame.frameTimeMs > thresholdMs &&
+            frame.wallTime - lastReportWallTime > ReportInterval)
+        {
+            triggered = true;
+            trailingRemaining = TrailingFrames;
+            triggerFrame = frame.frameNumber;
+            triggerMs = frame.frameTimeMs;
+        }
+        return;
+    }
+
+    // A worse frame inside the trailing window becomes the new
+    // trigger and restarts the window, so the report centers on the
+    // deepest point of the stall.
+    if (frame.frameTimeMs > triggerMs)
+    {
+        trailingRemaining = TrailingFrames;
+        triggerFrame = frame.frameNumber;
+        triggerMs = frame.frameTimeMs;
+        return;
+    }
+
+    if (--trailingRemaining == 0)
+    {
+        flush();
+        triggered = false;
+        lastReportWallTime = frame.wallTime;
+    }
+}
+
+
+void AnomalyRecorder::flush()
+{
+    time_t now = time(nullptr);
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+
+    string filename = fmt::sprintf("celestia-anomaly-%s-f%llu.txt",
+                                   stamp,
+                                   (unsigned long long) triggerFrame);
+    ofstream out(filename, ios::out | ios::trunc);
+    if (!out.good())
+    {
+        DPRINTF(LOG_LEVEL_ERROR,
+                "Cannot write anomaly report %s\n", filename);
+        return;
+    }
+
+    fmt::fprintf(out, "Celestia frame-time anomaly report\n");
+    fmt::fprintf(out, "trigger: frame %llu, %.1f ms (threshold %.1f ms)\n",
+                 (unsigned long long) triggerFrame, triggerMs, thresholdMs);
+    fmt::fprintf(out, "window: %u frames (%u after trigger)\n\n",
+                 ringCount, TrailingFrames);
+
+    // Frames are stored oldest-first starting at ringPos once the
+    // ring has wrapped.
+    unsigned int start = ringCount < RingFrames ? 0 : ringPos;
+    const FrameDiagnostics* prev = nullptr;
+    for (unsigned int i = 0; i < ringCount; i++)
+    {
+        const FrameDiagnostics& frame = ring[(start + i) % RingFrames];
+
+        fmt::fprintf(out, "frame %llu  t %.3f  tdb %.8f  %7.2f ms%s\n",
+                     (unsigned long long) frame.frameNumber,
+                     frame.wallTime,
+                     frame.tdb,
+                     frame.frameTimeMs,
+                     frame.frameNumber == triggerFrame ? "  <<< spike" : "");
+
+        for (const auto& pass : frame.passes)
+        {
+            fmt::fprintf(out, "    pass %-24s cpu %7.2f ms  gpu %7.2f ms\n",
+                         pass.name, pass.cpuTimeMs, pass.gpuTimeMs);
+        }
+
+        for (const auto& alloc : frame.allocs)
+        {
+            const FrameDiagnostics::Alloc* prevAlloc =
+                prev != nullptr ? findTag(*prev, alloc.tag) : nullptr;
+            int64_t dAllocs = counterDelta(alloc.allocations,
+                                           prevAlloc != nullptr ? prevAlloc->allocations : alloc.allocations);
+            int64_t dBytes = counterDelta(alloc.bytesAllocated,
+                                          prevAlloc != nullptr ? prevAlloc->bytesAllocated : alloc.bytesAllocated);
+            if (prev != nullptr && dAllocs == 0)
+                continue;
+            fmt::fprintf(out, "    alloc %-23s +%lld allocs  +%lld bytes  live %llu\n",
+                         alloc.tag,
+                         (long long) dAllocs,
+                         (long long) dBytes,
+                         (unsigned long long) alloc.liveBytes);
+        }
+
+        if (frame.residentBytes != 0 || frame.evictedBytes != 0)
+        {
+            int64_t dEvicted = prev != nullptr
+                ? counterDelta(frame.evictedBytes, prev->evictedBytes) : 0;
+            int64_t dRuns = prev != nullptr
+                ? counterDelta(frame.evictionRuns, prev->evictionRuns) : 0;
+            fmt::fprintf(out, "    resources resident %llu bytes",
+                         (unsigned long long) frame.residentBytes);
+            if (dEvicted > 0 || dRuns > 0)
+                fmt::fprintf(out, "  evicted +%lld bytes in %lld runs",
+                             (long long) dEvicted, (long long) dRuns);
+            fmt::fprintf(out, "\n");
+        }
+
+        prev = &frame;
+    }
+
+    nReports++;
+    DPRINTF(LOG_LEVEL_ERROR,
+            "Frame-time anomaly (%.1f ms); report written to %s\n",
+            triggerMs, filename);
+}
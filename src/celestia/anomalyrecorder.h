@@ -0,0 +1,103 @@
+// anomalyrecorder.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Flight recorder for intermittent frame-time spikes.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELESTIA_ANOMALYRECORDER_H_
+#define _CELESTIA_ANOMALYRECORDER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+//! One frame's worth of diagnostic detail, gathered by CelestiaCore
+//! after each draw. Pass timings and allocation counters are copied
+//! from the renderer and allocation tracker; the allocation and
+//! eviction counters are cumulative, so the report derives per-frame
+//! deltas from consecutive records.
+struct FrameDiagnostics
+{
+    std::uint64_t frameNumber{ 0 };
+    double wallTime{ 0.0 };      // app clock, seconds
+    double tdb{ 0.0 };           // simulation time of the frame
+    double frameTimeMs{ 0.0 };   // total draw() wall time
+
+    struct Pass
+    {
+        std::string name;
+        double cpuTimeMs{ 0.0 };
+        double gpuTimeMs{ 0.0 };
+    };
+    std::vector<Pass> passes;
+
+    struct Alloc
+    {
+        std::string tag;
+        std::uint64_t allocations{ 0 };
+        std::uint64_t bytesAllocated{ 0 };
+        std::uint64_t liveBytes{ 0 };
+    };
+    std::vector<Alloc> allocs;
+
+    std::uintmax_t residentBytes{ 0 };
+    std::uintmax_t evictedBytes{ 0 };
+    unsigned int evictionRuns{ 0 };
+};
+
+
+/*! AnomalyRecorder keeps the last few seconds of per-frame diagnostics
+ *  in a fixed-size ring. When a frame exceeds the configured threshold
+ *  it keeps recording through a short trailing window and then writes
+ *  the entire ring -- the frames leading up to the spike, the spike
+ *  itself, and its aftermath -- to a timestamped report file, giving a
+ *  post-hoc view of stutters that never reproduce under a profiler. It
+ *  is cheap enough to leave armed for whole sessions: per frame it
+ *  costs one ring slot overwrite, and the report path runs only after
+ *  a spike. Reports are rate limited so a sustained stall does not
+ *  flood the disk.
+ */
+class AnomalyRecorder
+{
+ public:
+    explicit AnomalyRecorder(double _thresholdMs);
+
+    double threshold() const
+    {
+        return thresholdMs;
+    }
+
+    //! Append one frame to the ring and flush a report if a spike's
+    //! trailing window just completed.
+    void recordFrame(FrameDiagnostics& frame);
+
+    unsigned int reportCount() const
+    {
+        return nReports;
+    }
+
+ private:
+    void flush();
+
+    double thresholdMs;
+
+    std::vector<FrameDiagnostics> ring;
+    unsigned int ringPos{ 0 };
+    unsigned int ringCount{ 0 };
+    std::uint64_t nextFrameNumber{ 0 };
+
+    bool triggered{ false };
+    unsigned int trailingRemaining{ 0 };
+    std::uint64_t triggerFrame{ 0 };
+    double triggerMs{ 0.0 };
+    double lastReportWallTime{ 0.0 };
+    unsigned int nReports{ 0 };
+};
+
+#endif // _CELESTIA_ANOMALYRECORDER_H_
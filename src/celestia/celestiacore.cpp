@@ -14,7 +14,11 @@
 // of the License, or (at your option) any later version.
 
 #include "celestiacore.h"
+#include "anomalyrecorder.h"
+#include "clustersync.h"
 #include "favorites.h"
+#include "scenetrace.h"
+#include "telemetry.h"
 #include "url.h"
 #include <celengine/astro.h>
 #include <celengine/asterism.h>
@@ -24,15 +28,29 @@
 #include <celscript/legacy/execution.h>
 #include <celscript/legacy/cmdparser.h>
 #include <celengine/multitexture.h>
+#include <celengine/meshmanager.h>
+#include <celengine/glstats.h>
+#include <celengine/texmanager.h>
+#include <celengine/compiledcatalog.h>
 #ifdef USE_SPICE
 #include <celephem/spiceinterface.h>
 #endif
 #include <celengine/axisarrow.h>
+#include <celengine/renderglsl.h>
 #include <celengine/planetgrid.h>
+#include <celengine/virtualtex.h>
 #include <celengine/visibleregion.h>
 #include <celmath/geomutil.h>
 #include <celutil/util.h>
+#include <celutil/alloctag.h>
+#include <celutil/asyncfile.h>
+#include <celutil/compress.h>
 #include <celutil/filetype.h>
+#include <celutil/packfile.h>
+#include <celutil/resbudget.h>
+#include <celutil/profiler.h>
+#include <celutil/tracelog.h>
+#include <celutil/memaudit.h>
 #include <celutil/formatnum.h>
 #include <celutil/debug.h>
 #include <celutil/utf8.h>
@@ -42,12 +60,19 @@
 #include <GL/glew.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <condition_variable>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <deque>
 #include <iomanip>
 #include <algorithm>
 #include <cstdlib>
 #include <cctype>
 #include <cstring>
 #include <cassert>
+#include <csignal>
 #include <ctime>
 #include <set>
 #include <celutil/debug.h>
@@ -170,6 +195,12 @@ CelestiaCore::~CelestiaCore()
     if (movieCapture != nullptr)
         recordEnd();
 
+    TraceLog::stop();
+
+    delete clusterSync;
+    delete sceneTrace;
+    delete anomalyRecorder;
+    delete telemetry;
     delete timer;
     delete renderer;
 }
@@ -1055,6 +1086,12 @@ void CelestiaCore::charEntered(const char *c_p, int modifiers)
         notifyWatchers(RenderFlagsChanged);
         break;
 
+    case '\017': // Ctrl+O
+        showGLStats = !showGLStats;
+        flash(showGLStats ? _("Driver call counters enabled")
+                          : _("Driver call counters disabled"));
+        break;
+
     case '\007':  // Ctrl+G
         flash(_("Goto surface"));
         addToHistory();
@@ -1720,6 +1757,12 @@ void CelestiaCore::charEntered(const char *c_p, int modifiers)
 
     case '`':
         showFPSCounter = !showFPSCounter;
+        // The per-pass cost table shares the FPS counter toggle; the
+        // renderer only issues timer queries while it is visible. The
+        // anomaly recorder also feeds on pass timings, so it keeps
+        // them running regardless of the counter.
+        renderer->setPassTimingEnabled(showFPSCounter ||
+                                       anomalyRecorder != nullptr);
         break;
 
     case '{':
@@ -1879,19 +1922,29 @@ void CelestiaCore::setStartURL(string url)
 
 void CelestiaCore::tick()
 {
+    CELTRACE_SCOPE("tick");
+
+    GetMemoryAudit().dumpIfRequested(cerr);
+
     double lastTime = sysTime;
-    sysTime = timer->getTime();
 
     // The time step is normally driven by the system clock; however, when
-    // recording a movie, we fix the time step the frame rate of the movie.
+    // recording a movie, we fix the time step the frame rate of the movie,
+    // and in deterministic mode the clock is never read at all so offline
+    // renders are reproducible frame for frame.
     double dt = 0.0;
-    if (movieCapture != nullptr && recording)
+    if (fixedTimeStep > 0.0)
     {
-        dt = 1.0 / movieCapture->getFrameRate();
+        dt = fixedTimeStep;
+        sysTime = lastTime + dt;
     }
     else
     {
-        dt = sysTime - lastTime;
+        sysTime = timer->getTime();
+        if (movieCapture != nullptr && recording)
+            dt = 1.0 / movieCapture->getFrameRate();
+        else
+            dt = sysTime - lastTime;
     }
 
     // Pause script execution
@@ -2053,20 +2106,107 @@ void CelestiaCore::tick()
     }
 
     // If there's a script running, tick it
-    if (m_script != nullptr)
     {
-        m_script->handleTickEvent(dt);
-        if (scriptState == ScriptRunning)
+        AllocTagScope allocTag("script");
+        double scriptStart = timer->getTime();
+        if (m_script != nullptr)
         {
-            bool finished = m_script->tick(dt);
-            if (finished)
-                cancelScript();
+            m_script->handleTickEvent(dt);
+            if (scriptState == ScriptRunning)
+            {
+                bool finished = m_script->tick(dt);
+                if (finished)
+                    cancelScript();
+            }
         }
+        if (m_scriptHook != nullptr)
+            m_scriptHook->call("tick", dt);
+        if (telemetry != nullptr && (m_script != nullptr || m_scriptHook != nullptr))
+            telemetry->recordScriptSlice((timer->getTime() - scriptStart) * 1000.0);
     }
-    if (m_scriptHook != nullptr)
-        m_scriptHook->call("tick", dt);
 
-    sim->update(dt);
+    {
+        AllocTagScope allocTag("sim");
+        sim->update(dt);
+    }
+
+    // Cluster sync happens after the simulation update so the master
+    // sends -- and clients overwrite -- this tick's final state.
+    if (clusterSync != nullptr)
+    {
+        if (clusterSync->mode() == ClusterSync::Master)
+            clusterSync->broadcastState(this);
+        else if (clusterSync->mode() == ClusterSync::Client)
+            clusterSync->applyState(this);
+    }
+
+    prewarmDestinationSystem();
+}
+
+
+// While a goto is in progress, warm up the destination system a few
+// bodies per tick: prime the ephemeris caches along each body's frame
+// chain and request its textures and geometry, so the work lands in
+// the travel frames instead of hitching on arrival. Runs on the main
+// thread, which owns both the simulation and the GL context; resource
+// types with background loaders go asynchronous from here anyway.
+void CelestiaCore::prewarmDestinationSystem()
+{
+    Observer* observer = sim->getActiveObserver();
+    if (observer->getMode() != Observer::Travelling)
+    {
+        prewarmSystem = nullptr;
+        prewarmQueue.clear();
+        prewarmQueueIndex = 0;
+        return;
+    }
+
+    SolarSystem* destSystem =
+        sim->getUniverse()->getNearestSolarSystem(observer->getJourneyDestination());
+    if (destSystem == nullptr || destSystem == sim->getNearestSolarSystem())
+        return;
+
+    if (destSystem != prewarmSystem)
+    {
+        prewarmSystem = destSystem;
+        prewarmQueue.clear();
+        prewarmQueueIndex = 0;
+        destSystem->getPlanets()->traverse(
+            [](Body* body, void* info)
+            {
+                ((std::vector<Body*>*) info)->push_back(body);
+                return true;
+            },
+            &prewarmQueue);
+    }
+
+    const size_t bodiesPerTick = 2;
+    double now = sim->getTime();
+    unsigned int resolution = renderer->getResolution();
+
+    for (size_t n = 0; n < bodiesPerTick && prewarmQueueIndex < prewarmQueue.size(); n++)
+    {
+        Body* body = prewarmQueue[prewarmQueueIndex++];
+        if (!body->extant(now))
+            continue;
+
+        body->getAstrocentricPosition(now);
+
+        Surface& surface = body->getSurface();
+        surface.baseTexture.find(resolution);
+        surface.bumpTexture.find(resolution);
+        surface.nightTexture.find(resolution);
+        surface.specularTexture.find(resolution);
+        surface.overlayTexture.find(resolution);
+
+        if (body->getRings() != nullptr)
+            body->getRings()->texture.find(resolution);
+        if (body->getAtmosphere() != nullptr)
+            body->getAtmosphere()->cloudTexture.find(resolution);
+
+        if (body->getGeometry() != InvalidResource)
+            GetGeometryManager()->find(body->getGeometry());
+    }
 }
 
 
@@ -2076,6 +2216,11 @@ void CelestiaCore::draw()
         return;
     viewChanged = false;
 
+    CELTRACE_SCOPE("draw");
+    AllocTagScope allocTag("render");
+
+    double frameStart = timer->getTime();
+
     if (views.size() == 1)
     {
         // I'm not certain that a special case for one view is required; but,
@@ -2090,6 +2235,9 @@ void CelestiaCore::draw()
     }
     else
     {
+        // All views draw the same simulation time, so let them share
+        // the renderer's time-keyed per-frame caches.
+        renderer->beginViewSet();
         for (const auto view : views)
         {
             if (view->type == View::ViewWindow)
@@ -2098,6 +2246,7 @@ void CelestiaCore::draw()
                 sim->render(*renderer, *view->observer);
             }
         }
+        renderer->endViewSet();
         renderer->setRenderRegion(0, 0, width, height, false);
     }
 
@@ -2131,6 +2280,22 @@ void CelestiaCore::draw()
         fpsCounterStartTime = sysTime;
     }
 
+    GLStats::endFrame(GetTextureManager()->residentBytes(),
+                      GetGeometryManager()->residentBytes());
+
+    lastFrameTime = timer->getTime() - frameStart;
+    if (anomalyRecorder != nullptr)
+        recordFrameDiagnostics();
+    if (telemetry != nullptr)
+    {
+        telemetry->recordFrame(lastFrameTime * 1000.0);
+        telemetry->update(sysTime);
+    }
+    if (frameBudget > 0.0)
+        applyFrameBudget();
+    if (targetFrameRate > 0.0)
+        applyFrameRateGovernor();
+
 #if 0
     GLenum err = glGetError();
     if (err != GL_NO_ERROR)
@@ -2362,6 +2527,11 @@ Simulation* CelestiaCore::getSimulation() const
     return sim;
 }
 
+ClusterSync* CelestiaCore::getClusterSync() const
+{
+    return clusterSync;
+}
+
 void CelestiaCore::showText(string s,
                             int horig, int vorig,
                             int hoff, int voff,
@@ -2464,6 +2634,18 @@ static void displayRotationPeriod(Overlay& overlay, double days)
 
 static void displaySpeed(Overlay& overlay, float speed)
 {
+    // The readout is identical between frames whenever the observer's
+    // speed is steady -- which is nearly always -- so cache the
+    // formatted line and only reformat when the speed changes.
+    static float lastSpeed = -1.0f;
+    static string readout;
+
+    if (speed == lastSpeed)
+    {
+        overlay << readout;
+        return;
+    }
+
     FormattedNumber n;
     const char *u;
 
@@ -2493,7 +2675,9 @@ static void displaySpeed(Overlay& overlay, float speed)
         u = _("ly/s");
     }
 
-    fmt::fprintf(overlay, _("Speed: %s %s\n"), n, u);
+    readout = fmt::sprintf(_("Speed: %s %s\n"), n, u);
+    lastSpeed = speed;
+    overlay << readout;
 }
 
 // Display a positive angle as degrees, minutes, and seconds. If the angle is less than one
@@ -3005,7 +3189,7 @@ void CelestiaCore::renderOverlay()
         if (lightTravelFlag && lt > 0.0)
         {
             overlay->setColor(0.42f, 1.0f, 1.0f, 1.0f);
-            *overlay << _("  LT");
+            *overlay << F_("  LT");
             overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
         }
         *overlay << '\n';
@@ -3014,27 +3198,27 @@ void CelestiaCore::renderOverlay()
             if (abs(abs(sim->getTimeScale()) - 1) < 1e-6)
             {
                 if (sign(sim->getTimeScale()) == 1)
-                    *overlay << _("Real time");
+                    *overlay << F_("Real time");
                 else
-                    *overlay << _("-Real time");
+                    *overlay << F_("-Real time");
             }
             else if (abs(sim->getTimeScale()) < MinimumTimeRate)
             {
-                *overlay << _("Time stopped");
+                *overlay << F_("Time stopped");
             }
             else if (abs(sim->getTimeScale()) > 1.0)
             {
-                fmt::fprintf(*overlay, _("%.6g x faster"), sim->getTimeScale()); // XXX: %'.12g
+                fmt::fprintf(*overlay, F_("%.6g x faster"), sim->getTimeScale()); // XXX: %'.12g
             }
             else
             {
-                fmt::fprintf(*overlay, _("%.6g x slower"), 1.0 / sim->getTimeScale()); // XXX: %'.12g
+                fmt::fprintf(*overlay, F_("%.6g x slower"), 1.0 / sim->getTimeScale()); // XXX: %'.12g
             }
 
             if (sim->getPauseState() == true)
             {
                 overlay->setColor(1.0f, 0.0f, 0.0f, 1.0f);
-                *overlay << _(" (Paused)");
+                *overlay << F_(" (Paused)");
             }
         }
 
@@ -3052,18 +3236,7 @@ void CelestiaCore::renderOverlay()
         overlay->beginText();
         *overlay << '\n';
         if (showFPSCounter)
-#ifdef OCTREE_DEBUG
-            fmt::fprintf(*overlay, _("FPS: %.1f, vis. stars stats: [ %zu : %zu : %zu ], vis. DSOs stats: [ %zu : %zu : %zu ]\n"),
-                         fps,
-                         getRenderer()->m_starProcStats.objects,
-                         getRenderer()->m_starProcStats.nodes,
-                         getRenderer()->m_starProcStats.height,
-                         getRenderer()->m_dsoProcStats.objects,
-                         getRenderer()->m_dsoProcStats.nodes,
-                         getRenderer()->m_dsoProcStats.height);
-#else
-            fmt::fprintf(*overlay, _("FPS: %.1f\n"), fps);
-#endif
+            fmt::fprintf(*overlay, F_("FPS: %.1f\n"), fps);
         else
             *overlay << '\n';
 
@@ -3073,6 +3246,133 @@ void CelestiaCore::renderOverlay()
         overlay->restorePos();
     }
 
+    if (showFPSCounter && renderer->getPassTimingEnabled())
+    {
+        // Rolling per-pass render cost, above the FPS counter
+        auto passTimings = renderer->getPassTimings();
+        overlay->savePos();
+        overlay->moveBy(0.0f, fontHeight * (int) (passTimings.size() + 4) + 5);
+        overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
+        overlay->beginText();
+        fmt::fprintf(*overlay, F_("Render pass cost (CPU ms / GPU ms):\n"));
+        for (const auto& timing : passTimings)
+        {
+            fmt::fprintf(*overlay, "  %s: %.2f / %.2f\n",
+                         timing.first,
+                         timing.second.cpuTimeMs,
+                         timing.second.gpuTimeMs);
+        }
+        overlay->endText();
+        overlay->restorePos();
+    }
+
+    if ((renderer->getRenderFlags() & Renderer::ShowOctree) != 0)
+    {
+        // Octree diagnostics: this frame's traversal cost next to the
+        // static per-level shape of the star octree, the numbers that
+        // matter when tuning split thresholds for non-stock catalogs.
+        if (starOctreeLevelStats.empty() &&
+            sim->getUniverse()->getStarCatalog() != nullptr &&
+            sim->getUniverse()->getStarCatalog()->getOctreeRoot() != nullptr)
+        {
+            sim->getUniverse()->getStarCatalog()->getOctreeRoot()->
+                computeStatistics(starOctreeLevelStats);
+        }
+
+        const OctreeProcStats& starStats = renderer->m_starProcStats;
+        const OctreeProcStats& dsoStats = renderer->m_dsoProcStats;
+        int nLines = 2 + (int) starOctreeLevelStats.size();
+
+        overlay->savePos();
+        overlay->moveBy(0.0f, fontHeight * (nLines + 14) + 5);
+        overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
+        overlay->beginText();
+        fmt::fprintf(*overlay, F_("Star octree: %zu nodes visited, %zu objects, depth %zu, %.2f ms\n"),
+                     starStats.nodes, starStats.objects, starStats.height,
+                     starStats.timeMs);
+        fmt::fprintf(*overlay, F_("DSO octree: %zu nodes visited, %zu objects, depth %zu, %.2f ms\n"),
+                     dsoStats.nodes, dsoStats.objects, dsoStats.height,
+                     dsoStats.timeMs);
+        int level = 0;
+        for (const auto& stat : starOctreeLevelStats)
+        {
+            fmt::fprintf(*overlay, "  L%d: %u nodes, %u stars\n",
+                         level, stat.nodeCount, stat.objectCount);
+            level++;
+        }
+        overlay->endText();
+        overlay->restorePos();
+    }
+
+    if (showGLStats)
+    {
+        // Driver traffic for the last completed frame, counted in the
+        // GL wrapper paths, plus each manager's resident estimate
+        const GLStats::Counters& gl = GLStats::lastFrame();
+        double texMiB = (double) GetTextureManager()->residentBytes() / (1024.0 * 1024.0);
+        double geomMiB = (double) GetGeometryManager()->residentBytes() / (1024.0 * 1024.0);
+
+        overlay->savePos();
+        overlay->moveBy(0.0f, fontHeight * 8 + 5);
+        overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
+        overlay->beginText();
+        fmt::fprintf(*overlay, F_("Driver calls (last frame):\n"));
+        fmt::fprintf(*overlay, F_("  draw calls: %u, program changes: %u, texture binds: %u\n"),
+                     gl.drawCalls, gl.programChanges, gl.textureBinds);
+        fmt::fprintf(*overlay, F_("  buffer uploads: %u (%.1f KiB)\n"),
+                     gl.bufferUploads, (double) gl.bufferUploadBytes / 1024.0);
+        fmt::fprintf(*overlay, F_("  texture uploads: %u (%.1f KiB)\n"),
+                     gl.textureUploads, (double) gl.textureUploadBytes / 1024.0);
+        fmt::fprintf(*overlay, F_("  resident textures: %.1f MiB, geometry: %.1f MiB\n"),
+                     texMiB, geomMiB);
+        if (GLStats::csvActive())
+            fmt::fprintf(*overlay, F_("  CSV capture active\n"));
+        overlay->endText();
+        overlay->restorePos();
+    }
+
+    if (showFPSCounter)
+    {
+        // Virtual texture tile residency, stacked above the render pass
+        // cost table; only textures with tile traffic are listed.
+        vector<VirtualTexture::Stats> vtStats;
+        GetVirtualTextureStats(vtStats);
+        vtStats.erase(remove_if(vtStats.begin(), vtStats.end(),
+                                [](const VirtualTexture::Stats& s)
+                                {
+                                    return s.residentTiles == 0 &&
+                                           s.tilesRequested == 0;
+                                }),
+                      vtStats.end());
+
+        if (!vtStats.empty())
+        {
+            int passLines = renderer->getPassTimingEnabled()
+                ? (int) renderer->getPassTimings().size() + 1
+                : 0;
+
+            overlay->savePos();
+            overlay->moveBy(0.0f, fontHeight * ((int) vtStats.size() + passLines + 5) + 5);
+            overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
+            overlay->beginText();
+            fmt::fprintf(*overlay, F_("Virtual texture tiles (resident by level / MB / faults / prefetch hit:wasted):\n"));
+            for (const auto& s : vtStats)
+            {
+                string levels;
+                for (unsigned int n : s.residentPerLevel)
+                    levels += fmt::sprintf(levels.empty() ? "%u" : "+%u", n);
+                fmt::fprintf(*overlay, "  %s: %s / %.1f / %u / %u:%u\n",
+                             s.name,
+                             levels.empty() ? string("0") : levels,
+                             (double) s.residentBytes / (1024.0 * 1024.0),
+                             s.tileFaults,
+                             s.prefetchHits, s.prefetchWasted);
+            }
+            overlay->endText();
+            overlay->restorePos();
+        }
+    }
+
     Universe *u = sim->getUniverse();
 
     if (hudDetail > 0 && (overlayElements & ShowFrame))
@@ -3087,10 +3387,10 @@ void CelestiaCore::renderOverlay()
         {
             double timeLeft = sim->getArrivalTime() - sim->getRealTime();
             if (timeLeft >= 1)
-                fmt::fprintf(*overlay, _("Travelling (%s)\n"),
+                fmt::fprintf(*overlay, F_("Travelling (%s)\n"),
                              FormattedNumber(timeLeft, 0, FormattedNumber::GroupThousands));
             else
-                fmt::fprintf(*overlay, _("Travelling\n"));
+                fmt::fprintf(*overlay, F_("Travelling\n"));
         }
         else
         {
@@ -3099,7 +3399,7 @@ void CelestiaCore::renderOverlay()
 
         if (!sim->getTrackedObject().empty())
         {
-            fmt::fprintf(*overlay, _("Track %s\n"),
+            fmt::fprintf(*overlay, F_("Track %s\n"),
                          C_("Track", getSelectionName(sim->getTrackedObject(), *u)));
         }
         else
@@ -3115,21 +3415,21 @@ void CelestiaCore::renderOverlay()
             switch (coordSys)
             {
             case ObserverFrame::Ecliptical:
-                fmt::fprintf(*overlay, _("Follow %s\n"),
+                fmt::fprintf(*overlay, F_("Follow %s\n"),
                              C_("Follow", getSelectionName(refObject, *u)));
                 break;
             case ObserverFrame::BodyFixed:
-                fmt::fprintf(*overlay, _("Sync Orbit %s\n"),
+                fmt::fprintf(*overlay, F_("Sync Orbit %s\n"),
                              C_("Sync", getSelectionName(refObject, *u)));
                 break;
             case ObserverFrame::PhaseLock:
-                fmt::fprintf(*overlay, _("Lock %s -> %s\n"),
+                fmt::fprintf(*overlay, F_("Lock %s -> %s\n"),
                              C_("Lock", getSelectionName(refObject, *u)),
                              C_("LockTo", getSelectionName(sim->getFrame()->getTargetObject(), *u)));
                 break;
 
             case ObserverFrame::Chase:
-                fmt::fprintf(*overlay, _("Chase %s\n"),
+                fmt::fprintf(*overlay, F_("Chase %s\n"),
                              C_("Chase", getSelectionName(refObject, *u)));
                 break;
 
@@ -3143,7 +3443,7 @@ void CelestiaCore::renderOverlay()
 
         // Field of view
         float fov = radToDeg(sim->getActiveObserver()->getFOV());
-        fmt::fprintf(*overlay, _("FOV: %s (%.2fx)\n"),
+        fmt::fprintf(*overlay, F_("FOV: %s (%.2fx)\n"),
                               angleToStr(fov), (*activeView)->zoom);
         overlay->endText();
         overlay->restorePos();
@@ -3171,10 +3471,10 @@ void CelestiaCore::renderOverlay()
                     // Skip displaying the English name if a localized version is present.
                     string starName = sim->getUniverse()->getStarCatalog()->getStarName(*sel.star());
                     string locStarName = sim->getUniverse()->getStarCatalog()->getStarName(*sel.star(), true);
-                    if (sel.star()->getCatalogNumber() == 0 && selectionNames.find("Sun") != string::npos && (const char*) "Sun" != _("Sun"))
+                    if (sel.star()->getCatalogNumber() == 0 && selectionNames.find("Sun") != string::npos && (const char*) "Sun" != F_("Sun"))
                     {
                         string::size_type startPos = selectionNames.find("Sun");
-                        string::size_type endPos = selectionNames.find(_("Sun"));
+                        string::size_type endPos = selectionNames.find(F_("Sun"));
                         selectionNames = selectionNames.erase(startPos, endPos - startPos);
                     }
                     else if (selectionNames.find(starName) != string::npos && starName != locStarName)
@@ -3348,7 +3648,7 @@ void CelestiaCore::renderOverlay()
         overlay->moveBy(0.0f, fontHeight * 3.0f + 35.0f);
         overlay->setColor(0.6f, 0.6f, 1.0f, 1.0f);
         overlay->beginText();
-        fmt::fprintf(*overlay, _("Target name: %s"), typedText);
+        fmt::fprintf(*overlay, F_("Target name: %s"), typedText);
         overlay->endText();
         overlay->setFont(font);
         if (typedTextCompletion.size() >= 1)
@@ -3435,10 +3735,10 @@ void CelestiaCore::renderOverlay()
         overlay->moveBy((float) ((width - movieWidth) / 2),
                         (float) ((height + movieHeight) / 2 + 2));
         overlay->beginText();
-        fmt::fprintf(*overlay, _("%dx%d at %f fps  %s"),
+        fmt::fprintf(*overlay, F_("%dx%d at %f fps  %s"),
                               movieWidth, movieHeight,
                               movieCapture->getFrameRate(),
-                              recording ? _("Recording") : _("Paused"));
+                              recording ? F_("Recording") : F_("Paused"));
 
         overlay->endText();
         overlay->restorePos();
@@ -3459,7 +3759,7 @@ void CelestiaCore::renderOverlay()
         overlay->moveBy((float) ((width - movieWidth) / 2),
                         (float) ((height - movieHeight) / 2 - fontHeight - 2));
         overlay->beginText();
-        *overlay << _("F11 Start/Pause    F12 Stop");
+        *overlay << F_("F11 Start/Pause    F12 Stop");
         overlay->endText();
         overlay->restorePos();
 
@@ -3469,10 +3769,10 @@ void CelestiaCore::renderOverlay()
     if (editMode)
     {
         overlay->savePos();
-        overlay->moveBy((float) ((width - font->getWidth(_("Edit Mode"))) / 2),
+        overlay->moveBy((float) ((width - font->getWidth(F_("Edit Mode"))) / 2),
                         (float) (height - fontHeight));
         overlay->setColor(1, 0, 1, 1);
-        *overlay << _("Edit Mode");
+        *overlay << F_("Edit Mode");
         overlay->restorePos();
     }
 
@@ -3481,78 +3781,428 @@ void CelestiaCore::renderOverlay()
 }
 
 
-class SolarSystemLoader
+// Parse the extras ssc catalogs on a pool of worker threads, each file
+// from a whole-file memory buffer, then apply the staged object lists
+// to the universe serially in discovery order. Application must stay in
+// order because later files may attach children to bodies defined in
+// earlier ones.
+// A catalog source for the staged loaders: either a loose file or a
+// member of an add-on pack, read straight from the pack's memory
+// mapping.
+struct CatalogSource
 {
-    Universe* universe;
-    ProgressNotifier* notifier;
+    fs::path path;           // loose file path, or the pack path for members
+    fs::path resourcePath;   // base for textures and models the catalog references
+    const PackFile* pack{ nullptr };
+    const PackFile::Member* member{ nullptr };
+};
 
- public:
-    SolarSystemLoader(Universe* u, ProgressNotifier* pn) : universe(u), notifier(pn) {};
+// Everything of interest found in one scan of the extras directories.
+// The catalog loaders previously each re-walked the whole extras tree;
+// on network storage the repeated metadata traffic dominated cold
+// start.
+struct ExtrasContent
+{
+    std::vector<CatalogSource> starCatalogs;
+    std::vector<CatalogSource> dsoCatalogs;
+    std::vector<CatalogSource> solarSystemCatalogs;
+    std::vector<std::unique_ptr<PackFile>> packs;
+};
 
-    void process(const fs::path& filepath)
+static bool readCatalogSource(const CatalogSource& source, string& contents)
+{
+    if (source.pack != nullptr)
     {
-        if (DetermineFileType(filepath) != Content_CelestiaCatalog)
-            return;
+        if (!source.pack->readMember(*source.member, contents))
+            return false;
+    }
+    else
+    {
+        ifstream in(source.path.string(), ios::in | ios::binary);
+        if (!in.good())
+            return false;
 
-        fmt::fprintf(clog, _("Loading solar system catalog: %s\n"), filepath.string());
-        if (notifier != nullptr)
-            notifier->update(filepath.filename().string());
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+    }
 
-        ifstream solarSysFile(filepath.string(), ios::in);
-        if (solarSysFile.good())
+    // Catalogs may be shipped gzip compressed under their normal names;
+    // inflate before handing the text to the parser.
+    if (IsGzipData(contents.data(), contents.size()))
+    {
+        string inflated;
+        if (!DecompressGzipData(contents.data(), contents.size(), inflated))
+            return false;
+        contents = std::move(inflated);
+    }
+
+    return true;
+}
+
+static void scanExtrasDirectories(const vector<string>& dirs, ExtrasContent& content)
+{
+    for (const auto& dir : dirs)
+    {
+        if (!is_valid_directory(dir))
+            continue;
+
+        for (const auto& fn : fs::recursive_directory_iterator(dir))
         {
-            LoadSolarSystemObjects(solarSysFile,
-                                   *universe,
-                                   filepath.parent_path());
+            switch (DetermineFileType(fn))
+            {
+            case Content_CelestiaStarCatalog:
+                content.starCatalogs.push_back({ fn.path(), fn.path().parent_path(), nullptr, nullptr });
+                break;
+            case Content_CelestiaDeepSkyCatalog:
+                content.dsoCatalogs.push_back({ fn.path(), fn.path().parent_path(), nullptr, nullptr });
+                break;
+            case Content_CelestiaCatalog:
+                content.solarSystemCatalogs.push_back({ fn.path(), fn.path().parent_path(), nullptr, nullptr });
+                break;
+            case Content_CelestiaPack:
+            {
+                auto pack = std::unique_ptr<PackFile>(new PackFile(fn.path()));
+                if (pack->isValid())
+                    content.packs.push_back(std::move(pack));
+                else
+                    fmt::fprintf(cerr, _("Error opening add-on pack %s\n"), fn.path());
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    // Index pack members; catalog members load through the pack's
+    // mapping, so one open per pack stands in for a stat and open per
+    // member. Resources referenced by packed catalogs resolve relative
+    // to the directory holding the pack.
+    for (const auto& pack : content.packs)
+    {
+        for (const auto& member : pack->members())
+        {
+            switch (DetermineFileType(fs::path(member.name)))
+            {
+            case Content_CelestiaStarCatalog:
+                content.starCatalogs.push_back({ pack->path(), pack->path().parent_path(), pack.get(), &member });
+                break;
+            case Content_CelestiaDeepSkyCatalog:
+                content.dsoCatalogs.push_back({ pack->path(), pack->path().parent_path(), pack.get(), &member });
+                break;
+            case Content_CelestiaCatalog:
+                content.solarSystemCatalogs.push_back({ pack->path(), pack->path().parent_path(), pack.get(), &member });
+                break;
+            default:
+                break;
+            }
+        }
+    }
+}
+
+
+static void loadSolarSystemCatalogs(Universe& universe,
+                                    const vector<CatalogSource>& files,
+                                    ProgressNotifier* notifier)
+{
+    struct ParsedCatalog
+    {
+        fs::path path;
+        fs::path resourcePath;
+        vector<SolarSystemObjectEntry> objects;
+        // Arena for the staged Value trees; freed wholesale once the
+        // file's definitions have been applied.
+        MemoryPool values{ 16, 65536 };
+    };
+    vector<ParsedCatalog> parsed(files.size());
+
+    std::atomic<size_t> nextFile(0);
+    auto parseFiles = [&]()
+    {
+        for (;;)
+        {
+            size_t i = nextFile.fetch_add(1);
+            if (i >= files.size())
+                return;
+
+            parsed[i].path = files[i].path;
+            parsed[i].resourcePath = files[i].resourcePath;
+
+            string contents;
+            if (!readCatalogSource(files[i], contents))
+                continue;
+
+            // Workers operate on distinct files, so each sidecar is
+            // touched by at most one thread. Pack members have no
+            // compiled sidecar; reading them is already one copy from
+            // the pack mapping.
+            string tokens;
+            if (files[i].pack == nullptr &&
+                GetCompiledCatalog(files[i].path, contents, tokens))
+            {
+                Tokenizer tokenizer(tokens.data(), tokens.size());
+                ParseSolarSystemObjects(tokenizer, parsed[i].objects, &parsed[i].values);
+            }
+            else
+            {
+                Tokenizer tokenizer(contents);
+                ParseSolarSystemObjects(tokenizer, parsed[i].objects, &parsed[i].values);
+            }
         }
     };
-};
 
-template <class OBJDB> class CatalogLoader
+    auto nThreads = (size_t) max(std::thread::hardware_concurrency(), 1u);
+    nThreads = min(nThreads, files.size());
+
+    {
+        // Worker threads must not touch the profiler; the parallel
+        // parse is recorded as a single phase.
+        ProfiledPhase parsePhase(PhaseProfiler::startup(), "parse");
+        vector<std::thread> workers;
+        for (size_t i = 1; i < nThreads; i++)
+            workers.emplace_back(parseFiles);
+        parseFiles();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    for (auto& catalog : parsed)
+    {
+        fmt::fprintf(clog, _("Loading solar system catalog: %s\n"), catalog.path.string());
+        if (notifier != nullptr)
+            notifier->update(catalog.path.filename().string());
+
+        ProfiledPhase filePhase(PhaseProfiler::startup(), catalog.path.string());
+
+        ApplySolarSystemObjects(catalog.objects, universe, catalog.resourcePath);
+    }
+}
+
+// Load dsc catalogs with the same staged scheme as the solar system
+// catalogs: the files are tokenized and parsed on worker threads, then
+// the objects are constructed and registered serially in discovery
+// order, since construction touches shared caches (galaxy forms,
+// categories, the name database).
+static void loadDeepSkyCatalogs(DSODatabase* dsoDB,
+                                const vector<CatalogSource>& files,
+                                ProgressNotifier* notifier)
 {
-    OBJDB*      objDB;
-    string      typeDesc;
-    ContentType contentType;
-    ProgressNotifier* notifier;
+    if (files.empty())
+        return;
+
+    struct ParsedCatalog
+    {
+        fs::path path;
+        fs::path resourcePath;
+        vector<DeepSkyCatalogEntry> entries;
+    };
+    vector<ParsedCatalog> parsed(files.size());
 
+    std::atomic<size_t> nextFile(0);
+    auto parseFiles = [&]()
+    {
+        for (;;)
+        {
+            size_t i = nextFile.fetch_add(1);
+            if (i >= files.size())
+                return;
+
+            parsed[i].path = files[i].path;
+            parsed[i].resourcePath = files[i].resourcePath;
+
+            string contents;
+            if (!readCatalogSource(files[i], contents))
+                continue;
+
+            string tokens;
+            if (files[i].pack == nullptr &&
+                GetCompiledCatalog(files[i].path, contents, tokens))
+            {
+                Tokenizer tokenizer(tokens.data(), tokens.size());
+                DSODatabase::parse(tokenizer, parsed[i].entries);
+            }
+            else
+            {
+                Tokenizer tokenizer(contents);
+                DSODatabase::parse(tokenizer, parsed[i].entries);
+            }
+        }
+    };
+
+    auto nThreads = (size_t) max(std::thread::hardware_concurrency(), 1u);
+    nThreads = min(nThreads, files.size());
+
+    {
+        ProfiledPhase parsePhase(PhaseProfiler::startup(), "parse");
+        vector<std::thread> workers;
+        for (size_t i = 1; i < nThreads; i++)
+            workers.emplace_back(parseFiles);
+        parseFiles();
+        for (auto& worker : workers)
+            worker.join();
+    }
+
+    for (auto& catalog : parsed)
+    {
+        fmt::fprintf(clog, _("Loading deep sky catalog: %s\n"), catalog.path.string());
+        if (notifier != nullptr)
+            notifier->update(catalog.path.filename().string());
+
+        ProfiledPhase filePhase(PhaseProfiler::startup(), catalog.path.string());
+
+        if (!dsoDB->apply(catalog.entries, catalog.resourcePath))
+            DPRINTF(LOG_LEVEL_ERROR, "Error reading deep sky catalog file: %s\n", catalog.path.string());
+    }
+}
+
+
+// CatalogPrefetcher pipelines catalog loading: a rolling window of
+// upcoming files is kept in flight on the shared asynchronous reader,
+// so file I/O overlaps parsing of the preceding catalogs while at most
+// a few whole catalogs are buffered at once.
+class CatalogPrefetcher
+{
  public:
-    CatalogLoader(OBJDB* db,
-                  const std::string& typeDesc,
-                  const ContentType& contentType,
-                  ProgressNotifier* pn) :
-        objDB      (db),
-        typeDesc   (typeDesc),
-        contentType(contentType),
-        notifier(pn)
+    struct Entry
     {
+        fs::path path;
+        fs::path resourcePath;
+        std::string contents;
+    };
+
+    CatalogPrefetcher(std::vector<Entry>&& files) :
+        pending(std::move(files))
+    {
+        fillWindow();
     }
 
-    void process(const fs::path& filepath)
+    CatalogPrefetcher(const CatalogPrefetcher&) = delete;
+    CatalogPrefetcher& operator=(const CatalogPrefetcher&) = delete;
+
+    //! Retrieve the next catalog in order; returns false when done.
+    //! Unreadable files are skipped.
+    bool next(Entry& entry)
     {
-        if (DetermineFileType(filepath) != contentType)
-            return;
+        while (nextServed < pending.size())
+        {
+            Entry& file = pending[nextServed++];
+            fillWindow();
 
-        fmt::fprintf(clog, _("Loading %s catalog: %s\n"), typeDesc, filepath.string());
-        if (notifier != nullptr)
-            notifier->update(filepath.filename().string());
+            // Entries from add-on packs arrive with their contents
+            // already read out of the pack mapping.
+            if (file.contents.empty())
+            {
+                AsyncFileReader::RequestHandle request = std::move(requests.front());
+                requests.pop_front();
+                if (!request->wait())
+                {
+                    fmt::fprintf(cerr, _("Error opening star catalog %s\n"), file.path);
+                    continue;
+                }
+                file.contents = request->takeContents();
+            }
+
+            // Inflate gzip compressed catalogs before they reach the
+            // parser (or the compiled sidecar hash).
+            if (IsGzipData(file.contents.data(), file.contents.size()))
+            {
+                string inflated;
+                if (!DecompressGzipData(file.contents.data(), file.contents.size(), inflated))
+                {
+                    fmt::fprintf(cerr, _("Error decompressing star catalog %s\n"), file.path);
+                    continue;
+                }
+                file.contents = std::move(inflated);
+            }
+
+            entry = std::move(file);
+            return true;
+        }
+        return false;
+    }
 
-        ifstream catalogFile(filepath.string(), ios::in);
-        if (catalogFile.good())
+ private:
+    void fillWindow()
+    {
+        while (nextSubmitted < pending.size() &&
+               nextSubmitted - nextServed < maxQueued)
         {
-            if (!objDB->load(catalogFile, filepath.parent_path()))
-                DPRINTF(LOG_LEVEL_ERROR, "Error reading %s catalog file: %s\n", typeDesc.c_str(), filepath.string());
+            Entry& file = pending[nextSubmitted++];
+            if (file.contents.empty())
+                requests.push_back(GetAsyncFileReader()->read(file.path));
         }
     }
+
+    static const size_t maxQueued = 4;
+
+    std::vector<Entry> pending;
+    std::deque<AsyncFileReader::RequestHandle> requests;
+    size_t nextSubmitted{ 0 };
+    size_t nextServed{ 0 };
 };
 
-using StarLoader = CatalogLoader<StarDatabase>;
-using DeepSkyLoader = CatalogLoader<DSODatabase>;
+
+// Emit the startup phase report to the destination named by the
+// CELESTIA_PROFILE_STARTUP environment variable ("-" for the console
+// log). Called after each init stage so the report covers whatever has
+// completed so far.
+static void writeStartupProfile()
+{
+    PhaseProfiler* profiler = PhaseProfiler::startup();
+    if (profiler == nullptr || profiler->empty())
+        return;
+
+    const char* dest = getenv("CELESTIA_PROFILE_STARTUP");
+    if (dest == nullptr)
+        return;
+
+    if (strcmp(dest, "-") == 0)
+    {
+        profiler->writeReport(clog);
+    }
+    else
+    {
+        ofstream out(dest, ios::out | ios::trunc);
+        if (out.good())
+            profiler->writeReport(out);
+    }
+}
+
+
+#ifndef _WIN32
+// Only the async-signal-safe flag set happens here; the report itself
+// is written from tick() on the main thread.
+static void memoryDumpSignalHandler(int /*sig*/)
+{
+    GetMemoryAudit().requestDump();
+}
+#endif
 
 
 bool CelestiaCore::initSimulation(const fs::path& configFileName,
                                   const vector<fs::path>& extrasDirs,
                                   ProgressNotifier* progressNotifier)
 {
+    PhaseProfiler* profiler = PhaseProfiler::startup();
+    if (profiler != nullptr)
+        profiler->beginPhase("initSimulation");
+
+    // Continuous tracing for exhibit machines; active until shutdown
+    // when the CELESTIA_TRACE_FILE environment variable names a file.
+    TraceLog::startFromEnvironment();
+
+    // Per-frame driver-call CSV capture, named by CELESTIA_GLSTATS_CSV
+    GLStats::startCsvFromEnvironment();
+
+    // Make per-tag allocation counters show up in memory audit dumps
+    GetAllocTracker();
+
+#ifndef _WIN32
+    // SIGUSR1 dumps a memory accounting report to stderr
+    signal(SIGUSR1, memoryDumpSignalHandler);
+#endif
+
     if (!configFileName.empty())
     {
         config = ReadCelestiaConfig(configFileName);
@@ -3618,60 +4268,72 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
     universe = new Universe();
 
 
+    // Walk the extras directories once up front, classifying catalog files
+    // and opening any add-on packs; the per-stage loaders below consume the
+    // result instead of performing their own recursive scans.
+    ExtrasContent extras;
+    {
+        ProfiledPhase phase(profiler, "scan extras");
+        scanExtrasDirectories(config->extrasDirs, extras);
+    }
+
+
     /***** Load star catalogs *****/
 
-    if (!readStars(*config, progressNotifier))
     {
-        fatalError(_("Cannot read star database."), false);
-        return false;
+        ProfiledPhase phase(profiler, "star catalogs");
+        if (!readStars(*config, extras, progressNotifier))
+        {
+            fatalError(_("Cannot read star database."), false);
+            return false;
+        }
     }
 
 
     /***** Load the deep sky catalogs *****/
 
-    DSONameDatabase* dsoNameDB  = new DSONameDatabase;
-    DSODatabase*     dsoDB      = new DSODatabase;
-    dsoDB->setNameDatabase(dsoNameDB);
+    {
+        ProfiledPhase dsoPhase(profiler, "deep sky catalogs");
 
-    // Load first the vector of dsoCatalogFiles in the data directory (deepsky.dsc, globulars.dsc,...):
+        DSONameDatabase* dsoNameDB  = new DSONameDatabase;
+        DSODatabase*     dsoDB      = new DSODatabase;
+        dsoDB->setNameDatabase(dsoNameDB);
 
-    for (const auto& file : config->dsoCatalogFiles)
-    {
-        if (progressNotifier)
-            progressNotifier->update(file.string());
+        // Load first the vector of dsoCatalogFiles in the data directory (deepsky.dsc, globulars.dsc,...):
 
-        ifstream dsoFile(file.string(), ios::in);
-        if (!dsoFile.good())
+        for (const auto& file : config->dsoCatalogFiles)
         {
-            warning(fmt::sprintf(_("Error opening deepsky catalog file %s.\n"), file));
-        }
-        if (!dsoDB->load(dsoFile, ""))
-        {
-            warning(fmt::sprintf(_("Cannot read Deep Sky Objects database %s.\n"), file));
+            if (progressNotifier)
+                progressNotifier->update(file.string());
+
+            ProfiledPhase filePhase(profiler, file.string());
+
+            ifstream dsoFile(file.string(), ios::in);
+            if (!dsoFile.good())
+            {
+                warning(fmt::sprintf(_("Error opening deepsky catalog file %s.\n"), file));
+            }
+            if (!dsoDB->load(dsoFile, ""))
+            {
+                warning(fmt::sprintf(_("Cannot read Deep Sky Objects database %s.\n"), file));
+            }
         }
-    }
 
-    // Next, read all the deep sky files in the extras directories
-    for (const auto& dir : config->extrasDirs)
-    {
-        if (!is_valid_directory(dir))
-            continue;
+        // Next, read all the deep sky files in the extras directories.
+        // The files are parsed in parallel and applied in discovery order.
+        loadDeepSkyCatalogs(dsoDB, extras.dsoCatalogs, progressNotifier);
 
-        DeepSkyLoader loader(dsoDB,
-                             "deep sky object",
-                             Content_CelestiaDeepSkyCatalog,
-                             progressNotifier);
-        for (const auto& fn : fs::recursive_directory_iterator(dir))
-            loader.process(fn);
+        dsoDB->finish();
+        universe->setDSOCatalog(dsoDB);
     }
-    dsoDB->finish();
-    universe->setDSOCatalog(dsoDB);
 
 
     /***** Load the solar system catalogs *****/
     // First read the solar system files listed individually in the
     // config file.
     {
+        ProfiledPhase phase(profiler, "solar system catalogs");
+
         SolarSystemCatalog* solarSystemCatalog = new SolarSystemCatalog();
         universe->setSolarSystemCatalog(solarSystemCatalog);
         for (const auto& file : config->solarSystemFiles)
@@ -3679,6 +4341,8 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
             if (progressNotifier)
                 progressNotifier->update(file.string());
 
+            ProfiledPhase filePhase(profiler, file.string());
+
             ifstream solarSysFile(file.string(), ios::in);
             if (!solarSysFile.good())
             {
@@ -3691,17 +4355,12 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
         }
     }
 
-    // Next, read all the solar system files in the extras directories
+    // Next, read all the solar system files in the extras directories.
+    // The files are parsed in parallel and applied in discovery order.
     {
-        for (const auto& dir : config->extrasDirs)
-        {
-            if (!is_valid_directory(dir))
-                continue;
+        ProfiledPhase phase(profiler, "extras solar system catalogs");
 
-            SolarSystemLoader loader(universe, progressNotifier);
-            for (const auto& fn : fs::recursive_directory_iterator(dir))
-                loader.process(fn);
-        }
+        loadSolarSystemCatalogs(*universe, extras.solarSystemCatalogs, progressNotifier);
     }
 
     // Load asterisms:
@@ -3772,12 +4431,55 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
         cursorHandler->setCursorShape(defaultCursorShape);
     }
 
+    // Start display cluster synchronization if the config asks for it
+    if (!compareIgnoringCase(config->clusterSyncMode, "master") ||
+        !compareIgnoringCase(config->clusterSyncMode, "client"))
+    {
+        bool master = !compareIgnoringCase(config->clusterSyncMode, "master");
+        clusterSync = new ClusterSync();
+        bool started = master
+            ? clusterSync->startMaster(config->clusterSyncAddress,
+                                       (unsigned short) config->clusterSyncPort)
+            : clusterSync->startClient(config->clusterSyncAddress,
+                                       (unsigned short) config->clusterSyncPort);
+        if (!started)
+        {
+            warning(fmt::sprintf(_("Cannot start cluster sync %s on %s:%u.\n"),
+                                 config->clusterSyncMode,
+                                 config->clusterSyncAddress,
+                                 config->clusterSyncPort));
+            delete clusterSync;
+            clusterSync = nullptr;
+        }
+    }
+
+    // Arm the frame-time anomaly recorder; AnomalyFrameThreshold 0
+    // in the config switches it off.
+    if (config->anomalyFrameThreshold > 0.0)
+        anomalyRecorder = new AnomalyRecorder(config->anomalyFrameThreshold);
+
+    // Opt-in metrics export; TelemetryFile in the config names the
+    // snapshot file a scraper watches.
+    if (!config->telemetryFile.empty())
+        telemetry = new TelemetryExporter(config->telemetryFile,
+                                          config->telemetryInterval);
+
+    if (profiler != nullptr)
+    {
+        profiler->endPhase();
+        writeStartupProfile();
+    }
+
     return true;
 }
 
 
 bool CelestiaCore::initRenderer()
 {
+    PhaseProfiler* profiler = PhaseProfiler::startup();
+    if (profiler != nullptr)
+        profiler->beginPhase("initRenderer");
+
     renderer->setRenderFlags(Renderer::ShowStars |
                              Renderer::ShowPlanets |
                              Renderer::ShowAtmospheres |
@@ -3800,6 +4502,8 @@ bool CelestiaCore::initRenderer()
     detailOptions.orbitPeriodsShown = config->orbitPeriodsShown;
     detailOptions.linearFadeFraction = config->linearFadeFraction;
 
+    GetResourceBudget().setBudget((uintmax_t) config->resourceMemoryBudget * 1024 * 1024);
+
     // Prepare the scene for rendering.
 #ifdef USE_GLCONTEXT
     if (!renderer->init(context, (int) width, (int) height, detailOptions))
@@ -3817,6 +4521,38 @@ bool CelestiaCore::initRenderer()
         setFaintestAutoMag();
     }
 
+    // Anomaly reports include per-pass timings, so keep the pass
+    // instrumentation on while the recorder is armed.
+    if (anomalyRecorder != nullptr)
+        renderer->setPassTimingEnabled(true);
+
+    // Parse a FontPreloadRanges config string -- comma-separated
+    // inclusive ranges of hexadecimal code points, e.g.
+    // "4E00-9FFF,3040-30FF" -- and rasterize each range into the
+    // font's glyph atlas up front, so label-heavy locales don't fault
+    // in thousands of glyphs during the first rendered frames.
+    auto preloadFontGlyphRanges = [](TextureFont* font, const string& ranges)
+    {
+        if (font == nullptr || ranges.empty())
+            return;
+
+        istringstream in(ranges);
+        string token;
+        while (getline(in, token, ','))
+        {
+            char* end = nullptr;
+            unsigned long first = strtoul(token.c_str(), &end, 16);
+            unsigned long last = (end != token.c_str() && *end == '-')
+                ? strtoul(end + 1, &end, 16) : 0;
+            if (end == token.c_str() || *end != '\0' || last < first)
+            {
+                fmt::fprintf(cerr, _("Bad font preload range: %s\n"), token);
+                continue;
+            }
+            font->preloadUnicodeRange((wchar_t) first, (wchar_t) last);
+        }
+    };
+
     if (config->mainFont == "")
 #if NO_TTF
         font = LoadTextureFont("fonts/default.txf");
@@ -3827,16 +4563,26 @@ bool CelestiaCore::initRenderer()
         font = LoadTextureFont(string("fonts/") + config->mainFont);
 
     if (font == nullptr)
+    {
         cout << _("Error loading font; text will not be visible.\n");
+    }
     else
+    {
         font->buildTexture();
+        preloadFontGlyphRanges(font, config->fontPreloadRanges);
+    }
 
     if (config->titleFont != "")
         titleFont = LoadTextureFont(string("fonts") + "/" + config->titleFont);
     if (titleFont != nullptr)
+    {
         titleFont->buildTexture();
+        preloadFontGlyphRanges(titleFont, config->fontPreloadRanges);
+    }
     else
+    {
         titleFont = font;
+    }
 
     // Set up the overlay
     overlay = new Overlay(*renderer);
@@ -3856,11 +4602,19 @@ bool CelestiaCore::initRenderer()
         else
         {
             labelFont->buildTexture();
+            preloadFontGlyphRanges(labelFont, config->fontPreloadRanges);
             renderer->setFont(Renderer::FontNormal, labelFont);
         }
     }
 
     renderer->setFont(Renderer::FontLarge, titleFont);
+
+    if (profiler != nullptr)
+    {
+        profiler->endPhase();
+        writeStartupProfile();
+    }
+
     return true;
 }
 
@@ -3871,9 +4625,12 @@ static void loadCrossIndex(StarDatabase* starDB,
 {
     if (!filename.empty())
     {
-        ifstream xrefFile(filename.string(), ios::in | ios::binary);
-        if (xrefFile.good())
+        // Read through the decompression helper so gzip compressed
+        // cross index files load transparently.
+        string contents;
+        if (ReadPossiblyCompressedFile(filename, contents))
         {
+            istringstream xrefFile(contents, ios::in | ios::binary);
             if (!starDB->loadCrossIndex(catalog, xrefFile))
                 fmt::fprintf(cerr, _("Error reading cross index %s\n"), filename);
             else
@@ -3884,10 +4641,22 @@ static void loadCrossIndex(StarDatabase* starDB,
 
 
 bool CelestiaCore::readStars(const CelestiaConfig& cfg,
+                             const ExtrasContent& extras,
                              ProgressNotifier* progressNotifier)
 {
     StarDetails::SetStarTextures(cfg.starTextures);
 
+    // Start pulling the binary star database and the cross index files
+    // into the file cache while the star names are parsed.
+    if (!cfg.starDatabaseFile.empty())
+        GetAsyncFileReader()->readahead(cfg.starDatabaseFile);
+    if (!cfg.HDCrossIndexFile.empty())
+        GetAsyncFileReader()->readahead(cfg.HDCrossIndexFile);
+    if (!cfg.SAOCrossIndexFile.empty())
+        GetAsyncFileReader()->readahead(cfg.SAOCrossIndexFile);
+    if (!cfg.GlieseCrossIndexFile.empty())
+        GetAsyncFileReader()->readahead(cfg.GlieseCrossIndexFile);
+
     ifstream starNamesFile(cfg.starNamesFile.string(), ios::in);
     if (!starNamesFile.good())
     {
@@ -3910,18 +4679,12 @@ bool CelestiaCore::readStars(const CelestiaConfig& cfg,
         if (progressNotifier)
             progressNotifier->update(cfg.starDatabaseFile.string());
 
-        ifstream starFile(cfg.starDatabaseFile.string(), ios::in | ios::binary);
-        if (!starFile.good())
+        // The path overload memory maps the catalog and decodes it in
+        // place, which is considerably faster than stream I/O for large
+        // star databases.
+        if (!starDB->loadBinary(cfg.starDatabaseFile))
         {
-            fmt::fprintf(cerr, _("Error opening %s\n"), cfg.starDatabaseFile);
-            delete starDB;
-            delete starNameDB;
-            return false;
-        }
-
-        if (!starDB->loadBinary(starFile))
-        {
-            cerr << _("Error reading stars file\n");
+            fmt::fprintf(cerr, _("Error reading stars file %s\n"), cfg.starDatabaseFile);
             delete starDB;
             delete starNameDB;
             return false;
@@ -3930,35 +4693,70 @@ bool CelestiaCore::readStars(const CelestiaConfig& cfg,
 
     starDB->setNameDatabase(starNameDB);
 
-    loadCrossIndex(starDB, StarDatabase::HenryDraper, cfg.HDCrossIndexFile);
-    loadCrossIndex(starDB, StarDatabase::SAO,         cfg.SAOCrossIndexFile);
-    loadCrossIndex(starDB, StarDatabase::Gliese,      cfg.GlieseCrossIndexFile);
+    // The cross indexes are independent and each load touches only its
+    // own catalog slot, so they can be read concurrently.
+    {
+        std::thread hdThread([&]() { loadCrossIndex(starDB, StarDatabase::HenryDraper, cfg.HDCrossIndexFile); });
+        std::thread saoThread([&]() { loadCrossIndex(starDB, StarDatabase::SAO, cfg.SAOCrossIndexFile); });
+        loadCrossIndex(starDB, StarDatabase::Gliese, cfg.GlieseCrossIndexFile);
+        hdThread.join();
+        saoThread.join();
+    }
 
     // Next, read any ASCII star catalog files specified in the StarCatalogs
-    // list.
+    // list, then supplemental star files from the extras directories. The
+    // file contents are prefetched on a background thread while the main
+    // thread parses, with per-file progress notifications.
+    vector<CatalogPrefetcher::Entry> starFiles;
     for (const auto& file : config->starCatalogFiles)
     {
-        if (file.empty())
-            continue;
-
-        ifstream starFile(file.string(), ios::in);
-        if (starFile.good())
-            starDB->load(starFile);
-        else
-            fmt::fprintf(cerr, _("Error opening star catalog %s\n"), file);
+        if (!file.empty())
+            starFiles.push_back({ file, fs::path(), {} });
     }
-
-    // Now, read supplemental star files from the extras directories
-    for (const auto& dir : config->extrasDirs)
+    for (const auto& source : extras.starCatalogs)
     {
-        if (!is_valid_directory(dir))
-            continue;
+        CatalogPrefetcher::Entry entry{ source.path, source.resourcePath, {} };
+        if (source.pack != nullptr)
+            source.pack->readMember(*source.member, entry.contents);
+        starFiles.push_back(std::move(entry));
+    }
 
-        StarLoader loader(starDB, "star", Content_CelestiaStarCatalog, progressNotifier);
-        for (const auto& fn : fs::recursive_directory_iterator(dir))
-            loader.process(fn);
+    {
+        CatalogPrefetcher prefetcher(std::move(starFiles));
+        CatalogPrefetcher::Entry entry;
+        while (prefetcher.next(entry))
+        {
+            fmt::fprintf(clog, _("Loading star catalog: %s\n"), entry.path.string());
+            if (progressNotifier != nullptr)
+                progressNotifier->update(entry.path.filename().string());
+
+            ProfiledPhase filePhase(PhaseProfiler::startup(), entry.path.string());
+
+            bool ok;
+            string tokens;
+            // Pack members share the pack's path, so compiled sidecars
+            // don't apply to them.
+            if (DetermineFileType(entry.path) != Content_CelestiaPack &&
+                GetCompiledCatalog(entry.path, entry.contents, tokens))
+            {
+                Tokenizer tokenizer(tokens.data(), tokens.size());
+                ok = starDB->load(tokenizer, entry.resourcePath);
+            }
+            else
+            {
+                Tokenizer tokenizer(entry.contents);
+                ok = starDB->load(tokenizer, entry.resourcePath);
+            }
+            if (!ok)
+                DPRINTF(LOG_LEVEL_ERROR, "Error reading star catalog file: %s\n", entry.path.string());
+        }
     }
 
+    // Reuse the prebuilt octree from a previous run when the loaded
+    // catalogs are unchanged; finish() validates the cache by hash.
+    if (!cfg.starDatabaseFile.empty())
+        starDB->setOctreeCacheFile(cfg.starDatabaseFile.string() + ".octree");
+
     starDB->finish();
 
     universe->setStarCatalog(starDB);
@@ -4043,6 +4841,246 @@ void CelestiaCore::setLightDelayActive(bool lightDelayActive)
     lightTravelFlag = lightDelayActive;
 }
 
+void CelestiaCore::setFrameBudget(double seconds)
+{
+    if (seconds > 0.0 && frameBudget <= 0.0)
+    {
+        // Capture the configured quality settings so degradation is
+        // always relative to them, not to an already degraded state.
+        baseMinOrbitSize = renderer->getMinimumOrbitSize();
+        baseMinFeatureSize = renderer->getMinimumFeatureSize();
+    }
+    else if (seconds <= 0.0 && frameBudget > 0.0)
+    {
+        renderer->setMinimumOrbitSize(baseMinOrbitSize);
+        renderer->setMinimumFeatureSize(baseMinFeatureSize);
+        degradeLevel = 0.0f;
+    }
+
+    frameBudget = seconds > 0.0 ? seconds : 0.0;
+}
+
+double CelestiaCore::getFrameBudget() const
+{
+    return frameBudget;
+}
+
+double CelestiaCore::getLastFrameTime() const
+{
+    return lastFrameTime;
+}
+
+double CelestiaCore::getFPS() const
+{
+    return fps;
+}
+
+void CelestiaCore::applyFrameBudget()
+{
+    // Climb quickly when over budget, relax slowly when comfortably
+    // under it; the dead band between the two avoids oscillating
+    // around the threshold.
+    float level = degradeLevel;
+    if (lastFrameTime > frameBudget)
+        level = std::min(1.0f, level + 0.1f);
+    else if (lastFrameTime < frameBudget * 0.8)
+        level = std::max(0.0f, level - 0.02f);
+
+    if (level != degradeLevel)
+    {
+        degradeLevel = level;
+        // At full degradation orbits and labeled features must cover
+        // five times as many pixels to be drawn.
+        renderer->setMinimumOrbitSize(baseMinOrbitSize * (1.0f + 4.0f * level));
+        renderer->setMinimumFeatureSize(baseMinFeatureSize * (1.0f + 4.0f * level));
+    }
+}
+
+void CelestiaCore::recordFrameDiagnostics()
+{
+    FrameDiagnostics frame;
+    frame.wallTime = sysTime;
+    frame.tdb = sim->getTime();
+    frame.frameTimeMs = lastFrameTime * 1000.0;
+
+    for (const auto& pass : renderer->getPassTimings())
+    {
+        FrameDiagnostics::Pass entry;
+        entry.name = pass.first;
+        entry.cpuTimeMs = pass.second.cpuTimeMs;
+        entry.gpuTimeMs = pass.second.gpuTimeMs;
+        frame.passes.push_back(entry);
+    }
+
+    if (AllocTracker::enabled())
+    {
+        vector<AllocTracker::TagStats> stats;
+        GetAllocTracker()->snapshot(stats);
+        for (const auto& tag : stats)
+        {
+            FrameDiagnostics::Alloc entry;
+            entry.tag = tag.tag;
+            entry.allocations = tag.allocations;
+            entry.bytesAllocated = tag.bytesAllocated;
+            entry.liveBytes = tag.liveBytes;
+            frame.allocs.push_back(entry);
+        }
+    }
+
+    ResourceBudget& budget = GetResourceBudget();
+    frame.residentBytes = budget.residentBytes();
+    frame.evictedBytes = budget.evictedBytes();
+    frame.evictionRuns = budget.evictionRuns();
+
+    anomalyRecorder->recordFrame(frame);
+}
+
+void CelestiaCore::registerQualityKnob(const std::string& name, int priority,
+                                       int maxLevel, std::function<void(int)> apply)
+{
+    QualityKnob knob;
+    knob.name = name;
+    knob.priority = priority;
+    knob.maxLevel = maxLevel;
+    knob.apply = std::move(apply);
+    qualityKnobs.push_back(std::move(knob));
+    sort(qualityKnobs.begin(), qualityKnobs.end(),
+         [](const QualityKnob& a, const QualityKnob& b) { return a.priority < b.priority; });
+}
+
+void CelestiaCore::registerDefaultQualityKnobs()
+{
+    // Base settings are captured when the governor is enabled, so
+    // degradation is always relative to the configured quality.
+    registerQualityKnob("annotations", 0, 3, [this](int level) {
+        renderer->setMinimumFeatureSize(governorBaseFeatureSize * (1.0f + 2.0f * (float) level));
+    });
+    registerQualityKnob("orbits", 1, 3, [this](int level) {
+        renderer->setMinimumOrbitSize(governorBaseOrbitSize * (1.0f + 2.0f * (float) level));
+    });
+    // There is no runtime atmosphere sample count to reduce, so the
+    // atmosphere knob sheds the cloud layer pass instead, which is
+    // the bulk of the per-planet atmosphere cost.
+    registerQualityKnob("clouds", 2, 1, [this](int level) {
+        if (level > 0)
+            renderer->setRenderFlags(renderer->getRenderFlags() & ~Renderer::ShowCloudMaps);
+        else
+            renderer->setRenderFlags(renderer->getRenderFlags() | Renderer::ShowCloudMaps);
+    });
+    registerQualityKnob("starmaglimit", 3, 4, [this](int level) {
+        renderer->setFaintestAM45deg(governorBaseFaintestAM - 0.5f * (float) level);
+        setFaintestAutoMag();
+    });
+}
+
+void CelestiaCore::setTargetFrameRate(double fps)
+{
+    if (fps > 0.0 && targetFrameRate <= 0.0)
+    {
+        // The governor and the plain frame budget drive the same
+        // settings; let the governor win.
+        setFrameBudget(0.0);
+
+        if (qualityKnobs.empty())
+            registerDefaultQualityKnobs();
+        governorBaseOrbitSize = renderer->getMinimumOrbitSize();
+        governorBaseFeatureSize = renderer->getMinimumFeatureSize();
+        governorBaseFaintestAM = renderer->getFaintestAM45deg();
+        frameTimeWindow.assign(120, 0.0);
+        frameTimeWindowPos = 0;
+        governorLastAdjust = sysTime;
+        governorUnderTargetSince = sysTime;
+    }
+    else if (fps <= 0.0 && targetFrameRate > 0.0)
+    {
+        for (auto& knob : qualityKnobs)
+        {
+            if (knob.level != 0)
+            {
+                knob.level = 0;
+                knob.apply(0);
+            }
+        }
+    }
+
+    targetFrameRate = fps > 0.0 ? fps : 0.0;
+}
+
+double CelestiaCore::getTargetFrameRate() const
+{
+    return targetFrameRate;
+}
+
+void CelestiaCore::setFixedTimeStep(double step)
+{
+    fixedTimeStep = step > 0.0 ? step : 0.0;
+}
+
+double CelestiaCore::getFixedTimeStep() const
+{
+    return fixedTimeStep;
+}
+
+void CelestiaCore::applyFrameRateGovernor()
+{
+    // In deterministic mode quality must not depend on how fast this
+    // node happens to render, or distributed segments won't match.
+    if (fixedTimeStep > 0.0)
+        return;
+
+    frameTimeWindow[frameTimeWindowPos] = lastFrameTime;
+    frameTimeWindowPos = (frameTimeWindowPos + 1) % frameTimeWindow.size();
+
+    // Adjust at most twice a second; a knob change takes a few frames
+    // to show up in the percentile, and reacting faster just churns.
+    if (sysTime - governorLastAdjust < 0.5)
+        return;
+    governorLastAdjust = sysTime;
+
+    vector<double> sorted(frameTimeWindow);
+    size_t p95 = (sorted.size() * 95) / 100;
+    nth_element(sorted.begin(), sorted.begin() + p95, sorted.end());
+    double frameTime95 = sorted[p95];
+
+    double targetFrameTime = 1.0 / targetFrameRate;
+    if (frameTime95 > targetFrameTime * 1.05)
+    {
+        governorUnderTargetSince = sysTime;
+        // Degrade the lowest priority knob that still has headroom
+        for (auto& knob : qualityKnobs)
+        {
+            if (knob.level < knob.maxLevel)
+            {
+                knob.level++;
+                knob.apply(knob.level);
+                break;
+            }
+        }
+    }
+    else if (frameTime95 < targetFrameTime * 0.85)
+    {
+        // Hysteresis: only restore quality after frames have stayed
+        // comfortably under target for a while, one step at a time in
+        // reverse degradation order.
+        if (sysTime - governorUnderTargetSince < 2.0)
+            return;
+        for (auto it = qualityKnobs.rbegin(); it != qualityKnobs.rend(); ++it)
+        {
+            if (it->level > 0)
+            {
+                it->level--;
+                it->apply(it->level);
+                governorUnderTargetSince = sysTime;
+                break;
+            }
+        }
+    }
+    else
+    {
+        governorUnderTargetSince = sysTime;
+    }
+}
+
 void CelestiaCore::setTextEnterMode(int mode)
 {
     if (mode != textEnterMode)
@@ -4468,3 +5506,32 @@ bool CelestiaCore::saveScreenShot(const fs::path& filename, ContentType type) co
 
     return false;
 }
+
+
+// Render one frame into an offscreen framebuffer and write it to a
+// file. Offline rendering can produce frames at a size independent of
+// any visible window; the on-screen viewport is restored before
+// returning.
+bool CelestiaCore::renderOffscreen(int w, int h,
+                                   const fs::path& filename,
+                                   ContentType type)
+{
+    if (w <= 0 || h <= 0)
+        return false;
+
+    FramebufferObject fbo((GLuint) w, (GLuint) h,
+                          FramebufferObject::ColorAttachment |
+                          FramebufferObject::DepthAttachment);
+    if (!fbo.isValid() || !fbo.bind())
+        return false;
+
+    int oldWidth = width;
+    int oldHeight = height;
+    resize(w, h);
+    draw();
+    bool success = saveScreenShot(filename, type);
+    fbo.unbind();
+    resize(oldWidth, oldHeight);
+
+    return success;
+}
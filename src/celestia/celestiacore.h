@@ -34,8 +34,14 @@
 #include <celscript/common/script.h>
 #include <celscript/legacy/legacyscript.h>
 #include <celscript/common/scriptmaps.h>
+#include <functional>
 
 class Url;
+struct ExtrasContent;
+class AnomalyRecorder;
+class ClusterSync;
+class SceneTrace;
+class TelemetryExporter;
 
 // class CelestiaWatcher;
 class CelestiaCore;
@@ -278,6 +284,57 @@ class CelestiaCore // : public Watchable<CelestiaCore>
     void setActiveFrameVisible(bool);
     bool getLightDelayActive() const;
     void setLightDelayActive(bool);
+
+    //! Session snapshots (session.cpp): serialize every view's
+    //! observer state, the view layout, markers, selection and time
+    //! to a compact binary stream, and restore them in one step
+    //! without re-running the scripts that produced the state.
+    bool saveSessionSnapshot(std::ostream&) const;
+    bool saveSessionSnapshot(const fs::path&) const;
+    bool restoreSessionSnapshot(std::istream&);
+    bool restoreSessionSnapshot(const fs::path&);
+
+    //! Display cluster synchronization (clustersync.cpp); null unless
+    //! enabled in the config file.
+    ClusterSync* getClusterSync() const;
+
+    //! Scene traces (scenetrace.cpp): record the current session's
+    //! camera path and render settings, and replay a recorded trace
+    //! frame by frame with deterministic stepping, reporting per-frame
+    //! and per-pass timing percentiles.
+    void beginSceneTrace();
+    bool endSceneTrace(const fs::path&);
+    bool replaySceneTrace(const fs::path&, std::ostream& report,
+                          double frameStep = 1.0 / 60.0);
+
+    //! Set a frame time budget in seconds (zero disables). While
+    //! frames exceed the budget the renderer's minimum orbit and
+    //! feature sizes are raised progressively, shedding orbit and
+    //! label work, and relaxed back when frames are comfortably
+    //! under budget again.
+    void setFrameBudget(double seconds);
+    double getFrameBudget() const;
+
+    //! Target frame rate for the governor; zero disables it and
+    //! restores all registered quality knobs to their base settings.
+    //! While active the governor watches the 95th percentile frame
+    //! time over a rolling window and steps quality knobs down one
+    //! level at a time -- lowest priority first -- whenever the
+    //! percentile runs over the frame time target, then restores them
+    //! in reverse once frames have been comfortably under target for
+    //! a couple of seconds. Enabling the governor supersedes the
+    //! simple frame budget; the two would fight over the same knobs.
+    void setTargetFrameRate(double fps);
+    double getTargetFrameRate() const;
+    //! Register a quality setting for the governor to manage. apply
+    //! is called with the degradation level (0 = configured quality,
+    //! up to maxLevel); knobs with lower priority are degraded first.
+    void registerQualityKnob(const std::string& name, int priority,
+                             int maxLevel, std::function<void(int)> apply);
+    //! Wall-clock duration of the most recent draw() in seconds
+    double getLastFrameTime() const;
+    //! Smoothed frame rate from the FPS counter
+    double getFPS() const;
     bool getAltAzimuthMode() const;
     void setAltAzimuthMode(bool);
     int getScreenDpi() const;
@@ -340,14 +397,34 @@ class CelestiaCore // : public Watchable<CelestiaCore>
 
     bool saveScreenShot(const fs::path&, ContentType = Content_Unknown) const;
 
+    //! Fixed time step in seconds for deterministic offline rendering;
+    //! zero (the default) restores wall-clock stepping. While a step is
+    //! set, tick() never reads the system clock and the frame rate
+    //! governor is suspended, so any node of a render farm stepping the
+    //! same script from the same start time produces identical frames.
+    void setFixedTimeStep(double step);
+    double getFixedTimeStep() const;
+
+    //! Render one frame at the given size into an offscreen framebuffer
+    //! and write it to a file; the on-screen viewport is restored
+    //! afterwards. Requires framebuffer object support.
+    bool renderOffscreen(int width, int height, const fs::path& filename,
+                         ContentType type = Content_Unknown);
+
  protected:
-    bool readStars(const CelestiaConfig&, ProgressNotifier*);
+    bool readStars(const CelestiaConfig&, const ExtrasContent&, ProgressNotifier*);
     void renderOverlay();
+    void applyFrameBudget();
+    void registerDefaultQualityKnobs();
+    void applyFrameRateGovernor();
 #ifdef CELX
     bool initLuaHook(ProgressNotifier*);
 #endif // CELX
 
  private:
+    void prewarmDestinationSystem();
+    void recordFrameDiagnostics();
+
     CelestiaConfig* config{ nullptr };
 
     Universe* universe{ nullptr };
@@ -357,6 +434,14 @@ class CelestiaCore // : public Watchable<CelestiaCore>
 
     Simulation* sim{ nullptr };
     Renderer* renderer{ nullptr };
+    ClusterSync* clusterSync{ nullptr };
+    SceneTrace* sceneTrace{ nullptr };
+    AnomalyRecorder* anomalyRecorder{ nullptr };
+    TelemetryExporter* telemetry{ nullptr };
+
+    // Per-level star octree shape for the octree diagnostics overlay,
+    // computed lazily the first time ShowOctree is switched on
+    std::vector<OctreeLevelStatistics> starOctreeLevelStats;
     Overlay* overlay{ nullptr };
     int width{ 1 };
     int height{ 1 };
@@ -394,6 +479,12 @@ class CelestiaCore // : public Watchable<CelestiaCore>
     bool lightTravelFlag{ false };
     double flashFrameStart{ 0.0 };
 
+    // Incremental warm-up of the journey destination system; see
+    // prewarmDestinationSystem()
+    SolarSystem* prewarmSystem{ nullptr };
+    std::vector<Body*> prewarmQueue;
+    std::size_t prewarmQueueIndex{ 0 };
+
     Timer* timer{ nullptr };
 
     std::unique_ptr<celestia::scripts::IScript>             m_script;
@@ -417,10 +508,37 @@ class CelestiaCore // : public Watchable<CelestiaCore>
 
     // Frame rate counter variables
     bool showFPSCounter{ false };
+    bool showGLStats{ false };
     int nFrames{ 0 };
     double fps{ 0.0 };
     double fpsCounterStartTime{ 0.0 };
 
+    // Frame budget; see setFrameBudget()
+    double lastFrameTime{ 0.0 };
+    double frameBudget{ 0.0 };
+    float degradeLevel{ 0.0f };
+    float baseMinOrbitSize{ 0.0f };
+    float baseMinFeatureSize{ 0.0f };
+
+    // Frame rate governor; see setTargetFrameRate()
+    struct QualityKnob
+    {
+        std::string name;
+        int priority{ 0 };
+        int maxLevel{ 1 };
+        int level{ 0 };
+        std::function<void(int)> apply;
+    };
+    double targetFrameRate{ 0.0 };
+    std::vector<QualityKnob> qualityKnobs;
+    std::vector<double> frameTimeWindow;
+    unsigned int frameTimeWindowPos{ 0 };
+    double governorLastAdjust{ 0.0 };
+    double governorUnderTargetSince{ 0.0 };
+    float governorBaseOrbitSize{ 0.0f };
+    float governorBaseFeatureSize{ 0.0f };
+    float governorBaseFaintestAM{ 0.0f };
+
     float oldFOV;
     float mouseMotion{ 0.0f };
     double dollyMotion{ 0.0 };
@@ -430,6 +548,7 @@ class CelestiaCore // : public Watchable<CelestiaCore>
 
     double sysTime{ 0.0 };
     double currentTime{ 0.0 };
+    double fixedTimeStep{ 0.0 };
 
     bool viewChanged{ true };
 
@@ -452,6 +571,10 @@ class CelestiaCore // : public Watchable<CelestiaCore>
     std::vector<Url*>::size_type historyCurrent{ 0 };
     std::string startURL;
 
+    // Session snapshot helpers (session.cpp)
+    void saveViewTree(std::ostream&, const View*) const;
+    bool restoreViewTree(std::istream&, View* leaf, View** newActiveView);
+
     std::list<View*> views;
     std::list<View*>::iterator activeView{ views.begin() };
     bool showActiveViewFrame{ false };
@@ -0,0 +1,594 @@
+// clustersync.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// State streaming for multi-node display clusters.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <celengine/observer.h>
+#include <celengine/simulation.h>
+#include <celutil/debug.h>
+#include "celestiacore.h"
+#include "clustersync.h"
+#include "url.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+// Defined in url.cpp: the complete (URL-encoded) path of a selection.
+const string getEncodedObjectName(const Selection& sel, const CelestiaCore* appCore);
+
+
+namespace
+{
+
+const char PacketMagic[4] = { 'C', 'E', 'L', 'C' };
+const uint16_t PacketVersion = 1;
+
+// Packet flags
+const uint8_t PauseFlag = 0x01;
+const uint8_t SelectionFlag = 0x02;
+
+// A state packet is a couple hundred bytes; this bounds the selection
+// path and keeps every packet well under a single MTU.
+const size_t MaxPacketSize = 1200;
+
+// Interpolation runs one packet interval behind the newest sample and
+// is allowed to extrapolate a quarter interval past it before it just
+// holds the newest state, so a single late packet doesn't cause a
+// visible hitch.
+const double MaxExtrapolation = 1.25;
+
+// A gap longer than this between packets restarts interpolation
+// instead of slewing across the discontinuity.
+const double MaxPacketGap = 1.0;
+
+
+// All multi-byte fields are stored little-endian, assembled bytewise
+// so the encoding doesn't depend on the host byte order.
+
+void writeUint32(string& out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out.push_back((char) ((v >> (i * 8)) & 0xff));
+}
+
+void writeUint16(string& out, uint16_t v)
+{
+    out.push_back((char) (v & 0xff));
+    out.push_back((char) ((v >> 8) & 0xff));
+}
+
+void writeUint8(string& out, uint8_t v)
+{
+    out.push_back((char) v);
+}
+
+void writeDouble(string& out, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    for (int i = 0; i < 8; i++)
+        out.push_back((char) ((bits >> (i * 8)) & 0xff));
+}
+
+void writeFloat(string& out, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint32(out, bits);
+}
+
+void writeString(string& out, const string& s)
+{
+    size_t length = min(s.length(), (size_t) 0xff);
+    writeUint8(out, (uint8_t) length);
+    out.append(s, 0, length);
+}
+
+// BigFix coordinates travel in the same base64 encoding the cel://
+// URL scheme uses; the round trip is exact.
+void writeBigFix(string& out, const BigFix& v)
+{
+    BigFix b = v;
+    string s = b.toString();
+    writeUint8(out, (uint8_t) s.length());
+    out.append(s);
+}
+
+
+// Bounded little-endian reader over a received datagram
+struct PacketReader
+{
+    const char* p;
+    const char* end;
+
+    bool readUint32(uint32_t& v)
+    {
+        if (end - p < 4)
+            return false;
+        v = 0;
+        for (int i = 0; i < 4; i++)
+            v |= (uint32_t) (uint8_t) p[i] << (i * 8);
+        p += 4;
+        return true;
+    }
+
+    bool readUint16(uint16_t& v)
+    {
+        if (end - p < 2)
+            return false;
+        v = (uint16_t) ((uint8_t) p[0] | ((uint16_t) (uint8_t) p[1] << 8));
+        p += 2;
+        return true;
+    }
+
+    bool readUint8(uint8_t& v)
+    {
+        if (end - p < 1)
+            return false;
+        v = (uint8_t) *p++;
+        return true;
+    }
+
+    bool readDouble(double& v)
+    {
+        if (end - p < 8)
+            return false;
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits |= (uint64_t) (uint8_t) p[i] << (i * 8);
+        memcpy(&v, &bits, sizeof v);
+        p += 8;
+        return true;
+    }
+
+    bool readFloat(float& v)
+    {
+        uint32_t bits;
+        if (!readUint32(bits))
+            return false;
+        memcpy(&v, &bits, sizeof v);
+        return true;
+    }
+
+    bool readString(string& s)
+    {
+        uint8_t length;
+        if (!readUint8(length) || end - p < (ptrdiff_t) length)
+            return false;
+        s.assign(p, length);
+        p += length;
+        return true;
+    }
+
+    bool readBigFix(BigFix& v)
+    {
+        string s;
+        if (!readString(s))
+            return false;
+        v = BigFix(s);
+        return true;
+    }
+};
+
+
+#ifdef _WIN32
+
+typedef SOCKET SocketHandle;
+
+bool initSockets()
+{
+    static bool initialized = false;
+    if (!initialized)
+    {
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+            return false;
+        initialized = true;
+    }
+    return true;
+}
+
+void closeSocket(intptr_t s)
+{
+    closesocket((SocketHandle) s);
+}
+
+bool setNonBlocking(intptr_t s)
+{
+    u_long nonBlocking = 1;
+    return ioctlsocket((SocketHandle) s, FIONBIO, &nonBlocking) == 0;
+}
+
+#else
+
+typedef int SocketHandle;
+
+bool initSockets()
+{
+    return true;
+}
+
+void closeSocket(intptr_t s)
+{
+    close((SocketHandle) s);
+}
+
+bool setNonBlocking(intptr_t s)
+{
+    int flags = fcntl((SocketHandle) s, F_GETFL, 0);
+    return flags != -1 && fcntl((SocketHandle) s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+#endif
+
+} // end unnamed namespace
+
+
+ClusterSync::~ClusterSync()
+{
+    stop();
+}
+
+
+bool ClusterSync::openSocket(const string& groupAddress, unsigned short port,
+                             bool master)
+{
+    if (!initSockets())
+        return false;
+
+    unsigned int group = inet_addr(groupAddress.c_str());
+    if (group == INADDR_NONE)
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Cluster sync: bad multicast address %s\n",
+                groupAddress.c_str());
+        return false;
+    }
+
+    intptr_t s = (intptr_t) socket(AF_INET, SOCK_DGRAM, 0);
+    if (s < 0)
+        return false;
+
+    if (master)
+    {
+        // Keep the stream on the local segment unless routing for it
+        // has been configured deliberately.
+        unsigned char ttl = 1;
+        setsockopt((SocketHandle) s, IPPROTO_IP, IP_MULTICAST_TTL,
+                   (const char*) &ttl, sizeof ttl);
+    }
+    else
+    {
+        int reuse = 1;
+        setsockopt((SocketHandle) s, SOL_SOCKET, SO_REUSEADDR,
+                   (const char*) &reuse, sizeof reuse);
+
+        sockaddr_in bindAddr;
+        memset(&bindAddr, 0, sizeof bindAddr);
+        bindAddr.sin_family = AF_INET;
+        bindAddr.sin_addr.s_addr = INADDR_ANY;
+        bindAddr.sin_port = htons(port);
+        if (bind((SocketHandle) s, (const sockaddr*) &bindAddr, sizeof bindAddr) != 0)
+        {
+            closeSocket(s);
+            return false;
+        }
+
+        ip_mreq mreq;
+        memset(&mreq, 0, sizeof mreq);
+        mreq.imr_multiaddr.s_addr = group;
+        mreq.imr_interface.s_addr = INADDR_ANY;
+        if (setsockopt((SocketHandle) s, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                       (const char*) &mreq, sizeof mreq) != 0)
+        {
+            closeSocket(s);
+            return false;
+        }
+
+        if (!setNonBlocking(s))
+        {
+            closeSocket(s);
+            return false;
+        }
+    }
+
+    m_socket = s;
+    m_groupAddress = group;
+    m_port = port;
+    return true;
+}
+
+
+bool ClusterSync::startMaster(const string& groupAddress, unsigned short port)
+{
+    stop();
+    if (!openSocket(groupAddress, port, true))
+        return false;
+    m_mode = Master;
+    m_sequence = 0;
+    m_lastSelectionPath.clear();
+    return true;
+}
+
+
+bool ClusterSync::startClient(const string& groupAddress, unsigned short port)
+{
+    stop();
+    if (!openSocket(groupAddress, port, false))
+        return false;
+    m_mode = Client;
+    m_havePrevious = false;
+    m_haveLatest = false;
+    m_lastSelectionPath.clear();
+    return true;
+}
+
+
+void ClusterSync::stop()
+{
+    if (m_socket >= 0)
+    {
+        closeSocket(m_socket);
+        m_socket = -1;
+    }
+    m_mode = Disabled;
+}
+
+
+void ClusterSync::broadcastState(CelestiaCore* appCore)
+{
+    if (m_mode != Master)
+        return;
+
+    Simulation* sim = appCore->getSimulation();
+
+    // The selection path is comparatively expensive to build and large
+    // to send, so it rides along only when it changes.
+    string selectionPath =
+        Url::decodeString(getEncodedObjectName(sim->getSelection(), appCore));
+    bool selectionChanged = m_sequence == 0 ||
+                            selectionPath != m_lastSelectionPath;
+
+    string packet;
+    packet.reserve(256);
+    packet.append(PacketMagic, sizeof PacketMagic);
+    writeUint16(packet, PacketVersion);
+    writeUint32(packet, ++m_sequence);
+
+    uint8_t flags = 0;
+    if (sim->getPauseState())
+        flags |= PauseFlag;
+    if (selectionChanged)
+        flags |= SelectionFlag;
+    writeUint8(packet, flags);
+
+    writeDouble(packet, sim->getTime());
+    writeDouble(packet, sim->getTimeScale());
+    writeFloat(packet, sim->getFaintestVisible());
+
+    vector<Observer*> observers = appCore->getObservers();
+    writeUint8(packet, (uint8_t) min(observers.size(), (size_t) 0xff));
+    for (size_t i = 0; i < min(observers.size(), (size_t) 0xff); i++)
+    {
+        const Observer* observer = observers[i];
+        UniversalCoord position = observer->getPosition();
+        writeBigFix(packet, position.x);
+        writeBigFix(packet, position.y);
+        writeBigFix(packet, position.z);
+        Quaterniond orientation = observer->getOrientation();
+        writeDouble(packet, orientation.w());
+        writeDouble(packet, orientation.x());
+        writeDouble(packet, orientation.y());
+        writeDouble(packet, orientation.z());
+        writeFloat(packet, observer->getFOV());
+    }
+
+    if (selectionChanged)
+    {
+        writeString(packet, selectionPath);
+        m_lastSelectionPath = selectionPath;
+    }
+
+    if (packet.size() > MaxPacketSize)
+        return;
+
+    sockaddr_in groupAddr;
+    memset(&groupAddr, 0, sizeof groupAddr);
+    groupAddr.sin_family = AF_INET;
+    groupAddr.sin_addr.s_addr = m_groupAddress;
+    groupAddr.sin_port = htons(m_port);
+    sendto((SocketHandle) m_socket, packet.data(), (int) packet.size(), 0,
+           (const sockaddr*) &groupAddr, sizeof groupAddr);
+}
+
+
+bool ClusterSync::decodePacket(const char* data, size_t length,
+                               StateSample& sample)
+{
+    PacketReader reader{ data, data + length };
+
+    if (length < sizeof PacketMagic ||
+        memcmp(data, PacketMagic, sizeof PacketMagic) != 0)
+        return false;
+    reader.p += sizeof PacketMagic;
+
+    uint16_t version;
+    if (!reader.readUint16(version) || version != PacketVersion)
+        return false;
+
+    uint8_t flags, observerCount;
+    if (!reader.readUint32(sample.sequence) ||
+        !reader.readUint8(flags) ||
+        !reader.readDouble(sample.tdb) ||
+        !reader.readDouble(sample.timeScale) ||
+        !reader.readFloat(sample.faintestVisible) ||
+        !reader.readUint8(observerCount))
+        return false;
+
+    sample.pauseState = (flags & PauseFlag) != 0;
+
+    sample.observers.resize(observerCount);
+    for (uint8_t i = 0; i < observerCount; i++)
+    {
+        ObserverState& state = sample.observers[i];
+        BigFix x, y, z;
+        double qw, qx, qy, qz;
+        if (!reader.readBigFix(x) ||
+            !reader.readBigFix(y) ||
+            !reader.readBigFix(z) ||
+            !reader.readDouble(qw) ||
+            !reader.readDouble(qx) ||
+            !reader.readDouble(qy) ||
+            !reader.readDouble(qz) ||
+            !reader.readFloat(state.fov))
+            return false;
+        state.position = UniversalCoord(x, y, z);
+        state.orientation = Quaterniond(qw, qx, qy, qz);
+    }
+
+    sample.hasSelection = (flags & SelectionFlag) != 0;
+    if (sample.hasSelection && !reader.readString(sample.selectionPath))
+        return false;
+
+    return true;
+}
+
+
+// Apply one (possibly interpolated) state to the simulation. The
+// discrete parts -- time scale, pause, selection, limiting magnitude
+// -- come from the newest sample and are only touched on change.
+void ClusterSync::applySample(CelestiaCore* appCore,
+                              const StateSample& sample,
+                              double tdb,
+                              const vector<ObserverState>& observers)
+{
+    Simulation* sim = appCore->getSimulation();
+
+    sim->setTime(tdb);
+
+    vector<Observer*> local = appCore->getObservers();
+    size_t count = min(local.size(), observers.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        local[i]->setPosition(observers[i].position);
+        local[i]->setOrientation(observers[i].orientation);
+        local[i]->setFOV(observers[i].fov);
+    }
+
+    if (sample.timeScale != m_lastTimeScale)
+    {
+        sim->setTimeScale(sample.timeScale);
+        m_lastTimeScale = sample.timeScale;
+    }
+    if (sample.pauseState != m_lastPauseState)
+    {
+        sim->setPauseState(sample.pauseState);
+        m_lastPauseState = sample.pauseState;
+    }
+    if (sample.faintestVisible != m_lastFaintest)
+    {
+        appCore->setFaintest(sample.faintestVisible);
+        m_lastFaintest = sample.faintestVisible;
+    }
+    if (sample.hasSelection && sample.selectionPath != m_lastSelectionPath)
+    {
+        sim->setSelection(sample.selectionPath.empty()
+                              ? Selection()
+                              : sim->findObjectFromPath(sample.selectionPath));
+        m_lastSelectionPath = sample.selectionPath;
+    }
+}
+
+
+bool ClusterSync::applyState(CelestiaCore* appCore)
+{
+    if (m_mode != Client)
+        return false;
+
+    // Drain everything that has arrived; packets are tiny and the
+    // newest one wins. An older sequence number (reordered datagram)
+    // is simply dropped.
+    char buffer[MaxPacketSize];
+    for (;;)
+    {
+        int received = recvfrom((SocketHandle) m_socket, buffer, sizeof buffer, 0,
+                                nullptr, nullptr);
+        if (received <= 0)
+            break;
+
+        StateSample sample;
+        if (!decodePacket(buffer, (size_t) received, sample))
+            continue;
+        if (m_haveLatest && sample.sequence <= m_latest.sequence)
+            continue;
+
+        sample.arrival = m_timer.getTime();
+        if (m_haveLatest)
+        {
+            m_previous = m_latest;
+            m_havePrevious = true;
+        }
+        m_latest = sample;
+        m_haveLatest = true;
+    }
+
+    if (!m_haveLatest)
+        return false;
+
+    double interval = m_havePrevious ? m_latest.arrival - m_previous.arrival
+                                     : 0.0;
+    if (!m_havePrevious || interval <= 0.0 || interval > MaxPacketGap)
+    {
+        applySample(appCore, m_latest, m_latest.tdb, m_latest.observers);
+        return true;
+    }
+
+    // Render one packet interval behind the newest sample and
+    // interpolate between the two most recent states; this stays
+    // smooth when the display refreshes faster than the master sends.
+    double alpha = (m_timer.getTime() - interval - m_previous.arrival) / interval;
+    alpha = max(0.0, min(MaxExtrapolation, alpha));
+    if (alpha >= 1.0)
+    {
+        applySample(appCore, m_latest, m_latest.tdb, m_latest.observers);
+        return true;
+    }
+
+    double tdb = m_previous.tdb + (m_latest.tdb - m_previous.tdb) * alpha;
+
+    vector<ObserverState> interpolated = m_previous.observers;
+    size_t count = min(interpolated.size(), m_latest.observers.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        const ObserverState& a = interpolated[i];
+        const ObserverState& b = m_latest.observers[i];
+        Vector3d offset = b.position.offsetFromKm(a.position);
+        interpolated[i].position = a.position.offsetKm(offset * alpha);
+        interpolated[i].orientation =
+            a.orientation.slerp(alpha, b.orientation);
+        interpolated[i].fov = a.fov + (b.fov - a.fov) * (float) alpha;
+    }
+
+    applySample(appCore, m_latest, tdb, interpolated);
+    return true;
+}
@@ -0,0 +1,119 @@
+// clustersync.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// State streaming for multi-node display clusters.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELESTIA_CLUSTERSYNC_H_
+#define _CELESTIA_CLUSTERSYNC_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <celengine/univcoord.h>
+#include <celutil/timer.h>
+
+class CelestiaCore;
+
+
+//! Synchronizes the simulation state of a cluster of Celestia
+//! instances, one per projector. The master multicasts a small state
+//! packet every tick -- simulation time, time scale, per-view observer
+//! states, the selection when it changes, and the limiting magnitude
+//! -- and clients apply it in place of their own time and camera
+//! motion, interpolating between the two most recent packets so
+//! rendering stays smooth when the display runs faster than the
+//! packet stream. Time is carried in every packet, so time
+//! acceleration cannot drift the nodes apart.
+class ClusterSync
+{
+ public:
+    enum Mode
+    {
+        Disabled = 0,
+        Master   = 1,
+        Client   = 2,
+    };
+
+    ClusterSync() = default;
+    ~ClusterSync();
+    ClusterSync(const ClusterSync&) = delete;
+    ClusterSync& operator=(const ClusterSync&) = delete;
+
+    //! Start multicasting state packets to the given group and port.
+    bool startMaster(const std::string& groupAddress, unsigned short port);
+    //! Join the multicast group and start applying received state.
+    bool startClient(const std::string& groupAddress, unsigned short port);
+    void stop();
+
+    Mode mode() const { return m_mode; }
+
+    //! Master side: send this tick's state. Call once per tick, after
+    //! the simulation has been updated.
+    void broadcastState(CelestiaCore* appCore);
+
+    //! Client side: drain received packets and apply the interpolated
+    //! master state to the simulation. Returns false while no state
+    //! has arrived yet, in which case the node runs free.
+    bool applyState(CelestiaCore* appCore);
+
+ private:
+    struct ObserverState
+    {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        UniversalCoord position;
+        Eigen::Quaterniond orientation;
+        float fov;
+    };
+
+    struct StateSample
+    {
+        uint32_t sequence{ 0 };
+        double tdb{ 0.0 };
+        double timeScale{ 1.0 };
+        bool pauseState{ false };
+        float faintestVisible{ 0.0f };
+        bool hasSelection{ false };
+        std::string selectionPath;
+        std::vector<ObserverState> observers;
+        double arrival{ 0.0 };
+    };
+
+    bool openSocket(const std::string& groupAddress, unsigned short port,
+                    bool master);
+    bool decodePacket(const char* data, size_t length, StateSample& sample);
+    void applySample(CelestiaCore* appCore, const StateSample& sample,
+                     double tdb,
+                     const std::vector<ObserverState>& observers);
+
+    Mode m_mode{ Disabled };
+    intptr_t m_socket{ -1 };
+    unsigned int m_groupAddress{ 0 };
+    unsigned short m_port{ 0 };
+    uint32_t m_sequence{ 0 };
+
+    // The last broadcast/applied discrete state, used to send the
+    // selection only when it changes and to avoid resetting the time
+    // scale and pause state every tick.
+    std::string m_lastSelectionPath;
+    double m_lastTimeScale{ 1.0 };
+    bool m_lastPauseState{ false };
+    float m_lastFaintest{ 0.0f };
+
+    // The two most recent samples, interpolated between on the client
+    StateSample m_previous;
+    StateSample m_latest;
+    bool m_havePrevious{ false };
+    bool m_haveLatest{ false };
+
+    Timer m_timer;
+};
+
+#endif // _CELESTIA_CLUSTERSYNC_H_
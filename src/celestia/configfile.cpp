@@ -90,6 +90,7 @@ CelestiaConfig* ReadCelestiaConfig(const fs::path& filename, CelestiaConfig *con
     configParams->getString("Font", config->mainFont);
     configParams->getString("LabelFont", config->labelFont);
     configParams->getString("TitleFont", config->titleFont);
+    configParams->getString("FontPreloadRanges", config->fontPreloadRanges);
     configParams->getPath("LogoTexture", config->logoTextureFile);
     configParams->getString("Cursor", config->cursor);
 
@@ -127,6 +128,28 @@ CelestiaConfig* ReadCelestiaConfig(const fs::path& filename, CelestiaConfig *con
 
     config->consoleLogRows = getUint(configParams, "LogSize", 200);
 
+    // GPU memory budget for textures and geometry in megabytes;
+    // zero (the default) disables eviction entirely.
+    config->resourceMemoryBudget = getUint(configParams, "ResourceMemoryBudget", 0);
+
+    // Multi-node display cluster synchronization. Mode is "master" or
+    // "client"; by default it is empty and sync stays disabled.
+    configParams->getString("ClusterSyncMode", config->clusterSyncMode);
+    config->clusterSyncAddress = "239.255.42.42";
+    configParams->getString("ClusterSyncAddress", config->clusterSyncAddress);
+    config->clusterSyncPort = getUint(configParams, "ClusterSyncPort", 8701);
+
+    // Frames slower than this many milliseconds trigger an anomaly
+    // report; zero disables the recorder.
+    config->anomalyFrameThreshold = 250.0;
+    configParams->getNumber("AnomalyFrameThreshold", config->anomalyFrameThreshold);
+
+    // Metrics snapshot file in the Prometheus text format, rewritten
+    // every TelemetryInterval seconds; no file means no telemetry.
+    configParams->getPath("TelemetryFile", config->telemetryFile);
+    config->telemetryInterval = 15.0;
+    configParams->getNumber("TelemetryInterval", config->telemetryInterval);
+
     Value* solarSystemsVal = configParams->getValue("SolarSystemCatalogs");
     if (solarSystemsVal != nullptr)
     {
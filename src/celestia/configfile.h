@@ -37,6 +37,7 @@ public:
     std::string mainFont;
     std::string labelFont;
     std::string titleFont;
+    std::string fontPreloadRanges;
     fs::path logoTextureFile;
     std::string cursor;
     std::vector<std::string> ignoreGLExtensions;
@@ -70,6 +71,22 @@ public:
 
     unsigned int consoleLogRows;
 
+    // Texture/geometry memory budget in megabytes; 0 disables eviction
+    unsigned int resourceMemoryBudget;
+
+    // Display cluster synchronization: "master", "client", or empty
+    std::string clusterSyncMode;
+    std::string clusterSyncAddress;
+    unsigned int clusterSyncPort;
+
+    // Frame-time spike trigger in milliseconds; 0 disables the recorder
+    double anomalyFrameThreshold;
+
+    // Periodic metrics export for fleet monitoring; an empty path
+    // leaves telemetry disabled
+    fs::path telemetryFile;
+    double telemetryInterval;
+
     Hash* params;
 
     float getFloatValue(const std::string& name);
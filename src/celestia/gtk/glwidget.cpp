@@ -21,8 +21,11 @@
 #include "common.h"
 
 
+/* Target interval between rendered frames, approximately 60 Hz. */
+#define FRAME_INTERVAL_MS 16
+
 /* Declarations: Callbacks */
-static gint glarea_idle(AppData* app);
+static gint glarea_frame(AppData* app);
 static gint glarea_configure(GtkWidget* widget, GdkEventConfigure*, AppData* app);
 static gint glarea_expose(GtkWidget* widget, GdkEventExpose* event, AppData* app);
 static gint glarea_motion_notify(GtkWidget*, GdkEventMotion* event, AppData* app);
@@ -57,17 +60,43 @@ void initGLCallbacks(AppData* app)
     g_signal_connect(GTK_OBJECT(app->glArea), "key_release_event",
                      G_CALLBACK(glarea_key_release), app);
 
-    /* Main call to execute redraw during GTK main loop */
-    g_idle_add((GSourceFunc)glarea_idle, app);
+    /* Frame pacer: rendering used to run from an idle callback, which
+     * monopolized the main loop and made menu interaction stutter.
+     * Frames are scheduled on a timeout source at a fixed cadence
+     * instead; the gaps between frames leave the loop free to dispatch
+     * UI events. */
+    g_timeout_add(FRAME_INTERVAL_MS, (GSourceFunc)glarea_frame, app);
 
 }
 
 
-/* CALLBACK: GL Function for main update (in GTK idle loop) */
-static gint glarea_idle(AppData* app)
+/* CALLBACK: GL Function for main update (paced by a timeout source) */
+static gint glarea_frame(AppData* app)
 {
+    GTimeVal frameStart, frameEnd;
+    glong frameMs;
+    guint delay;
+
+    g_get_current_time(&frameStart);
+
     app->core->tick();
-    return glDrawFrame(app);
+    glDrawFrame(app);
+
+    /* Schedule the next frame for the remainder of the frame interval.
+     * If the frame took the whole interval or longer -- e.g. because
+     * the buffer swap blocked waiting for vsync -- reschedule almost
+     * immediately and let the swap pace the loop. */
+    g_get_current_time(&frameEnd);
+    frameMs = (frameEnd.tv_sec - frameStart.tv_sec) * 1000 +
+              (frameEnd.tv_usec - frameStart.tv_usec) / 1000;
+    if (frameMs < 0 || frameMs >= FRAME_INTERVAL_MS)
+        delay = 1;
+    else
+        delay = (guint)(FRAME_INTERVAL_MS - frameMs);
+    g_timeout_add(delay, (GSourceFunc)glarea_frame, app);
+
+    /* One-shot source; the next frame was scheduled above. */
+    return FALSE;
 }
 
 
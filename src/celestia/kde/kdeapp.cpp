@@ -97,6 +97,9 @@ KdeApp* KdeApp::app=0;
 
 KBookmarkManager* KCelBookmarkManager::s_bookmarkManager;
 
+// Target interval between rendered frames, approximately 60 Hz.
+static const int frameIntervalMs = 16;
+
 static uint32 FilterOtherLocations = ~(Location::City |
                     Location::Observatory |
                     Location::LandingSite |
@@ -217,12 +220,30 @@ GLenum glewErr = glewInit();
 }
 
 
-    // We use a timer with a null timeout value
-    // to add appCore->tick to Qt's event loop
-    QTimer *t = new QTimer( dynamic_cast<QObject *>(this) );
-    QObject::connect( t, SIGNAL(timeout()), SLOT(celestia_tick()) );
-    t->start( 0, FALSE );
+    // Frame pacer: frames are scheduled through a single-shot timer at
+    // a fixed cadence rather than a null timeout, so the event loop has
+    // room between frames to dispatch menu and dialog events.
+    // celestia_tick() reschedules the timer after each frame.
+    tickTimer = new QTimer( dynamic_cast<QObject *>(this) );
+    QObject::connect( tickTimer, SIGNAL(timeout()), SLOT(celestia_tick()) );
+    tickTimer->start( frameIntervalMs, TRUE );
+
+}
 
+void KdeApp::celestia_tick()
+{
+    QTime frameStart = QTime::currentTime();
+
+    appCore->tick();
+    glWidget->updateGL();
+
+    // Schedule the next frame for the remainder of the frame interval.
+    // If the frame took the whole interval or longer -- e.g. because
+    // the buffer swap blocked waiting for vsync -- reschedule
+    // immediately and let the swap pace the loop.
+    int elapsed = frameStart.msecsTo(QTime::currentTime());
+    int delay = (elapsed < 0 || elapsed >= frameIntervalMs) ? 0 : frameIntervalMs - elapsed;
+    tickTimer->start( delay, TRUE );
 }
 
 void KdeApp::setStartURL(KURL url) {
@@ -43,6 +43,7 @@
 
 class KdeApp;
 class QResizeEvent;
+class QTimer;
 
 class KdeAlerter : public CelestiaCore::Alerter
 {
@@ -93,7 +94,7 @@ signals:
     void resized(int w, int h);
 
 public slots:
-    void celestia_tick() { appCore->tick(); glWidget->updateGL(); }
+    void celestia_tick();
     void slotFileOpen();
     void slotFileOpenRecent(const KURL&);
     void slotNull();
@@ -273,6 +274,9 @@ private:
     QLineEdit *altEdit, *longEdit, *latEdit, *objEdit;
     QComboBox *longSign, *latSign;
 
+    // Single-shot frame pacing timer; celestia_tick() reschedules it
+    // for the remainder of the frame interval after each frame.
+    QTimer* tickTimer;
 };
 
 
@@ -102,7 +102,6 @@ OggTheoraCapture::OggTheoraCapture(const Renderer *r):
     video_frame_count(0),
     video_bytesout(0),
     rowStride(0),
-    pixels(nullptr),
     outfile(nullptr)
 {
     yuvframe[0] = nullptr;
@@ -288,9 +287,9 @@ bool OggTheoraCapture::start(const std::string& filename,
     yuvframe[0]= new unsigned char[video_x*video_y*3];
     yuvframe[1]= new unsigned char[video_x*video_y*3];
 
-    // Now the buffer for reading the GL RGB pixels
+    // Capture buffers for the GL RGB pixels are pooled and recycled
+    // between the readback and encoder sides
     rowStride = (frame_x * 3 + 3) & ~0x3;
-    pixels = new unsigned char[rowStride*frame_y];
 
         /* clear initial frame as it may be larger than actual video data */
         /* fill Y plane with 0x10 and UV planes with 0x80, for black data */
@@ -318,15 +317,102 @@ bool OggTheoraCapture::start(const std::string& filename,
             video_x,video_y,
             frame_x_offset,frame_y_offset);
 
+    encoderQuit = false;
+    encoderThread = thread(&OggTheoraCapture::encoderLoop, this);
+
     capturing = true;
     return true;
 }
 
+// Maximum captured frames waiting for the encoder before the capture
+// side blocks; keeps memory bounded when the encoder falls behind.
+static const size_t MaxQueuedFrames = 3;
+
 bool OggTheoraCapture::captureFrame()
 {
     if (!capturing)
         return false;
 
+    // Get the dimensions of the current viewport
+    int x, y, w, h;
+    renderer->getViewport(&x, &y, &w, &h);
+
+    x += (w - frame_x) / 2;
+    y += (h - frame_y) / 2;
+    renderer->captureFrameAsync(x, y, frame_x, frame_y,
+                                Renderer::PixelFormat::RGB);
+
+    // Retrieve the readback issued two frames ago; the first couple of
+    // calls return nothing while the buffer ring fills, and the
+    // matching frames are drained in stopEncoder().
+    unsigned char* buffer = acquireFrameBuffer();
+    if (renderer->retrieveCapturedFrame(buffer))
+        enqueueFrame(buffer);
+    else
+        releaseFrameBuffer(buffer);
+
+    frameCaptured();
+    return true;
+}
+
+unsigned char* OggTheoraCapture::acquireFrameBuffer()
+{
+    {
+        lock_guard<mutex> lock(queueMutex);
+        if (!freeBuffers.empty())
+        {
+            unsigned char* buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+            return buffer;
+        }
+    }
+    return new unsigned char[rowStride * frame_y];
+}
+
+void OggTheoraCapture::releaseFrameBuffer(unsigned char* buffer)
+{
+    lock_guard<mutex> lock(queueMutex);
+    freeBuffers.push_back(buffer);
+}
+
+void OggTheoraCapture::enqueueFrame(unsigned char* buffer)
+{
+    unique_lock<mutex> lock(queueMutex);
+    queueCond.wait(lock, [this] { return frameQueue.size() < MaxQueuedFrames || encoderQuit; });
+    frameQueue.push_back(buffer);
+    lock.unlock();
+    queueCond.notify_all();
+}
+
+void OggTheoraCapture::encoderLoop()
+{
+    for (;;)
+    {
+        unsigned char* buffer;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCond.wait(lock, [this] { return encoderQuit || !frameQueue.empty(); });
+            if (frameQueue.empty())
+                break;
+            buffer = frameQueue.front();
+            frameQueue.pop_front();
+        }
+
+        encodeFrame(buffer);
+
+        {
+            lock_guard<mutex> lock(queueMutex);
+            freeBuffers.push_back(buffer);
+        }
+        queueCond.notify_all();
+    }
+}
+
+// Convert one captured RGB frame to YUV and feed the theora encoder;
+// runs on the encoder thread, which owns all ogg/theora state and the
+// output file while capture is active.
+void OggTheoraCapture::encodeFrame(const unsigned char* pixels)
+{
     while (ogg_stream_pageout(&to,&videopage)>0)
     {
         /* flush a video page */
@@ -334,17 +420,7 @@ bool OggTheoraCapture::captureFrame()
         video_bytesout+=fwrite(videopage.body,1,videopage.body_len,outfile);
 
     }
-    if(ogg_stream_eos(&to)) return false;
-
-    // Get the dimensions of the current viewport
-    int x, y, w, h;
-    renderer->getViewport(&x, &y, &w, &h);
-
-    x += (w - frame_x) / 2;
-    y += (h - frame_y) / 2;
-    renderer->captureFrame(x, y, frame_x, frame_y,
-                           Renderer::PixelFormat::RGB,
-                           pixels);
+    if(ogg_stream_eos(&to)) return;
 
     unsigned char *ybase = yuvframe[0];
     unsigned char *ubase = yuvframe[0]+ video_x*video_y;
@@ -355,7 +431,7 @@ bool OggTheoraCapture::captureFrame()
         unsigned char *yptr = ybase + (video_x*(y+frame_y_offset))+frame_x_offset;
         unsigned char *uptr = ubase + (video_x*(y+frame_y_offset))+frame_x_offset;
         unsigned char *vptr = vbase + (video_x*(y+frame_y_offset))+frame_x_offset;
-        unsigned char *rgb = pixels + ((frame_y-1-y)*rowStride); // The video is inverted
+        const unsigned char *rgb = pixels + ((frame_y-1-y)*rowStride); // The video is inverted
         for (int x=0; x<frame_x; x++)
         {
             unsigned char r = *rgb++;
@@ -414,13 +490,44 @@ bool OggTheoraCapture::captureFrame()
     unsigned char *temp = yuvframe[0];
     yuvframe[0] = yuvframe[1];
     yuvframe[1] = temp;
-    frameCaptured();
+}
 
-    return true;
+// Drain readbacks still in flight, hand them to the encoder, then shut
+// the encoder thread down. Must run on the GL thread.
+void OggTheoraCapture::stopEncoder()
+{
+    if (!encoderThread.joinable())
+        return;
+
+    while (renderer->hasPendingCapture())
+    {
+        unsigned char* buffer = acquireFrameBuffer();
+        if (renderer->retrieveCapturedFrame(buffer, true))
+        {
+            enqueueFrame(buffer);
+        }
+        else
+        {
+            releaseFrameBuffer(buffer);
+            break;
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        encoderQuit = true;
+    }
+    queueCond.notify_all();
+    encoderThread.join();
+
+    for (auto buffer : freeBuffers)
+        delete [] buffer;
+    freeBuffers.clear();
 }
 void OggTheoraCapture::cleanup()
 {
     capturing = false;
+    stopEncoder();
     /* clear out state */
 
     if(outfile)
@@ -482,7 +589,6 @@ void OggTheoraCapture::cleanup()
         outfile = nullptr;
         delete [] yuvframe[0];
         delete [] yuvframe[1];
-        delete [] pixels;
     }
 }
 
@@ -2,6 +2,11 @@
 #ifndef _OGGTHEORACAPTURE_H_
 #define _OGGTHEORACAPTURE_H_
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "theora/theora.h"
 #include "moviecapture.h"
 
@@ -27,6 +32,16 @@ public:
 private:
     void cleanup();
 
+    // Background encoder; captureFrame() only issues and retrieves
+    // asynchronous readbacks, the YUV conversion and theora/ogg work
+    // runs on encoderThread.
+    void encoderLoop();
+    void encodeFrame(const unsigned char* pixels);
+    void stopEncoder();
+    unsigned char* acquireFrameBuffer();
+    void releaseFrameBuffer(unsigned char* buffer);
+    void enqueueFrame(unsigned char* buffer);
+
 private:
     int video_x;
     int video_y;
@@ -50,7 +65,6 @@ private:
     // instead of clamped to 16-240).
 
     int            rowStride;
-    unsigned char  *pixels;
     unsigned char  *yuvframe[2];
     yuv_buffer     yuv;
     FILE           *outfile;
@@ -63,6 +77,13 @@ private:
     theora_info      ti;
     theora_comment   tc;
 
+    std::thread encoderThread;
+    std::mutex queueMutex;
+    std::condition_variable queueCond;
+    std::deque<unsigned char*> frameQueue;    // captured frames awaiting encode
+    std::vector<unsigned char*> freeBuffers;  // recycled capture buffers
+    bool encoderQuit{ false };
+
     virtual void frameCaptured() {}; /* to update UI status indicator */
 };
 #endif // _OGGTHEORACAPTURE_H_
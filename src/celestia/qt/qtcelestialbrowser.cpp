@@ -28,6 +28,7 @@
 #include <QLineEdit>
 #include <QRegExp>
 #include <QFontMetrics>
+#include <QTimer>
 #include <vector>
 #include <set>
 
@@ -115,6 +116,7 @@ public:
                   StarFilterPredicate& filterPred,
                   StarPredicate::Criterion criterion,
                   unsigned int nStars);
+    void invalidateFilter();
 
     Selection itemAtRow(unsigned int row) const;
 
@@ -123,6 +125,12 @@ private:
     UniversalCoord observerPos{ 0.0, 0.0, 0.0 };
     double now{ astro::J2000 };
     vector<Star*> stars;
+
+    // Result of the last filter pass over the full catalog; reused
+    // until a filter control changes or an add-on grows the catalog.
+    vector<Star*> filteredStars;
+    unsigned int filteredCatalogSize{ 0 };
+    bool filterValid{ false };
 };
 
 Selection StarTableModel::objectAtIndex(const QModelIndex& _index) const
@@ -383,6 +391,12 @@ void StarTableModel::sort(int column, Qt::SortOrder order)
 }
 
 
+void StarTableModel::invalidateFilter()
+{
+    filterValid = false;
+}
+
+
 void StarTableModel::populate(const UniversalCoord& _observerPos,
                               double _now,
                               StarFilterPredicate& filterPred,
@@ -397,66 +411,91 @@ void StarTableModel::populate(const UniversalCoord& _observerPos,
     typedef multiset<Star*, StarPredicate> StarSet;
     StarPredicate pred(criterion, observerPos, universe);
 
-    // Apply the filter
-    vector<Star*> filteredStars;
+    // Apply the filter. The star catalog is effectively static, so
+    // the pass over the full catalog is reused from the previous
+    // populate() unless a filter control changed or an add-on grew
+    // the catalog.
     unsigned int totalStars = stardb.size();
     unsigned int i = 0;
-    filteredStars.reserve(totalStars);
-    for (i = 0; i < totalStars; i++)
+    if (!filterValid || filteredCatalogSize != totalStars)
     {
-        Star* star = stardb.getStar(i);
-        if (!filterPred(star))
-            filteredStars.push_back(star);
+        filteredStars.clear();
+        filteredStars.reserve(totalStars);
+        for (i = 0; i < totalStars; i++)
+        {
+            Star* star = stardb.getStar(i);
+            if (!filterPred(star))
+                filteredStars.push_back(star);
+        }
+        filteredCatalogSize = totalStars;
+        filterValid = true;
     }
 
     // Don't try and show more stars than remain after the filter
     if (filteredStars.size() < nStars)
         nStars = filteredStars.size();
 
-    // Clear out the results of the previous populate() call
-    if (stars.size() != 0)
-    {
-        beginResetModel();
-        stars.clear();
-        endResetModel();
-    }
+    vector<Star*> newStars;
 
-    if (filteredStars.empty())
-        return;
+    if (!filteredStars.empty())
+    {
+        StarSet firstStars(pred);
 
-    StarSet firstStars(pred);
+        // We'll need at least nStars in the set, so first fill
+        // up the list indiscriminately.
+        for (i = 0; i < nStars; i++)
+        {
+            firstStars.insert(filteredStars[i]);
+        }
 
-    // We'll need at least nStars in the set, so first fill
-    // up the list indiscriminately.
-    for (i = 0; i < nStars; i++)
-    {
-        firstStars.insert(filteredStars[i]);
-    }
+        // From here on, only add a star to the set if it's
+        // A better match than the worst matching star already
+        // in the set.
+        const Star* lastStar = *--firstStars.end();
+        for (; i < filteredStars.size(); i++)
+        {
+            Star* star = filteredStars[i];
+            if (pred(star, lastStar))
+            {
+                firstStars.insert(star);
+                firstStars.erase(--firstStars.end());
+                lastStar = *--firstStars.end();
+            }
+        }
 
-    // From here on, only add a star to the set if it's
-    // A better match than the worst matching star already
-    // in the set.
-    const Star* lastStar = *--firstStars.end();
-    for (; i < filteredStars.size(); i++)
-    {
-        Star* star = filteredStars[i];
-        if (pred(star, lastStar))
+        // Move the best matching stars into the vector
+        newStars.reserve(nStars);
+        for (const auto& star : firstStars)
         {
-            firstStars.insert(star);
-            firstStars.erase(--firstStars.end());
-            lastStar = *--firstStars.end();
+            newStars.push_back(star);
         }
     }
 
-    // Move the best matching stars into the vector
-    stars.reserve(nStars);
-    for (const auto& star : firstStars)
+    // Apply the new result set incrementally instead of resetting the
+    // model: the view keeps its scroll position, and only the rows
+    // that exist in both sets repaint in place.
+    int oldCount = (int) stars.size();
+    int newCount = (int) newStars.size();
+
+    if (newCount > oldCount)
+    {
+        beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+        stars = std::move(newStars);
+        endInsertRows();
+    }
+    else if (newCount < oldCount)
+    {
+        beginRemoveRows(QModelIndex(), newCount, oldCount - 1);
+        stars = std::move(newStars);
+        endRemoveRows();
+    }
+    else
     {
-        stars.push_back(star);
+        stars = std::move(newStars);
     }
 
-    beginInsertRows(QModelIndex(), 0, stars.size());
-    endInsertRows();
+    if (newCount > 0)
+        dataChanged(index(0, 0), index(newCount - 1, 4));
 }
 
 
@@ -471,6 +510,7 @@ Selection StarTableModel::itemAtRow(unsigned int row) const
 
 CelestialBrowser::CelestialBrowser(CelestiaCore* _appCore, QWidget* parent, InfoPanel* _infoPanel) :
     QWidget(parent),
+    SimulationWatcher(*_appCore->getSimulation()),
     appCore(_appCore),
     infoPanel(_infoPanel)
 {
@@ -527,7 +567,7 @@ CelestialBrowser::CelestialBrowser(CelestiaCore* _appCore, QWidget* parent, Info
     QGridLayout* filterGroupLayout = new QGridLayout();
 
     withPlanetsFilterBox = new QCheckBox(_("With Planets"));
-    connect(withPlanetsFilterBox, SIGNAL(clicked()), this, SLOT(slotRefreshTable()));
+    connect(withPlanetsFilterBox, SIGNAL(clicked()), this, SLOT(slotFilterChanged()));
     filterGroupLayout->addWidget(withPlanetsFilterBox, 0, 0);
 
     multipleFilterBox = new QCheckBox(_("Multiple Stars"));
@@ -541,7 +581,7 @@ CelestialBrowser::CelestialBrowser(CelestiaCore* _appCore, QWidget* parent, Info
 
     filterGroupLayout->addWidget(new QLabel(_("Spectral Type")), 0, 1);
     spectralTypeFilterBox = new QLineEdit();
-    connect(spectralTypeFilterBox, SIGNAL(editingFinished()), this, SLOT(slotRefreshTable()));
+    connect(spectralTypeFilterBox, SIGNAL(editingFinished()), this, SLOT(slotFilterChanged()));
     filterGroupLayout->addWidget(spectralTypeFilterBox, 0, 2);
 
     filterGroup->setLayout(filterGroupLayout);
@@ -618,21 +658,63 @@ CelestialBrowser::CelestialBrowser(CelestiaCore* _appCore, QWidget* parent, Info
 }
 
 
+/******* SimulationWatcher method ********/
+void CelestialBrowser::notifyChange(Simulation* /* sim */, int changeFlags)
+{
+    // Only a time jump changes what the table shows; selection and
+    // marker changes don't affect its contents.
+    if ((changeFlags & Simulation::TimeJumped) == 0)
+        return;
+
+    modelStale = true;
+    if (isVisible() && !refreshQueued)
+    {
+        // Refresh from the event loop rather than synchronously, so a
+        // burst of notifications costs a single repopulation.
+        refreshQueued = true;
+        QTimer::singleShot(0, this, SLOT(slotQueuedRefresh()));
+    }
+}
+
+
+void CelestialBrowser::showEvent(QShowEvent* ev)
+{
+    QWidget::showEvent(ev);
+    if (modelStale)
+        slotRefreshTable();
+}
+
+
 /******* Slots ********/
 void CelestialBrowser::slotUncheckMultipleFilterBox()
 {
     multipleFilterBox->setChecked(false);
-    slotRefreshTable();
+    slotFilterChanged();
 }
 
 void CelestialBrowser::slotUncheckBarycentersFilterBox()
 {
     barycentersFilterBox->setChecked(false);
+    slotFilterChanged();
+}
+
+void CelestialBrowser::slotFilterChanged()
+{
+    starModel->invalidateFilter();
     slotRefreshTable();
 }
 
+void CelestialBrowser::slotQueuedRefresh()
+{
+    refreshQueued = false;
+    if (modelStale)
+        slotRefreshTable();
+}
+
 void CelestialBrowser::slotRefreshTable()
 {
+    modelStale = false;
+
     UniversalCoord observerPos = appCore->getSimulation()->getActiveObserver()->getPosition();
     double now = appCore->getSimulation()->getTime();
 
@@ -699,7 +781,8 @@ void CelestialBrowser::slotMarkSelected()
                 (float) markerColor.greenF(),
                 (float) markerColor.blueF());
 
-    Universe* universe = appCore->getSimulation()->getUniverse();
+    Simulation* sim = appCore->getSimulation();
+    Universe* universe = sim->getUniverse();
     string label;
 
     for (int row = 0; row < starModel->rowCount(QModelIndex()); row++)
@@ -719,14 +802,14 @@ void CelestialBrowser::slotMarkSelected()
                     }
 
                     // FIXME: unmark is required to change the marker representation
-                    universe->unmarkObject(sel, 1);
-                    universe->markObject(sel,
-                                         MarkerRepresentation(markerSymbol, size, color, label),
-                                         1);
+                    sim->unmarkObject(sel, 1);
+                    sim->markObject(sel,
+                                    MarkerRepresentation(markerSymbol, size, color, label),
+                                    1);
                 }
                 else
                 {
-                    universe->unmarkObject(sel, 1);
+                    sim->unmarkObject(sel, 1);
                 }
             }
         }
@@ -736,19 +819,19 @@ void CelestialBrowser::slotMarkSelected()
 void CelestialBrowser::slotUnmarkSelected()
 {
     QModelIndexList rows = treeView->selectionModel()->selectedRows();
-    Universe* universe = appCore->getSimulation()->getUniverse();
+    Simulation* sim = appCore->getSimulation();
 
     for (const auto &index : rows)
     {
         Selection sel = starModel->objectAtIndex(index);
         if (!sel.empty())
-            universe->unmarkObject(sel, 1);
+            sim->unmarkObject(sel, 1);
     } // for
 }
 
 void CelestialBrowser::slotClearMarkers()
 {
-    appCore->getSimulation()->getUniverse()->unmarkAll();
+    appCore->getSimulation()->unmarkAll();
 }
 
 void CelestialBrowser::slotSelectionChanged(const QItemSelection& newSel, const QItemSelection& oldSel)
@@ -15,10 +15,12 @@
 
 #include <QWidget>
 #include <celengine/body.h>
+#include <celengine/simulation.h>
 #include "qtselectionpopup.h"
 
 class QAbstractItemModel;
 class QItemSelection;
+class QShowEvent;
 class QTreeView;
 class QRadioButton;
 class QComboBox;
@@ -31,7 +33,7 @@ class InfoPanel;
 
 class StarTableModel;
 
-class CelestialBrowser : public QWidget
+class CelestialBrowser : public QWidget, public SimulationWatcher
 {
 Q_OBJECT
 
@@ -39,10 +41,18 @@ Q_OBJECT
     CelestialBrowser(CelestiaCore* _appCore, QWidget* parent, InfoPanel* infoPanel);
     ~CelestialBrowser() = default;
 
+    // SimulationWatcher method: marks the table stale instead of
+    // refreshing synchronously, so bursts of changes (a script
+    // setting time and selection together) coalesce into one refresh,
+    // and a hidden browser defers the work until it is shown.
+    void notifyChange(Simulation*, int changeFlags) override;
+
  public slots:
     void slotUncheckMultipleFilterBox();
     void slotUncheckBarycentersFilterBox();
+    void slotFilterChanged();
     void slotRefreshTable();
+    void slotQueuedRefresh();
     void slotContextMenu(const QPoint& pos);
     void slotMarkSelected();
     void slotUnmarkSelected();
@@ -52,9 +62,15 @@ Q_OBJECT
  signals:
     void selectionContextMenuRequested(const QPoint& pos, Selection& sel);
 
+ protected:
+    void showEvent(QShowEvent*) override;
+
  private:
     CelestiaCore* appCore;
 
+    bool modelStale{false};
+    bool refreshQueued{false};
+
     StarTableModel* starModel{nullptr};
     QTreeView* treeView{nullptr};
 
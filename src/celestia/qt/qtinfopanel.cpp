@@ -42,6 +42,7 @@ static void CalculateOsculatingElements(const Orbit& orbit,
 
 InfoPanel::InfoPanel(CelestiaCore* _appCore, const QString& title, QWidget* parent) :
     QDockWidget(title, parent),
+    SimulationWatcher(*_appCore->getSimulation()),
     appCore(_appCore)
 {
     textBrowser = new QTextBrowser(this);
@@ -50,6 +51,20 @@ InfoPanel::InfoPanel(CelestiaCore* _appCore, const QString& title, QWidget* pare
 }
 
 
+void InfoPanel::notifyChange(Simulation* sim, int changeFlags)
+{
+    // A hidden panel does no work; it is rebuilt on the next explicit
+    // request.
+    if ((changeFlags & Simulation::SelectionChanged) == 0 || !isVisible())
+        return;
+
+    if (sim->getSelection().empty())
+        return;
+
+    buildInfoPage(sim->getSelection(), sim->getUniverse(), sim->getTime());
+}
+
+
 void InfoPanel::buildInfoPage(Selection sel,
                               Universe* universe,
                               double tdb)
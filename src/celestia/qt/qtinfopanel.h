@@ -16,6 +16,7 @@
 #include <QDockWidget>
 #include <QTextStream>
 #include "celengine/selection.h"
+#include "celengine/simulation.h"
 
 class QTextBrowser;
 class Universe;
@@ -30,7 +31,7 @@ class ModelHelper
     virtual Selection itemForInfoPanel(const QModelIndex&) = 0;
 };
 
-class InfoPanel : public QDockWidget
+class InfoPanel : public QDockWidget, public SimulationWatcher
 {
  public:
     InfoPanel(CelestiaCore* appCore, const QString& title, QWidget* parent);
@@ -40,6 +41,11 @@ class InfoPanel : public QDockWidget
 
     void updateHelper(ModelHelper*, const QItemSelection&, const QItemSelection&);
 
+    // SimulationWatcher method: rebuild the page whenever the
+    // simulation selection changes, instead of waiting for a browser
+    // row click.
+    void notifyChange(Simulation*, int changeFlags) override;
+
  private:
     void pageHeader(QTextStream&);
     void pageFooter(QTextStream&);
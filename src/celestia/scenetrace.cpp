@@ -0,0 +1,313 @@
+// scenetrace.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Recorded scene traces and the replay benchmark built on them.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <vector>
+
+#include <celengine/observer.h>
+#include <celengine/render.h>
+#include <celengine/simulation.h>
+#include <celutil/timer.h>
+#include <fmt/printf.h>
+#include "celestiacore.h"
+#include "scenetrace.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+namespace
+{
+
+const char TraceMagic[8] = { 'C', 'E', 'L', 'T', 'R', 'A', 'C', 'E' };
+const uint16_t TraceVersion = 1;
+
+// All multi-byte fields are little-endian, written bytewise so the
+// encoding doesn't depend on host byte order.
+
+void writeUint64(ostream& out, uint64_t v)
+{
+    char buf[8];
+    for (int i = 0; i < 8; i++)
+        buf[i] = (char) ((v >> (i * 8)) & 0xff);
+    out.write(buf, 8);
+}
+
+void writeUint32(ostream& out, uint32_t v)
+{
+    char buf[4];
+    for (int i = 0; i < 4; i++)
+        buf[i] = (char) ((v >> (i * 8)) & 0xff);
+    out.write(buf, 4);
+}
+
+void writeUint16(ostream& out, uint16_t v)
+{
+    char buf[2];
+    buf[0] = (char) (v & 0xff);
+    buf[1] = (char) ((v >> 8) & 0xff);
+    out.write(buf, 2);
+}
+
+void writeFloat(ostream& out, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint32(out, bits);
+}
+
+void writeDouble(ostream& out, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint64(out, bits);
+}
+
+bool readUint64(istream& in, uint64_t& v)
+{
+    char buf[8];
+    if (!in.read(buf, 8))
+        return false;
+    v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t) (uint8_t) buf[i] << (i * 8);
+    return true;
+}
+
+bool readUint32(istream& in, uint32_t& v)
+{
+    char buf[4];
+    if (!in.read(buf, 4))
+        return false;
+    v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t) (uint8_t) buf[i] << (i * 8);
+    return true;
+}
+
+bool readUint16(istream& in, uint16_t& v)
+{
+    char buf[2];
+    if (!in.read(buf, 2))
+        return false;
+    v = (uint16_t) ((uint8_t) buf[0] | ((uint16_t) (uint8_t) buf[1] << 8));
+    return true;
+}
+
+bool readFloat(istream& in, float& v)
+{
+    uint32_t bits;
+    if (!readUint32(in, bits))
+        return false;
+    memcpy(&v, &bits, sizeof v);
+    return true;
+}
+
+bool readDouble(istream& in, double& v)
+{
+    uint64_t bits;
+    if (!readUint64(in, bits))
+        return false;
+    memcpy(&v, &bits, sizeof v);
+    return true;
+}
+
+double percentile(const vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = (size_t) (p * (double) (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+} // end unnamed namespace
+
+
+bool SceneTrace::write(ostream& out) const
+{
+    out.write(TraceMagic, sizeof TraceMagic);
+    writeUint16(out, TraceVersion);
+    writeDouble(out, startTdb);
+    writeDouble(out, timeScale);
+    writeUint64(out, renderFlags);
+    writeUint32(out, labelMode);
+    writeFloat(out, fov);
+    writeFloat(out, faintestVisible);
+    if (!out.good())
+        return false;
+    return path.write(out);
+}
+
+
+bool SceneTrace::read(istream& in)
+{
+    char magic[sizeof TraceMagic];
+    if (!in.read(magic, sizeof magic) ||
+        memcmp(magic, TraceMagic, sizeof magic) != 0)
+        return false;
+
+    uint16_t version;
+    if (!readUint16(in, version) || version != TraceVersion)
+        return false;
+
+    if (!readDouble(in, startTdb) ||
+        !readDouble(in, timeScale) ||
+        !readUint64(in, renderFlags) ||
+        !readUint32(in, labelMode) ||
+        !readFloat(in, fov) ||
+        !readFloat(in, faintestVisible))
+        return false;
+
+    return path.read(in);
+}
+
+
+bool SceneTrace::save(const fs::path& filename) const
+{
+    ofstream out(filename.string(), ios::out | ios::binary);
+    return out.good() && write(out);
+}
+
+
+bool SceneTrace::load(const fs::path& filename)
+{
+    ifstream in(filename.string(), ios::in | ios::binary);
+    return in.good() && read(in);
+}
+
+
+void CelestiaCore::beginSceneTrace()
+{
+    if (sceneTrace != nullptr)
+        return;
+
+    // The settings active now define the scene being traced; the
+    // camera keyframes accumulate on the observer until the trace
+    // ends.
+    sceneTrace = new SceneTrace();
+    sceneTrace->startTdb = sim->getTime();
+    sceneTrace->timeScale = sim->getTimeScale();
+    sceneTrace->renderFlags = renderer->getRenderFlags();
+    sceneTrace->labelMode = (uint32_t) renderer->getLabelMode();
+    sceneTrace->fov = sim->getActiveObserver()->getFOV();
+    sceneTrace->faintestVisible = sim->getFaintestVisible();
+    sim->getActiveObserver()->beginRecording();
+}
+
+
+bool CelestiaCore::endSceneTrace(const fs::path& filename)
+{
+    if (sceneTrace == nullptr)
+        return false;
+
+    shared_ptr<FlightPath> recorded = sim->getActiveObserver()->endRecording();
+    bool success = false;
+    if (recorded != nullptr && recorded->sampleCount() > 0)
+    {
+        sceneTrace->path = *recorded;
+        success = sceneTrace->save(filename);
+    }
+
+    delete sceneTrace;
+    sceneTrace = nullptr;
+    return success;
+}
+
+
+// Replay a recorded trace frame by frame and report timing
+// percentiles. The caller owns the GL context (a CI runner typically
+// provides an offscreen one); the simulation is stepped with the
+// deterministic fixed time step, so the same trace renders the same
+// frames on every build and the numbers are comparable across
+// releases. Frame times are CPU-side; per-pass GPU times come from
+// the renderer's pass timing queries.
+bool CelestiaCore::replaySceneTrace(const fs::path& filename,
+                                    ostream& report,
+                                    double frameStep)
+{
+    SceneTrace trace;
+    if (!trace.load(filename) || frameStep <= 0.0)
+        return false;
+
+    Observer* observer = sim->getActiveObserver();
+
+    // Apply the recorded scene state
+    sim->setTime(trace.startTdb);
+    sim->setTimeScale(trace.timeScale);
+    renderer->setRenderFlags(trace.renderFlags);
+    renderer->setLabelMode((int) trace.labelMode);
+    setFaintest(trace.faintestVisible);
+    observer->setFOV(trace.fov);
+
+    double savedTimeStep = getFixedTimeStep();
+    bool savedPassTiming = renderer->getPassTimingEnabled();
+    setFixedTimeStep(frameStep);
+    renderer->setPassTimingEnabled(true);
+
+    long frameCount = (long) (trace.path.duration() / frameStep) + 1;
+    vector<double> frameTimes;
+    frameTimes.reserve(frameCount);
+
+    Timer timer;
+    for (long frame = 0; frame < frameCount; frame++)
+    {
+        UniversalCoord position;
+        Quaterniond orientation;
+        if (trace.path.evaluate((double) frame * frameStep, position, orientation))
+        {
+            observer->setPosition(position);
+            observer->setOrientation(orientation);
+        }
+
+        timer.reset();
+        tick();
+        draw();
+        frameTimes.push_back(timer.getTime() * 1000.0);
+    }
+
+    setFixedTimeStep(savedTimeStep);
+    renderer->setPassTimingEnabled(savedPassTiming);
+
+    // Percentile report
+    vector<double> sorted(frameTimes);
+    sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (const auto t : sorted)
+        total += t;
+    double mean = sorted.empty() ? 0.0 : total / (double) sorted.size();
+
+    fmt::fprintf(report, "%ld frames, %.1f s of trace at %.1f fps\n",
+                 (long) sorted.size(), trace.path.duration(), 1.0 / frameStep);
+    fmt::fprintf(report, "frame ms: mean %.2f  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n",
+                 mean,
+                 percentile(sorted, 0.50),
+                 percentile(sorted, 0.95),
+                 percentile(sorted, 0.99),
+                 sorted.empty() ? 0.0 : sorted.back());
+
+    map<string, Renderer::PassTiming> passes = renderer->getPassTimings();
+    if (!passes.empty())
+    {
+        fmt::fprintf(report, "%-20s %10s %10s\n", "pass", "cpu ms", "gpu ms");
+        for (const auto& pass : passes)
+        {
+            fmt::fprintf(report, "%-20s %10.3f %10.3f\n",
+                         pass.first,
+                         pass.second.cpuTimeMs,
+                         pass.second.gpuTimeMs);
+        }
+    }
+
+    return true;
+}
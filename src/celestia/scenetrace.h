@@ -0,0 +1,45 @@
+// scenetrace.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Recorded scene traces for replayable render benchmarks.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELESTIA_SCENETRACE_H_
+#define _CELESTIA_SCENETRACE_H_
+
+#include <iosfwd>
+#include <celcompat/filesystem.h>
+#include <celengine/flightpath.h>
+
+
+//! A scene trace captures everything needed to re-render a recorded
+//! session: the camera flight path plus the simulation time, time
+//! scale and render settings that were active when recording started.
+//! Replaying a trace with CelestiaCore::replaySceneTrace() steps it at
+//! a fixed frame interval and reports per-frame and per-pass timing
+//! percentiles, so the same operator session can be measured across
+//! builds.
+class SceneTrace
+{
+ public:
+    double startTdb{ 0.0 };
+    double timeScale{ 1.0 };
+    uint64_t renderFlags{ 0 };
+    uint32_t labelMode{ 0 };
+    float fov{ 0.0f };
+    float faintestVisible{ 0.0f };
+    FlightPath path;
+
+    bool write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+    bool save(const fs::path& filename) const;
+    bool load(const fs::path& filename);
+};
+
+#endif // _CELESTIA_SCENETRACE_H_
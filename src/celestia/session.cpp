@@ -0,0 +1,475 @@
+// session.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Binary session snapshots: save and restore the complete interactive
+// state -- one observer per view, the view layout, markers, selection
+// and time -- so a session can resume without re-running the scripts
+// that produced it.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <celengine/marker.h>
+#include <celengine/observer.h>
+#include <celengine/simulation.h>
+#include "celestiacore.h"
+#include "url.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+// Defined in url.cpp: the complete (URL-encoded) path of a selection.
+const string getEncodedObjectName(const Selection& sel, const CelestiaCore* appCore);
+
+
+namespace
+{
+
+const char SessionMagic[8] = { 'C', 'E', 'L', 'S', 'E', 'S', 'S', 'N' };
+const uint16_t SessionVersion = 1;
+
+// View tree node tags; the values match View::Type.
+const uint8_t WindowNode = 1;
+const uint8_t HorizontalSplitNode = 2;
+const uint8_t VerticalSplitNode = 3;
+
+
+// All multi-byte fields are stored little-endian, assembled bytewise
+// so the encoding doesn't depend on the host byte order.
+
+void writeUint64(ostream& out, uint64_t v)
+{
+    char buf[8];
+    for (int i = 0; i < 8; i++)
+        buf[i] = (char) ((v >> (i * 8)) & 0xff);
+    out.write(buf, 8);
+}
+
+void writeUint32(ostream& out, uint32_t v)
+{
+    char buf[4];
+    for (int i = 0; i < 4; i++)
+        buf[i] = (char) ((v >> (i * 8)) & 0xff);
+    out.write(buf, 4);
+}
+
+void writeUint16(ostream& out, uint16_t v)
+{
+    char buf[2];
+    buf[0] = (char) (v & 0xff);
+    buf[1] = (char) ((v >> 8) & 0xff);
+    out.write(buf, 2);
+}
+
+void writeUint8(ostream& out, uint8_t v)
+{
+    out.put((char) v);
+}
+
+void writeFloat(ostream& out, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint32(out, bits);
+}
+
+void writeDouble(ostream& out, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    writeUint64(out, bits);
+}
+
+void writeString(ostream& out, const string& s)
+{
+    writeUint16(out, (uint16_t) min(s.length(), (size_t) 0xffff));
+    out.write(s.c_str(), min(s.length(), (size_t) 0xffff));
+}
+
+// BigFix coordinates are stored in the same base64 encoding the
+// cel:// URL scheme uses, length-prefixed; the round trip is exact.
+void writeBigFix(ostream& out, const BigFix& v)
+{
+    BigFix b = v;
+    string s = b.toString();
+    writeUint8(out, (uint8_t) s.length());
+    out.write(s.c_str(), s.length());
+}
+
+bool readUint64(istream& in, uint64_t& v)
+{
+    char buf[8];
+    if (!in.read(buf, 8))
+        return false;
+    v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t) (uint8_t) buf[i] << (i * 8);
+    return true;
+}
+
+bool readUint32(istream& in, uint32_t& v)
+{
+    char buf[4];
+    if (!in.read(buf, 4))
+        return false;
+    v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t) (uint8_t) buf[i] << (i * 8);
+    return true;
+}
+
+bool readUint16(istream& in, uint16_t& v)
+{
+    char buf[2];
+    if (!in.read(buf, 2))
+        return false;
+    v = (uint16_t) ((uint8_t) buf[0] | ((uint16_t) (uint8_t) buf[1] << 8));
+    return true;
+}
+
+bool readUint8(istream& in, uint8_t& v)
+{
+    int c = in.get();
+    if (c == EOF)
+        return false;
+    v = (uint8_t) c;
+    return true;
+}
+
+bool readFloat(istream& in, float& v)
+{
+    uint32_t bits;
+    if (!readUint32(in, bits))
+        return false;
+    memcpy(&v, &bits, sizeof v);
+    return true;
+}
+
+bool readDouble(istream& in, double& v)
+{
+    uint64_t bits;
+    if (!readUint64(in, bits))
+        return false;
+    memcpy(&v, &bits, sizeof v);
+    return true;
+}
+
+bool readString(istream& in, string& s)
+{
+    uint16_t length;
+    if (!readUint16(in, length))
+        return false;
+    s.resize(length);
+    return length == 0 || !!in.read(&s[0], length);
+}
+
+bool readBigFix(istream& in, BigFix& v)
+{
+    uint8_t len = 0;
+    if (!readUint8(in, len))
+        return false;
+    char buf[256];
+    if (!in.read(buf, len))
+        return false;
+    v = BigFix(string(buf, len));
+    return true;
+}
+
+
+// Selections are stored as their complete name path, the same path
+// the cel:// URL scheme uses (but without the percent encoding).
+void writeSelection(ostream& out, const Selection& sel, const CelestiaCore* appCore)
+{
+    writeString(out, Url::decodeString(getEncodedObjectName(sel, appCore)));
+}
+
+bool readSelection(istream& in, Simulation* sim, Selection& sel)
+{
+    string path;
+    if (!readString(in, path))
+        return false;
+    sel = path.empty() ? Selection() : sim->findObjectFromPath(path);
+    return true;
+}
+
+
+void writeObserverState(ostream& out, const Observer* observer,
+                        const CelestiaCore* appCore)
+{
+    UniversalCoord position = observer->getPosition();
+    writeBigFix(out, position.x);
+    writeBigFix(out, position.y);
+    writeBigFix(out, position.z);
+
+    Quaterniond orientation = observer->getOrientation();
+    writeDouble(out, orientation.w());
+    writeDouble(out, orientation.x());
+    writeDouble(out, orientation.y());
+    writeDouble(out, orientation.z());
+
+    writeFloat(out, observer->getFOV());
+
+    const ObserverFrame::SharedConstPtr& frame = observer->getFrame();
+    writeUint8(out, (uint8_t) frame->getCoordinateSystem());
+    writeSelection(out, frame->getRefObject(), appCore);
+    writeSelection(out, frame->getTargetObject(), appCore);
+    writeSelection(out, observer->getTrackedObject(), appCore);
+}
+
+bool readObserverState(istream& in, Observer* observer, Simulation* sim)
+{
+    BigFix x, y, z;
+    if (!readBigFix(in, x) || !readBigFix(in, y) || !readBigFix(in, z))
+        return false;
+
+    double qw, qx, qy, qz;
+    if (!readDouble(in, qw) || !readDouble(in, qx) ||
+        !readDouble(in, qy) || !readDouble(in, qz))
+        return false;
+
+    float fov;
+    if (!readFloat(in, fov))
+        return false;
+
+    uint8_t coordSys;
+    Selection refObject, targetObject, trackedObject;
+    if (!readUint8(in, coordSys) ||
+        !readSelection(in, sim, refObject) ||
+        !readSelection(in, sim, targetObject) ||
+        !readSelection(in, sim, trackedObject))
+        return false;
+
+    // The frame first: positions and orientations are universal, but
+    // the observer converts them into frame coordinates as they are
+    // set.
+    observer->setFrame((ObserverFrame::CoordinateSystem) coordSys,
+                       refObject, targetObject);
+    observer->setPosition(UniversalCoord(x, y, z));
+    observer->setOrientation(Quaterniond(qw, qx, qy, qz));
+    observer->setTrackedObject(trackedObject);
+    observer->setFOV(fov);
+
+    return true;
+}
+
+} // end unnamed namespace
+
+
+// Serialize the view tree in depth first order. Splits record which
+// fraction of the parent the first child occupies; windows record the
+// state of their observer.
+void CelestiaCore::saveViewTree(ostream& out, const View* view) const
+{
+    if (view->type == View::ViewWindow)
+    {
+        writeUint8(out, WindowNode);
+        writeUint8(out, view == *activeView ? 1 : 0);
+        writeFloat(out, view->zoom);
+        writeObserverState(out, view->observer, this);
+        return;
+    }
+
+    writeUint8(out, view->type == View::HorizontalSplit ? HorizontalSplitNode
+                                                        : VerticalSplitNode);
+    float splitPos = view->type == View::VerticalSplit
+        ? view->child1->width / view->width
+        : view->child1->height / view->height;
+    writeFloat(out, splitPos);
+    saveViewTree(out, view->child1);
+    saveViewTree(out, view->child2);
+}
+
+
+// Rebuild the view tree below leaf, which must be an unsplit window.
+// Splitting leaves the existing view as the first child, so the first
+// subtree restores into leaf and the second into the freshly created
+// window. The window that was marked active at save time is reported
+// through newActiveView.
+bool CelestiaCore::restoreViewTree(istream& in, View* leaf, View** newActiveView)
+{
+    uint8_t nodeType;
+    if (!readUint8(in, nodeType))
+        return false;
+
+    if (nodeType == WindowNode)
+    {
+        uint8_t active;
+        float zoom;
+        if (!readUint8(in, active) || !readFloat(in, zoom))
+            return false;
+        if (!readObserverState(in, leaf->observer, sim))
+            return false;
+        leaf->zoom = zoom;
+        if (active != 0)
+            *newActiveView = leaf;
+        return true;
+    }
+
+    if (nodeType != HorizontalSplitNode && nodeType != VerticalSplitNode)
+        return false;
+
+    float splitPos;
+    if (!readFloat(in, splitPos))
+        return false;
+    if (!(splitPos > 0.0f && splitPos < 1.0f))
+        return false;
+
+    // Split directly instead of through splitView(): restoring must
+    // not be subject to the minimum interactive split size, and the
+    // new observer state is about to be overwritten anyway.
+    Observer* o = sim->addObserver();
+    *o = *(sim->getActiveObserver());
+
+    View *split, *view;
+    View::Type type = nodeType == HorizontalSplitNode ? View::HorizontalSplit
+                                                      : View::VerticalSplit;
+    leaf->split(type, o, splitPos, &split, &view);
+    views.push_back(split);
+    views.push_back(view);
+
+    return restoreViewTree(in, leaf, newActiveView) &&
+           restoreViewTree(in, view, newActiveView);
+}
+
+
+bool CelestiaCore::saveSessionSnapshot(ostream& out) const
+{
+    out.write(SessionMagic, sizeof SessionMagic);
+    writeUint16(out, SessionVersion);
+
+    // Time state
+    writeDouble(out, sim->getTime());
+    writeDouble(out, sim->getTimeScale());
+    writeUint8(out, sim->getPauseState() ? 1 : 0);
+
+    // Selection
+    writeSelection(out, sim->getSelection(), this);
+
+    // View layout and per-view observer states
+    const View* root = views.front();
+    while (root->parent != nullptr)
+        root = root->parent;
+    saveViewTree(out, root);
+
+    // Markers
+    const MarkerList* markers = sim->getUniverse()->getMarkers();
+    writeUint32(out, (uint32_t) markers->size());
+    for (const auto& marker : *markers)
+    {
+        writeSelection(out, marker.object(), this);
+        writeUint32(out, (uint32_t) marker.priority());
+        writeUint8(out, marker.occludable() ? 1 : 0);
+        writeUint8(out, (uint8_t) marker.sizing());
+        writeUint8(out, (uint8_t) marker.representation().symbol());
+        writeFloat(out, marker.representation().size());
+        Color color = marker.representation().color();
+        writeFloat(out, color.red());
+        writeFloat(out, color.green());
+        writeFloat(out, color.blue());
+        writeFloat(out, color.alpha());
+        writeString(out, marker.representation().label());
+    }
+
+    return out.good();
+}
+
+
+bool CelestiaCore::restoreSessionSnapshot(istream& in)
+{
+    char magic[sizeof SessionMagic];
+    if (!in.read(magic, sizeof magic) ||
+        memcmp(magic, SessionMagic, sizeof magic) != 0)
+        return false;
+
+    uint16_t version;
+    if (!readUint16(in, version) || version != SessionVersion)
+        return false;
+
+    double tdb, timeScale;
+    uint8_t pauseState;
+    if (!readDouble(in, tdb) || !readDouble(in, timeScale) ||
+        !readUint8(in, pauseState))
+        return false;
+
+    Selection selection;
+    if (!readSelection(in, sim, selection))
+        return false;
+
+    sim->cancelMotion();
+    sim->setTime(tdb);
+
+    // Collapse to a single view, then rebuild the saved layout
+    singleView();
+    View* newActiveView = *activeView;
+    if (!restoreViewTree(in, *activeView, &newActiveView))
+        return false;
+    setActiveView(newActiveView);
+    setFOVFromZoom();
+
+    sim->setSelection(selection);
+    sim->setTimeScale(timeScale);
+    sim->setPauseState(pauseState != 0);
+
+    // Markers
+    Universe* universe = sim->getUniverse();
+    universe->unmarkAll();
+    uint32_t markerCount;
+    if (!readUint32(in, markerCount))
+        return false;
+    for (uint32_t i = 0; i < markerCount; i++)
+    {
+        Selection object;
+        uint32_t priority;
+        uint8_t occludable, sizing, symbol;
+        float size, red, green, blue, alpha;
+        string label;
+        if (!readSelection(in, sim, object) ||
+            !readUint32(in, priority) ||
+            !readUint8(in, occludable) ||
+            !readUint8(in, sizing) ||
+            !readUint8(in, symbol) ||
+            !readFloat(in, size) ||
+            !readFloat(in, red) ||
+            !readFloat(in, green) ||
+            !readFloat(in, blue) ||
+            !readFloat(in, alpha) ||
+            !readString(in, label))
+            return false;
+
+        // A marker whose object is gone (e.g. an add-on was removed)
+        // is silently dropped.
+        if (object.empty())
+            continue;
+
+        MarkerRepresentation rep((MarkerRepresentation::Symbol) symbol,
+                                 size,
+                                 Color(red, green, blue, alpha),
+                                 label);
+        universe->markObject(object, rep, (int) priority, occludable != 0,
+                             (MarkerSizing) sizing);
+    }
+
+    return true;
+}
+
+
+bool CelestiaCore::saveSessionSnapshot(const fs::path& path) const
+{
+    ofstream out(path.string(), ios::out | ios::binary);
+    return out.good() && saveSessionSnapshot(out) && !!out;
+}
+
+
+bool CelestiaCore::restoreSessionSnapshot(const fs::path& path)
+{
+    ifstream in(path.string(), ios::in | ios::binary);
+    return in.good() && restoreSessionSnapshot(in);
+}
@@ -0,0 +1,206 @@
+// telemetry.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Periodic metrics export for fleet monitoring.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <celengine/glstats.h>
+#include <celutil/alloctag.h>
+#include <celutil/debug.h>
+#include <celutil/memaudit.h>
+#include <celutil/resbudget.h>
+#include <fmt/printf.h>
+#include "telemetry.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Percentile of a sample set by nearest-rank; sorts its argument.
+double percentile(vector<float>& samples, double p)
+{
+    if (samples.empty())
+        return 0.0;
+    sort(samples.begin(), samples.end());
+    size_t rank = (size_t) (p * (double) (samples.size() - 1) + 0.5);
+    return samples[min(rank, samples.size() - 1)];
+}
+
+
+// Prometheus label values allow any UTF-8 but backslash, quote and
+// newline must be escaped; component names here are directory names,
+// so replacing the troublemakers is enough.
+string labelValue(const string& s)
+{
+    string escaped;
+    escaped.reserve(s.size());
+    for (char c : s)
+    {
+        if (c == '\\' || c == '"')
+            escaped += '\\';
+        if (c == '\n')
+            continue;
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // end unnamed namespace
+
+
+TelemetryExporter::TelemetryExporter(const fs::path& _outputPath,
+                                     double _intervalSeconds) :
+    outputPath(_outputPath),
+    intervalSeconds(max(1.0, _intervalSeconds))
+{
+    frameTimes.reserve(4096);
+}
+
+
+void TelemetryExporter::recordFrame(double frameTimeMs)
+{
+    totalFrames++;
+    frameTimes.push_back((float) frameTimeMs);
+}
+
+
+void TelemetryExporter::recordScriptSlice(double sliceMs)
+{
+    scriptSlices.push_back((float) sliceMs);
+}
+
+
+void TelemetryExporter::update(double wallTime)
+{
+    if (wallTime - lastExportTime < intervalSeconds)
+        return;
+    lastExportTime = wallTime;
+
+    exportReport();
+
+    frameTimes.clear();
+    scriptSlices.clear();
+}
+
+
+void TelemetryExporter::exportReport()
+{
+    // Write to a temporary name and rename into place, so a scraper
+    // reading the file never sees a partial snapshot.
+    fs::path tempPath = outputPath;
+    tempPath += ".tmp";
+
+    ofstream out(tempPath.string(), ios::out | ios::trunc);
+    if (!out.good())
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Cannot write telemetry file %s\n",
+                tempPath.string());
+        return;
+    }
+
+    fmt::fprintf(out, "# HELP celestia_frames_total Frames rendered since startup.\n");
+    fmt::fprintf(out, "# TYPE celestia_frames_total counter\n");
+    fmt::fprintf(out, "celestia_frames_total %llu\n",
+                 (unsigned long long) totalFrames);
+
+    fmt::fprintf(out, "# HELP celestia_frame_time_ms Frame time percentiles over the last export interval.\n");
+    fmt::fprintf(out, "# TYPE celestia_frame_time_ms summary\n");
+    fmt::fprintf(out, "celestia_frame_time_ms{quantile=\"0.5\"} %.3f\n",
+                 percentile(frameTimes, 0.5));
+    fmt::fprintf(out, "celestia_frame_time_ms{quantile=\"0.9\"} %.3f\n",
+                 percentile(frameTimes, 0.9));
+    fmt::fprintf(out, "celestia_frame_time_ms{quantile=\"0.99\"} %.3f\n",
+                 percentile(frameTimes, 0.99));
+    fmt::fprintf(out, "celestia_frame_time_ms{quantile=\"1\"} %.3f\n",
+                 frameTimes.empty() ? 0.0
+                     : *max_element(frameTimes.begin(), frameTimes.end()));
+
+    if (!scriptSlices.empty())
+    {
+        fmt::fprintf(out, "# HELP celestia_script_slice_ms Script slice time percentiles over the last export interval.\n");
+        fmt::fprintf(out, "# TYPE celestia_script_slice_ms summary\n");
+        fmt::fprintf(out, "celestia_script_slice_ms{quantile=\"0.5\"} %.3f\n",
+                     percentile(scriptSlices, 0.5));
+        fmt::fprintf(out, "celestia_script_slice_ms{quantile=\"0.99\"} %.3f\n",
+                     percentile(scriptSlices, 0.99));
+        fmt::fprintf(out, "celestia_script_slice_ms{quantile=\"1\"} %.3f\n",
+                     *max_element(scriptSlices.begin(), scriptSlices.end()));
+    }
+
+    // Memory by subsystem from the registered reporters
+    MemoryLedger ledger;
+    GetMemoryAudit().collect(ledger);
+    fmt::fprintf(out, "# HELP celestia_memory_bytes Estimated memory by subsystem and category.\n");
+    fmt::fprintf(out, "# TYPE celestia_memory_bytes gauge\n");
+    for (const auto& entry : ledger.entries())
+    {
+        fmt::fprintf(out, "celestia_memory_bytes{component=\"%s\",category=\"%s\"} %ju\n",
+                     labelValue(entry.component), labelValue(entry.category),
+                     entry.bytes);
+    }
+
+    // Resource cache behaviour; the hit rate is
+    // 1 - loads_total / lookups_total
+    ResourceBudget& budget = GetResourceBudget();
+    fmt::fprintf(out, "# HELP celestia_resource_lookups_total Resource manager lookups.\n");
+    fmt::fprintf(out, "# TYPE celestia_resource_lookups_total counter\n");
+    fmt::fprintf(out, "celestia_resource_lookups_total %ju\n", budget.lookupCount());
+    fmt::fprintf(out, "# HELP celestia_resource_loads_total Lookups that required a disk load.\n");
+    fmt::fprintf(out, "# TYPE celestia_resource_loads_total counter\n");
+    fmt::fprintf(out, "celestia_resource_loads_total %ju\n", budget.loadCount());
+    fmt::fprintf(out, "# HELP celestia_resource_resident_bytes Budget-managed resources currently loaded.\n");
+    fmt::fprintf(out, "# TYPE celestia_resource_resident_bytes gauge\n");
+    fmt::fprintf(out, "celestia_resource_resident_bytes %ju\n", budget.residentBytes());
+    fmt::fprintf(out, "# HELP celestia_resource_evicted_bytes_total Bytes released by budget eviction.\n");
+    fmt::fprintf(out, "# TYPE celestia_resource_evicted_bytes_total counter\n");
+    fmt::fprintf(out, "celestia_resource_evicted_bytes_total %ju\n", budget.evictedBytes());
+    fmt::fprintf(out, "# HELP celestia_resource_eviction_runs_total Budget eviction passes.\n");
+    fmt::fprintf(out, "# TYPE celestia_resource_eviction_runs_total counter\n");
+    fmt::fprintf(out, "celestia_resource_eviction_runs_total %u\n", budget.evictionRuns());
+
+    // Last frame's GL workload
+    const GLStats::Counters& gl = GLStats::lastFrame();
+    fmt::fprintf(out, "# HELP celestia_gl_draw_calls Draw calls in the most recent frame.\n");
+    fmt::fprintf(out, "# TYPE celestia_gl_draw_calls gauge\n");
+    fmt::fprintf(out, "celestia_gl_draw_calls %llu\n",
+                 (unsigned long long) gl.drawCalls);
+    fmt::fprintf(out, "# HELP celestia_gl_program_changes Shader program changes in the most recent frame.\n");
+    fmt::fprintf(out, "# TYPE celestia_gl_program_changes gauge\n");
+    fmt::fprintf(out, "celestia_gl_program_changes %llu\n",
+                 (unsigned long long) gl.programChanges);
+    fmt::fprintf(out, "# HELP celestia_gl_upload_bytes Buffer and texture bytes uploaded in the most recent frame.\n");
+    fmt::fprintf(out, "# TYPE celestia_gl_upload_bytes gauge\n");
+    fmt::fprintf(out, "celestia_gl_upload_bytes %llu\n",
+                 (unsigned long long) (gl.bufferUploadBytes + gl.textureUploadBytes));
+
+    // Live heap by allocation tag, present when tagging is enabled
+    if (AllocTracker::enabled())
+    {
+        vector<AllocTracker::TagStats> stats;
+        GetAllocTracker()->snapshot(stats);
+        fmt::fprintf(out, "# HELP celestia_alloc_live_bytes Live heap bytes by allocation tag.\n");
+        fmt::fprintf(out, "# TYPE celestia_alloc_live_bytes gauge\n");
+        for (const auto& tag : stats)
+        {
+            fmt::fprintf(out, "celestia_alloc_live_bytes{tag=\"%s\"} %llu\n",
+                         labelValue(tag.tag),
+                         (unsigned long long) tag.liveBytes);
+        }
+    }
+
+    out.close();
+    if (rename(tempPath.string().c_str(), outputPath.string().c_str()) != 0)
+        DPRINTF(LOG_LEVEL_ERROR, "Cannot rename telemetry file to %s\n",
+                outputPath.string());
+}
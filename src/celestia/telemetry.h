@@ -0,0 +1,61 @@
+// telemetry.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Periodic metrics export for fleet monitoring.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELESTIA_TELEMETRY_H_
+#define _CELESTIA_TELEMETRY_H_
+
+#include <cstdint>
+#include <vector>
+#include <celcompat/filesystem.h>
+
+
+/*! TelemetryExporter periodically writes a snapshot of runtime health
+ *  metrics -- frame-time percentiles, memory by subsystem, resource
+ *  cache hit rates and script slice times -- to a file in the
+ *  Prometheus text exposition format, so unattended installations can
+ *  be scraped by a node exporter textfile collector and alarmed on
+ *  before degradation becomes visible. It is opt-in via the
+ *  TelemetryFile setting in celestia.cfg and costs two vector appends
+ *  per frame between exports; the file is written to a temporary name
+ *  and renamed into place so scrapers never see a partial snapshot.
+ */
+class TelemetryExporter
+{
+ public:
+    TelemetryExporter(const fs::path& _outputPath, double _intervalSeconds);
+
+    //! Record one frame's draw time; called once per rendered frame.
+    void recordFrame(double frameTimeMs);
+
+    //! Record the time spent running script slices this tick.
+    void recordScriptSlice(double sliceMs);
+
+    //! Export a snapshot when the configured interval has elapsed.
+    void update(double wallTime);
+
+    double interval() const
+    {
+        return intervalSeconds;
+    }
+
+ private:
+    void exportReport();
+
+    fs::path outputPath;
+    double intervalSeconds;
+    double lastExportTime{ 0.0 };
+
+    std::uint64_t totalFrames{ 0 };
+    std::vector<float> frameTimes;
+    std::vector<float> scriptSlices;
+};
+
+#endif // _CELESTIA_TELEMETRY_H_
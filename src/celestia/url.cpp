@@ -41,6 +41,68 @@ constexpr const uint64_t NewRenderFlags = Renderer::ShowDwarfPlanets |
 
 const string getEncodedObjectName(const Selection& sel, const CelestiaCore* appCore);
 
+
+// Interned selection paths. Bookmark menus capture and regenerate URLs
+// in bulk, and every URL walks the name databases to resolve its
+// selections, so both directions of the path <-> selection mapping are
+// cached here. The caches are dropped whenever a catalog changes size
+// (e.g. after an incremental catalog load), since paths may then
+// resolve differently.
+static map<pair<int, const void*>, string> encodedNameCache;
+static map<string, Selection> resolvedPathCache;
+static uint32_t cachedStarCount = 0;
+static uint32_t cachedDSOCount = 0;
+static size_t cachedSystemCount = 0;
+
+static const void* selectionPointer(const Selection& sel)
+{
+    switch (sel.getType())
+    {
+    case Selection::Type_Star:
+        return sel.star();
+    case Selection::Type_Body:
+        return sel.body();
+    case Selection::Type_DeepSky:
+        return sel.deepsky();
+    case Selection::Type_Location:
+        return sel.location();
+    default:
+        return nullptr;
+    }
+}
+
+static void validateSelectionPathCaches(const Universe* universe)
+{
+    uint32_t nStars = universe->getStarCatalog() != nullptr ? universe->getStarCatalog()->size() : 0;
+    uint32_t nDSOs = universe->getDSOCatalog() != nullptr ? universe->getDSOCatalog()->size() : 0;
+    size_t nSystems = universe->getSolarSystemCatalog() != nullptr ? universe->getSolarSystemCatalog()->size() : 0;
+
+    if (nStars != cachedStarCount ||
+        nDSOs != cachedDSOCount ||
+        nSystems != cachedSystemCount)
+    {
+        encodedNameCache.clear();
+        resolvedPathCache.clear();
+        cachedStarCount = nStars;
+        cachedDSOCount = nDSOs;
+        cachedSystemCount = nSystems;
+    }
+}
+
+static Selection findObjectFromPathCached(Simulation* sim, const string& path)
+{
+    validateSelectionPathCaches(sim->getUniverse());
+
+    auto iter = resolvedPathCache.find(path);
+    if (iter != resolvedPathCache.end())
+        return iter->second;
+
+    Selection sel = sim->findObjectFromPath(path);
+    if (!sel.empty())
+        resolvedPathCache[path] = sel;
+    return sel;
+}
+
 void
 CelestiaState::captureState(CelestiaCore* appCore)
 {
@@ -238,7 +300,7 @@ Url::Url(std::string  str, CelestiaCore *core):
             if (pos != std::string::npos) bodyName[pos]='/';
         }
 
-        bodies.push_back(sim->findObjectFromPath(bodyName));
+        bodies.push_back(findObjectFromPathCached(sim, bodyName));
 
         nb--;
         i++;
@@ -752,7 +814,7 @@ void Url::goTo()
                 pos = selectedStr.find(":", pos + 1);
                 if (pos != std::string::npos) selectedStr[pos]='/';
             }
-            sel = sim->findObjectFromPath(selectedStr);
+            sel = findObjectFromPathCached(sim, selectedStr);
             sim->setSelection(sel);
         }
         else
@@ -768,7 +830,7 @@ void Url::goTo()
                 pos = trackedStr.find(":", pos + 1);
                 if (pos != std::string::npos) trackedStr[pos]='/';
             }
-            sel = sim->findObjectFromPath(trackedStr);
+            sel = findObjectFromPathCached(sim, trackedStr);
             sim->setTrackedObject(sel);
         }
         else
@@ -907,6 +969,13 @@ getEncodedObjectName(const Selection& selection, const CelestiaCore* appCore)
     Universe *universe = appCore->getSimulation()->getUniverse();
     string name;
 
+    validateSelectionPathCaches(universe);
+
+    pair<int, const void*> key((int) selection.getType(), selectionPointer(selection));
+    auto cached = encodedNameCache.find(key);
+    if (cached != encodedNameCache.end())
+        return cached->second;
+
     switch (selection.getType())
     {
         case Selection::Type_Body:
@@ -934,5 +1003,7 @@ getEncodedObjectName(const Selection& selection, const CelestiaCore* appCore)
             return "";
     }
 
-    return Url::encodeString(name);
+    string encoded = Url::encodeString(name);
+    encodedNameCache[key] = encoded;
+    return encoded;
 }
@@ -11,6 +11,11 @@
 #include <Eigen/LU>
 #include <cmath>
 
+#if defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(_M_X64)
+#define CELMATH_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
 using namespace Eigen;
 
 namespace celmath
@@ -108,6 +113,66 @@ Frustum::testSphere(const Eigen::Vector3d& center, double radius) const
 }
 
 
+unsigned int
+Frustum::testSpheres(const float* x, const float* y, const float* z,
+                     const float* radius, unsigned int count) const
+{
+    return testSpheres(planes, infinite ? 5 : 6, x, y, z, radius, count);
+}
+
+
+unsigned int
+Frustum::testSpheres(const PlaneType* planes,
+                     unsigned int nPlanes,
+                     const float* x, const float* y, const float* z,
+                     const float* radius, unsigned int count)
+{
+    unsigned int visibleMask = 0;
+    unsigned int i = 0;
+
+#ifdef CELMATH_USE_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 cz = _mm_loadu_ps(z + i);
+        __m128 negr = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+        // A sphere is outside the frustum when it lies entirely behind
+        // any single plane; OR the per-plane comparison results together
+        // and keep the lanes that never failed.
+        __m128 outside = _mm_setzero_ps();
+        for (unsigned int p = 0; p < nPlanes; p++)
+        {
+            const Vector3f& n = planes[p].normal();
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(n.x()), cx),
+                                                _mm_mul_ps(_mm_set1_ps(n.y()), cy)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n.z()), cz),
+                                                _mm_set1_ps(planes[p].offset())));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negr));
+        }
+
+        visibleMask |= (~((unsigned int) _mm_movemask_ps(outside)) & 0xfu) << i;
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        Vector3f center(x[i], y[i], z[i]);
+        bool outside = false;
+        for (unsigned int p = 0; p < nPlanes && !outside; p++)
+        {
+            if (planes[p].signedDistance(center) < -radius[i])
+                outside = true;
+        }
+        if (!outside)
+            visibleMask |= 1u << i;
+    }
+
+    return visibleMask;
+}
+
+
 /*
 Frustum::Aspect Frustum::testCapsule(const Capsulef& capsule) const
 {
@@ -56,6 +56,23 @@ class Frustum
     Aspect testSphere(const Eigen::Vector3d& center, double radius) const;
 //    Aspect testCapsule(const Capsulef&) const;
 
+    /*! Test up to 32 spheres, given in structure-of-arrays form, against
+     *  the frustum in a single call. Bit i of the returned mask is set
+     *  when sphere i is at least partially inside the frustum, i.e. when
+     *  testSphere() would not return Outside for it. Processing spheres
+     *  four at a time lets the plane tests vectorize, which matters when
+     *  this is called per octree node or per render list entry.
+     */
+    unsigned int testSpheres(const float* x, const float* y, const float* z,
+                             const float* radius, unsigned int count) const;
+
+    //! Batch sphere test against an explicit plane list; used by octree
+    //! traversal code which receives frustum planes rather than a Frustum.
+    static unsigned int testSpheres(const PlaneType* planes,
+                                    unsigned int nPlanes,
+                                    const float* x, const float* y, const float* z,
+                                    const float* radius, unsigned int count);
+
  private:
     void init(float, float, float, float);
 
@@ -19,4 +19,14 @@ extern float fractalsum(const float v[], float freq);
 extern float fractalsum(const Eigen::Vector2f& p, float freq);
 extern float fractalsum(const Eigen::Vector3f& p, float freq);
 
+// Batched evaluation over structure-of-arrays sample sets. When compiled
+// with AVX2 support these process eight samples per iteration; otherwise
+// they fall back to the scalar kernels above.
+extern void noise3v(const float x[], const float y[], const float z[],
+                    float out[], unsigned int count);
+extern void turbulencev(const float x[], const float y[], const float z[],
+                        float freq, float out[], unsigned int count);
+extern void fractalsumv(const float x[], const float y[], const float z[],
+                        float freq, float out[], unsigned int count);
+
 #endif // _PERLIN_H_
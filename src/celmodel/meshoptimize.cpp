@@ -0,0 +1,280 @@
+// meshoptimize.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Index and vertex reordering for GPU cache efficiency. The index
+// ordering pass is Tom Forsyth's "Linear-Speed Vertex Cache
+// Optimisation" greedy algorithm; the vertex pass rewrites the vertex
+// buffer in first-use order.
+
+#include "meshoptimize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+
+namespace cmod
+{
+
+namespace
+{
+
+// Modelled FIFO cache size and scoring constants from Forsyth's paper;
+// the results are close to optimal for real cache sizes from 12 to 64
+const unsigned int VertexCacheSize = 32;
+const float CacheDecayPower = 1.5f;
+const float LastTriScore = 0.75f;
+const float ValenceBoostScale = 2.0f;
+const float ValenceBoostPower = 0.5f;
+
+
+float
+VertexScore(int cachePosition, unsigned int activeFaces)
+{
+    // Vertices with no remaining faces never need to enter the cache again
+    if (activeFaces == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        if (cachePosition < 3)
+        {
+            // The three vertices of the last emitted triangle share a
+            // fixed score so that ordering within a strip-like run doesn't
+            // matter
+            score = LastTriScore;
+        }
+        else
+        {
+            score = std::pow(1.0f - (float) (cachePosition - 3) / (float) (VertexCacheSize - 3),
+                             CacheDecayPower);
+        }
+    }
+
+    // Boost vertices with few remaining faces so isolated triangles are
+    // emitted early instead of being left to scatter cache misses at the end
+    score += ValenceBoostScale * std::pow((float) activeFaces, -ValenceBoostPower);
+
+    return score;
+}
+
+
+//! Reorder one triangle list in place; returns false if the group is left unchanged
+bool
+OptimizeTriListGroup(Mesh::index32* indices, unsigned int nIndices, unsigned int nVertices)
+{
+    unsigned int nFaces = nIndices / 3;
+    if (nFaces < 2)
+        return false;
+
+    for (unsigned int i = 0; i < nFaces * 3; ++i)
+    {
+        if (indices[i] >= nVertices)
+            return false;
+    }
+
+    // Per-vertex adjacency: the faces using each vertex
+    std::vector<unsigned int> activeFaces(nVertices, 0);
+    for (unsigned int i = 0; i < nFaces * 3; ++i)
+        activeFaces[indices[i]]++;
+
+    std::vector<unsigned int> faceOffsets(nVertices + 1, 0);
+    for (unsigned int v = 0; v < nVertices; ++v)
+        faceOffsets[v + 1] = faceOffsets[v] + activeFaces[v];
+
+    std::vector<unsigned int> vertexFaces(nFaces * 3);
+    {
+        std::vector<unsigned int> fill(faceOffsets.begin(), faceOffsets.end() - 1);
+        for (unsigned int f = 0; f < nFaces; ++f)
+        {
+            for (unsigned int j = 0; j < 3; ++j)
+                vertexFaces[fill[indices[f * 3 + j]]++] = f;
+        }
+    }
+
+    std::vector<float> vertexScores(nVertices);
+    for (unsigned int v = 0; v < nVertices; ++v)
+        vertexScores[v] = VertexScore(-1, activeFaces[v]);
+
+    std::vector<float> faceScores(nFaces);
+    std::vector<bool> emitted(nFaces, false);
+    for (unsigned int f = 0; f < nFaces; ++f)
+    {
+        faceScores[f] = vertexScores[indices[f * 3]] +
+                        vertexScores[indices[f * 3 + 1]] +
+                        vertexScores[indices[f * 3 + 2]];
+    }
+
+    // LRU cache; three extra entries hold the vertices pushed out by the
+    // triangle being emitted while their scores are recomputed
+    std::vector<unsigned int> cache;
+    cache.reserve(VertexCacheSize + 3);
+
+    std::vector<Mesh::index32> newIndices;
+    newIndices.reserve(nFaces * 3);
+
+    int bestFace = -1;
+    for (unsigned int emittedCount = 0; emittedCount < nFaces; ++emittedCount)
+    {
+        if (bestFace < 0)
+        {
+            // No candidate adjacent to the cache contents; fall back to a
+            // scan for the best remaining face
+            float bestScore = -1.0e30f;
+            for (unsigned int f = 0; f < nFaces; ++f)
+            {
+                if (!emitted[f] && faceScores[f] > bestScore)
+                {
+                    bestScore = faceScores[f];
+                    bestFace = f;
+                }
+            }
+        }
+
+        unsigned int face = (unsigned int) bestFace;
+        emitted[face] = true;
+
+        for (unsigned int j = 0; j < 3; ++j)
+        {
+            Mesh::index32 v = indices[face * 3 + j];
+            newIndices.push_back(v);
+            activeFaces[v]--;
+
+            // Move the vertex to the front of the LRU cache
+            auto iter = std::find(cache.begin(), cache.end(), (unsigned int) v);
+            if (iter != cache.end())
+                cache.erase(iter);
+            cache.insert(cache.begin(), v);
+        }
+
+        // Rescore every cached vertex and find the next best face among
+        // their unemitted neighbors
+        bestFace = -1;
+        float bestScore = -1.0e30f;
+        for (std::size_t c = 0; c < cache.size(); ++c)
+        {
+            unsigned int v = cache[c];
+            int position = c < VertexCacheSize ? (int) c : -1;
+
+            float score = VertexScore(position, activeFaces[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+
+            for (unsigned int k = faceOffsets[v]; k < faceOffsets[v + 1]; ++k)
+            {
+                unsigned int f = vertexFaces[k];
+                if (emitted[f])
+                    continue;
+
+                faceScores[f] += delta;
+                if (faceScores[f] > bestScore)
+                {
+                    bestScore = faceScores[f];
+                    bestFace = f;
+                }
+            }
+        }
+
+        // Evict vertices that fell off the end of the modelled cache
+        while (cache.size() > VertexCacheSize)
+            cache.pop_back();
+    }
+
+    std::copy(newIndices.begin(), newIndices.end(), indices);
+    return true;
+}
+
+
+//! Rewrite the vertex buffer in first-use order and remap all indices
+bool
+ReorderVerticesByFirstUse(Mesh& mesh)
+{
+    unsigned int nVertices = mesh.getVertexCount();
+    const char* vertexData = reinterpret_cast<const char*>(mesh.getVertexData());
+    if (nVertices == 0 || vertexData == nullptr)
+        return false;
+
+    const Mesh::index32 Unmapped = ~(Mesh::index32) 0;
+    std::vector<Mesh::index32> remap(nVertices, Unmapped);
+    Mesh::index32 nextIndex = 0;
+
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        const Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        for (unsigned int j = 0; j < group->nIndices; ++j)
+        {
+            Mesh::index32 v = group->indices[j];
+            if (v < nVertices && remap[v] == Unmapped)
+                remap[v] = nextIndex++;
+        }
+    }
+
+    if (nextIndex == 0)
+        return false;
+
+    // Unreferenced vertices keep their data, packed at the end
+    bool identity = true;
+    for (unsigned int v = 0; v < nVertices; ++v)
+    {
+        if (remap[v] == Unmapped)
+            remap[v] = nextIndex++;
+        if (remap[v] != v)
+            identity = false;
+    }
+
+    if (identity)
+        return false;
+
+    unsigned int stride = mesh.getVertexDescription().stride;
+    auto* newVertexData = new char[(std::size_t) nVertices * stride];
+    for (unsigned int v = 0; v < nVertices; ++v)
+    {
+        std::memcpy(newVertexData + (std::size_t) remap[v] * stride,
+                    vertexData + (std::size_t) v * stride,
+                    stride);
+    }
+
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        for (unsigned int j = 0; j < group->nIndices; ++j)
+        {
+            if (group->indices[j] < nVertices)
+                group->indices[j] = remap[group->indices[j]];
+        }
+    }
+
+    mesh.setVertices(nVertices, newVertexData);
+    return true;
+}
+
+} // anonymous namespace
+
+
+bool
+OptimizeMeshForVertexCache(Mesh& mesh)
+{
+    bool changed = false;
+
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        if (group->prim == Mesh::TriList)
+            changed |= OptimizeTriListGroup(group->indices, group->nIndices, mesh.getVertexCount());
+    }
+
+    if (changed)
+        changed |= ReorderVerticesByFirstUse(mesh);
+
+    return changed;
+}
+
+} // namespace cmod
@@ -0,0 +1,34 @@
+// meshoptimize.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Index and vertex reordering for GPU cache efficiency.
+
+#ifndef _CELMODEL_MESHOPTIMIZE_H_
+#define _CELMODEL_MESHOPTIMIZE_H_
+
+#include "mesh.h"
+
+
+namespace cmod
+{
+
+/*! Reorder the mesh for efficient GPU consumption. Triangle list
+ *  groups are reordered with Forsyth's linear-speed vertex cache
+ *  optimization to reduce the average cache miss ratio, then the
+ *  vertex data is rewritten in first-use order so vertex fetches walk
+ *  the buffer roughly sequentially. Materials, primitive group
+ *  structure and vertex count are unchanged; only the ordering of
+ *  indices and vertices differs. Returns true if the mesh was
+ *  modified.
+ */
+bool OptimizeMeshForVertexCache(Mesh& mesh);
+
+} // namespace cmod
+
+#endif // !_CELMODEL_MESHOPTIMIZE_H_
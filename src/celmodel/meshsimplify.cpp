@@ -0,0 +1,277 @@
+// meshsimplify.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Triangle mesh decimation for level of detail rendering. Uses
+// vertex clustering on a uniform grid with quadric-optimized
+// placement of the cluster representatives.
+
+#include "meshsimplify.h"
+
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+using namespace Eigen;
+
+
+namespace cmod
+{
+
+namespace
+{
+
+// Error quadric for a vertex cluster: the sum of squared distances to
+// the planes of the faces incident on the cluster's source vertices.
+struct ClusterQuadric
+{
+    Matrix3f A{ Matrix3f::Zero() };
+    Vector3f b{ Vector3f::Zero() };
+    Vector3f positionSum{ Vector3f::Zero() };
+    unsigned int vertexCount{ 0 };
+
+    // Source vertex whose attributes the representative inherits
+    unsigned int representative{ 0 };
+    float representativeDistance{ 0.0f };
+};
+
+
+Vector3f
+VertexPosition(const char* vertexData, unsigned int stride, unsigned int posOffset, unsigned int index)
+{
+    float p[3];
+    std::memcpy(p, vertexData + (std::size_t) stride * index + posOffset, sizeof(p));
+    return Vector3f(p[0], p[1], p[2]);
+}
+
+} // anonymous namespace
+
+
+Mesh*
+SimplifyMesh(const Mesh& mesh, unsigned int targetFaceCount)
+{
+    const Mesh::VertexDescription& desc = mesh.getVertexDescription();
+    if (desc.getAttribute(Mesh::Position).format != Mesh::Float3)
+        return nullptr;
+
+    // Only triangle lists are supported; strips and fans are rare enough
+    // in practice that converting them isn't worth the trouble.
+    unsigned int faceCount = 0;
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        const Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        if (group->prim != Mesh::TriList)
+            return nullptr;
+        faceCount += group->nIndices / 3;
+    }
+
+    if (targetFaceCount == 0 || faceCount <= targetFaceCount)
+        return nullptr;
+
+    unsigned int stride = desc.stride;
+    unsigned int posOffset = desc.getAttribute(Mesh::Position).offset;
+    unsigned int nVertices = mesh.getVertexCount();
+    const char* vertexData = reinterpret_cast<const char*>(mesh.getVertexData());
+    if (vertexData == nullptr || nVertices == 0)
+        return nullptr;
+
+    AlignedBox<float, 3> bounds;
+    for (unsigned int i = 0; i < nVertices; ++i)
+        bounds.extend(VertexPosition(vertexData, stride, posOffset, i));
+
+    Vector3f extent = bounds.max() - bounds.min();
+    float maxExtent = extent.maxCoeff();
+    if (maxExtent <= 0.0f)
+        return nullptr;
+
+    // Mesh surfaces occupy on the order of gridSize^2 cells of a
+    // gridSize^3 grid, and each occupied cell yields roughly two faces.
+    auto gridSize = (unsigned int) std::ceil(std::sqrt((float) targetFaceCount * 0.5f));
+    gridSize = std::max(2u, std::min(gridSize, 512u));
+    Vector3f cellScale = Vector3f((float) gridSize, (float) gridSize, (float) gridSize).cwiseQuotient(
+        extent.cwiseMax(Vector3f::Constant(maxExtent * 1.0e-6f)));
+
+    // Map each source vertex to a cluster
+    std::map<std::uint64_t, unsigned int> cellClusters;
+    std::vector<unsigned int> vertexClusters(nVertices);
+    std::vector<ClusterQuadric> clusters;
+
+    for (unsigned int i = 0; i < nVertices; ++i)
+    {
+        Vector3f p = VertexPosition(vertexData, stride, posOffset, i);
+        Vector3f cell = (p - bounds.min()).cwiseProduct(cellScale);
+        auto cx = std::min((std::uint64_t) std::max(cell.x(), 0.0f), (std::uint64_t) gridSize - 1);
+        auto cy = std::min((std::uint64_t) std::max(cell.y(), 0.0f), (std::uint64_t) gridSize - 1);
+        auto cz = std::min((std::uint64_t) std::max(cell.z(), 0.0f), (std::uint64_t) gridSize - 1);
+        std::uint64_t cellId = (cz * gridSize + cy) * gridSize + cx;
+
+        auto iter = cellClusters.find(cellId);
+        unsigned int cluster;
+        if (iter == cellClusters.end())
+        {
+            cluster = clusters.size();
+            cellClusters.insert(std::make_pair(cellId, cluster));
+            clusters.push_back(ClusterQuadric());
+        }
+        else
+        {
+            cluster = iter->second;
+        }
+
+        vertexClusters[i] = cluster;
+        clusters[cluster].positionSum += p;
+        clusters[cluster].vertexCount++;
+    }
+
+    // No point building a level that barely reduces the face count
+    if (clusters.size() * 2 > (std::size_t) faceCount)
+        return nullptr;
+
+    // Accumulate area-weighted plane quadrics into the clusters of each
+    // face's corners
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        const Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        for (unsigned int j = 0; j + 2 < group->nIndices; j += 3)
+        {
+            Mesh::index32 i0 = group->indices[j];
+            Mesh::index32 i1 = group->indices[j + 1];
+            Mesh::index32 i2 = group->indices[j + 2];
+            if (i0 >= nVertices || i1 >= nVertices || i2 >= nVertices)
+                continue;
+
+            Vector3f p0 = VertexPosition(vertexData, stride, posOffset, i0);
+            Vector3f p1 = VertexPosition(vertexData, stride, posOffset, i1);
+            Vector3f p2 = VertexPosition(vertexData, stride, posOffset, i2);
+
+            Vector3f cross = (p1 - p0).cross(p2 - p0);
+            float doubleArea = cross.norm();
+            if (doubleArea <= 0.0f)
+                continue;
+
+            Vector3f normal = cross / doubleArea;
+            float d = -normal.dot(p0);
+
+            Matrix3f A = (doubleArea * normal) * normal.transpose();
+            Vector3f b = (doubleArea * d) * normal;
+
+            clusters[vertexClusters[i0]].A += A;
+            clusters[vertexClusters[i0]].b += b;
+            clusters[vertexClusters[i1]].A += A;
+            clusters[vertexClusters[i1]].b += b;
+            clusters[vertexClusters[i2]].A += A;
+            clusters[vertexClusters[i2]].b += b;
+        }
+    }
+
+    // Place each cluster's representative at the quadric minimum when the
+    // system is well conditioned, otherwise at the cluster centroid
+    float cellDiagonal = maxExtent / (float) gridSize * 1.7320508f;
+    std::vector<Vector3f> clusterPositions(clusters.size());
+    for (std::size_t i = 0; i < clusters.size(); ++i)
+    {
+        Vector3f centroid = clusters[i].positionSum / (float) std::max(1u, clusters[i].vertexCount);
+        Vector3f optimal = centroid;
+
+        float scale = clusters[i].A.trace();
+        if (scale > 0.0f &&
+            std::fabs(clusters[i].A.determinant()) > 1.0e-9f * scale * scale * scale)
+        {
+            Vector3f solution = clusters[i].A.inverse() * -clusters[i].b;
+
+            // Reject solutions that escape the cluster's neighborhood; they
+            // indicate a nearly singular system despite the determinant test
+            if ((solution - centroid).norm() <= cellDiagonal)
+                optimal = solution;
+        }
+
+        clusterPositions[i] = optimal;
+        clusters[i].representativeDistance = 1.0e30f;
+    }
+
+    // Pick the source vertex nearest the optimized position to donate the
+    // non-position attributes (normal, texture coordinates, ...)
+    for (unsigned int i = 0; i < nVertices; ++i)
+    {
+        ClusterQuadric& cluster = clusters[vertexClusters[i]];
+        Vector3f p = VertexPosition(vertexData, stride, posOffset, i);
+        float distance = (p - clusterPositions[vertexClusters[i]]).squaredNorm();
+        if (distance < cluster.representativeDistance)
+        {
+            cluster.representativeDistance = distance;
+            cluster.representative = i;
+        }
+    }
+
+    // Build the decimated vertex data
+    auto* newVertexData = new char[(std::size_t) clusters.size() * stride];
+    for (std::size_t i = 0; i < clusters.size(); ++i)
+    {
+        char* vertex = newVertexData + i * stride;
+        std::memcpy(vertex, vertexData + (std::size_t) stride * clusters[i].representative, stride);
+
+        float p[3] = { clusterPositions[i].x(), clusterPositions[i].y(), clusterPositions[i].z() };
+        std::memcpy(vertex + posOffset, p, sizeof(p));
+    }
+
+    auto* newMesh = new Mesh();
+    newMesh->setVertexDescription(desc);
+    newMesh->setVertices(clusters.size(), newVertexData);
+    newMesh->setName(mesh.getName());
+
+    // Remap the faces, dropping those that collapse within a single cluster
+    unsigned int newFaceCount = 0;
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        const Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        std::vector<Mesh::index32> newIndices;
+        newIndices.reserve(group->nIndices);
+
+        for (unsigned int j = 0; j + 2 < group->nIndices; j += 3)
+        {
+            Mesh::index32 i0 = group->indices[j];
+            Mesh::index32 i1 = group->indices[j + 1];
+            Mesh::index32 i2 = group->indices[j + 2];
+            if (i0 >= nVertices || i1 >= nVertices || i2 >= nVertices)
+                continue;
+
+            unsigned int c0 = vertexClusters[i0];
+            unsigned int c1 = vertexClusters[i1];
+            unsigned int c2 = vertexClusters[i2];
+            if (c0 == c1 || c1 == c2 || c2 == c0)
+                continue;
+
+            newIndices.push_back(c0);
+            newIndices.push_back(c1);
+            newIndices.push_back(c2);
+        }
+
+        if (newIndices.empty())
+            continue;
+
+        auto* indices = new Mesh::index32[newIndices.size()];
+        std::copy(newIndices.begin(), newIndices.end(), indices);
+        newMesh->addGroup(Mesh::TriList, group->materialIndex, newIndices.size(), indices);
+        newFaceCount += newIndices.size() / 3;
+    }
+
+    if (newFaceCount == 0)
+    {
+        delete newMesh;
+        return nullptr;
+    }
+
+    return newMesh;
+}
+
+} // namespace cmod
@@ -0,0 +1,40 @@
+// meshsimplify.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Triangle mesh decimation for level of detail rendering.
+
+#ifndef _CELMODEL_MESHSIMPLIFY_H_
+#define _CELMODEL_MESHSIMPLIFY_H_
+
+#include "mesh.h"
+
+
+namespace cmod
+{
+
+/*! Build a decimated copy of a triangle mesh with approximately
+ *  targetFaceCount triangles. Vertices are clustered on a uniform
+ *  grid and each cluster is replaced by a single vertex positioned
+ *  to minimize the quadric error of the faces incident on the
+ *  cluster, so flat areas collapse aggressively while silhouettes
+ *  and sharp features are preserved. The remaining vertex
+ *  attributes are copied from the source vertex nearest the
+ *  optimized position, and primitive groups keep their material
+ *  indices.
+ *
+ *  Returns nullptr if the mesh cannot be simplified: when it
+ *  contains primitive groups other than triangle lists, when it is
+ *  already below the target size, or when clustering fails to
+ *  remove a useful number of faces.
+ */
+Mesh* SimplifyMesh(const Mesh& mesh, unsigned int targetFaceCount);
+
+} // namespace cmod
+
+#endif // !_CELMODEL_MESHSIMPLIFY_H_
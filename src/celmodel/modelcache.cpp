@@ -0,0 +1,684 @@
+// modelcache.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Compact serialization of models for on-disk cache artifacts.
+// Vertex attributes are stored one stream per attribute: positions
+// quantized to 16 bits against the mesh bounding box, normals and
+// tangents as 16-bit octahedral pairs, texture coordinates as half
+// floats, everything else raw. Indices are zigzag-delta varints.
+
+#include "modelcache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+namespace cmod
+{
+
+namespace
+{
+
+const char CacheMagic[8] = { '#', 'q', 'c', 'm', 'd', 'l', '0', '1' };
+
+// Written in native order; a cache file from a machine with different
+// endianness fails this check and is regenerated
+const std::uint32_t ByteOrderSentinel = 0x01020304;
+
+// Upper bounds used to reject corrupt files before allocating
+const std::uint32_t MaxCount = 0x10000000;
+const std::uint32_t MaxStringLength = 1024;
+const std::uint32_t MaxVertexStride = 1024;
+const std::uint32_t MaxAttributes = 16;
+
+enum AttributeEncoding
+{
+    EncodingRaw        = 0,
+    EncodingPosition16 = 1,
+    EncodingOct16      = 2,
+    EncodingHalf       = 3,
+};
+
+
+template<typename T> void
+WriteRaw(std::ostream& out, T value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T> bool
+ReadRaw(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return in.good();
+}
+
+void
+WriteString(std::ostream& out, const std::string& s)
+{
+    WriteRaw(out, (std::uint16_t) std::min((std::size_t) MaxStringLength, s.length()));
+    out.write(s.c_str(), std::min((std::size_t) MaxStringLength, s.length()));
+}
+
+bool
+ReadString(std::istream& in, std::string& s)
+{
+    std::uint16_t length;
+    if (!ReadRaw(in, length) || length > MaxStringLength)
+        return false;
+
+    std::vector<char> buffer(length);
+    in.read(buffer.data(), length);
+    s.assign(buffer.data(), length);
+    return in.good();
+}
+
+
+std::uint16_t
+FloatToHalf(float f)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+
+    std::uint32_t sign = (bits >> 16) & 0x8000;
+    std::int32_t exponent = (std::int32_t) ((bits >> 23) & 0xff) - 127 + 15;
+    std::uint32_t mantissa = bits & 0x7fffff;
+
+    if (exponent <= 0)
+        return (std::uint16_t) sign;                     // flush underflow to zero
+    if (exponent >= 31)
+        return (std::uint16_t) (sign | 0x7c00);          // overflow to infinity
+
+    return (std::uint16_t) (sign | (exponent << 10) | (mantissa >> 13));
+}
+
+float
+HalfToFloat(std::uint16_t h)
+{
+    std::uint32_t sign = (std::uint32_t) (h & 0x8000) << 16;
+    std::uint32_t exponent = (h >> 10) & 0x1f;
+    std::uint32_t mantissa = h & 0x3ff;
+
+    std::uint32_t bits;
+    if (exponent == 0)
+        bits = sign;                                     // denormals were flushed on encode
+    else if (exponent == 31)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+
+void
+EncodeOct(const float n[3], std::uint16_t out[2])
+{
+    float l = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+    float ox = 0.0f;
+    float oy = 0.0f;
+    if (l > 0.0f)
+    {
+        ox = n[0] / l;
+        oy = n[1] / l;
+        if (n[2] < 0.0f)
+        {
+            float px = (1.0f - std::fabs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+            float py = (1.0f - std::fabs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+            ox = px;
+            oy = py;
+        }
+    }
+
+    out[0] = (std::uint16_t) (std::max(0.0f, std::min(1.0f, ox * 0.5f + 0.5f)) * 65535.0f + 0.5f);
+    out[1] = (std::uint16_t) (std::max(0.0f, std::min(1.0f, oy * 0.5f + 0.5f)) * 65535.0f + 0.5f);
+}
+
+void
+DecodeOct(const std::uint16_t in[2], float n[3])
+{
+    float ox = (float) in[0] / 65535.0f * 2.0f - 1.0f;
+    float oy = (float) in[1] / 65535.0f * 2.0f - 1.0f;
+    float oz = 1.0f - std::fabs(ox) - std::fabs(oy);
+    if (oz < 0.0f)
+    {
+        float px = (1.0f - std::fabs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+        float py = (1.0f - std::fabs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+        ox = px;
+        oy = py;
+    }
+
+    float l = std::sqrt(ox * ox + oy * oy + oz * oz);
+    if (l > 0.0f)
+    {
+        n[0] = ox / l;
+        n[1] = oy / l;
+        n[2] = oz / l;
+    }
+    else
+    {
+        n[0] = 0.0f;
+        n[1] = 0.0f;
+        n[2] = 1.0f;
+    }
+}
+
+
+void
+WriteVarint(std::ostream& out, std::uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.put((char) ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.put((char) value);
+}
+
+bool
+ReadVarint(std::istream& in, std::uint32_t& value)
+{
+    value = 0;
+    for (unsigned int shift = 0; shift < 35; shift += 7)
+    {
+        int c = in.get();
+        if (c == EOF)
+            return false;
+        value |= (std::uint32_t) (c & 0x7f) << shift;
+        if ((c & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+std::uint32_t
+ZigzagEncode(std::int32_t value)
+{
+    return ((std::uint32_t) value << 1) ^ (std::uint32_t) (value >> 31);
+}
+
+std::int32_t
+ZigzagDecode(std::uint32_t value)
+{
+    return (std::int32_t) (value >> 1) ^ -(std::int32_t) (value & 1);
+}
+
+
+AttributeEncoding
+ChooseEncoding(const Mesh::VertexAttribute& attr)
+{
+    if (attr.semantic == Mesh::Position && attr.format == Mesh::Float3)
+        return EncodingPosition16;
+
+    if ((attr.semantic == Mesh::Normal || attr.semantic == Mesh::Tangent) &&
+        attr.format == Mesh::Float3)
+        return EncodingOct16;
+
+    if (attr.semantic >= Mesh::Texture0 && attr.semantic <= Mesh::Texture3 &&
+        attr.format >= Mesh::Float1 && attr.format <= Mesh::Float4)
+        return EncodingHalf;
+
+    return EncodingRaw;
+}
+
+unsigned int
+FloatComponentCount(Mesh::VertexAttributeFormat format)
+{
+    switch (format)
+    {
+    case Mesh::Float1: return 1;
+    case Mesh::Float2: return 2;
+    case Mesh::Float3: return 3;
+    case Mesh::Float4: return 4;
+    default: return 0;
+    }
+}
+
+
+bool
+SaveMesh(const Mesh& mesh, std::ostream& out)
+{
+    const Mesh::VertexDescription& desc = mesh.getVertexDescription();
+    unsigned int nVertices = mesh.getVertexCount();
+    const char* vertexData = reinterpret_cast<const char*>(mesh.getVertexData());
+
+    WriteString(out, mesh.getName());
+    WriteRaw(out, (std::uint32_t) desc.stride);
+    WriteRaw(out, (std::uint32_t) desc.nAttributes);
+    for (unsigned int i = 0; i < desc.nAttributes; ++i)
+    {
+        WriteRaw(out, (std::int32_t) desc.attributes[i].semantic);
+        WriteRaw(out, (std::int32_t) desc.attributes[i].format);
+        WriteRaw(out, (std::uint32_t) desc.attributes[i].offset);
+    }
+
+    WriteRaw(out, (std::uint32_t) nVertices);
+
+    for (unsigned int i = 0; i < desc.nAttributes; ++i)
+    {
+        const Mesh::VertexAttribute& attr = desc.attributes[i];
+        auto encoding = ChooseEncoding(attr);
+        unsigned int attrSize = Mesh::getVertexAttributeSize(attr.format);
+        WriteRaw(out, (std::uint8_t) encoding);
+
+        switch (encoding)
+        {
+        case EncodingPosition16:
+        {
+            float lower[3] = { 0.0f, 0.0f, 0.0f };
+            float upper[3] = { 0.0f, 0.0f, 0.0f };
+            for (unsigned int v = 0; v < nVertices; ++v)
+            {
+                float p[3];
+                std::memcpy(p, vertexData + (std::size_t) v * desc.stride + attr.offset, sizeof(p));
+                for (unsigned int c = 0; c < 3; ++c)
+                {
+                    if (v == 0 || p[c] < lower[c]) lower[c] = p[c];
+                    if (v == 0 || p[c] > upper[c]) upper[c] = p[c];
+                }
+            }
+
+            out.write(reinterpret_cast<const char*>(lower), sizeof(lower));
+            out.write(reinterpret_cast<const char*>(upper), sizeof(upper));
+
+            for (unsigned int v = 0; v < nVertices; ++v)
+            {
+                float p[3];
+                std::memcpy(p, vertexData + (std::size_t) v * desc.stride + attr.offset, sizeof(p));
+                std::uint16_t q[3];
+                for (unsigned int c = 0; c < 3; ++c)
+                {
+                    float extent = upper[c] - lower[c];
+                    float t = extent > 0.0f ? (p[c] - lower[c]) / extent : 0.0f;
+                    q[c] = (std::uint16_t) (std::max(0.0f, std::min(1.0f, t)) * 65535.0f + 0.5f);
+                }
+                out.write(reinterpret_cast<const char*>(q), sizeof(q));
+            }
+            break;
+        }
+
+        case EncodingOct16:
+            for (unsigned int v = 0; v < nVertices; ++v)
+            {
+                float n[3];
+                std::memcpy(n, vertexData + (std::size_t) v * desc.stride + attr.offset, sizeof(n));
+                std::uint16_t q[2];
+                EncodeOct(n, q);
+                out.write(reinterpret_cast<const char*>(q), sizeof(q));
+            }
+            break;
+
+        case EncodingHalf:
+        {
+            unsigned int components = FloatComponentCount(attr.format);
+            for (unsigned int v = 0; v < nVertices; ++v)
+            {
+                for (unsigned int c = 0; c < components; ++c)
+                {
+                    float value;
+                    std::memcpy(&value,
+                                vertexData + (std::size_t) v * desc.stride + attr.offset + c * sizeof(float),
+                                sizeof(value));
+                    WriteRaw(out, FloatToHalf(value));
+                }
+            }
+            break;
+        }
+
+        case EncodingRaw:
+        default:
+            for (unsigned int v = 0; v < nVertices; ++v)
+                out.write(vertexData + (std::size_t) v * desc.stride + attr.offset, attrSize);
+            break;
+        }
+    }
+
+    WriteRaw(out, (std::uint32_t) mesh.getGroupCount());
+    for (unsigned int i = 0; i < mesh.getGroupCount(); ++i)
+    {
+        const Mesh::PrimitiveGroup* group = mesh.getGroup(i);
+        WriteRaw(out, (std::int32_t) group->prim);
+        WriteRaw(out, (std::uint32_t) group->materialIndex);
+        WriteRaw(out, (std::uint32_t) group->nIndices);
+
+        std::int32_t previous = 0;
+        for (unsigned int j = 0; j < group->nIndices; ++j)
+        {
+            auto index = (std::int32_t) group->indices[j];
+            WriteVarint(out, ZigzagEncode(index - previous));
+            previous = index;
+        }
+    }
+
+    return out.good();
+}
+
+
+Mesh*
+LoadMesh(std::istream& in)
+{
+    std::string name;
+    std::uint32_t stride;
+    std::uint32_t nAttributes;
+    if (!ReadString(in, name) ||
+        !ReadRaw(in, stride) || stride == 0 || stride > MaxVertexStride ||
+        !ReadRaw(in, nAttributes) || nAttributes == 0 || nAttributes > MaxAttributes)
+        return nullptr;
+
+    std::vector<Mesh::VertexAttribute> attributes(nAttributes);
+    for (std::uint32_t i = 0; i < nAttributes; ++i)
+    {
+        std::int32_t semantic;
+        std::int32_t format;
+        std::uint32_t offset;
+        if (!ReadRaw(in, semantic) || !ReadRaw(in, format) || !ReadRaw(in, offset))
+            return nullptr;
+        if (semantic < 0 || semantic >= Mesh::SemanticMax ||
+            format < 0 || format >= Mesh::FormatMax)
+            return nullptr;
+
+        attributes[i] = Mesh::VertexAttribute((Mesh::VertexAttributeSemantic) semantic,
+                                              (Mesh::VertexAttributeFormat) format,
+                                              offset);
+        if (offset + Mesh::getVertexAttributeSize(attributes[i].format) > stride)
+            return nullptr;
+    }
+
+    std::uint32_t nVertices;
+    if (!ReadRaw(in, nVertices) || nVertices > MaxCount)
+        return nullptr;
+
+    std::vector<char> vertexData((std::size_t) nVertices * stride);
+
+    for (std::uint32_t i = 0; i < nAttributes; ++i)
+    {
+        const Mesh::VertexAttribute& attr = attributes[i];
+        unsigned int attrSize = Mesh::getVertexAttributeSize(attr.format);
+
+        std::uint8_t encoding;
+        if (!ReadRaw(in, encoding))
+            return nullptr;
+
+        switch (encoding)
+        {
+        case EncodingPosition16:
+        {
+            if (attr.format != Mesh::Float3)
+                return nullptr;
+
+            float lower[3];
+            float upper[3];
+            in.read(reinterpret_cast<char*>(lower), sizeof(lower));
+            in.read(reinterpret_cast<char*>(upper), sizeof(upper));
+            if (!in.good())
+                return nullptr;
+
+            for (std::uint32_t v = 0; v < nVertices; ++v)
+            {
+                std::uint16_t q[3];
+                in.read(reinterpret_cast<char*>(q), sizeof(q));
+                float p[3];
+                for (unsigned int c = 0; c < 3; ++c)
+                    p[c] = lower[c] + (upper[c] - lower[c]) * ((float) q[c] / 65535.0f);
+                std::memcpy(vertexData.data() + (std::size_t) v * stride + attr.offset, p, sizeof(p));
+            }
+            break;
+        }
+
+        case EncodingOct16:
+        {
+            if (attr.format != Mesh::Float3)
+                return nullptr;
+
+            for (std::uint32_t v = 0; v < nVertices; ++v)
+            {
+                std::uint16_t q[2];
+                in.read(reinterpret_cast<char*>(q), sizeof(q));
+                float n[3];
+                DecodeOct(q, n);
+                std::memcpy(vertexData.data() + (std::size_t) v * stride + attr.offset, n, sizeof(n));
+            }
+            break;
+        }
+
+        case EncodingHalf:
+        {
+            unsigned int components = FloatComponentCount(attr.format);
+            if (components == 0)
+                return nullptr;
+
+            for (std::uint32_t v = 0; v < nVertices; ++v)
+            {
+                for (unsigned int c = 0; c < components; ++c)
+                {
+                    std::uint16_t h;
+                    if (!ReadRaw(in, h))
+                        return nullptr;
+                    float value = HalfToFloat(h);
+                    std::memcpy(vertexData.data() + (std::size_t) v * stride + attr.offset + c * sizeof(float),
+                                &value, sizeof(value));
+                }
+            }
+            break;
+        }
+
+        case EncodingRaw:
+            for (std::uint32_t v = 0; v < nVertices; ++v)
+                in.read(vertexData.data() + (std::size_t) v * stride + attr.offset, attrSize);
+            break;
+
+        default:
+            return nullptr;
+        }
+
+        if (!in.good())
+            return nullptr;
+    }
+
+    auto* mesh = new Mesh();
+    mesh->setName(name);
+    mesh->setVertexDescription(Mesh::VertexDescription(stride, nAttributes, attributes.data()));
+
+    auto* vertices = new char[(std::size_t) nVertices * stride];
+    std::memcpy(vertices, vertexData.data(), vertexData.size());
+    mesh->setVertices(nVertices, vertices);
+
+    std::uint32_t nGroups;
+    if (!ReadRaw(in, nGroups) || nGroups > MaxCount)
+    {
+        delete mesh;
+        return nullptr;
+    }
+
+    for (std::uint32_t i = 0; i < nGroups; ++i)
+    {
+        std::int32_t prim;
+        std::uint32_t materialIndex;
+        std::uint32_t nIndices;
+        if (!ReadRaw(in, prim) || prim < 0 || prim >= Mesh::PrimitiveTypeMax ||
+            !ReadRaw(in, materialIndex) ||
+            !ReadRaw(in, nIndices) || nIndices > MaxCount)
+        {
+            delete mesh;
+            return nullptr;
+        }
+
+        auto* indices = new Mesh::index32[nIndices];
+        std::int32_t previous = 0;
+        for (std::uint32_t j = 0; j < nIndices; ++j)
+        {
+            std::uint32_t delta;
+            if (!ReadVarint(in, delta))
+            {
+                delete[] indices;
+                delete mesh;
+                return nullptr;
+            }
+
+            previous += ZigzagDecode(delta);
+            if (previous < 0 || (std::uint32_t) previous >= nVertices)
+            {
+                delete[] indices;
+                delete mesh;
+                return nullptr;
+            }
+            indices[j] = (Mesh::index32) previous;
+        }
+
+        mesh->addGroup((Mesh::PrimitiveGroupType) prim, materialIndex, nIndices, indices);
+    }
+
+    return mesh;
+}
+
+} // anonymous namespace
+
+
+bool
+SaveCachedModel(const Model* model, std::ostream& out)
+{
+    out.write(CacheMagic, sizeof(CacheMagic));
+    WriteRaw(out, ByteOrderSentinel);
+
+    WriteRaw(out, (std::uint32_t) model->getMaterialCount());
+    for (std::uint32_t i = 0; i < model->getMaterialCount(); ++i)
+    {
+        const Material* material = model->getMaterial(i);
+        WriteRaw(out, material->diffuse.red());
+        WriteRaw(out, material->diffuse.green());
+        WriteRaw(out, material->diffuse.blue());
+        WriteRaw(out, material->emissive.red());
+        WriteRaw(out, material->emissive.green());
+        WriteRaw(out, material->emissive.blue());
+        WriteRaw(out, material->specular.red());
+        WriteRaw(out, material->specular.green());
+        WriteRaw(out, material->specular.blue());
+        WriteRaw(out, material->specularPower);
+        WriteRaw(out, material->opacity);
+        WriteRaw(out, (std::int32_t) material->blend);
+
+        for (int j = 0; j < Material::TextureSemanticMax; ++j)
+        {
+            std::string source;
+            if (material->maps[j] != nullptr)
+                source = material->maps[j]->source();
+            WriteString(out, source);
+        }
+    }
+
+    WriteRaw(out, (std::uint32_t) model->getMeshCount());
+    for (std::uint32_t i = 0; i < model->getMeshCount(); ++i)
+    {
+        if (!SaveMesh(*model->getMesh(i), out))
+            return false;
+    }
+
+    return out.good();
+}
+
+
+Model*
+LoadCachedModel(std::istream& in, TextureLoader* textureLoader)
+{
+    char magic[sizeof(CacheMagic)];
+    in.read(magic, sizeof(magic));
+    if (!in.good() || std::memcmp(magic, CacheMagic, sizeof(magic)) != 0)
+        return nullptr;
+
+    std::uint32_t sentinel;
+    if (!ReadRaw(in, sentinel) || sentinel != ByteOrderSentinel)
+        return nullptr;
+
+    auto* model = new Model();
+
+    std::uint32_t nMaterials;
+    if (!ReadRaw(in, nMaterials) || nMaterials > MaxCount)
+    {
+        delete model;
+        return nullptr;
+    }
+
+    for (std::uint32_t i = 0; i < nMaterials; ++i)
+    {
+        float diffuse[3];
+        float emissive[3];
+        float specular[3];
+        float specularPower;
+        float opacity;
+        std::int32_t blend;
+
+        bool ok = ReadRaw(in, diffuse[0]) && ReadRaw(in, diffuse[1]) && ReadRaw(in, diffuse[2]) &&
+                  ReadRaw(in, emissive[0]) && ReadRaw(in, emissive[1]) && ReadRaw(in, emissive[2]) &&
+                  ReadRaw(in, specular[0]) && ReadRaw(in, specular[1]) && ReadRaw(in, specular[2]) &&
+                  ReadRaw(in, specularPower) && ReadRaw(in, opacity) && ReadRaw(in, blend);
+        if (!ok || blend < 0 || blend >= Material::BlendMax)
+        {
+            delete model;
+            return nullptr;
+        }
+
+        auto* material = new Material();
+        material->diffuse = Material::Color(diffuse[0], diffuse[1], diffuse[2]);
+        material->emissive = Material::Color(emissive[0], emissive[1], emissive[2]);
+        material->specular = Material::Color(specular[0], specular[1], specular[2]);
+        material->specularPower = specularPower;
+        material->opacity = opacity;
+        material->blend = (Material::BlendMode) blend;
+
+        for (int j = 0; j < Material::TextureSemanticMax; ++j)
+        {
+            std::string source;
+            if (!ReadString(in, source))
+            {
+                delete material;
+                delete model;
+                return nullptr;
+            }
+
+            if (!source.empty())
+            {
+                if (textureLoader != nullptr)
+                    material->maps[j] = textureLoader->loadTexture(source);
+                else
+                    material->maps[j] = new Material::DefaultTextureResource(source);
+            }
+        }
+
+        model->addMaterial(material);
+    }
+
+    std::uint32_t nMeshes;
+    if (!ReadRaw(in, nMeshes) || nMeshes > MaxCount)
+    {
+        delete model;
+        return nullptr;
+    }
+
+    for (std::uint32_t i = 0; i < nMeshes; ++i)
+    {
+        Mesh* mesh = LoadMesh(in);
+        if (mesh == nullptr)
+        {
+            delete model;
+            return nullptr;
+        }
+
+        model->addMesh(mesh);
+    }
+
+    return model;
+}
+
+} // namespace cmod
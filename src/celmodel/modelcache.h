@@ -0,0 +1,45 @@
+// modelcache.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Compact serialization of models for on-disk cache artifacts.
+
+#ifndef _CELMODEL_MODELCACHE_H_
+#define _CELMODEL_MODELCACHE_H_
+
+#include "model.h"
+#include "modelfile.h"
+#include <iostream>
+
+
+namespace cmod
+{
+
+/*! Write a model in the compressed cache format. Vertex attributes
+ *  are quantized — positions to 16 bits normalized to the mesh
+ *  bounding box, normals and tangents to 16-bit octahedral pairs,
+ *  texture coordinates to half floats — and indices are stored as
+ *  zigzag-delta varints, which after the vertex cache optimization
+ *  pass are mostly one byte each. Files are typically 3-4x smaller
+ *  than binary CMOD. The format is an internal cache artifact, not an
+ *  interchange format: it is written and read by the same machine, so
+ *  values are stored in native byte order with a sentinel that makes
+ *  a foreign file fail to load.
+ */
+bool SaveCachedModel(const Model* model, std::ostream& out);
+
+/*! Load a model written by SaveCachedModel, reconstructing the
+ *  original interleaved vertex layout. Returns nullptr on any
+ *  malformed or foreign input; callers fall back to the source model
+ *  file.
+ */
+Model* LoadCachedModel(std::istream& in, TextureLoader* textureLoader = nullptr);
+
+} // namespace cmod
+
+#endif // !_CELMODEL_MODELCACHE_H_
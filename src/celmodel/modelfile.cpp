@@ -2045,18 +2045,28 @@ BinaryModelLoader::loadMesh()
 
         auto* indices = new uint32_t[indexCount];
 
+        // Read the whole index array with one read rather than one
+        // index at a time; the swap below is a no-op on little-endian
+        // machines.
+        in.read(reinterpret_cast<char*>(indices), indexCount * sizeof(uint32_t));
+        if (!in.good())
+        {
+            reportError("Failed reading index data");
+            delete[] indices;
+            delete mesh;
+            return nullptr;
+        }
+
         for (unsigned int i = 0; i < indexCount; i++)
         {
-            uint32_t index = readUint(in);
-            if (index >= vertexCount)
+            LE_TO_CPU_INT32(indices[i], indices[i]);
+            if (indices[i] >= vertexCount)
             {
                 reportError("Index out of range");
                 delete[] indices;
                 delete mesh;
                 return nullptr;
             }
-
-            indices[i] = index;
         }
 
         mesh->addGroup(type, materialIndex, indexCount, indices);
@@ -2080,38 +2090,44 @@ BinaryModelLoader::loadVertices(const Mesh::VertexDescription& vertexDesc,
     unsigned int vertexDataSize = vertexDesc.stride * vertexCount;
     auto* vertexData = new char[vertexDataSize];
 
-    unsigned int offset = 0;
+    // The file layout of a vertex is identical to the in-memory layout:
+    // attributes packed in declaration order with no padding, floats
+    // little-endian. Read the entire vertex blob with a single read
+    // instead of one attribute at a time; reading a 100 MB model
+    // attribute-wise took seconds in iostream overhead alone.
+    in.read(vertexData, vertexDataSize);
+    if (!in.good())
+    {
+        reportError("Failed reading vertex data");
+        delete[] vertexData;
+        return nullptr;
+    }
 
+#if defined(WORDS_BIGENDIAN) || defined(__BIG_ENDIAN__)
+    // Big-endian machines still have to swap each float in place
+    unsigned int offset = 0;
     for (unsigned int i = 0; i < vertexCount; i++, offset += vertexDesc.stride)
     {
-        assert(offset < vertexDataSize);
         for (unsigned int attr = 0; attr < vertexDesc.nAttributes; attr++)
         {
             unsigned int base = offset + vertexDesc.attributes[attr].offset;
-            Mesh::VertexAttributeFormat fmt = vertexDesc.attributes[attr].format;
-            /*int readCount = 0;    Unused*/
-            switch (fmt)
+            auto* fdata = reinterpret_cast<float*>(vertexData + base);
+
+            switch (vertexDesc.attributes[attr].format)
             {
-            case Mesh::Float1:
-                reinterpret_cast<float*>(vertexData + base)[0] = readFloat(in);
-                break;
-            case Mesh::Float2:
-                reinterpret_cast<float*>(vertexData + base)[0] = readFloat(in);
-                reinterpret_cast<float*>(vertexData + base)[1] = readFloat(in);
-                break;
-            case Mesh::Float3:
-                reinterpret_cast<float*>(vertexData + base)[0] = readFloat(in);
-                reinterpret_cast<float*>(vertexData + base)[1] = readFloat(in);
-                reinterpret_cast<float*>(vertexData + base)[2] = readFloat(in);
-                break;
             case Mesh::Float4:
-                reinterpret_cast<float*>(vertexData + base)[0] = readFloat(in);
-                reinterpret_cast<float*>(vertexData + base)[1] = readFloat(in);
-                reinterpret_cast<float*>(vertexData + base)[2] = readFloat(in);
-                reinterpret_cast<float*>(vertexData + base)[3] = readFloat(in);
+                LE_TO_CPU_FLOAT(fdata[3], fdata[3]);
+                /* fall through */
+            case Mesh::Float3:
+                LE_TO_CPU_FLOAT(fdata[2], fdata[2]);
+                /* fall through */
+            case Mesh::Float2:
+                LE_TO_CPU_FLOAT(fdata[1], fdata[1]);
+                /* fall through */
+            case Mesh::Float1:
+                LE_TO_CPU_FLOAT(fdata[0], fdata[0]);
                 break;
             case Mesh::UByte4:
-                in.get(reinterpret_cast<char*>(vertexData + base), 4);
                 break;
             default:
                 assert(0);
@@ -2120,6 +2136,7 @@ BinaryModelLoader::loadVertices(const Mesh::VertexDescription& vertexDesc,
             }
         }
     }
+#endif
 
     return vertexData;
 }
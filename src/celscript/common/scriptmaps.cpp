@@ -43,6 +43,7 @@ void initRenderFlagMap(FlagMap64 &RenderFlagMap)
     RenderFlagMap["openclusters"]        = Renderer::ShowOpenClusters;
     RenderFlagMap["cloudshadows"]        = Renderer::ShowCloudShadows;
     RenderFlagMap["ecliptic"]            = Renderer::ShowEcliptic;
+    RenderFlagMap["octree"]              = Renderer::ShowOctree;
 }
 
 void initLabelFlagMap(FlagMap &LabelFlagMap)
@@ -32,6 +32,17 @@ using namespace celmath;
 ////////////////
 // Wait command: a no-op with no side effect other than its duration
 
+Selection CachedSelection::resolve(ExecutionEnvironment& env)
+{
+    if (!resolved)
+    {
+        sel = env.getSimulation()->findObjectFromPath(path);
+        resolved = !sel.empty();
+    }
+    return sel;
+}
+
+
 CommandWait::CommandWait(double _duration) : TimedCommand(_duration)
 {
 }
@@ -50,8 +61,7 @@ CommandSelect::CommandSelect(string _target) : target(std::move(_target))
 
 void CommandSelect::process(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(target);
-    env.getSimulation()->setSelection(sel);
+    env.getSimulation()->setSelection(target.resolve(env));
 }
 
 
@@ -198,16 +208,16 @@ void CommandLock::process(ExecutionEnvironment& env)
 CommandSetFrame::CommandSetFrame(ObserverFrame::CoordinateSystem _coordSys,
                                  string refName,
                                  string targetName) :
-    coordSys(_coordSys), refObjectName(std::move(refName)), targetObjectName(std::move(targetName))
+    coordSys(_coordSys), refObject(std::move(refName)), targetObject(std::move(targetName))
 {
 }
 
 void CommandSetFrame::process(ExecutionEnvironment& env)
 {
-    Selection ref = env.getSimulation()->findObjectFromPath(refObjectName);
+    Selection ref = refObject.resolve(env);
     Selection target;
     if (coordSys == ObserverFrame::PhaseLock)
-        target = env.getSimulation()->findObjectFromPath(targetObjectName);
+        target = targetObject.resolve(env);
     env.getSimulation()->setFrame(coordSys, ref, target);
 }
 
@@ -567,7 +577,7 @@ CommandMark::CommandMark(string _target,
 
 void CommandMark::process(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(target);
+    Selection sel = target.resolve(env);
     if (sel.empty())
         return;
 
@@ -590,7 +600,7 @@ CommandUnmark::CommandUnmark(string _target) :
 
 void CommandUnmark::process(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(target);
+    Selection sel = target.resolve(env);
     if (sel.empty())
         return;
 
@@ -620,7 +630,7 @@ CommandPreloadTextures::CommandPreloadTextures(string _name) :
 
 void CommandPreloadTextures::process(ExecutionEnvironment& env)
 {
-    Selection target = env.getSimulation()->findObjectFromPath(name);
+    Selection target = name.resolve(env);
     if (target.body() == nullptr)
         return;
 
@@ -776,7 +786,7 @@ CommandSetRadius::CommandSetRadius(string _object, double _radius) :
 
 void CommandSetRadius::process(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(object);
+    Selection sel = object.resolve(env);
     if (sel.body() != nullptr)
     {
         Body* body = sel.body();
@@ -1089,7 +1099,7 @@ CommandSetRingsTexture::CommandSetRingsTexture(string _object,
 
 void CommandSetRingsTexture::process(ExecutionEnvironment& env)
 {
-    Selection sel = env.getSimulation()->findObjectFromPath(object);
+    Selection sel = object.resolve(env);
     if (sel.body() != nullptr &&
         sel.body()->getRings() != nullptr &&
         !textureName.empty())
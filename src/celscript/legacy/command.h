@@ -31,6 +31,28 @@ class Command
 typedef std::vector<Command*> CommandSequence;
 
 
+/*! Object reference for commands that name their target by path.
+ *  findObjectFromPath() parses the path and allocates on every call,
+ *  which shows up as churn when a script loops, so the path is
+ *  resolved on first use and the Selection reused afterwards. An
+ *  unresolved path is retried, since a script may name objects from
+ *  catalogs that finish loading later.
+ */
+class CachedSelection
+{
+ public:
+    CachedSelection() = default;
+    CachedSelection(std::string _path) : path(std::move(_path)) {};
+
+    Selection resolve(ExecutionEnvironment&);
+
+ private:
+    std::string path;
+    Selection sel;
+    bool resolved{ false };
+};
+
+
 class InstantaneousCommand : public Command
 {
  public:
@@ -74,7 +96,7 @@ class CommandSelect : public InstantaneousCommand
     void process(ExecutionEnvironment&);
 
  private:
-    std::string target;
+    CachedSelection target;
 };
 
 
@@ -219,8 +241,8 @@ class CommandSetFrame : public InstantaneousCommand
 
  private:
     ObserverFrame::CoordinateSystem coordSys;
-    std::string refObjectName;
-    std::string targetObjectName;
+    CachedSelection refObject;
+    CachedSelection targetObject;
 };
 
 
@@ -531,7 +553,7 @@ class CommandPreloadTextures : public InstantaneousCommand
     void process(ExecutionEnvironment&);
 
  private:
-    std::string name;
+    CachedSelection name;
 };
 
 
@@ -542,7 +564,7 @@ class CommandMark : public InstantaneousCommand
     void process(ExecutionEnvironment&);
 
  private:
-    std::string target;
+    CachedSelection target;
     MarkerRepresentation rep;
     bool occludable;
 };
@@ -555,7 +577,7 @@ class CommandUnmark : public InstantaneousCommand
     void process(ExecutionEnvironment&);
 
  private:
-    std::string target;
+    CachedSelection target;
 };
 
 
@@ -656,7 +678,7 @@ class CommandSetRadius : public InstantaneousCommand
     void process(ExecutionEnvironment&);
 
  private:
-    std::string object;
+    CachedSelection object;
     double radius;
 };
 
@@ -759,7 +781,8 @@ class CommandSetRingsTexture : public InstantaneousCommand
     void process(ExecutionEnvironment&);
 
  private:
-    std::string object, textureName, path;
+    CachedSelection object;
+    std::string textureName, path;
 };
 
 
@@ -64,6 +64,17 @@ LegacyScript::LegacyScript(CelestiaCore *core) :
 {
 }
 
+LegacyScript::~LegacyScript()
+{
+    // The Execution refers to the sequence, so drop it first
+    m_runningScript = nullptr;
+    if (m_script != nullptr)
+    {
+        for (auto* command : *m_script)
+            delete command;
+    }
+}
+
 bool LegacyScript::load(ifstream &scriptfile, const fs::path &path, string &errorMsg)
 {
     CommandParser parser(scriptfile, m_appCore->scriptMaps());
@@ -75,6 +86,7 @@ bool LegacyScript::load(ifstream &scriptfile, const fs::path &path, string &erro
             errorMsg = (*errors)[0];
         return false;
     }
+    m_script = unique_ptr<CommandSequence>(script);
     m_runningScript = make_unique<Execution>(*script, *m_execEnv);
     return true;
 }
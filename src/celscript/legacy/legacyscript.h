@@ -11,7 +11,9 @@
 
 #include <celscript/common/script.h>
 #include <iosfwd>
+#include <vector>
 
+class Command;
 class Execution;
 class ExecutionEnvironment;
 class CelestiaCore;
@@ -25,7 +27,7 @@ class LegacyScript : public IScript
 {
  public:
     LegacyScript(CelestiaCore*);
-    ~LegacyScript() override = default;
+    ~LegacyScript() override;
 
     bool load(std::ifstream&, const fs::path&, std::string&);
 
@@ -33,6 +35,9 @@ class LegacyScript : public IScript
 
  private:
     CelestiaCore *m_appCore;
+    // The parsed sequence; owned here, since Execution only holds
+    // iterators into it.
+    std::unique_ptr<std::vector<Command*>> m_script;
     std::unique_ptr<Execution> m_runningScript;
     std::unique_ptr<ExecutionEnvironment> m_execEnv;
 
@@ -12,7 +12,10 @@
 
 #include <config.h>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <ctime>
+#include <fstream>
 #include <map>
 #include <sstream>
 #include <utility>
@@ -27,6 +30,7 @@
 #include <celestia/imagecapture.h>
 #include <celestia/url.h>
 
+#include "celx_async.h"
 #include "celx_internal.h"
 #include "celx_misc.h"
 #include "celx_vector.h"
@@ -74,6 +78,12 @@ const char* CleanupCallback = "celestia_cleanup_callback";
 
 const char* EventHandlers = "celestia_event_handlers";
 
+// registry table mapping watch ids to callbacks; see celestia:addwatch()
+const char* WatchHandlers = "celestia_watch_handlers";
+
+// registry table mapping async job ids to callbacks; see celestia:asyncrun()
+const char* AsyncHandlers = "celestia_async_handlers";
+
 const char* KeyHandler        = "key";
 const char* TickHandler       = "tick";
 const char* MouseDownHandler  = "mousedown";
@@ -112,10 +122,20 @@ void PushClass(lua_State* l, int id)
     lua_pushlstring(l, CelxLua::ClassNames[id], strlen(CelxLua::ClassNames[id]));
 }
 
+// Push the registry key used for the fast pointer-keyed metatable
+// lookup. A lightuserdata key avoids the string push and hash of the
+// class name on every object creation and type check; ClassNames entry
+// addresses are unique and stable, and lightuserdata works identically
+// in Lua 5.1 and later.
+static void PushClassKey(lua_State* l, int id)
+{
+    lua_pushlightuserdata(l, const_cast<char**>(&CelxLua::ClassNames[id]));
+}
+
 // Set the class (metatable) of the object on top of the stack
 void Celx_SetClass(lua_State* l, int id)
 {
-    PushClass(l, id);
+    PushClassKey(l, id);
     lua_rawget(l, LUA_REGISTRYINDEX);
     if (lua_type(l, -1) != LUA_TTABLE)
         cout << "Metatable for " << CelxLua::ClassNames[id] << " not found!\n";
@@ -135,6 +155,12 @@ void Celx_CreateClassMetatable(lua_State* l, int id)
     PushClass(l, id);
     lua_rawset(l, LUA_REGISTRYINDEX); // registry.metatable = name
 
+    // pointer-keyed alias for the hot paths in Celx_SetClass and
+    // Celx_istype
+    PushClassKey(l, id);
+    lua_pushvalue(l, -2);
+    lua_rawset(l, LUA_REGISTRYINDEX); // registry.&name = metatable
+
     lua_pushliteral(l, "__index");
     lua_pushvalue(l, -2);
     lua_rawset(l, -3);
@@ -154,11 +180,25 @@ void Celx_RegisterMethod(lua_State* l, const char* name, lua_CFunction fn)
 // specified class
 bool Celx_istype(lua_State* l, int index, int id)
 {
-    // get registry[metatable]
     if (!lua_getmetatable(l, index))
         return false;
+
+    // compare metatable identity against registry[&name]; cheaper than
+    // the old name lookup plus strcmp, which showed up in profiles of
+    // vector-heavy scripts
+    PushClassKey(l, id);
     lua_rawget(l, LUA_REGISTRYINDEX);
+    if (lua_type(l, -1) == LUA_TTABLE)
+    {
+        bool matched = lua_rawequal(l, -1, -2) != 0;
+        lua_pop(l, 2);
+        return matched;
+    }
+    lua_pop(l, 1);
 
+    // fall back to the name mapping for metatables created outside
+    // Celx_CreateClassMetatable
+    lua_rawget(l, LUA_REGISTRYINDEX);
     if (lua_type(l, -1) != LUA_TSTRING)
     {
         cout << "Celx_istype failed!  Unregistered class.\n";
@@ -235,7 +275,7 @@ double LuaState::getTime() const
 
 // Check if the running script has exceeded its allowed timeslice
 // and terminate it if it has:
-static void checkTimeslice(lua_State* l, lua_Debug* /*ar*/)
+static void checkTimeslice(lua_State* l, lua_Debug* ar)
 {
     lua_pushstring(l, "celestia-luastate");
     lua_gettable(l, LUA_REGISTRYINDEX);
@@ -252,6 +292,14 @@ static void checkTimeslice(lua_State* l, lua_Debug* /*ar*/)
         return;
     }
 
+    // call and return events are only delivered while the profiler has
+    // widened the hook mask
+    if (ar != nullptr && ar->event != LUA_HOOKCOUNT)
+    {
+        luastate->profileEvent(l, ar);
+        return;
+    }
+
     if (luastate->timesliceExpired())
     {
         const char* errormsg = "Timeout: script hasn't returned control to celestia (forgot to call wait()?)";
@@ -259,6 +307,19 @@ static void checkTimeslice(lua_State* l, lua_Debug* /*ar*/)
         lua_pushstring(l, errormsg);
         lua_error(l);
     }
+
+    if (luastate->profileActive())
+        luastate->profileSample(l);
+
+#if LUA_VERSION_NUM >= 503
+    // Well before the hard timeout above, preempt a script that has
+    // used up its per-frame budget: force a yield and let tick()
+    // resume it on the next frame. Yielding from a count hook is only
+    // supported from Lua 5.3 on; with older versions scripts keep the
+    // old run-to-yield behavior.
+    if (luastate->resumeBudgetExpired())
+        lua_yield(l, 0);
+#endif
 }
 
 
@@ -339,6 +400,139 @@ bool LuaState::timesliceExpired()
 }
 
 
+void LuaState::setResumeBudget(double seconds)
+{
+    resumeBudget = seconds > 0.0 ? seconds : 0.0;
+}
+
+
+bool LuaState::resumeBudgetExpired() const
+{
+    return inResume && resumeBudget > 0.0 && budgetDeadline < getTime();
+}
+
+
+double LuaState::getLastSliceTime() const
+{
+    return lastSliceTime;
+}
+
+
+void LuaState::startProfile()
+{
+    if (costate == nullptr || profiling)
+        return;
+
+    profileStacks.clear();
+    profileBindings.clear();
+    profileCallStack.clear();
+    profiling = true;
+
+    // widen the hook mask: samples keep riding the 1000-instruction
+    // count tick, call/return events feed the binding attribution
+    lua_sethook(costate, checkTimeslice, LUA_MASKCOUNT | LUA_MASKCALL | LUA_MASKRET, 1000);
+}
+
+
+bool LuaState::stopProfile(const fs::path& path)
+{
+    if (!profiling)
+        return false;
+
+    profiling = false;
+    profileCallStack.clear();
+    if (costate != nullptr)
+        lua_sethook(costate, checkTimeslice, LUA_MASKCOUNT, 1000);
+
+    ofstream out(path.string().c_str());
+    if (!out.good())
+        return false;
+
+    out << "# celx profile\n";
+    out << "# engine crossings: binding, calls, inclusive seconds\n";
+    for (const auto& binding : profileBindings)
+    {
+        out << "# " << binding.first << ' ' << binding.second.calls
+            << ' ' << binding.second.seconds << '\n';
+    }
+
+    // collapsed flame-graph format: outermost;...;leaf samplecount
+    for (const auto& stack : profileStacks)
+        out << stack.first << ' ' << stack.second << '\n';
+
+    return out.good();
+}
+
+
+// Record one stack sample in collapsed form; runs every 1000 VM
+// instructions from the count hook while profiling.
+void LuaState::profileSample(lua_State* l)
+{
+    const int MaxSampleDepth = 32;
+
+    lua_Debug frame;
+    int depth = 0;
+    while (depth < MaxSampleDepth && lua_getstack(l, depth, &frame))
+        depth++;
+
+    string folded;
+    for (int level = depth - 1; level >= 0; level--)
+    {
+        if (!lua_getstack(l, level, &frame) || lua_getinfo(l, "nS", &frame) == 0)
+            continue;
+
+        if (!folded.empty())
+            folded += ';';
+        if (frame.name != nullptr)
+            folded += frame.name;
+        else if (*frame.what == 'm')
+            folded += "main";
+        else if (*frame.what == 'C')
+            folded += "[C]";
+        else
+        {
+            // anonymous Lua function; identify it by definition line
+            folded += "anon:";
+            folded += to_string(frame.linedefined);
+        }
+    }
+
+    if (!folded.empty())
+        ++profileStacks[folded];
+}
+
+
+// Attribute wall time to engine crossings: every call into a C binding
+// records the entry time; the matching return charges the elapsed time
+// to that binding. Lua-to-Lua calls are filtered out, so dispatch
+// stays cheap.
+void LuaState::profileEvent(lua_State* l, lua_Debug* ar)
+{
+    if (!profiling)
+        return;
+
+    if (ar->event == LUA_HOOKCALL)
+    {
+        if (lua_getinfo(l, "nS", ar) == 0 || *ar->what != 'C')
+            return;
+        profileCallStack.emplace_back(ar->name != nullptr ? ar->name : "[C]",
+                                      getTime());
+    }
+    else if (ar->event == LUA_HOOKRET)
+    {
+        if (profileCallStack.empty())
+            return;
+        if (lua_getinfo(l, "S", ar) == 0 || *ar->what != 'C')
+            return;
+
+        BindingProfile& binding = profileBindings[profileCallStack.back().first];
+        binding.calls++;
+        binding.seconds += getTime() - profileCallStack.back().second;
+        profileCallStack.pop_back();
+    }
+}
+
+
 static int resumeLuaThread(lua_State *L, lua_State *co, int narg)
 {
     int status;
@@ -405,6 +599,103 @@ static const char* readStreamChunk(lua_State* /*unused*/, void* udata, size_t* s
 }
 
 
+// Compiled chunk cache. Compiling a large script can take hundreds of
+// milliseconds, so the bytecode produced for a script file is kept in
+// a sidecar file next to it and reused while the source is unchanged.
+// The sidecar carries the Lua version, the pointer size and a hash of
+// the source; any mismatch simply falls back to compiling. Writing the
+// sidecar is best effort, as script directories may be read-only.
+
+static uint64_t hashChunkSource(const string& text)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);    // FNV-1a offset basis
+    for (char ch : text)
+    {
+        hash ^= (unsigned char) ch;
+        hash *= UINT64_C(1099511628211);
+    }
+    return hash;
+}
+
+static const char CompiledChunkMagic[4] = { 'C', 'L', 'U', 'A' };
+
+static fs::path compiledChunkPath(const fs::path& scriptPath)
+{
+    return fs::path(scriptPath.string() + ".luac");
+}
+
+static bool readCompiledChunk(const fs::path& cachePath, uint64_t sourceHash, string& chunk)
+{
+    ifstream in(cachePath.string(), ios::in | ios::binary);
+    if (!in.good())
+        return false;
+
+    char magic[4];
+    uint32_t luaVersion = 0;
+    uint32_t pointerSize = 0;
+    uint64_t hash = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&luaVersion), sizeof(luaVersion));
+    in.read(reinterpret_cast<char*>(&pointerSize), sizeof(pointerSize));
+    in.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+    if (!in.good() ||
+        memcmp(magic, CompiledChunkMagic, sizeof(magic)) != 0 ||
+        luaVersion != (uint32_t) LUA_VERSION_NUM ||
+        pointerSize != (uint32_t) sizeof(void*) ||
+        hash != sourceHash)
+    {
+        return false;
+    }
+
+    stringstream body;
+    body << in.rdbuf();
+    chunk = body.str();
+
+    return !chunk.empty();
+}
+
+static void writeCompiledChunk(const fs::path& cachePath, uint64_t sourceHash, const string& chunk)
+{
+    ofstream out(cachePath.string(), ios::out | ios::binary | ios::trunc);
+    if (!out.good())
+        return;
+
+    uint32_t luaVersion = LUA_VERSION_NUM;
+    uint32_t pointerSize = sizeof(void*);
+    out.write(CompiledChunkMagic, sizeof(CompiledChunkMagic));
+    out.write(reinterpret_cast<const char*>(&luaVersion), sizeof(luaVersion));
+    out.write(reinterpret_cast<const char*>(&pointerSize), sizeof(pointerSize));
+    out.write(reinterpret_cast<const char*>(&sourceHash), sizeof(sourceHash));
+    out.write(chunk.data(), chunk.size());
+}
+
+struct StringChunkInfo
+{
+    const string* data;
+    bool done;
+};
+
+static const char* readStringChunk(lua_State* /*unused*/, void* udata, size_t* size)
+{
+    auto* info = reinterpret_cast<StringChunkInfo*>(udata);
+    if (info->done)
+    {
+        *size = 0;
+        return nullptr;
+    }
+
+    info->done = true;
+    *size = info->data->size();
+    return info->data->data();
+}
+
+static int writeChunkBytes(lua_State* /*unused*/, const void* p, size_t size, void* udata)
+{
+    reinterpret_cast<string*>(udata)->append(reinterpret_cast<const char*>(p), size);
+    return 0;
+}
+
+
 // Callback for CelestiaCore::charEntered.
 // Returns true if keypress has been consumed
 bool LuaState::charEntered(const char* c_p)
@@ -582,6 +873,11 @@ bool LuaState::handleTickEvent(double dt)
     if (appCore == nullptr)
         return false;
 
+    // evaluate event watches and finished worker jobs before the
+    // polling-style tick handler
+    checkWatches();
+    checkAsyncJobs();
+
     // get the registered event table
     lua_getfield(costate, LUA_REGISTRYINDEX, EventHandlers);
     if (!lua_istable(costate, -1))
@@ -622,28 +918,326 @@ bool LuaState::handleTickEvent(double dt)
 }
 
 
-int LuaState::loadScript(istream& in, const fs::path& streamname)
+// Register a new event watch and return its id. The Lua callback must
+// already be stored in the WatchHandlers registry table under that id;
+// celestia_addwatch() takes care of this.
+int LuaState::addWatch(ScriptWatch&& watch)
 {
-    char buf[4096];
-    ReadChunkInfo info;
-    info.buf = buf;
-    info.bufSize = sizeof(buf);
-    info.in = &in;
+    watch.id = nextWatchId++;
+    watches.push_back(std::move(watch));
+    return watches.back().id;
+}
+
 
+bool LuaState::removeWatch(int id)
+{
+    for (auto iter = watches.begin(); iter != watches.end(); ++iter)
+    {
+        if (iter->id != id)
+            continue;
+
+        watches.erase(iter);
+        if (costate != nullptr)
+        {
+            lua_getfield(costate, LUA_REGISTRYINDEX, WatchHandlers);
+            if (lua_istable(costate, -1))
+            {
+                lua_pushinteger(costate, id);
+                lua_pushnil(costate);
+                lua_settable(costate, -3);
+            }
+            lua_pop(costate, 1);
+        }
+        return true;
+    }
+
+    return false;
+}
+
+
+// Evaluate all watch predicates and call the Lua callbacks of those
+// that fired. Runs once per tick from the tick dispatch paths; when
+// nothing fires, Lua is never entered.
+void LuaState::checkWatches()
+{
+    if (watches.empty() || costate == nullptr)
+        return;
+
+    CelestiaCore* appCore = getAppCore(costate, NoErrors);
+    if (appCore == nullptr)
+        return;
+
+    Simulation* sim = appCore->getSimulation();
+    Observer* observer = sim->getActiveObserver();
+    double now = sim->getTime();
+    UniversalCoord observerPos = observer->getPosition();
+
+    // Evaluate first, call out to Lua afterwards: a callback may add
+    // or remove watches and invalidate iterators.
+    std::vector<std::pair<ScriptWatch, double>> fired;
+
+    for (auto& watch : watches)
+    {
+        switch (watch.kind)
+        {
+        case ScriptWatch::TimeReached:
+            if (now >= watch.threshold)
+                fired.emplace_back(watch, 0.0);
+            break;
+
+        case ScriptWatch::DistanceThreshold:
+            {
+                double distance = watch.target.getPosition(now).offsetFromKm(observerPos).norm();
+                bool below = distance < watch.threshold;
+                if (below != watch.state)
+                {
+                    watch.state = below;
+                    fired.emplace_back(watch, distance);
+                }
+            }
+            break;
+
+        case ScriptWatch::Visibility:
+            {
+                Eigen::Vector3d offset = watch.target.getPosition(now).offsetFromKm(observerPos);
+                bool visible = false;
+                double distance = offset.norm();
+                if (distance > 0.0)
+                {
+                    Eigen::Vector3d viewDir = observer->getOrientation().conjugate() * -Eigen::Vector3d::UnitZ();
+                    visible = offset.dot(viewDir) > distance * cos(observer->getFOV() * 0.5);
+                }
+                if (visible != watch.state)
+                {
+                    watch.state = visible;
+                    fired.emplace_back(watch, distance);
+                }
+            }
+            break;
+
+        case ScriptWatch::SelectionChanged:
+            {
+                Selection current = sim->getSelection();
+                if (current != watch.lastSelection)
+                {
+                    watch.lastSelection = current;
+                    fired.emplace_back(watch, 0.0);
+                }
+            }
+            break;
+        }
+    }
+
+    for (const auto& f : fired)
+    {
+        fireWatch(f.first, f.second);
+        // time watches are one-shot; the others persist until removed
+        if (f.first.kind == ScriptWatch::TimeReached)
+            removeWatch(f.first.id);
+    }
+}
+
+
+// Call the Lua callback registered for a watch, passing an event table
+// describing what fired.
+void LuaState::fireWatch(const ScriptWatch& watch, double distance)
+{
+    lua_getfield(costate, LUA_REGISTRYINDEX, WatchHandlers);
+    if (!lua_istable(costate, -1))
+    {
+        lua_pop(costate, 1);
+        return;
+    }
+
+    lua_pushinteger(costate, watch.id);
+    lua_gettable(costate, -2);
+    lua_remove(costate, -2);        // remove the watch handler table
+    if (!lua_isfunction(costate, -1))
+    {
+        lua_pop(costate, 1);
+        return;
+    }
+
+    lua_newtable(costate);
+    lua_pushstring(costate, "id");
+    lua_pushinteger(costate, watch.id);
+    lua_settable(costate, -3);
+    lua_pushstring(costate, "type");
+    switch (watch.kind)
+    {
+    case ScriptWatch::TimeReached:
+        lua_pushstring(costate, "time");
+        break;
+    case ScriptWatch::DistanceThreshold:
+        lua_pushstring(costate, "distance");
+        break;
+    case ScriptWatch::Visibility:
+        lua_pushstring(costate, "visible");
+        break;
+    case ScriptWatch::SelectionChanged:
+        lua_pushstring(costate, "selection");
+        break;
+    }
+    lua_settable(costate, -3);
+
+    if (watch.kind == ScriptWatch::DistanceThreshold)
+    {
+        lua_pushstring(costate, "distance");
+        lua_pushnumber(costate, distance);
+        lua_settable(costate, -3);
+        lua_pushstring(costate, "below");
+        lua_pushboolean(costate, watch.state ? 1 : 0);
+        lua_settable(costate, -3);
+    }
+    else if (watch.kind == ScriptWatch::Visibility)
+    {
+        lua_pushstring(costate, "visible");
+        lua_pushboolean(costate, watch.state ? 1 : 0);
+        lua_settable(costate, -3);
+    }
+
+    timeout = getTime() + 1.0;
+    if (lua_pcall(costate, 1, 0, 0) != 0)
+    {
+        cerr << "Error while executing watch callback: " << lua_tostring(costate, -1) << "\n";
+        lua_pop(costate, 1);
+    }
+}
+
+
+int LuaState::startAsyncJob(std::string source, UniverseSnapshot&& snapshot)
+{
+    int id = nextAsyncJobId++;
+    asyncJobs.push_back(unique_ptr<AsyncScriptJob>(new AsyncScriptJob(id, move(source), move(snapshot))));
+    asyncJobs.back()->start();
+    return id;
+}
+
+
+// Deliver results of finished worker jobs to their main-thread
+// callbacks. Runs once per tick alongside checkWatches(); jobs still
+// in flight cost a single atomic load each.
+void LuaState::checkAsyncJobs()
+{
+    if (asyncJobs.empty() || costate == nullptr)
+        return;
+
+    for (auto iter = asyncJobs.begin(); iter != asyncJobs.end();)
+    {
+        if (!(*iter)->isDone())
+        {
+            ++iter;
+            continue;
+        }
+
+        // take ownership before calling out to Lua; the callback may
+        // launch new jobs and invalidate iterators
+        unique_ptr<AsyncScriptJob> job = move(*iter);
+        asyncJobs.erase(iter);
+
+        lua_getfield(costate, LUA_REGISTRYINDEX, AsyncHandlers);
+        if (!lua_istable(costate, -1))
+        {
+            lua_pop(costate, 1);
+            iter = asyncJobs.begin();
+            continue;
+        }
+        lua_pushinteger(costate, job->getId());
+        lua_gettable(costate, -2);
+        lua_pushinteger(costate, job->getId());
+        lua_pushnil(costate);
+        lua_settable(costate, -4);      // clear the handler entry
+        lua_remove(costate, -2);        // remove the handler table
+        if (!lua_isfunction(costate, -1))
+        {
+            lua_pop(costate, 1);
+            iter = asyncJobs.begin();
+            continue;
+        }
+
+        // callback(result, error): result is nil when the job failed
+        if (job->failed())
+        {
+            lua_pushnil(costate);
+            lua_pushstring(costate, job->getError().c_str());
+        }
+        else
+        {
+            PushLuaValue(costate, job->getResult());
+            lua_pushnil(costate);
+        }
+
+        timeout = getTime() + 1.0;
+        if (lua_pcall(costate, 2, 0, 0) != 0)
+        {
+            cerr << "Error while executing async script callback: " << lua_tostring(costate, -1) << "\n";
+            lua_pop(costate, 1);
+        }
+
+        iter = asyncJobs.begin();
+    }
+}
+
+
+int LuaState::loadScript(istream& in, const fs::path& streamname)
+{
+    int status;
     if (streamname != "string")
     {
         lua_pushstring(state, "celestia-scriptpath");
         lua_pushstring(state, streamname.string().c_str());
         lua_settable(state, LUA_REGISTRYINDEX);
+
+        // File-backed script: check the compiled chunk cache before
+        // compiling from source.
+        stringstream sourceStream;
+        sourceStream << in.rdbuf();
+        string source = sourceStream.str();
+        uint64_t sourceHash = hashChunkSource(source);
+        fs::path cachePath = compiledChunkPath(streamname);
+
+        string compiled;
+        bool cached = readCompiledChunk(cachePath, sourceHash, compiled);
+
+        StringChunkInfo info;
+        info.data = cached ? &compiled : &source;
+        info.done = false;
+
+#if LUA_VERSION_NUM >= 502
+        status = lua_load(state, readStringChunk, &info,
+                          streamname.string().c_str(), nullptr);
+#else
+        status = lua_load(state, readStringChunk, &info,
+                          streamname.string().c_str());
+#endif
+        if (status == 0 && !cached)
+        {
+            compiled.clear();
+#if LUA_VERSION_NUM >= 503
+            if (lua_dump(state, writeChunkBytes, &compiled, 0) == 0 && !compiled.empty())
+#else
+            if (lua_dump(state, writeChunkBytes, &compiled) == 0 && !compiled.empty())
+#endif
+                writeCompiledChunk(cachePath, sourceHash, compiled);
+        }
     }
+    else
+    {
+        char buf[4096];
+        ReadChunkInfo info;
+        info.buf = buf;
+        info.bufSize = sizeof(buf);
+        info.in = &in;
 
 #if LUA_VERSION_NUM >= 502
-    int status = lua_load(state, readStreamChunk, &info,
+        status = lua_load(state, readStreamChunk, &info,
                           streamname.string().c_str(), nullptr);
 #else
-    int status = lua_load(state, readStreamChunk, &info,
+        status = lua_load(state, readStreamChunk, &info,
                           streamname.string().c_str());
 #endif
+    }
+
     if (status != 0)
         cout << "Error loading script: " << lua_tostring(state, -1) << '\n';
 
@@ -669,8 +1263,13 @@ int LuaState::resume()
     if (co != costate)
         return 0;
 
-    timeout = getTime() + MaxTimeslice;
+    double sliceStart = getTime();
+    timeout = sliceStart + MaxTimeslice;
+    budgetDeadline = sliceStart + resumeBudget;
+    inResume = true;
     int nArgs = resumeLuaThread(state, co, 0);
+    inResume = false;
+    lastSliceTime = getTime() - sliceStart;
     if (nArgs < 0)
     {
         alive = false;
@@ -791,7 +1390,9 @@ bool LuaState::tick(double dt)
     lua_State* state = getState();
 
     // The values on the stack indicate what event will wake up the
-    // script.  For now, we just support wait()
+    // script.  For now, we just support wait(). A budget preemption
+    // yields no values and so falls into the zero-delay case, which
+    // carries the unfinished work over to the next frame.
     double delay;
     if (nArgs == 1 && lua_isnumber(state, -1))
         delay = lua_tonumber(state, -1);
@@ -1333,6 +1934,11 @@ bool LuaState::callLuaHook(void* obj, const char* method, float x, float y, int
 
 bool LuaState::callLuaHook(void* obj, const char* method, double dt)
 {
+    // the hook's per-frame tick call doubles as the hook environment's
+    // watch and async job evaluation point
+    checkWatches();
+    checkAsyncJobs();
+
     if (!eventHandlerEnabled)
         return false;
 
@@ -12,7 +12,10 @@
 #ifndef _CELESTIA_CELX_H_
 #define _CELESTIA_CELX_H_
 
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include "lua.hpp"
@@ -30,6 +33,8 @@ int lua_isinteger(lua_State *L, int index);
 
 class CelestiaCore;
 class View;
+class AsyncScriptJob;
+struct UniverseSnapshot;
 
 class LuaState
 {
@@ -53,6 +58,18 @@ public:
     bool timesliceExpired();
     void requestIO();
 
+    //! Set the per-resume execution budget in seconds. While a resume
+    //! exceeds the budget the script is forcibly yielded and continued
+    //! on the next tick, so a busy script degrades itself instead of
+    //! the frame rate. A budget of zero disables preemption, which is
+    //! the lane camera-motion scripts should run in.
+    void setResumeBudget(double seconds);
+    bool resumeBudgetExpired() const;
+
+    //! Wall-clock time in seconds the script ran during its most
+    //! recent resume; shown to scripts through celestia:perf()
+    double getLastSliceTime() const;
+
     bool charEntered(const char*);
     double getTime() const;
     int screenshotCount;
@@ -81,6 +98,52 @@ public:
         IODenied = 8
     };
 
+    //! An event subscription registered through celestia:addwatch().
+    //! The predicate is evaluated in C++ once per tick; the Lua
+    //! callback is only entered when it fires, so a dormant watch
+    //! costs a few comparisons instead of a per-tick pcall.
+    struct ScriptWatch
+    {
+        enum Kind
+        {
+            TimeReached,        // simulation time passed threshold (one-shot)
+            DistanceThreshold,  // observer-target distance crossed threshold km
+            Visibility,         // target entered or left the view cone
+            SelectionChanged,   // simulation selection changed
+        };
+
+        int id{ 0 };
+        Kind kind{ TimeReached };
+        Selection target;
+        double threshold{ 0.0 };
+        // Last predicate value, for edge detection
+        bool state{ false };
+        // Previously seen selection (SelectionChanged only)
+        Selection lastSelection;
+    };
+
+    int addWatch(ScriptWatch&& watch);
+    bool removeWatch(int id);
+    void checkWatches();
+
+    //! Launch a read-only analysis script on a worker thread against
+    //! an immutable universe snapshot and return the job id; see
+    //! celestia:asyncrun(). The callback runs on the main thread once
+    //! the job finishes.
+    int startAsyncJob(std::string source, UniverseSnapshot&& snapshot);
+    void checkAsyncJobs();
+
+    //! Sampling profiler: stack samples are taken on the existing
+    //! count hook and wall time is attributed to every crossing into a
+    //! C binding; see celestia:startprofile(). The report is written
+    //! in collapsed flame-graph format with the binding table in
+    //! comment lines.
+    void startProfile();
+    bool stopProfile(const fs::path& path);
+    bool profileActive() const { return profiling; }
+    void profileSample(lua_State* l);
+    void profileEvent(lua_State* l, lua_Debug* ar);
+
 private:
     lua_State* state;
     lua_State* costate{ nullptr }; // coroutine stack
@@ -89,6 +152,35 @@ private:
     double scriptAwakenTime{ 0.0 };
     IOMode ioMode{ NoIO };
     bool eventHandlerEnabled{ false };
+
+    // Per-resume execution budget; see setResumeBudget()
+    double resumeBudget{ 0.002 };
+    double budgetDeadline{ 0.0 };
+    double lastSliceTime{ 0.0 };
+    // Forced yields are only legal while resume() is driving the
+    // coroutine, not from pcall-based event handlers.
+    bool inResume{ false };
+
+    // Active event watches; see checkWatches()
+    std::vector<ScriptWatch> watches;
+    int nextWatchId{ 1 };
+
+    void fireWatch(const ScriptWatch& watch, double distance);
+
+    // Outstanding worker-thread jobs; see checkAsyncJobs()
+    std::vector<std::unique_ptr<AsyncScriptJob>> asyncJobs;
+    int nextAsyncJobId{ 1 };
+
+    // Profiler state; see startProfile()
+    struct BindingProfile
+    {
+        std::uint64_t calls{ 0 };
+        double seconds{ 0.0 };
+    };
+    bool profiling{ false };
+    std::map<std::string, std::uint64_t> profileStacks;     // folded stack -> samples
+    std::map<std::string, BindingProfile> profileBindings;  // binding name -> cost
+    std::vector<std::pair<std::string, double>> profileCallStack; // active C crossings
 };
 
 View* getViewByObserver(CelestiaCore*, Observer*);
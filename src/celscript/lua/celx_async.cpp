@@ -0,0 +1,220 @@
+// celx_async.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Off-main-thread execution of read-only celx analysis scripts against
+// an immutable per-tick snapshot of the universe.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "celx_async.h"
+
+using namespace std;
+
+
+// Capture depth limit for results crossing back to the main state;
+// guards against self-referential tables.
+constexpr int MaxCaptureDepth = 8;
+
+
+AsyncLuaValue CaptureLuaValue(lua_State* l, int index, int depth)
+{
+    AsyncLuaValue value;
+
+    switch (lua_type(l, index))
+    {
+    case LUA_TBOOLEAN:
+        value.type = AsyncLuaValue::Boolean;
+        value.boolValue = lua_toboolean(l, index) != 0;
+        break;
+
+    case LUA_TNUMBER:
+        value.type = AsyncLuaValue::Number;
+        value.numberValue = lua_tonumber(l, index);
+        break;
+
+    case LUA_TSTRING:
+        {
+            value.type = AsyncLuaValue::String;
+            size_t len = 0;
+            const char* s = lua_tolstring(l, index, &len);
+            value.stringValue.assign(s, len);
+        }
+        break;
+
+    case LUA_TTABLE:
+        if (depth < MaxCaptureDepth)
+        {
+            value.type = AsyncLuaValue::Table;
+            // normalize to an absolute index before pushing keys
+            int table = index > 0 ? index : lua_gettop(l) + index + 1;
+            lua_pushnil(l);
+            while (lua_next(l, table) != 0)
+            {
+                AsyncLuaValue key = CaptureLuaValue(l, -2, depth + 1);
+                AsyncLuaValue val = CaptureLuaValue(l, -1, depth + 1);
+                if (key.type != AsyncLuaValue::Nil && key.type != AsyncLuaValue::Table)
+                    value.tableValue.emplace_back(move(key), move(val));
+                lua_pop(l, 1);
+            }
+        }
+        break;
+
+    default:
+        // nil, userdata, functions and threads all transfer as nil
+        break;
+    }
+
+    return value;
+}
+
+
+void PushLuaValue(lua_State* l, const AsyncLuaValue& value)
+{
+    switch (value.type)
+    {
+    case AsyncLuaValue::Boolean:
+        lua_pushboolean(l, value.boolValue ? 1 : 0);
+        break;
+
+    case AsyncLuaValue::Number:
+        lua_pushnumber(l, value.numberValue);
+        break;
+
+    case AsyncLuaValue::String:
+        lua_pushlstring(l, value.stringValue.data(), value.stringValue.length());
+        break;
+
+    case AsyncLuaValue::Table:
+        lua_newtable(l);
+        for (const auto& entry : value.tableValue)
+        {
+            PushLuaValue(l, entry.first);
+            PushLuaValue(l, entry.second);
+            lua_rawset(l, -3);
+        }
+        break;
+
+    default:
+        lua_pushnil(l);
+        break;
+    }
+}
+
+
+static void setSnapshotField(lua_State* l, const char* key, double value)
+{
+    lua_pushstring(l, key);
+    lua_pushnumber(l, value);
+    lua_rawset(l, -3);
+}
+
+
+// Build the global snapshot table in the worker state.
+static void pushSnapshot(lua_State* l, const UniverseSnapshot& snapshot)
+{
+    lua_newtable(l);
+    setSnapshotField(l, "time", snapshot.time);
+    setSnapshotField(l, "fov", snapshot.fov);
+    setSnapshotField(l, "viewx", snapshot.viewX);
+    setSnapshotField(l, "viewy", snapshot.viewY);
+    setSnapshotField(l, "viewz", snapshot.viewZ);
+
+    lua_pushstring(l, "objects");
+    lua_newtable(l);
+    int i = 0;
+    for (const auto& obj : snapshot.objects)
+    {
+        lua_newtable(l);
+        lua_pushstring(l, "name");
+        lua_pushlstring(l, obj.name.data(), obj.name.length());
+        lua_rawset(l, -3);
+        setSnapshotField(l, "x", obj.x);
+        setSnapshotField(l, "y", obj.y);
+        setSnapshotField(l, "z", obj.z);
+        setSnapshotField(l, "distance", obj.distance);
+        setSnapshotField(l, "radius", obj.radius);
+        lua_rawseti(l, -2, ++i);
+    }
+    lua_rawset(l, -3);
+}
+
+
+static void openWorkerLibrary(lua_State* l, const char* name, lua_CFunction func)
+{
+#if LUA_VERSION_NUM >= 502
+    luaL_requiref(l, name, func, 1);
+    lua_pop(l, 1);
+#else
+    lua_pushcfunction(l, func);
+    lua_pushstring(l, name);
+    lua_call(l, 1, 0);
+#endif
+}
+
+
+AsyncScriptJob::AsyncScriptJob(int _id, string _source, UniverseSnapshot&& _snapshot) :
+    id(_id),
+    source(move(_source)),
+    snapshot(move(_snapshot))
+{
+}
+
+
+AsyncScriptJob::~AsyncScriptJob()
+{
+    if (worker.joinable())
+        worker.join();
+}
+
+
+void AsyncScriptJob::start()
+{
+    worker = thread(&AsyncScriptJob::run, this);
+}
+
+
+bool AsyncScriptJob::isDone() const
+{
+    return done.load(memory_order_acquire);
+}
+
+
+// Worker thread body. The private state never touches the universe;
+// everything it may read was copied into the snapshot up front.
+void AsyncScriptJob::run()
+{
+    lua_State* l = luaL_newstate();
+    if (l == nullptr)
+    {
+        errorMessage = "Out of memory creating worker state";
+        done.store(true, memory_order_release);
+        return;
+    }
+
+    // computation-only library set: no io, os or package
+    openWorkerLibrary(l, "", luaopen_base);
+    openWorkerLibrary(l, LUA_TABLIBNAME, luaopen_table);
+    openWorkerLibrary(l, LUA_STRLIBNAME, luaopen_string);
+    openWorkerLibrary(l, LUA_MATHLIBNAME, luaopen_math);
+
+    pushSnapshot(l, snapshot);
+    lua_setglobal(l, "snapshot");
+
+    if (luaL_loadbuffer(l, source.data(), source.length(), "async") != 0 ||
+        lua_pcall(l, 0, 1, 0) != 0)
+    {
+        const char* msg = lua_tostring(l, -1);
+        errorMessage = msg != nullptr ? msg : "Unknown error in async script";
+    }
+    else
+    {
+        result = CaptureLuaValue(l, -1);
+    }
+
+    lua_close(l);
+    done.store(true, memory_order_release);
+}
@@ -0,0 +1,107 @@
+// celx_async.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Off-main-thread execution of read-only celx analysis scripts against
+// an immutable per-tick snapshot of the universe.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "lua.hpp"
+
+//! A Lua value captured from or restored into a Lua stack. Only nil,
+//! booleans, numbers, strings and tables of these survive the transfer
+//! between the worker state and the main state; everything else
+//! (userdata, functions, threads) becomes nil.
+struct AsyncLuaValue
+{
+    enum Type
+    {
+        Nil,
+        Boolean,
+        Number,
+        String,
+        Table,
+    };
+
+    Type type{ Nil };
+    bool boolValue{ false };
+    double numberValue{ 0.0 };
+    std::string stringValue;
+    std::vector<std::pair<AsyncLuaValue, AsyncLuaValue>> tableValue;
+};
+
+//! One object captured into a universe snapshot. Positions are
+//! kilometer offsets from the observer at capture time, so distance
+//! and angular size queries are plain arithmetic on the worker side.
+struct SnapshotObject
+{
+    std::string name;
+    double x{ 0.0 };
+    double y{ 0.0 };
+    double z{ 0.0 };
+    double distance{ 0.0 };
+    double radius{ 0.0 };
+};
+
+//! Immutable per-tick snapshot handed to a worker script. Built on the
+//! main thread between frames; the worker only ever reads it.
+struct UniverseSnapshot
+{
+    double time{ 0.0 };           // simulation time, julian date
+    double fov{ 0.0 };            // active observer field of view, radians
+    double viewX{ 0.0 };          // observer view direction, unit vector
+    double viewY{ 0.0 };
+    double viewZ{ 0.0 };
+    std::vector<SnapshotObject> objects;
+};
+
+//! A script running on a worker thread in a private Lua state with
+//! only the base, table, string and math libraries and a read-only
+//! global snapshot table. The chunk's return value is captured as an
+//! AsyncLuaValue and delivered to the main-thread callback; any
+//! mutations the script wants must be performed by that callback,
+//! which runs with the full celestia API.
+class AsyncScriptJob
+{
+public:
+    AsyncScriptJob(int _id, std::string _source, UniverseSnapshot&& _snapshot);
+    ~AsyncScriptJob();
+
+    AsyncScriptJob(const AsyncScriptJob&) = delete;
+    AsyncScriptJob& operator=(const AsyncScriptJob&) = delete;
+
+    void start();
+    bool isDone() const;
+
+    int getId() const { return id; }
+    const AsyncLuaValue& getResult() const { return result; }
+    const std::string& getError() const { return errorMessage; }
+    bool failed() const { return !errorMessage.empty(); }
+
+private:
+    void run();
+
+    int id;
+    std::string source;
+    UniverseSnapshot snapshot;
+
+    std::thread worker;
+    std::atomic<bool> done{ false };
+
+    AsyncLuaValue result;
+    std::string errorMessage;
+};
+
+AsyncLuaValue CaptureLuaValue(lua_State* l, int index, int depth = 0);
+void PushLuaValue(lua_State* l, const AsyncLuaValue& value);
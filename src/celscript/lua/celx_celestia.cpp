@@ -10,6 +10,7 @@
 // of the License, or (at your option) any later version.
 
 #include <celutil/debug.h>
+#include <celutil/memaudit.h>
 #if NO_TTF
 #include "celtxf/texturefont.h"
 #else
@@ -17,9 +18,11 @@
 #endif
 #include <fmt/printf.h>
 #include <celengine/category.h>
+#include <celengine/glstats.h>
 #include <celengine/texture.h>
 #include <celcompat/filesystem.h>
 #include "celx.h"
+#include "celx_async.h"
 #include "celx_internal.h"
 #include "celx_celestia.h"
 #include "celx_frame.h"
@@ -30,6 +33,7 @@
 #include "celx_rotation.h"
 #include "celx_vector.h"
 #include "celx_category.h"
+#include <celmath/mathlib.h>
 #include <celestia/url.h>
 #include <celestia/celestiacore.h>
 #include <celestia/view.h>
@@ -47,6 +51,8 @@ extern const char* KeyHandler;
 extern const char* TickHandler;
 extern const char* MouseDownHandler;
 extern const char* MouseUpHandler;
+extern const char* WatchHandlers;
+extern const char* AsyncHandlers;
 
 LuaState *getLuaStateObject(lua_State*);
 
@@ -130,6 +136,38 @@ static int celestia_gettextwidth(lua_State* l)
     return 1;
 }
 
+// Return an array of { component, category, bytes } tables, one per
+// ledger entry collected from the registered memory reporters.
+static int celestia_memoryusage(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No arguments expected for celestia:memoryusage()");
+
+    this_celestia(l);
+
+    MemoryLedger ledger;
+    GetMemoryAudit().collect(ledger);
+
+    lua_newtable(l);
+    int i = 1;
+    for (const auto& entry : ledger.entries())
+    {
+        lua_pushnumber(l, (lua_Number) i++);
+        lua_newtable(l);
+        lua_pushstring(l, "component");
+        lua_pushstring(l, entry.component.c_str());
+        lua_settable(l, -3);
+        lua_pushstring(l, "category");
+        lua_pushstring(l, entry.category.c_str());
+        lua_settable(l, -3);
+        lua_pushstring(l, "bytes");
+        lua_pushnumber(l, (lua_Number) entry.bytes);
+        lua_settable(l, -3);
+        lua_settable(l, -3);
+    }
+
+    return 1;
+}
+
 static int celestia_getaltazimuthmode(lua_State* l)
 {
     Celx_CheckArgs(l, 1, 1, "No arguments expected for celestia:getaltazimuthmode()");
@@ -952,6 +990,109 @@ static int celestia_getselection(lua_State* l)
     return 1;
 }
 
+// Bulk variant of object:getposition() for scripts that drive many
+// objects per frame; the whole batch costs a single Lua/engine
+// crossing instead of one per object.
+//
+// celestia:getpositions(objects [, t [, origin]])
+//
+// objects is an array of objects, t an optional time (the current
+// simulation time if omitted), and origin an optional position or
+// object. The result is a flat array { x1, y1, z1, x2, y2, z2, ... }:
+// universal coordinates like the components of a position object, or,
+// when an origin is given, offsets from it in kilometers, which is the
+// form observer-relative placement wants.
+static int celestia_getpositions(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 4, "One to three arguments expected to celestia:getpositions()");
+    CelestiaCore* appCore = this_celestia(l);
+
+    if (!lua_istable(l, 2))
+    {
+        Celx_DoError(l, "First argument to celestia:getpositions() must be a table");
+        return 0;
+    }
+
+    double t = Celx_SafeGetNumber(l, 3, WrongType, "Second argument to celestia:getpositions() must be a number",
+                                  appCore->getSimulation()->getTime());
+
+    bool haveOrigin = false;
+    UniversalCoord origin;
+    if (lua_gettop(l) >= 4)
+    {
+        if (UniversalCoord* uc = to_position(l, 4))
+        {
+            origin = *uc;
+        }
+        else if (Selection* originSel = to_object(l, 4))
+        {
+            origin = originSel->getPosition(t);
+        }
+        else
+        {
+            Celx_DoError(l, "Third argument to celestia:getpositions() must be a position or object");
+            return 0;
+        }
+        haveOrigin = true;
+    }
+
+    // Gather the positions first so that origin-relative output can be
+    // reduced with the batch conversion instead of per-object calls.
+    std::vector<UniversalCoord> positions;
+    for (int i = 1; ; i++)
+    {
+        lua_pushinteger(l, i);
+        lua_rawget(l, 2);
+        if (lua_isnil(l, -1))
+        {
+            lua_pop(l, 1);
+            break;
+        }
+
+        Selection* sel = to_object(l, -1);
+        lua_pop(l, 1);
+        if (sel == nullptr)
+        {
+            Celx_DoError(l, "celestia:getpositions() expects a table of objects");
+            return 0;
+        }
+
+        positions.push_back(sel->getPosition(t));
+    }
+
+    lua_newtable(l);
+    int outIndex = 0;
+    if (haveOrigin)
+    {
+        std::vector<Vector3d> offsets(positions.size());
+        UniversalCoord::offsetsFromKm(positions.data(), positions.size(),
+                                      origin, offsets.data());
+        for (const auto& v : offsets)
+        {
+            lua_pushnumber(l, v.x());
+            lua_rawseti(l, -2, ++outIndex);
+            lua_pushnumber(l, v.y());
+            lua_rawseti(l, -2, ++outIndex);
+            lua_pushnumber(l, v.z());
+            lua_rawseti(l, -2, ++outIndex);
+        }
+    }
+    else
+    {
+        for (const auto& p : positions)
+        {
+            lua_pushnumber(l, (lua_Number) (double) p.x);
+            lua_rawseti(l, -2, ++outIndex);
+            lua_pushnumber(l, (lua_Number) (double) p.y);
+            lua_rawseti(l, -2, ++outIndex);
+            lua_pushnumber(l, (lua_Number) (double) p.z);
+            lua_rawseti(l, -2, ++outIndex);
+        }
+    }
+
+    return 1;
+}
+
 static int celestia_find(lua_State* l)
 {
     Celx_CheckArgs(l, 2, 2, "One argument expected for function celestia:find()");
@@ -1651,6 +1792,82 @@ static int celestia_getdso(lua_State* l)
 }
 
 
+// Push an array of DSO result objects for the spatial query methods.
+static int celestia_pushDSOResults(lua_State* l, const std::vector<DeepSkyObject*>& dsos)
+{
+    lua_createtable(l, (int) dsos.size(), 0);
+    int n = 0;
+    for (const auto dso : dsos)
+    {
+        object_new(l, Selection(dso));
+        lua_rawseti(l, -2, ++n);
+    }
+    return 1;
+}
+
+
+static int celestia_dsosincone(lua_State* l)
+{
+    Celx_CheckArgs(l, 5, 5, "Four arguments expected to function celestia:dsosincone");
+
+    CelestiaCore* appCore = this_celestia(l);
+    UniversalCoord* uc = to_position(l, 2);
+    Vector3d* dir = to_vector(l, 3);
+    if (uc == nullptr || dir == nullptr)
+    {
+        Celx_DoError(l, "First and second args to celestia:dsosincone must be a position and a vector");
+        return 0;
+    }
+    double halfAngle = Celx_SafeGetNumber(l, 4, AllErrors, "Third arg to celestia:dsosincone must be a number (degrees)");
+    double limitingMag = Celx_SafeGetNumber(l, 5, AllErrors, "Fourth arg to celestia:dsosincone must be a number");
+
+    DSODatabase* dsoDB = appCore->getSimulation()->getUniverse()->getDSOCatalog();
+    return celestia_pushDSOResults(l, dsoDB->coneSearch(uc->toLy(), *dir,
+                                                        celmath::degToRad(halfAngle),
+                                                        (float) limitingMag));
+}
+
+
+static int celestia_dsosbymagnitude(lua_State* l)
+{
+    Celx_CheckArgs(l, 4, 4, "Three arguments expected to function celestia:dsosbymagnitude");
+
+    CelestiaCore* appCore = this_celestia(l);
+    UniversalCoord* uc = to_position(l, 2);
+    if (uc == nullptr)
+    {
+        Celx_DoError(l, "First arg to celestia:dsosbymagnitude must be a position");
+        return 0;
+    }
+    double radius = Celx_SafeGetNumber(l, 3, AllErrors, "Second arg to celestia:dsosbymagnitude must be a number (light years)");
+    double faintestAbsMag = Celx_SafeGetNumber(l, 4, AllErrors, "Third arg to celestia:dsosbymagnitude must be a number");
+
+    DSODatabase* dsoDB = appCore->getSimulation()->getUniverse()->getDSOCatalog();
+    return celestia_pushDSOResults(l, dsoDB->magnitudeRangeSearch(uc->toLy(), radius,
+                                                                  (float) faintestAbsMag));
+}
+
+
+static int celestia_nearestdsos(lua_State* l)
+{
+    Celx_CheckArgs(l, 3, 3, "Two arguments expected to function celestia:nearestdsos");
+
+    CelestiaCore* appCore = this_celestia(l);
+    UniversalCoord* uc = to_position(l, 2);
+    if (uc == nullptr)
+    {
+        Celx_DoError(l, "First arg to celestia:nearestdsos must be a position");
+        return 0;
+    }
+    double k = Celx_SafeGetNumber(l, 3, AllErrors, "Second arg to celestia:nearestdsos must be a number");
+    if (k < 0.0)
+        k = 0.0;
+
+    DSODatabase* dsoDB = appCore->getSimulation()->getUniverse()->getDSOCatalog();
+    return celestia_pushDSOResults(l, dsoDB->nearestDSOs(uc->toLy(), (unsigned int) k));
+}
+
+
 static int celestia_newvector(lua_State* l)
 {
     Celx_CheckArgs(l, 4, 4, "Expected 3 arguments for celestia:newvector");
@@ -1936,6 +2153,325 @@ static int celestia_createcelscript(lua_State* l)
     return celscript_from_string(l, scripttext);
 }
 
+// celestia:perf()
+//
+// Return a table of performance counters for the most recent frame:
+// fps, framems (CPU frame time), scriptms (this script's last slice),
+// framebudgetms, and the octree traversal statistics for stars and
+// deep sky objects (starnodes/starobjects/starheight and the dso
+// equivalents). Show operators use these to certify that a script
+// stays within budget on the target hardware.
+static int celestia_perf(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(1, 1, "No arguments expected to celestia:perf()");
+    CelestiaCore* appCore = this_celestia(l);
+    LuaState* luastate = getLuaStateObject(l);
+    const Renderer* renderer = appCore->getRenderer();
+
+    lua_newtable(l);
+    celx.setTable("fps", appCore->getFPS());
+    celx.setTable("framems", appCore->getLastFrameTime() * 1000.0);
+    celx.setTable("scriptms", luastate->getLastSliceTime() * 1000.0);
+    celx.setTable("framebudgetms", appCore->getFrameBudget() * 1000.0);
+    celx.setTable("starnodes", (lua_Number) renderer->m_starProcStats.nodes);
+    celx.setTable("starobjects", (lua_Number) renderer->m_starProcStats.objects);
+    celx.setTable("starheight", (lua_Number) renderer->m_starProcStats.height);
+    celx.setTable("startraversalms", renderer->m_starProcStats.timeMs);
+    celx.setTable("dsonodes", (lua_Number) renderer->m_dsoProcStats.nodes);
+    celx.setTable("dsoobjects", (lua_Number) renderer->m_dsoProcStats.objects);
+    celx.setTable("dsoheight", (lua_Number) renderer->m_dsoProcStats.height);
+    celx.setTable("dsotraversalms", renderer->m_dsoProcStats.timeMs);
+
+    const GLStats::Counters& gl = GLStats::lastFrame();
+    celx.setTable("drawcalls", (lua_Number) gl.drawCalls);
+    celx.setTable("programchanges", (lua_Number) gl.programChanges);
+    celx.setTable("texturebinds", (lua_Number) gl.textureBinds);
+    celx.setTable("bufferuploadbytes", (lua_Number) gl.bufferUploadBytes);
+    celx.setTable("textureuploadbytes", (lua_Number) gl.textureUploadBytes);
+
+    return 1;
+}
+
+// celestia:setframebudget(milliseconds)
+//
+// Set the engine's frame time budget; frames running over it shed
+// orbit and label work until frame times recover. Zero disables the
+// mechanism and restores the configured quality settings.
+static int celestia_setframebudget(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:setframebudget()");
+    CelestiaCore* appCore = this_celestia(l);
+    double budget = Celx_SafeGetNumber(l, 2, AllErrors, "Argument to celestia:setframebudget() must be a number");
+    appCore->setFrameBudget(budget * 1.0e-3);
+    return 0;
+}
+
+// celestia:settargetfps(fps)
+//
+// Set the frame rate governor's target. While set, the 95th
+// percentile frame time is held under the target by stepping quality
+// knobs (annotation density, orbit detail, cloud layers, star
+// magnitude limit) down and back up with hysteresis. Zero disables
+// the governor and restores the configured quality settings.
+static int celestia_settargetfps(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:settargetfps()");
+    CelestiaCore* appCore = this_celestia(l);
+    double fps = Celx_SafeGetNumber(l, 2, AllErrors, "Argument to celestia:settargetfps() must be a number");
+    appCore->setTargetFrameRate(fps);
+    return 0;
+}
+
+// celestia:setscriptbudget(microseconds)
+//
+// Set the per-frame execution budget of the calling script. A script
+// exceeding the budget is preempted and continued next frame instead
+// of stalling rendering. Zero disables preemption; camera-motion
+// scripts should use that lane so their updates always complete within
+// the frame they were scheduled in.
+static int celestia_setscriptbudget(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:setscriptbudget()");
+    this_celestia(l);
+    double budget = Celx_SafeGetNumber(l, 2, AllErrors, "Argument to celestia:setscriptbudget() must be a number");
+    LuaState* luastate = getLuaStateObject(l);
+    luastate->setResumeBudget(budget * 1.0e-6);
+    return 0;
+}
+
+// celestia:addwatch(type, ...)
+//
+// Subscribe to an engine-side event. The predicate is checked in C++
+// once per tick and the callback runs only when it fires, replacing
+// tick handlers that poll every frame. Supported forms:
+//   celestia:addwatch("time", jd, callback)             -- one-shot
+//   celestia:addwatch("distance", object, km, callback)
+//   celestia:addwatch("visible", object, callback)
+//   celestia:addwatch("selection", callback)
+// Distance and visibility watches fire on every crossing of the
+// threshold; a visibility watch also fires on the first tick if the
+// target is already in view. Returns the watch id to pass to
+// celestia:removewatch(). The callback receives a table with at least
+// the fields id and type.
+static int celestia_addwatch(lua_State* l)
+{
+    Celx_CheckArgs(l, 3, 5, "Two to four arguments expected for celestia:addwatch()");
+    CelestiaCore* appCore = this_celestia(l);
+    LuaState* luastate = getLuaStateObject(l);
+    Simulation* sim = appCore->getSimulation();
+
+    string type = Celx_SafeGetString(l, 2, AllErrors, "First argument to celestia:addwatch() must be a string");
+
+    LuaState::ScriptWatch watch;
+    int callbackIndex = 0;
+
+    if (type == "time")
+    {
+        watch.kind = LuaState::ScriptWatch::TimeReached;
+        watch.threshold = Celx_SafeGetNumber(l, 3, AllErrors, "Time watch expects a julian date");
+        callbackIndex = 4;
+    }
+    else if (type == "distance")
+    {
+        watch.kind = LuaState::ScriptWatch::DistanceThreshold;
+        Selection* sel = to_object(l, 3);
+        if (sel == nullptr)
+        {
+            Celx_DoError(l, "Distance watch expects an object");
+            return 0;
+        }
+        watch.target = *sel;
+        watch.threshold = Celx_SafeGetNumber(l, 4, AllErrors, "Distance watch expects a threshold in kilometers");
+        // seed the edge detector with the current side of the threshold
+        double now = sim->getTime();
+        UniversalCoord observerPos = sim->getActiveObserver()->getPosition();
+        watch.state = watch.target.getPosition(now).offsetFromKm(observerPos).norm() < watch.threshold;
+        callbackIndex = 5;
+    }
+    else if (type == "visible")
+    {
+        watch.kind = LuaState::ScriptWatch::Visibility;
+        Selection* sel = to_object(l, 3);
+        if (sel == nullptr)
+        {
+            Celx_DoError(l, "Visibility watch expects an object");
+            return 0;
+        }
+        watch.target = *sel;
+        callbackIndex = 4;
+    }
+    else if (type == "selection")
+    {
+        watch.kind = LuaState::ScriptWatch::SelectionChanged;
+        watch.lastSelection = sim->getSelection();
+        callbackIndex = 3;
+    }
+    else
+    {
+        Celx_DoError(l, "Unknown watch type for celestia:addwatch()");
+        return 0;
+    }
+
+    if (!lua_isfunction(l, callbackIndex))
+    {
+        Celx_DoError(l, "Last argument to celestia:addwatch() must be a function");
+        return 0;
+    }
+
+    int id = luastate->addWatch(std::move(watch));
+
+    // store the callback in the watch handler registry table
+    lua_getfield(l, LUA_REGISTRYINDEX, WatchHandlers);
+    if (!lua_istable(l, -1))
+    {
+        lua_pop(l, 1);
+        lua_newtable(l);
+        lua_pushvalue(l, -1);
+        lua_setfield(l, LUA_REGISTRYINDEX, WatchHandlers);
+    }
+    lua_pushinteger(l, id);
+    lua_pushvalue(l, callbackIndex);
+    lua_settable(l, -3);
+    lua_pop(l, 1);
+
+    lua_pushinteger(l, id);
+    return 1;
+}
+
+// celestia:asyncrun(source, objects, callback)
+//
+// Run a read-only analysis script on a worker thread. The source
+// string executes in a private Lua state (base, table, string and math
+// libraries only) against a global snapshot table built here on the
+// main thread: simulation time, the active observer's field of view
+// and view direction, and for each object in the objects table its
+// name, position as a kilometer offset from the observer, distance and
+// radius. The chunk's return value (nil, booleans, numbers, strings
+// and tables of these) is handed to callback(result, error) on the
+// main thread once the job completes; any mutations belong in the
+// callback, which runs with the full celestia API. Returns the job id.
+static int celestia_asyncrun(lua_State* l)
+{
+    Celx_CheckArgs(l, 4, 4, "Three arguments expected for celestia:asyncrun()");
+    CelestiaCore* appCore = this_celestia(l);
+    LuaState* luastate = getLuaStateObject(l);
+    Simulation* sim = appCore->getSimulation();
+
+    string source = Celx_SafeGetString(l, 2, AllErrors, "First argument to celestia:asyncrun() must be a string");
+    if (!lua_istable(l, 3))
+    {
+        Celx_DoError(l, "Second argument to celestia:asyncrun() must be a table of objects");
+        return 0;
+    }
+    if (!lua_isfunction(l, 4))
+    {
+        Celx_DoError(l, "Third argument to celestia:asyncrun() must be a function");
+        return 0;
+    }
+
+    UniverseSnapshot snapshot;
+    double now = sim->getTime();
+    Observer* observer = sim->getActiveObserver();
+    UniversalCoord observerPos = observer->getPosition();
+    Eigen::Vector3d viewDir = observer->getOrientation().conjugate() * -Eigen::Vector3d::UnitZ();
+    snapshot.time = now;
+    snapshot.fov = observer->getFOV();
+    snapshot.viewX = viewDir.x();
+    snapshot.viewY = viewDir.y();
+    snapshot.viewZ = viewDir.z();
+
+    for (int i = 1; ; i++)
+    {
+        lua_pushinteger(l, i);
+        lua_rawget(l, 3);
+        if (lua_isnil(l, -1))
+        {
+            lua_pop(l, 1);
+            break;
+        }
+
+        Selection* sel = to_object(l, -1);
+        if (sel != nullptr)
+        {
+            SnapshotObject obj;
+            obj.name = sel->getName(true);
+            Eigen::Vector3d p = sel->getPosition(now).offsetFromKm(observerPos);
+            obj.x = p.x();
+            obj.y = p.y();
+            obj.z = p.z();
+            obj.distance = p.norm();
+            obj.radius = sel->radius();
+            snapshot.objects.push_back(std::move(obj));
+        }
+        lua_pop(l, 1);
+    }
+
+    int id = luastate->startAsyncJob(std::move(source), std::move(snapshot));
+
+    // store the callback in the async handler registry table
+    lua_getfield(l, LUA_REGISTRYINDEX, AsyncHandlers);
+    if (!lua_istable(l, -1))
+    {
+        lua_pop(l, 1);
+        lua_newtable(l);
+        lua_pushvalue(l, -1);
+        lua_setfield(l, LUA_REGISTRYINDEX, AsyncHandlers);
+    }
+    lua_pushinteger(l, id);
+    lua_pushvalue(l, 4);
+    lua_settable(l, -3);
+    lua_pop(l, 1);
+
+    lua_pushinteger(l, id);
+    return 1;
+}
+
+// celestia:removewatch(id)
+//
+// Cancel a watch created with celestia:addwatch(). Returns true if a
+// watch with the given id existed.
+static int celestia_removewatch(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:removewatch()");
+    this_celestia(l);
+    int id = (int) Celx_SafeGetNumber(l, 2, AllErrors, "Argument to celestia:removewatch() must be a number");
+    LuaState* luastate = getLuaStateObject(l);
+    lua_pushboolean(l, luastate->removeWatch(id) ? 1 : 0);
+    return 1;
+}
+
+// celestia:startprofile()
+//
+// Start the sampling profiler on the calling script: stack samples are
+// collected every 1000 VM instructions and wall time is attributed to
+// each crossing into a celx binding. Overhead is low enough to leave
+// running through a whole show segment.
+static int celestia_startprofile(lua_State* l)
+{
+    Celx_CheckArgs(l, 1, 1, "No argument expected for celestia:startprofile()");
+    this_celestia(l);
+    LuaState* luastate = getLuaStateObject(l);
+    luastate->startProfile();
+    return 0;
+}
+
+// celestia:stopprofile(filename)
+//
+// Stop profiling and write the report: binding call counts and
+// inclusive times as comment lines, followed by stack samples in
+// collapsed flame-graph format (feed straight to flamegraph.pl).
+// Returns true when the file was written.
+static int celestia_stopprofile(lua_State* l)
+{
+    Celx_CheckArgs(l, 2, 2, "One argument expected for celestia:stopprofile()");
+    this_celestia(l);
+    string filename = Celx_SafeGetString(l, 2, AllErrors, "Argument to celestia:stopprofile() must be a string");
+    LuaState* luastate = getLuaStateObject(l);
+    lua_pushboolean(l, luastate->stopProfile(filename) ? 1 : 0);
+    return 1;
+}
+
 static int celestia_requestsystemaccess(lua_State* l)
 {
     // ignore possible argument for future extensions
@@ -2139,6 +2675,7 @@ void CreateCelestiaMetaTable(lua_State* l)
     Celx_RegisterMethod(l, "flash", celestia_flash);
     Celx_RegisterMethod(l, "print", celestia_print);
     Celx_RegisterMethod(l, "gettextwidth", celestia_gettextwidth);
+    Celx_RegisterMethod(l, "memoryusage", celestia_memoryusage);
     Celx_RegisterMethod(l, "show", celestia_show);
     Celx_RegisterMethod(l, "setaltazimuthmode", celestia_setaltazimuthmode);
     Celx_RegisterMethod(l, "getaltazimuthmode", celestia_getaltazimuthmode);
@@ -2172,6 +2709,7 @@ void CreateCelestiaMetaTable(lua_State* l)
     Celx_RegisterMethod(l, "getobserver", celestia_getobserver);
     Celx_RegisterMethod(l, "getobservers", celestia_getobservers);
     Celx_RegisterMethod(l, "getselection", celestia_getselection);
+    Celx_RegisterMethod(l, "getpositions", celestia_getpositions);
     Celx_RegisterMethod(l, "find", celestia_find);
     Celx_RegisterMethod(l, "select", celestia_select);
     Celx_RegisterMethod(l, "mark", celestia_mark);
@@ -2209,6 +2747,9 @@ void CreateCelestiaMetaTable(lua_State* l)
     Celx_RegisterMethod(l, "getdsocount", celestia_getdsocount);
     Celx_RegisterMethod(l, "getstar", celestia_getstar);
     Celx_RegisterMethod(l, "getdso", celestia_getdso);
+    Celx_RegisterMethod(l, "dsosincone", celestia_dsosincone);
+    Celx_RegisterMethod(l, "dsosbymagnitude", celestia_dsosbymagnitude);
+    Celx_RegisterMethod(l, "nearestdsos", celestia_nearestdsos);
     Celx_RegisterMethod(l, "newframe", celestia_newframe);
     Celx_RegisterMethod(l, "newvector", celestia_newvector);
     Celx_RegisterMethod(l, "newposition", celestia_newposition);
@@ -2218,6 +2759,15 @@ void CreateCelestiaMetaTable(lua_State* l)
     Celx_RegisterMethod(l, "takescreenshot", celestia_takescreenshot);
     Celx_RegisterMethod(l, "createcelscript", celestia_createcelscript);
     Celx_RegisterMethod(l, "requestsystemaccess", celestia_requestsystemaccess);
+    Celx_RegisterMethod(l, "setscriptbudget", celestia_setscriptbudget);
+    Celx_RegisterMethod(l, "perf", celestia_perf);
+    Celx_RegisterMethod(l, "setframebudget", celestia_setframebudget);
+    Celx_RegisterMethod(l, "settargetfps", celestia_settargetfps);
+    Celx_RegisterMethod(l, "addwatch", celestia_addwatch);
+    Celx_RegisterMethod(l, "removewatch", celestia_removewatch);
+    Celx_RegisterMethod(l, "asyncrun", celestia_asyncrun);
+    Celx_RegisterMethod(l, "startprofile", celestia_startprofile);
+    Celx_RegisterMethod(l, "stopprofile", celestia_stopprofile);
     Celx_RegisterMethod(l, "getscriptpath", celestia_getscriptpath);
     Celx_RegisterMethod(l, "runscript", celestia_runscript);
     Celx_RegisterMethod(l, "registereventhandler", celestia_registereventhandler);
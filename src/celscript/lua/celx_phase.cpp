@@ -164,7 +164,7 @@ static int phase_getorientation(lua_State* l)
         tdb = phase->startTime();
     else if (tdb > phase->endTime())
         tdb = phase->endTime();
-    celx.newRotation(phase->rotationModel()->orientationAtTime(tdb));
+    celx.newRotation(phase->rotationOrientation(tdb));
 
     return 1;
 }
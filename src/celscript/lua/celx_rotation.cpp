@@ -72,6 +72,14 @@ static int rotation_add(lua_State* l)
 }
 
 
+// Fetch a rotation operand whose type the caller has already
+// established with isType(); skips the repeated metatable check.
+static Quaterniond* checked_rotation(lua_State* l, int index)
+{
+    return aligned_addr(reinterpret_cast<Quaterniond*>(lua_touserdata(l, index)));
+}
+
+
 static int rotation_mult(lua_State* l)
 {
     CelxLua celx(l);
@@ -82,14 +90,14 @@ static int rotation_mult(lua_State* l)
     lua_Number s = 0.0;
     if (celx.isType(1, Celx_Rotation) && celx.isType(2, Celx_Rotation))
     {
-        r1 = to_rotation(l, 1);
-        r2 = to_rotation(l, 2);
+        r1 = checked_rotation(l, 1);
+        r2 = checked_rotation(l, 2);
         rotation_new(l, *r1 * *r2);
     }
     else
         if (celx.isType(1, Celx_Rotation) && lua_isnumber(l, 2))
         {
-            r1 = to_rotation(l, 1);
+            r1 = checked_rotation(l, 1);
             s = lua_tonumber(l, 2);
             Quaterniond r(r1->w() * s, r1->x() * s, r1->y() * s, r1->x() * s);
             rotation_new(l, r);
@@ -98,7 +106,7 @@ static int rotation_mult(lua_State* l)
         if (lua_isnumber(l, 1) && celx.isType(2, Celx_Rotation))
         {
             s = lua_tonumber(l, 1);
-            r1 = to_rotation(l, 2);
+            r1 = checked_rotation(l, 2);
             Quaterniond r(r1->w() * s, r1->x() * s, r1->y() * s, r1->x() * s);
             rotation_new(l, r);
         }
@@ -36,6 +36,13 @@ Vector3d* to_vector(lua_State* l, int index)
     return aligned_addr(v);
 }
 
+// Fetch a vector operand whose type the caller has already established
+// with isType(); skips the metatable check that to_vector would repeat.
+static Vector3d* checked_vector(lua_State* l, int index)
+{
+    return aligned_addr(reinterpret_cast<Vector3d*>(lua_touserdata(l, index)));
+}
+
 static Vector3d* this_vector(lua_State* l)
 {
     CelxLua celx(l);
@@ -180,6 +187,26 @@ static int vector_length(lua_State* l)
     return 1;
 }
 
+// vector:set(x, y, z)
+//
+// Overwrite all three components in place and return the vector
+// itself. Lets hot loops reuse one scratch vector instead of
+// allocating a garbage-collected userdata per iteration, and replaces
+// three string-keyed __newindex dispatches with a single call.
+static int vector_setall(lua_State* l)
+{
+    CelxLua celx(l);
+
+    celx.checkArgs(4, 4, "Three arguments expected for vector:set");
+    auto v3 = this_vector(l);
+    double x = celx.safeGetNumber(2, AllErrors, "Vector components must be numbers");
+    double y = celx.safeGetNumber(3, AllErrors, "Vector components must be numbers");
+    double z = celx.safeGetNumber(4, AllErrors, "Vector components must be numbers");
+    *v3 = Vector3d(x, y, z);
+    lua_pushvalue(l, 1);
+    return 1;
+}
+
 static int vector_add(lua_State* l)
 {
     CelxLua celx(l);
@@ -191,14 +218,14 @@ static int vector_add(lua_State* l)
 
     if (celx.isType(1, Celx_Vec3) && celx.isType(2, Celx_Vec3))
     {
-        v1 = celx.toVector(1);
-        v2 = celx.toVector(2);
+        v1 = checked_vector(l, 1);
+        v2 = checked_vector(l, 2);
         celx.newVector(*v1 + *v2);
     }
     else
         if (celx.isType(1, Celx_Vec3) && celx.isType(2, Celx_Position))
         {
-            v1 = celx.toVector(1);
+            v1 = checked_vector(l, 1);
             p = celx.toPosition(2);
             celx.newPosition(p->offsetUly(*v1));
         }
@@ -220,21 +247,21 @@ static int vector_mult(lua_State* l)
     lua_Number s = 0.0;
     if (celx.isType(1, Celx_Vec3) && celx.isType(2, Celx_Vec3))
     {
-        v1 = celx.toVector(1);
-        v2 = celx.toVector(2);
+        v1 = checked_vector(l, 1);
+        v2 = checked_vector(l, 2);
         lua_pushnumber(l, (lua_Number)v1->dot(*v2));
     }
     else
         if (celx.isType(1, Celx_Vec3) && lua_isnumber(l, 2))
         {
-            v1 = celx.toVector(1);
+            v1 = checked_vector(l, 1);
             s = lua_tonumber(l, 2);
             celx.newVector(*v1 * s);
         }
     else
         if (celx.isType(1, Celx_Vec3) && celx.isType(2, Celx_Rotation))
         {
-            v1 = celx.toVector(1);
+            v1 = checked_vector(l, 1);
             q = celx.toRotation(2);
             celx.newRotation(Quaterniond(0, v1->x(), v1->y(), v1->z()) * *q);
         }
@@ -242,7 +269,7 @@ static int vector_mult(lua_State* l)
         if (lua_isnumber(l, 1) && celx.isType(2, Celx_Vec3))
         {
             s = lua_tonumber(l, 1);
-            v1 = celx.toVector(2);
+            v1 = checked_vector(l, 2);
             celx.newVector(*v1 * s);
         }
     else
@@ -261,8 +288,8 @@ static int vector_cross(lua_State* l)
     Vector3d* v2 = nullptr;
     if (celx.isType(1, Celx_Vec3) && celx.isType(2, Celx_Vec3))
     {
-        v1 = celx.toVector(1);
-        v2 = celx.toVector(2);
+        v1 = checked_vector(l, 1);
+        v2 = checked_vector(l, 2);
         celx.newVector(v1->cross(*v2));
     }
     else
@@ -297,6 +324,7 @@ void CreateVectorMetaTable(lua_State* l)
     celx.registerMethod("getz", vector_getz);
     celx.registerMethod("normalize", vector_normalize);
     celx.registerMethod("length", vector_length);
+    celx.registerMethod("set", vector_setall);
 
     lua_pop(l, 1); // remove metatable from stack
 }
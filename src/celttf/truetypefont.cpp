@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <array>
 #include <iostream>
+#include <map>
 #include <vector>
 #include <GL/glew.h>
 #include <fmt/printf.h>
@@ -61,7 +62,9 @@ struct TextureFontPrivate
     TextureFontPrivate& operator=(TextureFontPrivate&&) = default;
 
     float render(const string &s, float x, float y);
+    float render(const char* s, int length, float x, float y);
     float render(wchar_t ch, float xoffset, float yoffset);
+    const TextureFont::GlyphRun& getGlyphRun(const char* s, int length);
 
     bool buildAtlas();
     void computeTextureSize();
@@ -70,8 +73,11 @@ struct TextureFontPrivate
     int getCommonGlyphsCount();
     Glyph& getGlyph(wchar_t);
     Glyph& getGlyph(wchar_t, wchar_t);
+    float advance(wchar_t);
     int toPos(wchar_t) const;
     void optimize();
+    void addUnicodeBlock(wchar_t first, wchar_t last);
+    void flushPendingGlyphs();
 
     FT_Face m_face;         // font face
 
@@ -86,10 +92,17 @@ struct TextureFontPrivate
     vector<Glyph> m_glyphs; // character information
     GLint m_maxTextureSize; // max supported texture size
 
-    array<UnicodeBlock, 2> m_unicodeBlocks;
+    vector<UnicodeBlock> m_unicodeBlocks;
     int m_commonGlyphsCount { 0 };
 
+    // Glyphs encountered since the last atlas build; they render as
+    // the fallback glyph until the next flush folds them all into the
+    // atlas with a single rebuild.
+    vector<Glyph> m_pendingGlyphs;
+
     int m_inserted { 0 };
+
+    map<string, TextureFont::GlyphRun> m_glyphRunCache;
 };
 
 inline float pt_to_px(float pt, int dpi = 96)
@@ -104,8 +117,8 @@ inline float pt_to_px(float pt, int dpi = 96)
 
 TextureFontPrivate::TextureFontPrivate()
 {
-    m_unicodeBlocks[0] = { 0x0020, 0x007E }; // Basic Latin
-    m_unicodeBlocks[1] = { 0x03B1, 0x03CF }; // Lower case Greek
+    m_unicodeBlocks.push_back({ 0x0020, 0x007E }); // Basic Latin
+    m_unicodeBlocks.push_back({ 0x03B1, 0x03CF }); // Lower case Greek
 
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
 }
@@ -156,6 +169,32 @@ void TextureFontPrivate::initCommonGlyphs()
     }
 }
 
+// Add an inclusive Unicode range to the set of blocks that are kept
+// resident in the atlas, then rebuild it. toPos() relies on the block
+// list being sorted and disjoint, so ranges overlapping an existing
+// block are ignored. Dynamically faulted glyphs are discarded; they
+// are re-added on demand.
+void TextureFontPrivate::addUnicodeBlock(wchar_t first, wchar_t last)
+{
+    if (last < first)
+        return;
+
+    for (const auto &block : m_unicodeBlocks)
+    {
+        if (first <= block.last && last >= block.first)
+            return;
+    }
+
+    auto it = lower_bound(m_unicodeBlocks.begin(), m_unicodeBlocks.end(), first,
+                          [](const UnicodeBlock &block, wchar_t ch) { return block.first < ch; });
+    m_unicodeBlocks.insert(it, { first, last });
+
+    m_commonGlyphsCount = 0;
+    m_glyphs.clear();
+    m_pendingGlyphs.clear();
+    buildAtlas();
+}
+
 void TextureFontPrivate::computeTextureSize()
 {
     FT_GlyphSlot g = m_face->glyph;
@@ -193,6 +232,10 @@ bool TextureFontPrivate::buildAtlas()
     FT_GlyphSlot g = m_face->glyph;
     Glyph c;
 
+    // Rebuilding moves every glyph's texture coordinates, so any
+    // shaped runs pointing into the old atlas are stale.
+    m_glyphRunCache.clear();
+
     initCommonGlyphs();
     computeTextureSize();
 
@@ -316,16 +359,22 @@ Glyph& TextureFontPrivate::getGlyph(wchar_t ch)
     if (it != m_glyphs.end())
         return *it;
 
-    Glyph c;
-    if (!loadGlyphInfo(ch, c))
-        return g_badGlyph;
-
-    m_glyphs.push_back(c);
-    if (++m_inserted == 10)
-        optimize();
-    buildAtlas();
+    // Not in the atlas yet. Rebuilding it here would re-rasterize and
+    // re-upload every glyph in the middle of a frame -- with many new
+    // characters in flight (e.g. the first frame of CJK labels) that
+    // means one full rebuild per glyph. Instead queue the glyph and
+    // report a miss; the caller renders the fallback glyph until the
+    // next flush folds all pending glyphs in with a single rebuild.
+    auto pending = find_if(m_pendingGlyphs.begin(), m_pendingGlyphs.end(),
+                           [ch](Glyph &g) { return g.ch == ch; });
+    if (pending == m_pendingGlyphs.end())
+    {
+        Glyph c;
+        if (loadGlyphInfo(ch, c))
+            m_pendingGlyphs.push_back(c);
+    }
 
-    return m_glyphs.back();
+    return g_badGlyph;
 }
 
 void TextureFontPrivate::optimize()
@@ -333,28 +382,70 @@ void TextureFontPrivate::optimize()
     m_inserted = 0;
 }
 
+// Advance width of a character. Unlike texture coordinates, metrics
+// are known as soon as the glyph is loaded, so a glyph still waiting
+// for the next atlas build measures exactly even though it renders as
+// the fallback glyph until then.
+float TextureFontPrivate::advance(wchar_t ch)
+{
+    auto &g = getGlyph(ch);
+    if (g.ch == ch)
+        return g.ax;
+
+    auto it = find_if(m_pendingGlyphs.begin(), m_pendingGlyphs.end(),
+                      [ch](Glyph &p) { return p.ch == ch; });
+    if (it != m_pendingGlyphs.end())
+        return it->ax;
+
+    return getGlyph(L'?').ax;
+}
+
+// Fold all glyphs faulted in since the last atlas build into the
+// atlas. Coalescing them into one rebuild keeps the per-frame cost
+// bounded no matter how many new characters appeared at once.
+void TextureFontPrivate::flushPendingGlyphs()
+{
+    if (m_pendingGlyphs.empty())
+        return;
+
+    for (const auto &c : m_pendingGlyphs)
+    {
+        m_glyphs.push_back(c);
+        if (++m_inserted == 10)
+            optimize();
+    }
+    m_pendingGlyphs.clear();
+    buildAtlas();
+}
+
 /*
  * Render text using the currently loaded font and currently set font size.
  * Rendering starts at coordinates (x, y), z is always 0.
  * The pixel coordinates that the FreeType2 library uses are scaled by (sx, sy).
  */
 float TextureFontPrivate::render(const string &s, float x, float y)
+{
+    return render(s.data(), (int) s.length(), x, y);
+}
+
+float TextureFontPrivate::render(const char* s, int length, float x, float y)
 {
     if (m_texName == 0)
         return 0;
 
+    flushPendingGlyphs();
+
     // Use the texture containing the atlas
     glBindTexture(GL_TEXTURE_2D, m_texName);
 
     // Loop through all characters
-    int len = s.length();
     bool validChar = true;
     int i = 0;
 
-    while (i < len && validChar)
+    while (i < length && validChar)
     {
         wchar_t ch = 0;
-        validChar = UTF8Decode(s, i, ch);
+        validChar = UTF8Decode(s, i, length, ch);
         if (!validChar)
             break;
         i += UTF8EncodedSize(ch);
@@ -386,6 +477,93 @@ float TextureFontPrivate::render(const string &s, float x, float y)
     return x;
 }
 
+const TextureFont::GlyphRun& TextureFontPrivate::getGlyphRun(const char* s, int length)
+{
+    // Label strings come from catalogs and are effectively a bounded
+    // set, but guard against unbounded growth anyway.
+    if (m_glyphRunCache.size() > 16384)
+        m_glyphRunCache.clear();
+
+    string key(s, length);
+    auto iter = m_glyphRunCache.find(key);
+    if (iter != m_glyphRunCache.end())
+        return iter->second;
+
+    // First queue every missing glyph of the run, then fold them into
+    // the atlas with a single rebuild: rebuilding moves the texture
+    // coordinates of every glyph, so quads are only built once the set
+    // is stable.
+    vector<wchar_t> chars;
+    bool validChar = true;
+    int i = 0;
+    while (i < length && validChar)
+    {
+        wchar_t ch = 0;
+        validChar = UTF8Decode(s, i, length, ch);
+        if (!validChar)
+            break;
+        i += UTF8EncodedSize(ch);
+        getGlyph(ch, L'?');
+        chars.push_back(ch);
+    }
+    flushPendingGlyphs();
+
+    TextureFont::GlyphRun run;
+    float x = 0.0f;
+    float y = 0.0f;
+
+    for (wchar_t ch : chars)
+    {
+        auto& g = getGlyph(ch, L'?');
+
+        float x2 = x + g.bl;
+        float y2 = y + g.bt - g.bh;
+        float w = g.bw;
+        float h = g.bh;
+
+        x += g.ax;
+        y += g.ay;
+
+        if (!w || !h)
+            continue;
+
+        float u1 = g.tx + g.bw / m_texWidth;
+        float v1 = g.ty + g.bh / m_texHeight;
+        run.vertices.push_back({ x2,     y2,     g.tx, v1   });
+        run.vertices.push_back({ x2 + w, y2,     u1,   v1   });
+        run.vertices.push_back({ x2 + w, y2 + h, u1,   g.ty });
+        run.vertices.push_back({ x2,     y2 + h, g.tx, g.ty });
+    }
+
+    run.width = (int) x;
+    return m_glyphRunCache.emplace(std::move(key), std::move(run)).first->second;
+}
+
+
+const TextureFont::GlyphRun& TextureFont::getGlyphRun(const char* s, int length)
+{
+    return impl->getGlyphRun(s, length);
+}
+
+
+void TextureFont::renderGlyphRun(const GlyphRun& run, float xoffset, float yoffset) const
+{
+    if (run.vertices.empty())
+        return;
+
+    glPushMatrix();
+    glTranslatef(xoffset, yoffset, 0.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(GlyphVertex), &run.vertices[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(GlyphVertex), &run.vertices[0].u);
+    glDrawArrays(GL_QUADS, 0, (GLsizei) run.vertices.size());
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPopMatrix();
+}
+
+
 float TextureFontPrivate::render(wchar_t ch, float xoffset, float yoffset)
 {
 
@@ -463,6 +641,22 @@ void TextureFont::render(const string &s, float xoffset, float yoffset) const
     impl->render(s, xoffset, yoffset);
 }
 
+/**
+ * Render a byte range of UTF-8 text with the specified offset
+ *
+ * For text stored in something other than a std::string (e.g. pooled
+ * or arena-backed buffers.) Does *not* update the modelview transform.
+ *
+ * @param s -- pointer to UTF-8 encoded text
+ * @param length -- length of the text in bytes
+ * @param xoffset -- horizontal offset
+ * @param yoffset -- vertical offset
+ */
+void TextureFont::render(const char* s, int length, float xoffset, float yoffset) const
+{
+    impl->render(s, length, xoffset, yoffset);
+}
+
 /**
  * Render a string and update the modelview transform
  *
@@ -486,23 +680,33 @@ void TextureFont::render(const string& s) const
  * @return string width in pixels
  */
 int TextureFont::getWidth(const string& s) const
+{
+    return getWidth(s.data(), (int) s.length());
+}
+
+/**
+ * Calculate the width of a byte range of UTF-8 text in pixels
+ *
+ * @param s -- pointer to UTF-8 encoded text
+ * @param length -- length of the text in bytes
+ * @return string width in pixels
+ */
+int TextureFont::getWidth(const char* s, int length) const
 {
     int width = 0;
-    int len = s.length();
     bool validChar = true;
     int i = 0;
 
-    while (i < len && validChar)
+    while (i < length && validChar)
     {
         wchar_t ch = 0;
-        validChar = UTF8Decode(s, i, ch);
+        validChar = UTF8Decode(s, i, length, ch);
         if (!validChar)
             break;
 
         i += UTF8EncodedSize(ch);
 
-        auto& g = impl->getGlyph(ch, L'?');
-        width += g.ax;
+        width += impl->advance(ch);
     }
 
     return width;
@@ -545,14 +749,34 @@ int TextureFont::getTextureName() const
 
 void TextureFont::bind()
 {
+    // Binding marks the start of a batch of text drawing, so this is a
+    // safe point to fold any glyphs faulted in since the last build
+    // into the atlas.
+    impl->flushPendingGlyphs();
+
     if (impl->m_texName != 0)
         glBindTexture(GL_TEXTURE_2D, impl->m_texName);
 }
 
+/**
+ * Rasterize an inclusive Unicode range into the persistent glyph atlas
+ *
+ * Pre-rasterizing the scripts a locale's labels actually use (e.g. CJK
+ * blocks) at startup avoids faulting thousands of glyphs into the
+ * atlas during the first frames they appear on screen. Ranges are
+ * configured with the FontPreloadRanges directive in celestia.cfg.
+ *
+ * @param first -- first character of the range
+ * @param last -- last character of the range, inclusive
+ */
+void TextureFont::preloadUnicodeRange(wchar_t first, wchar_t last)
+{
+    impl->addUnicodeBlock(first, last);
+}
+
 short TextureFont::getAdvance(wchar_t ch) const
 {
-    auto& g = impl->getGlyph(ch, L'?');
-    return g.ax;
+    return (short) impl->advance(ch);
 }
 
 bool TextureFont::buildTexture()
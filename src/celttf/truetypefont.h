@@ -10,6 +10,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <celcompat/filesystem.h>
 
 struct TextureFontPrivate;
@@ -29,7 +30,36 @@ class TextureFont
     void render(wchar_t c, float xoffset, float yoffset) const;
     void render(const std::string& str, float xoffset, float yoffset) const;
 
+    // Byte-range variants, for text stored in something other than a
+    // std::string (e.g. pooled or arena-backed buffers.)
+    void render(const char* s, int length, float xoffset, float yoffset) const;
+
+    struct GlyphVertex
+    {
+        float x, y;
+        float u, v;
+    };
+
+    //! A shaped run: the resolved glyph quads of a string relative to
+    //! the pen origin, four vertices per glyph, plus the advance
+    //! width. Built once per distinct string and cached; the cache is
+    //! dropped whenever the glyph atlas is rebuilt, since that moves
+    //! every glyph's texture coordinates.
+    struct GlyphRun
+    {
+        std::vector<GlyphVertex> vertices;
+        int width{ 0 };
+    };
+
+    const GlyphRun& getGlyphRun(const char* s, int length);
+
+    //! Draw a previously shaped run at the given pen offset as a
+    //! single vertex-array submission. The font texture must already
+    //! be bound.
+    void renderGlyphRun(const GlyphRun& run, float xoffset, float yoffset) const;
+
     int getWidth(const std::string&) const;
+    int getWidth(const char* s, int length) const;
     int getWidth(int c) const;
     int getMaxWidth() const;
     int getHeight() const;
@@ -41,6 +71,12 @@ class TextureFont
 
     short getAdvance(wchar_t c) const;
 
+    //! Pre-rasterize an inclusive Unicode range into the glyph atlas,
+    //! so a locale's scripts (e.g. CJK blocks) don't fault in glyph by
+    //! glyph during the first frames labels appear. Configured via the
+    //! FontPreloadRanges directive in celestia.cfg.
+    void preloadUnicodeRange(wchar_t first, wchar_t last);
+
     int getTextureName() const;
     void bind();
     bool buildTexture();
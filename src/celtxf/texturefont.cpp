@@ -111,13 +111,18 @@ void TextureFont::render(const string& s) const
  */
 void TextureFont::render(const string& s, float xoffset, float yoffset) const
 {
-    int len = s.length();
+    render(s.data(), (int) s.length(), xoffset, yoffset);
+}
+
+
+void TextureFont::render(const char* s, int length, float xoffset, float yoffset) const
+{
     bool validChar = true;
     int i = 0;
 
-    while (i < len && validChar) {
+    while (i < length && validChar) {
         wchar_t ch = 0;
-        validChar = UTF8Decode(s, i, ch);
+        validChar = UTF8Decode(s, i, length, ch);
         i += UTF8EncodedSize(ch);
 
         render(ch, xoffset, yoffset);
@@ -130,17 +135,98 @@ void TextureFont::render(const string& s, float xoffset, float yoffset) const
 }
 
 
+void TextureFont::buildGlyphRun(const char* s, int length, GlyphRun& run) const
+{
+    bool validChar = true;
+    int i = 0;
+    float xoffset = 0.0f;
+
+    while (i < length && validChar)
+    {
+        wchar_t ch = 0;
+        validChar = UTF8Decode(s, i, length, ch);
+        i += UTF8EncodedSize(ch);
+
+        const Glyph* glyph = getGlyph(ch);
+        if (glyph == nullptr)
+            glyph = getGlyph((wchar_t) '?');
+        if (glyph == nullptr)
+            continue;
+
+        float x0 = glyph->xoff + xoffset;
+        float x1 = x0 + glyph->width;
+        float y0 = glyph->yoff;
+        float y1 = y0 + glyph->height;
+        run.vertices.push_back({ x0, y0, glyph->texCoords[0].u, glyph->texCoords[0].v });
+        run.vertices.push_back({ x1, y0, glyph->texCoords[1].u, glyph->texCoords[1].v });
+        run.vertices.push_back({ x1, y1, glyph->texCoords[2].u, glyph->texCoords[2].v });
+        run.vertices.push_back({ x0, y1, glyph->texCoords[3].u, glyph->texCoords[3].v });
+
+        xoffset += glyph->advance;
+    }
+
+    run.width = (int) xoffset;
+}
+
+
+const TextureFont::GlyphRun& TextureFont::getGlyphRun(const char* s, int length)
+{
+    // Label strings come from catalogs and are effectively a bounded
+    // set, but guard against unbounded growth anyway.
+    if (glyphRunCache.size() > 16384)
+        glyphRunCache.clear();
+
+    string key(s, length);
+    auto iter = glyphRunCache.find(key);
+    if (iter != glyphRunCache.end())
+        return iter->second;
+
+    GlyphRun run;
+    buildGlyphRun(s, length, run);
+    return glyphRunCache.emplace(std::move(key), std::move(run)).first->second;
+}
+
+
+void TextureFont::renderGlyphRun(const GlyphRun& run, float xoffset, float yoffset) const
+{
+    if (run.vertices.empty())
+        return;
+
+    glPushMatrix();
+    glTranslatef(xoffset, yoffset, 0.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(GlyphVertex), &run.vertices[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(GlyphVertex), &run.vertices[0].u);
+    glDrawArrays(GL_QUADS, 0, (GLsizei) run.vertices.size());
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPopMatrix();
+}
+
+
+void TextureFont::preloadUnicodeRange(wchar_t /* first */, wchar_t /* last */)
+{
+    // Nothing to do: a texture font's glyph set is fixed at load time.
+}
+
+
 int TextureFont::getWidth(const string& s) const
+{
+    return getWidth(s.data(), (int) s.length());
+}
+
+
+int TextureFont::getWidth(const char* s, int length) const
 {
     int width = 0;
-    int len = s.length();
     bool validChar = true;
     int i = 0;
 
-    while (i < len && validChar)
+    while (i < length && validChar)
     {
         wchar_t ch = 0;
-        validChar = UTF8Decode(s, i, ch);
+        validChar = UTF8Decode(s, i, length, ch);
         i += UTF8EncodedSize(ch);
 
         const Glyph* g = getGlyph(ch);
@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 #include <iostream>
 #include <celcompat/filesystem.h>
 
@@ -28,7 +29,35 @@ class TextureFont
     void render(wchar_t ch, float xoffset, float yoffset) const;
     void render(const std::string& s, float xoffset, float yoffset) const;
 
+    // Byte-range variants, for text stored in something other than a
+    // std::string (e.g. pooled or arena-backed buffers.)
+    void render(const char* s, int length, float xoffset, float yoffset) const;
+
+    struct GlyphVertex
+    {
+        float x, y;
+        float u, v;
+    };
+
+    //! A shaped run: the resolved glyph quads of a string relative to
+    //! the pen origin, four vertices per glyph, plus the advance
+    //! width. Built once per distinct string and cached, so repeated
+    //! labels skip the per-character UTF-8 decode and glyph lookup.
+    struct GlyphRun
+    {
+        std::vector<GlyphVertex> vertices;
+        int width{ 0 };
+    };
+
+    const GlyphRun& getGlyphRun(const char* s, int length);
+
+    //! Draw a previously shaped run at the given pen offset as a
+    //! single vertex-array submission. The font texture must already
+    //! be bound.
+    void renderGlyphRun(const GlyphRun& run, float xoffset, float yoffset) const;
+
     int getWidth(const std::string&) const;
+    int getWidth(const char* s, int length) const;
     int getWidth(int c) const;
     int getMaxWidth() const;
     int getHeight() const;
@@ -46,6 +75,11 @@ class TextureFont
         return glyph->advance;
     }
 
+    //! Accepted for interface parity with the TrueType backend; a
+    //! texture font ships every glyph it has in the .txf file, so
+    //! there is nothing to pre-rasterize.
+    void preloadUnicodeRange(wchar_t first, wchar_t last);
+
     int getTextureName() const;
 
     void bind();
@@ -82,6 +116,7 @@ class TextureFont
     void addGlyph(const Glyph&);
     const TextureFont::Glyph* getGlyph(wchar_t) const;
     void rebuildGlyphLookupTable();
+    void buildGlyphRun(const char* s, int length, GlyphRun&) const;
 
  private:
     int maxAscent{ 0 };
@@ -98,6 +133,8 @@ class TextureFont
     const Glyph** glyphLookup{ nullptr };
     unsigned int glyphLookupTableSize{ 0 };
 
+    std::map<std::string, GlyphRun> glyphRunCache;
+
  public:
     static TextureFont* load(std::istream& in);
 };
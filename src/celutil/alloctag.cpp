@@ -0,0 +1,258 @@
+// alloctag.cpp
+//
+// Allocation attribution by subsystem tag.
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "alloctag.h"
+
+using namespace std;
+
+
+namespace
+{
+
+// Tag slots use only zero-initialized storage and atomics, so the
+// allocation hooks are safe to run before any constructor and from
+// any thread.
+const unsigned int MaxTags = 16;
+const unsigned int MaxTagDepth = 16;
+
+struct TagSlot
+{
+    atomic<const char*> name;
+    atomic<uint64_t> allocations;
+    atomic<uint64_t> bytesAllocated;
+    atomic<uint64_t> liveBytes;
+    atomic<uint64_t> peakLiveBytes;
+};
+
+// Slot 0 is the implicit "untagged" bucket.
+TagSlot tagSlots[MaxTags];
+
+thread_local unsigned int tagStack[MaxTagDepth];
+thread_local unsigned int tagDepth = 0;
+
+
+// Find or claim the slot for a tag. Tags are string literals, so
+// pointer identity suffices and the set stays tiny; a linear scan is
+// fine.
+unsigned int acquireSlot(const char* tag)
+{
+    for (unsigned int i = 1; i < MaxTags; i++)
+    {
+        const char* name = tagSlots[i].name.load(memory_order_acquire);
+        if (name == tag)
+            return i;
+        if (name == nullptr)
+        {
+            const char* expected = nullptr;
+            if (tagSlots[i].name.compare_exchange_strong(expected, tag,
+                                                         memory_order_acq_rel))
+                return i;
+            if (expected == tag)
+                return i;
+        }
+    }
+    return 0;
+}
+
+unsigned int currentSlot()
+{
+    return tagDepth > 0 ? tagStack[min(tagDepth, MaxTagDepth) - 1] : 0;
+}
+
+} // end unnamed namespace
+
+
+AllocTagScope::AllocTagScope(const char* tag)
+{
+    if (tagDepth < MaxTagDepth)
+        tagStack[tagDepth] = acquireSlot(tag);
+    tagDepth++;
+}
+
+
+AllocTagScope::~AllocTagScope()
+{
+    if (tagDepth > 0)
+        tagDepth--;
+}
+
+
+#ifdef ALLOC_TAGGING
+
+namespace
+{
+
+// Every tracked block is preceded by a header recording its size and
+// tag slot; 16 bytes preserves the alignment malloc provides.
+struct BlockHeader
+{
+    uint64_t size;
+    uint32_t slot;
+    uint32_t magic;
+};
+
+const uint32_t BlockMagic = 0x43544147; // "CTAG"
+
+void* taggedAlloc(size_t size)
+{
+    void* raw = malloc(size + sizeof(BlockHeader));
+    if (raw == nullptr)
+        return nullptr;
+
+    unsigned int slot = currentSlot();
+    BlockHeader* header = (BlockHeader*) raw;
+    header->size = size;
+    header->slot = slot;
+    header->magic = BlockMagic;
+
+    TagSlot& stats = tagSlots[slot];
+    stats.allocations.fetch_add(1, memory_order_relaxed);
+    stats.bytesAllocated.fetch_add(size, memory_order_relaxed);
+    uint64_t live = stats.liveBytes.fetch_add(size, memory_order_relaxed) + size;
+    uint64_t peak = stats.peakLiveBytes.load(memory_order_relaxed);
+    while (live > peak &&
+           !stats.peakLiveBytes.compare_exchange_weak(peak, live,
+                                                      memory_order_relaxed))
+    {
+    }
+
+    return (char*) raw + sizeof(BlockHeader);
+}
+
+void taggedFree(void* p)
+{
+    if (p == nullptr)
+        return;
+
+    BlockHeader* header = (BlockHeader*) ((char*) p - sizeof(BlockHeader));
+    if (header->magic != BlockMagic)
+    {
+        // Not one of ours (allocated before the hooks were linked in,
+        // or handed over from a foreign allocator); pass it through.
+        free(p);
+        return;
+    }
+
+    tagSlots[header->slot].liveBytes.fetch_sub(header->size,
+                                               memory_order_relaxed);
+    header->magic = 0;
+    free(header);
+}
+
+} // end unnamed namespace
+
+
+void* operator new(size_t size)
+{
+    void* p = taggedAlloc(size);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    void* p = taggedAlloc(size);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    return taggedAlloc(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    return taggedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    taggedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    taggedFree(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+    taggedFree(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept
+{
+    taggedFree(p);
+}
+
+#endif // ALLOC_TAGGING
+
+
+bool AllocTracker::enabled()
+{
+#ifdef ALLOC_TAGGING
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+void AllocTracker::snapshot(vector<TagStats>& stats) const
+{
+    stats.clear();
+    for (unsigned int i = 0; i < MaxTags; i++)
+    {
+        const char* name = i == 0 ? "untagged"
+                                  : tagSlots[i].name.load(memory_order_acquire);
+        if (name == nullptr)
+            continue;
+        if (tagSlots[i].allocations.load(memory_order_relaxed) == 0)
+            continue;
+
+        TagStats entry;
+        entry.tag = name;
+        entry.allocations = tagSlots[i].allocations.load(memory_order_relaxed);
+        entry.bytesAllocated = tagSlots[i].bytesAllocated.load(memory_order_relaxed);
+        entry.liveBytes = tagSlots[i].liveBytes.load(memory_order_relaxed);
+        entry.peakLiveBytes = tagSlots[i].peakLiveBytes.load(memory_order_relaxed);
+        stats.push_back(entry);
+    }
+}
+
+
+void AllocTracker::reportMemory(MemoryLedger& ledger) const
+{
+    vector<TagStats> stats;
+    snapshot(stats);
+    for (const auto& entry : stats)
+        ledger.add("alloc", entry.tag, entry.liveBytes);
+}
+
+
+AllocTracker* GetAllocTracker()
+{
+    static AllocTracker* tracker = nullptr;
+    if (tracker == nullptr)
+    {
+        tracker = new AllocTracker();
+        GetMemoryAudit().registerReporter(tracker);
+    }
+    return tracker;
+}
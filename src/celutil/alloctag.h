@@ -0,0 +1,73 @@
+// alloctag.h
+//
+// Allocation attribution by subsystem tag.
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_ALLOCTAG_H_
+#define _CELUTIL_ALLOCTAG_H_
+
+#include <cstdint>
+#include <vector>
+#include "memaudit.h"
+
+
+/*! Scoped subsystem tag for allocation attribution. While a scope is
+ *  alive on a thread, every heap allocation made by that thread is
+ *  charged to the scope's tag; scopes nest, with the innermost tag
+ *  winning. The tag must be a string literal (the pointer identifies
+ *  the tag).
+ *
+ *  Scopes are always compiled and cost two thread-local writes; the
+ *  global operator new/delete hooks that actually feed the counters
+ *  are only built when ALLOC_TAGGING is defined (the ALLOC_TAGGING
+ *  CMake option), so release builds pay nothing for the
+ *  instrumentation points.
+ */
+class AllocTagScope
+{
+ public:
+    explicit AllocTagScope(const char* tag);
+    ~AllocTagScope();
+
+    AllocTagScope(const AllocTagScope&) = delete;
+    AllocTagScope& operator=(const AllocTagScope&) = delete;
+};
+
+
+/*! Per-tag allocation counters, reported through the memory audit
+ *  (component "alloc") so a dump correlates a frame-time spike with
+ *  the subsystem that allocated. Counts and bytes are cumulative;
+ *  live and peak track the currently outstanding footprint.
+ */
+class AllocTracker : public MemoryReporter
+{
+ public:
+    struct TagStats
+    {
+        const char* tag;
+        std::uint64_t allocations;
+        std::uint64_t bytesAllocated;
+        std::uint64_t liveBytes;
+        std::uint64_t peakLiveBytes;
+    };
+
+    //! Whether the allocation hooks were compiled in; without them
+    //! every counter stays zero.
+    static bool enabled();
+
+    void snapshot(std::vector<TagStats>& stats) const;
+
+    void reportMemory(MemoryLedger&) const override;
+};
+
+//! The process-wide tracker; registers itself with the memory audit on
+//! first use.
+AllocTracker* GetAllocTracker();
+
+#endif // _CELUTIL_ALLOCTAG_H_
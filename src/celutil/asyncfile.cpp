@@ -0,0 +1,170 @@
+// asyncfile.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Asynchronous file reading with readahead scheduling.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "asyncfile.h"
+
+using namespace std;
+
+
+static AsyncFileReader* asyncFileReader = nullptr;
+
+AsyncFileReader* GetAsyncFileReader()
+{
+    if (asyncFileReader == nullptr)
+        asyncFileReader = new AsyncFileReader();
+    return asyncFileReader;
+}
+
+
+bool AsyncFileReader::Request::wait()
+{
+    unique_lock<mutex> lock(stateMutex);
+    stateCondition.wait(lock, [this] { return state != Pending; });
+    return state == Done;
+}
+
+
+bool AsyncFileReader::Request::ready() const
+{
+    lock_guard<mutex> lock(stateMutex);
+    return state != Pending;
+}
+
+
+string AsyncFileReader::Request::takeContents()
+{
+    lock_guard<mutex> lock(stateMutex);
+    return std::move(contents);
+}
+
+
+AsyncFileReader::RequestHandle AsyncFileReader::read(const fs::path& path)
+{
+    return submit(path, true);
+}
+
+
+void AsyncFileReader::readahead(const fs::path& path)
+{
+    submit(path, false);
+}
+
+
+AsyncFileReader::RequestHandle AsyncFileReader::submit(const fs::path& path, bool demand)
+{
+    lock_guard<mutex> lock(queueMutex);
+
+    auto existing = inFlight.find(path.string());
+    if (existing != inFlight.end())
+    {
+        RequestHandle request = existing->second;
+        if (demand)
+        {
+            // Adopt a pending readahead of the same file: keep the
+            // contents and move it ahead of other speculative work.
+            lock_guard<mutex> stateLock(request->stateMutex);
+            request->discard = false;
+
+            auto queued = find(readaheadQueue.begin(), readaheadQueue.end(), request);
+            if (queued != readaheadQueue.end())
+            {
+                readaheadQueue.erase(queued);
+                demandQueue.push_back(request);
+            }
+        }
+        return request;
+    }
+
+    RequestHandle request = make_shared<Request>();
+    request->path = path;
+    request->discard = !demand;
+    inFlight[path.string()] = request;
+    if (demand)
+        demandQueue.push_back(request);
+    else
+        readaheadQueue.push_back(request);
+
+    startWorkers();
+    queueCondition.notify_one();
+
+    return request;
+}
+
+
+//! Spawn the worker pool on first use; must be called with queueMutex held
+void AsyncFileReader::startWorkers()
+{
+    unsigned int maxWorkers = max(1u, min(4u, thread::hardware_concurrency() / 2));
+    while (workerCount < maxWorkers)
+    {
+        thread(&AsyncFileReader::workerThread, this).detach();
+        workerCount++;
+    }
+}
+
+
+void AsyncFileReader::workerThread()
+{
+    for (;;)
+    {
+        RequestHandle request;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] {
+                return !demandQueue.empty() || !readaheadQueue.empty();
+            });
+
+            if (!demandQueue.empty())
+            {
+                request = demandQueue.front();
+                demandQueue.pop_front();
+            }
+            else
+            {
+                request = readaheadQueue.front();
+                readaheadQueue.pop_front();
+            }
+        }
+
+        string contents;
+        bool ok = false;
+        {
+            ifstream in(request->path.string(), ios::in | ios::binary);
+            if (in.good())
+            {
+                ostringstream buffer;
+                buffer << in.rdbuf();
+                if (!in.bad())
+                {
+                    contents = buffer.str();
+                    ok = true;
+                }
+            }
+        }
+
+        {
+            lock_guard<mutex> lock(queueMutex);
+            inFlight.erase(request->path.string());
+        }
+
+        {
+            lock_guard<mutex> stateLock(request->stateMutex);
+            if (!request->discard)
+                request->contents = std::move(contents);
+            request->state = ok ? Request::Done : Request::Failed;
+        }
+        request->stateCondition.notify_all();
+    }
+}
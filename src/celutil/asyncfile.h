@@ -0,0 +1,109 @@
+// asyncfile.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Asynchronous file reading with readahead scheduling.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_ASYNCFILE_H_
+#define _CELUTIL_ASYNCFILE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <celcompat/filesystem.h>
+
+/*! AsyncFileReader is a shared pool of I/O worker threads that reads
+ *  whole files into memory off the calling thread, so file I/O can
+ *  overlap parsing and decoding instead of serializing with them.
+ *
+ *  Requests come in two priorities. Demand reads are for data a caller
+ *  will block on shortly and are always served first; readahead reads
+ *  are hints for data expected to be needed soon and fill the idle
+ *  time between demand reads. A demand read for a path that already
+ *  has a readahead in flight attaches to it rather than reading the
+ *  file twice, so speculative and required work never duplicate I/O.
+ *
+ *  The implementation is a portable thread pool over blocking stream
+ *  reads. Platform asynchronous I/O interfaces would save the worker
+ *  threads but not change the callers, so the submission and
+ *  completion interface below deliberately exposes nothing about the
+ *  backend.
+ */
+class AsyncFileReader
+{
+ public:
+    class Request
+    {
+     public:
+        //! Block until the read finishes; returns true on success.
+        bool wait();
+
+        //! True once the read has finished, successfully or not.
+        bool ready() const;
+
+        //! Move the file contents out of the request; wait() must have
+        //! returned true first.
+        std::string takeContents();
+
+     private:
+        friend class AsyncFileReader;
+
+        enum State
+        {
+            Pending,
+            Done,
+            Failed,
+        };
+
+        fs::path path;
+        std::string contents;
+        bool discard{ false };
+        State state{ Pending };
+        mutable std::mutex stateMutex;
+        std::condition_variable stateCondition;
+    };
+
+    typedef std::shared_ptr<Request> RequestHandle;
+
+    AsyncFileReader() = default;
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    //! Queue a file for reading ahead of other pending work and return
+    //! a handle to wait on.
+    RequestHandle read(const fs::path& path);
+
+    //! Hint that a file will be wanted soon. The contents are read at
+    //! low priority and discarded, leaving the data in the OS file
+    //! cache; a later read() or stream open finds it warm. Returns
+    //! immediately.
+    void readahead(const fs::path& path);
+
+ private:
+    void startWorkers();
+    void workerThread();
+    RequestHandle submit(const fs::path& path, bool demand);
+
+    std::deque<RequestHandle> demandQueue;
+    std::deque<RequestHandle> readaheadQueue;
+    // In-flight requests by path, so a demand read can adopt a pending
+    // readahead of the same file instead of queuing a second read.
+    std::map<std::string, RequestHandle> inFlight;
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    unsigned int workerCount{ 0 };
+};
+
+//! The process-wide reader instance shared by all subsystems, created
+//! on first use.
+AsyncFileReader* GetAsyncFileReader();
+
+#endif // _CELUTIL_ASYNCFILE_H_
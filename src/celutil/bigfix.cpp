@@ -172,6 +172,39 @@ BigFix operator*(BigFix f, double d)
  *  overflow. This is not a problem in Celestia, where it is used exclusively
  *  in multiplications where one multiplicand has absolute value <= 1.0.
  */
+#ifdef CELESTIA_BIGFIX_INT128
+
+BigFix operator*(const BigFix& a, const BigFix& b)
+{
+    uint64_t ah = a.hi;
+    uint64_t al = a.lo;
+    if (a.isNegative())
+        BigFix::negate128(ah, al);
+
+    uint64_t bh = b.hi;
+    uint64_t bl = b.lo;
+    if (b.isNegative())
+        BigFix::negate128(bh, bl);
+
+    // The 64.64 product is the middle 128 bits of the 256-bit
+    // magnitude product, assembled here from the four 64x64 partial
+    // products; carries past bit 128 fall out of the result just as
+    // the discarded high words do in the limb version below.
+    unsigned __int128 mid = ((unsigned __int128) al * bl) >> 64;
+    mid += (unsigned __int128) al * bh;
+    mid += (unsigned __int128) ah * bl;
+    mid += (unsigned __int128) ah * bh << 64;
+
+    BigFix c;
+    c.lo = (uint64_t) mid;
+    c.hi = (uint64_t) (mid >> 64);
+
+    bool resultNegative = a.isNegative() != b.isNegative();
+    return resultNegative ? -c : c;
+}
+
+#else
+
 BigFix operator*(const BigFix& a, const BigFix& b)
 {
     // Multiply two fixed point values together using partial products.
@@ -242,6 +275,8 @@ BigFix operator*(const BigFix& a, const BigFix& b)
     return resultNegative ?  -c : c;
 }
 
+#endif // CELESTIA_BIGFIX_INT128
+
 
 int BigFix::sign() const
 {
@@ -18,6 +18,13 @@
 #include <string>
 #include <limits>
 
+// Use native 128-bit arithmetic where the compiler provides it (GCC
+// and Clang on 64-bit targets); the portable 32-bit limb paths remain
+// for everything else.
+#if defined(__SIZEOF_INT128__)
+#define CELESTIA_BIGFIX_INT128 1
+#endif
+
 /*! 64.64 signed fixed point numbers.
  */
 
@@ -89,12 +96,19 @@ inline BigFix BigFix::operator-() const
 
 inline BigFix BigFix::operator+=(const BigFix& a)
 {
+#ifdef CELESTIA_BIGFIX_INT128
+    unsigned __int128 s = (((unsigned __int128) hi << 64) | lo)
+                        + (((unsigned __int128) a.hi << 64) | a.lo);
+    lo = (uint64_t) s;
+    hi = (uint64_t) (s >> 64);
+#else
     lo += a.lo;
     hi += a.hi;
 
     // carry
     if (lo < a.lo)
         hi++;
+#endif
 
     return *this;
 }
@@ -102,12 +116,19 @@ inline BigFix BigFix::operator+=(const BigFix& a)
 
 inline BigFix BigFix::operator-=(const BigFix& a)
 {
+#ifdef CELESTIA_BIGFIX_INT128
+    unsigned __int128 s = (((unsigned __int128) hi << 64) | lo)
+                        - (((unsigned __int128) a.hi << 64) | a.lo);
+    lo = (uint64_t) s;
+    hi = (uint64_t) (s >> 64);
+#else
     lo -= a.lo;
     hi -= a.hi;
 
     // borrow
     if (lo > a.lo)
         hi--;
+#endif
 
     return *this;
 }
@@ -117,12 +138,19 @@ inline BigFix operator+(const BigFix& a, const BigFix& b)
 {
     BigFix c;
 
+#ifdef CELESTIA_BIGFIX_INT128
+    unsigned __int128 s = (((unsigned __int128) a.hi << 64) | a.lo)
+                        + (((unsigned __int128) b.hi << 64) | b.lo);
+    c.lo = (uint64_t) s;
+    c.hi = (uint64_t) (s >> 64);
+#else
     c.lo = a.lo + b.lo;
     c.hi = a.hi + b.hi;
 
     // carry
     if (c.lo < a.lo)
         c.hi++;
+#endif
 
     return c;
 }
@@ -132,12 +160,19 @@ inline BigFix operator-(const BigFix& a, const BigFix& b)
 {
     BigFix c;
 
+#ifdef CELESTIA_BIGFIX_INT128
+    unsigned __int128 s = (((unsigned __int128) a.hi << 64) | a.lo)
+                        - (((unsigned __int128) b.hi << 64) | b.lo);
+    c.lo = (uint64_t) s;
+    c.hi = (uint64_t) (s >> 64);
+#else
     c.lo = a.lo - b.lo;
     c.hi = a.hi - b.hi;
 
     // borrow
     if (c.lo > a.lo)
         c.hi--;
+#endif
 
     return c;
 }
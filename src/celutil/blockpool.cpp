@@ -0,0 +1,141 @@
+// blockpool.cpp
+//
+// A free-list allocator for small, frequently recycled objects.
+//
+// Copyright (C) 2008, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "blockpool.h"
+
+#include <cassert>
+#include <new>
+
+namespace
+{
+
+// Span size in bytes; one heap allocation amortizes across dozens to
+// hundreds of nodes. Node storage begins SpanHeaderSize bytes in, so
+// every node is at least 16-byte aligned for power-of-two node sizes.
+const std::size_t SpanSize = 4096;
+const std::size_t SpanHeaderSize = 16;
+
+// Size classes are powers of two from 8 bytes up to
+// SmallObjectAllocator::MaxPooledSize.
+const unsigned int MinSizeClassShift = 3;
+const unsigned int NumSizeClasses = 6;
+
+unsigned int sizeClassIndex(std::size_t size)
+{
+    unsigned int index = 0;
+    std::size_t classSize = std::size_t(1) << MinSizeClassShift;
+    while (classSize < size)
+    {
+        classSize <<= 1;
+        index++;
+    }
+    return index;
+}
+
+// Per-thread pool for a size class, created on first use and
+// deliberately never destroyed: the pools are caches for the life of
+// the thread, which sidesteps destruction order problems for
+// containers torn down during static cleanup.
+BlockPool* classPool(unsigned int index)
+{
+    static thread_local BlockPool* pools[NumSizeClasses] = {};
+    if (pools[index] == nullptr)
+        pools[index] = new BlockPool(std::size_t(1) << (MinSizeClassShift + index));
+    return pools[index];
+}
+
+} // anonymous namespace
+
+
+BlockPool::BlockPool(std::size_t nodeSize) :
+    m_nodeSize(nodeSize < sizeof(FreeNode) ? sizeof(FreeNode) : nodeSize)
+{
+}
+
+
+BlockPool::~BlockPool()
+{
+    Span* span = m_spanList;
+    while (span != nullptr)
+    {
+        Span* next = span->next;
+        ::operator delete(span);
+        span = next;
+    }
+}
+
+
+void* BlockPool::allocate()
+{
+    if (m_freeList == nullptr)
+        addSpan();
+
+    FreeNode* node = m_freeList;
+    m_freeList = node->next;
+    return node;
+}
+
+
+void BlockPool::release(void* p)
+{
+    FreeNode* node = static_cast<FreeNode*>(p);
+    node->next = m_freeList;
+    m_freeList = node;
+}
+
+
+std::size_t BlockPool::nodeSize() const
+{
+    return m_nodeSize;
+}
+
+
+// Carve a fresh span into nodes and thread them onto the free list.
+void BlockPool::addSpan()
+{
+    char* memory = static_cast<char*>(::operator new(SpanSize));
+    Span* span = reinterpret_cast<Span*>(memory);
+    span->next = m_spanList;
+    m_spanList = span;
+
+    std::size_t count = (SpanSize - SpanHeaderSize) / m_nodeSize;
+    assert(count > 0);
+    char* nodes = memory + SpanHeaderSize;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        FreeNode* node = reinterpret_cast<FreeNode*>(nodes + i * m_nodeSize);
+        node->next = m_freeList;
+        m_freeList = node;
+    }
+}
+
+
+void* SmallObjectAllocator::allocate(std::size_t size)
+{
+    if (size > MaxPooledSize)
+        return ::operator new(size);
+
+    return classPool(sizeClassIndex(size))->allocate();
+}
+
+
+// Containers using PoolAllocator must release memory on the thread
+// that allocated it; the pools are per-thread and unsynchronized.
+void SmallObjectAllocator::release(void* p, std::size_t size)
+{
+    if (size > MaxPooledSize)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    classPool(sizeClassIndex(size))->release(p);
+}
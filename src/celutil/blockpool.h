@@ -0,0 +1,123 @@
+// blockpool.h
+//
+// A free-list allocator for small, frequently recycled objects.
+//
+// Copyright (C) 2008, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_BLOCKPOOL_H_
+#define _CELUTIL_BLOCKPOOL_H_
+
+#include <cstddef>
+#include <string>
+
+/*! BlockPool hands out fixed-size nodes carved from page-sized spans,
+ *  linked through an intrusive free list. Allocation and release are a
+ *  couple of pointer moves; freed nodes are recycled, so once a process
+ *  reaches its steady-state working set the pool stops touching the
+ *  global allocator altogether. Spans are retained for the life of the
+ *  pool rather than returned piecemeal, which keeps long-uptime
+ *  processes from fragmenting the heap with interleaved small objects.
+ *
+ *  Unlike MemoryPool, which reclaims everything at once via freeAll(),
+ *  BlockPool supports freeing individual nodes, making it suitable for
+ *  objects with staggered lifetimes. A pool is not thread safe; share
+ *  one per thread (PoolAllocator below does this automatically.)
+ */
+class BlockPool
+{
+public:
+    explicit BlockPool(std::size_t nodeSize);
+    ~BlockPool();
+
+    void* allocate();
+    void release(void* p);
+
+    std::size_t nodeSize() const;
+
+private:
+    struct FreeNode
+    {
+        FreeNode* next;
+    };
+
+    struct Span
+    {
+        Span* next;
+    };
+
+    void addSpan();
+
+    std::size_t m_nodeSize;
+    FreeNode* m_freeList{ nullptr };
+    Span* m_spanList{ nullptr };
+};
+
+
+/*! Shared backing store for PoolAllocator: one BlockPool per
+ *  power-of-two size class per thread. Requests above the largest size
+ *  class fall through to the global heap. The per-thread pools live for
+ *  the life of the process, so memory handed out here may safely be
+ *  freed during static destruction.
+ */
+class SmallObjectAllocator
+{
+public:
+    static void* allocate(std::size_t size);
+    static void release(void* p, std::size_t size);
+
+    static const std::size_t MaxPooledSize = 256;
+};
+
+
+/*! PoolAllocator is an STL-compatible allocator that draws small
+ *  allocations from per-thread BlockPools via SmallObjectAllocator.
+ *  All instances are interchangeable, so it is default constructible
+ *  and containers using it can be declared without threading a pool
+ *  reference through their owners. Intended for node-based containers
+ *  and short strings that are created and destroyed at high rates,
+ *  such as per-frame label text.
+ */
+template<class T> class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() = default;
+
+    template<class U> PoolAllocator(const PoolAllocator<U>&)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(SmallObjectAllocator::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        SmallObjectAllocator::release(p, n * sizeof(T));
+    }
+};
+
+template<class T, class U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+    return true;
+}
+
+template<class T, class U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+{
+    return false;
+}
+
+
+//! std::string variant whose character storage comes from the pools.
+typedef std::basic_string<char, std::char_traits<char>, PoolAllocator<char>> PooledString;
+
+#endif // _CELUTIL_BLOCKPOOL_H_
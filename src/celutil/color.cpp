@@ -18,46 +18,6 @@ Color::ColorMap Color::x11Colors;
 const Color Color::White = Color(1.0f, 1.0f, 1.0f);
 const Color Color::Black = Color(0.0f,0.0f, 0.0f);
 
-Color::Color()
-{
-    c[Red] = c[Green] = c[Blue] = 0;
-    c[Alpha] = 0xff;
-}
-
-
-Color::Color(float r, float g, float b)
-{
-    c[Red] = (unsigned char) (clamp(r) * 255.99f);
-    c[Green] = (unsigned char) (clamp(g) * 255.99f);
-    c[Blue] = (unsigned char) (clamp(b) * 255.99f);
-    c[Alpha] = 0xff;
-}
-
-
-Color::Color(float r, float g, float b, float a)
-{
-    c[Red]   = (unsigned char) (clamp(r) * 255.99f);
-    c[Green] = (unsigned char) (clamp(g) * 255.99f);
-    c[Blue]  = (unsigned char) (clamp(b) * 255.99f);
-    c[Alpha] = (unsigned char) (clamp(a) * 255.99f);
-}
-
-
-Color::Color(unsigned char r, unsigned char g, unsigned char b) :
-    Color(r, g, b, 0xff)
-{
-}
-
-
-Color::Color(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
-{
-    c[Red] = r;
-    c[Green] = g;
-    c[Blue] = b;
-    c[Alpha] = a;
-}
-
-
 Color::Color(const Eigen::Vector3f &c) :
     Color(c.x(), c.y(), c.z())
 {
@@ -17,12 +17,49 @@
 
 class Color
 {
+ private:
+    // Component conversion helpers for the constexpr constructors;
+    // equivalent to celmath::clamp, which isn't visible from celutil.
+    static constexpr float clamp01(float x)
+    {
+        return x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+    }
+
+    static constexpr unsigned char toComponent(float x)
+    {
+        return (unsigned char) (clamp01(x) * 255.99f);
+    }
+
  public:
-    Color();
-    Color(float, float, float);
-    Color(float, float, float, float);
-    Color(unsigned char, unsigned char, unsigned char);
-    Color(unsigned char, unsigned char, unsigned char, unsigned char);
+    // The basic constructors are constexpr so that tables of colors
+    // (e.g. the star color temperature tables) can be laid down in the
+    // read-only data segment at compile time instead of being built by
+    // startup initializers.
+    constexpr Color() :
+        c{ 0, 0, 0, 0xff }
+    {
+    }
+
+    constexpr Color(float r, float g, float b) :
+        c{ toComponent(r), toComponent(g), toComponent(b), 0xff }
+    {
+    }
+
+    constexpr Color(float r, float g, float b, float a) :
+        c{ toComponent(r), toComponent(g), toComponent(b), toComponent(a) }
+    {
+    }
+
+    constexpr Color(unsigned char r, unsigned char g, unsigned char b) :
+        c{ r, g, b, 0xff }
+    {
+    }
+
+    constexpr Color(unsigned char r, unsigned char g, unsigned char b, unsigned char a) :
+        c{ r, g, b, a }
+    {
+    }
+
     Color(const Color&, float);
     Color(const Eigen::Vector3f&);
     Color(const Eigen::Vector4f&);
@@ -0,0 +1,84 @@
+// compress.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Transparent decompression of gzip compressed data files.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <fstream>
+#include <sstream>
+#include <zlib.h>
+#include "compress.h"
+
+using namespace std;
+
+
+bool IsGzipData(const char* data, size_t size)
+{
+    return size >= 2 &&
+           (unsigned char) data[0] == 0x1f &&
+           (unsigned char) data[1] == 0x8b;
+}
+
+
+bool DecompressGzipData(const char* data, size_t size, string& out)
+{
+    z_stream stream;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = (uInt) size;
+
+    // 15 window bits plus 32 enables automatic detection of gzip and
+    // zlib framing.
+    if (inflateInit2(&stream, 15 + 32) != Z_OK)
+        return false;
+
+    static const size_t chunkSize = 262144;
+    char chunk[chunkSize];
+
+    out.clear();
+    int status = Z_OK;
+    while (status == Z_OK)
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(chunk);
+        stream.avail_out = chunkSize;
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END)
+        {
+            inflateEnd(&stream);
+            return false;
+        }
+        out.append(chunk, chunkSize - stream.avail_out);
+    }
+
+    inflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+
+bool ReadPossiblyCompressedFile(const fs::path& path, string& out)
+{
+    ifstream in(path.string(), ios::in | ios::binary);
+    if (!in.good())
+        return false;
+
+    ostringstream buffer;
+    buffer << in.rdbuf();
+    if (in.bad())
+        return false;
+
+    string contents = buffer.str();
+    if (!IsGzipData(contents.data(), contents.size()))
+    {
+        out = std::move(contents);
+        return true;
+    }
+
+    return DecompressGzipData(contents.data(), contents.size(), out);
+}
@@ -0,0 +1,39 @@
+// compress.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Transparent decompression of gzip compressed data files.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_COMPRESS_H_
+#define _CELUTIL_COMPRESS_H_
+
+#include <cstddef>
+#include <string>
+#include <celcompat/filesystem.h>
+
+/*! Helpers for loaders that accept gzip compressed data files in place
+ *  of expanded ones. Compressed files keep their normal names and are
+ *  recognized by the gzip magic number, not the extension, so catalog
+ *  and resource references never change; a loader sniffs the first
+ *  bytes and inflates when required. zlib is already linked through
+ *  libpng, so accepting compressed content costs no new dependency.
+ */
+
+//! True if the buffer begins with the gzip magic number.
+bool IsGzipData(const char* data, size_t size);
+
+//! Inflate a complete gzip (or raw zlib) stream into out. Returns
+//! false if the data is corrupt or truncated.
+bool DecompressGzipData(const char* data, size_t size, std::string& out);
+
+//! Read a whole file into out, transparently inflating it when the
+//! contents are gzip compressed. Returns false if the file cannot be
+//! read or decompressed.
+bool ReadPossiblyCompressedFile(const fs::path& path, std::string& out);
+
+#endif // _CELUTIL_COMPRESS_H_
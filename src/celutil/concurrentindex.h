@@ -0,0 +1,164 @@
+// concurrentindex.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Lock-free catalog-number index for use during catalog loading.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_CONCURRENTINDEX_H_
+#define _CELUTIL_CONCURRENTINDEX_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/*! ConcurrentCatalogIndex is an insert-only hash table from catalog
+ *  number to object pointer, safe for any number of reader threads
+ *  concurrent with a single writer thread, without locks. Values are
+ *  published with a release store on the key slot, so a reader that
+ *  observes a key also observes its value. When the table fills up the
+ *  writer builds a larger copy and swaps it in atomically; retired
+ *  tables are kept until destruction or clear(), so readers can finish
+ *  probing them safely.
+ *
+ *  The key 0xffffffff (Star/DSO InvalidCatalogNumber) is reserved as
+ *  the empty slot marker and must not be inserted.
+ */
+template <class T> class ConcurrentCatalogIndex
+{
+ public:
+    ConcurrentCatalogIndex()
+    {
+        activeTable = new Table(initialCapacity);
+        retired.push_back(activeTable.load());
+    }
+
+    ~ConcurrentCatalogIndex()
+    {
+        for (auto table : retired)
+            delete table;
+    }
+
+    ConcurrentCatalogIndex(const ConcurrentCatalogIndex&) = delete;
+    ConcurrentCatalogIndex& operator=(const ConcurrentCatalogIndex&) = delete;
+
+    //! Look up a catalog number; may be called from any thread.
+    T* find(uint32_t catalogNumber) const
+    {
+        const Table* table = activeTable.load(std::memory_order_acquire);
+        size_t mask = table->capacity - 1;
+        for (size_t probe = hash(catalogNumber) & mask; ;
+             probe = (probe + 1) & mask)
+        {
+            uint32_t key = table->slots[probe].key.load(std::memory_order_acquire);
+            if (key == EmptyKey)
+                return nullptr;
+            if (key == catalogNumber)
+                return table->slots[probe].value.load(std::memory_order_relaxed);
+        }
+    }
+
+    //! Insert a new entry; only the single writer thread may call this.
+    void insert(uint32_t catalogNumber, T* value)
+    {
+        Table* table = activeTable.load(std::memory_order_relaxed);
+        if ((table->used + 1) * 4 > table->capacity * 3)
+            table = grow(table);
+
+        size_t mask = table->capacity - 1;
+        for (size_t probe = hash(catalogNumber) & mask; ;
+             probe = (probe + 1) & mask)
+        {
+            uint32_t key = table->slots[probe].key.load(std::memory_order_relaxed);
+            if (key == catalogNumber)
+            {
+                table->slots[probe].value.store(value, std::memory_order_release);
+                return;
+            }
+            if (key == EmptyKey)
+            {
+                // Publish the value before the key becomes visible.
+                table->slots[probe].value.store(value, std::memory_order_relaxed);
+                table->slots[probe].key.store(catalogNumber, std::memory_order_release);
+                ++table->used;
+                return;
+            }
+        }
+    }
+
+    //! Release all storage; no concurrent readers may be active.
+    void clear()
+    {
+        for (auto table : retired)
+            delete table;
+        retired.clear();
+        activeTable = new Table(initialCapacity);
+        retired.push_back(activeTable.load());
+    }
+
+ private:
+    static const uint32_t EmptyKey = 0xffffffffu;
+    static const size_t initialCapacity = 256;  // must be a power of two
+
+    struct Slot
+    {
+        std::atomic<uint32_t> key{ EmptyKey };
+        std::atomic<T*> value{ nullptr };
+    };
+
+    struct Table
+    {
+        Table(size_t _capacity) :
+            capacity(_capacity),
+            slots(new Slot[_capacity])
+        {
+        }
+
+        ~Table()
+        {
+            delete[] slots;
+        }
+
+        size_t capacity;
+        size_t used{ 0 };
+        Slot* slots;
+    };
+
+    static size_t hash(uint32_t key)
+    {
+        // Fibonacci hashing; catalog numbers cluster densely.
+        return (size_t) (key * 2654435769u);
+    }
+
+    Table* grow(Table* oldTable)
+    {
+        Table* newTable = new Table(oldTable->capacity * 2);
+        size_t mask = newTable->capacity - 1;
+        for (size_t i = 0; i < oldTable->capacity; ++i)
+        {
+            uint32_t key = oldTable->slots[i].key.load(std::memory_order_relaxed);
+            if (key == EmptyKey)
+                continue;
+            size_t probe = hash(key) & mask;
+            while (newTable->slots[probe].key.load(std::memory_order_relaxed) != EmptyKey)
+                probe = (probe + 1) & mask;
+            newTable->slots[probe].value.store(oldTable->slots[i].value.load(std::memory_order_relaxed),
+                                               std::memory_order_relaxed);
+            newTable->slots[probe].key.store(key, std::memory_order_relaxed);
+            ++newTable->used;
+        }
+
+        retired.push_back(newTable);
+        activeTable.store(newTable, std::memory_order_release);
+        return newTable;
+    }
+
+    std::atomic<Table*> activeTable{ nullptr };
+    std::vector<Table*> retired;
+};
+
+#endif // _CELUTIL_CONCURRENTINDEX_H_
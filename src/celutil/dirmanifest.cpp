@@ -0,0 +1,100 @@
+// dirmanifest.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Cached directory listings for resource path resolution.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "dirmanifest.h"
+
+#include <system_error>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+static DirectoryManifest* directoryManifest = nullptr;
+
+
+namespace
+{
+
+// Modification time of a directory, or 0 if it does not exist. Adding
+// or removing an entry updates the directory mtime on every platform
+// we support, which is what invalidates a cached listing.
+std::time_t directoryMTime(const fs::path& directory)
+{
+#ifdef _WIN32
+    struct _stat st;
+    if (_wstat(directory.c_str(), &st) != 0)
+        return 0;
+#else
+    struct stat st;
+    if (stat(directory.string().c_str(), &st) != 0)
+        return 0;
+#endif
+    return st.st_mtime;
+}
+
+} // namespace
+
+
+bool DirectoryManifest::exists(const fs::path& file)
+{
+    fs::path directory = file.parent_path();
+    std::string name = file.filename().string();
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    Listing& listing = getListing(directory);
+    if (listing.names.count(name) != 0)
+        return true;
+
+    // A miss may just mean the directory changed since it was
+    // enumerated; recheck the mtime so a file dropped in while running
+    // is still found.
+    std::time_t mtime = directoryMTime(directory);
+    if (mtime != listing.mtime)
+    {
+        listing.mtime = mtime;
+        enumerate(directory, listing);
+        return listing.names.count(name) != 0;
+    }
+
+    return false;
+}
+
+
+DirectoryManifest::Listing& DirectoryManifest::getListing(const fs::path& directory)
+{
+    auto iter = listings.find(directory.string());
+    if (iter != listings.end())
+        return iter->second;
+
+    Listing& listing = listings[directory.string()];
+    listing.mtime = directoryMTime(directory);
+    if (listing.mtime != 0)
+        enumerate(directory, listing);
+    return listing;
+}
+
+
+void DirectoryManifest::enumerate(const fs::path& directory, Listing& listing)
+{
+    listing.names.clear();
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec))
+        listing.names.insert(entry.path().filename().string());
+}
+
+
+DirectoryManifest* GetDirectoryManifest()
+{
+    if (directoryManifest == nullptr)
+        directoryManifest = new DirectoryManifest();
+    return directoryManifest;
+}
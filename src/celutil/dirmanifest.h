@@ -0,0 +1,53 @@
+// dirmanifest.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Cached directory listings for resource path resolution.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_DIRMANIFEST_H_
+#define _CELUTIL_DIRMANIFEST_H_
+
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <celcompat/filesystem.h>
+
+
+//! Caches the file names present in each directory consulted during
+//! resource path resolution. Texture lookup probes several directories
+//! and extensions per resource, and in a large extras tree most probes
+//! miss; answering them from a cached listing turns each probe into a
+//! hash lookup. A directory is enumerated once on first use; when a
+//! lookup misses, the directory modification time is rechecked, so
+//! files dropped in while running are still picked up at the cost of a
+//! single stat.
+class DirectoryManifest
+{
+ public:
+    //! Returns true if the named file currently exists. Thread safe.
+    bool exists(const fs::path& file);
+
+ private:
+    struct Listing
+    {
+        std::time_t mtime{ 0 };
+        std::unordered_set<std::string> names;
+    };
+
+    Listing& getListing(const fs::path& directory);
+    static void enumerate(const fs::path& directory, Listing& listing);
+
+    std::map<std::string, Listing> listings;
+    std::mutex mutex;
+};
+
+DirectoryManifest* GetDirectoryManifest();
+
+#endif // _CELUTIL_DIRMANIFEST_H_
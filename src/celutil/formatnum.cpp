@@ -18,6 +18,21 @@
 #define snprintf _snprintf
 #endif
 
+namespace
+{
+
+const double PowersOfTen[16] =
+{
+    1.0e0,  1.0e1,  1.0e2,  1.0e3,  1.0e4,  1.0e5,  1.0e6,  1.0e7,
+    1.0e8,  1.0e9,  1.0e10, 1.0e11, 1.0e12, 1.0e13, 1.0e14, 1.0e15,
+};
+
+// Largest magnitude for which value * 10^precision is guaranteed to
+// fit in a long long; beyond it the snprintf fallback is used.
+const double MaxDirectValue = 9.0e15;
+
+} // anonymous namespace
+
 FormattedNumber::FormattedNumber(double v,
                                  unsigned int _precision,
                                  unsigned int _flags) :
@@ -51,92 +66,186 @@ double FormattedNumber::getRoundedValue() const
 }
 
 
-std::ostream& operator<<(std::ostream& out, const FormattedNumber& num)
+// Number of digits to show after the decimal point.
+int FormattedNumber::fractionDigits(double roundedValue) const
 {
-    char fmt[32];
-    char buf[32];
-    char obuf[64];
     int fmtPrecision;
-    double value = num.getRoundedValue();
-    char *decimal_point = localeconv()->decimal_point;
-    char *thousands_sep = localeconv()->thousands_sep;
-    char *grouping = localeconv()->grouping;
-
-    memset(obuf, 0, sizeof(obuf));
 
-    if (num.flags & FormattedNumber::SignificantDigits)
+    if (flags & SignificantDigits)
     {
-        if (value == 0.0)
+        if (roundedValue == 0.0)
         {
             fmtPrecision = 5;
         }
         else
         {
-            fmtPrecision = (int) log10(fabs(value)) - num.precision + 1;
-            if (fabs(value) < 1.0)
+            fmtPrecision = (int) log10(fabs(roundedValue)) - precision + 1;
+            if (fabs(roundedValue) < 1.0)
                 fmtPrecision--;
             fmtPrecision = fmtPrecision > 0 ? 0 : -fmtPrecision;
         }
     }
     else
     {
-        fmtPrecision = num.precision;
+        fmtPrecision = precision;
+    }
+
+    return fmtPrecision;
+}
+
+
+/*! Format the number into the supplied buffer and return a pointer to
+ *  the start of the text (which is not necessarily the start of the
+ *  buffer.) The buffer should be FormattedNumber::BufferSize bytes.
+ *
+ *  The common case -- a value of modest magnitude with a handful of
+ *  fraction digits, i.e. every HUD readout -- is formatted by direct
+ *  digit emission from a scaled integer, with the locale's grouping
+ *  and decimal separators inserted in the same right-to-left pass.
+ *  This replaces the previous pair of snprintf calls plus a regrouping
+ *  pass, which showed up measurably in the per-frame overlay code.
+ *  Values too large for the integer path fall back to snprintf.
+ */
+const char* FormattedNumber::format(char* buf, std::size_t size) const
+{
+    double roundedValue = getRoundedValue();
+    int fmtPrecision = fractionDigits(roundedValue);
+    const struct lconv* lc = localeconv();
+    const char* decimal_point = lc->decimal_point;
+    const char* thousands_sep = lc->thousands_sep;
+    const char* grouping = lc->grouping;
+
+    // The direct path scales the value to an integer, which carries a
+    // few ulps of multiplication error. Fall back to snprintf when the
+    // value is too large for that to be exact enough, or when the
+    // scaled value sits so close to a rounding boundary that the error
+    // could flip the last digit relative to correct decimal rounding.
+    double scaledValue = fmtPrecision < 16 ? fabs(roundedValue) * PowersOfTen[fmtPrecision] : MaxDirectValue;
+    double fractional = scaledValue - floor(scaledValue);
+    if (scaledValue >= MaxDirectValue ||
+        fabs(fractional - 0.5) <= scaledValue * 1.0e-15)
+    {
+        char fmt[32];
+        snprintf(fmt, sizeof(fmt), "%%.%df", fmtPrecision);
+        snprintf(buf, size, fmt, roundedValue);
+        if ((flags & GroupThousands) == 0 || *grouping == 0)
+            return buf;
+        return groupDigits(buf, size);
     }
-    snprintf(fmt, sizeof(fmt)/sizeof(char), "%%.%df", fmtPrecision);
 
-    snprintf(buf, sizeof(buf)/sizeof(char), fmt, value);
+    bool negative = std::signbit(roundedValue);
+    long long scaled = (long long) (scaledValue + 0.5);
 
-    if (num.flags & FormattedNumber::GroupThousands)
+    // Emit right to left, starting with the fraction digits.
+    std::size_t j = size;
+    buf[--j] = '\0';
+
+    if (fmtPrecision > 0)
     {
-        const char* decimalPosition = strstr(buf, decimal_point);
-        int j = sizeof(obuf) - 1;
-        int i = strlen(buf);
-        int digitCount = 0;
-        if (decimalPosition != nullptr)
+        for (int k = 0; k < fmtPrecision; k++)
         {
-            int len = strlen(decimalPosition);
-            j -= len;
-            i -= len;
-            memcpy(obuf + j, decimalPosition, len);
-            --i;
-            --j;
+            buf[--j] = (char) ('0' + (int) (scaled % 10));
+            scaled /= 10;
         }
+        for (std::size_t k = strlen(decimal_point); k-- > 0;)
+            buf[--j] = decimal_point[k];
+    }
 
-        const char *g = grouping;
-        bool does_grouping = *g != 0;
-        while (i >= 0)
+    // Integer digits, with locale grouping applied as in the C
+    // library: group sizes advance through the grouping string, and
+    // CHAR_MAX means no further grouping.
+    const char* g = grouping;
+    bool doesGrouping = (flags & GroupThousands) != 0 && *g != 0;
+    int digitCount = 0;
+    do
+    {
+        if (doesGrouping && *g != CHAR_MAX && digitCount == *g)
         {
-            if (isdigit(buf[i]))
+            for (std::size_t k = strlen(thousands_sep); k-- > 0;)
+                buf[--j] = thousands_sep[k];
+            if (*(g + 1) != 0)
+                g++;
+            digitCount = 0;
+        }
+
+        buf[--j] = (char) ('0' + (int) (scaled % 10));
+        scaled /= 10;
+        digitCount++;
+    } while (scaled != 0);
+
+    if (negative)
+        buf[--j] = '-';
+
+    return buf + j;
+}
+
+
+// Insert the locale's thousands separators into already-formatted
+// plain decimal text, in place. Used only on the snprintf fallback
+// path; the direct path emits separators as it goes.
+const char* FormattedNumber::groupDigits(char* buf, std::size_t size) const
+{
+    char obuf[BufferSize];
+    const char* decimal_point = localeconv()->decimal_point;
+    const char* thousands_sep = localeconv()->thousands_sep;
+    const char* grouping = localeconv()->grouping;
+
+    memset(obuf, 0, sizeof(obuf));
+
+    const char* decimalPosition = strstr(buf, decimal_point);
+    int j = sizeof(obuf) - 1;
+    int i = strlen(buf);
+    int digitCount = 0;
+    if (decimalPosition != nullptr)
+    {
+        int len = strlen(decimalPosition);
+        j -= len;
+        i -= len;
+        memcpy(obuf + j, decimalPosition, len);
+        --i;
+        --j;
+    }
+
+    const char* g = grouping;
+    while (i >= 0)
+    {
+        if (isdigit(buf[i]))
+        {
+            if (*g != CHAR_MAX)
             {
-                if (does_grouping && *g != CHAR_MAX)
+                if (digitCount == *g)
                 {
-                    if (digitCount == *g)
+                    const char *c, *ts = thousands_sep;
+                    for (c = ts + strlen(ts) - 1; c >= ts; c--)
                     {
-                        const char *c, *ts = thousands_sep;
-                        for (c = ts + strlen(ts) - 1; c >= ts; c--)
-                        {
-                            obuf[j] = *c;
-                            j--;
-                        }
-                        if (*(g+1) != 0) g += 1;
-                        digitCount = 0;
+                        obuf[j] = *c;
+                        j--;
                     }
+                    if (*(g + 1) != 0)
+                        g += 1;
+                    digitCount = 0;
                 }
-                digitCount++;
             }
-
-            obuf[j] = buf[i];
-
-            j--;
-            i--;
+            digitCount++;
         }
 
-        out << (obuf + (j + 1));
-    }
-    else
-    {
-        out << buf;
+        obuf[j] = buf[i];
+        j--;
+        i--;
     }
 
+    std::size_t length = sizeof(obuf) - (std::size_t) (j + 1);
+    if (length > size)
+        length = size;
+    memcpy(buf, obuf + j + 1, length);
+    buf[length - 1] = '\0';
+    return buf;
+}
+
+
+std::ostream& operator<<(std::ostream& out, const FormattedNumber& num)
+{
+    char buf[FormattedNumber::BufferSize];
+    out << num.format(buf, sizeof(buf));
     return out;
 }
@@ -10,6 +10,7 @@
 #ifndef CELUTIL_FORMATNUM_H_
 #define CELUTIL_FORMATNUM_H_
 
+#include <cstddef>
 #include <iostream>
 
 
@@ -27,9 +28,20 @@ public:
         SignificantDigits = 0x2,
     };
 
+    // Required buffer size for format()
+    enum
+    {
+        BufferSize = 128,
+    };
+
+    const char* format(char* buf, std::size_t size) const;
+
     friend std::ostream& operator<<(std::ostream& out, const FormattedNumber& num);
 
 private:
+    int fractionDigits(double roundedValue) const;
+    const char* groupDigits(char* buf, std::size_t size) const;
+
     double value;
     unsigned int precision;
     unsigned int flags;
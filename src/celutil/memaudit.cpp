@@ -0,0 +1,91 @@
+// memaudit.cpp
+//
+// Memory usage accounting across engine subsystems.
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <ostream>
+#include "memaudit.h"
+
+
+void MemoryLedger::add(const std::string& component,
+                       const std::string& category,
+                       std::uintmax_t bytes)
+{
+    m_entries.push_back(Entry{ component, category, bytes });
+}
+
+
+std::uintmax_t MemoryLedger::total() const
+{
+    std::uintmax_t sum = 0;
+    for (const auto& entry : m_entries)
+        sum += entry.bytes;
+    return sum;
+}
+
+
+void MemoryAudit::registerReporter(const MemoryReporter* reporter)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    reporters.push_back(reporter);
+}
+
+
+void MemoryAudit::unregisterReporter(const MemoryReporter* reporter)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto iter = std::find(reporters.begin(), reporters.end(), reporter);
+    if (iter != reporters.end())
+        reporters.erase(iter);
+}
+
+
+void MemoryAudit::collect(MemoryLedger& ledger) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const MemoryReporter* reporter : reporters)
+        reporter->reportMemory(ledger);
+}
+
+
+void MemoryAudit::dump(std::ostream& out) const
+{
+    MemoryLedger ledger;
+    collect(ledger);
+
+    out << "Memory usage:\n";
+    for (const auto& entry : ledger.entries())
+    {
+        out << "  " << entry.component << '/' << entry.category
+            << ": " << entry.bytes << " bytes\n";
+    }
+    out << "Total accounted: " << ledger.total() << " bytes\n";
+    out.flush();
+}
+
+
+bool MemoryAudit::dumpIfRequested(std::ostream& out)
+{
+    // Plain load first: this runs once per tick and is almost always
+    // a no-op.
+    if (!dumpPending.load(std::memory_order_relaxed))
+        return false;
+    dumpPending.store(false, std::memory_order_relaxed);
+
+    dump(out);
+    return true;
+}
+
+
+MemoryAudit& GetMemoryAudit()
+{
+    static MemoryAudit audit;
+    return audit;
+}
@@ -0,0 +1,102 @@
+// memaudit.h
+//
+// Memory usage accounting across engine subsystems.
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_MEMAUDIT_H_
+#define _CELUTIL_MEMAUDIT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+//! A snapshot of memory usage, as component/category/bytes entries
+//! collected from the registered reporters. Figures are estimates of
+//! heap (and, where noted by the reporter, driver-side) footprint;
+//! they are for attribution, not exact allocator totals.
+class MemoryLedger
+{
+ public:
+    struct Entry
+    {
+        std::string component;
+        std::string category;
+        std::uintmax_t bytes;
+    };
+
+    void add(const std::string& component,
+             const std::string& category,
+             std::uintmax_t bytes);
+
+    const std::vector<Entry>& entries() const
+    {
+        return m_entries;
+    }
+
+    std::uintmax_t total() const;
+
+ private:
+    std::vector<Entry> m_entries;
+};
+
+
+//! Interface implemented by subsystems that can account for their
+//! memory use. reportMemory is called from the main thread and should
+//! add one entry per category of storage the subsystem owns.
+class MemoryReporter
+{
+ public:
+    virtual ~MemoryReporter() = default;
+
+    virtual void reportMemory(MemoryLedger&) const = 0;
+};
+
+
+/*! Registry of memory reporters, answering "where did the memory go"
+ *  for long-running processes. Subsystems register themselves on
+ *  construction (mirroring ResourceBudget); a snapshot can be
+ *  collected programmatically, dumped as text, or requested from a
+ *  signal handler and delivered on the next tick.
+ */
+class MemoryAudit
+{
+ public:
+    void registerReporter(const MemoryReporter*);
+    void unregisterReporter(const MemoryReporter*);
+
+    //! Gather entries from all registered reporters.
+    void collect(MemoryLedger&) const;
+
+    //! Write a formatted snapshot, one entry per line plus a total.
+    void dump(std::ostream&) const;
+
+    //! Flag that a dump should be written on the next call to
+    //! dumpIfRequested. Async-signal-safe.
+    void requestDump()
+    {
+        dumpPending.store(true, std::memory_order_relaxed);
+    }
+
+    //! Dump and return true if requestDump was called since the last
+    //! check; called once per tick from the main loop.
+    bool dumpIfRequested(std::ostream&);
+
+ private:
+    mutable std::mutex mutex;
+    std::vector<const MemoryReporter*> reporters;
+    std::atomic<bool> dumpPending{ false };
+};
+
+extern MemoryAudit& GetMemoryAudit();
+
+#endif // _CELUTIL_MEMAUDIT_H_
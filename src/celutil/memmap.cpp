@@ -0,0 +1,159 @@
+// memmap.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Read-only memory mapped file support.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "memmap.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MemoryMappedFile::map(const fs::path& path)
+{
+    unmap();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (base == nullptr)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_data = static_cast<const char*>(base);
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_file = file;
+    m_mapping = mapping;
+    return true;
+}
+
+void MemoryMappedFile::adviseRandom() const
+{
+    // No equivalent of madvise(); MapViewOfFile pages are demand-loaded
+    // without file-level readahead, which is already the behavior we want.
+}
+
+
+void MemoryMappedFile::prefetch(size_t /* offset */, size_t /* length */) const
+{
+    // PrefetchVirtualMemory() requires Windows 8; rely on demand paging.
+}
+
+
+void MemoryMappedFile::unmap()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    if (m_file != nullptr)
+        CloseHandle(m_file);
+    m_data = nullptr;
+    m_size = 0;
+    m_file = nullptr;
+    m_mapping = nullptr;
+}
+
+#else
+
+bool MemoryMappedFile::map(const fs::path& path)
+{
+    unmap();
+
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* base = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The typical access pattern for catalog files is a single
+    // sequential decode pass; let the kernel read ahead aggressively.
+    madvise(base, (size_t) st.st_size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const char*>(base);
+    m_size = (size_t) st.st_size;
+    m_fd = fd;
+    return true;
+}
+
+void MemoryMappedFile::adviseRandom() const
+{
+    if (m_data != nullptr)
+        madvise(const_cast<char*>(m_data), m_size, MADV_RANDOM);
+}
+
+
+void MemoryMappedFile::prefetch(size_t offset, size_t length) const
+{
+    if (m_data == nullptr || offset >= m_size)
+        return;
+    if (length > m_size - offset)
+        length = m_size - offset;
+
+    // madvise() requires a page aligned start address
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t misalign = offset % pageSize;
+    madvise(const_cast<char*>(m_data) + (offset - misalign),
+            length + misalign, MADV_WILLNEED);
+}
+
+
+void MemoryMappedFile::unmap()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<char*>(m_data), m_size);
+    if (m_fd != -1)
+        close(m_fd);
+    m_data = nullptr;
+    m_size = 0;
+    m_fd = -1;
+}
+
+#endif // _WIN32
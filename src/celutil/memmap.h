@@ -0,0 +1,80 @@
+// memmap.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Read-only memory mapped file support.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_MEMMAP_H_
+#define _CELUTIL_MEMMAP_H_
+
+#include <cstddef>
+#include <celcompat/filesystem.h>
+
+/*! MemoryMappedFile maps a whole file read-only into the address
+ *  space of the process. On platforms without a usable mapping
+ *  primitive the map() call simply fails and callers are expected
+ *  to fall back to stream based I/O.
+ *
+ *  The mapping is shared, so several Celestia processes reading the
+ *  same catalog file reference a single copy in the OS page cache.
+ */
+class MemoryMappedFile
+{
+ public:
+    MemoryMappedFile() = default;
+    MemoryMappedFile(const fs::path& path)
+    {
+        map(path);
+    }
+
+    ~MemoryMappedFile()
+    {
+        unmap();
+    }
+
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    bool map(const fs::path& path);
+    void unmap();
+
+    //! Tell the OS that access will be random rather than sequential,
+    //! disabling aggressive readahead so only touched pages stay resident.
+    void adviseRandom() const;
+
+    //! Ask the OS to asynchronously page in the given byte range ahead
+    //! of use. Advisory only; a no-op on platforms without support.
+    void prefetch(size_t offset, size_t length) const;
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool isValid() const
+    {
+        return m_data != nullptr;
+    }
+
+ private:
+    const char* m_data{ nullptr };
+    size_t m_size{ 0 };
+#ifdef _WIN32
+    void* m_file{ nullptr };
+    void* m_mapping{ nullptr };
+#else
+    int m_fd{ -1 };
+#endif
+};
+
+#endif // _CELUTIL_MEMMAP_H_
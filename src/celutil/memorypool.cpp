@@ -46,7 +46,7 @@ MemoryPool::MemoryPool(unsigned int alignment, unsigned int blockSize) :
 MemoryPool::~MemoryPool()
 {
     for (const auto& block : m_blockList)
-        delete block.m_memory;
+        delete[] block.m_memory;
 }
 
 
@@ -66,6 +66,7 @@ MemoryPool::allocate(unsigned int size)
     if (m_blockOffset + size > m_blockSize)
     {
         m_currentBlock++;
+        m_blockOffset = 0;
     }
 
     // See if we need to allocate a new block
@@ -14,7 +14,9 @@
 #ifndef _CELUTIL_MEMORYPOOL_H_
 #define _CELUTIL_MEMORYPOOL_H_
 
+#include <cstddef>
 #include <list>
+#include <new>
 
 class MemoryPool
 {
@@ -42,5 +44,66 @@ private:
     unsigned int m_blockOffset;
 };
 
+
+/*! ArenaAllocator is an STL-compatible allocator that draws from a
+ *  MemoryPool. deallocate() is a no-op: all memory handed out is
+ *  reclaimed at once by the pool's freeAll(). This makes it suitable
+ *  for transient containers with a well-defined lifetime, such as
+ *  scratch buffers that live for a single rendered frame. Requests too
+ *  large for the pool's block size fall back to the global heap (and
+ *  those are returned to the heap in deallocate().)
+ */
+template<class T> class ArenaAllocator
+{
+public:
+    typedef T value_type;
+
+    ArenaAllocator(MemoryPool& pool) :
+        m_pool(&pool)
+    {
+    }
+
+    template<class U> ArenaAllocator(const ArenaAllocator<U>& other) :
+        m_pool(other.pool())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        void* memory = m_pool->allocate((unsigned int) (n * sizeof(T)));
+        if (memory == nullptr)
+            memory = ::operator new(n * sizeof(T));
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        // Pool memory is reclaimed en masse by MemoryPool::freeAll();
+        // only oversize heap fallback allocations are freed here.
+        if (n * sizeof(T) > m_pool->blockSize())
+            ::operator delete(p);
+    }
+
+    MemoryPool* pool() const
+    {
+        return m_pool;
+    }
+
+private:
+    MemoryPool* m_pool;
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.pool() == b.pool();
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+    return a.pool() != b.pool();
+}
+
 #endif // _CELUTIL_MEMORYPOOL_H_
 
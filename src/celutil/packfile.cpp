@@ -0,0 +1,176 @@
+// packfile.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Packaged add-on container support.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <cstring>
+#include <fstream>
+#include "packfile.h"
+
+using namespace std;
+
+static const char PACK_MAGIC[8] = { 'C', 'E', 'L', 'P', 'A', 'C', 'K', '\0' };
+static const size_t PACK_HEADER_SIZE = sizeof(PACK_MAGIC) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+
+// The pack is read through a memory mapping, so "reading" a field is a
+// bounds check and a memcpy; the same idiom the octree cache loader
+// uses.
+template<typename T> static bool
+readField(const char* base, size_t fileSize, size_t& pos, T& value)
+{
+    if (pos + sizeof(T) > fileSize)
+        return false;
+    memcpy(&value, base + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+
+bool PackFile::open(const fs::path& path)
+{
+    valid = false;
+    directory.clear();
+    packPath = path;
+
+    if (!map.map(path))
+        return false;
+
+    const char* p = map.data();
+    size_t fileSize = map.size();
+
+    if (fileSize < PACK_HEADER_SIZE ||
+        memcmp(p, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0)
+    {
+        return false;
+    }
+
+    size_t pos = sizeof(PACK_MAGIC);
+    uint32_t version = 0;
+    uint32_t memberCount = 0;
+    uint64_t directoryOffset = 0;
+    if (!readField(p, fileSize, pos, version) ||
+        !readField(p, fileSize, pos, memberCount) ||
+        !readField(p, fileSize, pos, directoryOffset))
+    {
+        return false;
+    }
+
+    if (version != CurrentVersion || directoryOffset > fileSize)
+        return false;
+
+    pos = (size_t) directoryOffset;
+    directory.reserve(memberCount);
+    for (uint32_t i = 0; i < memberCount; i++)
+    {
+        Member member;
+        uint32_t nameLength = 0;
+        if (!readField(p, fileSize, pos, member.method) ||
+            !readField(p, fileSize, pos, member.offset) ||
+            !readField(p, fileSize, pos, member.size) ||
+            !readField(p, fileSize, pos, nameLength))
+        {
+            directory.clear();
+            return false;
+        }
+
+        if (pos + nameLength > fileSize ||
+            member.method != MethodStored ||
+            member.offset + member.size > fileSize)
+        {
+            directory.clear();
+            return false;
+        }
+
+        member.name.assign(p + pos, nameLength);
+        pos += nameLength;
+        directory.push_back(member);
+    }
+
+    valid = true;
+    return true;
+}
+
+
+const char* PackFile::memberData(const Member& member) const
+{
+    return map.data() + member.offset;
+}
+
+
+bool PackFile::readMember(const Member& member, string& contents) const
+{
+    if (!valid)
+        return false;
+
+    contents.assign(memberData(member), (size_t) member.size);
+    return true;
+}
+
+
+bool PackFile::create(const fs::path& path,
+                      const vector<pair<string, string>>& members)
+{
+    ofstream out(path.string(), ios::out | ios::binary | ios::trunc);
+    if (!out.good())
+        return false;
+
+    // Header; the directory offset is patched in once the data has
+    // been written.
+    uint32_t version = CurrentVersion;
+    uint32_t memberCount = (uint32_t) members.size();
+    uint64_t directoryOffset = 0;
+    out.write(PACK_MAGIC, sizeof(PACK_MAGIC));
+    out.write((const char*) &version, sizeof(version));
+    out.write((const char*) &memberCount, sizeof(memberCount));
+    out.write((const char*) &directoryOffset, sizeof(directoryOffset));
+
+    vector<Member> directory;
+    directory.reserve(members.size());
+
+    static const char padding[MemberAlignment] = { 0 };
+    uint64_t offset = PACK_HEADER_SIZE;
+    for (const auto& entry : members)
+    {
+        size_t pad = (size_t) ((MemberAlignment - offset % MemberAlignment) % MemberAlignment);
+        if (pad != 0)
+        {
+            out.write(padding, pad);
+            offset += pad;
+        }
+
+        out.write(entry.second.data(), entry.second.size());
+
+        Member member;
+        member.name = entry.first;
+        member.method = MethodStored;
+        member.offset = offset;
+        member.size = entry.second.size();
+        directory.push_back(member);
+
+        offset += entry.second.size();
+    }
+
+    directoryOffset = offset;
+    for (const auto& member : directory)
+    {
+        uint32_t nameLength = (uint32_t) member.name.size();
+        out.write((const char*) &member.method, sizeof(member.method));
+        out.write((const char*) &member.offset, sizeof(member.offset));
+        out.write((const char*) &member.size, sizeof(member.size));
+        out.write((const char*) &nameLength, sizeof(nameLength));
+        out.write(member.name.data(), nameLength);
+    }
+
+    // Patch the directory offset in the header.
+    out.seekp(sizeof(PACK_MAGIC) + 2 * sizeof(uint32_t), ios::beg);
+    out.write((const char*) &directoryOffset, sizeof(directoryOffset));
+
+    return out.good();
+}
@@ -0,0 +1,114 @@
+// packfile.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Packaged add-on container support.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_PACKFILE_H_
+#define _CELUTIL_PACKFILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <celcompat/filesystem.h>
+#include <celutil/memmap.h>
+
+/*! PackFile reads a Celestia add-on pack (.cpak): a single container
+ *  file replacing the thousands of loose files an extras directory
+ *  otherwise holds, so one open and one directory read stand in for a
+ *  per-file stat and open apiece -- the dominant cold start cost on
+ *  network storage.
+ *
+ *  Layout (all integers little endian, the only byte order Celestia's
+ *  binary catalog formats use):
+ *
+ *      8 bytes   magic "CELPACK\0"
+ *      uint32    format version (currently 1)
+ *      uint32    member count
+ *      uint64    central directory offset
+ *      ...       member data, each member aligned to 4096 bytes
+ *      directory, one record per member:
+ *          uint32  storage method (0 = stored uncompressed)
+ *          uint64  data offset
+ *          uint64  data size
+ *          uint32  name length
+ *          ...     name, UTF-8, '/' separated, relative to the pack
+ *
+ *  The whole pack is memory mapped and members are handed out as
+ *  pointers into the mapping, so extracting a member copies nothing
+ *  and untouched members never leave the OS page cache. Member data
+ *  is page aligned so uncompressed assets can also be mapped or
+ *  DMA-uploaded directly. The per-member storage method field leaves
+ *  room for compressed chunked members in a later version without a
+ *  format break; this tree ships no compression library, so version 1
+ *  packs are store-only.
+ */
+class PackFile
+{
+ public:
+    struct Member
+    {
+        std::string name;       // relative path, '/' separated
+        uint32_t method;        // storage method; 0 = stored
+        uint64_t offset;        // data offset within the pack
+        uint64_t size;          // data size in bytes
+    };
+
+    PackFile() = default;
+    PackFile(const fs::path& path)
+    {
+        open(path);
+    }
+
+    PackFile(const PackFile&) = delete;
+    PackFile& operator=(const PackFile&) = delete;
+
+    //! Map the pack and index its central directory. Returns false and
+    //! leaves the pack invalid if the file is missing or malformed.
+    bool open(const fs::path& path);
+
+    bool isValid() const
+    {
+        return valid;
+    }
+
+    const fs::path& path() const
+    {
+        return packPath;
+    }
+
+    const std::vector<Member>& members() const
+    {
+        return directory;
+    }
+
+    //! Pointer to a member's data within the mapping; valid for the
+    //! lifetime of the PackFile.
+    const char* memberData(const Member& member) const;
+
+    //! Copy a member's contents into a string; convenient for the
+    //! stream based catalog parsers.
+    bool readMember(const Member& member, std::string& contents) const;
+
+    //! Write a pack containing the given (name, contents) pairs.
+    static bool create(const fs::path& path,
+                       const std::vector<std::pair<std::string, std::string>>& members);
+
+    static const uint32_t CurrentVersion = 1;
+    static const uint32_t MethodStored = 0;
+    static const size_t MemberAlignment = 4096;
+
+ private:
+    MemoryMappedFile map;
+    std::vector<Member> directory;
+    fs::path packPath;
+    bool valid{ false };
+};
+
+#endif // _CELUTIL_PACKFILE_H_
@@ -0,0 +1,118 @@
+// profiler.cpp
+//
+// Copyright (C) 2018, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <cstdlib>
+#include <ostream>
+#include "profiler.h"
+
+
+PhaseProfiler::Phase* PhaseProfiler::currentPhase()
+{
+    Phase* phase = &root;
+    for (size_t index : openPhases)
+        phase = &phase->children[index];
+    return phase;
+}
+
+
+void PhaseProfiler::beginPhase(const std::string& name)
+{
+    Phase* parent = currentPhase();
+    parent->children.emplace_back();
+    parent->children.back().name = name;
+    openPhases.push_back(parent->children.size() - 1);
+    phaseStarts.push_back(timer.getTime());
+}
+
+
+void PhaseProfiler::endPhase()
+{
+    if (openPhases.empty())
+        return;
+
+    currentPhase()->seconds = timer.getTime() - phaseStarts.back();
+    openPhases.pop_back();
+    phaseStarts.pop_back();
+}
+
+
+bool PhaseProfiler::empty() const
+{
+    return root.children.empty();
+}
+
+
+void PhaseProfiler::clear()
+{
+    root.children.clear();
+    openPhases.clear();
+    phaseStarts.clear();
+}
+
+
+static void writeJSONString(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char) c < 0x20)
+            out << ' ';
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+
+void PhaseProfiler::writePhase(std::ostream& out, const Phase& phase, int depth)
+{
+    std::string indent(depth * 2, ' ');
+    out << indent << "{ \"name\": ";
+    writeJSONString(out, phase.name);
+    out << ", \"seconds\": " << phase.seconds;
+    if (!phase.children.empty())
+    {
+        out << ", \"children\": [\n";
+        for (size_t i = 0; i < phase.children.size(); i++)
+        {
+            writePhase(out, phase.children[i], depth + 1);
+            out << (i + 1 < phase.children.size() ? ",\n" : "\n");
+        }
+        out << indent << "]";
+    }
+    out << " }";
+}
+
+
+void PhaseProfiler::writeReport(std::ostream& out) const
+{
+    out << "{ \"phases\": [\n";
+    for (size_t i = 0; i < root.children.size(); i++)
+    {
+        writePhase(out, root.children[i], 1);
+        out << (i + 1 < root.children.size() ? ",\n" : "\n");
+    }
+    out << "] }\n";
+}
+
+
+PhaseProfiler* PhaseProfiler::startup()
+{
+    static PhaseProfiler* profiler = nullptr;
+    static bool checked = false;
+    if (!checked)
+    {
+        checked = true;
+        if (getenv("CELESTIA_PROFILE_STARTUP") != nullptr)
+            profiler = new PhaseProfiler();
+    }
+    return profiler;
+}
@@ -0,0 +1,83 @@
+// profiler.h
+//
+// Copyright (C) 2018, Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <celutil/timer.h>
+
+//! Hierarchical wall-clock profiler for the startup path. Phases nest:
+//! beginPhase() opens a child of the innermost open phase and endPhase()
+//! closes it, so loaders can record catalog-by-catalog timings under the
+//! phase that invoked them. The recorded tree is written as JSON so
+//! reports from different runs can be diffed mechanically.
+class PhaseProfiler
+{
+public:
+    void beginPhase(const std::string& name);
+    void endPhase();
+
+    bool empty() const;
+    void clear();
+
+    //! Write the recorded phase tree as a JSON document.
+    void writeReport(std::ostream& out) const;
+
+    //! Profiler covering CelestiaCore::initSimulation() and
+    //! initRenderer(). Returns nullptr unless profiling was requested
+    //! with the CELESTIA_PROFILE_STARTUP environment variable, whose
+    //! value names the report file ("-" for the console log).
+    static PhaseProfiler* startup();
+
+private:
+    struct Phase
+    {
+        std::string name;
+        double seconds{ 0.0 };
+        std::vector<Phase> children;
+    };
+
+    Phase* currentPhase();
+    static void writePhase(std::ostream& out, const Phase& phase, int depth);
+
+    Phase root;
+    // Index path to the innermost open phase, with its start time;
+    // indices stay valid while deeper phases grow the tree.
+    std::vector<size_t> openPhases;
+    std::vector<double> phaseStarts;
+    Timer timer;
+};
+
+
+//! Open a profiler phase for the lifetime of a scope. A null profiler
+//! is permitted and records nothing, so call sites need no checks.
+class ProfiledPhase
+{
+public:
+    ProfiledPhase(PhaseProfiler* _profiler, const std::string& name) :
+        profiler(_profiler)
+    {
+        if (profiler != nullptr)
+            profiler->beginPhase(name);
+    }
+
+    ~ProfiledPhase()
+    {
+        if (profiler != nullptr)
+            profiler->endPhase();
+    }
+
+    ProfiledPhase(const ProfiledPhase&) = delete;
+    ProfiledPhase& operator=(const ProfiledPhase&) = delete;
+
+private:
+    PhaseProfiler* profiler;
+};
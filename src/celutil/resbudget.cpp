@@ -0,0 +1,100 @@
+// resbudget.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include "resbudget.h"
+
+using namespace std;
+
+
+// Eviction age window, in frames. The first pass only touches
+// resources unused for ten seconds or so; if that doesn't get under
+// budget the window is halved down to (but never including) resources
+// used in the current or previous frame.
+static const unsigned int EvictionMaxAge = 600;
+static const unsigned int EvictionMinAge = 2;
+
+
+ResourceBudget& GetResourceBudget()
+{
+    static ResourceBudget budget;
+    return budget;
+}
+
+
+void ResourceBudget::registerManager(EvictableResourceManager* manager)
+{
+    managers.push_back(manager);
+}
+
+
+void ResourceBudget::unregisterManager(EvictableResourceManager* manager)
+{
+    managers.erase(remove(managers.begin(), managers.end(), manager),
+                   managers.end());
+}
+
+
+std::uintmax_t ResourceBudget::residentBytes() const
+{
+    uintmax_t total = 0;
+    for (const auto* manager : managers)
+        total += manager->residentBytes();
+    return total;
+}
+
+
+std::uintmax_t ResourceBudget::lookupCount() const
+{
+    uintmax_t total = 0;
+    for (const auto* manager : managers)
+        total += manager->lookupCount();
+    return total;
+}
+
+
+std::uintmax_t ResourceBudget::loadCount() const
+{
+    uintmax_t total = 0;
+    for (const auto* manager : managers)
+        total += manager->loadCount();
+    return total;
+}
+
+
+void ResourceBudget::update()
+{
+    frame++;
+
+    if (budgetBytes == 0)
+        return;
+
+    uintmax_t total = residentBytes();
+    if (total <= budgetBytes)
+        return;
+
+    nEvictionRuns++;
+
+    for (unsigned int age = EvictionMaxAge;
+         age >= EvictionMinAge && total > budgetBytes;
+         age /= 2)
+    {
+        if (frame <= age)
+            continue;
+
+        for (auto* manager : managers)
+        {
+            uintmax_t freed = manager->evictNotUsedSince(frame - age);
+            totalEvictedBytes += freed;
+            total = total > freed ? total - freed : 0;
+            if (total <= budgetBytes)
+                break;
+        }
+    }
+}
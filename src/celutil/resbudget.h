@@ -0,0 +1,102 @@
+// resbudget.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_RESBUDGET_H_
+#define _CELUTIL_RESBUDGET_H_
+
+#include <cstdint>
+#include <vector>
+
+
+//! Interface implemented by resource managers that can report and
+//! release resident resources; used by ResourceBudget to enforce a
+//! global memory budget across all managers.
+class EvictableResourceManager
+{
+ public:
+    virtual ~EvictableResourceManager() = default;
+
+    //! Approximate bytes of budget-managed resources currently loaded.
+    virtual std::uintmax_t residentBytes() const = 0;
+
+    //! Release resources whose last use predates the given frame
+    //! stamp; returns the number of bytes freed.
+    virtual std::uintmax_t evictNotUsedSince(unsigned int frame) = 0;
+
+    //! Total resource lookups, and the subset that required loading
+    //! from disk (a cold miss or a reload after eviction). The ratio
+    //! gives the cache hit rate for monitoring.
+    virtual std::uintmax_t lookupCount() const { return 0; }
+    virtual std::uintmax_t loadCount() const { return 0; }
+};
+
+
+/*! Global memory budget across the texture and geometry managers.
+ *  Resource managers stamp each resource with the current frame number
+ *  on use; once per frame, update() totals resident bytes and, when a
+ *  budget is configured and exceeded, evicts least-recently-rendered
+ *  resources by repeatedly tightening an age cutoff until the total
+ *  fits again. Evicted resources reload transparently the next time
+ *  they are rendered.
+ *
+ *  The budget is disabled (no eviction) until setBudget is called with
+ *  a nonzero value, normally from the ResourceMemoryBudget setting in
+ *  celestia.cfg.
+ */
+class ResourceBudget
+{
+ public:
+    void registerManager(EvictableResourceManager* manager);
+    void unregisterManager(EvictableResourceManager* manager);
+
+    //! Advance the frame stamp and evict if over budget; called once
+    //! per rendered frame.
+    void update();
+
+    unsigned int currentFrame() const
+    {
+        return frame;
+    }
+
+    void setBudget(std::uintmax_t bytes)
+    {
+        budgetBytes = bytes;
+    }
+
+    std::uintmax_t budget() const
+    {
+        return budgetBytes;
+    }
+
+    // Statistics for monitoring
+    std::uintmax_t residentBytes() const;
+    std::uintmax_t lookupCount() const;
+    std::uintmax_t loadCount() const;
+
+    std::uintmax_t evictedBytes() const
+    {
+        return totalEvictedBytes;
+    }
+
+    unsigned int evictionRuns() const
+    {
+        return nEvictionRuns;
+    }
+
+ private:
+    std::vector<EvictableResourceManager*> managers;
+    unsigned int frame{ 1 };
+    std::uintmax_t budgetBytes{ 0 };
+    std::uintmax_t totalEvictedBytes{ 0 };
+    unsigned int nEvictionRuns{ 0 };
+};
+
+extern ResourceBudget& GetResourceBudget();
+
+#endif // _CELUTIL_RESBUDGET_H_
@@ -12,6 +12,11 @@
 
 #include <vector>
 #include <map>
+#include <set>
+#include <cstdint>
+#include <fstream>
+#include <celutil/memaudit.h>
+#include <celutil/resbudget.h>
 #include <celutil/reshandle.h>
 #include <celcompat/filesystem.h>
 
@@ -20,6 +25,7 @@ enum ResourceState {
     ResourceNotLoaded     = 0,
     ResourceLoaded        = 1,
     ResourceLoadingFailed = 2,
+    ResourceLoading       = 3,
 };
 
 
@@ -32,22 +38,100 @@ template<class T> class ResourceInfo
     virtual fs::path resolve(const fs::path&) = 0;
     virtual T* load(const fs::path&) = 0;
 
+    /*! Resource types that return true here are loaded on a background
+     *  thread instead of through load(). While the load is in progress
+     *  the manager reports the resource as unavailable (find() returns
+     *  nullptr), so callers must be prepared to render without it.
+     */
+    virtual bool loadsAsynchronously() const { return false; }
+
+    //! Start a background load; only called when loadsAsynchronously()
+    virtual void beginLoad(const fs::path&) {}
+
+    /*! Poll a background load started with beginLoad(). Returns true
+     *  once the load has finished, with the resource (or nullptr on
+     *  failure) stored in the out parameter. Called from the thread
+     *  that owns the resource manager. Loaders are expected to have
+     *  computed contentHash on the background thread by the time this
+     *  returns true; the manager then applies content aliasing without
+     *  ever reading the file on the calling thread.
+     */
+    virtual bool tryFinishLoad(T*& res) { res = nullptr; return false; }
+
+    /*! FNV-1a hash of a file's bytes, or zero when the file cannot be
+     *  read. Used by the manager for resources that load synchronously
+     *  and by asynchronous loaders, which must call it on their
+     *  background thread.
+     */
+    static uint64_t hashFileContents(const fs::path& path)
+    {
+        std::ifstream in(path.string(), std::ios::in | std::ios::binary);
+        if (!in.good())
+            return 0;
+
+        uint64_t hash = UINT64_C(14695981039346656037);    // FNV-1a offset basis
+        char buffer[65536];
+        for (;;)
+        {
+            in.read(buffer, sizeof(buffer));
+            std::streamsize n = in.gcount();
+            if (n <= 0)
+                break;
+            for (std::streamsize i = 0; i < n; i++)
+            {
+                hash ^= (unsigned char) buffer[i];
+                hash *= UINT64_C(1099511628211);
+            }
+        }
+
+        // Reserve zero for "unknown"
+        return hash != 0 ? hash : 1;
+    }
+
+    //! Block until a load started with beginLoad() completes; only
+    //! called when loadsAsynchronously()
+    virtual void waitLoad() {}
+
+    /*! Approximate resident size of the loaded resource in bytes.
+     *  Resources reporting zero are exempt from the memory budget and
+     *  are never evicted.
+     */
+    virtual std::uintmax_t resourceSize() const { return 0; }
+
     typedef T ResourceType;
     ResourceState state;
     fs::path resolvedName;
     T* resource;
+
+    //! FNV-1a hash of the source file bytes, or zero when unknown.
+    //! Byte-identical files loaded under different paths share one
+    //! resident resource. Filled in by the manager for synchronous
+    //! resource types and by the loader's background thread for
+    //! asynchronous ones.
+    uint64_t contentHash{ 0 };
+
+    //! Frame stamp of the most recent use; see ResourceBudget
+    unsigned int lastUsed{ 0 };
 };
 
 
-template<class T> class ResourceManager
+template<class T> class ResourceManager : public EvictableResourceManager, public MemoryReporter
 {
  private:
     fs::path baseDir;
 
  public:
     ResourceManager();
-    ResourceManager(const fs::path& _baseDir) : baseDir(_baseDir) {};
-    ~ResourceManager();
+    ResourceManager(const fs::path& _baseDir) : baseDir(_baseDir)
+    {
+        GetResourceBudget().registerManager(this);
+        GetMemoryAudit().registerReporter(this);
+    };
+    ~ResourceManager()
+    {
+        GetMemoryAudit().unregisterReporter(this);
+        GetResourceBudget().unregisterManager(this);
+    };
 
     typedef typename T::ResourceType ResourceType;
 
@@ -55,6 +139,7 @@ template<class T> class ResourceManager
     typedef std::vector<T> ResourceTable;
     typedef std::map<T, ResourceHandle> ResourceHandleMap;
     typedef std::map<fs::path, ResourceType*> NameMap;
+    typedef std::map<ResourceType*, std::uintmax_t> SizeMap;
 
     typedef typename ResourceHandleMap::value_type ResourceHandleMapValue;
     typedef typename NameMap::value_type NameMapValue;
@@ -62,6 +147,46 @@ template<class T> class ResourceManager
     ResourceTable resources;
     ResourceHandleMap handles;
     NameMap loadedResources;
+    SizeMap resourceSizes;
+    std::uintmax_t residentSize{ 0 };
+    std::uintmax_t nLookups{ 0 };
+    std::uintmax_t nLoads{ 0 };
+
+    //! Resolved names with a background load in flight
+    std::set<fs::path> pendingNames;
+
+    //! Loaded resources by content hash, with the reverse map used for
+    //! cleanup at eviction. Add-ons often ship byte-identical files
+    //! under different paths; these collapse them to one resident copy.
+    std::map<uint64_t, ResourceType*> contentHashes;
+    std::map<ResourceType*, uint64_t> resourceHashes;
+
+    //! Pin counts for resources whose pointers are held outside the
+    //! re-find()-every-frame discipline (timeline phases keep orbit and
+    //! rotation model pointers for the life of a body). A pinned
+    //! resource is never evicted.
+    std::map<ResourceType*, unsigned int> pinCounts;
+
+    void registerLoaded(T& info)
+    {
+        nLoads++;
+        info.state = ResourceLoaded;
+        loadedResources.insert(NameMapValue(info.resolvedName, info.resource));
+
+        if (info.contentHash != 0 && contentHashes.count(info.contentHash) == 0)
+        {
+            contentHashes[info.contentHash] = info.resource;
+            resourceHashes[info.resource] = info.contentHash;
+        }
+
+        std::uintmax_t size = info.resourceSize();
+        if (size != 0)
+        {
+            resourceSizes[info.resource] = size;
+            residentSize += size;
+            pinCounts.insert(std::make_pair(info.resource, 0u));
+        }
+    }
 
  public:
     ResourceHandle getHandle(const T& info)
@@ -88,6 +213,9 @@ template<class T> class ResourceManager
         }
         else
         {
+            nLookups++;
+            resources[h].lastUsed = GetResourceBudget().currentFrame();
+
             if (resources[h].state == ResourceNotLoaded)
             {
                 resources[h].resolvedName = resources[h].resolve(baseDir);
@@ -98,17 +226,81 @@ template<class T> class ResourceManager
                     resources[h].resource = iter->second;
                     resources[h].state = ResourceLoaded;
                 }
+                else if (resources[h].loadsAsynchronously())
+                {
+                    // Hashing the file here would read it end to end on
+                    // this thread -- exactly the stall background loading
+                    // exists to avoid -- so the hash is computed on the
+                    // load path instead and content aliasing happens at
+                    // load completion below.
+                    if (pendingNames.count(resources[h].resolvedName) == 0)
+                    {
+                        resources[h].beginLoad(resources[h].resolvedName);
+                        pendingNames.insert(resources[h].resolvedName);
+                        resources[h].state = ResourceLoading;
+                    }
+                    // else another handle is already loading the same file;
+                    // stay in ResourceNotLoaded and pick the result out of
+                    // loadedResources on a later call.
+                }
+                else if ((resources[h].contentHash = T::hashFileContents(resources[h].resolvedName)) != 0 &&
+                         contentHashes.count(resources[h].contentHash) != 0)
+                {
+                    // A byte-identical file is already resident under
+                    // another path; alias it instead of loading a copy.
+                    resources[h].resource = contentHashes[resources[h].contentHash];
+                    resources[h].state = ResourceLoaded;
+                    loadedResources.insert(NameMapValue(resources[h].resolvedName,
+                                                        resources[h].resource));
+                }
                 else
                 {
                     resources[h].resource = resources[h].load(resources[h].resolvedName);
                     if (resources[h].resource == nullptr)
+                        resources[h].state = ResourceLoadingFailed;
+                    else
+                        registerLoaded(resources[h]);
+                }
+            }
+
+            if (resources[h].state == ResourceLoading)
+            {
+                ResourceType* res = nullptr;
+                if (resources[h].tryFinishLoad(res))
+                {
+                    pendingNames.erase(resources[h].resolvedName);
+                    if (res == nullptr)
                     {
                         resources[h].state = ResourceLoadingFailed;
                     }
                     else
                     {
-                        resources[h].state = ResourceLoaded;
-                        loadedResources.insert(NameMapValue(resources[h].resolvedName, resources[h].resource));
+                        // The loader hashed the file on its background
+                        // thread; a byte-identical file may already be
+                        // resident under another path, in which case the
+                        // fresh copy is dropped and the name aliased to
+                        // the resident resource.
+                        ResourceType* alias = nullptr;
+                        if (resources[h].contentHash != 0)
+                        {
+                            auto aliasIter = contentHashes.find(resources[h].contentHash);
+                            if (aliasIter != contentHashes.end())
+                                alias = aliasIter->second;
+                        }
+
+                        if (alias != nullptr)
+                        {
+                            delete res;
+                            resources[h].resource = alias;
+                            resources[h].state = ResourceLoaded;
+                            loadedResources.insert(NameMapValue(resources[h].resolvedName,
+                                                                resources[h].resource));
+                        }
+                        else
+                        {
+                            resources[h].resource = res;
+                            registerLoaded(resources[h]);
+                        }
                     }
                 }
             }
@@ -120,6 +312,99 @@ template<class T> class ResourceManager
         }
     }
 
+    /*! Like find(), but waits for a background load to finish instead
+     *  of returning nullptr while it is in flight. Used by callers
+     *  that need the resource immediately, such as the solar system
+     *  loader, which takes orbit and rotation model pointers at parse
+     *  time. Returns nullptr only when the load fails.
+     */
+    ResourceType* fetch(ResourceHandle h)
+    {
+        ResourceType* res = find(h);
+        if (res != nullptr || h >= (int) handles.size() || h < 0)
+            return res;
+
+        for (;;)
+        {
+            if (resources[h].state == ResourceLoading)
+            {
+                resources[h].waitLoad();
+            }
+            else if (resources[h].state == ResourceNotLoaded &&
+                     pendingNames.count(resources[h].resolvedName) != 0)
+            {
+                // Another handle owns the in-flight load of the same
+                // file; wait on that handle and let its find() register
+                // the result, which this handle then aliases.
+                ResourceHandle owner = -1;
+                for (int i = 0; i < (int) resources.size(); i++)
+                {
+                    if (resources[i].state == ResourceLoading &&
+                        resources[i].resolvedName == resources[h].resolvedName)
+                    {
+                        owner = i;
+                        break;
+                    }
+                }
+                if (owner < 0)
+                    return nullptr;
+                resources[owner].waitLoad();
+                find(owner);
+            }
+            else
+            {
+                return nullptr;
+            }
+
+            res = find(h);
+            if (res != nullptr || resources[h].state == ResourceLoadingFailed)
+                return res;
+        }
+    }
+
+    /*! Start loading a resource in the background without waiting for
+     *  the result; a later find() or fetch() picks up the finished
+     *  load. No effect on resources that load synchronously or are
+     *  already loaded.
+     */
+    void prefetch(ResourceHandle h)
+    {
+        if (h >= (int) handles.size() || h < 0)
+            return;
+
+        T& info = resources[h];
+        if (info.state != ResourceNotLoaded || !info.loadsAsynchronously())
+            return;
+
+        info.resolvedName = info.resolve(baseDir);
+        if (loadedResources.count(info.resolvedName) != 0 ||
+            pendingNames.count(info.resolvedName) != 0)
+            return;
+
+        info.beginLoad(info.resolvedName);
+        pendingNames.insert(info.resolvedName);
+        info.state = ResourceLoading;
+    }
+
+    /*! Pin a resource against eviction. Pointers that this manager
+     *  does not own are ignored, so callers need not distinguish
+     *  managed resources from ones they created themselves.
+     */
+    void addRef(ResourceType* res)
+    {
+        typename std::map<ResourceType*, unsigned int>::iterator iter = pinCounts.find(res);
+        if (iter != pinCounts.end())
+            iter->second++;
+    }
+
+    //! Drop a pin taken with addRef(); ignored for unmanaged pointers.
+    void release(ResourceType* res)
+    {
+        typename std::map<ResourceType*, unsigned int>::iterator iter = pinCounts.find(res);
+        if (iter != pinCounts.end() && iter->second > 0)
+            iter->second--;
+    }
+
     const T* getResourceInfo(ResourceHandle h)
     {
         if (h >= (int) handles.size() || h < 0)
@@ -127,6 +412,116 @@ template<class T> class ResourceManager
         else
             return &resources[h];
     }
+
+    std::uintmax_t residentBytes() const override
+    {
+        return residentSize;
+    }
+
+    std::uintmax_t lookupCount() const override
+    {
+        return nLookups;
+    }
+
+    std::uintmax_t loadCount() const override
+    {
+        return nLoads;
+    }
+
+    //! MemoryReporter: resident resource bytes plus the lookup tables.
+    //! The component name is the manager's base directory ("textures",
+    //! "models", ...). Map nodes are estimated at the value size plus
+    //! four pointers of tree overhead.
+    void reportMemory(MemoryLedger& ledger) const override
+    {
+        std::string component = baseDir.string();
+        ledger.add(component, "resident", residentSize);
+
+        std::uintmax_t tableBytes = resources.capacity() * sizeof(T);
+        tableBytes += handles.size() * (sizeof(ResourceHandleMapValue) + 4 * sizeof(void*));
+        tableBytes += loadedResources.size() * (sizeof(NameMapValue) + 4 * sizeof(void*));
+        ledger.add(component, "index", tableBytes);
+    }
+
+    /*! Release budget-managed resources whose most recent use by any
+     *  handle predates the given frame stamp. Callers that hold
+     *  resource pointers across frames must re-find() them each frame,
+     *  which is how the renderer already uses these managers.
+     */
+    std::uintmax_t evictNotUsedSince(unsigned int frame) override
+    {
+        // A resource can be shared by several handles; its effective
+        // stamp is the newest among them.
+        std::map<ResourceType*, unsigned int> newest;
+        for (const auto& info : resources)
+        {
+            if (info.state == ResourceLoaded && info.resource != nullptr)
+            {
+                auto iter = newest.find(info.resource);
+                if (iter == newest.end() || iter->second < info.lastUsed)
+                    newest[info.resource] = info.lastUsed;
+            }
+        }
+
+        std::uintmax_t freed = 0;
+        std::set<ResourceType*> evicted;
+        for (typename SizeMap::iterator sizeIter = resourceSizes.begin();
+             sizeIter != resourceSizes.end();)
+        {
+            ResourceType* res = sizeIter->first;
+
+            auto newestIter = newest.find(res);
+            unsigned int stamp = newestIter != newest.end() ? newestIter->second : 0;
+            if (stamp >= frame)
+            {
+                ++sizeIter;
+                continue;
+            }
+
+            auto pinIter = pinCounts.find(res);
+            if (pinIter != pinCounts.end() && pinIter->second > 0)
+            {
+                ++sizeIter;
+                continue;
+            }
+
+            for (auto& info : resources)
+            {
+                if (info.resource == res)
+                {
+                    info.resource = nullptr;
+                    info.state = ResourceNotLoaded;
+                }
+            }
+
+            auto hashIter = resourceHashes.find(res);
+            if (hashIter != resourceHashes.end())
+            {
+                contentHashes.erase(hashIter->second);
+                resourceHashes.erase(hashIter);
+            }
+
+            pinCounts.erase(res);
+            delete res;
+            evicted.insert(res);
+            freed += sizeIter->second;
+            residentSize -= sizeIter->second;
+            sizeIter = resourceSizes.erase(sizeIter);
+        }
+
+        // A content-aliased resource can be registered under several
+        // names; drop every name that referred to an evicted resource.
+        for (typename NameMap::iterator iter = loadedResources.begin();
+             iter != loadedResources.end();)
+        {
+            if (evicted.count(iter->second) != 0)
+                iter = loadedResources.erase(iter);
+            else
+                ++iter;
+        }
+
+        return freed;
+    }
 };
 
 #endif // _CELUTIL_RESMANAGER_H_
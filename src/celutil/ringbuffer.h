@@ -0,0 +1,80 @@
+// ringbuffer.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Fixed-capacity lock-free single-producer/single-consumer queue.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#ifndef _CELUTIL_RINGBUFFER_H_
+#define _CELUTIL_RINGBUFFER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*! SPSCRingBuffer is a bounded queue that is safe for one producer
+ *  thread and one consumer thread without locks: the producer only
+ *  writes the tail index and the consumer only writes the head index,
+ *  each published with a release store and read by the other side with
+ *  an acquire load. Capacity is rounded up to a power of two so the
+ *  indexes can wrap with a mask.
+ */
+template<class T> class SPSCRingBuffer
+{
+ public:
+    explicit SPSCRingBuffer(std::size_t capacity)
+    {
+        std::size_t rounded = 1;
+        while (rounded < capacity)
+            rounded <<= 1;
+        m_items.resize(rounded);
+        m_mask = rounded - 1;
+    }
+
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+    //! Append an item; returns false when the buffer is full. Producer
+    //! thread only.
+    bool push(const T& item)
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+            return false;
+
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Remove the oldest item; returns false when the buffer is empty.
+    //! Consumer thread only.
+    bool pop(T& item)
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) ==
+               m_tail.load(std::memory_order_acquire);
+    }
+
+ private:
+    std::vector<T> m_items;
+    std::size_t m_mask{ 0 };
+    std::atomic<std::size_t> m_head{ 0 };
+    std::atomic<std::size_t> m_tail{ 0 };
+};
+
+#endif // _CELUTIL_RINGBUFFER_H_
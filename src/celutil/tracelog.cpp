@@ -0,0 +1,240 @@
+// tracelog.cpp
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include "tracelog.h"
+#include "ringbuffer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+
+namespace
+{
+
+// Events per thread ring. At one span (two events) per instrumented
+// site per frame this covers several seconds of backlog before the
+// drain thread must catch up.
+const size_t TraceRingSize = 16384;
+
+struct TraceEvent
+{
+    uint64_t ns;
+    uint32_t site;
+    uint8_t phase;
+};
+
+// One ring per producer thread. Buffers are created on a thread's
+// first event and kept for the life of the process (the drain thread
+// may still be consuming a ring after its producer exits), so the
+// total is bounded by the number of distinct threads that ever trace.
+struct TraceBuffer
+{
+    TraceBuffer(unsigned int _tid) :
+        ring(TraceRingSize),
+        tid(_tid)
+    {
+    }
+
+    SPSCRingBuffer<TraceEvent> ring;
+    unsigned int tid;
+    // Written by the producer, read by the drain thread at shutdown;
+    // an approximate count is fine.
+    atomic<uint64_t> dropped{ 0 };
+};
+
+// Guards the site and buffer registries; never taken on the recording
+// path except for a thread's first event.
+mutex registryMutex;
+vector<string> siteNames;
+vector<unique_ptr<TraceBuffer>> buffers;
+unsigned int nextThreadId = 1;
+
+thread_local TraceBuffer* threadBuffer = nullptr;
+
+FILE* traceFile = nullptr;
+thread drainThread;
+bool wroteEvent = false;
+
+// The trace clock. steady_clock resolves to the hardware counter via
+// the vDSO on the platforms we care about, without the frequency and
+// migration caveats of reading the TSC directly.
+uint64_t traceClockNs()
+{
+    return (uint64_t) chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TraceBuffer* acquireThreadBuffer()
+{
+    lock_guard<mutex> lock(registryMutex);
+    buffers.emplace_back(new TraceBuffer(nextThreadId++));
+    return buffers.back().get();
+}
+
+void writeEvent(const TraceEvent& event, unsigned int tid)
+{
+    const char* phase = "i";
+    if (event.phase == TraceLog::Begin)
+        phase = "B";
+    else if (event.phase == TraceLog::End)
+        phase = "E";
+
+    string name;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        if (event.site < siteNames.size())
+            name = siteNames[event.site];
+    }
+
+    fprintf(traceFile, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u%s}",
+            wroteEvent ? ",\n" : "\n",
+            name.c_str(), phase, event.ns / 1000.0, tid,
+            event.phase == TraceLog::Instant ? ",\"s\":\"t\"" : "");
+    wroteEvent = true;
+}
+
+// Pop everything currently queued; returns the number of events
+// written.
+size_t drainOnce()
+{
+    size_t drained = 0;
+
+    // The buffer list only grows; holding the lock just long enough to
+    // copy it keeps producers registering new threads unblocked.
+    vector<TraceBuffer*> snapshot;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        snapshot.reserve(buffers.size());
+        for (const auto& buffer : buffers)
+            snapshot.push_back(buffer.get());
+    }
+
+    for (auto* buffer : snapshot)
+    {
+        TraceEvent event;
+        while (buffer->ring.pop(event))
+        {
+            writeEvent(event, buffer->tid);
+            drained++;
+        }
+    }
+
+    return drained;
+}
+
+} // end unnamed namespace
+
+
+atomic<bool> TraceLog::ms_active{ false };
+
+
+unsigned int
+TraceLog::registerSite(const char* name)
+{
+    lock_guard<mutex> lock(registryMutex);
+    siteNames.push_back(name);
+    return (unsigned int) (siteNames.size() - 1);
+}
+
+
+bool
+TraceLog::start(const fs::path& path)
+{
+    if (active())
+        return false;
+
+    traceFile = fopen(path.string().c_str(), "w");
+    if (traceFile == nullptr)
+        return false;
+
+    fputs("[", traceFile);
+    wroteEvent = false;
+
+    ms_active.store(true, memory_order_release);
+    drainThread = thread(drainLoop);
+
+    return true;
+}
+
+
+void
+TraceLog::stop()
+{
+    if (!active())
+        return;
+
+    ms_active.store(false, memory_order_release);
+    drainThread.join();
+
+    // Final sweep for events recorded while the drain thread was
+    // shutting down, then the drop totals.
+    drainOnce();
+
+    uint64_t dropped = 0;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        for (const auto& buffer : buffers)
+            dropped += buffer->dropped.load(memory_order_relaxed);
+    }
+    fprintf(traceFile, "%s{\"name\":\"dropped events: %llu\",\"ph\":\"i\",\"ts\":%.3f,\"pid\":1,\"tid\":0,\"s\":\"g\"}",
+            wroteEvent ? ",\n" : "\n",
+            (unsigned long long) dropped, traceClockNs() / 1000.0);
+
+    fputs("\n]\n", traceFile);
+    fclose(traceFile);
+    traceFile = nullptr;
+}
+
+
+void
+TraceLog::startFromEnvironment()
+{
+    const char* path = getenv("CELESTIA_TRACE_FILE");
+    if (path != nullptr && *path != '\0')
+        start(path);
+}
+
+
+void
+TraceLog::recordEvent(unsigned int site, EventPhase phase)
+{
+    TraceBuffer* buffer = threadBuffer;
+    if (buffer == nullptr)
+    {
+        buffer = acquireThreadBuffer();
+        threadBuffer = buffer;
+    }
+
+    TraceEvent event;
+    event.ns = traceClockNs();
+    event.site = site;
+    event.phase = phase;
+
+    if (!buffer->ring.push(event))
+        buffer->dropped.fetch_add(1, memory_order_relaxed);
+}
+
+
+void
+TraceLog::drainLoop()
+{
+    while (ms_active.load(memory_order_acquire))
+    {
+        if (drainOnce() == 0)
+            this_thread::sleep_for(chrono::milliseconds(10));
+    }
+}
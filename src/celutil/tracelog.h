@@ -0,0 +1,124 @@
+// tracelog.h
+//
+// Copyright (C) 2019, the Celestia Development Team
+//
+// Always-on event tracing for hunting frame spikes in production.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <celcompat/filesystem.h>
+
+//! TraceLog records (site id, timestamp) events from any thread into
+//! fixed-size per-thread lock-free rings, which a background thread
+//! drains to a file in the Chrome trace-event format (load it with
+//! chrome://tracing). It is meant to stay compiled in: while tracing is
+//! inactive an instrumented site costs a single relaxed atomic load,
+//! and while active an event is one clock read and one ring push, so
+//! machines that exhibit intermittent frame spikes can run with tracing
+//! on continuously. Producers never block: when a ring fills faster
+//! than the drain thread empties it, events are dropped and counted,
+//! and the drop total is recorded at the end of the trace.
+class TraceLog
+{
+public:
+    enum EventPhase : std::uint8_t
+    {
+        Begin   = 0,
+        End     = 1,
+        Instant = 2
+    };
+
+    //! Register an instrumentation site and return its id. The macros
+    //! below call this once per site from a function-local static, so
+    //! the lock it takes is off the recording path.
+    static unsigned int registerSite(const char* name);
+
+    //! Start writing a trace to the named file. Returns false if the
+    //! file cannot be opened or tracing is already active.
+    static bool start(const fs::path& path);
+
+    //! Drain whatever remains in the rings, finish the file, and join
+    //! the drain thread.
+    static void stop();
+
+    //! Start tracing if the CELESTIA_TRACE_FILE environment variable
+    //! names an output file, mirroring CELESTIA_PROFILE_STARTUP.
+    static void startFromEnvironment();
+
+    static bool active()
+    {
+        return ms_active.load(std::memory_order_relaxed);
+    }
+
+    static void record(unsigned int site, EventPhase phase)
+    {
+        if (active())
+            recordEvent(site, phase);
+    }
+
+private:
+    static void recordEvent(unsigned int site, EventPhase phase);
+    static void drainLoop();
+
+    static std::atomic<bool> ms_active;
+};
+
+
+//! Emit a Begin event now and the matching End event at the close of
+//! the enclosing scope.
+class TraceSpan
+{
+public:
+    TraceSpan(unsigned int site) :
+        m_site(site)
+    {
+        TraceLog::record(m_site, TraceLog::Begin);
+    }
+
+    ~TraceSpan()
+    {
+        TraceLog::record(m_site, TraceLog::End);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    unsigned int m_site;
+};
+
+
+#define CELTRACE_CONCAT2(a, b) a ## b
+#define CELTRACE_CONCAT(a, b) CELTRACE_CONCAT2(a, b)
+
+//! Trace the enclosing scope as a named span.
+#define CELTRACE_SCOPE(name) \
+    static const unsigned int CELTRACE_CONCAT(celtrace_site_, __LINE__) = \
+        TraceLog::registerSite(name); \
+    TraceSpan CELTRACE_CONCAT(celtrace_span_, __LINE__)(CELTRACE_CONCAT(celtrace_site_, __LINE__))
+
+//! Record a single point-in-time event.
+#define CELTRACE_INSTANT(name) \
+    do \
+    { \
+        static const unsigned int celtrace_site = TraceLog::registerSite(name); \
+        TraceLog::record(celtrace_site, TraceLog::Instant); \
+    } while (0)
+
+//! Zone markers for external profiling sessions. CELZONE threads named
+//! spans through the hot functions, so an attached profiler sees
+//! subsystems instead of inlined symbols; unlike CELTRACE_SCOPE it
+//! compiles to nothing unless the build enables CELESTIA_PROFILE, so
+//! release builds carry no cost at all for the dense instrumentation.
+#ifdef CELESTIA_PROFILE
+#define CELZONE(name) CELTRACE_SCOPE(name)
+#else
+#define CELZONE(name)
+#endif
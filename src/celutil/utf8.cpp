@@ -9,6 +9,7 @@
 
 #include "utf8.h"
 #include <cctype>
+#include <cstdint>
 #include <cstring>
 #include "util.h"
 #include <wchar.h>
@@ -559,6 +560,59 @@ int UTF8StringCompare(const std::string& s0, const std::string& s1)
         return 0;
 }
 
+
+std::string UTF8NormalizedKey(const std::string& str)
+{
+    std::string key;
+    key.reserve(str.length());
+
+    int len = (int) str.length();
+    int i = 0;
+    while (i < len)
+    {
+        // ASCII fast path: test eight bytes at once for a high bit and
+        // fold them through the first normalization page (which maps
+        // A-Z to a-z and is otherwise the identity below 0x80).
+        while (i + 8 <= (int) len)
+        {
+            uint64_t chunk;
+            std::memcpy(&chunk, str.data() + i, sizeof(chunk));
+            if ((chunk & UINT64_C(0x8080808080808080)) != 0)
+                break;
+            for (int k = 0; k < 8; k++)
+                key += (char) WGL4_Normalization_00[(unsigned char) str[i + k]];
+            i += 8;
+        }
+        if (i >= len)
+            break;
+
+        auto c = (unsigned char) str[i];
+        if (c < 0x80)
+        {
+            key += (char) WGL4_Normalization_00[c];
+            i++;
+            continue;
+        }
+
+        wchar_t ch = 0;
+        if (!UTF8Decode(str, i, ch))
+        {
+            // Keep bad bytes as-is so distinct malformed strings still
+            // produce distinct keys.
+            key += (char) c;
+            i++;
+            continue;
+        }
+
+        i += UTF8EncodedSize(ch);
+        char encoded[7];
+        key.append(encoded, UTF8Encode(UTF8Normalize(ch), encoded));
+    }
+
+    return key;
+}
+
+
 int UTF8StringCompare(const std::string& s0, const std::string& s1, size_t n, bool ignoreCase)
 {
     int len0 = s0.length();
@@ -26,6 +26,15 @@ int UTF8Encode(wchar_t ch, char* s);
 int UTF8StringCompare(const std::string& s0, const std::string& s1);
 int UTF8StringCompare(const std::string& s0, const std::string& s1, size_t n, bool ignoreCase = false);
 
+//! Build the WGL-4 normalized, case-folded key of a UTF-8 string. Two
+//! strings compare equal under UTF8StringCompare(..., ignoreCase = true)
+//! exactly when their keys are byte-wise identical, and a string is a
+//! character prefix of another exactly when its key is a byte prefix of
+//! the other's, so repeated comparisons against precomputed keys reduce
+//! to memcmp. ASCII runs -- the overwhelming majority of catalog
+//! names -- are scanned eight bytes at a time.
+std::string UTF8NormalizedKey(const std::string& str);
+
 class UTF8StringOrderingPredicate
 {
  public:
@@ -26,6 +26,16 @@
 #define gettext_noop(string) string
 #endif
 
+// Memoizing variant of _() for strings translated every frame (the
+// heads-up display redraws its labels on each frame): the translation
+// of the literal argument is resolved once and the pointer cached at
+// the call site, so steady-state translation is a pointer load instead
+// of a message catalog lookup. Celestia selects its locale once at
+// startup, so a cached translation cannot go stale.
+#ifndef F_
+#define F_(string) ([]() -> const char* { static const char* cachedTranslation = gettext(string); return cachedTranslation; }())
+#endif
+
 #ifdef _WIN32
 // POSIX provides an extension to printf family to reorder their arguments,
 // so GNU GetText provides own replacement for them on windows platform
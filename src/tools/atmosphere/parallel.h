@@ -0,0 +1,68 @@
+// parallel.h
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Minimal work-stealing loop for the atmosphere table generators. The
+// integration loops in scattersim and scattertable are embarrassingly
+// parallel across table rows, so a shared atomic row counter and a few
+// worker threads is all the machinery needed.
+
+#ifndef _TOOLS_ATMOSPHERE_PARALLEL_H_
+#define _TOOLS_ATMOSPHERE_PARALLEL_H_
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+inline unsigned int defaultThreadCount()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+
+/*! Run body(i) for every i in [begin, end), distributed over the given
+ *  number of threads. Iterations are claimed one at a time from a
+ *  shared counter, so uneven rows (e.g. view rays that miss the
+ *  atmosphere entirely) balance themselves. body must only write to
+ *  locations owned by its own iteration. The calling thread
+ *  participates, so threads == 1 degenerates to a plain loop.
+ */
+inline void parallelFor(unsigned int begin, unsigned int end,
+                        unsigned int threads,
+                        const std::function<void(unsigned int)>& body)
+{
+    if (threads <= 1 || end - begin <= 1)
+    {
+        for (unsigned int i = begin; i < end; i++)
+            body(i);
+        return;
+    }
+
+    std::atomic<unsigned int> next(begin);
+    auto worker = [&]() {
+        for (;;)
+        {
+            unsigned int i = next.fetch_add(1);
+            if (i >= end)
+                return;
+            body(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool)
+        thread.join();
+}
+
+#endif // _TOOLS_ATMOSPHERE_PARALLEL_H_
@@ -22,6 +22,7 @@
 #include <celmath/intersect.h>
 #include <zlib.h>
 #include <png.h>
+#include "parallel.h"
 
 using namespace std;
 using namespace Eigen;
@@ -52,6 +53,7 @@ enum LUTUsageType
 static LUTUsageType LUTUsage = NoLUT;
 static bool UseFisheyeCameras = false;
 static double CameraExposure = 0.0;
+static unsigned int ThreadCount = 0;   // 0 means use all hardware threads
 
 
 typedef map<string, double> ParameterSet;
@@ -377,6 +379,8 @@ void usage()
     cerr << "           set the number of integration steps for depth\n";
     cerr << "   --scattersteps <value> (or -s)\n";
     cerr << "           set the number of integration steps for scattering\n";
+    cerr << "   --threads <value> (or -t)\n";
+    cerr << "           set the number of worker threads (default: all hardware threads)\n";
 }
 
 
@@ -1030,7 +1034,9 @@ buildExtinctionLUT(const Scene& scene)
     //Sphered planet = Sphered(scene.planet.radius);
     Sphered shell = Sphered(scene.planet.radius + scene.atmosphereShellHeight);
 
-    for (unsigned int i = 0; i < ExtinctionLUTHeightSteps; i++)
+    parallelFor(0, ExtinctionLUTHeightSteps,
+                ThreadCount == 0 ? defaultThreadCount() : ThreadCount,
+                [&](unsigned int i)
     {
         double h = (double) i / (double) (ExtinctionLUTHeightSteps - 1) *
             scene.atmosphereShellHeight * 0.9999;
@@ -1057,7 +1063,7 @@ buildExtinctionLUT(const Scene& scene)
 
             lut->setValue(i, j, ext.cwiseMax(1.0e-18));
         }
-    }
+    });
 
     return lut;
 }
@@ -1090,7 +1096,9 @@ buildOpticalDepthLUT(const Scene& scene)
     //Sphered planet = Sphered(scene.planet.radius);
     Sphered shell = Sphered(scene.planet.radius + scene.atmosphereShellHeight);
 
-    for (unsigned int i = 0; i < ExtinctionLUTHeightSteps; i++)
+    parallelFor(0, ExtinctionLUTHeightSteps,
+                ThreadCount == 0 ? defaultThreadCount() : ThreadCount,
+                [&](unsigned int i)
     {
         double h = (double) i / (double) (ExtinctionLUTHeightSteps - 1) *
             scene.atmosphereShellHeight;
@@ -1116,7 +1124,7 @@ buildOpticalDepthLUT(const Scene& scene)
 
             lut->setValue(i, j, Vector3d(depth.rayleigh, depth.mie, depth.absorption));
         }
-    }
+    });
 
     return lut;
 }
@@ -1307,7 +1315,9 @@ buildScatteringLUT(const Scene& scene)
 
     Sphered shell = Sphered(scene.planet.radius + scene.atmosphereShellHeight);
 
-    for (unsigned int i = 0; i < ScatteringLUTHeightSteps; i++)
+    parallelFor(0, ScatteringLUTHeightSteps,
+                ThreadCount == 0 ? defaultThreadCount() : ThreadCount,
+                [&](unsigned int i)
     {
         double h = (double) i / (double) (ScatteringLUTHeightSteps - 1) *
             scene.atmosphereShellHeight * 0.9999;
@@ -1348,7 +1358,7 @@ buildScatteringLUT(const Scene& scene)
                 lut->setValue(i, j, k, inscatter);
             }
         }
-    }
+    });
 
     return lut;
 }
@@ -1600,14 +1610,16 @@ void render(const Scene& scene,
     unsigned int bottom = min(image.height, viewport.y + viewport.height);
 
     cout << "Rendering " << viewport.width << "x" << viewport.height << " view" << endl;
-    for (unsigned int i = viewport.y; i < bottom; i++)
-    {
-        unsigned int row = i - viewport.y;
-        if (row % 50 == 49)
-            cout << row + 1 << endl;
-        else if (row % 10 == 0)
-            cout << ".";
 
+    // Rows are fully independent of one another (raytrace is const and
+    // setPixel writes are disjoint), so distribute them over the worker
+    // threads. Progress dots are emitted by completion count since rows
+    // no longer finish in order.
+    std::atomic<unsigned int> rowsDone(0);
+    parallelFor(viewport.y, bottom,
+                ThreadCount == 0 ? defaultThreadCount() : ThreadCount,
+                [&](unsigned int i)
+    {
         for (unsigned int j = viewport.x; j < right; j++)
         {
             double viewportX = ((double) (j - viewport.x) / (double) (viewport.width - 1) - 0.5) * aspectRatio;
@@ -1626,7 +1638,13 @@ void render(const Scene& scene,
 
             image.setPixel(j, i, color);
         }
-    }
+
+        unsigned int done = rowsDone.fetch_add(1) + 1;
+        if (done % 50 == 0)
+            cout << done << endl;
+        else if (done % 10 == 0)
+            cout << "." << flush;
+    });
     cout << endl << "Complete" << endl;
 }
 
@@ -1874,6 +1892,15 @@ bool parseCommandLine(int argc, char* argv[])
                     return false;
                 i++;
             }
+            else if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threads"))
+            {
+                if (i == argc - 1)
+                    return false;
+
+                if (sscanf(argv[i + 1], " %u", &ThreadCount) != 1)
+                    return false;
+                i++;
+            }
             else if (!strcmp(argv[i], "-i") || !strcmp(argv[i], "--image"))
             {
                 if (i == argc - 1)
@@ -36,14 +36,17 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <cstdlib>
 #include <cmath>
 #include <algorithm>
 #include <map>
+#include <vector>
 #include <cassert>
 #include <Eigen/Core>
 #include <celmath/mathlib.h>
+#include "parallel.h"
 
 using namespace Eigen;
 using namespace std;
@@ -56,6 +59,8 @@ constexpr const unsigned int SunAngleSamples = 32;
 
 // Values settable via the command line
 static unsigned int ScatteringIntegrationSteps = 25;
+static unsigned int ThreadCount = 0;    // 0 means one per hardware thread
+static bool ForceRegeneration = false;
 
 typedef map<string, double> ParameterSet;
 
@@ -174,7 +179,10 @@ Atmosphere::computeTransmittanceTable() const
     // position just *above* the planet surface.
     float baseHeight = Rg * 1.0e-6f;
 
-    for (unsigned int i = 0; i < HeightSamples; ++i)
+    // Each height layer is an independent row of the table
+    parallelFor(0, HeightSamples,
+                ThreadCount == 0 ? defaultThreadCount() : ThreadCount,
+                [&](unsigned int i)
     {
         float v = float(i) / float(HeightSamples);
         float h = v * v * (Rt - Rg) + baseHeight;
@@ -216,7 +224,7 @@ Atmosphere::computeTransmittanceTable() const
                 cout << "Non-physical transmittance " << transmittanceTable[index].x() << endl;
             }
         }
-    }
+    });
 
     return transmittanceTable;
 }
@@ -241,113 +249,122 @@ Atmosphere::computeInscatterTable() const
     unsigned int sampleCount = HeightSamples * ViewAngleSamples * SunAngleSamples;
     Vector4f* inscatter = new Vector4f[sampleCount];
 
-    for (unsigned int i = 0; i < HeightSamples; ++i)
+    // Every (height, view angle) row of the table is independent, so
+    // rows are distributed across worker threads. Within a row, the
+    // sample positions, densities and view-path transmittances along
+    // the ray are the same for every sun angle, so they are integrated
+    // once per row instead of once per sun angle.
+    parallelFor(0, HeightSamples * ViewAngleSamples,
+                ThreadCount == 0 ? defaultThreadCount() : ThreadCount,
+                [&](unsigned int row)
     {
+        unsigned int i = row / ViewAngleSamples;
+        unsigned int j = row % ViewAngleSamples;
+
         float w = float(i) / float(HeightSamples);
         float h = w * w * (Rt - Rg) + baseHeight;
         float r = Rg + h;
         float r2 = r * r;
 
-        cout << "layer " << i << ", height=" << h << "km\n";
-
         Vector2f eye(0.0f, r);
 
-        for (unsigned int j = 0; j < ViewAngleSamples; ++j)
+        float v = float(j) / float(ViewAngleSamples - 1);
+        float mu = max(-1.0f, min(1.0f, toMu(v)));
+        float cosTheta = mu;
+        float sinTheta2 = 1.0f - cosTheta * cosTheta;
+        float sinTheta = sqrt(sinTheta2);
+        Vector2f view(sinTheta, cosTheta);
+
+        float pathLength;
+        float d = Rg2 - r2 * sinTheta2;
+        if (d > 0.0f && -r * cosTheta - sqrt(d) > 0.0f)
         {
-            float v = float(j) / float(ViewAngleSamples - 1);
-            float mu = max(-1.0f, min(1.0f, toMu(v)));
-            float cosTheta = mu;
-            float sinTheta2 = 1.0f - cosTheta * cosTheta;
-            float sinTheta = sqrt(sinTheta2);
-            Vector2f view(sinTheta, cosTheta);
+            // Ray hits the planet
+            pathLength = -r * cosTheta - sqrt(Rg2 - r2 * sinTheta2);
+        }
+        else
+        {
+            // Ray hits the sky
+            pathLength = -r * cosTheta + sqrt(Rt2 - r2 * sinTheta2);
+        }
 
-            float pathLength;
-            float d = Rg2 - r2 * sinTheta2;
-            if (d > 0.0f && -r * cosTheta - sqrt(d) > 0.0f)
-            {
-                // Ray hits the planet
-                pathLength = -r * cosTheta - sqrt(Rg2 - r2 * sinTheta2);
-            }
-            else
-            {
-                // Ray hits the sky
-                pathLength = -r * cosTheta + sqrt(Rt2 - r2 * sinTheta2);
-            }
+        float stepLength = pathLength / float(ScatteringIntegrationSteps);
+        Vector2f step = view * stepLength;
 
-            for (unsigned int k = 0; k < SunAngleSamples; ++k)
-            {
-                float w = float(k) / float(SunAngleSamples - 1);
-                float muS = toMuS(w);
-                float cosPhi = muS;
-                float sinPhi = sqrt(max(0.0f, 1.0f - cosPhi * cosPhi));
-                Vector2f sun(sinPhi, cosPhi);
+        // Sun-angle independent state of each integration step
+        struct PathSample
+        {
+            Vector2f x;           // sample position
+            float rx;             // distance from planet center
+            Vector3f viewPathTransmittance;
+            float rayleighDensity;  // density * stepLength
+            float mieDensity;
+        };
+        vector<PathSample> path(ScatteringIntegrationSteps);
+
+        for (unsigned int m = 0; m < ScatteringIntegrationSteps; ++m)
+        {
+            PathSample& sample = path[m];
+            sample.x = eye + step * m;
+            sample.rx = sample.x.norm();
+            sample.viewPathTransmittance =
+                transmittance(r, mu, stepLength * m, *this);
+
+            float hx = sample.rx - Rg;
+            sample.rayleighDensity = exp(-hx / rayleighScaleHeight) * stepLength;
+            sample.mieDensity = exp(-hx / mieScaleHeight) * stepLength;
+        }
 
-                float stepLength = pathLength / float(ScatteringIntegrationSteps);
-                Vector2f step = view * stepLength;
+        for (unsigned int k = 0; k < SunAngleSamples; ++k)
+        {
+            float u = float(k) / float(SunAngleSamples - 1);
+            float muS = toMuS(u);
+            float cosPhi = muS;
+            float sinPhi = sqrt(max(0.0f, 1.0f - cosPhi * cosPhi));
+            Vector2f sun(sinPhi, cosPhi);
 
-                Vector3f rayleigh = Vector3f::Zero();
-                float mie = 0.0f;
+            Vector3f rayleigh = Vector3f::Zero();
+            float mie = 0.0f;
 
-                for (unsigned int m = 0; m < ScatteringIntegrationSteps; ++m)
+            for (unsigned int m = 0; m < ScatteringIntegrationSteps; ++m)
+            {
+                const PathSample& sample = path[m];
+                float rx = sample.rx;
+                float rx2 = rx * rx;
+
+                // Compute the cosine and sine of the angle between the
+                // sun direction and zenith at the current sample.
+                float c = sample.x.dot(sun) / rx;
+                float s2 = 1.0f - c * c;
+
+                // Compute the transmittance along the path to the sun
+                // and the total transmittance t.
+                if (Rg2 - rx2 * s2 < 0.0f || -rx * c - sqrt(Rg2 - rx2 * s2) < 0.0f)
                 {
-                    Vector2f x = eye + step * m;
-                    float distanceToViewer = stepLength * m;
-                    float rx2 = x.squaredNorm();
-                    float rx = sqrt(rx2);
-
-                    // Compute the transmittance along the path to the viewer
-                    Vector3f viewPathTransmittance = transmittance(r, mu, distanceToViewer, *this);
-
-                    // Compute the cosine and sine of the angle between the
-                    // sun direction and zenith at the current sample.
-                    float c = x.dot(sun) / rx;
-                    float s2 = 1.0f - c * c;
-
-                    // Compute the transmittance along the path to the sun
-                    // and the total transmittance t.
-                    Vector3f t;
-                    if (Rg2 - rx2 * s2 < 0.0f || -rx * c - sqrt(Rg2 - rx2 * s2) < 0.0f)
-                    {
-                        // Compute the distance through the atmosphere
-                        // in the direction of the sun
-                        float sunPathLength = -rx * c + sqrt(Rt2 - rx2 * s2);
-                        Vector3f sunPathTransmittance = transmittance(rx, c, sunPathLength, *this);
-
-                        t = viewPathTransmittance.cwiseProduct(sunPathTransmittance);
-                    }
-                    else
-                    {
-                        // Ray to sun intersects the planet; no inscattered
-                        // light at this point.
-                        t = Vector3f::Zero();
-                    }
+                    // Compute the distance through the atmosphere
+                    // in the direction of the sun
+                    float sunPathLength = -rx * c + sqrt(Rt2 - rx2 * s2);
+                    Vector3f t = sample.viewPathTransmittance.cwiseProduct(
+                        transmittance(rx, c, sunPathLength, *this));
 
                     // Accumulate Rayleigh and Mie scattering
-                    float hx = rx - Rg;
-                    rayleigh += (exp(-hx / rayleighScaleHeight) * stepLength) * t;
-                    mie += exp(-hx / mieScaleHeight) * stepLength * t.x();
+                    rayleigh += sample.rayleighDensity * t;
+                    mie += sample.mieDensity * t.x();
                 }
-
-                unsigned int index = (i * ViewAngleSamples + j) * SunAngleSamples + k;
-                inscatter[index] << rayleigh.cwiseProduct(rayleighCoeff),
-                                    mie * mieCoeff;
-                if (i == HeightSamples - 1 && k == 0)
-                {
-                    cout << acos(muS) * 180.0/M_PI << ", "
-                         << acos(mu) * 180.0/M_PI << ", "
-                         << inscatter[index].transpose() << endl;
-                }
-
-#if 0
-                // Emit warnings about NaNs in scatter table
-                if (isnan(rayleigh.x()))
-                {
-                    cout << "NaN in inscatter table at (" << k << ", " << j << ", " << i << ")\n";
-                }
-#endif
+                // else: ray to sun intersects the planet; no
+                // inscattered light at this point.
             }
+
+            unsigned int index = (i * ViewAngleSamples + j) * SunAngleSamples + k;
+            inscatter[index] << rayleigh.cwiseProduct(rayleighCoeff),
+                                mie * mieCoeff;
         }
-    }
+
+        // One progress marker per completed height layer
+        if (j == ViewAngleSamples - 1)
+            cout << "." << flush;
+    });
+    cout << "\n";
 
     return inscatter;
 }
@@ -361,6 +378,10 @@ void usage()
     cerr << "           (default is out.atm)\n";
     cerr << "   --scattersteps <value> (or -s)\n";
     cerr << "           set the number of integration steps for scattering\n";
+    cerr << "   --threads <value> (or -t)\n";
+    cerr << "           set the number of worker threads (default: all cores)\n";
+    cerr << "   --force (or -f)\n";
+    cerr << "           regenerate tables even when parameters are unchanged\n";
 }
 
 
@@ -491,6 +512,19 @@ bool parseCommandLine(int argc, char* argv[])
                 OutputFileName = string(argv[i + 1]);
                 i++;
             }
+            else if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--threads"))
+            {
+                if (i == argc - 1)
+                    return false;
+
+                if (sscanf(argv[i + 1], " %u", &ThreadCount) != 1)
+                    return false;
+                i++;
+            }
+            else if (!strcmp(argv[i], "-f") || !strcmp(argv[i], "--force"))
+            {
+                ForceRegeneration = true;
+            }
             else
             {
                 return false;
@@ -856,6 +890,60 @@ static void WriteTransmittanceTableDDS(ostream& out, Vector3f* transmittanceTabl
 
 
 
+// Incremental regeneration: each output table carries a sidecar stamp
+// file recording the parameters it was generated from. When the stamp
+// matches and the table file exists, that table is skipped, so editing
+// a parameter that only one table depends on (e.g. the integration
+// step count, which the analytic transmittance table ignores) only
+// regenerates what actually changed.
+
+static string transmittanceStamp(const Atmosphere& atm)
+{
+    ostringstream s;
+    s << "size " << ViewAngleSamples << " " << HeightSamples << "\n"
+      << "radius " << atm.planetRadius << "\n"
+      << "rayleighscaleheight " << atm.rayleighScaleHeight << "\n"
+      << "rayleighcoeff " << atm.rayleighCoeff.transpose() << "\n"
+      << "miescaleheight " << atm.mieScaleHeight << "\n"
+      << "miecoeff " << atm.mieCoeff << "\n"
+      << "absorptioncoeff " << atm.absorptionCoeff.transpose() << "\n";
+    return s.str();
+}
+
+
+static string inscatterStamp(const Atmosphere& atm)
+{
+    ostringstream s;
+    s << transmittanceStamp(atm)
+      << "sunanglesamples " << SunAngleSamples << "\n"
+      << "scattersteps " << ScatteringIntegrationSteps << "\n";
+    return s.str();
+}
+
+
+static bool stampMatches(const string& tableFileName, const string& stamp)
+{
+    ifstream table(tableFileName, ifstream::binary);
+    if (!table.good())
+        return false;
+
+    ifstream in(tableFileName + ".stamp");
+    if (!in.good())
+        return false;
+
+    ostringstream existing;
+    existing << in.rdbuf();
+    return existing.str() == stamp;
+}
+
+
+static void writeStamp(const string& tableFileName, const string& stamp)
+{
+    ofstream out(tableFileName + ".stamp");
+    out << stamp;
+}
+
+
 #if TEST_FLOAT_TO_HALF
 int main(void)
 {
@@ -895,16 +983,40 @@ int main(int argc, char* argv[])
     cout << "Mie scale height: " << atmosphere.mieScaleHeight << "km\n";
     cout << "Mie coeff: " << atmosphere.mieCoeff << "m^-1\n";
     cout << "Absorption coeff: " << atmosphere.absorptionCoeff.transpose() << "m^-1\n";
-    cout << "Using " << ScatteringIntegrationSteps << " integration steps.\n";
+    cout << "Using " << ScatteringIntegrationSteps << " integration steps and "
+         << (ThreadCount == 0 ? defaultThreadCount() : ThreadCount) << " threads.\n";
 
-    cout << "Generating transmittance table (" << ViewAngleSamples << "x"
-         << HeightSamples << ")...\n";
-    Vector3f* transmittanceTable = atmosphere.computeTransmittanceTable();
+    string tStamp = transmittanceStamp(atmosphere);
+    string iStamp = inscatterStamp(atmosphere);
+    bool generateTransmittance =
+        ForceRegeneration || !stampMatches("transmittance.dds", tStamp);
+    bool generateInscatter =
+        ForceRegeneration || !stampMatches("inscatter.dds", iStamp);
 
-    cout << "Generating inscatter table (" << SunAngleSamples << "x"
-         << ViewAngleSamples << "x" << HeightSamples << ")...\n";
+    Vector3f* transmittanceTable = nullptr;
+    Vector4f* inscatterTable = nullptr;
 
-    Vector4f* inscatterTable = atmosphere.computeInscatterTable();
+    if (generateTransmittance)
+    {
+        cout << "Generating transmittance table (" << ViewAngleSamples << "x"
+             << HeightSamples << ")...\n";
+        transmittanceTable = atmosphere.computeTransmittanceTable();
+    }
+    else
+    {
+        cout << "transmittance.dds is up to date; skipping (--force to regenerate)\n";
+    }
+
+    if (generateInscatter)
+    {
+        cout << "Generating inscatter table (" << SunAngleSamples << "x"
+             << ViewAngleSamples << "x" << HeightSamples << ")...\n";
+        inscatterTable = atmosphere.computeInscatterTable();
+    }
+    else
+    {
+        cout << "inscatter.dds is up to date; skipping (--force to regenerate)\n";
+    }
 
     ByteSwapRequired = !IsLittleEndian();
 
@@ -964,13 +1076,21 @@ int main(int argc, char* argv[])
     out.close();
 #else
     // Write tables as separate DDS files
-    ofstream transmittanceOut("transmittance.dds", ostream::binary);
-    WriteTransmittanceTableDDS(transmittanceOut, transmittanceTable);
-    transmittanceOut.close();
+    if (generateTransmittance)
+    {
+        ofstream transmittanceOut("transmittance.dds", ostream::binary);
+        WriteTransmittanceTableDDS(transmittanceOut, transmittanceTable);
+        transmittanceOut.close();
+        writeStamp("transmittance.dds", tStamp);
+    }
 
-    ofstream inscatterOut("inscatter.dds", ostream::binary);
-    WriteInscatterTableDDS(inscatterOut, inscatterTable);
-    inscatterOut.close();
+    if (generateInscatter)
+    {
+        ofstream inscatterOut("inscatter.dds", ostream::binary);
+        WriteInscatterTableDDS(inscatterOut, inscatterTable);
+        inscatterOut.close();
+        writeStamp("inscatter.dds", iStamp);
+    }
 #endif
 
     return 0;
@@ -0,0 +1,459 @@
+// celbench.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Microbenchmarks for engine hot paths. Every benchmark runs a fixed
+// workload built from a fixed seed, so the operation counts are
+// identical from run to run and across machines; only the wall time
+// varies. Results can be saved as a baseline and later runs checked
+// against it with a tolerance, which is how release performance claims
+// are verified before rollout:
+//
+//     celbench --save baseline.txt         # on the reference machine
+//     celbench --check baseline.txt        # exits nonzero on regression
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <celengine/astro.h>
+#include <celengine/parser.h>
+#include <celengine/staroctree.h>
+#include <celengine/stellarclass.h>
+#include <celengine/tokenizer.h>
+#include <celephem/orbit.h>
+#include <celephem/vsop87.h>
+#include <celmath/frustum.h>
+#include <celutil/bigfix.h>
+#include <celutil/timer.h>
+#include <celutil/utf8.h>
+#include <fmt/printf.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+using namespace celmath;
+using namespace std;
+
+
+struct BenchmarkResult
+{
+    string name;
+    double nsPerOp;
+};
+
+static vector<BenchmarkResult> results;
+
+// Accumulator the benchmark bodies feed so the optimizer cannot
+// discard their work.
+static volatile double sink = 0.0;
+
+
+template <typename F>
+static void runBenchmark(const string& name, long ops, F body)
+{
+    Timer timer;
+    body();
+    double elapsed = timer.getTime();
+
+    BenchmarkResult result;
+    result.name = name;
+    result.nsPerOp = elapsed * 1.0e9 / (double) ops;
+    results.push_back(result);
+    fmt::printf("%-24s %12.1f ns/op   (%ld ops in %.3f s)\n",
+                name, result.nsPerOp, ops, elapsed);
+}
+
+
+// Deterministic pseudorandom numbers; must not vary between platforms
+// or library versions, so no <random> here.
+static uint64_t lcgState = 0x123456789abcdefULL;
+
+static double lcg()
+{
+    lcgState = lcgState * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (double) (lcgState >> 11) / 9007199254740992.0;
+}
+
+
+static void benchBigFix()
+{
+    const long ops = 2000000;
+    BigFix a(1.0e12 + 0.375);
+    BigFix b(7.25e-5);
+    BigFix sum(0.0);
+    runBenchmark("bigfix/arith", ops, [&]() {
+        for (long i = 0; i < ops; i++)
+        {
+            sum += a;
+            sum = sum - b;
+            sum = sum * 0.999999;
+        }
+        sink += (double) sum;
+    });
+}
+
+
+static void benchFrustum()
+{
+    const int sphereCount = 1024;
+    const long repeats = 2000;
+    vector<Vector3f> centers(sphereCount);
+    vector<float> radii(sphereCount);
+    for (int i = 0; i < sphereCount; i++)
+    {
+        centers[i] = Vector3f((float) (lcg() * 2000.0 - 1000.0),
+                              (float) (lcg() * 2000.0 - 1000.0),
+                              (float) (lcg() * -2000.0));
+        radii[i] = (float) (lcg() * 50.0 + 0.1);
+    }
+
+    Frustum frustum((float) (3.14159265 / 4.0), 1.5f, 1.0f, 1.0e6f);
+    runBenchmark("frustum/sphere", repeats * sphereCount, [&]() {
+        long inside = 0;
+        for (long r = 0; r < repeats; r++)
+        {
+            for (int i = 0; i < sphereCount; i++)
+            {
+                if (frustum.testSphere(centers[i], radii[i]) != Frustum::Outside)
+                    inside++;
+            }
+        }
+        sink += (double) inside;
+    });
+}
+
+
+static void benchUTF8Compare()
+{
+    // Star-name-like strings: mostly ASCII with the occasional
+    // accented or Greek character, as in the real name database.
+    const char* fragments[] = {
+        "Alpha", "Beta", "\xce\xb1", "\xce\xb2", "Centauri", "Cygni",
+        "Eridani", "Ori\xc3\xb3n", "HIP", "Gliese", "Proxima", "61"
+    };
+    const int nameCount = 256;
+    vector<string> names(nameCount);
+    for (int i = 0; i < nameCount; i++)
+    {
+        string s = fragments[(int) (lcg() * 12)];
+        s += ' ';
+        s += fragments[(int) (lcg() * 12)];
+        names[i] = s;
+    }
+
+    const long repeats = 30;
+    runBenchmark("utf8/compare", repeats * nameCount * nameCount, [&]() {
+        long total = 0;
+        for (long r = 0; r < repeats; r++)
+        {
+            for (int i = 0; i < nameCount; i++)
+            {
+                for (int j = 0; j < nameCount; j++)
+                    total += UTF8StringCompare(names[i], names[j], 64, true);
+            }
+        }
+        sink += (double) total;
+    });
+}
+
+
+static void benchTokenizer()
+{
+    // A synthetic catalog in ssc syntax; one parse of the whole text
+    // counts as one operation.
+    string text;
+    for (int i = 0; i < 200; i++)
+    {
+        ostringstream obj;
+        obj << "\"Object " << i << "\" \"Sol\"\n"
+            << "{\n"
+            << "    Radius " << 1000.0 + i << "\n"
+            << "    Oblateness 0.0034\n"
+            << "    Texture \"surface.png\"\n"
+            << "    EllipticalOrbit {\n"
+            << "        Period " << 1.0 + i * 0.25 << "\n"
+            << "        SemiMajorAxis " << 0.4 + i * 0.01 << "\n"
+            << "        Eccentricity 0.2056\n"
+            << "        Inclination 7.0049\n"
+            << "    }\n"
+            << "}\n\n";
+        text += obj.str();
+    }
+
+    const long repeats = 100;
+    runBenchmark("tokenizer/parse", repeats, [&]() {
+        long values = 0;
+        for (long r = 0; r < repeats; r++)
+        {
+            istringstream in(text);
+            Tokenizer tokenizer(&in);
+            Parser parser(&tokenizer);
+            while (tokenizer.nextToken() != Tokenizer::TokenEnd)
+            {
+                tokenizer.pushBack();
+                // Object name, parent name, then the property block
+                Value* v = parser.readValue();
+                if (v == nullptr)
+                    break;
+                delete v;
+                values++;
+            }
+        }
+        sink += (double) values;
+    });
+}
+
+
+static void benchKepler()
+{
+    // Mercury-like elements. Times advance monotonically, which is the
+    // common case in the simulation and exercises the warm-started
+    // Kepler solver.
+    EllipticalOrbit orbit(0.3075, 0.2056, 7.0049, 48.33, 29.12, 174.796, 87.969);
+    const long ops = 2000000;
+    runBenchmark("kepler/elliptical", ops, [&]() {
+        Vector3d total(Vector3d::Zero());
+        double t = 2451545.0;
+        for (long i = 0; i < ops; i++)
+        {
+            total += orbit.positionAtTime(t);
+            t += 0.0001;
+        }
+        sink += total.x();
+    });
+}
+
+
+static void benchVSOP87()
+{
+    Orbit* orbit = CreateVSOP87Orbit("vsop87-earth");
+    if (orbit == nullptr)
+        return;
+
+    const long ops = 100000;
+    runBenchmark("vsop87/earth", ops, [&]() {
+        Vector3d total(Vector3d::Zero());
+        double t = 2451545.0;
+        for (long i = 0; i < ops; i++)
+        {
+            total += orbit->positionAtTime(t);
+            t += 0.01;
+        }
+        sink += total.x();
+    });
+
+    delete orbit;
+}
+
+
+// Star octree build and traversal over a synthetic catalog; the
+// constants mirror the ones the star database uses.
+static const float OctreeRootSize = 1000000000.0f;
+static const float OctreeMagnitude = 6.0f;
+
+class CountingStarHandler : public StarHandler
+{
+public:
+    void process(const Star& /* star */, float /* distance */, float /* appMag */) override
+    {
+        count++;
+    }
+
+    long count{ 0 };
+};
+
+static void benchOctree()
+{
+    const int starCount = 200000;
+    vector<Star> stars(starCount);
+    StarDetails* details =
+        StarDetails::GetStarDetails(StellarClass(StellarClass::NormalStar,
+                                                 StellarClass::Spectral_G,
+                                                 2,
+                                                 StellarClass::Lum_V));
+    for (int i = 0; i < starCount; i++)
+    {
+        // Cluster most stars near the center like a real catalog so
+        // the tree actually acquires depth.
+        double r = pow(lcg(), 3.0) * 50000.0;
+        double theta = lcg() * 6.283185307;
+        double z = lcg() * 2.0 - 1.0;
+        double s = sqrt(1.0 - z * z);
+        stars[i].setPosition(Vector3f((float) (r * s * cos(theta)),
+                                      (float) (r * s * sin(theta)),
+                                      (float) (r * z)));
+        stars[i].setAbsoluteMagnitude((float) (lcg() * 14.0 - 2.0));
+        stars[i].setDetails(details);
+    }
+
+    StarOctree* octree = nullptr;
+    Star* sortedStars = nullptr;
+    {
+        float absMag = astro::appToAbsMag(OctreeMagnitude,
+                                          OctreeRootSize * (float) sqrt(3.0));
+        DynamicStarOctree* root =
+            new DynamicStarOctree(Vector3f(1000.0f, 1000.0f, 1000.0f), absMag);
+
+        Timer timer;
+        for (int i = 0; i < starCount; i++)
+            root->insertObject(stars[i], OctreeRootSize);
+        root->rebuildAndSort(octree, sortedStars);
+        double elapsed = timer.getTime();
+
+        BenchmarkResult result;
+        result.name = "octree/build";
+        result.nsPerOp = elapsed * 1.0e9 / (double) starCount;
+        results.push_back(result);
+        fmt::printf("%-24s %12.1f ns/op   (%d ops in %.3f s)\n",
+                    result.name, result.nsPerOp, starCount, elapsed);
+        delete root;
+    }
+
+    // Traverse from viewpoints orbiting the cluster, planes built the
+    // same way the star database builds them.
+    const long repeats = 400;
+    CountingStarHandler handler;
+    runBenchmark("octree/traverse", repeats, [&]() {
+        for (long r = 0; r < repeats; r++)
+        {
+            double angle = (double) r * 0.1;
+            Vector3f position((float) (cos(angle) * 20000.0),
+                              0.0f,
+                              (float) (sin(angle) * 20000.0));
+            Hyperplane<float, 3> frustumPlanes[5];
+            Vector3f planeNormals[5];
+            Matrix3f rot =
+                (Matrix3f) AngleAxisf((float) angle, Vector3f::UnitY());
+            float h = (float) tan(3.14159265 / 8.0);
+            float w = h * 1.5f;
+            planeNormals[0] = Vector3f(0.0f, 1.0f, -h);
+            planeNormals[1] = Vector3f(0.0f, -1.0f, -h);
+            planeNormals[2] = Vector3f(1.0f, 0.0f, -w);
+            planeNormals[3] = Vector3f(-1.0f, 0.0f, -w);
+            planeNormals[4] = Vector3f(0.0f, 0.0f, -1.0f);
+            for (int i = 0; i < 5; i++)
+            {
+                planeNormals[i] = rot.transpose() * planeNormals[i].normalized();
+                frustumPlanes[i] = Hyperplane<float, 3>(planeNormals[i], position);
+            }
+
+            octree->processVisibleObjects(handler, position, frustumPlanes,
+                                          OctreeMagnitude, OctreeRootSize);
+        }
+        sink += (double) handler.count;
+    });
+
+    delete octree;
+    delete[] sortedStars;
+}
+
+
+static bool saveBaseline(const string& filename)
+{
+    ofstream out(filename);
+    if (!out.good())
+        return false;
+    for (const auto& result : results)
+        out << result.name << ' ' << result.nsPerOp << '\n';
+    return out.good();
+}
+
+
+static bool checkBaseline(const string& filename, double tolerancePercent)
+{
+    ifstream in(filename);
+    if (!in.good())
+    {
+        fmt::fprintf(cerr, "Cannot read baseline %s\n", filename);
+        return false;
+    }
+
+    map<string, double> baseline;
+    string name;
+    double nsPerOp;
+    while (in >> name >> nsPerOp)
+        baseline[name] = nsPerOp;
+
+    bool ok = true;
+    for (const auto& result : results)
+    {
+        auto iter = baseline.find(result.name);
+        if (iter == baseline.end())
+        {
+            fmt::printf("%-24s (not in baseline)\n", result.name);
+            continue;
+        }
+
+        double limit = iter->second * (1.0 + tolerancePercent / 100.0);
+        if (result.nsPerOp > limit)
+        {
+            fmt::printf("%-24s REGRESSION: %.1f ns/op vs baseline %.1f (+%.0f%% allowed)\n",
+                        result.name, result.nsPerOp, iter->second,
+                        tolerancePercent);
+            ok = false;
+        }
+        else
+        {
+            fmt::printf("%-24s ok: %.1f ns/op vs baseline %.1f\n",
+                        result.name, result.nsPerOp, iter->second);
+        }
+    }
+
+    return ok;
+}
+
+
+int main(int argc, char* argv[])
+{
+    string saveFile;
+    string checkFile;
+    double tolerance = 25.0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            saveFile = argv[++i];
+        else if (strcmp(argv[i], "--check") == 0 && i + 1 < argc)
+            checkFile = argv[++i];
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+            tolerance = atof(argv[++i]);
+        else
+        {
+            fmt::fprintf(cerr,
+                         "Usage: %s [--save baseline.txt] [--check baseline.txt] [--tolerance pct]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    benchBigFix();
+    benchFrustum();
+    benchUTF8Compare();
+    benchTokenizer();
+    benchKepler();
+    benchVSOP87();
+    benchOctree();
+
+    if (!saveFile.empty() && !saveBaseline(saveFile))
+    {
+        fmt::fprintf(cerr, "Cannot write baseline %s\n", saveFile);
+        return 1;
+    }
+
+    if (!checkFile.empty())
+    {
+        fmt::printf("\nChecking against %s (tolerance %.0f%%):\n",
+                    checkFile, tolerance);
+        if (!checkBaseline(checkFile, tolerance))
+            return 1;
+    }
+
+    return 0;
+}
@@ -14,6 +14,8 @@
 #include <celmath/mathlib.h>
 #include <Eigen/Core>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include <vector>
 #ifdef TRISTRIP
 #include <NvTriStrip.h>
@@ -1297,6 +1299,54 @@ GenerateModelNormals(const Model& model, float smoothAngle, bool weldVertices, f
 }
 
 
+unsigned int
+DefaultJobCount()
+{
+    unsigned int n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+
+/*! Apply an operation to every mesh in a model, processing up to jobs
+ *  meshes concurrently. Meshes are claimed one at a time from a shared
+ *  counter so that large and small meshes balance themselves across
+ *  threads; the calling thread participates in the work. The operation
+ *  is handed the mesh and its index in the model, and must not touch
+ *  any mesh other than its own.
+ */
+void
+ForEachMesh(const Model& model,
+            unsigned int jobs,
+            const std::function<void(Mesh&, uint32_t)>& op)
+{
+    uint32_t meshCount = model.getMeshCount();
+    if (jobs <= 1 || meshCount <= 1)
+    {
+        for (uint32_t i = 0; i < meshCount; i++)
+            op(*model.getMesh(i), i);
+        return;
+    }
+
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]() {
+        for (;;)
+        {
+            uint32_t i = next.fetch_add(1);
+            if (i >= meshCount)
+                return;
+            op(*model.getMesh(i), i);
+        }
+    };
+
+    vector<std::thread> pool;
+    for (unsigned int t = 1; t < min(jobs, meshCount); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (auto& th : pool)
+        th.join();
+}
+
+
 #ifdef TRISTRIP
 bool
 convertToStrips(Mesh& mesh)
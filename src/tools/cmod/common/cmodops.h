@@ -14,6 +14,7 @@
 
 #include <celmodel/model.h>
 #include <Eigen/Core>
+#include <functional>
 #include <vector>
 
 
@@ -47,6 +48,16 @@ extern bool UniquifyVertices(cmod::Mesh& mesh);
 extern cmod::Model* MergeModelMeshes(const cmod::Model& model);
 extern cmod::Model* GenerateModelNormals(const cmod::Model& model, float smoothAngle, bool weldVertices, float weldTolerance);
 
+#ifdef TRISTRIP
+extern bool convertToStrips(cmod::Mesh& mesh);
+#endif
+
+// Parallel mesh processing
+extern unsigned int DefaultJobCount();
+extern void ForEachMesh(const cmod::Model& model,
+                        unsigned int jobs,
+                        const std::function<void(cmod::Mesh&, uint32_t)>& op);
+
 
 template<typename T, typename U> void
 JoinVertices(std::vector<Face>& faces,
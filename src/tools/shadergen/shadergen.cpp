@@ -0,0 +1,159 @@
+// shadergen.cpp
+//
+// Build-time generator for precompiled shader sources. Reads a trace of
+// frequently used ShaderProperties permutations (one per line) and emits
+// a C++ translation unit with the assembled GLSL sources, so common
+// bodies skip the string-assembly path at runtime. See shaders.trace for
+// the input format.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <celengine/shadermanager.h>
+#include <GL/glew.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// Parse one trace line of the form
+//   nLights texUsage lightModel effects shadowCounts simpleProps
+// Fields may be decimal or 0x-prefixed hex. Returns false for comments
+// and malformed lines.
+static bool ParseTraceLine(const string& line, ShaderProperties& props)
+{
+    string trimmed = line.substr(0, line.find('#'));
+
+    istringstream in(trimmed);
+    string fields[6];
+    for (auto& field : fields)
+    {
+        if (!(in >> field))
+            return false;
+    }
+
+    props.nLights      = (unsigned short) strtoul(fields[0].c_str(), nullptr, 0);
+    props.texUsage     = (unsigned short) strtoul(fields[1].c_str(), nullptr, 0);
+    props.lightModel   = (unsigned short) strtoul(fields[2].c_str(), nullptr, 0);
+    props.effects      = (unsigned short) strtoul(fields[3].c_str(), nullptr, 0);
+    props.shadowCounts = (uint32_t) strtoul(fields[4].c_str(), nullptr, 0);
+    props.simpleProps  = (uint32_t) strtoul(fields[5].c_str(), nullptr, 0);
+
+    return true;
+}
+
+
+static void EmitSource(ostream& out, const string& source)
+{
+    out << "R\"glsl(" << source << ")glsl\"";
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        cerr << "Usage: shadergen <trace file> <output file>\n";
+        return 1;
+    }
+
+#if defined(GLEW_ARB_shader_texture_lod) && defined(GLEW_GET_VAR)
+    // The assembled ring shadow code depends on this extension; assume
+    // it is present. The runtime lookup skips the precompiled table when
+    // it is not.
+    __GLEW_ARB_shader_texture_lod = GL_TRUE;
+#endif
+
+    ifstream traceFile(argv[1]);
+    if (!traceFile.good())
+    {
+        cerr << "Error opening trace file " << argv[1] << '\n';
+        return 1;
+    }
+
+    vector<ShaderProperties> propsList;
+    string line;
+    while (getline(traceFile, line))
+    {
+        ShaderProperties props;
+        if (ParseTraceLine(line, props))
+            propsList.push_back(props);
+    }
+
+    ofstream out(argv[2]);
+    if (!out.good())
+    {
+        cerr << "Error creating output file " << argv[2] << '\n';
+        return 1;
+    }
+
+    out << "// Generated by shadergen from " << argv[1] << "; do not edit.\n\n";
+    out << "#include <celengine/shadermanager.h>\n\n";
+
+    out << "static ShaderProperties\n"
+           "MakeProps(unsigned short nLights, unsigned short texUsage,\n"
+           "          unsigned short lightModel, unsigned short effects,\n"
+           "          uint32_t shadowCounts, uint32_t simpleProps)\n"
+           "{\n"
+           "    ShaderProperties props;\n"
+           "    props.nLights      = nLights;\n"
+           "    props.texUsage     = texUsage;\n"
+           "    props.lightModel   = lightModel;\n"
+           "    props.effects      = effects;\n"
+           "    props.shadowCounts = shadowCounts;\n"
+           "    props.simpleProps  = simpleProps;\n"
+           "    return props;\n"
+           "}\n\n";
+
+    out << "static const PrecompiledShaderSource precompiledSources[] =\n{\n";
+
+    unsigned int count = 0;
+    for (const auto& props : propsList)
+    {
+        string vsSource;
+        string fsSource;
+        ShaderManager::buildShaderSources(props, vsSource, fsSource);
+
+        if (vsSource.find(")glsl\"") != string::npos ||
+            fsSource.find(")glsl\"") != string::npos)
+        {
+            cerr << "Assembled source breaks the raw literal delimiter; skipping entry\n";
+            continue;
+        }
+
+        out << "    {\n"
+            << "        MakeProps(" << props.nLights
+            << ", 0x" << hex << props.texUsage
+            << ", " << dec << props.lightModel
+            << ", 0x" << hex << props.effects
+            << ", 0x" << props.shadowCounts
+            << ", 0x" << props.simpleProps << dec << "),\n";
+        out << "        ";
+        EmitSource(out, vsSource);
+        out << ",\n        ";
+        EmitSource(out, fsSource);
+        out << "\n    },\n";
+        count++;
+    }
+
+    out << "};\n\n";
+    out << "const PrecompiledShaderSource* PrecompiledShaderSources = precompiledSources;\n";
+    out << "const unsigned int PrecompiledShaderSourceCount = " << count << ";\n";
+
+    if (!out.good())
+    {
+        cerr << "Error writing output file " << argv[2] << '\n';
+        return 1;
+    }
+
+    cout << "Wrote " << count << " precompiled shader variants to " << argv[2] << '\n';
+
+    return 0;
+}
@@ -11,9 +11,13 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include <cctype>
 #include <cassert>
+#include <cmath>
+#include <vector>
 #include <celutil/bytes.h>
 #include <celengine/astro.h>
 #include <celengine/star.h>
@@ -24,6 +28,7 @@ using namespace std;
 static string inputFilename;
 static string outputFilename;
 static bool useSphericalCoords = false;
+static bool useCompactFormat = false;
 
 
 void Usage()
@@ -31,6 +36,7 @@ void Usage()
     cerr << "Usage: makestardb [options] <input file> <output star database>\n";
     cerr << "  Options:\n";
     cerr << "    --spherical (or -s) : input file has spherical coords (RA/dec/distance\n";
+    cerr << "    --compact (or -c)   : write the compact tiered (version 0x0301) format\n";
 }
 
 
@@ -47,6 +53,10 @@ bool parseCommandLine(int argc, char* argv[])
             {
                 useSphericalCoords = true;
             }
+            else if (!strcmp(argv[i], "--compact") || !strcmp(argv[i], "-c"))
+            {
+                useCompactFormat = true;
+            }
             else
             {
                 cerr << "Unknown command line switch: " << argv[i] << '\n';
@@ -106,25 +116,38 @@ static void writeShort(ostream& out, int16_t n)
 }
 
 
-bool WriteStarDatabase(istream& in, ostream& out, bool sphericalCoords)
+static void writeVarint(ostream& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.put((char) ((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.put((char) value);
+}
+
+
+struct StarRecord
+{
+    uint32_t catalogNumber;
+    float x, y, z;
+    int16_t packedMag;
+    uint16_t spectralType;
+};
+
+
+bool ReadStarRecords(istream& in, bool sphericalCoords, vector<StarRecord>& stars)
 {
-    unsigned int record = 0;
     unsigned int nStarsInFile = 0;
 
     in >> nStarsInFile;
     if (!in.good())
     {
         cerr << "Error reading star count at beginning of input file.\n";
-        return 1;
+        return false;
     }
 
-    // Write the header
-    out.write("CELSTARS", 8);
-
-    // Write the version
-    writeShort(out, 0x0100);
-
-    writeUint(out, nStarsInFile);
+    stars.reserve(nStarsInFile);
 
     for (unsigned int record = 0; record < nStarsInFile; record++)
     {
@@ -202,18 +225,207 @@ bool WriteStarDatabase(istream& in, ostream& out, bool sphericalCoords)
         cout << scString << ' ' << details->getSpectralType() << '\n';
 #endif
 
-        writeUint(out, catalogNumber);
-        writeFloat(out, x);
-        writeFloat(out, y);
-        writeFloat(out, z);
-        writeShort(out, (int16_t) (absMag * 256.0f));
-        writeUshort(out, sc.pack());
+        StarRecord star;
+        star.catalogNumber = catalogNumber;
+        star.x = x;
+        star.y = y;
+        star.z = z;
+        star.packedMag = (int16_t) (absMag * 256.0f);
+        star.spectralType = sc.pack();
+        stars.push_back(star);
     }
 
     return true;
 }
 
 
+bool WriteStarDatabase(const vector<StarRecord>& stars, ostream& out)
+{
+    // Write the header
+    out.write("CELSTARS", 8);
+
+    // Write the version
+    writeShort(out, 0x0100);
+
+    writeUint(out, (uint32_t) stars.size());
+
+    for (const auto& star : stars)
+    {
+        writeUint(out, star.catalogNumber);
+        writeFloat(out, star.x);
+        writeFloat(out, star.y);
+        writeFloat(out, star.z);
+        writeShort(out, star.packedMag);
+        writeUshort(out, star.spectralType);
+    }
+
+    return true;
+}
+
+
+// The compact format groups stars by the leaf cubes of an octree
+// subdivision, stored in traversal order. Within a group, positions
+// quantize to 16 bits per axis relative to the group cube, spectral
+// types index a per-group palette, and catalog numbers are sorted and
+// delta coded as varints, cutting a typical record from 20 bytes to
+// around half that. Quantization error is bounded by the leaf cube
+// size, which shrinks wherever stars are dense. The tiered version
+// (0x0301) written here also records each group's brightest absolute
+// magnitude, so the loader can defer decoding of groups too faint to
+// be seen until an observer gets close enough.
+
+static const size_t CompactGroupMaxStars = 256;
+static const int CompactMaxDepth = 24;
+
+struct CompactGroup
+{
+    float cx, cy, cz;
+    float halfSize;
+    vector<const StarRecord*> stars;
+};
+
+
+static void collectCompactGroups(vector<const StarRecord*>& stars,
+                                 float cx, float cy, float cz, float halfSize,
+                                 int depth,
+                                 vector<CompactGroup>& groups)
+{
+    if (stars.size() <= CompactGroupMaxStars || depth >= CompactMaxDepth)
+    {
+        // Delta coding wants ascending catalog numbers; a leaf past the
+        // depth limit is split into several groups sharing one cube.
+        sort(stars.begin(), stars.end(),
+             [](const StarRecord* a, const StarRecord* b) {
+                 return a->catalogNumber < b->catalogNumber;
+             });
+        for (size_t first = 0; first < stars.size(); first += CompactGroupMaxStars)
+        {
+            size_t count = min(CompactGroupMaxStars, stars.size() - first);
+            CompactGroup group;
+            group.cx = cx;
+            group.cy = cy;
+            group.cz = cz;
+            group.halfSize = halfSize;
+            group.stars.assign(stars.begin() + first, stars.begin() + first + count);
+            groups.push_back(group);
+        }
+        return;
+    }
+
+    vector<const StarRecord*> children[8];
+    for (const StarRecord* star : stars)
+    {
+        int child = (star->x >= cx ? 1 : 0) |
+                    (star->y >= cy ? 2 : 0) |
+                    (star->z >= cz ? 4 : 0);
+        children[child].push_back(star);
+    }
+    stars.clear();
+    stars.shrink_to_fit();
+
+    float quarter = halfSize * 0.5f;
+    for (int child = 0; child < 8; child++)
+    {
+        if (children[child].empty())
+            continue;
+        collectCompactGroups(children[child],
+                             cx + ((child & 1) ? quarter : -quarter),
+                             cy + ((child & 2) ? quarter : -quarter),
+                             cz + ((child & 4) ? quarter : -quarter),
+                             quarter, depth + 1, groups);
+    }
+}
+
+
+static uint16_t quantizeCoord(float value, float corner, float edge)
+{
+    float q = (value - corner) / edge * 65535.0f + 0.5f;
+    if (q < 0.0f)
+        q = 0.0f;
+    if (q > 65535.0f)
+        q = 65535.0f;
+    return (uint16_t) q;
+}
+
+
+bool WriteCompactStarDatabase(const vector<StarRecord>& stars, ostream& out)
+{
+    out.write("CELSTARS", 8);
+    writeShort(out, 0x0301);
+    writeUint(out, (uint32_t) stars.size());
+
+    // Root cube centered at the origin, just covering every star
+    float maxCoord = 1.0f;
+    for (const auto& star : stars)
+    {
+        maxCoord = max(maxCoord, fabsf(star.x));
+        maxCoord = max(maxCoord, fabsf(star.y));
+        maxCoord = max(maxCoord, fabsf(star.z));
+    }
+
+    vector<const StarRecord*> all;
+    all.reserve(stars.size());
+    for (const auto& star : stars)
+        all.push_back(&star);
+
+    vector<CompactGroup> groups;
+    collectCompactGroups(all, 0.0f, 0.0f, 0.0f, maxCoord, 0, groups);
+
+    writeUint(out, (uint32_t) groups.size());
+    for (const auto& group : groups)
+    {
+        // Per-group spectral type palette in first-appearance order
+        vector<uint16_t> palette;
+        for (const StarRecord* star : group.stars)
+        {
+            if (find(palette.begin(), palette.end(), star->spectralType) == palette.end())
+                palette.push_back(star->spectralType);
+        }
+
+        float cornerX = group.cx - group.halfSize;
+        float cornerY = group.cy - group.halfSize;
+        float cornerZ = group.cz - group.halfSize;
+        float edge = group.halfSize * 2.0f;
+
+        ostringstream records(ios::out | ios::binary);
+        uint32_t prevCatalogNumber = 0;
+        for (const StarRecord* star : group.stars)
+        {
+            writeVarint(records, star->catalogNumber - prevCatalogNumber);
+            prevCatalogNumber = star->catalogNumber;
+            writeUshort(records, quantizeCoord(star->x, cornerX, edge));
+            writeUshort(records, quantizeCoord(star->y, cornerY, edge));
+            writeUshort(records, quantizeCoord(star->z, cornerZ, edge));
+            writeShort(records, star->packedMag);
+            size_t paletteIndex = find(palette.begin(), palette.end(), star->spectralType) -
+                                  palette.begin();
+            records.put((char) (uint8_t) paletteIndex);
+        }
+        string recordBytes = records.str();
+
+        // Brightest (minimum) member magnitude; the loader defers
+        // groups whose brightest member is too faint to be seen
+        int16_t brightestMag = group.stars.front()->packedMag;
+        for (const StarRecord* star : group.stars)
+            brightestMag = min(brightestMag, star->packedMag);
+
+        writeFloat(out, group.cx);
+        writeFloat(out, group.cy);
+        writeFloat(out, group.cz);
+        writeFloat(out, group.halfSize);
+        writeShort(out, brightestMag);
+        writeUint(out, (uint32_t) recordBytes.size());
+        writeUshort(out, (uint16_t) group.stars.size());
+        writeUshort(out, (uint16_t) palette.size());
+        for (uint16_t entry : palette)
+            writeUshort(out, entry);
+        out.write(recordBytes.data(), recordBytes.size());
+    }
+
+    return out.good();
+}
+
+
 int main(int argc, char* argv[])
 {
     if (!parseCommandLine(argc, argv) || inputFilename.empty())
@@ -236,7 +448,12 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    bool success = WriteStarDatabase(inputFile, stardbFile, useSphericalCoords);
+    vector<StarRecord> stars;
+    if (!ReadStarRecords(inputFile, useSphericalCoords, stars))
+        return 1;
+
+    bool success = useCompactFormat ? WriteCompactStarDatabase(stars, stardbFile)
+                                    : WriteStarDatabase(stars, stardbFile);
 
     return success ? 0 : 1;
 }
@@ -0,0 +1,315 @@
+// startupcheck.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// Startup-time regression checker for phase profiler reports.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Compares two startup profile reports written by the phase profiler
+// (run Celestia with CELESTIA_PROFILE_STARTUP=<file> against a pinned
+// dataset to produce one) and fails when any phase runs over its
+// budget -- the baseline time plus a relative tolerance. Output is one
+// CSV row per phase, so CI can both gate on the exit status and archive
+// the numbers:
+//
+//     startupcheck [--tolerance <percent>] [--min-ms <ms>] baseline.json current.json
+//
+// Phases faster than --min-ms in the baseline are reported but never
+// fail the check; at that scale timer noise outweighs any real
+// regression. Phases present on only one side are flagged as added or
+// removed without failing, since add-ons legitimately change the
+// phase list. Exit status: 0 within budget, 1 regression, 2 bad usage
+// or unreadable report.
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+struct PhaseTime
+{
+    double seconds{ 0.0 };
+    bool present{ false };
+};
+
+
+// Minimal recursive-descent reader for the profiler's report format:
+// objects with "name", "seconds" and an optional "children" array.
+// Phases are flattened to slash-separated paths.
+class ReportReader
+{
+ public:
+    ReportReader(istream& _in) :
+        in(_in)
+    {
+    }
+
+    bool read(map<string, PhaseTime>& phases)
+    {
+        skipSpace();
+        if (!expect('{'))
+            return false;
+        if (!readString(scratch) || scratch != "phases")
+            return false;
+        skipSpace();
+        if (!expect(':'))
+            return false;
+        if (!readPhaseArray(phases, ""))
+            return false;
+        skipSpace();
+        return expect('}');
+    }
+
+ private:
+    bool readPhaseArray(map<string, PhaseTime>& phases, const string& prefix)
+    {
+        skipSpace();
+        if (!expect('['))
+            return false;
+        for (;;)
+        {
+            skipSpace();
+            if (in.peek() == ']')
+            {
+                in.get();
+                return true;
+            }
+            if (!readPhase(phases, prefix))
+                return false;
+            skipSpace();
+            if (in.peek() == ',')
+                in.get();
+        }
+    }
+
+    bool readPhase(map<string, PhaseTime>& phases, const string& prefix)
+    {
+        skipSpace();
+        if (!expect('{'))
+            return false;
+
+        string name;
+        double seconds = 0.0;
+        bool haveChildren = false;
+        string path;
+
+        for (;;)
+        {
+            if (!readString(scratch))
+                return false;
+            skipSpace();
+            if (!expect(':'))
+                return false;
+            skipSpace();
+
+            if (scratch == "name")
+            {
+                if (!readString(name))
+                    return false;
+                path = prefix.empty() ? name : prefix + "/" + name;
+            }
+            else if (scratch == "seconds")
+            {
+                in >> seconds;
+                if (!in.good())
+                    return false;
+            }
+            else if (scratch == "children")
+            {
+                if (path.empty() || !readPhaseArray(phases, path))
+                    return false;
+                haveChildren = true;
+            }
+            else
+            {
+                return false;
+            }
+
+            skipSpace();
+            int c = in.get();
+            if (c == '}')
+                break;
+            if (c != ',')
+                return false;
+            skipSpace();
+        }
+
+        if (path.empty())
+            return false;
+
+        // A phase with children reports its own time too; keep the
+        // parent so whole-stage budgets (e.g. all of initRenderer)
+        // are checked alongside the individual loads.
+        (void) haveChildren;
+        phases[path].seconds = seconds;
+        phases[path].present = true;
+        return true;
+    }
+
+    bool readString(string& s)
+    {
+        skipSpace();
+        if (!expect('"'))
+            return false;
+        s.clear();
+        for (;;)
+        {
+            int c = in.get();
+            if (c == EOF)
+                return false;
+            if (c == '"')
+                return true;
+            if (c == '\\')
+            {
+                c = in.get();
+                if (c == EOF)
+                    return false;
+            }
+            s += (char) c;
+        }
+    }
+
+    bool expect(char c)
+    {
+        skipSpace();
+        return in.get() == c;
+    }
+
+    void skipSpace()
+    {
+        while (isspace(in.peek()))
+            in.get();
+    }
+
+    istream& in;
+    string scratch;
+};
+
+
+static bool loadReport(const char* filename, map<string, PhaseTime>& phases)
+{
+    ifstream in(filename);
+    if (!in.good())
+    {
+        fprintf(stderr, "startupcheck: cannot open %s\n", filename);
+        return false;
+    }
+
+    ReportReader reader(in);
+    if (!reader.read(phases))
+    {
+        fprintf(stderr, "startupcheck: %s is not a startup profile report\n",
+                filename);
+        return false;
+    }
+    return true;
+}
+
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: startupcheck [--tolerance <percent>] [--min-ms <ms>] "
+            "baseline.json current.json\n");
+}
+
+
+int main(int argc, char* argv[])
+{
+    double tolerance = 10.0;
+    double minMs = 20.0;
+    const char* baselineFile = nullptr;
+    const char* currentFile = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            tolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc)
+        {
+            minMs = atof(argv[++i]);
+        }
+        else if (baselineFile == nullptr)
+        {
+            baselineFile = argv[i];
+        }
+        else if (currentFile == nullptr)
+        {
+            currentFile = argv[i];
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if (baselineFile == nullptr || currentFile == nullptr)
+    {
+        usage();
+        return 2;
+    }
+
+    map<string, PhaseTime> baseline;
+    map<string, PhaseTime> current;
+    if (!loadReport(baselineFile, baseline) ||
+        !loadReport(currentFile, current))
+        return 2;
+
+    printf("phase,baseline_ms,current_ms,delta_pct,status\n");
+
+    int regressions = 0;
+    for (const auto& entry : baseline)
+    {
+        const string& path = entry.first;
+        double baseMs = entry.second.seconds * 1000.0;
+
+        auto it = current.find(path);
+        if (it == current.end())
+        {
+            printf("%s,%.2f,,,removed\n", path.c_str(), baseMs);
+            continue;
+        }
+
+        double curMs = it->second.seconds * 1000.0;
+        double deltaPct = baseMs > 0.0
+            ? (curMs - baseMs) / baseMs * 100.0 : 0.0;
+
+        const char* status = "ok";
+        if (deltaPct > tolerance && baseMs >= minMs)
+        {
+            status = "regressed";
+            regressions++;
+        }
+        printf("%s,%.2f,%.2f,%+.1f,%s\n",
+               path.c_str(), baseMs, curMs, deltaPct, status);
+    }
+
+    for (const auto& entry : current)
+    {
+        if (baseline.find(entry.first) == baseline.end())
+            printf("%s,,%.2f,,added\n",
+                   entry.first.c_str(), entry.second.seconds * 1000.0);
+    }
+
+    if (regressions > 0)
+    {
+        fprintf(stderr, "startupcheck: %d phase%s over budget (>%.0f%%)\n",
+                regressions, regressions == 1 ? "" : "s", tolerance);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,553 @@
+// synthcat.cpp
+//
+// Copyright (C) 2026, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Generate synthetic star, deep sky and solar system catalogs for
+// load testing. Real catalogs top out around 120,000 stars, so octree,
+// loader and renderer scaling work needs fabricated datasets; this
+// tool produces them reproducibly from a seed instead of ad hoc
+// scripts. Star output is written both as the makestardb text format
+// and directly as a version 0x0100 CELSTARS database (pipe the text
+// through makestardb --compact for the tiered format); deep sky
+// objects and planetary systems are written as ordinary .dsc and .ssc
+// files. Stars stream straight to disk as they are generated, so
+// catalog size is limited by disk space rather than memory --
+// a billion-star run needs no more RAM than a thousand-star one.
+//
+// The spatial distribution is selectable: uniform fills a sphere,
+// disc approximates a galactic disc (exponential radial falloff with
+// a thin gaussian height), and cluster scatters dense gaussian clumps
+// through the volume to stress deep octree subdivision. A binary
+// fraction emits close companion pairs, the worst case for octree
+// leaf splitting.
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <celutil/bytes.h>
+#include <celengine/stellarclass.h>
+
+using namespace std;
+
+
+static string outputPrefix;
+static unsigned int starCount = 100000;
+static unsigned int dsoCount = 0;
+static unsigned int systemCount = 0;
+static float radius = 16000.0f;
+static string distribution = "uniform";
+static unsigned int clusterCount = 50;
+static float binaryFraction = 0.0f;
+static float nameDensity = 0.01f;
+static uint64_t seed = 1;
+static bool textOnly = false;
+static bool binaryOnly = false;
+
+
+void Usage()
+{
+    cerr << "Usage: synthcat [options] <output prefix>\n";
+    cerr << "  Options:\n";
+    cerr << "    --stars <count>           : number of stars (default 100000)\n";
+    cerr << "    --dsos <count>            : number of deep sky objects (default 0)\n";
+    cerr << "    --systems <count>         : number of planetary systems (default 0)\n";
+    cerr << "    --radius <ly>             : radius of the star volume (default 16000)\n";
+    cerr << "    --distribution <name>     : uniform, disc or cluster (default uniform)\n";
+    cerr << "    --clusters <count>        : clump count for cluster mode (default 50)\n";
+    cerr << "    --binary-fraction <frac>  : fraction of stars with a close companion\n";
+    cerr << "    --name-density <frac>     : fraction of stars given a name (default 0.01)\n";
+    cerr << "    --seed <n>                : random seed (default 1)\n";
+    cerr << "    --text-only               : skip the binary star database\n";
+    cerr << "    --binary-only             : skip the text star catalog\n";
+}
+
+
+bool parseCommandLine(int argc, char* argv[])
+{
+    int i = 1;
+    int fileCount = 0;
+
+    while (i < argc)
+    {
+        if (argv[i][0] == '-')
+        {
+            bool hasValue = i + 1 < argc;
+            if (!strcmp(argv[i], "--stars") && hasValue)
+                starCount = (unsigned int) strtoul(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--dsos") && hasValue)
+                dsoCount = (unsigned int) strtoul(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--systems") && hasValue)
+                systemCount = (unsigned int) strtoul(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--radius") && hasValue)
+                radius = (float) atof(argv[++i]);
+            else if (!strcmp(argv[i], "--distribution") && hasValue)
+                distribution = argv[++i];
+            else if (!strcmp(argv[i], "--clusters") && hasValue)
+                clusterCount = (unsigned int) strtoul(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--binary-fraction") && hasValue)
+                binaryFraction = (float) atof(argv[++i]);
+            else if (!strcmp(argv[i], "--name-density") && hasValue)
+                nameDensity = (float) atof(argv[++i]);
+            else if (!strcmp(argv[i], "--seed") && hasValue)
+                seed = strtoull(argv[++i], nullptr, 10);
+            else if (!strcmp(argv[i], "--text-only"))
+                textOnly = true;
+            else if (!strcmp(argv[i], "--binary-only"))
+                binaryOnly = true;
+            else
+            {
+                cerr << "Unknown command line switch: " << argv[i] << '\n';
+                return false;
+            }
+            i++;
+        }
+        else
+        {
+            if (fileCount == 0)
+            {
+                outputPrefix = string(argv[i]);
+                fileCount++;
+            }
+            else
+            {
+                return false;
+            }
+            i++;
+        }
+    }
+
+    if (distribution != "uniform" && distribution != "disc" &&
+        distribution != "cluster")
+    {
+        cerr << "Unknown distribution: " << distribution << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+
+// Small deterministic generator so the same seed yields the same
+// catalog on every platform; implementations of <random> engines are
+// standardized but the distributions are not.
+class RandomStream
+{
+ public:
+    RandomStream(uint64_t _state) :
+        state(_state)
+    {
+    }
+
+    uint64_t next()
+    {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 16;
+    }
+
+    // Uniform in [0, 1)
+    double frand()
+    {
+        return (double) (next() & 0xffffffffULL) / 4294967296.0;
+    }
+
+    double frand(double minValue, double maxValue)
+    {
+        return minValue + frand() * (maxValue - minValue);
+    }
+
+    // Standard normal deviate via Box-Muller
+    double gaussian()
+    {
+        double u1 = frand();
+        double u2 = frand();
+        if (u1 < 1.0e-12)
+            u1 = 1.0e-12;
+        return sqrt(-2.0 * log(u1)) * cos(2.0 * 3.14159265358979323846 * u2);
+    }
+
+    // Uniformly distributed direction
+    void direction(double& x, double& y, double& z)
+    {
+        double cosTheta = frand(-1.0, 1.0);
+        double sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+        double phi = frand(0.0, 2.0 * 3.14159265358979323846);
+        x = sinTheta * cos(phi);
+        y = sinTheta * sin(phi);
+        z = cosTheta;
+    }
+
+ private:
+    uint64_t state;
+};
+
+
+static void writeUint(ostream& out, uint32_t n)
+{
+    LE_TO_CPU_INT32(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+static void writeFloat(ostream& out, float f)
+{
+    LE_TO_CPU_FLOAT(f, f);
+    out.write(reinterpret_cast<char*>(&f), sizeof f);
+}
+
+static void writeUshort(ostream& out, uint16_t n)
+{
+    LE_TO_CPU_INT16(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+static void writeShort(ostream& out, int16_t n)
+{
+    LE_TO_CPU_INT16(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+
+// Main sequence spectral classes with their approximate frequencies
+// and absolute magnitudes. The mix only needs to be plausible: bright
+// rare classes dominate the visible set at a distance while faint
+// common ones dominate the near field, which is the load pattern the
+// renderer and octree see with real catalogs.
+struct SpectralBin
+{
+    StellarClass::SpectralClass spectralClass;
+    const char* label;
+    double frequency;
+    double absMag;
+};
+
+static const SpectralBin spectralBins[] =
+{
+    { StellarClass::Spectral_O, "O", 0.0003, -5.5 },
+    { StellarClass::Spectral_B, "B", 0.0013, -1.5 },
+    { StellarClass::Spectral_A, "A", 0.0060,  1.5 },
+    { StellarClass::Spectral_F, "F", 0.0300,  3.3 },
+    { StellarClass::Spectral_G, "G", 0.0760,  4.9 },
+    { StellarClass::Spectral_K, "K", 0.1210,  6.6 },
+    { StellarClass::Spectral_M, "M", 0.7654, 10.5 },
+};
+
+
+struct SyntheticStar
+{
+    uint32_t catalogNumber;
+    float x, y, z;
+    float absMag;
+    unsigned int subclass;
+    const SpectralBin* bin;
+};
+
+
+static void samplePosition(RandomStream& rng,
+                           const vector<float>& clusterCenters,
+                           float& x, float& y, float& z)
+{
+    if (distribution == "disc")
+    {
+        // Exponential surface density with scale length radius / 4 and
+        // a gaussian height of radius / 50, roughly the Milky Way's
+        // aspect ratio. The disc lies in the xz plane, matching
+        // Celestia's celestial coordinate convention where y points
+        // toward the north celestial pole.
+        double r = -log(1.0 - rng.frand()) * (radius / 4.0);
+        if (r > radius)
+            r = radius;
+        double phi = rng.frand(0.0, 2.0 * 3.14159265358979323846);
+        x = (float) (r * cos(phi));
+        z = (float) (r * sin(phi));
+        y = (float) (rng.gaussian() * (radius / 50.0));
+    }
+    else if (distribution == "cluster")
+    {
+        size_t cluster = (size_t) (rng.frand() * (clusterCenters.size() / 3));
+        double dx, dy, dz;
+        rng.direction(dx, dy, dz);
+        double r = fabs(rng.gaussian()) * (radius / 200.0);
+        x = clusterCenters[cluster * 3]     + (float) (dx * r);
+        y = clusterCenters[cluster * 3 + 1] + (float) (dy * r);
+        z = clusterCenters[cluster * 3 + 2] + (float) (dz * r);
+    }
+    else
+    {
+        // Uniform density in a sphere
+        double dx, dy, dz;
+        rng.direction(dx, dy, dz);
+        double r = radius * cbrt(rng.frand());
+        x = (float) (dx * r);
+        y = (float) (dy * r);
+        z = (float) (dz * r);
+    }
+}
+
+
+static SyntheticStar sampleStar(RandomStream& rng, uint32_t catalogNumber)
+{
+    SyntheticStar star;
+    star.catalogNumber = catalogNumber;
+
+    double p = rng.frand();
+    star.bin = &spectralBins[sizeof(spectralBins) / sizeof(spectralBins[0]) - 1];
+    for (const SpectralBin& bin : spectralBins)
+    {
+        if (p < bin.frequency)
+        {
+            star.bin = &bin;
+            break;
+        }
+        p -= bin.frequency;
+    }
+
+    star.subclass = (unsigned int) (rng.frand() * 10.0);
+    star.absMag = (float) (star.bin->absMag + rng.gaussian() * 0.75);
+    return star;
+}
+
+
+static void emitStar(const SyntheticStar& star, ostream* text, ostream* binary)
+{
+    if (text != nullptr)
+    {
+        *text << star.catalogNumber << ' '
+              << star.x << ' ' << star.y << ' ' << star.z << ' '
+              << star.absMag << ' '
+              << star.bin->label << star.subclass << "V\n";
+    }
+
+    if (binary != nullptr)
+    {
+        StellarClass sc(StellarClass::NormalStar,
+                        star.bin->spectralClass,
+                        star.subclass,
+                        StellarClass::Lum_V);
+        writeUint(*binary, star.catalogNumber);
+        writeFloat(*binary, star.x);
+        writeFloat(*binary, star.y);
+        writeFloat(*binary, star.z);
+        writeShort(*binary, (int16_t) (star.absMag * 256.0f));
+        writeUshort(*binary, sc.pack());
+    }
+}
+
+
+static bool generateStars(vector<uint32_t>& systemStars)
+{
+    ofstream textFile;
+    ofstream binaryFile;
+    ofstream nameFile;
+
+    if (!binaryOnly)
+    {
+        textFile.open(outputPrefix + ".txt", ios::out);
+        if (!textFile.good())
+        {
+            cerr << "Error opening " << outputPrefix << ".txt\n";
+            return false;
+        }
+        textFile << starCount << '\n';
+    }
+
+    if (!textOnly)
+    {
+        binaryFile.open(outputPrefix + ".dat", ios::out | ios::binary);
+        if (!binaryFile.good())
+        {
+            cerr << "Error opening " << outputPrefix << ".dat\n";
+            return false;
+        }
+        binaryFile.write("CELSTARS", 8);
+        writeShort(binaryFile, 0x0100);
+        writeUint(binaryFile, starCount);
+    }
+
+    if (nameDensity > 0.0f)
+    {
+        nameFile.open(outputPrefix + "-names.dat", ios::out);
+        if (!nameFile.good())
+        {
+            cerr << "Error opening " << outputPrefix << "-names.dat\n";
+            return false;
+        }
+    }
+
+    RandomStream rng(seed);
+
+    // Cluster centers are placed uniformly through the sphere; the
+    // members then scatter around them in samplePosition
+    vector<float> clusterCenters;
+    if (distribution == "cluster")
+    {
+        clusterCenters.resize((size_t) clusterCount * 3);
+        for (unsigned int cluster = 0; cluster < clusterCount; cluster++)
+        {
+            double dx, dy, dz;
+            rng.direction(dx, dy, dz);
+            double r = radius * cbrt(rng.frand());
+            clusterCenters[(size_t) cluster * 3]     = (float) (dx * r);
+            clusterCenters[(size_t) cluster * 3 + 1] = (float) (dy * r);
+            clusterCenters[(size_t) cluster * 3 + 2] = (float) (dz * r);
+        }
+    }
+
+    ostream* text = binaryOnly ? nullptr : &textFile;
+    ostream* binary = textOnly ? nullptr : &binaryFile;
+
+    uint32_t catalogNumber = 1;
+    unsigned int emitted = 0;
+    while (emitted < starCount)
+    {
+        SyntheticStar star = sampleStar(rng, catalogNumber++);
+        samplePosition(rng, clusterCenters, star.x, star.y, star.z);
+        emitStar(star, text, binary);
+        emitted++;
+
+        if (nameDensity > 0.0f && rng.frand() < nameDensity)
+            nameFile << star.catalogNumber << ":SYN " << star.catalogNumber << '\n';
+        if (systemStars.size() < systemCount)
+            systemStars.push_back(star.catalogNumber);
+
+        // A companion a few hundred to a few thousand AU out -- close
+        // enough that the pair always shares deep octree cells
+        if (emitted < starCount && rng.frand() < binaryFraction)
+        {
+            SyntheticStar companion = sampleStar(rng, catalogNumber++);
+            double dx, dy, dz;
+            rng.direction(dx, dy, dz);
+            double separation = rng.frand(1.0e-4, 2.0e-3);
+            companion.x = star.x + (float) (dx * separation);
+            companion.y = star.y + (float) (dy * separation);
+            companion.z = star.z + (float) (dz * separation);
+            if (companion.absMag < star.absMag)
+                companion.absMag = star.absMag + (float) rng.frand(0.5, 4.0);
+            emitStar(companion, text, binary);
+            emitted++;
+        }
+    }
+
+    return (text == nullptr || text->good()) &&
+           (binary == nullptr || binary->good());
+}
+
+
+static bool generateDeepSkyObjects()
+{
+    ofstream out(outputPrefix + ".dsc", ios::out);
+    if (!out.good())
+    {
+        cerr << "Error opening " << outputPrefix << ".dsc\n";
+        return false;
+    }
+
+    static const char* galaxyTypes[] =
+    {
+        "E0", "E3", "S0", "Sa", "Sb", "Sc", "SBa", "SBb", "SBc", "Irr"
+    };
+
+    // Independent stream so star and DSO catalogs of the same seed can
+    // be regenerated separately without perturbing each other
+    RandomStream rng(seed ^ 0xda3e39cb94b95bdbULL);
+
+    out << "# Synthetic deep sky catalog generated by synthcat\n"
+        << "# seed " << seed << ", " << dsoCount << " objects\n\n";
+
+    for (unsigned int i = 0; i < dsoCount; i++)
+    {
+        double RA = rng.frand(0.0, 24.0);
+        double dec = asin(rng.frand(-1.0, 1.0)) * 180.0 / 3.14159265358979323846;
+        // Uniform in volume out to 1e9 ly
+        double dist = 1.0e9 * cbrt(rng.frand());
+        double galaxyRadius = 1.0e4 * pow(10.0, rng.frand(0.0, 1.0));
+        double absMag = -19.5 + rng.gaussian() * 1.5;
+        double ax, ay, az;
+        rng.direction(ax, ay, az);
+
+        out << "Galaxy \"SYNDSO " << (i + 1) << "\"\n"
+            << "{\n"
+            << "        Type     \"" << galaxyTypes[(size_t) (rng.frand() * 10.0)] << "\"\n"
+            << "        RA       " << RA << '\n'
+            << "        Dec      " << dec << '\n'
+            << "        Distance " << dist << '\n'
+            << "        Radius   " << galaxyRadius << '\n'
+            << "        AbsMag   " << absMag << '\n'
+            << "        Axis     [ " << ax << ' ' << ay << ' ' << az << " ]\n"
+            << "        Angle    " << rng.frand(0.0, 180.0) << '\n'
+            << "}\n\n";
+    }
+
+    return out.good();
+}
+
+
+static bool generateSystems(const vector<uint32_t>& systemStars)
+{
+    ofstream out(outputPrefix + ".ssc", ios::out);
+    if (!out.good())
+    {
+        cerr << "Error opening " << outputPrefix << ".ssc\n";
+        return false;
+    }
+
+    RandomStream rng(seed ^ 0xc2b2ae3d27d4eb4fULL);
+
+    out << "# Synthetic planetary systems generated by synthcat\n"
+        << "# seed " << seed << ", " << systemStars.size() << " systems\n\n";
+
+    for (uint32_t catalogNumber : systemStars)
+    {
+        unsigned int nPlanets = 1 + (unsigned int) (rng.frand() * 6.0);
+        double a = rng.frand(0.05, 0.4);
+        for (unsigned int planet = 0; planet < nPlanets; planet++)
+        {
+            double planetRadius = 2000.0 * pow(10.0, rng.frand(0.0, 1.6));
+            out << '"' << (char) ('b' + planet) << "\" \"HIP "
+                << catalogNumber << "\"\n"
+                << "{\n"
+                << "        Class   \"planet\"\n"
+                << "        Texture \"exo-class" << (1 + (int) (rng.frand() * 4.0)) << ".*\"\n"
+                << "        Radius  " << planetRadius << '\n'
+                << "        EllipticalOrbit {\n"
+                << "                Period        " << sqrt(a * a * a) << '\n'
+                << "                SemiMajorAxis " << a << '\n'
+                << "                Eccentricity  " << rng.frand(0.0, 0.3) << '\n'
+                << "                Inclination   " << rng.frand(0.0, 5.0) << '\n'
+                << "        }\n"
+                << "}\n\n";
+            a *= rng.frand(1.4, 2.2);
+        }
+    }
+
+    return out.good();
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv) || outputPrefix.empty())
+    {
+        Usage();
+        return 1;
+    }
+
+    vector<uint32_t> systemStars;
+    if (starCount > 0 && !generateStars(systemStars))
+        return 1;
+
+    if (dsoCount > 0 && !generateDeepSkyObjects())
+        return 1;
+
+    if (!systemStars.empty() && !generateSystems(systemStars))
+        return 1;
+
+    return 0;
+}
@@ -1,14 +1,18 @@
 #include <celephem/xyzvbinary.h>
 #include <celutil/bytes.h> // __BYTE_ORDER__
 #include <fmt/printf.h>
+#include <algorithm>
+#include <cmath>
 #include <cstring> // memcpy
 #include <fstream>
 #include <iostream>
 #include <limits> // std::numeric_limits
+#include <vector>
 
 using namespace std;
 
 constexpr char magic[8] = "CELXYZV";
+constexpr char compressedMagic[8] = { 'C', 'E', 'L', 'X', 'Y', 'Z', 'V', 'C' };
 
 // Scan past comments. A comment begins with the # character and ends
 // with a newline. Return true if the stream state is good. The stream
@@ -104,17 +108,282 @@ static bool xyzvToBinary(const string& inFilename, const string& outFilename)
     return !!out.write(reinterpret_cast<char*>(&header), sizeof(header));
 }
 
+// Evaluate a Chebyshev series by the Clenshaw recurrence.
+static double chebEval(const double coeffs[], double u)
+{
+    double b1 = 0.0;
+    double b2 = 0.0;
+    for (int k = (int) XYZVChebyshevDegree; k >= 1; k--)
+    {
+        double b0 = 2.0 * u * b1 - b2 + coeffs[k];
+        b2 = b1;
+        b1 = b0;
+    }
+    return u * b1 - b2 + coeffs[0];
+}
+
+// Derivative of a Chebyshev series with respect to u, computed by
+// differentiating the Clenshaw recurrence alongside it.
+static double chebEvalDeriv(const double coeffs[], double u)
+{
+    double b1 = 0.0, b2 = 0.0;
+    double db1 = 0.0, db2 = 0.0;
+    for (int k = (int) XYZVChebyshevDegree; k >= 1; k--)
+    {
+        double db0 = 2.0 * b1 + 2.0 * u * db1 - db2;
+        double b0 = 2.0 * u * b1 - b2 + coeffs[k];
+        db2 = db1;
+        db1 = db0;
+        b2 = b1;
+        b1 = b0;
+    }
+    return b1 + u * db1 - db2;
+}
+
+// Least squares fit of a Chebyshev series to (u[i], y[i]) via the
+// normal equations; the basis is well conditioned on [-1,1] at this
+// degree. Coefficients beyond the fitted degree are zeroed.
+static void fitChebyshev(const vector<double>& u, const vector<double>& y,
+                         unsigned int degree,
+                         double coeffs[XYZVChebyshevDegree + 1])
+{
+    unsigned int nc = degree + 1;
+    double A[XYZVChebyshevDegree + 1][XYZVChebyshevDegree + 1] = {};
+    double rhs[XYZVChebyshevDegree + 1] = {};
+
+    for (size_t i = 0; i < u.size(); i++)
+    {
+        double basis[XYZVChebyshevDegree + 1];
+        basis[0] = 1.0;
+        if (nc > 1)
+            basis[1] = u[i];
+        for (unsigned int k = 2; k < nc; k++)
+            basis[k] = 2.0 * u[i] * basis[k - 1] - basis[k - 2];
+
+        for (unsigned int j = 0; j < nc; j++)
+        {
+            rhs[j] += basis[j] * y[i];
+            for (unsigned int k = 0; k < nc; k++)
+                A[j][k] += basis[j] * basis[k];
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (unsigned int col = 0; col < nc; col++)
+    {
+        unsigned int pivot = col;
+        for (unsigned int row = col + 1; row < nc; row++)
+        {
+            if (fabs(A[row][col]) > fabs(A[pivot][col]))
+                pivot = row;
+        }
+        if (fabs(A[pivot][col]) < 1.0e-12)
+        {
+            A[col][col] = 1.0;
+            rhs[col] = 0.0;
+            continue;
+        }
+        if (pivot != col)
+        {
+            for (unsigned int k = 0; k < nc; k++)
+                swap(A[col][k], A[pivot][k]);
+            swap(rhs[col], rhs[pivot]);
+        }
+        for (unsigned int row = col + 1; row < nc; row++)
+        {
+            double f = A[row][col] / A[col][col];
+            for (unsigned int k = col; k < nc; k++)
+                A[row][k] -= f * A[col][k];
+            rhs[row] -= f * rhs[col];
+        }
+    }
+    for (int row = (int) nc - 1; row >= 0; row--)
+    {
+        double s = rhs[row];
+        for (unsigned int k = row + 1; k < nc; k++)
+            s -= A[row][k] * coeffs[k];
+        coeffs[row] = s / A[row][row];
+    }
+    for (unsigned int k = nc; k <= XYZVChebyshevDegree; k++)
+        coeffs[k] = 0.0;
+}
+
+static int16_t quantize(double value, double scale)
+{
+    double q = floor(value / scale + 0.5);
+    return (int16_t) max(-32767.0, min(32767.0, q));
+}
+
+// Convert text xyzv file to the compressed binary format: per-block
+// Chebyshev predictors with 16-bit quantized residuals (see
+// xyzvbinary.h). Quantization scales adapt to the worst residual of
+// each block, so the conversion reports the worst position error
+// introduced.
+static bool xyzvToCompressed(const string& inFilename, const string& outFilename)
+{
+    ifstream in(inFilename);
+    ofstream out(outFilename);
+    if (!in.good() || !out.good())
+        return false;
+
+    if (!SkipComments(in))
+        return false;
+
+    // Samples must be loaded up front: the block predictors are fitted
+    // to the positions they will predict.
+    vector<XYZVBinaryData> records;
+    double lastTdb = -numeric_limits<double>::infinity();
+    XYZVBinaryData data;
+    while (in.good())
+    {
+        in >> data.tdb;
+        in >> data.position[0];
+        in >> data.position[1];
+        in >> data.position[2];
+        in >> data.velocity[0];
+        in >> data.velocity[1];
+        in >> data.velocity[2];
+
+        if (!in.good())
+            continue;
+
+        // Duplicate times break bracketing searches; drop them here
+        // like the readers do.
+        if (data.tdb != lastTdb)
+        {
+            records.push_back(data);
+            lastTdb = data.tdb;
+        }
+    }
+
+    if (records.empty())
+        return false;
+
+    uint64_t blockCount =
+        ((uint64_t) records.size() + XYZVCompressedBlockSamples - 1) /
+        XYZVCompressedBlockSamples;
+
+    XYZVCompressedHeader header;
+    memcpy(header.magic, compressedMagic, 8);
+    header.byteOrder = __BYTE_ORDER__;
+    header.digits = std::numeric_limits<double>::digits;
+    header.reserved = 0;
+    header.count = records.size();
+    header.blockCount = blockCount;
+    if (!out.write(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+
+    vector<XYZVCompressedBlock> blocks(blockCount);
+    vector<XYZVCompressedSample> samples(records.size());
+    double worstError = 0.0;
+
+    for (uint64_t b = 0; b < blockCount; b++)
+    {
+        size_t begin = (size_t) b * XYZVCompressedBlockSamples;
+        size_t end = min(begin + XYZVCompressedBlockSamples, records.size());
+        size_t n = end - begin;
+
+        XYZVCompressedBlock& block = blocks[b];
+        block.startTime = records[begin].tdb;
+        block.endTime = records[end - 1].tdb;
+        block.sampleCount = (uint32_t) n;
+        block.reserved = 0;
+
+        double span = block.endTime - block.startTime;
+        double dudt = span > 0.0 ? 2.0 / span : 0.0;
+
+        vector<double> u(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            u[i] = span > 0.0
+                ? 2.0 * (records[begin + i].tdb - block.startTime) / span - 1.0
+                : 0.0;
+        }
+
+        unsigned int degree = (unsigned int) min((size_t) XYZVChebyshevDegree, n - 1);
+        vector<double> y(n);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (size_t i = 0; i < n; i++)
+                y[i] = records[begin + i].position[axis];
+            fitChebyshev(u, y, degree, block.coeffs[axis]);
+        }
+
+        // Residuals against the predictor (positions) and its
+        // derivative (velocities; the derivative is km/day, the file
+        // stores km/sec).
+        double maxPos = 0.0;
+        double maxVel = 0.0;
+        for (size_t i = 0; i < n; i++)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                double dp = records[begin + i].position[axis] -
+                            chebEval(block.coeffs[axis], u[i]);
+                double dv = records[begin + i].velocity[axis] -
+                            chebEvalDeriv(block.coeffs[axis], u[i]) * dudt / 86400.0;
+                maxPos = max(maxPos, fabs(dp));
+                maxVel = max(maxVel, fabs(dv));
+            }
+        }
+        block.posScale = maxPos > 0.0 ? maxPos / 32767.0 : 1.0;
+        block.velScale = maxVel > 0.0 ? maxVel / 32767.0 : 1.0;
+        worstError = max(worstError, block.posScale * 0.5);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            XYZVCompressedSample& s = samples[begin + i];
+            s.timeOffset = (float) (records[begin + i].tdb - block.startTime);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                double dp = records[begin + i].position[axis] -
+                            chebEval(block.coeffs[axis], u[i]);
+                double dv = records[begin + i].velocity[axis] -
+                            chebEvalDeriv(block.coeffs[axis], u[i]) * dudt / 86400.0;
+                s.position[axis] = quantize(dp, block.posScale);
+                s.velocity[axis] = quantize(dv, block.velScale);
+            }
+        }
+    }
+
+    if (!out.write(reinterpret_cast<char*>(blocks.data()),
+                   blocks.size() * sizeof(XYZVCompressedBlock)))
+        return false;
+    if (!out.write(reinterpret_cast<char*>(samples.data()),
+                   samples.size() * sizeof(XYZVCompressedSample)))
+        return false;
+
+    fmt::fprintf(cerr, "%llu samples in %llu blocks, worst position error %g km\n",
+                 (unsigned long long) records.size(),
+                 (unsigned long long) blockCount,
+                 worstError);
+    return true;
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc < 3)
+    bool compress = false;
+    int argIndex = 1;
+    if (argc > 1 && strcmp(argv[1], "-c") == 0)
+    {
+        compress = true;
+        argIndex = 2;
+    }
+
+    if (argc - argIndex < 2)
     {
-        fmt::fprintf(cerr, "Usage: %s infile.xyzv outfile.bin\n", argv[0]);
+        fmt::fprintf(cerr, "Usage: %s [-c] infile.xyzv outfile.bin\n", argv[0]);
+        fmt::fprintf(cerr, "  -c  write the compressed format (Chebyshev predictor + quantized residuals)\n");
         return 1;
     }
 
-    if (!xyzvToBinary(argv[1], argv[2]))
+    bool ok = compress
+        ? xyzvToCompressed(argv[argIndex], argv[argIndex + 1])
+        : xyzvToBinary(argv[argIndex], argv[argIndex + 1]);
+    if (!ok)
     {
-        fmt::fprintf(cerr, "Error converting %s to %s.\n", argv[1], argv[2]);
+        fmt::fprintf(cerr, "Error converting %s to %s.\n",
+                     argv[argIndex], argv[argIndex + 1]);
         return 1;
     }
 